@@ -251,6 +251,7 @@ help:
 	$(info $(SPACE)msi - create a Windows-msi-based installer)
 	$(info $(SPACE)plugins - build plugins sub-targets)
 	$(info $(SPACE)testapps - build testapps sub-targets)
+	$(info $(SPACE)bench - build and run the benchmarks (set BENCH_BASELINE_FILE to compare against a baseline))
 	$(info $(SPACE)test - build and test all targets)
 	$(info $(SPACE)testutf - build and run utf test sub-targets)
 	$(info $(SPACE)testjni - build and run jni test sub-targets)
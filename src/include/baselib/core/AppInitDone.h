@@ -103,7 +103,8 @@ namespace bl
             SAA_in_opt          const std::size_t                   threadsCount = ThreadPoolImpl::THREADS_COUNT_DEFAULT,
             SAA_in_opt          ThreadPool*                         sharedThreadPool = nullptr,
             SAA_in_opt          ThreadPool*                         sharedNonBlockingThreadPool = nullptr,
-            SAA_in_opt          const bool                          noThreadPool = false
+            SAA_in_opt          const bool                          noThreadPool = false,
+            SAA_in_opt          const bool                          workStealing = false
             )
             :
             m_pushLevel( loggingLevel, true /* global */ ),
@@ -154,6 +155,10 @@ namespace bl
                  * The passed in threadsCount applies to the general purpose thread
                  * pool, the I/O thread pool has fixed small # of threads
                  * (ThreadPoolDefault::IO_THREADS_COUNT)
+                 *
+                 * The work stealing scheduler (if requested) is also only used for
+                 * the general purpose thread pool as it is the one which executes
+                 * the tasks callbacks
                  */
 
                 if( sharedThreadPool )
@@ -164,7 +169,10 @@ namespace bl
                 {
                     m_threadPoolGeneralPurpose = ThreadPoolImplDefault::template createInstance< ThreadPool >(
                         os::getAbstractPriorityDefault(),
-                        threadsCount
+                        threadsCount,
+                        false                                   /* abortIfUnhandled */,
+                        eh::eh_callback_t()                     /* ehCB */,
+                        workStealing
                         );
 
                     ThreadPoolDefault::setDefault(
@@ -38,6 +38,7 @@ namespace bl
         typedef om::ObjectImpl< om::BoxedValueObject< std::vector< std::string > > >            string_vector;
         typedef om::ObjectImpl< om::BoxedValueObject< std::vector< uuid_t > > >                 uuid_vector;
         typedef om::ObjectImpl< om::BoxedValueObject< std::vector< std::uint64_t > > >          uint64_vector;
+        typedef om::ObjectImpl< om::BoxedValueObject< os::stdio_file_ptr > >                    stdio_file;
 
     } // bo
 
@@ -31,6 +31,7 @@
 #include <boost/iterator/counting_iterator.hpp>
 #include <baselib/core/detail/BoostIncludeGuardPop.h>
 
+#include <atomic>
 #include <cstdio>
 #include <memory>
 #include <mutex>
@@ -49,6 +50,8 @@
 #define BL_RIP_MSG( msg ) \
     do \
     { \
+        bl::detail::GlobalHooks::onFatalError(); \
+        \
         BL_STDIO_TEXT( \
             { \
                 std::cerr \
@@ -262,7 +265,14 @@ namespace bl
         >
         class GlobalHooksT
         {
+        public:
+
+            typedef void ( *fatal_error_hook_t )();
+
+        private:
+
             static std::recursive_mutex g_lock;
+            static std::atomic< fatal_error_hook_t > g_fatalErrorHook;
 
         public:
 
@@ -272,6 +282,33 @@ namespace bl
 
                 cb();
             }
+
+            /**
+             * @brief Sets a hook which is invoked once before the process is aborted
+             * by BL_RIP_MSG (e.g. to flush buffered output); returns the previous hook
+             *
+             * The hook must not throw and must not block indefinitely
+             */
+
+            static fatal_error_hook_t setFatalErrorHook( SAA_in_opt const fatal_error_hook_t hook ) NOEXCEPT
+            {
+                return g_fatalErrorHook.exchange( hook );
+            }
+
+            static void onFatalError() NOEXCEPT
+            {
+                /*
+                 * The hook is reset before it is invoked, so if it fails fatally
+                 * itself it won't be invoked recursively
+                 */
+
+                const auto hook = g_fatalErrorHook.exchange( nullptr );
+
+                if( hook )
+                {
+                    hook();
+                }
+            }
         };
 
         template
@@ -281,6 +318,13 @@ namespace bl
         std::recursive_mutex
         GlobalHooksT< E >::g_lock;
 
+        template
+        <
+            typename E
+        >
+        std::atomic< typename GlobalHooksT< E >::fatal_error_hook_t >
+        GlobalHooksT< E >::g_fatalErrorHook( nullptr );
+
         typedef GlobalHooksT<> GlobalHooks;
 
     } // detail
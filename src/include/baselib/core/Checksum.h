@@ -17,17 +17,430 @@
 #ifndef __BL_CHECKSUM_H_
 #define __BL_CHECKSUM_H_
 
+#include <baselib/core/Annotations.h>
+#include <baselib/core/BaseDefs.h>
+
 #include <boost/crc.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*
+ * The hardware CRC32C implementation uses the SSE4.2 crc32 instruction which is only
+ * used if the CPU supports it (the check is done at runtime), so the code does not
+ * have to be compiled with -msse4.2
+ */
+
+#if ( defined( __x86_64__ ) || defined( _M_X64 ) ) && ( defined( __GNUC__ ) || defined( _MSC_VER ) )
+
+#define BL_CHECKSUM_HAS_CRC32C_INTRINSICS
+
+#include <nmmintrin.h>
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#define BL_CHECKSUM_TARGET_SSE42
+#else
+#define BL_CHECKSUM_TARGET_SSE42 __attribute__(( target( "sse4.2" ) ))
+#endif
+
+#endif
+
 namespace bl
 {
     namespace cs
     {
         using boost::crc_32_type;
 
+        namespace detail
+        {
+            /**
+             * @brief class CrcTables - the lookup tables of the slicing-by-8 algorithm for
+             * a reflected CRC-32 polynomial
+             */
+
+            template
+            <
+                std::uint32_t POLYNOMIAL
+            >
+            class CrcTablesT
+            {
+                BL_NO_COPY_OR_MOVE( CrcTablesT )
+
+            private:
+
+                CrcTablesT() NOEXCEPT
+                {
+                    for( std::uint32_t i = 0U; i < 256U; ++i )
+                    {
+                        std::uint32_t crc = i;
+
+                        for( std::size_t bit = 0U; bit < 8U; ++bit )
+                        {
+                            crc = ( crc & 1U ) ? ( ( crc >> 1 ) ^ POLYNOMIAL ) : ( crc >> 1 );
+                        }
+
+                        table[ 0 ][ i ] = crc;
+                    }
+
+                    for( std::size_t slice = 1U; slice < 8U; ++slice )
+                    {
+                        for( std::size_t i = 0U; i < 256U; ++i )
+                        {
+                            const auto prev = table[ slice - 1U ][ i ];
+
+                            table[ slice ][ i ] = ( prev >> 8 ) ^ table[ 0 ][ prev & 0xFFU ];
+                        }
+                    }
+                }
+
+            public:
+
+                std::uint32_t                                   table[ 8 ][ 256 ];
+
+                static auto get() NOEXCEPT -> const CrcTablesT&
+                {
+                    static const CrcTablesT g_tables;
+
+                    return g_tables;
+                }
+
+                /**
+                 * @brief Updates the CRC register (i.e. the CRC value before the final xor)
+                 *
+                 * The data is read in 8 bytes words which are assembled explicitly, so the
+                 * code is portable with respect to alignment and endianness
+                 */
+
+                static auto update(
+                    SAA_in          std::uint32_t                   crc,
+                    SAA_in          const unsigned char*            data,
+                    SAA_in          std::size_t                     size
+                    ) NOEXCEPT
+                    -> std::uint32_t
+                {
+                    const auto& t = get().table;
+
+                    while( size >= 8U )
+                    {
+                        const std::uint32_t lo = crc ^ (
+                            static_cast< std::uint32_t >( data[ 0 ] ) |
+                            static_cast< std::uint32_t >( data[ 1 ] ) << 8 |
+                            static_cast< std::uint32_t >( data[ 2 ] ) << 16 |
+                            static_cast< std::uint32_t >( data[ 3 ] ) << 24
+                            );
+
+                        const std::uint32_t hi =
+                            static_cast< std::uint32_t >( data[ 4 ] ) |
+                            static_cast< std::uint32_t >( data[ 5 ] ) << 8 |
+                            static_cast< std::uint32_t >( data[ 6 ] ) << 16 |
+                            static_cast< std::uint32_t >( data[ 7 ] ) << 24;
+
+                        crc =
+                            t[ 7 ][ lo & 0xFFU ] ^
+                            t[ 6 ][ ( lo >> 8 ) & 0xFFU ] ^
+                            t[ 5 ][ ( lo >> 16 ) & 0xFFU ] ^
+                            t[ 4 ][ lo >> 24 ] ^
+                            t[ 3 ][ hi & 0xFFU ] ^
+                            t[ 2 ][ ( hi >> 8 ) & 0xFFU ] ^
+                            t[ 1 ][ ( hi >> 16 ) & 0xFFU ] ^
+                            t[ 0 ][ hi >> 24 ];
+
+                        data += 8U;
+                        size -= 8U;
+                    }
+
+                    while( size )
+                    {
+                        crc = t[ 0 ][ ( crc ^ *data ) & 0xFFU ] ^ ( crc >> 8 );
+
+                        ++data;
+                        --size;
+                    }
+
+                    return crc;
+                }
+            };
+
+            enum : std::uint32_t
+            {
+                CRC32_POLYNOMIAL_REFLECTED = 0xEDB88320U,
+                CRC32C_POLYNOMIAL_REFLECTED = 0x82F63B78U,
+            };
+
+            typedef CrcTablesT< CRC32_POLYNOMIAL_REFLECTED >    Crc32Tables;
+            typedef CrcTablesT< CRC32C_POLYNOMIAL_REFLECTED >   Crc32cTables;
+
+            /**
+             * @brief class Crc32cImpl - selects the CRC32C implementation once (at the first
+             * use) based on the CPU capabilities
+             */
+
+            template
+            <
+                typename E = void
+            >
+            class Crc32cImplT
+            {
+                BL_DECLARE_STATIC( Crc32cImplT )
+
+            public:
+
+                typedef std::uint32_t ( *update_fn_t )(
+                    SAA_in          std::uint32_t                   crc,
+                    SAA_in          const unsigned char*            data,
+                    SAA_in          std::size_t                     size
+                    );
+
+            private:
+
+#if defined( BL_CHECKSUM_HAS_CRC32C_INTRINSICS )
+
+                static bool detectHardwareSupport() NOEXCEPT
+                {
+#if defined( _MSC_VER )
+                    int info[ 4 ];
+
+                    __cpuid( info, 1 );
+
+                    return 0 != ( info[ 2 ] & ( 1 << 20 ) );
+#else
+                    __builtin_cpu_init();
+
+                    return 0 != __builtin_cpu_supports( "sse4.2" );
+#endif
+                }
+
+                BL_CHECKSUM_TARGET_SSE42
+                static std::uint32_t updateHardware(
+                    SAA_in          std::uint32_t                   crc,
+                    SAA_in          const unsigned char*            data,
+                    SAA_in          std::size_t                     size
+                    )
+                {
+                    std::uint64_t crc64 = crc;
+
+                    while( size >= 8U )
+                    {
+                        std::uint64_t value;
+
+                        std::memcpy( &value, data, sizeof( value ) );
+
+                        crc64 = _mm_crc32_u64( crc64, value );
+
+                        data += 8U;
+                        size -= 8U;
+                    }
+
+                    crc = static_cast< std::uint32_t >( crc64 );
+
+                    while( size )
+                    {
+                        crc = _mm_crc32_u8( crc, *data );
+
+                        ++data;
+                        --size;
+                    }
+
+                    return crc;
+                }
+
+#else // defined( BL_CHECKSUM_HAS_CRC32C_INTRINSICS )
+
+                static bool detectHardwareSupport() NOEXCEPT
+                {
+                    return false;
+                }
+
+                static std::uint32_t updateHardware(
+                    SAA_in          std::uint32_t                   crc,
+                    SAA_in          const unsigned char*            data,
+                    SAA_in          std::size_t                     size
+                    )
+                {
+                    return Crc32cTables::update( crc, data, size );
+                }
+
+#endif // defined( BL_CHECKSUM_HAS_CRC32C_INTRINSICS )
+
+                static std::uint32_t updateSoftware(
+                    SAA_in          std::uint32_t                   crc,
+                    SAA_in          const unsigned char*            data,
+                    SAA_in          std::size_t                     size
+                    )
+                {
+                    return Crc32cTables::update( crc, data, size );
+                }
+
+            public:
+
+                static bool isHardwareAccelerated() NOEXCEPT
+                {
+                    static const bool g_hardwareSupport = detectHardwareSupport();
+
+                    return g_hardwareSupport;
+                }
+
+                static auto getUpdateFunction( SAA_in const bool forceSoftware = false ) NOEXCEPT -> update_fn_t
+                {
+                    return ( isHardwareAccelerated() && ! forceSoftware ) ? &updateHardware : &updateSoftware;
+                }
+            };
+
+            typedef Crc32cImplT<> Crc32cImpl;
+
+        } // detail
+
+        /**
+         * @brief class Crc32 - CRC-32 (the IEEE 802.3 polynomial) computed with slicing-by-8
+         *
+         * The values are identical to boost::crc_32_type (which processes one byte at a time),
+         * so it must be used for the checksums which are persisted already (e.g. the chunk and
+         * file checksums in the filesystem metadata). It has the same interface as
+         * boost::crc_32_type, so it can be used as a drop-in replacement
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class Crc32T
+        {
+        private:
+
+            std::uint32_t                                       m_crc;
+
+        public:
+
+            Crc32T() NOEXCEPT
+                :
+                m_crc( 0xFFFFFFFFU )
+            {
+            }
+
+            void process_bytes(
+                SAA_in          const void*                     buffer,
+                SAA_in          const std::size_t               size
+                ) NOEXCEPT
+            {
+                m_crc = detail::Crc32Tables::update( m_crc, static_cast< const unsigned char* >( buffer ), size );
+            }
+
+            auto checksum() const NOEXCEPT -> std::uint32_t
+            {
+                return m_crc ^ 0xFFFFFFFFU;
+            }
+
+            void reset() NOEXCEPT
+            {
+                m_crc = 0xFFFFFFFFU;
+            }
+        };
+
+        typedef Crc32T<> Crc32;
+
+        /**
+         * @brief class Crc32c - CRC-32C (the Castagnoli polynomial)
+         *
+         * It uses the SSE4.2 crc32 instruction when the CPU supports it and slicing-by-8
+         * otherwise (both produce the same values). Note that the values are different from
+         * CRC-32, so it is only suitable for checksums which are not persisted already
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class Crc32cT
+        {
+        private:
+
+            typedef detail::Crc32cImpl::update_fn_t             update_fn_t;
+
+            const update_fn_t                                   m_update;
+            std::uint32_t                                       m_crc;
+
+        public:
+
+            explicit Crc32cT( SAA_in_opt const bool forceSoftware = false ) NOEXCEPT
+                :
+                m_update( detail::Crc32cImpl::getUpdateFunction( forceSoftware ) ),
+                m_crc( 0xFFFFFFFFU )
+            {
+            }
+
+            void process_bytes(
+                SAA_in          const void*                     buffer,
+                SAA_in          const std::size_t               size
+                ) NOEXCEPT
+            {
+                m_crc = m_update( m_crc, static_cast< const unsigned char* >( buffer ), size );
+            }
+
+            auto checksum() const NOEXCEPT -> std::uint32_t
+            {
+                return m_crc ^ 0xFFFFFFFFU;
+            }
+
+            void reset() NOEXCEPT
+            {
+                m_crc = 0xFFFFFFFFU;
+            }
+
+            static bool isHardwareAccelerated() NOEXCEPT
+            {
+                return detail::Crc32cImpl::isHardwareAccelerated();
+            }
+        };
+
+        typedef Crc32cT<> Crc32c;
+
+        enum : std::size_t
+        {
+            FUSED_SLICE_SIZE = 16U * 1024U,
+        };
+
+        /**
+         * @brief Computes a checksum and a hash of the same buffer in a single pass
+         *
+         * The buffer is processed in slices which fit in the L1 cache, so the hash calculator
+         * reads the data which was just brought in the cache by the checksum rather than
+         * walking the whole buffer (e.g. 1 MB data block) from memory a second time
+         *
+         * CHECKSUM must have process_bytes( buffer, size ) and HASH must have update( buffer,
+         * size ) (e.g. hash::HashCalculatorDefault) - the hash is not finalized here
+         */
+
+        template
+        <
+            typename CHECKSUM,
+            typename HASH
+        >
+        inline void updateChecksumAndHash(
+            SAA_inout       CHECKSUM&                           checksum,
+            SAA_inout       HASH&                               hash,
+            SAA_in          const void*                         buffer,
+            SAA_in          std::size_t                         size
+            )
+        {
+            auto data = static_cast< const unsigned char* >( buffer );
+
+            while( size )
+            {
+                const auto sliceSize = std::min< std::size_t >( size, FUSED_SLICE_SIZE );
+
+                checksum.process_bytes( data, sliceSize );
+                hash.update( data, sliceSize );
+
+                data += sliceSize;
+                size -= sliceSize;
+            }
+        }
+
     } // cs
 
 } // bl
 
 #endif /* __BL_CHECKSUM_H_ */
-
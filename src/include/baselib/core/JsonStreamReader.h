@@ -0,0 +1,1020 @@
+/*
+ * This file is part of the swblocks-baselib library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __BL_JSONSTREAMREADER_H_
+#define __BL_JSONSTREAMREADER_H_
+
+#include <baselib/core/JsonUtils.h>
+#include <baselib/core/NumberUtils.h>
+#include <baselib/core/BaseIncludes.h>
+
+#include <cstdlib>
+#include <limits>
+
+namespace bl
+{
+    namespace json
+    {
+        /**
+         * @brief class StreamReader - a pull style JSON reader which works directly on
+         * a (const char*, size) view of the JSON text
+         *
+         * Unlike readFromString() it does not build a json::Value tree; the values are read
+         * directly into the caller's variables and values which are skipped are only
+         * validated (no allocations). Object keys are returned as views into the input (or
+         * into a scratch buffer if they contain escape sequences), so they are only valid
+         * until the next key is read
+         *
+         * Syntax errors are reported as JsonException and value type mismatches are reported
+         * the same way json_spirit does (so remapIncorrectValueTypeException() can be used)
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class StreamReaderT
+        {
+        public:
+
+            typedef std::pair< const char*, std::size_t >                           view_t;
+
+            enum : std::size_t
+            {
+                MAX_NESTING_DEPTH = 512U,
+            };
+
+        protected:
+
+            cpp::ScalarTypeIniter< const char* >                                    m_begin;
+            cpp::ScalarTypeIniter< const char* >                                    m_pos;
+            cpp::ScalarTypeIniter< const char* >                                    m_end;
+            cpp::ScalarTypeIniter< std::size_t >                                    m_depth;
+            std::string                                                             m_keyBuffer;
+
+            static const char* typeToString( SAA_in const ValueType type ) NOEXCEPT
+            {
+                /*
+                 * Must match the names used by json_spirit in its check_type() errors
+                 */
+
+                switch( type )
+                {
+                    case json_spirit::obj_type:     return "Object";
+                    case json_spirit::array_type:   return "Array";
+                    case json_spirit::str_type:     return "string";
+                    case json_spirit::bool_type:    return "boolean";
+                    case json_spirit::int_type:     return "integer";
+                    case json_spirit::real_type:    return "real";
+                    default:                        return "null";
+                }
+            }
+
+            void throwParserError( SAA_in const char* reason ) const
+            {
+                unsigned int line = 1U;
+                unsigned int column = 1U;
+
+                for( auto pos = m_begin.value(); pos < m_pos.value(); ++pos )
+                {
+                    if( '\n' == *pos )
+                    {
+                        ++line;
+                        column = 1U;
+                    }
+                    else
+                    {
+                        ++column;
+                    }
+                }
+
+                BL_THROW(
+                    JsonException()
+                        << eh::errinfo_parser_line( line )
+                        << eh::errinfo_parser_column( column )
+                        << eh::errinfo_parser_reason( reason ),
+                    BL_MSG()
+                        << "JSON parser error at line: "
+                        << line
+                        << ", column: "
+                        << column
+                        << ", reason: "
+                        << reason
+                    );
+            }
+
+            void throwTypeMismatch( SAA_in const ValueType expected, SAA_in const ValueType actual ) const
+            {
+                throw std::runtime_error(
+                    resolveMessage(
+                        BL_MSG()
+                            << "get_value< "
+                            << typeToString( expected )
+                            << " > called on "
+                            << typeToString( actual )
+                            << " Value"
+                        )
+                    );
+            }
+
+            void skipWhitespace() NOEXCEPT
+            {
+                auto pos = m_pos.value();
+
+                while( pos < m_end.value() && ( ' ' == *pos || '\t' == *pos || '\n' == *pos || '\r' == *pos ) )
+                {
+                    ++pos;
+                }
+
+                m_pos = pos;
+            }
+
+            char peekChar()
+            {
+                skipWhitespace();
+
+                if( m_pos.value() == m_end.value() )
+                {
+                    throwParserError( "unexpected end of input" );
+                }
+
+                return *m_pos.value();
+            }
+
+            void expectChar( SAA_in const char ch )
+            {
+                if( ch != peekChar() )
+                {
+                    throwParserError( "unexpected character" );
+                }
+
+                ++m_pos.lvalue();
+            }
+
+            bool tryConsumeLiteral( SAA_in const char* literal ) NOEXCEPT
+            {
+                const auto length = std::strlen( literal );
+
+                if( static_cast< std::size_t >( m_end.value() - m_pos.value() ) >= length &&
+                    0 == std::memcmp( m_pos.value(), literal, length ) )
+                {
+                    m_pos = m_pos.value() + length;
+
+                    return true;
+                }
+
+                return false;
+            }
+
+            void enterNested()
+            {
+                if( ++m_depth.lvalue() > MAX_NESTING_DEPTH )
+                {
+                    throwParserError( "maximum nesting depth exceeded" );
+                }
+            }
+
+            void leaveNested() NOEXCEPT
+            {
+                --m_depth.lvalue();
+            }
+
+            static void appendUtf8( SAA_inout std::string& out, SAA_in const std::uint32_t codePoint )
+            {
+                if( codePoint < 0x80U )
+                {
+                    out.push_back( static_cast< char >( codePoint ) );
+                }
+                else if( codePoint < 0x800U )
+                {
+                    out.push_back( static_cast< char >( 0xC0U | ( codePoint >> 6 ) ) );
+                    out.push_back( static_cast< char >( 0x80U | ( codePoint & 0x3FU ) ) );
+                }
+                else if( codePoint < 0x10000U )
+                {
+                    out.push_back( static_cast< char >( 0xE0U | ( codePoint >> 12 ) ) );
+                    out.push_back( static_cast< char >( 0x80U | ( ( codePoint >> 6 ) & 0x3FU ) ) );
+                    out.push_back( static_cast< char >( 0x80U | ( codePoint & 0x3FU ) ) );
+                }
+                else
+                {
+                    out.push_back( static_cast< char >( 0xF0U | ( codePoint >> 18 ) ) );
+                    out.push_back( static_cast< char >( 0x80U | ( ( codePoint >> 12 ) & 0x3FU ) ) );
+                    out.push_back( static_cast< char >( 0x80U | ( ( codePoint >> 6 ) & 0x3FU ) ) );
+                    out.push_back( static_cast< char >( 0x80U | ( codePoint & 0x3FU ) ) );
+                }
+            }
+
+            std::uint32_t readHex4()
+            {
+                if( m_end.value() - m_pos.value() < 4 )
+                {
+                    throwParserError( "invalid unicode escape sequence" );
+                }
+
+                std::uint32_t value = 0U;
+
+                for( std::size_t i = 0U; i < 4U; ++i )
+                {
+                    const auto ch = *m_pos.value();
+
+                    value <<= 4;
+
+                    if( ch >= '0' && ch <= '9' )
+                    {
+                        value |= static_cast< std::uint32_t >( ch - '0' );
+                    }
+                    else if( ch >= 'a' && ch <= 'f' )
+                    {
+                        value |= static_cast< std::uint32_t >( ch - 'a' + 10 );
+                    }
+                    else if( ch >= 'A' && ch <= 'F' )
+                    {
+                        value |= static_cast< std::uint32_t >( ch - 'A' + 10 );
+                    }
+                    else
+                    {
+                        throwParserError( "invalid unicode escape sequence" );
+                    }
+
+                    ++m_pos.lvalue();
+                }
+
+                return value;
+            }
+
+            /**
+             * @brief Scans a string value; the raw (still escaped) content is returned as a view
+             * and the decoded content is stored in out only if out is not nullptr
+             */
+
+            view_t scanString( SAA_inout_opt std::string* out, SAA_out_opt bool* isEscaped = nullptr )
+            {
+                expectChar( '"' );
+
+                const auto start = m_pos.value();
+                auto pos = start;
+                bool escaped = false;
+
+                while( true )
+                {
+                    if( pos == m_end.value() )
+                    {
+                        m_pos = pos;
+
+                        throwParserError( "unterminated string" );
+                    }
+
+                    if( '"' == *pos )
+                    {
+                        break;
+                    }
+
+                    if( '\\' == *pos )
+                    {
+                        escaped = true;
+                    }
+
+                    pos += ( '\\' == *pos && pos + 1 < m_end.value() ) ? 2 : 1;
+                }
+
+                const auto raw = view_t( start, static_cast< std::size_t >( pos - start ) );
+
+                if( isEscaped )
+                {
+                    *isEscaped = escaped;
+                }
+
+                if( ! escaped )
+                {
+                    if( out )
+                    {
+                        out -> assign( start, raw.second );
+                    }
+
+                    m_pos = pos + 1;
+
+                    return raw;
+                }
+
+                /*
+                 * The string contains escape sequences; these are validated (and decoded if
+                 * requested) in a second pass
+                 */
+
+                if( out )
+                {
+                    out -> clear();
+                }
+
+                m_pos = start;
+
+                while( m_pos.value() < pos )
+                {
+                    const auto ch = *m_pos.value();
+
+                    ++m_pos.lvalue();
+
+                    if( '\\' != ch )
+                    {
+                        if( out )
+                        {
+                            out -> push_back( ch );
+                        }
+
+                        continue;
+                    }
+
+                    const auto escape = *m_pos.value();
+
+                    ++m_pos.lvalue();
+
+                    char decoded = 0;
+
+                    switch( escape )
+                    {
+                        case '"':   decoded = '"';  break;
+                        case '\\':  decoded = '\\'; break;
+                        case '/':   decoded = '/';  break;
+                        case 'b':   decoded = '\b'; break;
+                        case 'f':   decoded = '\f'; break;
+                        case 'n':   decoded = '\n'; break;
+                        case 'r':   decoded = '\r'; break;
+                        case 't':   decoded = '\t'; break;
+
+                        case 'u':
+                            {
+                                auto codePoint = readHex4();
+
+                                if( codePoint >= 0xD800U && codePoint < 0xDC00U &&
+                                    pos - m_pos.value() >= 6 &&
+                                    '\\' == m_pos.value()[ 0 ] &&
+                                    'u' == m_pos.value()[ 1 ] )
+                                {
+                                    m_pos = m_pos.value() + 2;
+
+                                    const auto low = readHex4();
+
+                                    codePoint = 0x10000U + ( ( codePoint - 0xD800U ) << 10 ) + ( low - 0xDC00U );
+                                }
+
+                                if( out )
+                                {
+                                    appendUtf8( *out, codePoint );
+                                }
+                            }
+                            continue;
+
+                        default:
+                            throwParserError( "invalid escape sequence" );
+                    }
+
+                    if( out )
+                    {
+                        out -> push_back( decoded );
+                    }
+                }
+
+                m_pos = pos + 1;
+
+                return raw;
+            }
+
+            /**
+             * @brief Scans a number; the view is only valid as a temporary
+             */
+
+            view_t scanNumber( SAA_out bool& isReal )
+            {
+                skipWhitespace();
+
+                const auto start = m_pos.value();
+                auto pos = start;
+
+                isReal = false;
+
+                if( pos < m_end.value() && ( '-' == *pos || '+' == *pos ) )
+                {
+                    ++pos;
+                }
+
+                const auto digits = pos;
+
+                while( pos < m_end.value() )
+                {
+                    const auto ch = *pos;
+
+                    if( ch >= '0' && ch <= '9' )
+                    {
+                        ++pos;
+                    }
+                    else if( '.' == ch || 'e' == ch || 'E' == ch || ( ( '-' == ch || '+' == ch ) && isReal ) )
+                    {
+                        isReal = true;
+                        ++pos;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+
+                if( pos == digits )
+                {
+                    throwParserError( "invalid value" );
+                }
+
+                m_pos = pos;
+
+                return view_t( start, static_cast< std::size_t >( pos - start ) );
+            }
+
+            double parseReal( SAA_in const view_t& number )
+            {
+                /*
+                 * The input view is not NUL terminated, so the number is copied to the stack
+                 */
+
+                char buffer[ 64 ];
+
+                if( number.second >= sizeof( buffer ) )
+                {
+                    throwParserError( "invalid number" );
+                }
+
+                std::memcpy( buffer, number.first, number.second );
+                buffer[ number.second ] = 0;
+
+                char* end = nullptr;
+
+                const auto value = std::strtod( buffer, &end );
+
+                if( end != buffer + number.second )
+                {
+                    throwParserError( "invalid number" );
+                }
+
+                return value;
+            }
+
+            /**
+             * @brief Parses an integer in the way json_spirit stores it: values which fit
+             * in int64 are signed and larger positive values are unsigned
+             */
+
+            std::uint64_t parseInteger( SAA_in const view_t& number, SAA_out bool& isNegative )
+            {
+                auto pos = number.first;
+                const auto end = number.first + number.second;
+
+                isNegative = '-' == *pos;
+
+                if( '-' == *pos || '+' == *pos )
+                {
+                    ++pos;
+                }
+
+                std::uint64_t value = 0U;
+
+                for( ; pos < end; ++pos )
+                {
+                    const auto digit = static_cast< std::uint64_t >( *pos - '0' );
+
+                    if( value > ( std::numeric_limits< std::uint64_t >::max() - digit ) / 10U )
+                    {
+                        throwParserError( "integer value is out of range" );
+                    }
+
+                    value = value * 10U + digit;
+                }
+
+                if( isNegative && value > static_cast< std::uint64_t >( std::numeric_limits< std::int64_t >::max() ) + 1U )
+                {
+                    throwParserError( "integer value is out of range" );
+                }
+
+                return value;
+            }
+
+            template
+            <
+                typename T
+            >
+            T readIntegerAs()
+            {
+                const auto type = peekType();
+
+                if( json_spirit::int_type != type )
+                {
+                    throwTypeMismatch( json_spirit::int_type, type );
+                }
+
+                bool isReal;
+                bool isNegative;
+
+                const auto magnitude = parseInteger( scanNumber( isReal ), isNegative );
+
+                /*
+                 * The value must fit into T, otherwise it throws rather than wraps
+                 */
+
+                const auto throwOutOfRange = [ this ]() -> void
+                {
+                    throwParserError( "integer value is out of range" );
+                };
+
+                if( ! isNegative || ! magnitude )
+                {
+                    return numbers::safeCoerceTo< T >( magnitude, throwOutOfRange );
+                }
+
+                if(
+                    ! std::is_signed< T >::value ||
+                    magnitude - 1U > static_cast< std::uint64_t >( std::numeric_limits< T >::max() )
+                    )
+                {
+                    throwOutOfRange();
+                }
+
+                /*
+                 * Note that magnitude - 1 always fits into T (see the check above), so the
+                 * negation below can't overflow even for the minimum value of T
+                 */
+
+                return static_cast< T >( -static_cast< T >( magnitude - 1U ) - 1 );
+            }
+
+            void requireType( SAA_in const ValueType expected )
+            {
+                const auto type = peekType();
+
+                if( expected != type )
+                {
+                    throwTypeMismatch( expected, type );
+                }
+            }
+
+        public:
+
+            StreamReaderT()
+            {
+            }
+
+            StreamReaderT(
+                SAA_in_bcount( size )       const char*                                 data,
+                SAA_in                      const std::size_t                           size
+                )
+                :
+                m_begin( data ),
+                m_pos( data ),
+                m_end( data + size )
+            {
+            }
+
+            StreamReaderT( SAA_in const view_t& view )
+                :
+                m_begin( view.first ),
+                m_pos( view.first ),
+                m_end( view.first + view.second )
+            {
+            }
+
+            /**
+             * @brief Returns true if the view points into the input (e.g. a key which was not
+             * decoded into the scratch buffer)
+             */
+
+            bool isInputView( SAA_in const view_t& view ) const NOEXCEPT
+            {
+                return view.first >= m_begin.value() && view.first + view.second <= m_end.value();
+            }
+
+            bool eof() NOEXCEPT
+            {
+                skipWhitespace();
+
+                return m_pos.value() == m_end.value();
+            }
+
+            void requireEof()
+            {
+                if( ! eof() )
+                {
+                    throwParserError( "unexpected trailing data" );
+                }
+            }
+
+            /**
+             * @brief Returns the type of the next value without consuming it
+             */
+
+            ValueType peekType()
+            {
+                const auto ch = peekChar();
+
+                switch( ch )
+                {
+                    case '{':   return json_spirit::obj_type;
+                    case '[':   return json_spirit::array_type;
+                    case '"':   return json_spirit::str_type;
+                    case 't':   return json_spirit::bool_type;
+                    case 'f':   return json_spirit::bool_type;
+                    case 'n':   return json_spirit::null_type;
+
+                    default:
+                        {
+                            const auto saved = m_pos.value();
+
+                            bool isReal;
+
+                            scanNumber( isReal );
+
+                            m_pos = saved;
+
+                            return isReal ? json_spirit::real_type : json_spirit::int_type;
+                        }
+                }
+            }
+
+            bool tryReadNull()
+            {
+                if( 'n' != peekChar() )
+                {
+                    return false;
+                }
+
+                if( ! tryConsumeLiteral( "null" ) )
+                {
+                    throwParserError( "invalid value" );
+                }
+
+                return true;
+            }
+
+            void read( SAA_out bool& value )
+            {
+                requireType( json_spirit::bool_type );
+
+                if( tryConsumeLiteral( "true" ) )
+                {
+                    value = true;
+                }
+                else if( tryConsumeLiteral( "false" ) )
+                {
+                    value = false;
+                }
+                else
+                {
+                    throwParserError( "invalid value" );
+                }
+            }
+
+            void read( SAA_out int& value )
+            {
+                value = readIntegerAs< int >();
+            }
+
+            void read( SAA_out std::int64_t& value )
+            {
+                value = readIntegerAs< std::int64_t >();
+            }
+
+            void read( SAA_out std::uint64_t& value )
+            {
+                value = readIntegerAs< std::uint64_t >();
+            }
+
+            void read( SAA_out double& value )
+            {
+                const auto type = peekType();
+
+                if( json_spirit::int_type == type )
+                {
+                    /*
+                     * Positive values larger than the int64 maximum are unsigned (in the same
+                     * way json_spirit stores them), so they must not be read as int64
+                     */
+
+                    value = '-' == peekChar() ?
+                        static_cast< double >( readIntegerAs< std::int64_t >() ) :
+                        static_cast< double >( readIntegerAs< std::uint64_t >() );
+
+                    return;
+                }
+
+                if( json_spirit::real_type != type )
+                {
+                    throwTypeMismatch( json_spirit::real_type, type );
+                }
+
+                bool isReal;
+
+                value = parseReal( scanNumber( isReal ) );
+            }
+
+            void read( SAA_out std::string& value )
+            {
+                requireType( json_spirit::str_type );
+
+                scanString( &value );
+            }
+
+            /**
+             * @brief Reads the next value as a json::Value tree; the tree is built in place to
+             * avoid copying the sub-trees
+             */
+
+            void read( SAA_out json::Value& value )
+            {
+                switch( peekType() )
+                {
+                    case json_spirit::obj_type:
+                        {
+                            value = json::Value( json::Object() );
+
+                            auto& object = value.get_obj();
+
+                            readObject(
+                                [ & ]( SAA_in const view_t& key ) -> void
+                                {
+                                    const auto pair = object.emplace( std::string( key.first, key.second ), json::Value() );
+
+                                    if( ! pair.second )
+                                    {
+                                        BL_THROW_USER(
+                                            BL_MSG()
+                                                << "Duplicate entry encountered for property with name '"
+                                                << pair.first -> first
+                                                << "' while parsing a JSON object"
+                                            );
+                                    }
+
+                                    read( pair.first -> second );
+                                }
+                                );
+                        }
+                        break;
+
+                    case json_spirit::array_type:
+                        {
+                            value = json::Value( json::Array() );
+
+                            auto& array = value.get_array();
+
+                            readArray(
+                                [ & ]() -> void
+                                {
+                                    array.push_back( json::Value() );
+
+                                    read( array.back() );
+                                }
+                                );
+                        }
+                        break;
+
+                    case json_spirit::str_type:
+                        {
+                            std::string text;
+
+                            scanString( &text );
+
+                            value = json::Value( text );
+                        }
+                        break;
+
+                    case json_spirit::bool_type:
+                        {
+                            bool flag;
+
+                            read( flag );
+
+                            value = json::Value( flag );
+                        }
+                        break;
+
+                    case json_spirit::real_type:
+                        {
+                            double number;
+
+                            read( number );
+
+                            value = json::Value( number );
+                        }
+                        break;
+
+                    case json_spirit::int_type:
+                        {
+                            bool isReal;
+                            bool isNegative;
+
+                            const auto magnitude = parseInteger( scanNumber( isReal ), isNegative );
+
+                            if( ! isNegative &&
+                                magnitude > static_cast< std::uint64_t >( std::numeric_limits< std::int64_t >::max() ) )
+                            {
+                                value = json::Value( magnitude );
+                            }
+                            else
+                            {
+                                value = json::Value(
+                                    static_cast< std::int64_t >( isNegative ? ( ~magnitude + 1U ) : magnitude )
+                                    );
+                            }
+                        }
+                        break;
+
+                    default:
+                        {
+                            tryReadNull();
+
+                            value = json::Value();
+                        }
+                        break;
+                }
+            }
+
+            json::Value readValue()
+            {
+                json::Value value;
+
+                read( value );
+
+                return value;
+            }
+
+            /**
+             * @brief Skips the next value (it is still validated, but nothing is allocated)
+             */
+
+            void skipValue()
+            {
+                switch( peekType() )
+                {
+                    case json_spirit::obj_type:
+                        readObject(
+                            [ this ]( SAA_in const view_t& /* key */ ) -> void
+                            {
+                                skipValue();
+                            }
+                            );
+                        break;
+
+                    case json_spirit::array_type:
+                        readArray(
+                            [ this ]() -> void
+                            {
+                                skipValue();
+                            }
+                            );
+                        break;
+
+                    case json_spirit::str_type:
+                        scanString( nullptr );
+                        break;
+
+                    case json_spirit::bool_type:
+                        {
+                            bool value;
+
+                            read( value );
+                        }
+                        break;
+
+                    case json_spirit::null_type:
+                        tryReadNull();
+                        break;
+
+                    default:
+                        {
+                            bool isReal;
+
+                            scanNumber( isReal );
+                        }
+                        break;
+                }
+            }
+
+            /**
+             * @brief Skips the next value and returns its raw JSON text as a view
+             */
+
+            view_t captureValue()
+            {
+                skipWhitespace();
+
+                const auto start = m_pos.value();
+
+                skipValue();
+
+                return view_t( start, static_cast< std::size_t >( m_pos.value() - start ) );
+            }
+
+            /**
+             * @brief Reads an object; the callback is invoked for each key and it must consume
+             * the value (e.g. by calling read(), readValue() or skipValue())
+             */
+
+            template
+            <
+                typename CB
+            >
+            void readObject( SAA_in CB&& callback )
+            {
+                requireType( json_spirit::obj_type );
+
+                expectChar( '{' );
+
+                enterNested();
+
+                if( '}' != peekChar() )
+                {
+                    while( true )
+                    {
+                        bool isEscaped;
+
+                        auto key = scanString( nullptr, &isEscaped );
+
+                        if( isEscaped )
+                        {
+                            m_pos = key.first - 1;
+
+                            scanString( &m_keyBuffer );
+
+                            key = view_t( m_keyBuffer.data(), m_keyBuffer.size() );
+                        }
+
+                        expectChar( ':' );
+
+                        callback( key );
+
+                        if( ',' != peekChar() )
+                        {
+                            break;
+                        }
+
+                        ++m_pos.lvalue();
+                    }
+                }
+
+                expectChar( '}' );
+
+                leaveNested();
+            }
+
+            /**
+             * @brief Reads an array; the callback is invoked for each item and it must consume it
+             */
+
+            template
+            <
+                typename CB
+            >
+            void readArray( SAA_in CB&& callback )
+            {
+                requireType( json_spirit::array_type );
+
+                expectChar( '[' );
+
+                enterNested();
+
+                if( ']' != peekChar() )
+                {
+                    while( true )
+                    {
+                        callback();
+
+                        if( ',' != peekChar() )
+                        {
+                            break;
+                        }
+
+                        ++m_pos.lvalue();
+                    }
+                }
+
+                expectChar( ']' );
+
+                leaveNested();
+            }
+        };
+
+        typedef StreamReaderT<> StreamReader;
+
+    } // json
+
+} // bl
+
+#endif /* __BL_JSONSTREAMREADER_H_ */
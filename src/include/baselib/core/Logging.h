@@ -26,7 +26,9 @@
 #include <baselib/core/StringUtils.h>
 #include <baselib/core/TimeUtils.h>
 
+#include <atomic>
 #include <iostream>
+#include <thread>
 
 /*
  * The logging interface; e.g.
@@ -37,6 +39,9 @@
  *             << "The answer to the Ultimate Question of Life is "
  *             << 42
  *         );
+ *
+ * Note that the message expression is not evaluated at all (i.e. nothing is
+ * formatted) if the channel is not enabled for the current logging level
  */
 
 #define BL_LOG( channel, msg ) \
@@ -106,6 +111,27 @@ namespace bl
             LL_DEFAULT = -1
         };
 
+        /**
+         * @brief What to do when the per thread queue of the async mode is full
+         *
+         * OVERFLOW_BLOCK - the logging thread waits until the flusher thread makes room
+         * OVERFLOW_DROP - the message is dropped and the number of the dropped messages
+         * is reported later; this applies only to the info, debug and trace channels - the
+         * notify, error and warning messages are never dropped
+         */
+
+        enum OverflowPolicy
+        {
+            OVERFLOW_BLOCK,
+            OVERFLOW_DROP,
+        };
+
+        enum : std::size_t
+        {
+            ASYNC_QUEUE_CAPACITY_DEFAULT = 4096U,
+            ASYNC_FLUSH_INTERVAL_IN_MILLISECONDS_DEFAULT = 50U,
+        };
+
         class Channel;
 
         static Channel& notify()   { return g_notify; }
@@ -140,9 +166,208 @@ namespace bl
         static Level g_level;
 
         static os::mutex g_lock;
+        static std::atomic< std::thread::id > g_lockOwner;
         static line_logger_t g_lineLogger;
         static channels_t g_level2Channel;
 
+        /**
+         * @brief A log record queued in the async mode
+         *
+         * The channel prefix strings are static, so they are referenced by pointer
+         */
+
+        struct AsyncRecord
+        {
+            const std::string*                              prefix;
+            std::string                                     text;
+            Level                                           level;
+            bool                                            enableTimestamp;
+            bool                                            isMultiLine;
+        };
+
+        /**
+         * @brief A bounded single producer / single consumer ring buffer of log
+         * records; there is one per logging thread and the consumer is whoever
+         * holds g_lock (normally the flusher thread)
+         */
+
+        class AsyncQueue
+        {
+            BL_NO_COPY( AsyncQueue )
+
+        private:
+
+            enum : std::size_t
+            {
+                CACHE_LINE_SIZE = 64U,
+            };
+
+            const std::size_t                               m_capacity;
+            cpp::SafeUniquePtr< AsyncRecord[] >             m_records;
+
+            std::atomic< std::size_t >                      m_head;
+            char                                            m_padding[ CACHE_LINE_SIZE ];
+            std::atomic< std::size_t >                      m_tail;
+            std::atomic< std::size_t >                      m_dropped;
+            std::atomic< bool >                             m_orphaned;
+
+        public:
+
+            AsyncQueue( SAA_in const std::size_t capacity )
+                :
+                m_capacity( capacity ),
+                m_records( cpp::SafeUniquePtr< AsyncRecord[] >::attach( new AsyncRecord[ capacity ] ) ),
+                m_head( 0U ),
+                m_tail( 0U ),
+                m_dropped( 0U ),
+                m_orphaned( false )
+            {
+                BL_UNUSED( m_padding );
+            }
+
+            std::size_t capacity() const NOEXCEPT
+            {
+                return m_capacity;
+            }
+
+            std::size_t size() const NOEXCEPT
+            {
+                return m_tail.load( std::memory_order_acquire ) - m_head.load( std::memory_order_acquire );
+            }
+
+            bool isOrphaned() const NOEXCEPT
+            {
+                return m_orphaned.load( std::memory_order_acquire );
+            }
+
+            void setOrphaned() NOEXCEPT
+            {
+                m_orphaned.store( true, std::memory_order_release );
+            }
+
+            void notifyDropped() NOEXCEPT
+            {
+                m_dropped.fetch_add( 1U, std::memory_order_relaxed );
+            }
+
+            std::size_t takeDropped() NOEXCEPT
+            {
+                return m_dropped.exchange( 0U, std::memory_order_relaxed );
+            }
+
+            /**
+             * @brief Called only by the thread which owns the queue; the text of the
+             * record is moved into the queue on success
+             */
+
+            bool tryPush( SAA_inout AsyncRecord& record ) NOEXCEPT
+            {
+                const auto tail = m_tail.load( std::memory_order_relaxed );
+
+                if( tail - m_head.load( std::memory_order_acquire ) == m_capacity )
+                {
+                    return false;
+                }
+
+                auto& slot = m_records[ tail & ( m_capacity - 1U ) ];
+
+                slot.prefix = record.prefix;
+                slot.text.swap( record.text );
+                slot.level = record.level;
+                slot.enableTimestamp = record.enableTimestamp;
+                slot.isMultiLine = record.isMultiLine;
+
+                m_tail.store( tail + 1U, std::memory_order_release );
+
+                return true;
+            }
+
+            /**
+             * @brief Called only by the consumer (i.e. with g_lock held)
+             */
+
+            template
+            <
+                typename CB
+            >
+            void drain( SAA_in const CB& cb )
+            {
+                const auto tail = m_tail.load( std::memory_order_acquire );
+
+                for( auto head = m_head.load( std::memory_order_relaxed ); head != tail; ++head )
+                {
+                    auto& slot = m_records[ head & ( m_capacity - 1U ) ];
+
+                    /*
+                     * The slot is released even if the callback throws, so a failing
+                     * line logger can't make the producer wait forever
+                     */
+
+                    BL_SCOPE_EXIT(
+                        {
+                            std::string().swap( slot.text );
+                            m_head.store( head + 1U, std::memory_order_release );
+                        }
+                        );
+
+                    cb( slot );
+                }
+            }
+        };
+
+        class AsyncQueueHolder
+        {
+            BL_NO_COPY( AsyncQueueHolder )
+
+        private:
+
+            const std::shared_ptr< AsyncQueue >             m_queue;
+
+        public:
+
+            AsyncQueueHolder( SAA_in const std::shared_ptr< AsyncQueue >& queue )
+                :
+                m_queue( queue )
+            {
+            }
+
+            ~AsyncQueueHolder() NOEXCEPT
+            {
+                /*
+                 * The thread is exiting - the flusher thread will discard the queue once
+                 * it has been drained
+                 */
+
+                m_queue -> setOrphaned();
+            }
+
+            AsyncQueue& queue() const NOEXCEPT
+            {
+                return *m_queue;
+            }
+        };
+
+        typedef std::vector< std::shared_ptr< AsyncQueue > > async_queues_t;
+
+        /*
+         * The async mode state - g_asyncLock protects the list of the queues
+         * and the flusher thread
+         */
+
+        static std::atomic< bool > g_asyncEnabled;
+        static OverflowPolicy g_asyncOverflowPolicy;
+        static std::size_t g_asyncQueueCapacity;
+        static std::size_t g_asyncFlushIntervalInMilliseconds;
+        static bool g_asyncStopRequested;
+
+        static os::mutex g_asyncLock;
+        static os::condition_variable g_asyncFlushEvent;
+        static os::condition_variable g_asyncSpaceEvent;
+        static async_queues_t g_asyncQueues;
+        static cpp::SafeUniquePtr< os::thread > g_asyncFlusher;
+        static std::atomic< std::thread::id > g_asyncFlusherId;
+        static os::thread_specific_ptr< AsyncQueueHolder > g_asyncQueueHolder;
+
         static const std::string g_noneLabel;
         static const std::string g_notifyLabel;
         static const std::string g_errorLabel;
@@ -151,6 +376,60 @@ namespace bl
         static const std::string g_debugLabel;
         static const std::string g_traceLabel;
 
+        static bool isLockOwner() NOEXCEPT
+        {
+            /*
+             * Only the thread which holds g_lock can observe its own id here
+             */
+
+            return g_lockOwner.load( std::memory_order_relaxed ) == std::this_thread::get_id();
+        }
+
+        /**
+         * @brief The guard for g_lock which tracks the owner thread
+         *
+         * It is re-entrant, so a line logger which logs itself (e.g. on a write error)
+         * does not deadlock; the nested record is written with the lock already held
+         */
+
+        class LockGuard
+        {
+            BL_NO_COPY( LockGuard )
+
+        private:
+
+            const bool                                      m_isAcquired;
+
+        public:
+
+            LockGuard()
+                :
+                m_isAcquired( ! isLockOwner() )
+            {
+                if( m_isAcquired )
+                {
+                    g_lock.lock();
+                    g_lockOwner.store( std::this_thread::get_id(), std::memory_order_relaxed );
+                }
+            }
+
+            LockGuard( SAA_in const std::adopt_lock_t& )
+                :
+                m_isAcquired( true )
+            {
+                g_lockOwner.store( std::this_thread::get_id(), std::memory_order_relaxed );
+            }
+
+            ~LockGuard() NOEXCEPT
+            {
+                if( m_isAcquired )
+                {
+                    g_lockOwner.store( std::thread::id(), std::memory_order_relaxed );
+                    g_lock.unlock();
+                }
+            }
+        };
+
         static Level safeCastLevelNoThrow( SAA_in const int level ) NOEXCEPT
         {
             if( level >= LL_NONE && level < LL_LAST )
@@ -190,6 +469,349 @@ namespace bl
             return channels;
         }
 
+        static AsyncQueue& getAsyncQueue()
+        {
+            auto* holder = g_asyncQueueHolder.get();
+
+            if( ! holder )
+            {
+                BL_MUTEX_GUARD( g_asyncLock );
+
+                const auto queue = std::make_shared< AsyncQueue >( g_asyncQueueCapacity );
+
+                g_asyncQueues.push_back( queue );
+                g_asyncQueueHolder.reset( new AsyncQueueHolder( queue ) );
+
+                holder = g_asyncQueueHolder.get();
+            }
+
+            return holder -> queue();
+        }
+
+        static void writeRecordNoLock( SAA_in const AsyncRecord& record )
+        {
+            if( ! g_lineLogger )
+            {
+                return;
+            }
+
+            if( ! record.isMultiLine )
+            {
+                g_lineLogger( *record.prefix, record.text, record.enableTimestamp, record.level );
+
+                return;
+            }
+
+            cpp::SafeInputStringStream is( record.text );
+
+            std::string line;
+            while( ! is.eof() )
+            {
+                std::getline( is, line );
+
+                g_lineLogger( *record.prefix, line, record.enableTimestamp, record.level );
+            }
+        }
+
+        /**
+         * @brief Writes out all queued records (the caller must hold g_lock)
+         *
+         * The records of each thread are written in order, but there is no ordering
+         * between the records of different threads beyond the flush boundaries
+         */
+
+        static void flushAsyncNoLock()
+        {
+            async_queues_t queues;
+
+            {
+                BL_MUTEX_GUARD( g_asyncLock );
+
+                queues = g_asyncQueues;
+            }
+
+            bool hasOrphaned = false;
+
+            for( const auto& queue : queues )
+            {
+                hasOrphaned = hasOrphaned || queue -> isOrphaned();
+
+                queue -> drain( &this_type::writeRecordNoLock );
+
+                const auto dropped = queue -> takeDropped();
+
+                if( dropped && g_lineLogger )
+                {
+                    g_lineLogger(
+                        g_warning.prefix(),
+                        resolveMessage(
+                            BL_MSG()
+                                << dropped
+                                << " log message(s) were dropped because the async logging queue was full"
+                            ),
+                        false /* enableTimestamp */,
+                        LL_WARNING
+                        );
+                }
+            }
+
+            if( hasOrphaned )
+            {
+                /*
+                 * The orphaned flag must be checked before the queue size, so a record
+                 * pushed just before the thread has exited is never lost
+                 */
+
+                BL_MUTEX_GUARD( g_asyncLock );
+
+                g_asyncQueues.erase(
+                    std::remove_if(
+                        g_asyncQueues.begin(),
+                        g_asyncQueues.end(),
+                        []( SAA_in const std::shared_ptr< AsyncQueue >& queue ) -> bool
+                        {
+                            return queue -> isOrphaned() && 0U == queue -> size();
+                        }
+                        ),
+                    g_asyncQueues.end()
+                    );
+            }
+
+            /*
+             * Wake up the logging threads waiting for room in their queues; g_asyncLock
+             * is taken so the wake up can't be missed by a thread which has just checked
+             * its queue and is about to wait
+             */
+
+            {
+                BL_MUTEX_GUARD( g_asyncLock );
+            }
+
+            g_asyncSpaceEvent.notify_all();
+        }
+
+        /**
+         * @brief Reports a flush failure (e.g. a write error of the line logger) without
+         * stopping the flusher thread - the logging threads could otherwise wait for it
+         * forever in the OVERFLOW_BLOCK mode
+         */
+
+        static void reportAsyncFlushFailure( SAA_in const std::exception& exception ) NOEXCEPT
+        {
+            try
+            {
+                LockGuard guard;
+
+                if( g_lineLogger )
+                {
+                    g_lineLogger(
+                        g_warning.prefix(),
+                        resolveMessage(
+                            BL_MSG()
+                                << "Flushing of the async logging queues has failed: "
+                                << exception.what()
+                            ),
+                        false /* enableTimestamp */,
+                        LL_WARNING
+                        );
+                }
+            }
+            catch( std::exception& )
+            {
+                /*
+                 * The line logger is not usable at the moment; the next flush will retry
+                 */
+            }
+        }
+
+        static void runAsyncFlusher() NOEXCEPT
+        {
+            BL_NOEXCEPT_BEGIN()
+
+            /*
+             * The flusher thread writes its own records synchronously (see tryOutAsync)
+             */
+
+            g_asyncFlusherId.store( std::this_thread::get_id(), std::memory_order_release );
+
+            BL_SCOPE_EXIT(
+                {
+                    g_asyncFlusherId.store( std::thread::id(), std::memory_order_release );
+                }
+                );
+
+            for( ;; )
+            {
+                bool stopRequested;
+
+                {
+                    os::mutex_unique_lock guard( g_asyncLock );
+
+                    if( ! g_asyncStopRequested )
+                    {
+                        g_asyncFlushEvent.wait_for(
+                            guard,
+                            os::chrono::milliseconds( g_asyncFlushIntervalInMilliseconds )
+                            );
+                    }
+
+                    stopRequested = g_asyncStopRequested;
+                }
+
+                try
+                {
+                    flushAsync();
+                }
+                catch( std::exception& e )
+                {
+                    reportAsyncFlushFailure( e );
+                }
+
+                if( stopRequested )
+                {
+                    break;
+                }
+            }
+
+            BL_NOEXCEPT_END()
+        }
+
+        /**
+         * @brief Invoked by BL_RIP_MSG before the process is aborted, so the messages
+         * which explain the failure are not lost in the queues
+         *
+         * It must not block indefinitely and it must not touch g_lock if the failing
+         * thread already holds it (e.g. the line logger itself has failed) - the flush
+         * is skipped in this case as the state of the line logger is unknown
+         */
+
+        static void flushAsyncOnFatalError()
+        {
+            try
+            {
+                if( isLockOwner() )
+                {
+                    return;
+                }
+
+                bool isLocked = false;
+
+                for( std::size_t i = 0U; i < 100U && ! isLocked; ++i )
+                {
+                    isLocked = g_lock.try_lock();
+
+                    if( ! isLocked )
+                    {
+                        std::this_thread::sleep_for( os::chrono::milliseconds( 10 ) );
+                    }
+                }
+
+                if( isLocked )
+                {
+                    LockGuard guard( std::adopt_lock );
+
+                    flushAsyncNoLock();
+                }
+            }
+            catch( ... )
+            {
+                /*
+                 * The process is going down anyway
+                 */
+            }
+        }
+
+        /**
+         * @brief Queues the record if the async mode is enabled; returns false
+         * if it isn't and the record needs to be written synchronously
+         *
+         * The records logged by the flusher thread or from within the line logger (i.e.
+         * with g_lock held) are also written synchronously, as nobody else would drain
+         * the queue while such a thread waits for room in it
+         */
+
+        static bool tryOutAsync(
+            SAA_in          const std::string&              prefix,
+            SAA_inout       std::string&&                   text,
+            SAA_in          const Level                     level,
+            SAA_in          const bool                      isMultiLine
+            )
+        {
+            if( ! g_asyncEnabled.load( std::memory_order_acquire ) )
+            {
+                return false;
+            }
+
+            if( isLockOwner() || g_asyncFlusherId.load( std::memory_order_acquire ) == std::this_thread::get_id() )
+            {
+                return false;
+            }
+
+            auto& queue = getAsyncQueue();
+
+            AsyncRecord record;
+
+            record.prefix = &prefix;
+            record.text.swap( text );
+            record.level = level;
+            record.enableTimestamp = isVerboseModeEnabled();
+            record.isMultiLine = isMultiLine;
+
+            while( ! queue.tryPush( record ) )
+            {
+                if( OVERFLOW_DROP == g_asyncOverflowPolicy && level > LL_WARNING )
+                {
+                    queue.notifyDropped();
+
+                    return true;
+                }
+
+                /*
+                 * Back pressure - wake up the flusher and wait for it to make room
+                 * (or drain the queue ourselves if the async mode was disabled)
+                 */
+
+                if( g_asyncEnabled.load( std::memory_order_acquire ) )
+                {
+                    os::mutex_unique_lock guard( g_asyncLock );
+
+                    g_asyncFlushEvent.notify_one();
+
+                    g_asyncSpaceEvent.wait_for(
+                        guard,
+                        os::chrono::milliseconds( g_asyncFlushIntervalInMilliseconds ),
+                        [ & ]() -> bool
+                        {
+                            return
+                                queue.size() < queue.capacity() ||
+                                ! g_asyncEnabled.load( std::memory_order_acquire );
+                        }
+                        );
+                }
+                else
+                {
+                    flushAsync();
+                }
+            }
+
+            if( 2U * queue.size() >= queue.capacity() )
+            {
+                g_asyncFlushEvent.notify_one();
+            }
+
+            if( ! g_asyncEnabled.load( std::memory_order_acquire ) )
+            {
+                /*
+                 * The async mode was disabled concurrently and the final flush may
+                 * have already happened
+                 */
+
+                flushAsync();
+            }
+
+            return true;
+        }
+
     public:
 
         static void defaultLineLoggerNoLock(
@@ -264,7 +886,7 @@ namespace bl
 
         static line_logger_t setLineLogger( SAA_in const line_logger_t& lineLogger )
         {
-            BL_MUTEX_GUARD( g_lock );
+            LockGuard guard;
 
             const line_logger_t prev = g_lineLogger;
             g_lineLogger = lineLogger;
@@ -282,6 +904,110 @@ namespace bl
                 );
         }
 
+        /**
+         * @brief Switches the logging into async mode
+         *
+         * In async mode BL_LOG only formats the message and queues it in a lock free
+         * per thread queue and a dedicated flusher thread writes out the queued records
+         * in batches (every flushIntervalInMilliseconds or sooner if a queue is getting
+         * full) with the line logger, so the logging threads never wait for the I/O
+         *
+         * The queues are bounded (queueCapacity must be a power of 2) and policy controls
+         * what happens when a queue is full. The queues are flushed when the async mode is
+         * disabled and also before the process is aborted by BL_RIP_MSG
+         *
+         * Note that in async mode the timestamps (in verbose mode) reflect the time when
+         * the message was flushed rather than the time when it was logged
+         */
+
+        static void enableAsyncMode(
+            SAA_in_opt  const std::size_t           queueCapacity = ASYNC_QUEUE_CAPACITY_DEFAULT,
+            SAA_in_opt  const OverflowPolicy        policy = OVERFLOW_BLOCK,
+            SAA_in_opt  const std::size_t           flushIntervalInMilliseconds = ASYNC_FLUSH_INTERVAL_IN_MILLISECONDS_DEFAULT
+            )
+        {
+            BL_CHK_ARG( queueCapacity && 0U == ( queueCapacity & ( queueCapacity - 1U ) ), queueCapacity );
+            BL_CHK_ARG( flushIntervalInMilliseconds, flushIntervalInMilliseconds );
+
+            BL_MUTEX_GUARD( g_asyncLock );
+
+            BL_CHK(
+                true,
+                nullptr != g_asyncFlusher.get(),
+                BL_MSG()
+                    << "The async logging mode is already enabled"
+                );
+
+            g_asyncOverflowPolicy = policy;
+            g_asyncQueueCapacity = queueCapacity;
+            g_asyncFlushIntervalInMilliseconds = flushIntervalInMilliseconds;
+            g_asyncStopRequested = false;
+
+            g_asyncFlusher = cpp::SafeUniquePtr< os::thread >::attach(
+                new os::thread( &this_type::runAsyncFlusher )
+                );
+
+            detail::GlobalHooks::setFatalErrorHook( &this_type::flushAsyncOnFatalError );
+
+            g_asyncEnabled.store( true, std::memory_order_release );
+        }
+
+        /**
+         * @brief Switches the logging back into synchronous mode after all queued
+         * records were written out; returns false if the async mode was not enabled
+         */
+
+        static bool disableAsyncMode()
+        {
+            cpp::SafeUniquePtr< os::thread > flusher;
+
+            {
+                BL_MUTEX_GUARD( g_asyncLock );
+
+                if( ! g_asyncFlusher )
+                {
+                    return false;
+                }
+
+                g_asyncEnabled.store( false, std::memory_order_release );
+                g_asyncStopRequested = true;
+
+                flusher = std::move( g_asyncFlusher );
+            }
+
+            g_asyncFlushEvent.notify_all();
+            g_asyncSpaceEvent.notify_all();
+            flusher -> join();
+
+            detail::GlobalHooks::setFatalErrorHook( nullptr );
+
+            /*
+             * The flusher thread does a final flush before it exits, but a record may
+             * still have been queued by a thread which has not yet observed the switch
+             */
+
+            flushAsync();
+
+            return true;
+        }
+
+        static bool isAsyncModeEnabled() NOEXCEPT
+        {
+            return g_asyncEnabled.load( std::memory_order_acquire );
+        }
+
+        /**
+         * @brief Writes out all records queued in async mode (it is a no-op in
+         * synchronous mode)
+         */
+
+        static void flushAsync()
+        {
+            LockGuard guard;
+
+            flushAsyncNoLock();
+        }
+
         static bool isVerboseModeEnabled()
         {
             return ( getLevel() >= LL_DEBUG );
@@ -454,11 +1180,18 @@ namespace bl
 
                 if( isEnabled() )
                 {
-                    BL_MUTEX_GUARD( g_lock );
+                    auto text = resolveMessage( std::forward< T >( msg ) );
+
+                    if( tryOutAsync( m_prefix, std::move( text ), m_level, false /* isMultiLine */ ) )
+                    {
+                        return;
+                    }
+
+                    LockGuard guard;
 
                     g_lineLogger(
                         m_prefix,
-                        resolveMessage( std::forward< T >( msg ) ),
+                        text,
                         isVerboseModeEnabled() /* enableTimestamp */,
                         m_level
                         );
@@ -482,9 +1215,16 @@ namespace bl
 
                 if( isEnabled() )
                 {
-                    BL_MUTEX_GUARD( g_lock );
+                    auto text = bl::resolveMessage( std::forward< T >( msg ) );
+
+                    if( tryOutAsync( m_prefix, std::move( text ), m_level, true /* isMultiLine */ ) )
+                    {
+                        return;
+                    }
+
+                    LockGuard guard;
 
-                    cpp::SafeInputStringStream is( bl::resolveMessage( std::forward< T >( msg ) ) );
+                    cpp::SafeInputStringStream is( text );
 
                     std::string line;
                     while( ! is.eof() )
@@ -539,6 +1279,49 @@ namespace bl
             }
         };
 
+        /**
+         * @brief Async mode enable/restore wrapper; it does nothing if the async
+         * mode is already enabled
+         */
+
+        class AsyncModePusher
+        {
+            BL_NO_COPY( AsyncModePusher )
+
+        private:
+
+            bool m_enabled;
+
+        public:
+
+            AsyncModePusher(
+                SAA_in_opt  const std::size_t           queueCapacity = ASYNC_QUEUE_CAPACITY_DEFAULT,
+                SAA_in_opt  const OverflowPolicy        policy = OVERFLOW_BLOCK,
+                SAA_in_opt  const std::size_t           flushIntervalInMilliseconds = ASYNC_FLUSH_INTERVAL_IN_MILLISECONDS_DEFAULT
+                )
+                :
+                m_enabled( false )
+            {
+                if( ! isAsyncModeEnabled() )
+                {
+                    enableAsyncMode( queueCapacity, policy, flushIntervalInMilliseconds );
+                    m_enabled = true;
+                }
+            }
+
+            ~AsyncModePusher() NOEXCEPT
+            {
+                BL_NOEXCEPT_BEGIN()
+
+                if( m_enabled )
+                {
+                    disableAsyncMode();
+                }
+
+                BL_NOEXCEPT_END()
+            }
+        };
+
         /**
          * @brief Line logger push/restore wrapper
          */
@@ -561,7 +1344,7 @@ namespace bl
 
             ~LineLoggerPusher() NOEXCEPT
             {
-                BL_MUTEX_GUARD( g_lock );
+                LockGuard guard;
 
                 g_lineLogger.swap( m_prev );
             }
@@ -577,9 +1360,23 @@ namespace bl
 
     BL_DEFINE_STATIC_MEMBER( LoggingT, typename LoggingT< TCLASS >::Level, g_level )                = LoggingT< TCLASS >::LL_INFO;
     BL_DEFINE_STATIC_MEMBER( LoggingT, os::mutex, g_lock );
+    BL_DEFINE_STATIC_MEMBER( LoggingT, std::atomic< std::thread::id >, g_lockOwner )( ( std::thread::id() ) );
     BL_DEFINE_STATIC_MEMBER( LoggingT, typename LoggingT< TCLASS >::line_logger_t, g_lineLogger )   = LoggingT< TCLASS >::getDefaultLineLogger();
     BL_DEFINE_STATIC_MEMBER( LoggingT, typename LoggingT< TCLASS >::channels_t, g_level2Channel )   = LoggingT< TCLASS >::getChannels();
 
+    BL_DEFINE_STATIC_MEMBER( LoggingT, std::atomic< bool >, g_asyncEnabled )( false );
+    BL_DEFINE_STATIC_MEMBER( LoggingT, typename LoggingT< TCLASS >::OverflowPolicy, g_asyncOverflowPolicy )  = LoggingT< TCLASS >::OVERFLOW_BLOCK;
+    BL_DEFINE_STATIC_MEMBER( LoggingT, std::size_t, g_asyncQueueCapacity )                          = LoggingT< TCLASS >::ASYNC_QUEUE_CAPACITY_DEFAULT;
+    BL_DEFINE_STATIC_MEMBER( LoggingT, std::size_t, g_asyncFlushIntervalInMilliseconds )            = LoggingT< TCLASS >::ASYNC_FLUSH_INTERVAL_IN_MILLISECONDS_DEFAULT;
+    BL_DEFINE_STATIC_MEMBER( LoggingT, bool, g_asyncStopRequested )                                 = false;
+    BL_DEFINE_STATIC_MEMBER( LoggingT, os::mutex, g_asyncLock );
+    BL_DEFINE_STATIC_MEMBER( LoggingT, os::condition_variable, g_asyncFlushEvent );
+    BL_DEFINE_STATIC_MEMBER( LoggingT, os::condition_variable, g_asyncSpaceEvent );
+    BL_DEFINE_STATIC_MEMBER( LoggingT, typename LoggingT< TCLASS >::async_queues_t, g_asyncQueues );
+    BL_DEFINE_STATIC_MEMBER( LoggingT, cpp::SafeUniquePtr< os::thread >, g_asyncFlusher );
+    BL_DEFINE_STATIC_MEMBER( LoggingT, std::atomic< std::thread::id >, g_asyncFlusherId )( ( std::thread::id() ) );
+    BL_DEFINE_STATIC_MEMBER( LoggingT, os::thread_specific_ptr< typename LoggingT< TCLASS >::AsyncQueueHolder >, g_asyncQueueHolder );
+
     BL_DEFINE_STATIC_CONST_STRING ( LoggingT, g_noneLabel )                                         = "none";
     BL_DEFINE_STATIC_CONST_STRING ( LoggingT, g_notifyLabel )                                       = "notify";
     BL_DEFINE_STATIC_CONST_STRING ( LoggingT, g_errorLabel )                                        = "error";
@@ -692,6 +692,97 @@ namespace bl
             return detail::OS::ftell( fileptr );
         }
 
+        /**
+         * @brief Reads exactly sizeInBytes at the specified offset without moving the file
+         * position and bypassing the stdio buffer
+         *
+         * Similar to fread it fails if the read goes past the end of file and unlike fseek +
+         * fread it can be called concurrently on the same file by multiple threads
+         */
+
+        inline void fpread(
+            SAA_in          const stdio_file_ptr&               fileptr,
+            SAA_in          const std::uint64_t                 offset,
+            SAA_out_bcount( sizeInBytes ) void*                 buffer,
+            SAA_in          const std::size_t                   sizeInBytes
+            )
+        {
+            detail::OS::fpread( fileptr, offset, buffer, sizeInBytes );
+        }
+
+        /**
+         * @brief Writes the buffer at the specified offset without moving the file position and
+         * bypassing the stdio buffer (i.e. the file must not be written with fwrite at the same time)
+         *
+         * Unlike fseek + fwrite it can be called concurrently on the same file by multiple threads
+         */
+
+        inline void fpwrite(
+            SAA_in          const stdio_file_ptr&               fileptr,
+            SAA_in          const std::uint64_t                 offset,
+            SAA_in_bcount( sizeInBytes ) const void*            buffer,
+            SAA_in          const std::size_t                   sizeInBytes
+            )
+        {
+            detail::OS::fpwrite( fileptr, offset, buffer, sizeInBytes );
+        }
+
+        /**
+         * @brief Reserves the disk space for a file which is going to be written with the
+         * specified size (where the platform and the file system support it)
+         *
+         * If the preallocation is done the file is also extended to the specified size
+         */
+
+        inline void fpreallocate(
+            SAA_in          const stdio_file_ptr&               fileptr,
+            SAA_in          const std::uint64_t                 size
+            )
+        {
+            detail::OS::fpreallocate( fileptr, size );
+        }
+
+        /**
+         * @brief Flushes the stdio buffer and the file data and metadata to the disk
+         * (i.e. fflush + fsync)
+         */
+
+        inline void fsync( SAA_in const stdio_file_ptr& fileptr )
+        {
+            detail::OS::fsync( fileptr );
+        }
+
+        /**
+         * @brief Flushes the directory entries (e.g. after a file was created, renamed or deleted)
+         * to the disk, where the platform and the file system support it
+         */
+
+        inline void fsyncDirectory( SAA_in const fs::path& path )
+        {
+            detail::OS::fsyncDirectory( path );
+        }
+
+        /**
+         * @brief Reads all entries of a directory (except . and ..) in a single pass
+         *
+         * The entry types are taken from the directory enumeration itself where the
+         * platform provides them and stat is only called as requested by statMode
+         * (or when the type is not known); it is much cheaper than iterating with
+         * fs::directory_iterator and calling symlink_status() for each entry
+         *
+         * The error code is only set if the directory can't be opened or read
+         */
+
+        inline void readDirectory(
+            SAA_in          const fs::path&                             path,
+            SAA_in          const DirectoryStatMode                     statMode,
+            SAA_inout       std::vector< DirectoryEntryInfo >&          entries,
+            SAA_out         eh::error_code&                             ec
+            )
+        {
+            detail::OS::readDirectory( path, statMode, entries, ec );
+        }
+
         inline std::time_t getFileCreateTime( SAA_in const fs::path& path )
         {
             return detail::OS::getFileCreateTime( path );
@@ -918,6 +1009,11 @@ namespace bl
             return false;
         }
 
+        inline bool trySetCurrentThreadAffinity( SAA_in const std::size_t cpuIndex ) NOEXCEPT
+        {
+            return detail::OS::trySetCurrentThreadAffinity( cpuIndex );
+        }
+
         inline void daemonize()
         {
             detail::OS::daemonize();
@@ -28,6 +28,7 @@
 #include <baselib/core/Logging.h>
 #include <baselib/core/PoolAllocatorDefault.h>
 
+#include <atomic>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
@@ -201,8 +202,8 @@ namespace bl
      * Note: T must also be std::is_nothrow_default_constructible
      *
      * Note: This is somewhat naive implementation which uses a vector and a
-     * lock. A more scalable implementation could be done in the future which
-     * is lock free (e.g. slist based)
+     * lock. See LockFreePool below for a more scalable lock free implementation
+     * with the same interface
      *
      * The default checker is SimplePoolCheckerIntrusiveImplPtr as we expect in
      * most cases these objects to be smart pointers (om::ObjPtr or cpp::SafeUniquePtr)
@@ -287,6 +288,290 @@ namespace bl
         }
     };
 
+    /**
+     * @brief class LockFreePool - a lock free pool implementation with the same
+     * semantics and interface as SimplePool (tryGet() / put())
+     *
+     * The implementation is a Treiber stack (LIFO, so recently used objects which
+     * are likely still hot in the cache are handed out first) over a fixed array
+     * of nodes which is pre-allocated at construction time. The nodes are never
+     * freed while the pool is alive, so they are referenced by index and the stack
+     * heads pack the index with a modification tag in a single 64 bit word which
+     * protects against the ABA problem without the need of a double width CAS
+     *
+     * There are two stacks - one of the nodes which hold cached objects and one of
+     * the free nodes. If the pool is full (i.e. there are no free nodes) then put()
+     * simply drops the object and it will be destroyed by the caller
+     *
+     * Note: T must be std::nothrow_move_constructible or std::nothrow_copy_constructible
+     * Note: T must also be std::is_nothrow_default_constructible
+     *
+     * Note: the CHECKER policy is invoked without a lock, so it must not keep any
+     * shared state (i.e. SimplePoolCheckerNaiveImpl can't be used here, but the
+     * default SimplePoolCheckerIntrusiveImplPtr is safe as it only touches the
+     * object which is exclusively owned by the caller at this point)
+     */
+
+    template
+    <
+        typename T,
+        template < typename > class CHECKER = SimplePoolCheckerIntrusiveImplPtr
+    >
+    class LockFreePool :
+        public om::ObjectDefaultBase,
+        private CHECKER< T >
+    {
+        BL_DECLARE_OBJECT_IMPL_NO_DESTRUCTOR( LockFreePool )
+
+    public:
+
+        enum : std::size_t
+        {
+            CAPACITY_DEFAULT = 4096U,
+        };
+
+    private:
+
+        typedef CHECKER< T >                                checker_t;
+        typedef std::uint64_t                               head_t;
+
+        enum : std::uint32_t
+        {
+            INVALID_INDEX = 0xFFFFFFFFU,
+        };
+
+        enum : std::size_t
+        {
+            CACHE_LINE_SIZE = 64U,
+        };
+
+        struct Node
+        {
+            T                                               value;
+            std::atomic< std::uint32_t >                    next;
+
+            Node() NOEXCEPT
+                :
+                value(),
+                next( INVALID_INDEX )
+            {
+            }
+        };
+
+        const std::string                                   m_name;
+        const std::size_t                                   m_capacity;
+        cpp::SafeUniquePtr< Node[] >                        m_nodes;
+
+        /*
+         * The two stack heads are kept on separate cache lines as the used stack
+         * is modified by both tryGet() and put() and the free one is too, but
+         * still this avoids some unnecessary false sharing
+         */
+
+        std::atomic< head_t >                               m_usedHead;
+        char                                                m_padding[ CACHE_LINE_SIZE ];
+        std::atomic< head_t >                               m_freeHead;
+
+        static head_t makeHead(
+            SAA_in          const std::uint32_t             index,
+            SAA_in          const std::uint32_t             tag
+            ) NOEXCEPT
+        {
+            return ( static_cast< head_t >( tag ) << 32 ) | index;
+        }
+
+        static std::uint32_t getIndex( SAA_in const head_t head ) NOEXCEPT
+        {
+            return static_cast< std::uint32_t >( head & 0xFFFFFFFFU );
+        }
+
+        static std::uint32_t getTag( SAA_in const head_t head ) NOEXCEPT
+        {
+            return static_cast< std::uint32_t >( head >> 32 );
+        }
+
+        Node* popNode( SAA_inout std::atomic< head_t >& head ) NOEXCEPT
+        {
+            auto current = head.load( std::memory_order_acquire );
+
+            for( ;; )
+            {
+                const auto index = getIndex( current );
+
+                if( INVALID_INDEX == index )
+                {
+                    return nullptr;
+                }
+
+                /*
+                 * Note: the node can be popped and pushed back by another thread
+                 * while we read its next pointer, but in this case the tag will be
+                 * different and the CAS below will fail (the nodes are never freed
+                 * while the pool is alive, so the read itself is always safe)
+                 */
+
+                const auto next = m_nodes[ index ].next.load( std::memory_order_relaxed );
+
+                if(
+                    head.compare_exchange_weak(
+                        current,
+                        makeHead( next, getTag( current ) + 1U ),
+                        std::memory_order_acquire,
+                        std::memory_order_acquire
+                        )
+                    )
+                {
+                    return &m_nodes[ index ];
+                }
+            }
+        }
+
+        void pushNode(
+            SAA_inout       std::atomic< head_t >&          head,
+            SAA_in          Node*                           node
+            ) NOEXCEPT
+        {
+            const auto index = static_cast< std::uint32_t >( node - m_nodes.get() );
+
+            auto current = head.load( std::memory_order_relaxed );
+
+            for( ;; )
+            {
+                node -> next.store( getIndex( current ), std::memory_order_relaxed );
+
+                if(
+                    head.compare_exchange_weak(
+                        current,
+                        makeHead( index, getTag( current ) + 1U ),
+                        std::memory_order_release,
+                        std::memory_order_relaxed
+                        )
+                    )
+                {
+                    return;
+                }
+            }
+        }
+
+    protected:
+
+        LockFreePool(
+            SAA_in          std::string&&                   name = std::string(),
+            SAA_in          const std::size_t               capacity = CAPACITY_DEFAULT
+            )
+            :
+            m_name( BL_PARAM_FWD( name ) ),
+            m_capacity( capacity ),
+            m_usedHead( makeHead( INVALID_INDEX, 0U ) ),
+            m_freeHead( makeHead( INVALID_INDEX, 0U ) )
+        {
+            static_assert(
+                std::is_nothrow_move_constructible< T >::value ||
+                std::is_nothrow_copy_constructible< T >::value,
+                "T must be nothrow_move_constructible or nothrow_copy_constructible"
+                );
+
+            static_assert(
+                std::is_nothrow_default_constructible< T >::value,
+                "T must be is_nothrow_default_constructible"
+                );
+
+            BL_CHK_ARG( capacity && capacity < INVALID_INDEX, capacity );
+
+            BL_UNUSED( m_padding );
+
+            m_nodes = cpp::SafeUniquePtr< Node[] >::attach( new Node[ m_capacity ] );
+
+            /*
+             * Initially all nodes are chained in the free nodes stack
+             */
+
+            for( std::size_t i = 0U; i < m_capacity; ++i )
+            {
+                m_nodes[ i ].next.store(
+                    i + 1U < m_capacity ? static_cast< std::uint32_t >( i + 1U ) : INVALID_INDEX,
+                    std::memory_order_relaxed
+                    );
+            }
+
+            m_freeHead.store( makeHead( 0U, 0U ), std::memory_order_release );
+        }
+
+        ~LockFreePool() NOEXCEPT
+        {
+            std::size_t count = 0U;
+
+            for(
+                auto index = getIndex( m_usedHead.load( std::memory_order_acquire ) );
+                INVALID_INDEX != index;
+                index = m_nodes[ index ].next.load( std::memory_order_relaxed )
+                )
+            {
+                ++count;
+            }
+
+            BL_LOG(
+                Logging::trace(),
+                BL_MSG()
+                    << "LockFreePool: destroying lock free pool "
+                    << m_name
+                    << ( m_name.empty() ? "" : " " )
+                    << this
+                    << "; # of cached objects: "
+                    << count
+                    << "; capacity: "
+                    << m_capacity
+                );
+        }
+
+    public:
+
+        auto capacity() const NOEXCEPT -> std::size_t
+        {
+            return m_capacity;
+        }
+
+        T tryGet() NOEXCEPT
+        {
+            const auto node = popNode( m_usedHead );
+
+            if( ! node )
+            {
+                return T();
+            }
+
+            auto value = std::move( node -> value );
+            node -> value = T();
+
+            pushNode( m_freeHead, node );
+
+            checker_t::markAllocated( value );
+
+            return value;
+        }
+
+        void put( SAA_inout T&& value )
+        {
+            checker_t::markFreed( value );
+
+            const auto node = popNode( m_freeHead );
+
+            if( ! node )
+            {
+                /*
+                 * The pool is full - the object is simply dropped and
+                 * it will be destroyed when value goes out of scope
+                 */
+
+                return;
+            }
+
+            node -> value = std::forward< T >( value );
+
+            pushNode( m_usedHead, node );
+        }
+    };
+
     /**
      * @brief class TaggedPool - a tagged pool implementation; it pools objects
      * of type T which grouped by tags of type K and the caller can request objects of
@@ -47,6 +47,15 @@ namespace bl
 
         virtual asio::io_service& aioService() = 0;
 
+        /**
+         * @brief Posts a callback to be executed on one of the thread pool threads
+         *
+         * Normally this is equivalent to aioService().post( callback ), but a thread pool
+         * which uses a work stealing scheduler will queue it on per thread deques instead
+         */
+
+        virtual void post( SAA_in cpp::void_callback_t&& callback ) = 0;
+
         virtual std::exception_ptr lastException() const = 0;
     };
 
@@ -28,11 +28,31 @@
 
 #include <algorithm>
 #include <atomic>
+#include <deque>
 
 namespace bl
 {
     /**
      * @brief class ThreadPoolImpl
+     *
+     * If the work stealing scheduler is enabled then the callbacks posted via post( ... )
+     * don't go through the shared I/O service queue (which is protected by a single lock),
+     * but instead each thread has its own deque of callbacks. The callbacks posted from a
+     * thread pool thread are pushed on the back of its own deque and executed in LIFO order
+     * (to keep the cache warm) while the idle threads steal from the front of the other
+     * threads' deques. The callbacks posted from non thread pool threads are distributed
+     * across the deques in round robin fashion
+     *
+     * When a thread has no callbacks to execute and nothing to steal it blocks in the I/O
+     * service (so it can process the I/O completions) and it is woken up with an empty
+     * handler posted on the I/O service only if there are such idle threads; a busy thread
+     * also runs one ready I/O service handler every IO_POLL_INTERVAL callbacks, so the I/O
+     * completions are not starved under sustained load (if that handler happens to be a
+     * wake up meant for an idle thread it is passed on to the idle threads)
+     *
+     * The work stealing scheduler is used for the general purpose thread pool if it is
+     * requested via AppInitDone (the non-blocking I/O thread pool and the thread pool
+     * shards always use the I/O service directly)
      */
 
     template
@@ -54,9 +74,37 @@ namespace bl
 
         static const std::size_t THREADS_COUNT_DEFAULT;
         static const std::size_t THREADS_COUNT_MAX;
+        static const std::size_t IO_POLL_INTERVAL;
 
     private:
 
+        struct Worker
+        {
+            os::mutex                                       lock;
+            std::deque< cpp::void_callback_t >              callbacks;
+
+            /*
+             * Only accessed by the thread which owns the worker
+             */
+
+            bool                                            polling;
+
+            Worker()
+                :
+                polling( false )
+            {
+            }
+        };
+
+        static void workerCleanupNoop( SAA_in_opt Worker* worker ) NOEXCEPT
+        {
+            /*
+             * The workers are owned by the thread pool and not by the thread
+             */
+
+            BL_UNUSED( worker );
+        }
+
         const os::AbstractPriority                          m_priority;
 
         std::vector< cpp::SafeUniquePtr< os::thread > >     m_threads;
@@ -71,6 +119,14 @@ namespace bl
         eh::eh_callback_t                                   m_ehCB;
         std::exception_ptr                                  m_lastException;
 
+        const bool                                          m_workStealing;
+        std::vector< cpp::SafeUniquePtr< Worker > >         m_workers;
+        std::atomic< std::size_t >                          m_workersCount;
+        std::atomic< std::size_t >                          m_idleCount;
+        std::atomic< std::size_t >                          m_wakeupsPending;
+        std::atomic< std::size_t >                          m_nextWorker;
+        os::thread_specific_ptr< Worker >                   m_currentWorker;
+
     protected:
 
         /**
@@ -106,7 +162,154 @@ namespace bl
             return false;
         }
 
-        void run() NOEXCEPT
+        bool tryPopOrSteal(
+            SAA_in                  const std::size_t                           workerIndex,
+            SAA_out                 cpp::void_callback_t&                       callback
+            )
+        {
+            {
+                auto& worker = *m_workers[ workerIndex ];
+
+                BL_MUTEX_GUARD( worker.lock );
+
+                if( ! worker.callbacks.empty() )
+                {
+                    callback = std::move( worker.callbacks.back() );
+                    worker.callbacks.pop_back();
+
+                    return true;
+                }
+            }
+
+            const auto workersCount = m_workersCount.load( std::memory_order_acquire );
+
+            for( std::size_t i = 1U; i < workersCount; ++i )
+            {
+                auto& victim = *m_workers[ ( workerIndex + i ) % workersCount ];
+
+                BL_MUTEX_GUARD( victim.lock );
+
+                if( ! victim.callbacks.empty() )
+                {
+                    callback = std::move( victim.callbacks.front() );
+                    victim.callbacks.pop_front();
+
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void postWakeup()
+        {
+            m_ioservice -> post(
+                [ this ]() -> void
+                {
+                    const auto* worker = m_currentWorker.get();
+
+                    if( worker && worker -> polling && m_idleCount.load() )
+                    {
+                        /*
+                         * The wake up was consumed by a busy thread which polls the I/O
+                         * service between the callbacks; pass it on to the idle threads
+                         * (the pending wake ups count stays the same)
+                         */
+
+                        postWakeup();
+
+                        return;
+                    }
+
+                    --m_wakeupsPending;
+                }
+                );
+        }
+
+        void runWorkStealing( SAA_in const std::size_t workerIndex )
+        {
+            m_currentWorker.reset( m_workers[ workerIndex ].get() );
+
+            auto& worker = *m_workers[ workerIndex ];
+
+            cpp::void_callback_t callback;
+            std::size_t executedSincePoll = 0U;
+
+            for( ;; )
+            {
+                if( callback || tryPopOrSteal( workerIndex, callback ) )
+                {
+                    auto cb = std::move( callback );
+                    callback.clear();
+
+                    cb();
+
+                    /*
+                     * Run one ready I/O service handler (if any) every IO_POLL_INTERVAL
+                     * callbacks, so the I/O and timer completions are not starved while
+                     * the deques are never empty (i.e. under sustained load), but without
+                     * taking the I/O service lock after every callback
+                     */
+
+                    if( ++executedSincePoll >= IO_POLL_INTERVAL )
+                    {
+                        executedSincePoll = 0U;
+
+                        worker.polling = true;
+
+                        BL_SCOPE_EXIT( worker.polling = false; );
+
+                        m_ioservice -> poll_one();
+                    }
+
+                    continue;
+                }
+
+                executedSincePoll = 0U;
+
+                std::size_t executed;
+
+                {
+                    /*
+                     * Mark the thread as idle *before* checking the deques once
+                     * again, so post( ... ) will either see the thread as idle
+                     * (and wake it up) or we will see the newly posted callback
+                     */
+
+                    ++m_idleCount;
+
+                    BL_SCOPE_EXIT( --m_idleCount; );
+
+                    if( tryPopOrSteal( workerIndex, callback ) )
+                    {
+                        continue;
+                    }
+
+                    executed = m_ioservice -> run_one();
+                }
+
+                if( 0U == executed )
+                {
+                    /*
+                     * The I/O service was stopped or it is out of work (i.e. the
+                     * thread pool is being disposed); let's drain the deques
+                     * before we exit
+                     */
+
+                    while( tryPopOrSteal( workerIndex, callback ) )
+                    {
+                        auto cb = std::move( callback );
+                        callback.clear();
+
+                        cb();
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        void run( SAA_in const std::size_t workerIndex ) NOEXCEPT
         {
             BL_NOEXCEPT_BEGIN()
 
@@ -195,7 +398,15 @@ namespace bl
 
                     guard.unlock();
 
-                    m_ioservice -> run();
+                    if( m_workStealing )
+                    {
+                        runWorkStealing( workerIndex );
+                    }
+                    else
+                    {
+                        m_ioservice -> run();
+                    }
+
                     break;
                 }
                 catch( std::exception& )
@@ -229,7 +440,8 @@ namespace bl
             SAA_in      const os::AbstractPriority          priority,
             SAA_in_opt  const std::size_t                   threadsCount = THREADS_COUNT_DEFAULT,
             SAA_in_opt  const bool                          abortIfUnhandled = false,
-            SAA_in_opt  eh::eh_callback_t&&                 ehCB = eh::eh_callback_t()
+            SAA_in_opt  eh::eh_callback_t&&                 ehCB = eh::eh_callback_t(),
+            SAA_in_opt  const bool                          workStealing = false
             )
             :
             m_priority( priority ),
@@ -237,8 +449,24 @@ namespace bl
             m_shuttingDown( false ),
             m_abortIfUnhandled( abortIfUnhandled ),
             m_ehCB( BL_PARAM_FWD( ehCB ) ),
-            m_lastException( nullptr )
+            m_lastException( nullptr ),
+            m_workStealing( workStealing ),
+            m_workersCount( 0U ),
+            m_idleCount( 0U ),
+            m_wakeupsPending( 0U ),
+            m_nextWorker( 0U ),
+            m_currentWorker( &this_type::workerCleanupNoop )
         {
+            if( m_workStealing )
+            {
+                /*
+                 * The workers vector is never reallocated, so the workers can be
+                 * accessed without a lock for indexes less than m_workersCount
+                 */
+
+                m_workers.reserve( THREADS_COUNT_MAX );
+            }
+
             createThreads( limitThreadCount( threadsCount ) );
         }
 
@@ -286,11 +514,21 @@ namespace bl
             {
                 m_threads.reserve( threadCount );
 
+                if( m_workStealing )
+                {
+                    for( std::size_t i = currentSize; i < threadCount; ++i )
+                    {
+                        m_workers.push_back( cpp::SafeUniquePtr< Worker >::attach( new Worker() ) );
+                    }
+
+                    m_workersCount.store( m_workers.size(), std::memory_order_release );
+                }
+
                 for( std::size_t i = currentSize; i < threadCount; ++i )
                 {
                     m_threads.push_back(
                         cpp::SafeUniquePtr< os::thread >::attach(
-                            new os::thread( cpp::bind( &this_type::run, this ) )
+                            new os::thread( cpp::bind( &this_type::run, this, i ) )
                             )
                         );
                 }
@@ -435,6 +673,68 @@ namespace bl
             return *m_ioservice;
         }
 
+        virtual void post( SAA_in cpp::void_callback_t&& callback ) OVERRIDE
+        {
+            if( ! m_workStealing )
+            {
+                aioService().post( BL_PARAM_FWD( callback ) );
+
+                return;
+            }
+
+            BL_CHK(
+                true,
+                m_shuttingDown,
+                "Thread pool object has been disposed"
+                );
+
+            auto* worker = m_currentWorker.get();
+
+            if( ! worker )
+            {
+                /*
+                 * This is not a thread pool thread - distribute in round robin fashion
+                 */
+
+                const auto workersCount = m_workersCount.load( std::memory_order_acquire );
+
+                BL_ASSERT( workersCount );
+
+                worker = m_workers[ m_nextWorker.fetch_add( 1U, std::memory_order_relaxed ) % workersCount ].get();
+            }
+
+            {
+                BL_MUTEX_GUARD( worker -> lock );
+
+                worker -> callbacks.push_back( BL_PARAM_FWD( callback ) );
+            }
+
+            /*
+             * The fence pairs with the increment of m_idleCount in runWorkStealing( ... ) which
+             * happens before the thread checks the deques for the last time before it blocks
+             */
+
+            std::atomic_thread_fence( std::memory_order_seq_cst );
+
+            /*
+             * If there are idle threads blocked in the I/O service wake up one of them, but
+             * only if there are not enough wake ups pending already (a thread which is woken
+             * up always checks all deques after the wake up handler has executed)
+             */
+
+            auto wakeupsPending = m_wakeupsPending.load();
+
+            while( m_idleCount.load() > wakeupsPending )
+            {
+                if( m_wakeupsPending.compare_exchange_weak( wakeupsPending, wakeupsPending + 1U ) )
+                {
+                    postWakeup();
+
+                    break;
+                }
+            }
+        }
+
         virtual std::exception_ptr lastException() const OVERRIDE
         {
             return m_lastException;
@@ -448,6 +748,7 @@ namespace bl
 
     BL_DEFINE_STATIC_MEMBER( ThreadPoolImplT, const std::size_t, THREADS_COUNT_DEFAULT ) = 32;
     BL_DEFINE_STATIC_MEMBER( ThreadPoolImplT, const std::size_t, THREADS_COUNT_MAX )     = 1024;
+    BL_DEFINE_STATIC_MEMBER( ThreadPoolImplT, const std::size_t, IO_POLL_INTERVAL )      = 16;
 
     typedef om::ObjectImpl< ThreadPoolImplT<> > ThreadPoolImpl;
 
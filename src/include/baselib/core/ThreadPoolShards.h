@@ -0,0 +1,157 @@
+/*
+ * This file is part of the swblocks-baselib library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __BL_THREADPOOLSHARDS_H_
+#define __BL_THREADPOOLSHARDS_H_
+
+#include <baselib/core/ThreadPoolImpl.h>
+#include <baselib/core/ThreadPool.h>
+#include <baselib/core/OS.h>
+#include <baselib/core/ObjModel.h>
+#include <baselib/core/Logging.h>
+#include <baselib/core/BaseIncludes.h>
+
+namespace bl
+{
+    /**
+     * @brief class ThreadPoolShards - a set of single threaded thread pools (shards)
+     *
+     * Each shard has its own I/O service and its thread is pinned to a CPU core (best effort),
+     * so the objects which are bound to a shard (e.g. the sockets of the connections accepted
+     * by a sharded server) have their handlers always executed on the same core and don't
+     * contend on the shared reactor and handler queue of the default I/O thread pool
+     */
+
+    template
+    <
+        typename E = void
+    >
+    class ThreadPoolShardsT : public om::DisposableObjectBase
+    {
+    public:
+
+        typedef ThreadPoolShardsT< E >                                          this_type;
+
+    protected:
+
+        std::vector< om::ObjPtrDisposable< ThreadPool > >                       m_shards;
+
+        ThreadPoolShardsT(
+            SAA_in_opt      const std::size_t                                   shardsCount = 0U,
+            SAA_in_opt      const bool                                          pinThreads = true
+            )
+        {
+            const std::size_t coresCount = std::max< std::size_t >( os::thread::hardware_concurrency(), 1U );
+
+            const std::size_t shardsCountActual = shardsCount ? shardsCount : coresCount;
+
+            m_shards.reserve( shardsCountActual );
+
+            for( std::size_t i = 0U; i < shardsCountActual; ++i )
+            {
+                m_shards.push_back(
+                    om::lockDisposable(
+                        ThreadPoolImpl::createInstance< ThreadPool >(
+                            os::getAbstractPriorityDefault(),
+                            1U /* threadsCount */
+                            )
+                        )
+                    );
+
+                if( pinThreads )
+                {
+                    const std::size_t cpuIndex = i % coresCount;
+
+                    m_shards.back() -> post(
+                        [ i, cpuIndex ]() -> void
+                        {
+                            if( ! os::trySetCurrentThreadAffinity( cpuIndex ) )
+                            {
+                                BL_LOG(
+                                    Logging::debug(),
+                                    BL_MSG()
+                                        << "Cannot pin the thread of shard #"
+                                        << i
+                                        << " to CPU #"
+                                        << cpuIndex
+                                    );
+                            }
+                        }
+                        );
+                }
+            }
+        }
+
+        ~ThreadPoolShardsT() NOEXCEPT
+        {
+            disposeInternal();
+        }
+
+        void disposeInternal() NOEXCEPT
+        {
+            BL_NOEXCEPT_BEGIN()
+
+            for( auto& shard : m_shards )
+            {
+                /*
+                 * Note that ObjPtrDisposable< ... >::reset() disposes the thread pool
+                 */
+
+                shard.reset();
+            }
+
+            BL_NOEXCEPT_END()
+        }
+
+    public:
+
+        auto size() const NOEXCEPT -> std::size_t
+        {
+            return m_shards.size();
+        }
+
+        auto shard( SAA_in const std::size_t shardIndex ) const NOEXCEPT -> const om::ObjPtrDisposable< ThreadPool >&
+        {
+            BL_ASSERT( shardIndex < m_shards.size() );
+
+            return m_shards[ shardIndex ];
+        }
+
+        auto aioService( SAA_in const std::size_t shardIndex ) -> asio::io_service&
+        {
+            const auto& threadPool = shard( shardIndex );
+
+            BL_CHK(
+                false,
+                nullptr != threadPool,
+                BL_MSG()
+                    << "Thread pool shards have been disposed already"
+                );
+
+            return threadPool -> aioService();
+        }
+
+        virtual void dispose() NOEXCEPT OVERRIDE
+        {
+            disposeInternal();
+        }
+    };
+
+    typedef om::ObjectImpl< ThreadPoolShardsT<> > ThreadPoolShards;
+
+} // bl
+
+#endif /* __BL_THREADPOOLSHARDS_H_ */
@@ -28,6 +28,7 @@
 
 #include <cstdint>
 #include <cstdio>
+#include <ctime>
 #include <exception>
 #include <locale>
 #include <iostream>
@@ -917,8 +918,11 @@ namespace bl
 
         /* import names we will use directly from boost::filesystem namespace */
         using boost::filesystem::detail::utf8_codecvt_facet;
+        using boost::filesystem::block_file;
+        using boost::filesystem::character_file;
         using boost::filesystem::directory_entry;
         using boost::filesystem::directory_file;
+        using boost::filesystem::fifo_file;
         using boost::filesystem::file_status;
         using boost::filesystem::file_type;
         using boost::filesystem::perms;
@@ -926,7 +930,9 @@ namespace bl
         using boost::filesystem::reparse_file;
         using boost::filesystem::space_info;
         using boost::filesystem::socket_file;
+        using boost::filesystem::status_error;
         using boost::filesystem::symlink_file;
+        using boost::filesystem::type_unknown;
 
         const perms ExecutableFileMask = perms::owner_exe | perms::group_exe | perms::others_exe;
 
@@ -2135,6 +2141,51 @@ namespace bl
 
     } // fs
 
+    namespace os
+    {
+        /**
+         * @brief Which directory entries os::readDirectory() should call stat on
+         *
+         * The entry type is normally returned by the directory enumeration itself, so
+         * the stat calls are only needed when the caller also needs the permissions,
+         * the size and the last write time of the entries
+         */
+
+        enum DirectoryStatMode : std::uint32_t
+        {
+            DirectoryStatNone           = 0,
+            DirectoryStatRegularFiles   = 1,
+            DirectoryStatAll            = 2,
+        };
+
+        /**
+         * @brief The size and the last write time of a directory entry as returned
+         * by os::readDirectory() - these are only valid if isKnown is true
+         */
+
+        struct DirectoryEntryStat
+        {
+            bool                                                isKnown;
+            std::uint64_t                                       size;
+            std::time_t                                         lastWriteTime;
+        };
+
+        /**
+         * @brief A directory entry as returned by os::readDirectory()
+         *
+         * The symlink status always has the type, but it only has the permissions
+         * if the entry was stat-ed (i.e. if stat.isKnown is true)
+         */
+
+        struct DirectoryEntryInfo
+        {
+            std::string                                         name;
+            fs::file_status                                     symlinkStatus;
+            DirectoryEntryStat                                  stat;
+        };
+
+    } // os
+
 } // bl
 
 namespace std
@@ -44,6 +44,7 @@
 #include <pwd.h>
 #include <grp.h>
 #include <fcntl.h>
+#include <dirent.h>
 #include <sys/resource.h>
 
 #ifdef __linux__
@@ -54,6 +55,13 @@
 
 #include <sys/prctl.h>
 
+/*
+ * This is for ::pthread_setaffinity_np API which is only available on Linux
+ */
+
+#include <pthread.h>
+#include <sched.h>
+
 #endif
 
 #if !defined( BL_DEVENV_VERSION ) || BL_DEVENV_VERSION < 3
@@ -156,6 +164,11 @@ namespace bl
                     GET_PASSWD_BUFFER_LENGTH = 512
                 };
 
+                enum : std::size_t
+                {
+                    READ_DIRECTORY_BUFFER_SIZE = 64 * 1024,
+                };
+
                 static const char*                  g_procSelfExeSymlink;
 
                 class EncapsulatedPidHandle FINAL
@@ -1735,6 +1748,232 @@ namespace bl
                     return numbers::safeCoerceTo< std::uint64_t >( pos );
                 }
 
+                static void fpread(
+                    SAA_in          const stdio_file_ptr&               fileptr,
+                    SAA_in          const std::uint64_t                 offset,
+                    SAA_out_bcount( sizeInBytes ) void*                 buffer,
+                    SAA_in          const std::size_t                   sizeInBytes
+                    )
+                {
+                    detail::stdioChkOffset( offset );
+
+                    const int fd = ::fileno( fileptr.get() );
+
+                    auto* data = static_cast< char* >( buffer );
+                    auto pos = numbers::safeCoerceTo< off_t >( offset );
+                    auto remaining = sizeInBytes;
+
+                    while( remaining )
+                    {
+                        const auto bytesRead = ::pread( fd, data, remaining, pos );
+
+                        if( -1 == bytesRead && EINTR == errno )
+                        {
+                            continue;
+                        }
+
+                        if( -1 == bytesRead )
+                        {
+                            BL_THROW_EC(
+                                eh::error_code( errno, eh::generic_category() ),
+                                BL_MSG()
+                                    << "Cannot read from file"
+                                );
+                        }
+
+                        if( ! bytesRead )
+                        {
+                            BL_THROW_EC(
+                                eh::errc::make_error_code( eh::errc::operation_not_permitted ),
+                                BL_MSG()
+                                    << "Reading past the end of file"
+                                );
+                        }
+
+                        data += bytesRead;
+                        pos += bytesRead;
+                        remaining -= static_cast< std::size_t >( bytesRead );
+                    }
+                }
+
+                static void fpwrite(
+                    SAA_in          const stdio_file_ptr&               fileptr,
+                    SAA_in          const std::uint64_t                 offset,
+                    SAA_in_bcount( sizeInBytes ) const void*            buffer,
+                    SAA_in          const std::size_t                   sizeInBytes
+                    )
+                {
+                    detail::stdioChkOffset( offset );
+
+                    const int fd = ::fileno( fileptr.get() );
+
+                    const auto* data = static_cast< const char* >( buffer );
+                    auto pos = numbers::safeCoerceTo< off_t >( offset );
+                    auto remaining = sizeInBytes;
+
+                    while( remaining )
+                    {
+                        /*
+                         * pwrite can write less than requested (e.g. if interrupted by a signal),
+                         * so we loop until all the data is written
+                         */
+
+                        const auto written = ::pwrite( fd, data, remaining, pos );
+
+                        if( -1 == written && EINTR == errno )
+                        {
+                            continue;
+                        }
+
+                        if( written <= 0 )
+                        {
+                            BL_THROW_EC(
+                                eh::error_code( written ? errno : EIO, eh::generic_category() ),
+                                BL_MSG()
+                                    << "Cannot write to file"
+                                );
+                        }
+
+                        data += written;
+                        pos += written;
+                        remaining -= static_cast< std::size_t >( written );
+                    }
+                }
+
+                static void fpreallocate(
+                    SAA_in          const stdio_file_ptr&               fileptr,
+                    SAA_in          const std::uint64_t                 size
+                    )
+                {
+                    detail::stdioChkOffset( size );
+
+#ifdef __linux__
+                    if( ! size )
+                    {
+                        return;
+                    }
+
+                    const int fd = ::fileno( fileptr.get() );
+
+                    for( ;; )
+                    {
+                        /*
+                         * Note that we call fallocate(2) directly rather than posix_fallocate
+                         * because when the file system does not support preallocation (e.g. NFS
+                         * and some FUSE file systems) glibc emulates the latter by writing
+                         * every block of the file, which doubles the write I/O it was supposed
+                         * to save
+                         */
+
+                        if( 0 == ::fallocate( fd, 0 /* mode */, 0 /* offset */, numbers::safeCoerceTo< off_t >( size ) ) )
+                        {
+                            return;
+                        }
+
+                        const int errorCode = errno;
+
+                        if( EINTR == errorCode )
+                        {
+                            continue;
+                        }
+
+                        if( EOPNOTSUPP == errorCode || ENOSYS == errorCode )
+                        {
+                            /*
+                             * The file system or the kernel does not support preallocation, so
+                             * we just skip it as it is only an optimization
+                             */
+
+                            return;
+                        }
+
+                        BL_THROW_EC(
+                            eh::error_code( errorCode, eh::generic_category() ),
+                            BL_MSG()
+                                << "Cannot preallocate file space of size "
+                                << size
+                            );
+                    }
+#else
+                    /*
+                     * Preallocation is not supported on this platform (e.g. Darwin)
+                     */
+
+                    BL_UNUSED( fileptr );
+#endif
+                }
+
+                static int fsyncNoThrow( SAA_in const int fd ) NOEXCEPT
+                {
+                    for( ;; )
+                    {
+                        if( 0 == ::fsync( fd ) )
+                        {
+                            return 0;
+                        }
+
+                        if( EINTR != errno )
+                        {
+                            return errno;
+                        }
+                    }
+                }
+
+                static void fsync( SAA_in const stdio_file_ptr& fileptr )
+                {
+                    BL_CHK_ERRNO_NM( false, 0 == std::fflush( fileptr.get() ) );
+
+                    const auto rc = fsyncNoThrow( ::fileno( fileptr.get() ) );
+
+                    if( rc )
+                    {
+                        BL_THROW_EC(
+                            eh::error_code( rc, eh::generic_category() ),
+                            BL_MSG()
+                                << "Cannot flush file to disk"
+                            );
+                    }
+                }
+
+                static void fsyncDirectory( SAA_in const fs::path& path )
+                {
+                    const int dirfd = ::open( path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+
+                    if( -1 == dirfd )
+                    {
+                        BL_THROW_EC(
+                            eh::error_code( errno, eh::generic_category() ),
+                            BL_MSG()
+                                << "Cannot open directory "
+                                << fs::normalizePathParameterForPrint( path )
+                            );
+                    }
+
+                    BL_SCOPE_EXIT(
+                        {
+                            ::close( dirfd );
+                        }
+                        );
+
+                    const auto rc = fsyncNoThrow( dirfd );
+
+                    /*
+                     * Some file systems do not support fsync on directories (EINVAL) and
+                     * there is nothing more which can be done in this case
+                     */
+
+                    if( rc && EINVAL != rc )
+                    {
+                        BL_THROW_EC(
+                            eh::error_code( rc, eh::generic_category() ),
+                            BL_MSG()
+                                << "Cannot flush directory "
+                                << fs::normalizePathParameterForPrint( path )
+                                << " to disk"
+                            );
+                    }
+                }
+
                 static void updateFileAttributes(
                     SAA_in          const fs::path&                     path,
                     SAA_in          const FileAttributes                attributes,
@@ -1763,6 +2002,256 @@ namespace bl
                     return FileAttributeNone;
                 }
 
+                static fs::file_type fileTypeFromMode( SAA_in const mode_t mode ) NOEXCEPT
+                {
+                    if( S_ISREG( mode ) )
+                    {
+                        return fs::regular_file;
+                    }
+
+                    if( S_ISDIR( mode ) )
+                    {
+                        return fs::directory_file;
+                    }
+
+                    if( S_ISLNK( mode ) )
+                    {
+                        return fs::symlink_file;
+                    }
+
+                    if( S_ISBLK( mode ) )
+                    {
+                        return fs::block_file;
+                    }
+
+                    if( S_ISCHR( mode ) )
+                    {
+                        return fs::character_file;
+                    }
+
+                    if( S_ISFIFO( mode ) )
+                    {
+                        return fs::fifo_file;
+                    }
+
+                    if( S_ISSOCK( mode ) )
+                    {
+                        return fs::socket_file;
+                    }
+
+                    return fs::type_unknown;
+                }
+
+                static fs::file_type fileTypeFromDirentType( SAA_in const unsigned char type ) NOEXCEPT
+                {
+                    switch( type )
+                    {
+                        default:
+                        case DT_UNKNOWN:    return fs::status_error;
+                        case DT_REG:        return fs::regular_file;
+                        case DT_DIR:        return fs::directory_file;
+                        case DT_LNK:        return fs::symlink_file;
+                        case DT_BLK:        return fs::block_file;
+                        case DT_CHR:        return fs::character_file;
+                        case DT_FIFO:       return fs::fifo_file;
+                        case DT_SOCK:       return fs::socket_file;
+                    }
+                }
+
+                /**
+                 * @brief Adds a single entry returned by getdents64 / readdir and calls
+                 * stat on it (relative to the directory fd) only if it is really needed
+                 *
+                 * Entries which were deleted after they were enumerated are skipped
+                 */
+
+                static void addDirectoryEntry(
+                    SAA_in          const int                                   dirfd,
+                    SAA_in          const char*                                 name,
+                    SAA_in          const unsigned char                         direntType,
+                    SAA_in          const DirectoryStatMode                     statMode,
+                    SAA_inout       std::vector< DirectoryEntryInfo >&          entries
+                    )
+                {
+                    if( '.' == name[ 0 ] && ( '\0' == name[ 1 ] || ( '.' == name[ 1 ] && '\0' == name[ 2 ] ) ) )
+                    {
+                        return;
+                    }
+
+                    auto type = fileTypeFromDirentType( direntType );
+
+                    const bool statNeeded =
+                        fs::status_error == type ||
+                        DirectoryStatAll == statMode ||
+                        ( DirectoryStatRegularFiles == statMode && fs::regular_file == type );
+
+                    DirectoryEntryInfo info;
+
+                    info.name = name;
+                    info.stat.isKnown = false;
+                    info.stat.size = 0U;
+                    info.stat.lastWriteTime = 0;
+
+                    if( statNeeded )
+                    {
+                        struct ::stat fileStatus;
+
+                        if( 0 == ::fstatat( dirfd, name, &fileStatus, AT_SYMLINK_NOFOLLOW ) )
+                        {
+                            const auto permsMask = S_IRWXU | S_IRWXG | S_IRWXO | S_ISUID | S_ISGID | S_ISVTX;
+
+                            type = fileTypeFromMode( fileStatus.st_mode );
+
+                            info.symlinkStatus = fs::file_status(
+                                type,
+                                static_cast< fs::perms >( fileStatus.st_mode & permsMask )
+                                );
+
+                            info.stat.isKnown = true;
+                            info.stat.size = fs::regular_file == type ?
+                                numbers::safeCoerceTo< std::uint64_t >( fileStatus.st_size ) : 0U;
+                            info.stat.lastWriteTime = fileStatus.st_mtime;
+                        }
+                        else
+                        {
+                            if( ENOENT == errno )
+                            {
+                                return;
+                            }
+
+                            /*
+                             * Leave the status unknown (status_error), so the caller
+                             * calling fs::directory_entry::symlink_status() will retry
+                             * the stat call and report the error the usual way
+                             */
+
+                            info.symlinkStatus = fs::file_status( fs::status_error );
+                        }
+                    }
+                    else
+                    {
+                        info.symlinkStatus = fs::file_status( type );
+                    }
+
+                    entries.push_back( std::move( info ) );
+                }
+
+                /**
+                 * @brief Reads all entries of a directory without calling stat on each
+                 * entry (unless statMode requires it)
+                 *
+                 * On Linux it calls getdents64 directly with a large buffer to minimize
+                 * the number of system calls and on other UNIX platforms it uses readdir;
+                 * the entry types come from d_type and the stat calls which are still
+                 * needed are done with fstatat relative to the directory fd, so the
+                 * kernel doesn't have to resolve the full path for each entry
+                 */
+
+                static void readDirectory(
+                    SAA_in          const fs::path&                             path,
+                    SAA_in          const DirectoryStatMode                     statMode,
+                    SAA_inout       std::vector< DirectoryEntryInfo >&          entries,
+                    SAA_out         eh::error_code&                             ec
+                    )
+                {
+                    ec.clear();
+
+                    const int dirfd = ::open( path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+
+                    if( -1 == dirfd )
+                    {
+                        ec = eh::error_code( errno, eh::generic_category() );
+
+                        return;
+                    }
+
+#ifdef __linux__
+                    BL_SCOPE_EXIT(
+                        {
+                            ::close( dirfd );
+                        }
+                        );
+
+                    std::vector< char > buffer( READ_DIRECTORY_BUFFER_SIZE );
+
+                    for( ;; )
+                    {
+                        const auto bytesRead = ::syscall( SYS_getdents64, dirfd, buffer.data(), buffer.size() );
+
+                        if( -1 == bytesRead && EINTR == errno )
+                        {
+                            continue;
+                        }
+
+                        if( -1 == bytesRead )
+                        {
+                            ec = eh::error_code( errno, eh::generic_category() );
+
+                            return;
+                        }
+
+                        if( 0 == bytesRead )
+                        {
+                            break;
+                        }
+
+                        for( long pos = 0; pos < bytesRead; )
+                        {
+                            /*
+                             * The kernel linux_dirent64 layout matches struct dirent64
+                             * from glibc (d_ino, d_off, d_reclen, d_type, d_name)
+                             */
+
+                            const auto* entry = reinterpret_cast< const struct ::dirent64* >( buffer.data() + pos );
+
+                            addDirectoryEntry( dirfd, entry -> d_name, entry -> d_type, statMode, entries );
+
+                            pos += entry -> d_reclen;
+                        }
+                    }
+#else
+                    /*
+                     * ::fdopendir takes ownership of the fd on success
+                     */
+
+                    DIR* dir = ::fdopendir( dirfd );
+
+                    if( nullptr == dir )
+                    {
+                        ec = eh::error_code( errno, eh::generic_category() );
+
+                        ::close( dirfd );
+
+                        return;
+                    }
+
+                    BL_SCOPE_EXIT(
+                        {
+                            ::closedir( dir );
+                        }
+                        );
+
+                    for( ;; )
+                    {
+                        errno = 0;
+
+                        const auto* entry = ::readdir( dir );
+
+                        if( nullptr == entry )
+                        {
+                            if( errno )
+                            {
+                                ec = eh::error_code( errno, eh::generic_category() );
+                            }
+
+                            break;
+                        }
+
+                        addDirectoryEntry( dirfd, entry -> d_name, entry -> d_type, statMode, entries );
+                    }
+#endif
+                }
+
                 static std::time_t getFileCreateTime( SAA_in const fs::path& path )
                 {
                     BL_UNUSED( path );
@@ -2457,6 +2946,34 @@ namespace bl
                     setIoPriority( IO_PRIORITY_WHO_CURRENT_THREAD, priority );
                 }
 
+                /**
+                 * @brief Pins the current thread to the specified CPU (best effort)
+                 *
+                 * Returns false if the affinity can't be set (e.g. the CPU is not available to
+                 * the process or the platform doesn't support it as it is the case on Darwin)
+                 */
+
+                static bool trySetCurrentThreadAffinity( SAA_in const std::size_t cpuIndex ) NOEXCEPT
+                {
+#ifdef __linux__
+                    if( cpuIndex >= CPU_SETSIZE )
+                    {
+                        return false;
+                    }
+
+                    cpu_set_t cpuSet;
+
+                    CPU_ZERO( &cpuSet );
+                    CPU_SET( cpuIndex, &cpuSet );
+
+                    return 0 == ::pthread_setaffinity_np( ::pthread_self(), sizeof( cpuSet ), &cpuSet );
+#else
+                    BL_UNUSED( cpuIndex );
+
+                    return false;
+#endif
+                }
+
                 /**
                  * @brief Turn the process into a daemon - a background service process detached from the console
                  *
@@ -1661,6 +1661,167 @@ namespace bl
                     return pos;
                 }
 
+                static void fpread(
+                    SAA_in          const stdio_file_ptr&               fileptr,
+                    SAA_in          const std::uint64_t                 offset,
+                    SAA_out_bcount( sizeInBytes ) void*                 buffer,
+                    SAA_in          const std::size_t                   sizeInBytes
+                    )
+                {
+                    detail::stdioChkOffset( offset );
+
+                    const auto handle = getOSFileHandle( fileptr );
+
+                    auto* data = static_cast< char* >( buffer );
+                    auto pos = offset;
+                    auto remaining = sizeInBytes;
+
+                    while( remaining )
+                    {
+                        OVERLAPPED overlapped = { 0 };
+
+                        overlapped.Offset = static_cast< DWORD >( pos & 0xFFFFFFFFU );
+                        overlapped.OffsetHigh = static_cast< DWORD >( pos >> 32 );
+
+                        const auto toRead = static_cast< DWORD >( remaining > 0x40000000U ? 0x40000000U : remaining );
+
+                        DWORD bytesRead = 0;
+
+                        if( ! ::ReadFile( handle, data, toRead, &bytesRead, &overlapped ) )
+                        {
+                            const auto lastError = ::GetLastError();
+
+                            /*
+                             * ERROR_HANDLE_EOF is reported as a zero bytes read below
+                             */
+
+                            if( ERROR_HANDLE_EOF != lastError )
+                            {
+                                BL_THROW_EC(
+                                    createSystemErrorCode( ( int ) lastError ),
+                                    BL_MSG()
+                                        << "Cannot read from file"
+                                    );
+                            }
+
+                            bytesRead = 0;
+                        }
+
+                        if( ! bytesRead )
+                        {
+                            BL_THROW_EC(
+                                eh::errc::make_error_code( eh::errc::operation_not_permitted ),
+                                BL_MSG()
+                                    << "Reading past the end of file"
+                                );
+                        }
+
+                        data += bytesRead;
+                        pos += bytesRead;
+                        remaining -= bytesRead;
+                    }
+                }
+
+                static void fpwrite(
+                    SAA_in          const stdio_file_ptr&               fileptr,
+                    SAA_in          const std::uint64_t                 offset,
+                    SAA_in_bcount( sizeInBytes ) const void*            buffer,
+                    SAA_in          const std::size_t                   sizeInBytes
+                    )
+                {
+                    detail::stdioChkOffset( offset );
+
+                    const auto handle = getOSFileHandle( fileptr );
+
+                    const auto* data = static_cast< const char* >( buffer );
+                    auto pos = offset;
+                    auto remaining = sizeInBytes;
+
+                    while( remaining )
+                    {
+                        /*
+                         * WriteFile with an explicit offset in the OVERLAPPED structure is
+                         * the Windows equivalent of pwrite
+                         */
+
+                        OVERLAPPED overlapped = { 0 };
+
+                        overlapped.Offset = static_cast< DWORD >( pos & 0xFFFFFFFFU );
+                        overlapped.OffsetHigh = static_cast< DWORD >( pos >> 32 );
+
+                        /*
+                         * The size of a single write is limited to 1 GB to fit in DWORD
+                         */
+
+                        const auto toWrite = static_cast< DWORD >( remaining > 0x40000000U ? 0x40000000U : remaining );
+
+                        DWORD written = 0;
+
+                        if( ! ::WriteFile( handle, data, toWrite, &written, &overlapped ) || ! written )
+                        {
+                            BL_THROW_EC(
+                                createSystemErrorCode( ( int )::GetLastError() ),
+                                BL_MSG()
+                                    << "Cannot write to file"
+                                );
+                        }
+
+                        data += written;
+                        pos += written;
+                        remaining -= written;
+                    }
+                }
+
+                static void fpreallocate(
+                    SAA_in          const stdio_file_ptr&               fileptr,
+                    SAA_in          const std::uint64_t                 size
+                    )
+                {
+                    detail::stdioChkOffset( size );
+
+                    FILE_ALLOCATION_INFO allocationInfo;
+
+                    allocationInfo.AllocationSize.QuadPart = static_cast< LONGLONG >( size );
+
+                    if( ! ::SetFileInformationByHandle(
+                            getOSFileHandle( fileptr ),
+                            FileAllocationInfo,
+                            &allocationInfo,
+                            sizeof( allocationInfo )
+                            ) )
+                    {
+                        BL_THROW_EC(
+                            createSystemErrorCode( ( int )::GetLastError() ),
+                            BL_MSG()
+                                << "Cannot preallocate file"
+                            );
+                    }
+                }
+
+                static void fsync( SAA_in const stdio_file_ptr& fileptr )
+                {
+                    BL_CHK_ERRNO_NM( false, 0 == std::fflush( fileptr.get() ) );
+
+                    if( ! ::FlushFileBuffers( getOSFileHandle( fileptr ) ) )
+                    {
+                        BL_THROW_EC(
+                            createSystemErrorCode( ( int )::GetLastError() ),
+                            BL_MSG()
+                                << "Cannot flush file to disk"
+                            );
+                    }
+                }
+
+                static void fsyncDirectory( SAA_in const fs::path& path )
+                {
+                    /*
+                     * NTFS journals the directory entries together with the file metadata
+                     * and directories can't be flushed with FlushFileBuffers
+                     */
+
+                    BL_UNUSED( path );
+                }
+
                 static void updateFileAttributes(
                     SAA_in          const fs::path&                     path,
                     SAA_in          const FileAttributes                attributes,
@@ -1708,6 +1869,69 @@ namespace bl
                     }
                 }
 
+                /**
+                 * @brief Reads all entries of a directory
+                 *
+                 * On Windows the directory iterator already returns the entry types
+                 * without extra calls, so this is implemented on top of it and only the
+                 * permissions, the sizes and the last write times need extra calls
+                 */
+
+                static void readDirectory(
+                    SAA_in          const fs::path&                             path,
+                    SAA_in          const DirectoryStatMode                     statMode,
+                    SAA_inout       std::vector< DirectoryEntryInfo >&          entries,
+                    SAA_out         eh::error_code&                             ec
+                    )
+                {
+                    fs::directory_iterator end, it( path, ec );
+
+                    if( ec )
+                    {
+                        return;
+                    }
+
+                    for( ; it != end; it.increment( ec ) )
+                    {
+                        if( ec )
+                        {
+                            return;
+                        }
+
+                        const auto& entry = *it;
+
+                        DirectoryEntryInfo info;
+
+                        info.name = entry.path().filename().string();
+                        info.symlinkStatus = entry.symlink_status();
+                        info.stat.isKnown = false;
+                        info.stat.size = 0U;
+                        info.stat.lastWriteTime = 0;
+
+                        const auto type = info.symlinkStatus.type();
+
+                        const bool statNeeded =
+                            DirectoryStatAll == statMode ||
+                            ( DirectoryStatRegularFiles == statMode && fs::regular_file == type );
+
+                        if( statNeeded )
+                        {
+                            eh::error_code ecStat;
+
+                            info.stat.size = fs::regular_file == type ? fs::file_size( entry.path(), ecStat ) : 0U;
+
+                            if( ! ecStat )
+                            {
+                                info.stat.lastWriteTime = fs::last_write_time( entry.path(), ecStat );
+                            }
+
+                            info.stat.isKnown = ! ecStat;
+                        }
+
+                        entries.push_back( std::move( info ) );
+                    }
+                }
+
                 static FileAttributes getFileAttributes( SAA_in const fs::path& path )
                 {
                     const auto pwzFileName = path.native().c_str();
@@ -3006,6 +3230,26 @@ namespace bl
                     g_currentAbstractPriority = priority;
                 }
 
+                /**
+                 * @brief Pins the current thread to the specified CPU (best effort)
+                 *
+                 * Returns false if the affinity can't be set (e.g. the CPU is not in the current
+                 * processor group or it is not available to the process)
+                 */
+
+                static bool trySetCurrentThreadAffinity( SAA_in const std::size_t cpuIndex ) NOEXCEPT
+                {
+                    if( cpuIndex >= sizeof( DWORD_PTR ) * 8U )
+                    {
+                        return false;
+                    }
+
+                    return 0U != ::SetThreadAffinityMask(
+                        ::GetCurrentThread(),
+                        static_cast< DWORD_PTR >( 1U ) << cpuIndex
+                        );
+                }
+
                 static void daemonize()
                 {
                     /*
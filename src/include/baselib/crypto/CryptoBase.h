@@ -272,6 +272,23 @@ namespace bl
 
                     initNativeSslContext( context -> native_handle() );
 
+                    /*
+                     * The session id context must be set for the TLS sessions to be resumable
+                     * when the client certificates are requested (see the verify_peer mode in
+                     * AsioSslStreamWrapper) or otherwise OpenSSL fails the handshake when the
+                     * client attempts to resume a session
+                     */
+
+                    static const unsigned char sessionIdContext[] = "swblocks-baselib";
+
+                    BL_CHK_CRYPTO_API_NM(
+                        ::SSL_CTX_set_session_id_context(
+                            context -> native_handle(),
+                            sessionIdContext,
+                            sizeof( sessionIdContext ) - 1U
+                            )
+                        );
+
                     context -> use_private_key(
                         asio::const_buffer( privateKeyPem.data(), privateKeyPem.size() ),
                         boost::asio::ssl::context::pem
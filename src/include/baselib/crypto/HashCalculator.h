@@ -239,6 +239,138 @@ namespace bl
 
         typedef HashCalculator< detail::Sha512CalculatorImpl > HashCalculatorDefault;
 
+        /**
+         * @brief class SipHash24 - the SipHash-2-4 keyed 64-bit hash function
+         *
+         * It is much cheaper than the SHA-2 hashes above and with a secret random key it is
+         * resistant to hash flooding, so it is suitable for hashing untrusted keys in hash
+         * tables; however it is not collision resistant in the cryptographic sense, so the
+         * callers must still compare the original keys on lookup
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class SipHash24T
+        {
+            BL_DECLARE_STATIC( SipHash24T )
+
+        public:
+
+            enum : std::size_t
+            {
+                KEY_SIZE = 16U,
+            };
+
+        private:
+
+            static std::uint64_t rotl(
+                SAA_in      const std::uint64_t         value,
+                SAA_in      const unsigned              bits
+                ) NOEXCEPT
+            {
+                return ( value << bits ) | ( value >> ( 64U - bits ) );
+            }
+
+            static std::uint64_t load64( SAA_in const std::uint8_t* data ) NOEXCEPT
+            {
+                std::uint64_t value = 0U;
+
+                for( std::size_t i = 0U; i < 8U; ++i )
+                {
+                    value |= static_cast< std::uint64_t >( data[ i ] ) << ( 8U * i );
+                }
+
+                return value;
+            }
+
+            static void sipRound( SAA_inout std::uint64_t ( &v )[ 4 ] ) NOEXCEPT
+            {
+                v[ 0 ] += v[ 1 ];
+                v[ 1 ] = rotl( v[ 1 ], 13U );
+                v[ 1 ] ^= v[ 0 ];
+                v[ 0 ] = rotl( v[ 0 ], 32U );
+
+                v[ 2 ] += v[ 3 ];
+                v[ 3 ] = rotl( v[ 3 ], 16U );
+                v[ 3 ] ^= v[ 2 ];
+
+                v[ 0 ] += v[ 3 ];
+                v[ 3 ] = rotl( v[ 3 ], 21U );
+                v[ 3 ] ^= v[ 0 ];
+
+                v[ 2 ] += v[ 1 ];
+                v[ 1 ] = rotl( v[ 1 ], 17U );
+                v[ 1 ] ^= v[ 2 ];
+                v[ 2 ] = rotl( v[ 2 ], 32U );
+            }
+
+        public:
+
+            /**
+             * @brief Computes the hash of the data with a key of KEY_SIZE bytes
+             */
+
+            static std::uint64_t hash(
+                SAA_in      const std::uint8_t*         key,
+                SAA_in      const void*                 buffer,
+                SAA_in      const std::size_t           size
+                ) NOEXCEPT
+            {
+                const auto k0 = load64( key );
+                const auto k1 = load64( key + 8U );
+
+                std::uint64_t v[ 4 ] =
+                {
+                    k0 ^ 0x736f6d6570736575ULL,
+                    k1 ^ 0x646f72616e646f6dULL,
+                    k0 ^ 0x6c7967656e657261ULL,
+                    k1 ^ 0x7465646279746573ULL,
+                };
+
+                const auto* data = static_cast< const std::uint8_t* >( buffer );
+                const auto* end = data + ( size & ~std::size_t( 7U ) );
+
+                for( ; data != end; data += 8U )
+                {
+                    const auto m = load64( data );
+
+                    v[ 3 ] ^= m;
+                    sipRound( v );
+                    sipRound( v );
+                    v[ 0 ] ^= m;
+                }
+
+                /*
+                 * The last word holds the remaining bytes and the low byte of the size
+                 * in its most significant byte
+                 */
+
+                auto last = static_cast< std::uint64_t >( size & 0xffU ) << 56U;
+
+                for( std::size_t i = 0U; i < ( size & 7U ); ++i )
+                {
+                    last |= static_cast< std::uint64_t >( data[ i ] ) << ( 8U * i );
+                }
+
+                v[ 3 ] ^= last;
+                sipRound( v );
+                sipRound( v );
+                v[ 0 ] ^= last;
+
+                v[ 2 ] ^= 0xffU;
+                sipRound( v );
+                sipRound( v );
+                sipRound( v );
+                sipRound( v );
+
+                return v[ 0 ] ^ v[ 1 ] ^ v[ 2 ] ^ v[ 3 ];
+            }
+        };
+
+        typedef SipHash24T<> SipHash24;
+
     } // hash
 
 } // bl
@@ -39,14 +39,147 @@ namespace bl
 
         typedef om::ObjectImpl< DataBlockT<> > DataBlock;
 
+        /**
+         * @brief class DataBlocksPool - a pool of data blocks grouped in size classes
+         *
+         * The size classes are powers of two from SIZE_CLASS_MIN to SIZE_CLASS_MAX (which is
+         * the default block capacity) and each size class is a separate lock free pool, so a
+         * small message doesn't have to hold on to a block with the default (1 MB) capacity
+         *
+         * Blocks which capacity is not exactly one of the size classes (e.g. blocks created
+         * with custom capacity or grown beyond SIZE_CLASS_MAX) and external blocks are not
+         * pooled and they are simply dropped when put in the pool
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class DataBlocksPoolT :
+            public om::ObjectDefaultBase
+        {
+            BL_DECLARE_OBJECT_IMPL( DataBlocksPoolT )
+
+        public:
+
+            typedef om::ObjectImpl< DataBlockT< E > >                           block_t;
+            typedef om::ObjectImpl< LockFreePool< om::ObjPtr< block_t > > >     class_pool_t;
+
+            enum : std::size_t
+            {
+                SIZE_CLASS_MIN          = 512U,
+                SIZE_CLASS_MAX          = 1024U * 1024U,
+                SIZE_CLASSES_COUNT      = 12U,
+            };
+
+        private:
+
+            om::ObjPtr< class_pool_t >                                          m_pools[ SIZE_CLASSES_COUNT ];
+
+            static std::size_t sizeClassIndex( SAA_in const std::size_t capacity ) NOEXCEPT
+            {
+                std::size_t classCapacity = SIZE_CLASS_MIN;
+
+                for( std::size_t i = 0U; i < SIZE_CLASSES_COUNT; ++i, classCapacity <<= 1 )
+                {
+                    if( capacity == classCapacity )
+                    {
+                        return i;
+                    }
+                }
+
+                return SIZE_CLASSES_COUNT;
+            }
+
+        protected:
+
+            DataBlocksPoolT( SAA_in_opt const std::string& name = std::string() )
+            {
+                static_assert(
+                    ( std::size_t( SIZE_CLASS_MIN ) << ( SIZE_CLASSES_COUNT - 1U ) ) == SIZE_CLASS_MAX,
+                    "The size classes must cover all powers of two from SIZE_CLASS_MIN to SIZE_CLASS_MAX"
+                    );
+
+                std::size_t classCapacity = SIZE_CLASS_MIN;
+
+                for( std::size_t i = 0U; i < SIZE_CLASSES_COUNT; ++i, classCapacity <<= 1 )
+                {
+                    m_pools[ i ] = class_pool_t::createInstance(
+                        resolveMessage(
+                            BL_MSG()
+                                << name
+                                << ( name.empty() ? "" : " " )
+                                << "[size class "
+                                << classCapacity
+                                << "]"
+                            )
+                        );
+                }
+            }
+
+        public:
+
+            /**
+             * @brief Returns the capacity of the smallest size class which can fit the specified
+             * size or the size itself if it is larger than the largest size class
+             */
+
+            static std::size_t capacityForSize( SAA_in const std::size_t size ) NOEXCEPT
+            {
+                if( size > SIZE_CLASS_MAX )
+                {
+                    return size;
+                }
+
+                std::size_t classCapacity = SIZE_CLASS_MIN;
+
+                while( classCapacity < size )
+                {
+                    classCapacity <<= 1;
+                }
+
+                return classCapacity;
+            }
+
+            static bool isSizeClass( SAA_in const std::size_t capacity ) NOEXCEPT
+            {
+                return sizeClassIndex( capacity ) != SIZE_CLASSES_COUNT;
+            }
+
+            auto tryGet( SAA_in_opt const std::size_t capacity = SIZE_CLASS_MAX ) NOEXCEPT -> om::ObjPtr< block_t >
+            {
+                const auto index = sizeClassIndex( capacity );
+
+                return index == SIZE_CLASSES_COUNT ? nullptr : m_pools[ index ] -> tryGet();
+            }
+
+            void put( SAA_inout om::ObjPtr< block_t >&& block )
+            {
+                if( ! block || block -> isExternal() )
+                {
+                    return;
+                }
+
+                const auto index = sizeClassIndex( block -> capacity() );
+
+                if( index != SIZE_CLASSES_COUNT )
+                {
+                    m_pools[ index ] -> put( BL_PARAM_FWD( block ) );
+                }
+            }
+        };
+
         /*
          * Note: The data blocks are assumed to be pooled and just moved across the pipeline via a shared
          * pool. Otherwise the whole process will be very inefficient as massive amounts of data will have
          * to be privately copied from one processing unit to another. And in addition to that we'll have
          * many heap allocations as well.
+         *
+         * The pool is shared by all processing units and connections, so each size class is a lock free
+         * pool
          */
 
-        typedef om::ObjectImpl< SimplePool< om::ObjPtr< DataBlock > > > datablocks_pool_type;
+        typedef om::ObjectImpl< DataBlocksPoolT<> > datablocks_pool_type;
 
         template
         <
@@ -66,6 +199,8 @@ namespace bl
             static const std::size_t                                            g_BlockCapacityDefault;
 
             cpp::SafeUniquePtr< char[] >                                        m_data;
+            cpp::ScalarTypeIniter< char* >                                      m_buffer;
+            om::ObjPtr< om::Object >                                            m_externalOwner;
             cpp::ScalarTypeIniter< std::size_t >                                m_capacity;
             cpp::ScalarTypeIniter< std::size_t >                                m_size;
             cpp::ScalarTypeIniter< bool >                                       m_freed;
@@ -93,14 +228,44 @@ namespace bl
                 #pragma warning( suppress : 6001 )
                 #endif // _WIN32
                 m_data = cpp::SafeUniquePtr< char[] >::attach( new char[ m_capacity.value() ] );
+                m_buffer = m_data.get();
                 m_size = m_capacity;
             }
 
+            /**
+             * @brief Creates a block which references external memory (e.g. a memory mapped
+             * file region) instead of owning its buffer
+             *
+             * The external owner object is what keeps the memory valid and it is held for as
+             * long as the block is alive. External blocks must not be put in a data blocks
+             * pool as their capacity is the size of the external memory
+             */
+
+            DataBlockT(
+                SAA_in          om::ObjPtr< om::Object >&&                      externalOwner,
+                SAA_in          void*                                           externalData,
+                SAA_in          const std::size_t                               size
+                )
+                :
+                m_buffer( reinterpret_cast< char* >( externalData ) ),
+                m_externalOwner( BL_PARAM_FWD( externalOwner ) ),
+                m_capacity( size ),
+                m_size( size )
+            {
+                BL_ASSERT( m_externalOwner );
+                BL_ASSERT( externalData || ! size );
+            }
+
         public:
 
             typedef char*                                                       iterator;
             typedef const char*                                                 const_iterator;
 
+            bool isExternal() const NOEXCEPT
+            {
+                return nullptr != m_externalOwner;
+            }
+
             auto capacity() const NOEXCEPT -> std::size_t
             {
                 return m_capacity;
@@ -155,29 +320,65 @@ namespace bl
                 m_size = 0U;
             }
 
+            /**
+             * @brief Grows the block so it has at least the requested capacity while preserving
+             * the data, the size and the offset
+             *
+             * The new capacity is rounded up to a size class, so the block remains poolable. Note
+             * that the block buffer is re-allocated, so any pointers obtained via begin() / pv()
+             * prior to the call are invalidated and that is also why write() never grows the block
+             * implicitly (e.g. the buffer can be exposed to Java via a direct byte buffer)
+             */
+
+            void reserve( SAA_in const std::size_t capacity )
+            {
+                if( capacity <= m_capacity )
+                {
+                    return;
+                }
+
+                BL_CHK_T(
+                    true,
+                    isExternal(),
+                    NotSupportedException(),
+                    BL_MSG()
+                        << "Blocks which reference external memory cannot be grown"
+                    );
+
+                const auto newCapacity = capacityForSize( capacity );
+
+                auto newData = cpp::SafeUniquePtr< char[] >::attach( new char[ newCapacity ] );
+
+                std::memcpy( newData.get(), m_buffer.value(), m_size );
+
+                m_data = std::move( newData );
+                m_buffer = m_data.get();
+                m_capacity = newCapacity;
+            }
+
             auto begin() NOEXCEPT -> iterator
             {
-                return m_data.get();
+                return m_buffer.value();
             }
 
             auto end() NOEXCEPT -> iterator
             {
-                return m_data.get() + m_size;
+                return m_buffer.value() + m_size;
             }
 
             auto begin() const NOEXCEPT -> const_iterator
             {
-                return m_data.get();
+                return m_buffer.value();
             }
 
             auto end() const NOEXCEPT -> const_iterator
             {
-                return m_data.get() + m_size;
+                return m_buffer.value() + m_size;
             }
 
             auto pv() const NOEXCEPT -> void*
             {
-                return reinterpret_cast< void* >( m_data.get() );
+                return reinterpret_cast< void* >( m_buffer.value() );
             }
 
             template
@@ -201,7 +402,7 @@ namespace bl
                         << m_capacity
                     );
 
-                std::memcpy( m_data.get() + m_size, &value, sizeof( T ) );
+                std::memcpy( m_buffer.value() + m_size, &value, sizeof( T ) );
                 m_size += sizeof( T );
             }
 
@@ -223,7 +424,7 @@ namespace bl
                         << m_capacity
                     );
 
-                std::memcpy( m_data.get() + m_size, text.c_str(), textSize );
+                std::memcpy( m_buffer.value() + m_size, text.c_str(), textSize );
                 m_size += textSize;
             }
 
@@ -250,7 +451,7 @@ namespace bl
                         << m_size
                     );
 
-                std::memcpy( value, m_data.get() + m_offset1, sizeof( T ) );
+                std::memcpy( value, m_buffer.value() + m_offset1, sizeof( T ) );
                 m_offset1 += sizeof( T );
             }
 
@@ -274,7 +475,7 @@ namespace bl
                         << m_size
                     );
 
-                text -> assign( m_data.get() + m_offset1, textSize );
+                text -> assign( m_buffer.value() + m_offset1, textSize );
                 m_offset1 += textSize;
             }
 
@@ -284,7 +485,7 @@ namespace bl
                 )
                 -> om::ObjPtr< DataBlock >
             {
-                auto newBlock = dataBlocksPool ? dataBlocksPool -> tryGet() : nullptr;
+                auto newBlock = dataBlocksPool ? dataBlocksPool -> tryGet( capacity ) : nullptr;
 
                 if( newBlock )
                 {
@@ -307,19 +508,12 @@ namespace bl
                 )
                 -> om::ObjPtr< DataBlock >
             {
-                auto newBlock = dataBlocksPool ? dataBlocksPool -> tryGet() : nullptr;
-
-                if( ! newBlock )
-                {
-                    newBlock = DataBlock::createInstance( block -> capacity() );
-                }
-                else
-                {
-                    BL_ASSERT( block -> capacity() == newBlock -> capacity() );
+                /*
+                 * The copy is taken from the smallest size class which can fit the data
+                 * (i.e. it can have smaller capacity than the original block)
+                 */
 
-                    newBlock -> setOffset1( 0U );
-                    newBlock -> setSize( 0U );
-                }
+                auto newBlock = getForSize( dataBlocksPool, block -> size() );
 
                 std::memcpy( newBlock -> begin(), block -> begin(), block -> size() );
 
@@ -329,13 +523,35 @@ namespace bl
                 return newBlock;
             }
 
+            /**
+             * @brief Returns a block from the smallest size class which can fit the specified size
+             *
+             * If the size is larger than the largest size class a block with exactly the requested
+             * capacity is allocated (such blocks are not pooled)
+             */
+
+            static auto getForSize(
+                SAA_in_opt      const om::ObjPtr< datablocks_pool_type >&       dataBlocksPool,
+                SAA_in          const std::size_t                               size
+                )
+                -> om::ObjPtr< DataBlock >
+            {
+                return get( dataBlocksPool, capacityForSize( size ) );
+            }
+
+            static std::size_t capacityForSize( SAA_in const std::size_t size ) NOEXCEPT
+            {
+                return datablocks_pool_type::capacityForSize( size );
+            }
+
             static std::size_t defaultCapacity() NOEXCEPT
             {
                 return g_BlockCapacityDefault;
             }
         };
 
-        BL_DEFINE_STATIC_MEMBER( DataBlockT, const std::size_t, g_BlockCapacityDefault ) = 1024 * 1024;
+        BL_DEFINE_STATIC_MEMBER( DataBlockT, const std::size_t, g_BlockCapacityDefault ) =
+            DataBlocksPoolT< TCLASS >::SIZE_CLASS_MAX;
 
     } // data
 
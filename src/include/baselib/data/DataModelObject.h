@@ -19,6 +19,7 @@
 
 #include <baselib/crypto/HashCalculator.h>
 
+#include <baselib/core/JsonStreamReader.h>
 #include <baselib/core/JsonUtils.h>
 #include <baselib/core/ObjModel.h>
 #include <baselib/core/ObjModelDefs.h>
@@ -29,8 +30,270 @@ namespace bl
 {
     namespace dm
     {
+        /**
+         * @brief Writer for the compact binary data model encoding
+         *
+         * Unsigned integers and lengths are encoded as LEB128 varints, signed integers are
+         * zigzag encoded first, doubles are written as 8 bytes in little endian order and
+         * strings are length prefixed
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class BinaryWriterT
+        {
+            BL_NO_COPY_OR_MOVE( BinaryWriterT )
+
+        protected:
+
+            std::string                                         m_buffer;
+
+        public:
+
+            BinaryWriterT()
+            {
+            }
+
+            const std::string& buffer() const NOEXCEPT
+            {
+                return m_buffer;
+            }
+
+            void clear() NOEXCEPT
+            {
+                m_buffer.clear();
+            }
+
+            void writeRaw(
+                SAA_in_bcount( size )       const char*                         data,
+                SAA_in                      const std::size_t                   size
+                )
+            {
+                m_buffer.append( data, size );
+            }
+
+            void writeRaw( SAA_in const std::string& data )
+            {
+                m_buffer.append( data );
+            }
+
+            void writeVarint( SAA_in std::uint64_t value )
+            {
+                while( value >= 0x80U )
+                {
+                    m_buffer.push_back( static_cast< char >( ( value & 0x7FU ) | 0x80U ) );
+                    value >>= 7;
+                }
+
+                m_buffer.push_back( static_cast< char >( value ) );
+            }
+
+            void write( SAA_in const bool value )
+            {
+                m_buffer.push_back( value ? 1 : 0 );
+            }
+
+            void write( SAA_in const int value )
+            {
+                const auto wide = static_cast< std::int64_t >( value );
+
+                writeVarint( ( static_cast< std::uint64_t >( wide ) << 1 ) ^ static_cast< std::uint64_t >( wide >> 63 ) );
+            }
+
+            void write( SAA_in const std::uint64_t value )
+            {
+                writeVarint( value );
+            }
+
+            void write( SAA_in const double value )
+            {
+                static_assert( sizeof( std::uint64_t ) == sizeof( double ), "double must be 64 bit" );
+
+                std::uint64_t bits;
+
+                std::memcpy( &bits, &value, sizeof( bits ) );
+
+                for( std::size_t i = 0U; i < sizeof( bits ); ++i )
+                {
+                    m_buffer.push_back( static_cast< char >( ( bits >> ( 8U * i ) ) & 0xFFU ) );
+                }
+            }
+
+            void write( SAA_in const std::string& value )
+            {
+                writeVarint( value.size() );
+                m_buffer.append( value );
+            }
+        };
+
+        typedef BinaryWriterT<> BinaryWriter;
+
+        /**
+         * @brief Reader for the compact binary data model encoding (see BinaryWriterT)
+         *
+         * The reader does not own the data; malformed or truncated input is reported as
+         * JsonException, so the existing handlers for malformed documents apply unchanged
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class BinaryReaderT
+        {
+        protected:
+
+            cpp::ScalarTypeIniter< const char* >                m_pos;
+            cpp::ScalarTypeIniter< const char* >                m_end;
+
+        public:
+
+            BinaryReaderT()
+            {
+            }
+
+            BinaryReaderT(
+                SAA_in_bcount( size )       const char*                         data,
+                SAA_in                      const std::size_t                   size
+                )
+                :
+                m_pos( data ),
+                m_end( data + size )
+            {
+            }
+
+            bool eof() const NOEXCEPT
+            {
+                return m_pos.value() == m_end.value();
+            }
+
+            std::size_t remaining() const NOEXCEPT
+            {
+                return static_cast< std::size_t >( m_end.value() - m_pos.value() );
+            }
+
+            const char* readRaw( SAA_in const std::size_t size )
+            {
+                BL_CHK_T(
+                    true,
+                    size > remaining(),
+                    JsonException(),
+                    BL_MSG()
+                        << "Binary data model document is truncated"
+                    );
+
+                const auto data = m_pos.value();
+
+                m_pos = data + size;
+
+                return data;
+            }
+
+            std::uint64_t readVarint()
+            {
+                std::uint64_t value = 0U;
+
+                for( std::size_t shift = 0U; ; shift += 7U )
+                {
+                    BL_CHK_T(
+                        true,
+                        shift > 63U,
+                        JsonException(),
+                        BL_MSG()
+                            << "Binary data model document contains an invalid varint"
+                        );
+
+                    const auto byte = static_cast< std::uint8_t >( *readRaw( 1U ) );
+
+                    value |= static_cast< std::uint64_t >( byte & 0x7FU ) << shift;
+
+                    if( 0U == ( byte & 0x80U ) )
+                    {
+                        return value;
+                    }
+                }
+            }
+
+            std::size_t readLength()
+            {
+                const auto length = readVarint();
+
+                BL_CHK_T(
+                    true,
+                    length > remaining(),
+                    JsonException(),
+                    BL_MSG()
+                        << "Binary data model document is truncated"
+                    );
+
+                return static_cast< std::size_t >( length );
+            }
+
+            BinaryReaderT readNested()
+            {
+                const auto size = readLength();
+
+                return BinaryReaderT( readRaw( size ), size );
+            }
+
+            void read( SAA_out bool& value )
+            {
+                value = 0 != *readRaw( 1U );
+            }
+
+            void read( SAA_out int& value )
+            {
+                const auto encoded = readVarint();
+
+                value = static_cast< int >(
+                    static_cast< std::int64_t >( encoded >> 1 ) ^ -static_cast< std::int64_t >( encoded & 1U )
+                    );
+            }
+
+            void read( SAA_out std::uint64_t& value )
+            {
+                value = readVarint();
+            }
+
+            void read( SAA_out double& value )
+            {
+                const auto data = readRaw( sizeof( std::uint64_t ) );
+
+                std::uint64_t bits = 0U;
+
+                for( std::size_t i = 0U; i < sizeof( bits ); ++i )
+                {
+                    bits |= static_cast< std::uint64_t >( static_cast< std::uint8_t >( data[ i ] ) ) << ( 8U * i );
+                }
+
+                std::memcpy( &value, &bits, sizeof( value ) );
+            }
+
+            void read( SAA_out std::string& value )
+            {
+                const auto size = readLength();
+
+                value.assign( readRaw( size ), size );
+            }
+        };
+
+        typedef BinaryReaderT<> BinaryReader;
+
         /**
          * @brief The base class for all serialization context objects
+         *
+         * In binary mode an object is encoded as the number of declared properties, a bitmap
+         * of which of them are present, the length prefixed values of the present properties
+         * in declaration order and finally the unmapped properties as name / JSON text pairs.
+         * Properties can only be appended to a data model object to keep the binary encoding
+         * compatible (unknown trailing properties are skipped when decoding)
+         *
+         * In streaming mode the JSON text is read with json::StreamReader: the context only
+         * indexes the properties of the object (as views into the text) and each property
+         * is then read directly into the typed member, so no json::Value tree is built
+         * except for custom and unmapped properties
          */
 
         template
@@ -43,23 +306,191 @@ namespace bl
 
         protected:
 
+            struct StreamProperty
+            {
+                json::StreamReader::view_t                      key;
+                json::StreamReader::view_t                      value;
+                bool                                            processed;
+            };
+
             const bool                                          m_isSerialization;
+            const bool                                          m_isBinary;
+            const bool                                          m_isStreaming;
             json::Object                                        m_serializationDoc;
             json::Object                                        m_deserializationDoc;
             cpp::ScalarTypeIniter< bool >                       m_detectUnknownProperties;
             std::unordered_set< std::string >                   m_processedProperties;
 
+            BinaryWriter                                        m_binaryBody;
+            BinaryWriter                                        m_binaryField;
+            std::vector< bool >                                 m_binaryPresence;
+            std::vector< std::pair< const char*, std::size_t > > m_binaryFields;
+            cpp::ScalarTypeIniter< std::size_t >                m_binaryFieldIndex;
+
+            std::vector< StreamProperty >                       m_streamProperties;
+            std::deque< std::string >                           m_streamDecodedKeys;
+            cpp::ScalarTypeIniter< bool >                       m_ignoreUnmapped;
+
+            static bool streamKeyLess(
+                SAA_in              const json::StreamReader::view_t&               key1,
+                SAA_in              const json::StreamReader::view_t&               key2
+                ) NOEXCEPT
+            {
+                const auto rc = std::memcmp( key1.first, key2.first, std::min( key1.second, key2.second ) );
+
+                return rc < 0 || ( 0 == rc && key1.second < key2.second );
+            }
+
+            void loadStreamDoc( SAA_inout json::StreamReader& reader )
+            {
+                reader.readObject(
+                    [ & ]( SAA_in const json::StreamReader::view_t& key ) -> void
+                    {
+                        auto stableKey = key;
+
+                        if( ! reader.isInputView( key ) )
+                        {
+                            /*
+                             * The key had escape sequences and it was decoded into a scratch buffer
+                             */
+
+                            m_streamDecodedKeys.emplace_back( key.first, key.second );
+
+                            const auto& decoded = m_streamDecodedKeys.back();
+
+                            stableKey = json::StreamReader::view_t( decoded.data(), decoded.size() );
+                        }
+
+                        StreamProperty property;
+
+                        property.key = stableKey;
+                        property.value = reader.captureValue();
+                        property.processed = false;
+
+                        m_streamProperties.push_back( property );
+                    }
+                    );
+
+                std::sort(
+                    m_streamProperties.begin(),
+                    m_streamProperties.end(),
+                    []( SAA_in const StreamProperty& property1, SAA_in const StreamProperty& property2 ) -> bool
+                    {
+                        return streamKeyLess( property1.key, property2.key );
+                    }
+                    );
+
+                for( std::size_t i = 1U; i < m_streamProperties.size(); ++i )
+                {
+                    if( ! streamKeyLess( m_streamProperties[ i - 1U ].key, m_streamProperties[ i ].key ) )
+                    {
+                        throwDuplicateProperty(
+                            std::string( m_streamProperties[ i ].key.first, m_streamProperties[ i ].key.second )
+                            );
+                    }
+                }
+            }
+
+            void loadBinaryDoc( SAA_inout BinaryReader& reader )
+            {
+                const auto fieldsCount = reader.readVarint();
+
+                BL_CHK_T(
+                    true,
+                    fieldsCount > reader.remaining() * 8U,
+                    JsonException(),
+                    BL_MSG()
+                        << "Binary data model document is truncated"
+                    );
+
+                const auto bitmap = reader.readRaw( static_cast< std::size_t >( ( fieldsCount + 7U ) / 8U ) );
+
+                m_binaryFields.resize( static_cast< std::size_t >( fieldsCount ) );
+
+                for( std::size_t i = 0U; i < m_binaryFields.size(); ++i )
+                {
+                    if( bitmap[ i / 8U ] & ( 1 << ( i % 8U ) ) )
+                    {
+                        const auto size = reader.readLength();
+
+                        m_binaryFields[ i ] = std::make_pair( reader.readRaw( size ), size );
+                    }
+                }
+
+                /*
+                 * The unmapped properties are loaded into the deserialization document, so they are
+                 * picked up by the regular unmapped properties handling
+                 */
+
+                const auto unmappedCount = reader.readVarint();
+
+                for( std::uint64_t i = 0U; i < unmappedCount; ++i )
+                {
+                    std::string name;
+                    std::string jsonText;
+
+                    reader.read( name );
+                    reader.read( jsonText );
+
+                    m_deserializationDoc.emplace( std::move( name ), json::readFromString( jsonText ) );
+                }
+
+                BL_CHK_T(
+                    false,
+                    reader.eof(),
+                    JsonException(),
+                    BL_MSG()
+                        << "Binary data model document has unexpected trailing data"
+                    );
+            }
+
         public:
 
-            SerializationContextBaseT( SAA_in_opt const bool isSerialization = true ) NOEXCEPT
+            SerializationContextBaseT(
+                SAA_in_opt          const bool                                      isSerialization = true,
+                SAA_in_opt          const bool                                      isBinary = false
+                ) NOEXCEPT
+                :
+                m_isSerialization( isSerialization ),
+                m_isBinary( isBinary ),
+                m_isStreaming( false )
+            {
+                BL_ASSERT( isSerialization || ! isBinary );
+            }
+
+            /**
+             * @brief Creates a streaming deserialization context; it consumes the next value from
+             * the reader (which must be an object) and the JSON text must outlive the context
+             */
+
+            SerializationContextBaseT( SAA_inout json::StreamReader& reader )
                 :
-                m_isSerialization( isSerialization )
+                m_isSerialization( false ),
+                m_isBinary( false ),
+                m_isStreaming( true )
             {
+                loadStreamDoc( reader );
+            }
+
+            /**
+             * @brief Creates a binary deserialization context; the data referenced by the reader
+             * must outlive the context
+             */
+
+            SerializationContextBaseT( SAA_in BinaryReader reader )
+                :
+                m_isSerialization( false ),
+                m_isBinary( true ),
+                m_isStreaming( false )
+            {
+                loadBinaryDoc( reader );
             }
 
             SerializationContextBaseT( SAA_in const std::string& json )
                 :
-                m_isSerialization( false )
+                m_isSerialization( false ),
+                m_isBinary( false ),
+                m_isStreaming( false )
             {
                 auto rootValue = json::readFromString( json );
 
@@ -68,7 +499,9 @@ namespace bl
 
             SerializationContextBaseT( SAA_inout json::Object&& object ) NOEXCEPT
                 :
-                m_isSerialization( false )
+                m_isSerialization( false ),
+                m_isBinary( false ),
+                m_isStreaming( false )
             {
                 m_deserializationDoc.swap( object );
             }
@@ -88,6 +521,223 @@ namespace bl
                 return m_isSerialization;
             }
 
+            bool isBinary() const NOEXCEPT
+            {
+                return m_isBinary;
+            }
+
+            bool isStreaming() const NOEXCEPT
+            {
+                return m_isStreaming;
+            }
+
+            bool ignoreUnmapped() const NOEXCEPT
+            {
+                return m_ignoreUnmapped;
+            }
+
+            /**
+             * @brief If set the unmapped properties are skipped rather than loaded into
+             * DataModelObject::unmapped() (streaming deserialization only)
+             */
+
+            void ignoreUnmapped( SAA_in const bool ignoreUnmapped ) NOEXCEPT
+            {
+                m_ignoreUnmapped = ignoreUnmapped;
+            }
+
+            static void throwDuplicateProperty( SAA_in const std::string& name )
+            {
+                BL_THROW_USER(
+                    BL_MSG()
+                        << "Duplicate entry encountered for property with name '"
+                        << name
+                        << "' while parsing a JSON object"
+                    );
+            }
+
+            /**
+             * @brief Finds a property and positions the reader on its value; returns false if
+             * the property is not present (streaming deserialization only)
+             *
+             * If skipNull=true a property with null value is treated as not present and it is
+             * not marked as processed either (i.e. it is loaded as unmapped), which matches
+             * how the json::Value based path handles the null string properties
+             */
+
+            bool streamFindProperty(
+                SAA_in              const char*                                     name,
+                SAA_out             json::StreamReader&                             reader,
+                SAA_in_opt          const bool                                      skipNull = false
+                )
+            {
+                BL_ASSERT( isStreaming() );
+
+                const auto key = json::StreamReader::view_t( name, std::strlen( name ) );
+
+                const auto pos = std::lower_bound(
+                    m_streamProperties.begin(),
+                    m_streamProperties.end(),
+                    key,
+                    []( SAA_in const StreamProperty& property, SAA_in const json::StreamReader::view_t& value ) -> bool
+                    {
+                        return streamKeyLess( property.key, value );
+                    }
+                    );
+
+                if( pos == m_streamProperties.end() || streamKeyLess( key, pos -> key ) )
+                {
+                    return false;
+                }
+
+                reader = json::StreamReader( pos -> value );
+
+                if( skipNull && reader.tryReadNull() )
+                {
+                    return false;
+                }
+
+                pos -> processed = true;
+
+                return true;
+            }
+
+            bool streamFindProperty(
+                SAA_in              const std::string&                              name,
+                SAA_out             json::StreamReader&                             reader,
+                SAA_in_opt          const bool                                      skipNull = false
+                )
+            {
+                return streamFindProperty( name.c_str(), reader, skipNull );
+            }
+
+            /**
+             * @brief Loads the properties which were not processed into the unmapped object
+             * (streaming deserialization only)
+             */
+
+            void streamLoadUnmapped( SAA_inout json::Object& unmapped )
+            {
+                BL_ASSERT( isStreaming() );
+
+                for( const auto& property : m_streamProperties )
+                {
+                    if( property.processed )
+                    {
+                        continue;
+                    }
+
+                    std::string name( property.key.first, property.key.second );
+
+                    BL_CHK_USER(
+                        true,
+                        detectUnknownProperties(),
+                        BL_MSG()
+                            << "Unrecognized property '"
+                            << name
+                            << "' found while parsing JSON document. Check if the property is typed correctly."
+                        );
+
+                    if( m_ignoreUnmapped )
+                    {
+                        continue;
+                    }
+
+                    json::StreamReader reader( property.value );
+
+                    reader.read( unmapped[ name ] );
+                }
+            }
+
+            /**
+             * @brief Starts writing the value of the next property (binary serialization only)
+             */
+
+            BinaryWriter& binaryBeginField() NOEXCEPT
+            {
+                BL_ASSERT( isSerialization() && isBinary() );
+
+                m_binaryField.clear();
+
+                return m_binaryField;
+            }
+
+            void binaryEndField()
+            {
+                BL_ASSERT( isSerialization() && isBinary() );
+
+                m_binaryPresence.push_back( true );
+
+                m_binaryBody.writeVarint( m_binaryField.buffer().size() );
+                m_binaryBody.writeRaw( m_binaryField.buffer() );
+            }
+
+            void binarySkipField()
+            {
+                BL_ASSERT( isSerialization() && isBinary() );
+
+                m_binaryPresence.push_back( false );
+            }
+
+            /**
+             * @brief Moves to the next property and returns false if it is not present in
+             * the document (binary deserialization only)
+             */
+
+            bool binaryNextField( SAA_out BinaryReader& reader )
+            {
+                BL_ASSERT( ! isSerialization() && isBinary() );
+
+                const std::size_t index = m_binaryFieldIndex;
+
+                ++m_binaryFieldIndex.lvalue();
+
+                if( index >= m_binaryFields.size() || ! m_binaryFields[ index ].first )
+                {
+                    return false;
+                }
+
+                reader = BinaryReader( m_binaryFields[ index ].first, m_binaryFields[ index ].second );
+
+                return true;
+            }
+
+            /**
+             * @brief Returns the binary encoding of the serialized object
+             */
+
+            std::string binaryDoc() const
+            {
+                BL_ASSERT( isSerialization() && isBinary() );
+
+                BinaryWriter writer;
+
+                writer.writeVarint( m_binaryPresence.size() );
+
+                std::string bitmap( ( m_binaryPresence.size() + 7U ) / 8U, '\0' );
+
+                for( std::size_t i = 0U; i < m_binaryPresence.size(); ++i )
+                {
+                    if( m_binaryPresence[ i ] )
+                    {
+                        bitmap[ i / 8U ] |= static_cast< char >( 1 << ( i % 8U ) );
+                    }
+                }
+
+                writer.writeRaw( bitmap );
+                writer.writeRaw( m_binaryBody.buffer() );
+
+                writer.writeVarint( m_serializationDoc.size() );
+
+                for( const auto& pair : m_serializationDoc )
+                {
+                    writer.write( pair.first );
+                    writer.write( json::saveToString( pair.second ) );
+                }
+
+                return writer.buffer();
+            }
+
             json::Object& serializationDoc() NOEXCEPT
             {
                 BL_ASSERT( isSerialization() );
@@ -313,6 +963,85 @@ namespace bl
                 return getObjectHash< T >( dataObject, salt, true /* canonicalize */ );
             }
 
+            /*************************************************************************************************
+             * Binary encoding helpers
+             */
+
+            /**
+             * @brief The first byte of a top level binary document; it can never start a JSON text,
+             * so the two encodings can be told apart by looking at the first byte
+             */
+
+            static char binaryFormatMarker() NOEXCEPT
+            {
+                return static_cast< char >( 0xB1 );
+            }
+
+            static bool isBinaryDoc(
+                SAA_in_bcount( size )       const char*                         data,
+                SAA_in                      const std::size_t                   size
+                ) NOEXCEPT
+            {
+                return size && binaryFormatMarker() == data[ 0 ];
+            }
+
+            template
+            <
+                typename T
+            >
+            static auto getBinaryString(
+                SAA_in              const om::ObjPtr< T >&                          dataObject,
+                SAA_in_opt          const bool                                      canonicalize = false
+                )
+                -> std::string
+            {
+                SerializationContextBase context( true /* isSerialization */, true /* isBinary */ );
+
+                dataObject -> serializeProperties( context, canonicalize );
+
+                std::string result( 1U, binaryFormatMarker() );
+
+                result.append( context.binaryDoc() );
+
+                return result;
+            }
+
+            template
+            <
+                typename T
+            >
+            static auto loadFromBinary(
+                SAA_in_bcount( size )       const char*                         data,
+                SAA_in                      const std::size_t                   size
+                )
+                -> om::ObjPtr< T >
+            {
+                BL_CHK_T(
+                    false,
+                    isBinaryDoc( data, size ),
+                    JsonException(),
+                    BL_MSG()
+                        << "Data is not a binary data model document"
+                    );
+
+                SerializationContextBase context( BinaryReader( data + 1U, size - 1U ) );
+
+                auto dataObject = T::template createInstance();
+
+                dataObject -> serializeProperties( context );
+
+                return dataObject;
+            }
+
+            template
+            <
+                typename T
+            >
+            static auto loadFromBinary( SAA_in const std::string& data ) -> om::ObjPtr< T >
+            {
+                return loadFromBinary< T >( data.data(), data.size() );
+            }
+
             /*************************************************************************************************
              * Deserialize helpers
              */
@@ -350,13 +1079,44 @@ namespace bl
                 return loadFromJsonObject< T >( jsonValue.get_obj() );
             }
 
+            /**
+             * @brief Loads the object directly from the JSON text (without building a json::Value
+             * tree); if ignoreUnmapped is set the unmapped properties are skipped
+             */
+
+            template
+            <
+                typename T
+            >
+            static auto loadFromJsonText(
+                SAA_in_bcount( size )       const char*                         data,
+                SAA_in                      const std::size_t                   size,
+                SAA_in_opt                  const bool                          ignoreUnmapped = false
+                )
+                -> om::ObjPtr< T >
+            {
+                json::StreamReader reader( data, size );
+
+                SerializationContextBase context( reader );
+
+                reader.requireEof();
+
+                context.ignoreUnmapped( ignoreUnmapped );
+
+                auto dataObject = T::template createInstance();
+
+                dataObject -> serializeProperties( context );
+
+                return dataObject;
+            }
+
             template
             <
                 typename T
             >
             static auto loadFromJsonText( SAA_in const std::string& jsonText ) -> om::ObjPtr< T >
             {
-                return loadFromJsonValue< T >( json::readFromString( jsonText ) );
+                return loadFromJsonText< T >( jsonText.data(), jsonText.size() );
             }
 
             template
@@ -39,6 +39,18 @@
 #define BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_DESERIALIZE( context, obj ) \
     BL_DM_SERIALIZATION_CONTEXT_IMPL context( obj ) \
 
+#undef BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_SERIALIZE_BINARY
+#define BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_SERIALIZE_BINARY( context ) \
+    BL_DM_SERIALIZATION_CONTEXT_IMPL context( true /* isSerialization */, true /* isBinary */ ) \
+
+#undef BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_DESERIALIZE_BINARY
+#define BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_DESERIALIZE_BINARY( context, reader ) \
+    BL_DM_SERIALIZATION_CONTEXT_IMPL context( reader ) \
+
+#undef BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_DESERIALIZE_STREAM
+#define BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_DESERIALIZE_STREAM( context, reader ) \
+    BL_DM_SERIALIZATION_CONTEXT_IMPL context( reader ) \
+
 #undef BL_DM_SERIALIZATION_CONTEXT_IMPL_DESERIALIZE_SETNAME
 #define BL_DM_SERIALIZATION_CONTEXT_IMPL_DESERIALIZE_SETNAME( obj, value ) \
     do { } while( false )
@@ -199,6 +211,64 @@ template \
             m_ ## name ## IsSet = false; \
         } \
     } \
+    void name ## SerializeBinary( \
+        SAA_inout       BL_DM_SERIALIZATION_CONTEXT_IMPL&               context, \
+        SAA_in          const bool                                      canonicalize \
+        ) \
+    { \
+        if( canonicalize || m_ ## name ## IsSet ) \
+        { \
+            context.binaryBeginField().write( name() ); \
+            context.binaryEndField(); \
+        } \
+        else \
+        { \
+            if( isRequired ) \
+            { \
+                BL_DM_THROW_REQUIRED_PROPERTY_NOT_SET( name, "saving" ) \
+            } \
+            \
+            context.binarySkipField(); \
+        } \
+    } \
+    void name ## DeserializeBinary( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::dm::BinaryReader reader; \
+        \
+        if( context.binaryNextField( reader ) ) \
+        { \
+            reader.read( m_ ## name.lvalue() ); \
+            m_ ## name ## IsSet = true; \
+        } \
+        else \
+        { \
+            if( isRequired ) \
+            { \
+                BL_DM_THROW_REQUIRED_PROPERTY_NOT_SET( name, "loading" ) \
+            } \
+            \
+            m_ ## name ## IsSet = false; \
+        } \
+    } \
+    void name ## DeserializeStream( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::json::StreamReader reader; \
+        \
+        if( context.streamFindProperty( jsonProp, reader ) ) \
+        { \
+            reader.read( m_ ## name.lvalue() ); \
+            m_ ## name ## IsSet = true; \
+        } \
+        else \
+        { \
+            if( isRequired ) \
+            { \
+                BL_DM_THROW_REQUIRED_PROPERTY_NOT_SET( name, "loading" ) \
+            } \
+            \
+            m_ ## name ## IsSet = false; \
+        } \
+    } \
 
 /*
  * BL_DM_DECLARE_BOOL_* macros
@@ -301,6 +371,26 @@ template \
         } \
         \
     } \
+    void name ## SerializeBinary( \
+        SAA_inout       BL_DM_SERIALIZATION_CONTEXT_IMPL&               context, \
+        SAA_in          const bool                                      canonicalize \
+        ) \
+    { \
+        if( canonicalize || ( ! name().empty() ) ) \
+        { \
+            context.binaryBeginField().write( name() ); \
+            context.binaryEndField(); \
+        } \
+        else \
+        { \
+            if( isRequired ) \
+            { \
+                BL_DM_THROW_REQUIRED_PROPERTY_NOT_SET( name, "saving" ) \
+            } \
+            \
+            context.binarySkipField(); \
+        } \
+    } \
 
 #define BL_DM_DECLARE_STRING_PROPERTY_DESERIALIZE( name, jsonProp, isRequired ) \
     private: \
@@ -325,6 +415,34 @@ template \
             BL_DM_THROW_REQUIRED_PROPERTY_NOT_SET( name, "loading" ) \
         } \
     } \
+    void name ## DeserializeBinary( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::dm::BinaryReader reader; \
+        \
+        if( context.binaryNextField( reader ) ) \
+        { \
+            reader.read( m_ ## name ); \
+        } \
+        \
+        if( isRequired && name().empty() ) \
+        { \
+            BL_DM_THROW_REQUIRED_PROPERTY_NOT_SET( name, "loading" ) \
+        } \
+    } \
+    void name ## DeserializeStream( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::json::StreamReader reader; \
+        \
+        if( context.streamFindProperty( jsonProp, reader, true /* skipNull */ ) ) \
+        { \
+            reader.read( m_ ## name ); \
+        } \
+        \
+        if( isRequired && name().empty() ) \
+        { \
+            BL_DM_THROW_REQUIRED_PROPERTY_NOT_SET( name, "loading" ) \
+        } \
+    } \
 
 #define BL_DM_DECLARE_STRING_PROPERTY_RO( name ) \
     BL_DM_DECLARE_PROPERTY_STRING_RO_IMPL( name ) \
@@ -409,6 +527,82 @@ template \
         \
         context.addProcessedProperty( #jsonProp ); \
     } \
+    void name ## SerializeBinary( \
+        SAA_inout       BL_DM_SERIALIZATION_CONTEXT_IMPL&               context, \
+        SAA_in          const bool                                      canonicalize \
+        ) \
+    { \
+        if( false == canonicalize && m_ ## name.size() == 0 ) \
+        { \
+            context.binarySkipField(); \
+            return; \
+        } \
+        \
+        auto& writer = context.binaryBeginField(); \
+        \
+        writer.writeVarint( m_ ## name.size() ); \
+        \
+        for( const auto& item : m_ ## name ) \
+        { \
+            writer.write( item ); \
+        } \
+        \
+        context.binaryEndField(); \
+    } \
+    void name ## DeserializeBinary( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::dm::BinaryReader reader; \
+        \
+        if( ! context.binaryNextField( reader ) ) \
+        { \
+            return; \
+        } \
+        \
+        containerType < item_type > temp; \
+        \
+        const auto count = reader.readVarint(); \
+        \
+        for( std::uint64_t i = 0U; i < count; ++i ) \
+        { \
+            item_type item; \
+            reader.read( item ); \
+            temp.inserter( std::move( item ) ); \
+        } \
+        \
+        m_ ##name .swap( temp ); \
+    } \
+    void name ## DeserializeStream( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::json::StreamReader reader; \
+        \
+        if( ! context.streamFindProperty( #jsonProp, reader ) ) \
+        { \
+            return; \
+        } \
+        \
+        containerType < item_type > temp; \
+        \
+        reader.readArray( \
+            [ & ]() -> void \
+            { \
+                if( ! std::is_same< item_type, std::string >::value && \
+                    reader.peekType() == bl::json::ValueType::str_type ) \
+                { \
+                    std::string itemValue; \
+                    reader.read( itemValue ); \
+                    temp.inserter( bl::utils::lexical_cast< item_type >( itemValue ) ); \
+                } \
+                else \
+                { \
+                    item_type item; \
+                    reader.read( item ); \
+                    temp.inserter( std::move( item ) ); \
+                } \
+            } \
+            ); \
+        \
+        m_ ##name .swap( temp ); \
+    } \
     \
     public: \
     const containerType < item_type >& name() const NOEXCEPT \
@@ -469,6 +663,44 @@ template \
         \
         context.addProcessedProperty( #name ); \
     } \
+    void name ## SerializeBinary( \
+        SAA_inout       BL_DM_SERIALIZATION_CONTEXT_IMPL&               context, \
+        SAA_in          const bool                                      canonicalize \
+        ) \
+    { \
+        if( canonicalize || ! m_ ## name.is_null() ) \
+        { \
+            context.binaryBeginField().write( bl::json::saveToString( m_ ## name ) ); \
+            context.binaryEndField(); \
+        } \
+        else \
+        { \
+            context.binarySkipField(); \
+        } \
+    } \
+    void name ## DeserializeBinary( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::dm::BinaryReader reader; \
+        \
+        if( ! context.binaryNextField( reader ) ) \
+        { \
+            return; \
+        } \
+        \
+        std::string jsonText; \
+        reader.read( jsonText ); \
+        \
+        m_ ## name = bl::json::readFromString( jsonText ); \
+    } \
+    void name ## DeserializeStream( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::json::StreamReader reader; \
+        \
+        if( context.streamFindProperty( #name, reader ) ) \
+        { \
+            reader.read( m_ ## name ); \
+        } \
+    } \
     \
     public: \
     const bl::json::Value& name() const NOEXCEPT \
@@ -544,6 +776,66 @@ template \
         \
         context.addProcessedProperty( #jsonProp ); \
     } \
+    void name ## SerializeBinary( \
+        SAA_inout       BL_DM_SERIALIZATION_CONTEXT_IMPL&               context, \
+        SAA_in          const bool                                      canonicalize \
+        ) \
+    { \
+        if( canonicalize || m_ ## name ) \
+        { \
+            BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_SERIALIZE_BINARY( tempContext ); \
+            if( m_ ## name ) \
+            { \
+                m_ ## name -> invokeSerialize; \
+            } \
+            \
+            context.binaryBeginField().writeRaw( tempContext.binaryDoc() ); \
+            context.binaryEndField(); \
+        } \
+        else \
+        { \
+            context.binarySkipField(); \
+        } \
+    } \
+    void name ## DeserializeBinary( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::dm::BinaryReader reader; \
+        \
+        if( ! context.binaryNextField( reader ) ) \
+        { \
+            return; \
+        } \
+        \
+        auto ptr = type::createInstance(); \
+        \
+        BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_DESERIALIZE_BINARY( tempContext, reader ); \
+        \
+        tempContext.detectUnknownProperties( context.detectUnknownProperties() ); \
+        \
+        ptr -> serializeProperties( tempContext ); \
+        \
+        m_ ##name .swap( ptr ); \
+    } \
+    void name ## DeserializeStream( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::json::StreamReader reader; \
+        \
+        if( ! context.streamFindProperty( #jsonProp, reader ) ) \
+        { \
+            return; \
+        } \
+        \
+        auto ptr = type::createInstance(); \
+        \
+        BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_DESERIALIZE_STREAM( tempContext, reader ); \
+        \
+        tempContext.detectUnknownProperties( context.detectUnknownProperties() ); \
+        tempContext.ignoreUnmapped( context.ignoreUnmapped() ); \
+        \
+        ptr -> serializeProperties( tempContext ); \
+        \
+        m_ ##name .swap( ptr ); \
+    } \
     \
     public: \
     const bl::om::ObjPtr< type >& name() const NOEXCEPT \
@@ -627,6 +919,83 @@ template \
         \
         context.addProcessedProperty( #jsonProp ); \
     } \
+    void name ## SerializeBinary( \
+        SAA_inout       BL_DM_SERIALIZATION_CONTEXT_IMPL&               context, \
+        SAA_in          const bool                                      canonicalize \
+        ) \
+    { \
+        if( false == canonicalize && m_ ## name.size() == 0 ) \
+        { \
+            context.binarySkipField(); \
+            return; \
+        } \
+        \
+        auto& writer = context.binaryBeginField(); \
+        \
+        writer.writeVarint( m_ ## name.size() ); \
+        \
+        for( const auto& item : m_ ## name ) \
+        { \
+            BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_SERIALIZE_BINARY( tempContext ); \
+            item -> serializeProperties( tempContext ); \
+            writer.write( tempContext.binaryDoc() ); \
+        } \
+        \
+        context.binaryEndField(); \
+    } \
+    void name ## DeserializeBinary( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::dm::BinaryReader reader; \
+        \
+        if( ! context.binaryNextField( reader ) ) \
+        { \
+            return; \
+        } \
+        \
+        std::vector< bl::om::ObjPtr< type > > temp; \
+        \
+        const auto count = reader.readVarint(); \
+        \
+        for( std::uint64_t i = 0U; i < count; ++i ) \
+        { \
+            BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_DESERIALIZE_BINARY( tempContext, reader.readNested() ); \
+            \
+            tempContext.detectUnknownProperties( context.detectUnknownProperties() ); \
+            \
+            auto obj = type::createInstance(); \
+            obj -> serializeProperties( tempContext ); \
+            temp.push_back( std::move( obj ) ); \
+        } \
+        \
+        m_ ## name.swap( temp ); \
+    } \
+    void name ## DeserializeStream( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::json::StreamReader reader; \
+        \
+        if( ! context.streamFindProperty( #jsonProp, reader ) ) \
+        { \
+            return; \
+        } \
+        \
+        std::vector< bl::om::ObjPtr< type > > temp; \
+        \
+        reader.readArray( \
+            [ & ]() -> void \
+            { \
+                BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_DESERIALIZE_STREAM( tempContext, reader ); \
+                \
+                tempContext.detectUnknownProperties( context.detectUnknownProperties() ); \
+                tempContext.ignoreUnmapped( context.ignoreUnmapped() ); \
+                \
+                auto obj = type::createInstance(); \
+                obj -> serializeProperties( tempContext ); \
+                temp.push_back( std::move( obj ) ); \
+            } \
+            ); \
+        \
+        m_ ## name.swap( temp ); \
+    } \
     \
     public: \
     const std::vector< bl::om::ObjPtr< type > >& name() const NOEXCEPT \
@@ -701,6 +1070,95 @@ template \
         \
         context.addProcessedProperty( #nameArg ); \
     } \
+    void nameArg ## SerializeBinary( \
+        SAA_inout       BL_DM_SERIALIZATION_CONTEXT_IMPL&               context, \
+        SAA_in          const bool                                      canonicalize \
+        ) \
+    { \
+        if( false == canonicalize && m_ ## nameArg .size() == 0 ) \
+        { \
+            context.binarySkipField(); \
+            return; \
+        } \
+        \
+        auto& writer = context.binaryBeginField(); \
+        \
+        writer.writeVarint( m_ ## nameArg .size() ); \
+        \
+        for( const auto& pair : m_ ## nameArg ) \
+        { \
+            BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_SERIALIZE_BINARY( tempContext ); \
+            pair.second -> serializeProperties( tempContext ); \
+            writer.write( pair.first ); \
+            writer.write( tempContext.binaryDoc() ); \
+        } \
+        \
+        context.binaryEndField(); \
+    } \
+    void nameArg ## DeserializeBinary( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::dm::BinaryReader reader; \
+        \
+        if( ! context.binaryNextField( reader ) ) \
+        { \
+            return; \
+        } \
+        \
+        std::map< std::string, bl::om::ObjPtr< type > > temp; \
+        \
+        const auto count = reader.readVarint(); \
+        \
+        for( std::uint64_t i = 0U; i < count; ++i ) \
+        { \
+            std::string key; \
+            reader.read( key ); \
+            \
+            BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_DESERIALIZE_BINARY( tempContext, reader.readNested() ); \
+            \
+            tempContext.detectUnknownProperties( context.detectUnknownProperties() ); \
+            \
+            auto obj = type::createInstance(); \
+            obj -> serializeProperties( tempContext ); \
+            BL_DM_SERIALIZATION_CONTEXT_IMPL_DESERIALIZE_SETNAME( obj, key ); \
+            temp.emplace( std::move( key ), std::move( obj ) ); \
+        } \
+        \
+        m_ ##nameArg .swap( temp ); \
+    } \
+    void nameArg ## DeserializeStream( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::json::StreamReader reader; \
+        \
+        if( ! context.streamFindProperty( #nameArg, reader ) ) \
+        { \
+            return; \
+        } \
+        \
+        std::map< std::string, bl::om::ObjPtr< type > > temp; \
+        \
+        reader.readObject( \
+            [ & ]( SAA_in const bl::json::StreamReader::view_t& keyView ) -> void \
+            { \
+                std::string key( keyView.first, keyView.second ); \
+                \
+                BL_DM_SERIALIZATION_CONTEXT_IMPL_DECL_DESERIALIZE_STREAM( tempContext, reader ); \
+                \
+                tempContext.detectUnknownProperties( context.detectUnknownProperties() ); \
+                tempContext.ignoreUnmapped( context.ignoreUnmapped() ); \
+                \
+                auto obj = type::createInstance(); \
+                obj -> serializeProperties( tempContext ); \
+                BL_DM_SERIALIZATION_CONTEXT_IMPL_DESERIALIZE_SETNAME( obj, key ); \
+                \
+                if( ! temp.emplace( key, std::move( obj ) ).second ) \
+                { \
+                    context.throwDuplicateProperty( key ); \
+                } \
+            } \
+            ); \
+        \
+        m_ ##nameArg .swap( temp ); \
+    } \
     \
     public: \
     const std::map< std::string, bl::om::ObjPtr< type > >& nameArg() const NOEXCEPT \
@@ -763,6 +1221,78 @@ template \
         \
         context.addProcessedProperty( #name ); \
     }\
+    void name ## SerializeBinary( \
+        SAA_inout       BL_DM_SERIALIZATION_CONTEXT_IMPL&               context, \
+        SAA_in          const bool                                      canonicalize \
+        ) \
+    { \
+        if( false == canonicalize && m_ ## name .size() == 0 ) \
+        { \
+            context.binarySkipField(); \
+            return; \
+        } \
+        \
+        auto& writer = context.binaryBeginField(); \
+        \
+        writer.writeVarint( m_ ## name .size() ); \
+        \
+        for( const auto& pair : m_ ## name ) \
+        { \
+            writer.write( pair.first ); \
+            writer.write( pair.second ); \
+        } \
+        \
+        context.binaryEndField(); \
+    } \
+    void name ## DeserializeBinary( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::dm::BinaryReader reader; \
+        \
+        if( ! context.binaryNextField( reader ) ) \
+        { \
+            return; \
+        } \
+        \
+        std::map< std::string, type > temp; \
+        \
+        const auto count = reader.readVarint(); \
+        \
+        for( std::uint64_t i = 0U; i < count; ++i ) \
+        { \
+            std::string key; \
+            reader.read( key ); \
+            reader.read( temp[ key ] ); \
+        } \
+        \
+        m_ ## name .swap( temp ); \
+    } \
+    void name ## DeserializeStream( SAA_inout BL_DM_SERIALIZATION_CONTEXT_IMPL& context ) \
+    { \
+        bl::json::StreamReader reader; \
+        \
+        if( ! context.streamFindProperty( #name, reader ) ) \
+        { \
+            return; \
+        } \
+        \
+        std::map< std::string, type > temp; \
+        \
+        reader.readObject( \
+            [ & ]( SAA_in const bl::json::StreamReader::view_t& keyView ) -> void \
+            { \
+                const auto pair = temp.emplace( std::string( keyView.first, keyView.second ), type() ); \
+                \
+                if( ! pair.second ) \
+                { \
+                    context.throwDuplicateProperty( pair.first -> first ); \
+                } \
+                \
+                reader.read( pair.first -> second ); \
+            } \
+            ); \
+        \
+        m_ ## name .swap( temp ); \
+    } \
     \
     public: \
     const std::map< std::string, type >& name() const NOEXCEPT \
@@ -793,13 +1323,31 @@ template \
 #define BL_DM_IMPL_PROPERTY( name ) \
     if( context.isSerialization() ) \
     { \
-        name ## Serialize( context.serializationDoc(), canonicalize ); \
+        if( context.isBinary() ) \
+        { \
+            name ## SerializeBinary( context, canonicalize ); \
+        } \
+        else \
+        { \
+            name ## Serialize( context.serializationDoc(), canonicalize ); \
+        } \
     } \
     else \
     { \
         try \
         { \
-            name ## Deserialize( context.deserializationDoc(), context ); \
+            if( context.isBinary() ) \
+            { \
+                name ## DeserializeBinary( context ); \
+            } \
+            else if( context.isStreaming() ) \
+            { \
+                name ## DeserializeStream( context ); \
+            } \
+            else \
+            { \
+                name ## Deserialize( context.deserializationDoc(), context ); \
+            } \
         } \
         catch( std::runtime_error& e ) \
         { \
@@ -841,7 +1389,14 @@ template \
                 } \
             } \
             \
-            if( ! context.isSerialization() ) \
+            if( ! context.isSerialization() && context.isStreaming() ) \
+            { \
+                m_unmapped.clear(); \
+                \
+                context.streamLoadUnmapped( m_unmapped ); \
+            } \
+            \
+            if( ! context.isSerialization() && ! context.isStreaming() ) \
             { \
                 m_unmapped.clear(); \
                 \
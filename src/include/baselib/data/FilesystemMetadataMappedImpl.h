@@ -0,0 +1,1262 @@
+/*
+ * This file is part of the swblocks-baselib library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __BL_FILESYSTEMMETADATAMAPPEDIMPL_H_
+#define __BL_FILESYSTEMMETADATAMAPPEDIMPL_H_
+
+#include <baselib/data/FilesystemMetadata.h>
+
+#include <baselib/core/UuidIteratorImpl.h>
+#include <baselib/core/FsUtils.h>
+#include <baselib/core/OS.h>
+#include <baselib/core/ObjModel.h>
+#include <baselib/core/ObjModelDefs.h>
+#include <baselib/core/BaseIncludes.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace bl
+{
+    namespace data
+    {
+        namespace detail
+        {
+            /**
+             * @brief class MappedStoreWriter - appends records to a store file through a write
+             * buffer using positional writes only, so the records which were already appended
+             * can still be updated and read back in place
+             *
+             * Records are never split between the buffer and the file since the buffer is
+             * flushed before a record which doesn't fit is appended
+             */
+
+            template
+            <
+                typename E = void
+            >
+            class MappedStoreWriterT
+            {
+                BL_NO_COPY_OR_MOVE( MappedStoreWriterT )
+
+            public:
+
+                enum : std::size_t
+                {
+                    BUFFER_SIZE = 256U * 1024U,
+                };
+
+            protected:
+
+                os::stdio_file_ptr                                  m_file;
+                std::uint64_t                                       m_flushedSize;
+                std::vector< char >                                 m_buffer;
+
+            public:
+
+                MappedStoreWriterT( SAA_in const fs::path& path )
+                    :
+                    m_file( os::fopen( path, "w+b" ) ),
+                    m_flushedSize( 0U )
+                {
+                    m_buffer.reserve( BUFFER_SIZE );
+                }
+
+                std::uint64_t size() const NOEXCEPT
+                {
+                    return m_flushedSize + m_buffer.size();
+                }
+
+                std::uint64_t append(
+                    SAA_in_bcount( size )   const void*                 data,
+                    SAA_in                  const std::size_t           size
+                    )
+                {
+                    if( m_buffer.size() + size > BUFFER_SIZE )
+                    {
+                        flush();
+                    }
+
+                    const auto offset = this -> size();
+
+                    if( size >= BUFFER_SIZE )
+                    {
+                        os::fpwrite( m_file, offset, data, size );
+
+                        m_flushedSize += size;
+
+                        return offset;
+                    }
+
+                    const auto* bytes = static_cast< const char* >( data );
+
+                    m_buffer.insert( m_buffer.end(), bytes, bytes + size );
+
+                    return offset;
+                }
+
+                void update(
+                    SAA_in                  const std::uint64_t         offset,
+                    SAA_in_bcount( size )   const void*                 data,
+                    SAA_in                  const std::size_t           size
+                    )
+                {
+                    BL_ASSERT( offset + size <= this -> size() );
+
+                    if( offset >= m_flushedSize )
+                    {
+                        std::memcpy( m_buffer.data() + ( offset - m_flushedSize ), data, size );
+                    }
+                    else
+                    {
+                        BL_ASSERT( offset + size <= m_flushedSize );
+
+                        os::fpwrite( m_file, offset, data, size );
+                    }
+                }
+
+                void read(
+                    SAA_in                  const std::uint64_t         offset,
+                    SAA_out_bcount( size )  void*                       data,
+                    SAA_in                  const std::size_t           size
+                    )
+                {
+                    BL_ASSERT( offset + size <= this -> size() );
+
+                    if( offset >= m_flushedSize )
+                    {
+                        std::memcpy( data, m_buffer.data() + ( offset - m_flushedSize ), size );
+                    }
+                    else
+                    {
+                        BL_ASSERT( offset + size <= m_flushedSize );
+
+                        os::fpread( m_file, offset, data, size );
+                    }
+                }
+
+                void flush()
+                {
+                    if( m_buffer.empty() )
+                    {
+                        return;
+                    }
+
+                    os::fpwrite( m_file, m_flushedSize, m_buffer.data(), m_buffer.size() );
+
+                    m_flushedSize += m_buffer.size();
+                    m_buffer.clear();
+                }
+
+                /**
+                 * @brief Flushes the buffer and closes the file after its data is made durable
+                 * (fsync), so it can be relied upon once the store is finalized
+                 */
+
+                void close()
+                {
+                    flush();
+
+                    os::fsync( m_file );
+
+                    m_file.reset();
+                }
+            };
+
+            typedef MappedStoreWriterT<> MappedStoreWriter;
+
+            /**
+             * @brief class MappedStoreFile - a read-only or a read-write mapping of a whole
+             * store file (empty files are not mapped since they can't be)
+             */
+
+            template
+            <
+                typename E = void
+            >
+            class MappedStoreFileT
+            {
+                BL_NO_COPY_OR_MOVE( MappedStoreFileT )
+
+            protected:
+
+                cpp::SafeUniquePtr< os::ipc::file_mapping >         m_mapping;
+                os::ipc::mapped_region                              m_region;
+                std::uint64_t                                       m_size;
+
+            public:
+
+                MappedStoreFileT()
+                    :
+                    m_size( 0U )
+                {
+                }
+
+                void map(
+                    SAA_in                  const fs::path&             path,
+                    SAA_in                  const bool                  writable
+                    )
+                {
+                    unmap();
+
+                    m_size = fs::file_size( path );
+
+                    if( ! m_size )
+                    {
+                        return;
+                    }
+
+                    const auto mode = writable ? os::ipc::read_write : os::ipc::read_only;
+
+                    m_mapping = cpp::SafeUniquePtr< os::ipc::file_mapping >::attach(
+                        new os::ipc::file_mapping( path.string().c_str(), mode )
+                        );
+
+                    os::ipc::mapped_region region( *m_mapping, mode );
+
+                    m_region.swap( region );
+                }
+
+                void unmap() NOEXCEPT
+                {
+                    os::ipc::mapped_region region;
+
+                    m_region.swap( region );
+                    m_mapping.reset();
+                    m_size = 0U;
+                }
+
+                void flush()
+                {
+                    if( m_size )
+                    {
+                        BL_CHK(
+                            false,
+                            m_region.flush(),
+                            BL_MSG()
+                                << "Cannot flush a memory mapped file"
+                            );
+                    }
+                }
+
+                std::uint64_t size() const NOEXCEPT
+                {
+                    return m_size;
+                }
+
+                template
+                <
+                    typename T
+                >
+                T* data() const NOEXCEPT
+                {
+                    return static_cast< T* >( m_region.get_address() );
+                }
+            };
+
+            typedef MappedStoreFileT<> MappedStoreFile;
+
+        } // detail
+
+        /**
+         * @brief class FilesystemMetadataMappedImpl - an on-disk implementation of the filesystem
+         * metadata which is written while the entries and the chunks are being created and then
+         * it is memory mapped for reading, so its memory usage is bounded for arbitrary large
+         * packages and it can be reopened after a restart once it has been finalized
+         *
+         * The store is a directory with the following files:
+         *
+         * entries.dat / chunks.dat - the fixed size attribute records of the entries and the chunks
+         * entry-ids.dat / chunk-ids.dat - the id columns of the entries and the chunks in the order
+         *      they were created (these are iterated directly by queryAllEntries / queryAllChunks)
+         * strings.dat - the strings heap; the parent paths are interned, so each entry only stores
+         *      its own file name and a reference to the (shared) path of its parent directory
+         * index.dat - created by finalize() and contains the ids of the entries and the chunks sorted
+         *      for binary search and the chunk ids grouped by entry, so queryChunks() returns a slice
+         *
+         * The index is built in a temporary file which is renamed when it is complete and all the
+         * store files have been synced to disk, so a store is finalized if and only if index.dat
+         * exists
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class FilesystemMetadataMappedImplT :
+            public FilesystemMetadata,
+            public FilesystemMetadataRO,
+            public FilesystemMetadataWO
+        {
+            BL_DECLARE_OBJECT_IMPL( FilesystemMetadataMappedImplT )
+
+            BL_QITBL_BEGIN()
+                BL_QITBL_ENTRY( FilesystemMetadataRO )
+                BL_QITBL_ENTRY( FilesystemMetadataWO )
+            BL_QITBL_END( FilesystemMetadataRO )
+
+        public:
+
+            typedef FilesystemMetadata::EntryInfo               EntryInfo;
+            typedef FilesystemMetadata::ChunkInfo               ChunkInfo;
+
+            enum OpenMode
+            {
+                CreateNew,
+                OpenExisting,
+            };
+
+        protected:
+
+            typedef detail::MappedStoreWriter                   MappedStoreWriter;
+            typedef detail::MappedStoreFile                     MappedStoreFile;
+
+            enum : std::uint64_t
+            {
+                INDEX_MAGIC = 0x31444d5346424c42ULL, /* "BLBFSMD1" */
+            };
+
+            enum : std::uint32_t
+            {
+                INDEX_VERSION = 1U,
+            };
+
+            struct StringRef
+            {
+                std::uint64_t                                   offset;
+                std::uint32_t                                   size;
+                std::uint32_t                                   isSet;
+            };
+
+            struct EntryRecord
+            {
+                std::uint64_t                                   size;
+                std::int64_t                                    timeCreated;
+                std::int64_t                                    lastModified;
+                std::uint64_t                                   firstChunk;
+                std::uint64_t                                   chunksCount;
+                std::uint32_t                                   type;
+                std::uint32_t                                   flags;
+                std::uint32_t                                   checksum;
+                std::uint32_t                                   isChecksumSet;
+                StringRef                                       parentPath;
+                StringRef                                       fileName;
+                StringRef                                       targetPath;
+                StringRef                                       sourcePath;
+                StringRef                                       hash;
+            };
+
+            struct ChunkRecord
+            {
+                std::uint64_t                                   pos;
+                std::uint64_t                                   entryIndex;
+                std::uint32_t                                   size;
+                std::uint32_t                                   checksum;
+                std::uint32_t                                   isChunkDuplicate;
+                std::uint32_t                                   reserved;
+                StringRef                                       hash;
+            };
+
+            struct IndexRecord
+            {
+                uuid_t                                          id;
+                std::uint64_t                                   index;
+
+                bool operator <( SAA_in const IndexRecord& other ) const NOEXCEPT
+                {
+                    return id < other.id;
+                }
+            };
+
+            struct IndexHeader
+            {
+                std::uint64_t                                   magic;
+                std::uint32_t                                   version;
+                std::uint32_t                                   reserved;
+                std::uint64_t                                   entriesCount;
+                std::uint64_t                                   chunksCount;
+            };
+
+            static_assert(
+                std::is_standard_layout< EntryRecord >::value && 0U == sizeof( EntryRecord ) % 8U,
+                "EntryRecord must be a standard layout type of size multiple of 8"
+                );
+
+            static_assert(
+                std::is_standard_layout< ChunkRecord >::value && 0U == sizeof( ChunkRecord ) % 8U,
+                "ChunkRecord must be a standard layout type of size multiple of 8"
+                );
+
+            static_assert(
+                sizeof( uuid_t ) == 16U && 0U == sizeof( IndexRecord ) % 8U,
+                "IndexRecord must be of size multiple of 8"
+                );
+
+            const fs::path                                      m_storePath;
+
+            cpp::ScalarTypeIniter< bool >                       m_locked;
+            os::mutex                                           m_lock;
+
+            /*
+             * The state used while the metadata is being written
+             */
+
+            cpp::SafeUniquePtr< MappedStoreWriter >             m_entries;
+            cpp::SafeUniquePtr< MappedStoreWriter >             m_chunks;
+            cpp::SafeUniquePtr< MappedStoreWriter >             m_entryIds;
+            cpp::SafeUniquePtr< MappedStoreWriter >             m_chunkIds;
+            cpp::SafeUniquePtr< MappedStoreWriter >             m_strings;
+
+            std::unordered_map< uuid_t, std::uint64_t >         m_entryIndexes;
+            std::unordered_map< std::string, StringRef >        m_parentPaths;
+            std::unordered_multimap< std::size_t, std::uint64_t > m_fileNameHashes;
+
+            /*
+             * The mapped files used after the metadata has been finalized
+             */
+
+            MappedStoreFile                                     m_entriesMapped;
+            MappedStoreFile                                     m_chunksMapped;
+            MappedStoreFile                                     m_entryIdsMapped;
+            MappedStoreFile                                     m_chunkIdsMapped;
+            MappedStoreFile                                     m_stringsMapped;
+            MappedStoreFile                                     m_indexMapped;
+
+            std::uint64_t                                       m_entriesCount;
+            std::uint64_t                                       m_chunksCount;
+            const IndexRecord*                                  m_entriesIndex;
+            const IndexRecord*                                  m_chunksIndex;
+            const uuid_t*                                       m_chunksByEntry;
+
+            FilesystemMetadataMappedImplT(
+                SAA_in              const fs::path&                             storePath,
+                SAA_in_opt          const OpenMode                              mode = CreateNew
+                )
+                :
+                m_storePath( storePath ),
+                m_entriesCount( 0U ),
+                m_chunksCount( 0U ),
+                m_entriesIndex( nullptr ),
+                m_chunksIndex( nullptr ),
+                m_chunksByEntry( nullptr )
+            {
+                if( OpenExisting == mode )
+                {
+                    openMapped();
+
+                    return;
+                }
+
+                fs::safeMkdirs( m_storePath );
+                fs::safeRemoveIfExists( m_storePath / "index.dat" );
+
+                m_entries = createWriter( "entries.dat" );
+                m_chunks = createWriter( "chunks.dat" );
+                m_entryIds = createWriter( "entry-ids.dat" );
+                m_chunkIds = createWriter( "chunk-ids.dat" );
+                m_strings = createWriter( "strings.dat" );
+            }
+
+            cpp::SafeUniquePtr< MappedStoreWriter > createWriter( SAA_in const char* fileName )
+            {
+                return cpp::SafeUniquePtr< MappedStoreWriter >::attach(
+                    new MappedStoreWriter( m_storePath / fileName )
+                    );
+            }
+
+            om::ObjPtr< om::Object > selfRef() NOEXCEPT
+            {
+                return om::copy( static_cast< om::Object* >( static_cast< FilesystemMetadataRO* >( this ) ) );
+            }
+
+            void chkLocked()
+            {
+                BL_CHK(
+                    false,
+                    m_locked,
+                    BL_MSG()
+                        << "Using the FilesystemMetadataRO interface is only allowed on immutable object"
+                    );
+            }
+
+            void chkUnlocked()
+            {
+                BL_CHK(
+                    true,
+                    m_locked,
+                    BL_MSG()
+                        << "Using the FilesystemMetadataWO interface is only allowed on mutable object"
+                    );
+            }
+
+            /*
+             * Helpers used while the metadata is being written
+             */
+
+            StringRef appendString( SAA_in const std::string& value )
+            {
+                StringRef ref;
+
+                ref.offset = m_strings -> append( value.data(), value.size() );
+                ref.size = numbers::safeCoerceTo< std::uint32_t >( value.size() );
+                ref.isSet = 1U;
+
+                return ref;
+            }
+
+            static StringRef emptyString() NOEXCEPT
+            {
+                StringRef ref;
+
+                ref.offset = 0U;
+                ref.size = 0U;
+                ref.isSet = 0U;
+
+                return ref;
+            }
+
+            StringRef appendPath( SAA_in const om::ObjPtrCopyable< bo::path >& path )
+            {
+                return path ? appendString( path -> value().string() ) : emptyString();
+            }
+
+            StringRef internParentPath( SAA_in const std::string& parentPath )
+            {
+                const auto pos = m_parentPaths.find( parentPath );
+
+                if( pos != m_parentPaths.end() )
+                {
+                    return pos -> second;
+                }
+
+                const auto ref = appendString( parentPath );
+
+                m_parentPaths.emplace( parentPath, ref );
+
+                return ref;
+            }
+
+            std::string readWrittenString( SAA_in const StringRef& ref )
+            {
+                std::string value( ref.size, '\0' );
+
+                if( ref.size )
+                {
+                    m_strings -> read( ref.offset, &value[ 0 ], ref.size );
+                }
+
+                return value;
+            }
+
+            std::uint64_t getWrittenEntryIndex( SAA_in const uuid_t& entryId )
+            {
+                const auto pos = m_entryIndexes.find( entryId );
+
+                BL_CHK(
+                    false,
+                    pos != m_entryIndexes.end(),
+                    BL_MSG()
+                        << "Invalid entry id '"
+                        << uuids::uuid2string( entryId )
+                        << "'"
+                    );
+
+                return pos -> second;
+            }
+
+            template
+            <
+                typename T
+            >
+            void updateEntryField(
+                SAA_in              const std::uint64_t                         entryIndex,
+                SAA_in              const std::size_t                           fieldOffset,
+                SAA_in              const T&                                    value
+                )
+            {
+                m_entries -> update( entryIndex * sizeof( EntryRecord ) + fieldOffset, &value, sizeof( value ) );
+            }
+
+            /*
+             * Helpers used after the metadata has been finalized
+             */
+
+            void openMapped()
+            {
+                m_indexMapped.map( m_storePath / "index.dat", false /* writable */ );
+
+                BL_CHK(
+                    false,
+                    m_indexMapped.size() >= sizeof( IndexHeader ),
+                    BL_MSG()
+                        << "Filesystem metadata store index "
+                        << fs::normalizePathParameterForPrint( m_storePath / "index.dat" )
+                        << " is invalid"
+                    );
+
+                const auto& header = *m_indexMapped.data< const IndexHeader >();
+
+                m_entriesCount = header.entriesCount;
+                m_chunksCount = header.chunksCount;
+
+                const auto expectedIndexSize =
+                    sizeof( IndexHeader ) +
+                    ( m_entriesCount + m_chunksCount ) * sizeof( IndexRecord ) +
+                    m_chunksCount * sizeof( uuid_t );
+
+                BL_CHK(
+                    false,
+                    INDEX_MAGIC == header.magic &&
+                    INDEX_VERSION == header.version &&
+                    expectedIndexSize == m_indexMapped.size(),
+                    BL_MSG()
+                        << "Filesystem metadata store index "
+                        << fs::normalizePathParameterForPrint( m_storePath / "index.dat" )
+                        << " is invalid"
+                    );
+
+                mapChecked( m_entriesMapped, "entries.dat", m_entriesCount * sizeof( EntryRecord ) );
+                mapChecked( m_chunksMapped, "chunks.dat", m_chunksCount * sizeof( ChunkRecord ) );
+                mapChecked( m_entryIdsMapped, "entry-ids.dat", m_entriesCount * sizeof( uuid_t ) );
+                mapChecked( m_chunkIdsMapped, "chunk-ids.dat", m_chunksCount * sizeof( uuid_t ) );
+
+                m_stringsMapped.map( m_storePath / "strings.dat", false /* writable */ );
+
+                const auto* indexData = m_indexMapped.data< const char >() + sizeof( IndexHeader );
+
+                m_entriesIndex = reinterpret_cast< const IndexRecord* >( indexData );
+                m_chunksIndex = m_entriesIndex + m_entriesCount;
+                m_chunksByEntry = reinterpret_cast< const uuid_t* >( m_chunksIndex + m_chunksCount );
+
+                m_locked = true;
+            }
+
+            void mapChecked(
+                SAA_inout           MappedStoreFile&                            file,
+                SAA_in              const char*                                 fileName,
+                SAA_in              const std::uint64_t                         expectedSize
+                )
+            {
+                file.map( m_storePath / fileName, false /* writable */ );
+
+                BL_CHK(
+                    false,
+                    expectedSize == file.size(),
+                    BL_MSG()
+                        << "Filesystem metadata store file "
+                        << fs::normalizePathParameterForPrint( m_storePath / fileName )
+                        << " has unexpected size "
+                        << file.size()
+                        << "; expected size is "
+                        << expectedSize
+                    );
+            }
+
+            static std::uint64_t findIndex(
+                SAA_in              const IndexRecord*                          begin,
+                SAA_in              const std::uint64_t                         count,
+                SAA_in              const uuid_t&                               id,
+                SAA_in              const char*                                 idType
+                )
+            {
+                IndexRecord key;
+
+                key.id = id;
+                key.index = 0U;
+
+                const auto* end = begin + count;
+                const auto* pos = std::lower_bound( begin, end, key );
+
+                BL_CHK(
+                    false,
+                    pos != end && pos -> id == id,
+                    BL_MSG()
+                        << "Invalid "
+                        << idType
+                        << " id '"
+                        << uuids::uuid2string( id )
+                        << "'"
+                    );
+
+                return pos -> index;
+            }
+
+            const EntryRecord& getEntry( SAA_in const uuid_t& entryId ) const
+            {
+                const auto index = findIndex( m_entriesIndex, m_entriesCount, entryId, "entry" );
+
+                chkStoreIndex( index < m_entriesCount, "index" );
+
+                return m_entriesMapped.data< const EntryRecord >()[ index ];
+            }
+
+            const ChunkRecord& getChunk( SAA_in const uuid_t& chunkId ) const
+            {
+                const auto index = findIndex( m_chunksIndex, m_chunksCount, chunkId, "chunk" );
+
+                chkStoreIndex( index < m_chunksCount, "index" );
+
+                return m_chunksMapped.data< const ChunkRecord >()[ index ];
+            }
+
+            /*
+             * The record indexes and counts are read from the mapped files, so they must be
+             * validated before they are used to access the other mapped files, otherwise a
+             * truncated or corrupted store would be read out of bounds
+             */
+
+            static void chkStoreIndex(
+                SAA_in              const bool                                  isValid,
+                SAA_in              const char*                                 fileType
+                )
+            {
+                BL_CHK(
+                    false,
+                    isValid,
+                    BL_MSG()
+                        << "Filesystem metadata store "
+                        << fileType
+                        << " file is corrupted"
+                    );
+            }
+
+            const EntryRecord& getEntryWithChunks( SAA_in const uuid_t& entryId ) const
+            {
+                const auto& entry = getEntry( entryId );
+
+                chkStoreIndex(
+                    entry.chunksCount <= m_chunksCount && entry.firstChunk <= m_chunksCount - entry.chunksCount,
+                    "entries"
+                    );
+
+                return entry;
+            }
+
+            std::string loadString( SAA_in const StringRef& ref ) const
+            {
+                if( ! ref.size )
+                {
+                    return std::string();
+                }
+
+                BL_CHK(
+                    false,
+                    ref.offset + ref.size <= m_stringsMapped.size(),
+                    BL_MSG()
+                        << "Filesystem metadata store strings file is corrupted"
+                    );
+
+                return std::string( m_stringsMapped.data< const char >() + ref.offset, ref.size );
+            }
+
+            om::ObjPtrCopyable< bo::path > loadPath( SAA_in const StringRef& ref ) const
+            {
+                if( ! ref.isSet )
+                {
+                    return nullptr;
+                }
+
+                auto path = bo::path::createInstance();
+
+                path -> lvalue() = loadString( ref );
+
+                return om::ObjPtrCopyable< bo::path >( std::move( path ) );
+            }
+
+            static void syncFile( SAA_in const fs::path& path )
+            {
+                const auto file = os::fopen( path, "r+b" );
+
+                os::fsync( file );
+            }
+
+            /*
+             * Builds the index while the store files are not mapped (i.e. before openMapped())
+             */
+
+            void buildIndex()
+            {
+                const auto entriesCount = m_entries -> size() / sizeof( EntryRecord );
+                const auto chunksCount = m_chunks -> size() / sizeof( ChunkRecord );
+
+                m_entries -> close();
+                m_chunks -> close();
+                m_entryIds -> close();
+                m_chunkIds -> close();
+                m_strings -> close();
+
+                const auto indexPath = m_storePath / "index.dat";
+                const auto indexTempPath = m_storePath / "index.dat.tmp";
+
+                const auto indexSize =
+                    sizeof( IndexHeader ) +
+                    ( entriesCount + chunksCount ) * sizeof( IndexRecord ) +
+                    chunksCount * sizeof( uuid_t );
+
+                {
+                    const auto file = os::fopen( indexTempPath, "wb" );
+                }
+
+                fs::resize_file( indexTempPath, indexSize );
+
+                {
+                    MappedStoreFile entries;
+                    MappedStoreFile chunks;
+                    MappedStoreFile entryIds;
+                    MappedStoreFile chunkIds;
+                    MappedStoreFile index;
+
+                    entries.map( m_storePath / "entries.dat", true /* writable */ );
+                    chunks.map( m_storePath / "chunks.dat", false /* writable */ );
+                    entryIds.map( m_storePath / "entry-ids.dat", false /* writable */ );
+                    chunkIds.map( m_storePath / "chunk-ids.dat", false /* writable */ );
+                    index.map( indexTempPath, true /* writable */ );
+
+                    auto* entryRecords = entries.data< EntryRecord >();
+                    const auto* chunkRecords = chunks.data< const ChunkRecord >();
+
+                    auto* entriesIndex = reinterpret_cast< IndexRecord* >( index.data< char >() + sizeof( IndexHeader ) );
+                    auto* chunksIndex = entriesIndex + entriesCount;
+                    auto* chunksByEntry = reinterpret_cast< uuid_t* >( chunksIndex + chunksCount );
+
+                    /*
+                     * Group the chunk ids by entry (a counting sort which is stable, so
+                     * the chunks of each entry are kept in the order they were created)
+                     */
+
+                    for( std::uint64_t i = 0U; i < chunksCount; ++i )
+                    {
+                        ++entryRecords[ chunkRecords[ i ].entryIndex ].chunksCount;
+                    }
+
+                    std::uint64_t firstChunk = 0U;
+
+                    for( std::uint64_t i = 0U; i < entriesCount; ++i )
+                    {
+                        entryRecords[ i ].firstChunk = firstChunk;
+                        firstChunk += entryRecords[ i ].chunksCount;
+                        entryRecords[ i ].chunksCount = 0U;
+                    }
+
+                    for( std::uint64_t i = 0U; i < chunksCount; ++i )
+                    {
+                        auto& entry = entryRecords[ chunkRecords[ i ].entryIndex ];
+
+                        chunksByEntry[ entry.firstChunk + entry.chunksCount ] = chunkIds.data< const uuid_t >()[ i ];
+                        ++entry.chunksCount;
+                    }
+
+                    /*
+                     * Build the sorted ids indexes in place in the mapped index file
+                     */
+
+                    for( std::uint64_t i = 0U; i < entriesCount; ++i )
+                    {
+                        entriesIndex[ i ].id = entryIds.data< const uuid_t >()[ i ];
+                        entriesIndex[ i ].index = i;
+                    }
+
+                    for( std::uint64_t i = 0U; i < chunksCount; ++i )
+                    {
+                        chunksIndex[ i ].id = chunkIds.data< const uuid_t >()[ i ];
+                        chunksIndex[ i ].index = i;
+                    }
+
+                    std::sort( entriesIndex, entriesIndex + entriesCount );
+                    std::sort( chunksIndex, chunksIndex + chunksCount );
+
+                    auto& header = *index.data< IndexHeader >();
+
+                    header.magic = INDEX_MAGIC;
+                    header.version = INDEX_VERSION;
+                    header.reserved = 0U;
+                    header.entriesCount = entriesCount;
+                    header.chunksCount = chunksCount;
+
+                    entries.flush();
+                    index.flush();
+                }
+
+                /*
+                 * The store is considered finalized once index.dat exists, so all the store files
+                 * must be durable before the rename (the other store files were already synced
+                 * when their writers were closed above) and the rename itself must be durable too
+                 * (i.e. the directory is synced after it)
+                 */
+
+                syncFile( m_storePath / "entries.dat" );
+                syncFile( indexTempPath );
+
+                fs::safeRename( indexTempPath, indexPath );
+
+                os::fsyncDirectory( m_storePath );
+
+                m_entries.reset();
+                m_chunks.reset();
+                m_entryIds.reset();
+                m_chunkIds.reset();
+                m_strings.reset();
+
+                m_entryIndexes.clear();
+                m_parentPaths.clear();
+                m_fileNameHashes.clear();
+            }
+
+        public:
+
+            const fs::path& storePath() const NOEXCEPT
+            {
+                return m_storePath;
+            }
+
+            MetadataStatistics computeStatistics()
+            {
+                chkLocked();
+
+                MetadataStatistics result;
+
+                result.entriesCount = ( std::uint32_t ) m_entriesCount;
+
+                /*
+                 * This check is to guard for the cast above not truncating data
+                 */
+
+                BL_CHK(
+                    false,
+                    result.entriesCount == m_entriesCount,
+                    BL_MSG()
+                        << "Number of entries being uploaded "
+                        << m_entriesCount
+                        << " is too big"
+                    );
+
+                const auto* entries = m_entriesMapped.data< const EntryRecord >();
+
+                for( std::uint64_t i = 0U; i < m_entriesCount; ++i )
+                {
+                    const auto& entry = entries[ i ];
+
+                    result.totalSize += entry.size;
+
+                    switch( entry.type )
+                    {
+                        case EntryType::Symlink:
+                            ++result.symlinksCount;
+                            break;
+
+                        case EntryType::Directory:
+                            ++result.directoriesCount;
+                            break;
+
+                        case EntryType::File:
+                            ++result.filesCount;
+                            break;
+
+                        default:
+                            BL_THROW(
+                                UnexpectedException(),
+                                BL_MSG()
+                                    << "Unexpected file system entry type: "
+                                    << entry.type
+                                );
+                            break;
+                    }
+                }
+
+                return result;
+            }
+
+            /*
+             * Implementation of FilesystemMetadataRO
+             */
+
+            virtual om::ObjPtr< UuidIterator >      queryAllEntries() OVERRIDE
+            {
+                chkLocked();
+
+                const auto* begin = m_entryIdsMapped.data< const uuid_t >();
+
+                return UuidIteratorImpl::createInstance< UuidIterator >( begin, begin + m_entriesCount, selfRef() );
+            }
+
+            virtual om::ObjPtr< UuidIterator >      queryAllChunks() OVERRIDE
+            {
+                chkLocked();
+
+                const auto* begin = m_chunkIdsMapped.data< const uuid_t >();
+
+                return UuidIteratorImpl::createInstance< UuidIterator >( begin, begin + m_chunksCount, selfRef() );
+            }
+
+            virtual std::size_t                     queryEntriesCount() OVERRIDE
+            {
+                chkLocked();
+
+                return numbers::safeCoerceTo< std::size_t >( m_entriesCount );
+            }
+
+            virtual om::ObjPtr< UuidIterator >      queryChunks( SAA_in const uuid_t& entryId ) OVERRIDE
+            {
+                chkLocked();
+
+                const auto& entry = getEntryWithChunks( entryId );
+                const auto* begin = m_chunksByEntry + entry.firstChunk;
+
+                return UuidIteratorImpl::createInstance< UuidIterator >( begin, begin + entry.chunksCount, selfRef() );
+            }
+
+            virtual std::size_t                     queryChunksCount( SAA_in const uuid_t& entryId ) OVERRIDE
+            {
+                chkLocked();
+
+                return numbers::safeCoerceTo< std::size_t >( getEntryWithChunks( entryId ).chunksCount );
+            }
+
+            virtual uuid_t                          queryEntryId( SAA_in const uuid_t& chunkId ) OVERRIDE
+            {
+                chkLocked();
+
+                const auto& chunk = getChunk( chunkId );
+
+                chkStoreIndex( chunk.entryIndex < m_entriesCount, "chunks" );
+
+                return m_entryIdsMapped.data< const uuid_t >()[ chunk.entryIndex ];
+            }
+
+            virtual EntryInfo                       loadEntryInfo( SAA_in const uuid_t& entryId ) OVERRIDE
+            {
+                chkLocked();
+
+                const auto& entry = getEntry( entryId );
+
+                EntryInfo info;
+
+                info.type = static_cast< EntryType >( entry.type );
+                info.size = entry.size;
+                info.timeCreated = static_cast< std::time_t >( entry.timeCreated );
+                info.lastModified = static_cast< std::time_t >( entry.lastModified );
+                info.flags = static_cast< EntryFlags >( entry.flags );
+                info.isChecksumSet = 0U != entry.isChecksumSet;
+                info.checksum = entry.checksum;
+
+                info.relPath = bo::path::createInstance();
+
+                if( entry.parentPath.size )
+                {
+                    info.relPath -> lvalue() = loadString( entry.parentPath );
+                    info.relPath -> lvalue() /= loadString( entry.fileName );
+                }
+                else
+                {
+                    info.relPath -> lvalue() = loadString( entry.fileName );
+                }
+
+                info.targetPath = loadPath( entry.targetPath );
+                info.sourcePath = loadPath( entry.sourcePath );
+
+                if( entry.hash.isSet )
+                {
+                    info.hash = bo::string::createInstance( loadString( entry.hash ) );
+                }
+
+                return info;
+            }
+
+            virtual ChunkInfo                       loadChunkInfo( SAA_in const uuid_t& chunkId ) OVERRIDE
+            {
+                chkLocked();
+
+                const auto& chunk = getChunk( chunkId );
+
+                ChunkInfo info;
+
+                info.pos = chunk.pos;
+                info.size = chunk.size;
+                info.checksum = chunk.checksum;
+                info.isChunkDuplicate = 0U != chunk.isChunkDuplicate;
+
+                if( chunk.hash.isSet )
+                {
+                    info.hash = bo::string::createInstance( loadString( chunk.hash ) );
+                }
+
+                return info;
+            }
+
+            /*
+             * Implementation of FilesystemMetadataWO
+             */
+
+            virtual uuid_t  createEntry( SAA_in EntryInfo&& entryInfo ) OVERRIDE
+            {
+                BL_MUTEX_GUARD( m_lock );
+
+                chkUnlocked();
+
+                BL_CHK(
+                    false,
+                    nullptr != entryInfo.relPath,
+                    BL_MSG()
+                        << "relPath must be provided for each entry"
+                    );
+
+                const auto& relPath = entryInfo.relPath -> value();
+
+                const auto parentPath = relPath.parent_path().string();
+                const auto fileName = relPath.filename().string();
+
+                const auto parentPathRef = parentPath.empty() ? emptyString() : internParentPath( parentPath );
+
+                /*
+                 * Ensure the relative path provided is always unique
+                 *
+                 * Since the parent paths are interned the path is unique if the pair of the
+                 * parent path offset and the file name is unique; only the hashes of these are
+                 * kept in memory and the file names are read back from the store on collision
+                 */
+
+                const auto pathHash =
+                    std::hash< std::string >()( fileName ) ^
+                    std::hash< std::uint64_t >()( parentPathRef.offset + parentPathRef.isSet );
+
+                const auto range = m_fileNameHashes.equal_range( pathHash );
+
+                for( auto pos = range.first; pos != range.second; ++pos )
+                {
+                    EntryRecord existing;
+
+                    m_entries -> read( pos -> second * sizeof( EntryRecord ), &existing, sizeof( existing ) );
+
+                    BL_CHK(
+                        true,
+                        existing.parentPath.offset == parentPathRef.offset &&
+                        existing.parentPath.isSet == parentPathRef.isSet &&
+                        readWrittenString( existing.fileName ) == fileName,
+                        BL_MSG()
+                            << "relPath must be unique for each entry"
+                        );
+                }
+
+                const auto entryId = uuids::create();
+                const auto entryIndex = m_entries -> size() / sizeof( EntryRecord );
+
+                EntryRecord record;
+
+                std::memset( &record, 0, sizeof( record ) );
+
+                record.size = entryInfo.size;
+                record.timeCreated = entryInfo.timeCreated;
+                record.lastModified = entryInfo.lastModified;
+                record.type = static_cast< std::uint32_t >( static_cast< EntryType >( entryInfo.type ) );
+                record.flags = static_cast< std::uint32_t >( static_cast< EntryFlags >( entryInfo.flags ) );
+                record.checksum = entryInfo.checksum;
+                record.isChecksumSet = entryInfo.isChecksumSet ? 1U : 0U;
+                record.parentPath = parentPathRef;
+                record.fileName = appendString( fileName );
+                record.targetPath = appendPath( entryInfo.targetPath );
+                record.sourcePath = appendPath( entryInfo.sourcePath );
+                record.hash = entryInfo.hash ? appendString( entryInfo.hash -> value() ) : emptyString();
+
+                m_entries -> append( &record, sizeof( record ) );
+                m_entryIds -> append( &entryId, sizeof( entryId ) );
+
+                m_entryIndexes.emplace( entryId, entryIndex );
+                m_fileNameHashes.emplace( pathHash, entryIndex );
+
+                return entryId;
+            }
+
+            virtual void    associateChecksum( SAA_in const uuid_t& entryId, SAA_in const std::uint32_t checksum ) OVERRIDE
+            {
+                BL_MUTEX_GUARD( m_lock );
+
+                chkUnlocked();
+
+                const auto entryIndex = getWrittenEntryIndex( entryId );
+
+                updateEntryField( entryIndex, offsetof( EntryRecord, checksum ), checksum );
+                updateEntryField( entryIndex, offsetof( EntryRecord, isChecksumSet ), std::uint32_t( 1U ) );
+            }
+
+            virtual void associateHash(
+                SAA_in      const uuid_t&           entryId,
+                SAA_in      const std::string&      hash
+                ) OVERRIDE
+            {
+                BL_MUTEX_GUARD( m_lock );
+
+                chkUnlocked();
+
+                const auto entryIndex = getWrittenEntryIndex( entryId );
+
+                updateEntryField( entryIndex, offsetof( EntryRecord, hash ), appendString( hash ) );
+            }
+
+            virtual uuid_t  createChunk( SAA_in const uuid_t& entryId, SAA_in ChunkInfo&& chunkInfo ) OVERRIDE
+            {
+                BL_MUTEX_GUARD( m_lock );
+
+                chkUnlocked();
+
+                const auto entryIndex = getWrittenEntryIndex( entryId );
+
+                const auto chunkId = uuids::create();
+
+                ChunkRecord record;
+
+                std::memset( &record, 0, sizeof( record ) );
+
+                record.pos = chunkInfo.pos;
+                record.entryIndex = entryIndex;
+                record.size = chunkInfo.size;
+                record.checksum = chunkInfo.checksum;
+                record.isChunkDuplicate = chunkInfo.isChunkDuplicate ? 1U : 0U;
+                record.hash = chunkInfo.hash ? appendString( chunkInfo.hash -> value() ) : emptyString();
+
+                m_chunks -> append( &record, sizeof( record ) );
+                m_chunkIds -> append( &chunkId, sizeof( chunkId ) );
+
+                return chunkId;
+            }
+
+            virtual void    finalize() OVERRIDE
+            {
+                BL_MUTEX_GUARD( m_lock );
+
+                chkUnlocked();
+
+                buildIndex();
+                openMapped();
+            }
+
+            virtual bool    isFinalized() const NOEXCEPT OVERRIDE
+            {
+                return m_locked;
+            }
+        };
+
+        typedef FilesystemMetadataMappedImplT<> FilesystemMetadataMapped;
+        typedef om::ObjectImpl< FilesystemMetadataMappedImplT<> > FilesystemMetadataMappedImpl;
+
+    } // data
+
+} // bl
+
+#endif /* __BL_FILESYSTEMMETADATAMAPPEDIMPL_H_ */
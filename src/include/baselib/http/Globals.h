@@ -61,6 +61,10 @@ namespace bl
             static const std::string                            g_cookie;
             static const std::string                            g_setCookie;
 
+            static const std::string                            g_connection;
+            static const std::string                            g_keepAlive;
+            static const std::string                            g_close;
+
             static const std::string                            g_contentTypeDefault;
 
             static const char                                   g_nameSeparator;
@@ -93,6 +97,10 @@ namespace bl
         BL_DEFINE_STATIC_CONST_STRING( HttpHeaderT, g_cookie )                      = "Cookie";
         BL_DEFINE_STATIC_CONST_STRING( HttpHeaderT, g_setCookie )                   = "Set-Cookie";
 
+        BL_DEFINE_STATIC_CONST_STRING( HttpHeaderT, g_connection )                  = "Connection";
+        BL_DEFINE_STATIC_CONST_STRING( HttpHeaderT, g_keepAlive )                   = "keep-alive";
+        BL_DEFINE_STATIC_CONST_STRING( HttpHeaderT, g_close )                       = "close";
+
         BL_DEFINE_STATIC_CONST_STRING( HttpHeaderT, g_contentTypeDefault )          = "application/json; charset=UTF-8";
 
         BL_DEFINE_STATIC_MEMBER( HttpHeaderT, const char, g_nameSeparator )         = ':';
@@ -0,0 +1,600 @@
+/*
+ * This file is part of the swblocks-baselib library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __BL_HTTP_HTTPCONNECTIONSPOOL_H_
+#define __BL_HTTP_HTTPCONNECTIONSPOOL_H_
+
+#include <baselib/tasks/TcpBaseTasks.h>
+#include <baselib/tasks/TcpSslBaseTasks.h>
+
+#include <baselib/crypto/OpenSSLTypes.h>
+
+#include <baselib/core/ObjModel.h>
+#include <baselib/core/ObjModelDefs.h>
+#include <baselib/core/TimeUtils.h>
+#include <baselib/core/OS.h>
+#include <baselib/core/BaseIncludes.h>
+
+#include <deque>
+#include <unordered_map>
+
+namespace bl
+{
+    namespace tasks
+    {
+        namespace detail
+        {
+            /**
+             * @brief class HttpConnectionsPoolStreamTraits - abstracts the differences between
+             * the plain TCP and the SSL streams which the connections pool needs to know about
+             */
+
+            template
+            <
+                typename E = void
+            >
+            class HttpConnectionsPoolStreamTraitsT
+            {
+                BL_DECLARE_STATIC( HttpConnectionsPoolStreamTraitsT )
+
+            public:
+
+                typedef asio::ip::tcp::socket                                       socket_t;
+
+                static socket_t& getSocket( SAA_in socket_t& stream ) NOEXCEPT
+                {
+                    return stream;
+                }
+
+                static socket_t& getSocket( SAA_in AsioSslStreamWrapper& stream ) NOEXCEPT
+                {
+                    return stream.getStream().next_layer();
+                }
+
+                static auto tryGetSession( SAA_in socket_t& /* stream */ ) NOEXCEPT -> crypto::sslsession_ptr_t
+                {
+                    return nullptr;
+                }
+
+                static auto tryGetSession( SAA_in AsioSslStreamWrapper& stream ) NOEXCEPT -> crypto::sslsession_ptr_t
+                {
+                    return stream.hasHandshakeCompletedSuccessfully() ? stream.tryGetSession() : nullptr;
+                }
+
+                static void setSession(
+                    SAA_in          socket_t&                                       /* stream */,
+                    SAA_in          ::SSL_SESSION*                                  /* session */
+                    )
+                {
+                }
+
+                static void setSession(
+                    SAA_in          AsioSslStreamWrapper&                           stream,
+                    SAA_in          ::SSL_SESSION*                                  session
+                    )
+                {
+                    stream.setSession( session );
+                }
+
+                static bool isSessionReused( SAA_in socket_t& /* stream */ ) NOEXCEPT
+                {
+                    return false;
+                }
+
+                static void prepareToDiscard( SAA_in socket_t& /* stream */ ) NOEXCEPT
+                {
+                }
+
+                /**
+                 * @brief Marks an idle SSL connection as shutdown before it is discarded
+                 *
+                 * OpenSSL marks the session as non-resumable when the connection is freed
+                 * without a shutdown and since the cached sessions are shared with the
+                 * connections that would invalidate them, so we do a quiet shutdown (i.e.
+                 * no close notify alert is sent) which is fine for idle connections
+                 */
+
+                static void prepareToDiscard( SAA_in AsioSslStreamWrapper& stream ) NOEXCEPT
+                {
+                    ::SSL_set_shutdown( stream.getStream().native_handle(), SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN );
+                }
+
+                static bool isSessionReused( SAA_in AsioSslStreamWrapper& stream ) NOEXCEPT
+                {
+                    return stream.isSessionReused();
+                }
+
+                /**
+                 * @brief Checks if an idle connection is still usable
+                 *
+                 * An idle connection should not have any data pending to be read, so if the
+                 * non-blocking peek doesn't return would_block then the server has either
+                 * closed the connection (EOF / reset) or it has sent something unexpected
+                 * (e.g. TLS close notify alert) and in all these cases the connection can't
+                 * be reused
+                 */
+
+                static bool isConnectionAlive( SAA_in socket_t& socket ) NOEXCEPT
+                {
+                    if( ! socket.is_open() )
+                    {
+                        return false;
+                    }
+
+                    eh::error_code ec;
+
+                    const bool wasNonBlocking = socket.non_blocking();
+
+                    socket.non_blocking( true, ec );
+
+                    if( ec )
+                    {
+                        return false;
+                    }
+
+                    char ch;
+
+                    ( void ) socket.receive( asio::buffer( &ch, 1U ), socket_t::message_peek, ec );
+
+                    eh::error_code ecRestore;
+
+                    socket.non_blocking( wasNonBlocking, ecRestore );
+
+                    return asio::error::would_block == ec && ! ecRestore;
+                }
+            };
+
+            typedef HttpConnectionsPoolStreamTraitsT<> HttpConnectionsPoolStreamTraits;
+
+        } // detail
+
+        /**
+         * @brief class HttpConnectionsPool - a pool of idle keep-alive HTTP connections grouped
+         * by endpoint (host:port) which also caches the last TLS session for each endpoint, so
+         * the new connections to the same endpoint can do an abbreviated handshake
+         *
+         * The number of idle connections per endpoint is bounded (the oldest connection is
+         * evicted when the limit is reached) and the idle connections expire after some time
+         * which should be shorter than the keep-alive timeout of the servers; the connections
+         * are also health checked when they are taken from the pool
+         *
+         * The expired connections are pruned (for all endpoints) each time a connection is taken
+         * from or returned to the pool and the endpoints which have no idle connections left
+         * are removed after the cached TLS session expires too
+         *
+         * Note that the pooled connections are bound to the I/O service of the default I/O
+         * thread pool, so the pool must be disposed before the thread pools are shutdown; after
+         * the pool is disposed the connections returned to it are closed right away
+         */
+
+        template
+        <
+            typename STREAM
+        >
+        class HttpConnectionsPoolT : public om::DisposableObjectBase
+        {
+        public:
+
+            typedef HttpConnectionsPoolT< STREAM >                                  this_type;
+
+            typedef typename STREAM::stream_t                                       stream_t;
+            typedef typename STREAM::stream_ref                                     stream_ref;
+
+            enum : std::size_t
+            {
+                MAX_IDLE_CONNECTIONS_PER_ENDPOINT_DEFAULT = 8U,
+
+                /*
+                 * The idle timeout should be less than the keep-alive timeout of
+                 * the servers (which is usually 5 seconds or more)
+                 */
+
+                IDLE_TIMEOUT_IN_MILLISECONDS_DEFAULT = 4000U,
+
+                /*
+                 * The default TLS session timeout of OpenSSL
+                 */
+
+                SESSION_TIMEOUT_IN_SECONDS = 300U,
+            };
+
+        protected:
+
+            typedef detail::HttpConnectionsPoolStreamTraits                         traits_t;
+
+            typedef std::pair< stream_ref, time::ptime >                            idle_connection_t;
+
+            struct EndpointInfo
+            {
+                std::deque< idle_connection_t >                                     idleConnections;
+                crypto::sslsession_ptr_t                                            session;
+                time::ptime                                                         lastUsed;
+            };
+
+            const std::size_t                                                       m_maxIdleConnectionsPerEndpoint;
+            const time::time_duration                                               m_idleTimeout;
+
+            os::mutex                                                               m_lock;
+            std::unordered_map< std::string, EndpointInfo >                         m_endpoints;
+            cpp::ScalarTypeIniter< std::size_t >                                    m_reusedConnectionsCount;
+            cpp::ScalarTypeIniter< std::size_t >                                    m_resumedSessionsCount;
+            cpp::ScalarTypeIniter< bool >                                           m_disposed;
+
+            HttpConnectionsPoolT(
+                SAA_in_opt      const std::size_t                                   maxIdleConnectionsPerEndpoint =
+                    MAX_IDLE_CONNECTIONS_PER_ENDPOINT_DEFAULT,
+                SAA_in_opt      const time::time_duration&                          idleTimeout =
+                    time::milliseconds( IDLE_TIMEOUT_IN_MILLISECONDS_DEFAULT )
+                )
+                :
+                m_maxIdleConnectionsPerEndpoint( maxIdleConnectionsPerEndpoint ),
+                m_idleTimeout( idleTimeout )
+            {
+            }
+
+            ~HttpConnectionsPoolT() NOEXCEPT
+            {
+                BL_NOEXCEPT_BEGIN()
+
+                clear();
+
+                BL_NOEXCEPT_END()
+            }
+
+            static void discard( SAA_inout stream_ref&& stream ) NOEXCEPT
+            {
+                if( stream )
+                {
+                    traits_t::prepareToDiscard( *stream );
+
+                    stream.reset();
+                }
+            }
+
+            bool isExpired(
+                SAA_in          const idle_connection_t&                            connection,
+                SAA_in          const time::ptime&                                  now
+                ) const NOEXCEPT
+            {
+                return now - connection.second >= m_idleTimeout;
+            }
+
+            /**
+             * @brief Moves the expired idle connections of all endpoints into discarded (so
+             * they can be closed outside of the lock) and removes the endpoints which have no
+             * idle connections and which haven't been used for longer than the session timeout
+             *
+             * Note that this must be called while holding m_lock
+             */
+
+            void pruneExpired(
+                SAA_in          const time::ptime&                                  now,
+                SAA_inout       std::vector< stream_ref >&                          discarded
+                )
+            {
+                for( auto pos = m_endpoints.begin(); pos != m_endpoints.end(); )
+                {
+                    auto& idleConnections = pos -> second.idleConnections;
+
+                    /*
+                     * The idle connections are ordered by the time they were released, so
+                     * the expired connections are always at the front
+                     */
+
+                    while( ! idleConnections.empty() && isExpired( idleConnections.front(), now ) )
+                    {
+                        discarded.push_back( std::move( idleConnections.front().first ) );
+                        idleConnections.pop_front();
+                    }
+
+                    if(
+                        idleConnections.empty() &&
+                        now - pos -> second.lastUsed >= time::seconds( SESSION_TIMEOUT_IN_SECONDS )
+                        )
+                    {
+                        pos = m_endpoints.erase( pos );
+                    }
+                    else
+                    {
+                        ++pos;
+                    }
+                }
+            }
+
+            static void discardAll( SAA_inout std::vector< stream_ref >& discarded ) NOEXCEPT
+            {
+                for( auto& connection : discarded )
+                {
+                    discard( std::move( connection ) );
+                }
+            }
+
+        public:
+
+            std::size_t maxIdleConnectionsPerEndpoint() const NOEXCEPT
+            {
+                return m_maxIdleConnectionsPerEndpoint;
+            }
+
+            const time::time_duration& idleTimeout() const NOEXCEPT
+            {
+                return m_idleTimeout;
+            }
+
+            /**
+             * @brief Returns an idle connection to the endpoint which is still alive or
+             * nullptr if there isn't such (in which case a new connection should be made)
+             */
+
+            auto tryGet( SAA_in const std::string& endpointId ) -> stream_ref
+            {
+                /*
+                 * The expired and dead connections are closed outside of the lock
+                 */
+
+                std::vector< stream_ref > discarded;
+
+                stream_ref stream;
+
+                {
+                    BL_MUTEX_GUARD( m_lock );
+
+                    const auto now = time::microsec_clock::universal_time();
+
+                    pruneExpired( now, discarded );
+
+                    const auto pos = m_endpoints.find( endpointId );
+
+                    if( pos == m_endpoints.end() )
+                    {
+                        discardAll( discarded );
+
+                        return nullptr;
+                    }
+
+                    auto& idleConnections = pos -> second.idleConnections;
+
+                    /*
+                     * The most recently released connections are reused first as these are
+                     * the least likely to be closed by the server
+                     */
+
+                    while( ! idleConnections.empty() )
+                    {
+                        auto connection = std::move( idleConnections.back() );
+                        idleConnections.pop_back();
+
+                        if(
+                            ! isExpired( connection, now ) &&
+                            traits_t::isConnectionAlive( traits_t::getSocket( *connection.first ) )
+                            )
+                        {
+                            stream = std::move( connection.first );
+
+                            ++m_reusedConnectionsCount.lvalue();
+
+                            break;
+                        }
+
+                        discarded.push_back( std::move( connection.first ) );
+                    }
+                }
+
+                discardAll( discarded );
+
+                return stream;
+            }
+
+            /**
+             * @brief Returns a connection to the pool after a complete response was received
+             * on it and it is still open on both sides (i.e. the server has agreed to keep it
+             * alive)
+             */
+
+            void put(
+                SAA_in          const std::string&                                  endpointId,
+                SAA_inout       stream_ref&&                                        stream
+                )
+            {
+                BL_ASSERT( stream );
+
+                std::vector< stream_ref > discarded;
+
+                {
+                    BL_MUTEX_GUARD( m_lock );
+
+                    const auto now = time::microsec_clock::universal_time();
+
+                    pruneExpired( now, discarded );
+
+                    if( m_disposed || 0U == m_maxIdleConnectionsPerEndpoint )
+                    {
+                        discarded.push_back( std::move( stream ) );
+                    }
+                    else
+                    {
+                        auto& endpoint = m_endpoints[ endpointId ];
+
+                        if( endpoint.idleConnections.size() >= m_maxIdleConnectionsPerEndpoint )
+                        {
+                            discarded.push_back( std::move( endpoint.idleConnections.front().first ) );
+                            endpoint.idleConnections.pop_front();
+                        }
+
+                        endpoint.idleConnections.emplace_back( std::move( stream ), now );
+                        endpoint.lastUsed = now;
+                    }
+                }
+
+                discardAll( discarded );
+            }
+
+            /**
+             * @brief Saves the TLS session of a connection (if any) so it can be resumed by
+             * the new connections to the same endpoint
+             */
+
+            void trySaveSession(
+                SAA_in          const std::string&                                  endpointId,
+                SAA_in          stream_t&                                           stream
+                )
+            {
+                auto session = traits_t::tryGetSession( stream );
+
+                if( ! session )
+                {
+                    return;
+                }
+
+                const bool isSessionReused = traits_t::isSessionReused( stream );
+
+                crypto::sslsession_ptr_t replaced;
+
+                {
+                    BL_MUTEX_GUARD( m_lock );
+
+                    if( m_disposed )
+                    {
+                        return;
+                    }
+
+                    auto& endpoint = m_endpoints[ endpointId ];
+
+                    replaced = std::move( endpoint.session );
+                    endpoint.session = std::move( session );
+                    endpoint.lastUsed = time::microsec_clock::universal_time();
+
+                    if( isSessionReused )
+                    {
+                        ++m_resumedSessionsCount.lvalue();
+                    }
+                }
+            }
+
+            /**
+             * @brief Requests the last saved TLS session for the endpoint (if any) to be
+             * resumed on a new connection which hasn't done the handshake yet
+             */
+
+            bool tryResumeSession(
+                SAA_in          const std::string&                                  endpointId,
+                SAA_in          stream_t&                                           stream
+                )
+            {
+                BL_MUTEX_GUARD( m_lock );
+
+                const auto pos = m_endpoints.find( endpointId );
+
+                if( pos == m_endpoints.end() || ! pos -> second.session )
+                {
+                    return false;
+                }
+
+                /*
+                 * SSL_set_session increments the session reference count, so it is ok to
+                 * replace or free the cached session afterwards
+                 */
+
+                traits_t::setSession( stream, pos -> second.session.get() );
+
+                pos -> second.lastUsed = time::microsec_clock::universal_time();
+
+                return true;
+            }
+
+            /**
+             * @brief Discards the saved TLS session for the endpoint (e.g. if the server
+             * has failed the handshake when the session was attempted to be resumed)
+             */
+
+            void removeSession( SAA_in const std::string& endpointId )
+            {
+                crypto::sslsession_ptr_t removed;
+
+                {
+                    BL_MUTEX_GUARD( m_lock );
+
+                    const auto pos = m_endpoints.find( endpointId );
+
+                    if( pos != m_endpoints.end() )
+                    {
+                        removed = std::move( pos -> second.session );
+                    }
+                }
+            }
+
+            std::size_t idleConnectionsCount( SAA_in const std::string& endpointId )
+            {
+                BL_MUTEX_GUARD( m_lock );
+
+                const auto pos = m_endpoints.find( endpointId );
+
+                return pos == m_endpoints.end() ? 0U : pos -> second.idleConnections.size();
+            }
+
+            std::size_t reusedConnectionsCount()
+            {
+                BL_MUTEX_GUARD( m_lock );
+
+                return m_reusedConnectionsCount;
+            }
+
+            std::size_t resumedSessionsCount()
+            {
+                BL_MUTEX_GUARD( m_lock );
+
+                return m_resumedSessionsCount;
+            }
+
+            virtual void dispose() OVERRIDE
+            {
+                {
+                    BL_MUTEX_GUARD( m_lock );
+
+                    m_disposed = true;
+                }
+
+                clear();
+            }
+
+            void clear()
+            {
+                std::unordered_map< std::string, EndpointInfo > endpoints;
+
+                {
+                    BL_MUTEX_GUARD( m_lock );
+
+                    endpoints.swap( m_endpoints );
+                }
+
+                for( auto& endpoint : endpoints )
+                {
+                    for( auto& connection : endpoint.second.idleConnections )
+                    {
+                        discard( std::move( connection.first ) );
+                    }
+                }
+            }
+        };
+
+        typedef om::ObjectImpl< HttpConnectionsPoolT< TcpSocketAsyncBase > > HttpConnectionsPool;
+        typedef om::ObjectImpl< HttpConnectionsPoolT< TcpSslSocketAsyncBase > > HttpSslConnectionsPool;
+
+    } // tasks
+
+} // bl
+
+#endif /* __BL_HTTP_HTTPCONNECTIONSPOOL_H_ */
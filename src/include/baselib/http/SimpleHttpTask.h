@@ -20,6 +20,7 @@
 #include <baselib/tasks/TaskBase.h>
 #include <baselib/tasks/TcpBaseTasks.h>
 
+#include <baselib/http/HttpConnectionsPool.h>
 #include <baselib/http/Globals.h>
 
 #include <baselib/data/DataBlock.h>
@@ -60,6 +61,8 @@ namespace bl
 
             typedef http::HeadersMap                                                HeadersMap;
 
+            typedef om::ObjectImpl< HttpConnectionsPoolT< STREAM > >                connections_pool_t;
+
         protected:
 
             enum
@@ -91,6 +94,12 @@ namespace bl
             time::time_duration                                                     m_timeout;
             cpp::ScalarTypeIniter< bool >                                           m_isSecureMode;
             cpp::ScalarTypeIniter< bool >                                           m_isExpectUtf8Content;
+            om::ObjPtr< connections_pool_t >                                        m_connectionsPool;
+            cpp::ScalarTypeIniter< bool >                                           m_isReusedConnection;
+            cpp::ScalarTypeIniter< bool >                                           m_isSessionResumeRequested;
+            cpp::ScalarTypeIniter< bool >                                           m_isKeepAliveResponse;
+            cpp::ScalarTypeIniter< bool >                                           m_isRequestWritten;
+            cpp::ScalarTypeIniter< std::size_t >                                    m_contentLengthReceived;
 
             SimpleHttpTaskT(
                 SAA_in          std::string&&               host,
@@ -229,9 +238,107 @@ namespace bl
             {
                 initRequest();
 
+                if( m_connectionsPool )
+                {
+                    auto stream = m_connectionsPool -> tryGet( base_type::endpointId() );
+
+                    if( stream )
+                    {
+                        /*
+                         * We have got an idle connection to the same endpoint which is already
+                         * connected (and for SSL the handshake is already done), so we can
+                         * skip the resolve / connect / handshake steps and send the request
+                         * right away
+                         */
+
+                        base_type::attachStream( std::move( stream ) );
+
+                        eh::error_code ec;
+
+                        base_type::m_endpoint = base_type::getSocket().remote_endpoint( ec );
+
+                        m_isReusedConnection = true;
+
+                        continueAfterConnected();
+
+                        return;
+                    }
+                }
+
                 base_type::scheduleTask( eq );
             }
 
+            virtual bool continueAfterResolved( SAA_in tcp::resolver::iterator endpoints ) OVERRIDE
+            {
+                const bool result = base_type::continueAfterResolved( endpoints );
+
+                if( m_connectionsPool )
+                {
+                    /*
+                     * The socket was just created and the connect has started, but the protocol
+                     * handshake hasn't started yet (it will start after the connect completes),
+                     * so we can still request the TLS session to be resumed
+                     */
+
+                    m_isSessionResumeRequested =
+                        m_connectionsPool -> tryResumeSession( base_type::endpointId(), base_type::getStream() );
+                }
+
+                return result;
+            }
+
+            virtual bool scheduleTaskFinishContinuation( SAA_in_opt const std::exception_ptr& eptrIn = nullptr ) OVERRIDE
+            {
+                const bool isRetryNeeded =
+                    eptrIn &&
+                    HTTP_STATUS_UNDEFINED == m_httpStatus &&
+                    ! TaskBase::isCanceled() &&
+                    (
+                        ( m_isReusedConnection && ( ! m_isRequestWritten || isSafeAction() ) ) ||
+                        ( m_isSessionResumeRequested && ! base_type::hasHandshakeCompletedSuccessfully() )
+                    );
+
+                if( isRetryNeeded )
+                {
+                    /*
+                     * If the pooled connection has failed before any response was received
+                     * that means the server has most likely closed it after it was health
+                     * checked (e.g. the keep-alive timeout has expired on the server side)
+                     *
+                     * If the handshake has failed when a TLS session was attempted to be
+                     * resumed then the server likely doesn't support resuming it and we
+                     * should discard the session
+                     *
+                     * In both cases we retry the request once on a new connection, but note
+                     * that if the request was (even partially) written on a pooled connection
+                     * the server may have already received and executed it, so in this case
+                     * only the safe methods (which have no side effects) are retried
+                     */
+
+                    if( m_isSessionResumeRequested && ! m_isReusedConnection )
+                    {
+                        m_connectionsPool -> removeSession( base_type::endpointId() );
+                    }
+
+                    m_isReusedConnection = false;
+                    m_isSessionResumeRequested = false;
+
+                    cancelTimer();
+                    resetRequestState();
+
+                    base_type::resetStreamState();
+                    base_type::m_resolver.reset();
+
+                    initRequest();
+
+                    base_type::startConnectionEstablishingInternal();
+
+                    return true;
+                }
+
+                return base_type::scheduleTaskFinishContinuation( eptrIn );
+            }
+
             void scheduleTimer()
             {
                 m_timer -> expires_from_now( m_timeout );
@@ -251,9 +358,14 @@ namespace bl
 
                 m_remoteEndpointId = net::safeRemoteEndpointId( base_type::getSocket() );
 
+                /*
+                 * Note that m_resolver won't be created if a pooled connection was
+                 * acquired, so the timer is created on the I/O thread pool directly
+                 */
+
                 m_timer.reset(
                     new asio::deadline_timer(
-                        base_type::m_resolver -> get_io_service(),
+                        ThreadPoolDefault::getDefault( base_type::getThreadPoolId() ) -> aioService(),
                         time::milliseconds( 0 )
                         )
                     );
@@ -266,7 +378,8 @@ namespace bl
                     cpp::bind(
                         &this_type::doRequest,
                         om::ObjPtrCopyable< this_type >::acquireRef( this ),
-                        asio::placeholders::error
+                        asio::placeholders::error,
+                        asio::placeholders::bytes_transferred
                         )
                     );
 
@@ -488,6 +601,28 @@ namespace bl
                 m_isExpectUtf8Content = isExpectUtf8Content;
             }
 
+            const om::ObjPtr< connections_pool_t >& getConnectionsPool() const NOEXCEPT
+            {
+                return m_connectionsPool;
+            }
+
+            /**
+             * @brief Sets a connections pool to be used by the task
+             *
+             * When a pool is set the task will request the connection to be kept alive and
+             * then reuse the pooled connections and the TLS sessions for the same endpoint
+             */
+
+            void setConnectionsPool( SAA_in const om::ObjPtr< connections_pool_t >& connectionsPool ) NOEXCEPT
+            {
+                m_connectionsPool = om::copy( connectionsPool );
+            }
+
+            bool isReusedConnection() const NOEXCEPT
+            {
+                return m_isReusedConnection;
+            }
+
             void addExpectedHttpStatuses( SAA_in const http::StatusesList& expectedHttpStatuses )
             {
                 m_expectedHttpStatuses.insert( expectedHttpStatuses.begin(), expectedHttpStatuses.end() );
@@ -533,7 +668,8 @@ namespace bl
                     << m_path
                     << " HTTP/1.0\r\nHost: "
                     << base_type::m_query.host_name()
-                    << "\r\nAccept: */*\r\nConnection: close";
+                    << "\r\nAccept: */*\r\nConnection: "
+                    << ( m_connectionsPool ? HttpHeader::g_keepAlive : HttpHeader::g_close );
 
                 for( const auto& headerPair : m_requestHeaders )
                 {
@@ -559,8 +695,16 @@ namespace bl
                 }
             }
 
-            void doRequest( SAA_in const eh::error_code& ec ) NOEXCEPT
+            void doRequest(
+                SAA_in      const eh::error_code&                   ec,
+                SAA_in      const std::size_t                       bytesTransferred
+                ) NOEXCEPT
             {
+                if( bytesTransferred )
+                {
+                    m_isRequestWritten = true;
+                }
+
                 BL_TASKS_HANDLER_BEGIN_CHK_EC()
 
                 asio::async_read_until(
@@ -674,6 +818,31 @@ namespace bl
                 {
                     m_responseLength = std::stoul( pos -> second );
                 }
+                else if( isNoContentResponse() )
+                {
+                    m_responseLength = 0U;
+                }
+
+                if( m_connectionsPool )
+                {
+                    /*
+                     * The connection can be reused only if the server has agreed to keep
+                     * it alive and the end of the response can be determined without
+                     * reading until EOF (i.e. from the Content-Length header or from the
+                     * status code / method for the responses which have no content)
+                     *
+                     * A keep-alive response which has content, but no Content-Length is
+                     * never reused - its content is read until the server closes the
+                     * connection (or until the request timeout expires)
+                     */
+
+                    const auto connection = tryGetResponseHeader( HttpHeader::g_connection );
+
+                    m_isKeepAliveResponse =
+                        static_cast< std::size_t >( -1 ) != m_responseLength &&
+                        connection &&
+                        str::iequals( *connection, HttpHeader::g_keepAlive );
+                }
 
                 auto cookies = cookiesBuffer.str();
 
@@ -685,10 +854,25 @@ namespace bl
                 if( m_response.size() > 0 )
                 {
                     // get current content
+                    m_contentLengthReceived.lvalue() += m_response.size();
                     m_contentOutStream << &m_response;
                 }
 
-                // Start reading remaining data
+                if( ! isKeepAliveResponseComplete() )
+                {
+                    // Start reading remaining data
+                    scheduleReadContent();
+
+                    return;
+                }
+
+                completeResponse();
+
+                BL_TASKS_HANDLER_END()
+            }
+
+            void scheduleReadContent()
+            {
                 base_type::getStream().async_read_some(
                     asio::buffer( m_contentBuffer -> pv(), m_contentBuffer -> size() ),
                     cpp::bind(
@@ -700,8 +884,6 @@ namespace bl
                     );
 
                 scheduleTimer();
-
-                BL_TASKS_HANDLER_END_NOTREADY()
             }
 
             void doReadContent(
@@ -729,14 +911,14 @@ namespace bl
                 {
                     BL_TASKS_HANDLER_BEGIN()
 
-                    m_contentOut = decodeContent();
+                    /*
+                     * The server has closed the connection, so it can't be reused even
+                     * if it has agreed to keep it alive initially
+                     */
 
-                    m_contentOutStream.str( std::string() );
+                    m_isKeepAliveResponse = false;
 
-                    if( HTTP_SUCCESS_OK != m_httpStatus )
-                    {
-                        throwHttpException();
-                    }
+                    completeResponse();
 
                     BL_TASKS_HANDLER_END()
 
@@ -746,23 +928,105 @@ namespace bl
                 BL_TASKS_HANDLER_BEGIN_CHK_EC()
 
                 // store any content from response
+                m_contentLengthReceived.lvalue() += bytesTransferred;
                 m_contentOutStream
                     << std::string( reinterpret_cast< char* >( m_contentBuffer -> pv() ), bytesTransferred );
 
-                // Continue reading remaining data until EOF.
-                base_type::getStream().async_read_some(
-                    asio::buffer( m_contentBuffer -> pv(), m_contentBuffer -> size() ),
-                    cpp::bind(
-                        &this_type::doReadContent,
-                        om::ObjPtrCopyable< this_type >::acquireRef( this ),
-                        asio::placeholders::error,
-                        asio::placeholders::bytes_transferred
-                        )
-                    );
+                if( ! isKeepAliveResponseComplete() )
+                {
+                    // Continue reading remaining data until EOF (or until Content-Length is reached)
+                    scheduleReadContent();
 
-                scheduleTimer();
+                    return;
+                }
 
-                BL_TASKS_HANDLER_END_NOTREADY()
+                completeResponse();
+
+                BL_TASKS_HANDLER_END()
+            }
+
+            /**
+             * @brief Returns true if the method is safe (i.e. it has no side effects on
+             * the server) and thus the request can be retried after it was sent
+             */
+
+            bool isSafeAction() const NOEXCEPT
+            {
+                return
+                    "GET" == m_action ||
+                    "HEAD" == m_action ||
+                    "OPTIONS" == m_action ||
+                    "TRACE" == m_action;
+            }
+
+            /**
+             * @brief Returns true if the response can't have content (regardless of the
+             * Content-Length header) based on the request method and the status code
+             */
+
+            bool isNoContentResponse() const NOEXCEPT
+            {
+                return
+                    "HEAD" == m_action ||
+                    m_httpStatus < HTTP_SUCCESS_OK ||
+                    HTTP_SUCCESS_NO_CONTENT == m_httpStatus ||
+                    HTTP_REDIRECT_NOT_MODIFIED == m_httpStatus;
+            }
+
+            bool isKeepAliveResponseComplete() const NOEXCEPT
+            {
+                return m_isKeepAliveResponse && m_contentLengthReceived >= m_responseLength;
+            }
+
+            void completeResponse()
+            {
+                m_contentOut = decodeContent();
+
+                m_contentOutStream.str( std::string() );
+
+                chkToReleaseConnection();
+
+                if( HTTP_SUCCESS_OK != m_httpStatus )
+                {
+                    throwHttpException();
+                }
+            }
+
+            /**
+             * @brief Saves the TLS session and returns the connection to the pool if
+             * the server has agreed to keep it alive and the response was complete
+             */
+
+            void chkToReleaseConnection()
+            {
+                if( ! m_connectionsPool || ! base_type::isChannelOpen() )
+                {
+                    return;
+                }
+
+                const auto endpointId = base_type::endpointId();
+
+                m_connectionsPool -> trySaveSession( endpointId, base_type::getStream() );
+
+                if( m_isKeepAliveResponse && m_contentLengthReceived == m_responseLength )
+                {
+                    cancelTimer();
+
+                    m_connectionsPool -> put( endpointId, base_type::detachStream() );
+                }
+            }
+
+            void resetRequestState()
+            {
+                m_request.consume( m_request.size() );
+                m_response.consume( m_response.size() );
+                m_contentOutStream.str( std::string() );
+                m_responseHeaders.clear();
+                m_responseLength = -1;
+                m_httpStatus = HTTP_STATUS_UNDEFINED;
+                m_isKeepAliveResponse = false;
+                m_isRequestWritten = false;
+                m_contentLengthReceived = 0U;
             }
 
             template
@@ -27,6 +27,8 @@
 
 #include <baselib/data/DataBlock.h>
 
+#include <baselib/core/ThreadPool.h>
+#include <baselib/core/TimeUtils.h>
 #include <baselib/core/ObjModelDefs.h>
 #include <baselib/core/ObjModel.h>
 #include <baselib/core/BaseIncludes.h>
@@ -57,23 +59,119 @@ namespace bl
             typedef httpserver::detail::ParserHelpers                                           ParserHelpers;
             typedef httpserver::detail::HttpParserResult                                        HttpParserResult;
 
-            om::ObjPtr< data::DataBlock >                                                       m_buffer;
+            const om::ObjPtr< data::DataBlock >                                                 m_buffer;
             const om::ObjPtr< Parser >                                                          m_parser;
             om::ObjPtr< Request >                                                               m_request;
 
             ServerResult                                                                        m_parsingStatus;
 
+            /*
+             * The idle timer handler and the read handler can run concurrently, so which
+             * of them wins is decided once via compare and swap of the idle state
+             */
+
+            enum IdleState : int
+            {
+                IDLE_WAITING,
+                IDLE_DATA_RECEIVED,
+                IDLE_TIMED_OUT,
+            };
+
+            const time::time_duration                                                           m_idleTimeout;
+            cpp::SafeUniquePtr< asio::deadline_timer >                                          m_idleTimer;
+            std::atomic< int >                                                                  m_idleState;
+            cpp::ScalarTypeIniter< bool >                                                       m_connectionClosed;
+
         protected:
 
-            HttpServerReceiveRequestTask( SAA_in typename base_type::stream_ref&& connectedStream )
+            /**
+             * @brief The buffer and the parser are normally owned by the connection, so they
+             * can be reused for all requests on it
+             *
+             * If idleTimeout is specified the task is waiting for the next request on
+             * a persistent connection - in this case the client closing the connection (or
+             * the idle timeout expiring) before any data was received is not an error
+             */
+
+            HttpServerReceiveRequestTask(
+                SAA_in          typename base_type::stream_ref&&                                connectedStream,
+                SAA_in_opt      om::ObjPtr< data::DataBlock >&&                                 buffer = nullptr,
+                SAA_in_opt      om::ObjPtr< Parser >&&                                          parser = nullptr,
+                SAA_in_opt      const time::time_duration&                                      idleTimeout = time::neg_infin
+                )
                 :
-                m_buffer( data::DataBlock::createInstance( 512U ) ),
-                m_parser( Parser::createInstance() ),
-                m_parsingStatus( ParserHelpers::serverResult( HttpParserResult::MORE_DATA_REQUIRED ) )
+                m_buffer( buffer ? BL_PARAM_FWD( buffer ) : data::DataBlock::createInstance( BUFFER_SIZE_DEFAULT ) ),
+                m_parser( parser ? BL_PARAM_FWD( parser ) : Parser::createInstance() ),
+                m_parsingStatus( ParserHelpers::serverResult( HttpParserResult::MORE_DATA_REQUIRED ) ),
+                m_idleTimeout( idleTimeout ),
+                m_idleState( IDLE_WAITING )
             {
                 base_type::attachStream( BL_PARAM_FWD( connectedStream ) );
             }
 
+            bool isWaitingForNextRequest() const NOEXCEPT
+            {
+                return ! m_idleTimeout.is_special() && IDLE_DATA_RECEIVED != m_idleState.load();
+            }
+
+            bool tryChangeIdleState( SAA_in const IdleState newState ) NOEXCEPT
+            {
+                int expected = IDLE_WAITING;
+
+                return m_idleState.compare_exchange_strong( expected, newState ) || newState == expected;
+            }
+
+            void scheduleIdleTimer()
+            {
+                m_idleTimer.reset(
+                    new asio::deadline_timer(
+                        ThreadPoolDefault::getDefault( base_type::getThreadPoolId() ) -> aioService()
+                        )
+                    );
+
+                m_idleTimer -> expires_from_now( m_idleTimeout );
+
+                m_idleTimer -> async_wait(
+                    cpp::bind(
+                        &this_type::onIdleTimer,
+                        om::ObjPtrCopyable< this_type >::acquireRef( this ),
+                        asio::placeholders::error
+                        )
+                    );
+            }
+
+            void cancelIdleTimer() NOEXCEPT
+            {
+                if( m_idleTimer )
+                {
+                    eh::error_code ec;
+
+                    m_idleTimer -> cancel( ec );
+                }
+            }
+
+            void onIdleTimer( SAA_in const eh::error_code& ec ) NOEXCEPT
+            {
+                BL_TASKS_HANDLER_BEGIN()
+
+                if(
+                    asio::error::operation_aborted != ec &&
+                    tryChangeIdleState( IDLE_TIMED_OUT ) &&
+                    base_type::isChannelOpen()
+                    )
+                {
+                    /*
+                     * Shutting down the socket will abort the pending read and the
+                     * read handler will complete the task (even if the next request has
+                     * just started arriving - the timeout has expired first)
+                     */
+
+                    base_type::cancelTask();
+                }
+
+                BL_TASKS_HANDLER_END_NOTREADY()
+            }
+
             void scheduleRead()
             {
                 base_type::getStream().async_read_some(
@@ -92,8 +190,44 @@ namespace bl
                 SAA_in      const std::size_t                                                   bytesTransferred
                 ) NOEXCEPT
             {
-                BL_TASKS_HANDLER_BEGIN_CHK_EC()
+                BL_TASKS_HANDLER_BEGIN()
+
+                cancelIdleTimer();
+
+                const bool isIdle = ec ?
+                    isWaitingForNextRequest()
+                    :
+                    ! tryChangeIdleState( IDLE_DATA_RECEIVED );
+
+                if( isIdle )
+                {
+                    /*
+                     * The persistent connection was closed by the client or because the idle
+                     * timeout has expired before the next request has started arriving
+                     */
+
+                    m_connectionClosed = true;
+                }
+                else
+                {
+                    BL_CHK_EC_NM( ec );
+                    BL_TASKS_HANDLER_CHK_CANCEL_IMPL()
+
+                    if( ! handleData( bytesTransferred ) )
+                    {
+                        /*
+                         * More data is required and the read has been re-scheduled
+                         */
+
+                        return;
+                    }
+                }
+
+                BL_TASKS_HANDLER_END()
+            }
 
+            bool handleData( SAA_in const std::size_t bytesTransferred )
+            {
                 m_parsingStatus = m_parser -> parse(
                     reinterpret_cast< char* >( m_buffer -> pv() ),
                     reinterpret_cast< char* >( m_buffer -> pv() ) + bytesTransferred
@@ -105,9 +239,18 @@ namespace bl
                 {
                     scheduleRead();
 
-                    return;
+                    return false;
                 }
 
+                chkParsingStatus();
+
+                return true;
+            }
+
+            void chkParsingStatus()
+            {
+                const auto parserResult = m_parsingStatus.first;
+
                 if( HttpParserResult::PARSED == parserResult )
                 {
                     m_request = m_parser -> buildRequest();
@@ -142,8 +285,6 @@ namespace bl
                             << " and no error details"
                         );
                 }
-
-                BL_TASKS_HANDLER_END()
             }
 
             virtual void scheduleTask( SAA_in const std::shared_ptr< tasks::ExecutionQueue >& eq ) OVERRIDE
@@ -158,11 +299,21 @@ namespace bl
 
                 BL_UNUSED( eq );
 
+                if( ! m_idleTimeout.is_special() )
+                {
+                    scheduleIdleTimer();
+                }
+
                 scheduleRead();
             }
 
         public:
 
+            enum : std::size_t
+            {
+                BUFFER_SIZE_DEFAULT = 4U * 1024U,
+            };
+
             auto request() NOEXCEPT -> const om::ObjPtr< Request >&
             {
                 return m_request;
@@ -172,6 +323,51 @@ namespace bl
             {
                 return m_parsingStatus;
             }
+
+            /**
+             * @brief Returns true if the persistent connection was closed while waiting for
+             * the next request (in which case there is no request and nothing to respond to)
+             */
+
+            bool isConnectionClosed() const NOEXCEPT
+            {
+                return m_connectionClosed;
+            }
+
+            /**
+             * @brief Parses the data which was received together with the previous request
+             * on the same connection (pipelining) - it must be called before the task is
+             * scheduled
+             *
+             * @return true if the request has been parsed (or has failed to parse) without
+             * having to read more data from the connection and then the task should not be
+             * scheduled
+             */
+
+            bool tryParsePendingData()
+            {
+                if( m_parser -> hasPendingData() )
+                {
+                    m_idleState.store( IDLE_DATA_RECEIVED );
+                }
+
+                m_parsingStatus = m_parser -> parseNext();
+
+                switch( m_parsingStatus.first )
+                {
+                    case HttpParserResult::MORE_DATA_REQUIRED:
+                        return false;
+
+                    case HttpParserResult::PARSED:
+                        m_request = m_parser -> buildRequest();
+                        break;
+
+                    default:
+                        break;
+                }
+
+                return true;
+            }
         };
 
         template
@@ -198,26 +394,44 @@ namespace bl
             typedef HttpServerSendResponseTask< STREAM >                                        this_type;
             typedef STREAM                                                                      base_type;
 
+            typedef http::Parameters::HttpHeader                                                HttpHeader;
+
             const om::ObjPtr< Response >                                                        m_response;
+            const std::string                                                                   m_extraHeaders;
+            std::vector< asio::const_buffer >                                                   m_buffers;
+            cpp::ScalarTypeIniter< std::size_t >                                                m_buffersWritten;
+            om::ObjPtr< data::DataBlock >                                                       m_contentBlock;
 
         protected:
 
+            /**
+             * @brief The extra headers (if any) are headers decided by the connection rather
+             * than by the backend (e.g. 'Connection') and they must be CRLF terminated
+             */
+
             HttpServerSendResponseTask(
                 SAA_in      typename base_type::stream_ref&&                                    connectedStream,
-                SAA_in      om::ObjPtr< Response >&&                                            response
+                SAA_in      om::ObjPtr< Response >&&                                            response,
+                SAA_in_opt  std::string&&                                                       extraHeaders = std::string(),
+                SAA_in_opt  const bool                                                          closeStreamOnTaskFinish = true
                 )
                 :
-                m_response( BL_PARAM_FWD( response ) )
+                m_response( BL_PARAM_FWD( response ) ),
+                m_extraHeaders( BL_PARAM_FWD( extraHeaders ) )
             {
                 base_type::attachStream( BL_PARAM_FWD( connectedStream ) );
-                base_type::isCloseStreamOnTaskFinish( true );
+                base_type::isCloseStreamOnTaskFinish( closeStreamOnTaskFinish );
             }
 
-            void scheduleWrite()
+            template
+            <
+                typename BUFFERS
+            >
+            void scheduleWriteBuffers( SAA_in const BUFFERS& buffers )
             {
                 asio::async_write(
                     base_type::getStream(),
-                    asio::buffer( m_response -> getSerialized().c_str(), m_response -> getSerialized().size() ),
+                    buffers,
                     boost::bind(
                         &this_type::handleWrite,
                         om::ObjPtrCopyable< this_type >::acquireRef( this ),
@@ -227,6 +441,118 @@ namespace bl
                     );
             }
 
+            enum : std::size_t
+            {
+                WRITE_BUFFERS_MAX = 16U,
+            };
+
+            /**
+             * @brief The response is written as a scatter-gather sequence of buffers (status
+             * line, extra headers, headers and then the content or the content blocks), so
+             * the response content is never copied
+             *
+             * The buffers are written in batches of fixed size arrays as some versions of asio
+             * do not write std::vector buffer sequences to SSL streams correctly
+             *
+             * If the response is streamed then after the status line and the headers are written
+             * the content blocks are pulled from the producer one at a time (see below)
+             */
+
+            void scheduleWrite()
+            {
+                const auto& statusLine = m_response -> getStatusLine();
+                const auto& headers = m_response -> getSerializedHeaders();
+                const auto& content = m_response -> content();
+                const auto& contentBlocks = m_response -> contentBlocks();
+
+                m_buffers.clear();
+                m_buffers.reserve( 4U + contentBlocks.size() );
+
+                m_buffers.push_back( asio::buffer( statusLine.c_str(), statusLine.size() ) );
+
+                if( ! m_extraHeaders.empty() )
+                {
+                    m_buffers.push_back( asio::buffer( m_extraHeaders.c_str(), m_extraHeaders.size() ) );
+                }
+
+                m_buffers.push_back( asio::buffer( headers.c_str(), headers.size() ) );
+
+                if( ! content.empty() )
+                {
+                    m_buffers.push_back( asio::buffer( content.c_str(), content.size() ) );
+                }
+
+                for( const auto& block : contentBlocks )
+                {
+                    if( block -> size() )
+                    {
+                        m_buffers.push_back( asio::buffer( block -> begin(), block -> size() ) );
+                    }
+                }
+
+                m_buffersWritten = 0U;
+
+                scheduleWriteNextBuffers();
+            }
+
+            void scheduleWriteNextBuffers()
+            {
+                BL_ASSERT( m_buffersWritten < m_buffers.size() );
+
+                const auto count = std::min< std::size_t >(
+                    WRITE_BUFFERS_MAX,
+                    m_buffers.size() - m_buffersWritten
+                    );
+
+                /*
+                 * The unused buffers in the array are empty and they are simply skipped
+                 */
+
+                std::array< asio::const_buffer, WRITE_BUFFERS_MAX > buffers;
+
+                const auto first = m_buffers.begin() + m_buffersWritten;
+
+                std::copy( first, first + count, buffers.begin() );
+
+                m_buffersWritten += count;
+
+                scheduleWriteBuffers( buffers );
+            }
+
+            /**
+             * @brief Pulls the next block from the content producer of a streamed response and
+             * writes it - returns false when the content is complete
+             *
+             * The next block is only requested after the previous one has been written, so the
+             * producer is free to reuse the same block and at most one block is held in memory
+             */
+
+            bool scheduleWriteNextContentBlock()
+            {
+                const auto& contentProducer = m_response -> contentProducer();
+
+                for( ;; )
+                {
+                    m_contentBlock = contentProducer();
+
+                    if( ! m_contentBlock )
+                    {
+                        return false;
+                    }
+
+                    if( m_contentBlock -> size() )
+                    {
+                        break;
+                    }
+                }
+
+                scheduleWriteBuffers(
+                    asio::buffer( m_contentBlock -> begin(), m_contentBlock -> size() )
+                    );
+
+                return true;
+            }
+
             void handleWrite(
                 SAA_in      const eh::error_code&                                               ec,
                 SAA_in      const std::size_t                                                   bytesTransferred
@@ -236,6 +562,20 @@ namespace bl
 
                 BL_TASKS_HANDLER_BEGIN_CHK_EC()
 
+                if( m_buffersWritten < m_buffers.size() )
+                {
+                    scheduleWriteNextBuffers();
+
+                    return;
+                }
+
+                if( m_response -> isStreamed() && scheduleWriteNextContentBlock() )
+                {
+                    return;
+                }
+
+                m_contentBlock.reset();
+
                 BL_TASKS_HANDLER_END()
             }
 
@@ -267,6 +607,14 @@ namespace bl
 
         /**
          * @brief class HttpServerConnection
+         *
+         * If the client asks for a persistent connection ('Connection: keep-alive') then
+         * after the response is sent the connection goes back to RECEIVE for the next
+         * request (up to keepAliveMaxRequests requests and as long as the next request
+         * starts arriving within keepAliveIdleTimeout)
+         *
+         * Pipelined requests (sent before the previous response was received) are parsed
+         * from the data which was already read with the previous request
          */
 
         template
@@ -283,6 +631,13 @@ namespace bl
             typedef tasks::WrapperTaskBase                                                      base_type;
 
             typedef httpserver::detail::HttpParserResult                                        HttpParserResult;
+            typedef http::Parameters::HttpHeader                                                HttpHeader;
+
+            enum : std::size_t
+            {
+                KEEP_ALIVE_MAX_REQUESTS_DEFAULT = 100U,
+                KEEP_ALIVE_IDLE_TIMEOUT_IN_SECONDS_DEFAULT = 5U,
+            };
 
         protected:
 
@@ -303,19 +658,154 @@ namespace bl
             const om::ObjPtr< ServerBackendProcessing >                                         m_backend;
             State                                                                               m_state;
 
+            const om::ObjPtr< data::DataBlock >                                                 m_buffer;
+            const om::ObjPtr< Parser >                                                          m_parser;
+            const time::time_duration                                                           m_keepAliveIdleTimeout;
+            const std::size_t                                                                   m_keepAliveMaxRequests;
+            std::size_t                                                                         m_requestsCount;
+            bool                                                                                m_keepAlive;
+
             HttpServerConnection(
                 SAA_in          om::ObjPtr< ServerBackendProcessing >&&                         backend,
-                SAA_in          typename STREAM::stream_ref&&                                   connectedStream
+                SAA_in          typename STREAM::stream_ref&&                                   connectedStream,
+                SAA_in_opt      const time::time_duration&                                      keepAliveIdleTimeout =
+                    time::seconds( KEEP_ALIVE_IDLE_TIMEOUT_IN_SECONDS_DEFAULT ),
+                SAA_in_opt      const std::size_t                                               keepAliveMaxRequests =
+                    KEEP_ALIVE_MAX_REQUESTS_DEFAULT
                 )
                 :
                 m_backend( BL_PARAM_FWD( backend ) ),
-                m_state( RECEIVE )
+                m_state( RECEIVE ),
+                m_buffer( data::DataBlock::createInstance( receive_task_t::BUFFER_SIZE_DEFAULT ) ),
+                m_parser( Parser::createInstance() ),
+                m_keepAliveIdleTimeout( keepAliveIdleTimeout ),
+                m_keepAliveMaxRequests( keepAliveMaxRequests ),
+                m_requestsCount( 0U ),
+                m_keepAlive( false )
             {
-                m_receiveRequestTask = receive_task_t::createInstance( BL_PARAM_FWD( connectedStream ) );
+                /*
+                 * Pipelining only makes sense if persistent connections are enabled
+                 */
+
+                m_parser -> isPipeliningEnabled( m_keepAliveMaxRequests > 1U );
+
+                m_receiveRequestTask = receive_task_t::createInstance(
+                    BL_PARAM_FWD( connectedStream ),
+                    om::copy( m_buffer ),
+                    om::copy( m_parser )
+                    );
 
                 m_wrappedTask = om::qi< tasks::Task >( m_receiveRequestTask );
             }
 
+            void processReceivedRequest()
+            {
+                const auto parsingStatus = m_receiveRequestTask -> parsingStatus();
+
+                if( parsingStatus.first != HttpParserResult::PARSED )
+                {
+                    scheduleStdErrorResponse( parsingStatus.second /* exception */ );
+                }
+                else
+                {
+                    m_processingTask = m_backend -> getProcessingTask(
+                        om::copy( m_receiveRequestTask -> request() )
+                        );
+                    m_wrappedTask = om::qi< tasks::Task >( m_processingTask );
+                    m_state = PROCESS;
+                }
+            }
+
+            void scheduleResponse()
+            {
+                /*
+                 * Only clients which have asked for a persistent connection get the
+                 * 'Connection' header and for the last request allowed on the connection
+                 * they are told explicitly that the connection will be closed
+                 */
+
+                ++m_requestsCount;
+
+                const bool isKeepAliveRequested = m_receiveRequestTask -> request() -> isKeepAliveRequested();
+
+                auto response = m_backend -> getResponse( m_processingTask );
+
+                /*
+                 * A streamed response has no Content-Length and its content is delimited by
+                 * closing the connection, so it is always the last one on the connection
+                 */
+
+                m_keepAlive =
+                    isKeepAliveRequested &&
+                    m_requestsCount < m_keepAliveMaxRequests &&
+                    ! response -> isStreamed();
+
+                /*
+                 * If more requests were pipelined after a request which ends the connection
+                 * they are not going to be processed, so the client is told explicitly that
+                 * the connection is closed
+                 */
+
+                const bool hasDiscardedData = ! m_keepAlive && m_parser -> hasPendingData();
+
+                if( hasDiscardedData )
+                {
+                    BL_LOG(
+                        Logging::debug(),
+                        BL_MSG()
+                            << "The HTTP connection is closed and the data received after the last request is discarded; endpoint: "
+                            << m_receiveRequestTask -> safeRemoteEndpointId()
+                        );
+                }
+
+                std::string extraHeaders;
+
+                if( isKeepAliveRequested || hasDiscardedData )
+                {
+                    extraHeaders = HttpHeader::g_connection;
+                    extraHeaders += HttpHeader::g_nameSeparator;
+                    extraHeaders += HttpHeader::g_space;
+                    extraHeaders += m_keepAlive ? HttpHeader::g_keepAlive : HttpHeader::g_close;
+                    extraHeaders += HttpHeader::g_crlf;
+                }
+
+                m_sendResponseTask = send_task_t::createInstance(
+                    BL_PARAM_FWD( m_receiveRequestTask -> detachStream() ),
+                    std::move( response ),
+                    std::move( extraHeaders ),
+                    ! m_keepAlive /* closeStreamOnTaskFinish */
+                    );
+                m_wrappedTask = om::qi< tasks::Task >( m_sendResponseTask );
+                m_state = RESPOND;
+            }
+
+            void scheduleNextRequest()
+            {
+                m_receiveRequestTask = receive_task_t::createInstance(
+                    m_sendResponseTask -> detachStream(),
+                    om::copy( m_buffer ),
+                    om::copy( m_parser ),
+                    m_keepAliveIdleTimeout
+                    );
+
+                m_processingTask.reset();
+                m_sendResponseTask.reset();
+
+                if( m_receiveRequestTask -> tryParsePendingData() )
+                {
+                    /*
+                     * The next request was pipelined and it has been received already
+                     */
+
+                    processReceivedRequest();
+                }
+                else
+                {
+                    m_wrappedTask = om::qi< tasks::Task >( m_receiveRequestTask );
+                    m_state = RECEIVE;
+                }
+            }
+
             void scheduleStdErrorResponse( SAA_in const std::exception_ptr& eptr )
             {
                 const auto remoteEndpointId = m_receiveRequestTask -> safeRemoteEndpointId();
@@ -341,6 +831,7 @@ namespace bl
 
                 m_wrappedTask = om::qi< tasks::Task >( m_sendResponseTask );
                 m_state = RESPOND;
+                m_keepAlive = false;
             }
 
         public:
@@ -372,42 +863,37 @@ namespace bl
                 switch( m_state )
                 {
                     case RECEIVE:
+
+                        if( m_receiveRequestTask -> isConnectionClosed() )
                         {
-                            const auto parsingStatus = m_receiveRequestTask -> parsingStatus();
-
-                            if( parsingStatus.first != HttpParserResult::PARSED )
-                            {
-                                scheduleStdErrorResponse( parsingStatus.second /* exception */ );
-                            }
-                            else
-                            {
-                                m_processingTask = m_backend -> getProcessingTask(
-                                    om::copy( m_receiveRequestTask -> request() )
-                                    );
-                                m_wrappedTask = om::qi< tasks::Task >( m_processingTask );
-                                m_state = PROCESS;
-                            }
+                            /*
+                             * The persistent connection was closed while idle
+                             */
+
+                            return nullptr;
                         }
+
+                        processReceivedRequest();
                         break;
 
                     case PROCESS:
-                        {
-                            m_sendResponseTask = send_task_t::createInstance(
-                                BL_PARAM_FWD( m_receiveRequestTask -> detachStream() ),
-                                std::move( m_backend -> getResponse( m_processingTask ) )
-                                );
-                            m_wrappedTask = om::qi< tasks::Task >( m_sendResponseTask );
-                            m_state = RESPOND;
-                        }
+
+                        scheduleResponse();
                         break;
 
                     case RESPOND:
 
-                        /*
-                         * We are done
-                         */
+                        if( ! m_keepAlive )
+                        {
+                            /*
+                             * We are done
+                             */
 
-                        return nullptr;
+                            return nullptr;
+                        }
+
+                        scheduleNextRequest();
+                        break;
 
                     default:
 
@@ -443,29 +929,45 @@ namespace bl
             typedef tasks::TcpServerBase< STREAM, SERVERPOLICY >                                base_type;
             typedef typename STREAM::stream_ref                                                 stream_ref;
 
+            typedef HttpServerConnectionImpl< STREAM >                                          connection_t;
+
             const om::ObjPtr< ServerBackendProcessing >                                         m_backend;
+            const time::time_duration                                                           m_keepAliveIdleTimeout;
+            const std::size_t                                                                   m_keepAliveMaxRequests;
 
         protected:
 
+            /**
+             * @brief Passing keepAliveMaxRequests <= 1 disables persistent connections
+             */
+
             HttpServerT(
                 SAA_in      om::ObjPtr< ServerBackendProcessing >&&                             backend,
                 SAA_in      const om::ObjPtr< tasks::TaskControlTokenRW >&                      controlToken,
                 SAA_in      std::string&&                                                       host,
                 SAA_in      const unsigned short                                                port,
                 SAA_in      const std::string&                                                  privateKeyPem,
-                SAA_in      const std::string&                                                  certificatePem
+                SAA_in      const std::string&                                                  certificatePem,
+                SAA_in_opt  const time::time_duration&                                          keepAliveIdleTimeout =
+                    time::seconds( connection_t::KEEP_ALIVE_IDLE_TIMEOUT_IN_SECONDS_DEFAULT ),
+                SAA_in_opt  const std::size_t                                                   keepAliveMaxRequests =
+                    connection_t::KEEP_ALIVE_MAX_REQUESTS_DEFAULT
                 )
                 :
                 base_type( controlToken, BL_PARAM_FWD( host ), port, privateKeyPem, certificatePem ),
-                m_backend( BL_PARAM_FWD( backend ) )
+                m_backend( BL_PARAM_FWD( backend ) ),
+                m_keepAliveIdleTimeout( keepAliveIdleTimeout ),
+                m_keepAliveMaxRequests( keepAliveMaxRequests )
             {
             }
 
             virtual om::ObjPtr< tasks::Task > createConnection( SAA_inout stream_ref&& connectedStream ) OVERRIDE
             {
-                const auto connection = HttpServerConnectionImpl< STREAM >::createInstance(
+                const auto connection = connection_t::createInstance(
                     om::copy( m_backend ),
-                    BL_PARAM_FWD( connectedStream )
+                    BL_PARAM_FWD( connectedStream ),
+                    m_keepAliveIdleTimeout,
+                    m_keepAliveMaxRequests
                     );
 
                 return om::qi< tasks::Task >( connection );
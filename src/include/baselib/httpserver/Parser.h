@@ -23,6 +23,8 @@
 
 #include <baselib/http/Globals.h>
 
+#include <baselib/data/DataBlock.h>
+
 #include <baselib/core/ObjModel.h>
 #include <baselib/core/StringUtils.h>
 #include <baselib/core/Utils.h>
@@ -56,70 +58,50 @@ namespace bl
         protected:
 
             Context                                             m_context;
+            cpp::ScalarTypeIniter< bool >                       m_pipeliningEnabled;
 
-        public:
-
-            static const std::size_t                            g_maxHeadersSize;
-            static const std::size_t                            g_maxContentSize;
-
-            auto buildRequest() -> om::ObjPtr< Request >
-            {
-                BL_CHK(
-                    false,
-                    m_context.m_parsed,
-                    BL_MSG()
-                        << "The HTTP parser is expecting more data"
-                    );
-
-                auto request = Request::createInstance(
-                    std::move( m_context.m_method ),
-                    std::move( m_context.m_uri ),
-                    std::move( m_context.m_headers ),
-                    std::move( m_context.m_body )
-                    );
-
-                return request;
-            }
-
-            void reset()
+            auto bufferSize() const NOEXCEPT -> std::size_t
             {
-                m_context = Context();
+                return m_context.m_buffer ? m_context.m_buffer -> size() : 0U;
             }
 
-            auto parse(
+            void appendToBuffer(
                 SAA_in  const char*                             begin,
                 SAA_in  const char*                             end
-              )
-              -> ServerResult
+                )
             {
-                if( m_context.m_parsed )
-                {
-                    return ParserHelpers::serverError(
-                        BL_MSG()
-                            << "Unexpected input data: the HTTP request has been parsed already"
-                        );
-                }
+                const auto dataLength = static_cast< std::size_t >( end - begin );
 
-                BL_CHK(
-                    false,
-                    end > begin,
-                    BL_MSG()
-                        << "Unexpected input data: the HTTP parser called with an invalid data buffer"
-                    );
+                std::size_t size = 0U;
 
-                const auto bufferLength = m_context.m_buffer.size() + ( end - begin );
+                if( m_context.m_buffer )
+                {
+                    size = m_context.m_buffer -> size();
 
-                if( bufferLength > ( g_maxContentSize + g_maxHeadersSize ) )
+                    const auto capacity = m_context.m_buffer -> capacity();
+
+                    if( size + dataLength > capacity )
+                    {
+                        m_context.m_buffer -> reserve( std::max< std::size_t >( size + dataLength, 2U * capacity ) );
+                    }
+                }
+                else
                 {
-                    return ParserHelpers::serverError(
-                        BL_MSG()
-                            << "HTTP "
-                            << ( ! m_context.m_headersParsed ? "request" : "content" )
-                            <<  " size too large"
-                        );
+                    m_context.m_buffer = data::DataBlock::getForSize( nullptr /* dataBlocksPool */, dataLength );
                 }
 
-                m_context.m_buffer.append( begin, end );
+                std::memcpy( m_context.m_buffer -> begin() + size, begin, dataLength );
+
+                m_context.m_buffer -> setSize( size + dataLength );
+            }
+
+            auto parseBuffer() -> ServerResult
+            {
+                const auto bufferLength = bufferSize();
+
+                BL_ASSERT( bufferLength );
+
+                const char* data = m_context.m_buffer -> begin();
 
                 if( ! m_context.m_headersParsed )
                 {
@@ -127,7 +109,16 @@ namespace bl
                      * We need to parse the headers
                      */
 
-                    const auto posSentinel = m_context.m_buffer.find( HttpHeader::g_sentinel );
+                    const auto& sentinel = HttpHeader::g_sentinel;
+
+                    const auto sentinelPos =
+                        std::search( data, data + bufferLength, sentinel.c_str(), sentinel.c_str() + sentinel.size() );
+
+                    const auto posSentinel =
+                        sentinelPos == data + bufferLength ?
+                            std::string::npos
+                            :
+                            static_cast< std::size_t >( sentinelPos - data );
 
                     const auto currentHeadersSize =
                         posSentinel == std::string::npos ? bufferLength : posSentinel;
@@ -142,7 +133,7 @@ namespace bl
 
                     if( posSentinel == std::string::npos )
                     {
-                        if( bufferLength > 0 && ! ParserHelpers::isValidName( std::string{ m_context.m_buffer[ 0 ] } ) )
+                        if( ! ParserHelpers::isValidName( std::string{ data[ 0 ] } ) )
                         {
                             return ParserHelpers::serverError(
                                 BL_MSG()
@@ -153,8 +144,14 @@ namespace bl
                         return ParserHelpers::serverResult( HttpParserResult::MORE_DATA_REQUIRED );
                     }
 
+                    /*
+                     * Only the headers are copied out of the buffer (the body stays in the block)
+                     */
+
+                    const std::string headersText( data, posSentinel );
+
                     const auto headers = str::splitString(
-                        m_context.m_buffer,
+                        headersText,
                         HttpHeader::g_crlf,
                         0U,
                         posSentinel
@@ -227,16 +224,23 @@ namespace bl
                         );
                 }
 
-                if( bufferLength == m_context.m_maxRequestLength )
-                {
-                    if( m_context.m_expectedBodyLength > 0U )
-                    {
-                        m_context.m_body = m_context.m_buffer.substr(
-                            m_context.m_bodyBeginPos,
-                            m_context.m_expectedBodyLength
-                            );
-                    }
+                /*
+                 * The whole request is going to be received in the same block, so it is grown
+                 * once here rather than on each read
+                 */
+
+                m_context.m_buffer -> reserve( m_context.m_maxRequestLength );
+
+                /*
+                 * When pipelining is enabled the data after the end of the request belongs
+                 * to the next request(s) and it is left in the buffer for parseNext()
+                 */
 
+                if(
+                    bufferLength == m_context.m_maxRequestLength ||
+                    ( m_pipeliningEnabled && bufferLength > m_context.m_maxRequestLength )
+                    )
+                {
                     m_context.m_parsed = true;
 
                     return ParserHelpers::serverResult( HttpParserResult::PARSED );
@@ -253,6 +257,172 @@ namespace bl
                         << m_context.m_expectedBodyLength
                     );
             }
+
+        public:
+
+            static const std::size_t                            g_maxHeadersSize;
+            static const std::size_t                            g_maxContentSize;
+
+            auto buildRequest() -> om::ObjPtr< Request >
+            {
+                BL_CHK(
+                    false,
+                    m_context.m_parsed,
+                    BL_MSG()
+                        << "The HTTP parser is expecting more data"
+                    );
+
+                /*
+                 * The body is not copied, but the request holds a slice of the input buffer
+                 */
+
+                om::ObjPtr< data::DataBlock > bodyBlock;
+
+                if( m_context.m_expectedBodyLength )
+                {
+                    bodyBlock = om::copy( m_context.m_buffer );
+                    m_context.m_isBufferShared = true;
+                }
+
+                auto request = Request::createInstance(
+                    std::move( m_context.m_method ),
+                    std::move( m_context.m_uri ),
+                    std::move( m_context.m_headers ),
+                    std::move( bodyBlock ),
+                    m_context.m_bodyBeginPos,
+                    m_context.m_expectedBodyLength
+                    );
+
+                return request;
+            }
+
+            void reset()
+            {
+                m_context = Context();
+            }
+
+            bool isPipeliningEnabled() const NOEXCEPT
+            {
+                return m_pipeliningEnabled;
+            }
+
+            /**
+             * @brief Allows the input buffer to contain more than one request (e.g. for
+             * persistent connections where the client does not wait for the response)
+             */
+
+            void isPipeliningEnabled( SAA_in const bool pipeliningEnabled ) NOEXCEPT
+            {
+                m_pipeliningEnabled = pipeliningEnabled;
+            }
+
+            /**
+             * @brief Returns true if a parsed request is followed by data which belongs
+             * to the next request
+             */
+
+            bool hasPendingData() const NOEXCEPT
+            {
+                return m_context.m_parsed && bufferSize() > m_context.m_maxRequestLength;
+            }
+
+            /**
+             * @brief Prepares the parser for the next request on the same connection
+             *
+             * The data following the last parsed request (if any) is parsed right away and
+             * the input buffer is kept, so its capacity is reused for the next request, unless
+             * it is shared with the last request (i.e. its body) in which case only the pending
+             * data is copied into a new buffer
+             */
+
+            auto parseNext() -> ServerResult
+            {
+                auto buffer = std::move( m_context.m_buffer );
+
+                const bool isBufferShared = m_context.m_isBufferShared;
+
+                const auto size = buffer ? buffer -> size() : 0U;
+                const auto consumed = m_context.m_parsed ? m_context.m_maxRequestLength : size;
+                const auto pendingSize = size - consumed;
+
+                reset();
+
+                if( pendingSize )
+                {
+                    if( isBufferShared )
+                    {
+                        auto newBuffer = data::DataBlock::getForSize( nullptr /* dataBlocksPool */, pendingSize );
+
+                        std::memcpy( newBuffer -> begin(), buffer -> begin() + consumed, pendingSize );
+
+                        buffer = std::move( newBuffer );
+                    }
+                    else
+                    {
+                        std::memmove( buffer -> begin(), buffer -> begin() + consumed, pendingSize );
+                    }
+
+                    buffer -> setSize( pendingSize );
+                }
+                else if( buffer )
+                {
+                    if( isBufferShared )
+                    {
+                        buffer.reset();
+                    }
+                    else
+                    {
+                        buffer -> setSize( 0U );
+                    }
+                }
+
+                m_context.m_buffer = std::move( buffer );
+
+                if( ! pendingSize )
+                {
+                    return ParserHelpers::serverResult( HttpParserResult::MORE_DATA_REQUIRED );
+                }
+
+                return parseBuffer();
+            }
+
+            auto parse(
+                SAA_in  const char*                             begin,
+                SAA_in  const char*                             end
+              )
+              -> ServerResult
+            {
+                if( m_context.m_parsed )
+                {
+                    return ParserHelpers::serverError(
+                        BL_MSG()
+                            << "Unexpected input data: the HTTP request has been parsed already"
+                        );
+                }
+
+                BL_CHK(
+                    false,
+                    end > begin,
+                    BL_MSG()
+                        << "Unexpected input data: the HTTP parser called with an invalid data buffer"
+                    );
+
+                const auto bufferLength = bufferSize() + ( end - begin );
+
+                if( bufferLength > ( g_maxContentSize + g_maxHeadersSize ) )
+                {
+                    return ParserHelpers::serverError(
+                        BL_MSG()
+                            << "HTTP "
+                            << ( ! m_context.m_headersParsed ? "request" : "content" )
+                            <<  " size too large"
+                        );
+                }
+
+                appendToBuffer( begin, end );
+
+                return parseBuffer();
+            }
         };
 
         typedef om::ObjectImpl< ParserT<> > Parser;
@@ -19,7 +19,10 @@
 
 #include <baselib/http/Globals.h>
 
+#include <baselib/data/DataBlock.h>
+
 #include <baselib/core/ObjModel.h>
+#include <baselib/core/StringUtils.h>
 #include <baselib/core/BaseIncludes.h>
 
 namespace bl
@@ -28,6 +31,10 @@ namespace bl
     {
         /**
          * @brief class Request
+         *
+         * The body is not owned as a string, but it is a slice of a data block (normally the
+         * block the request was received into by the parser), so it is never copied on the
+         * receive path (it is only copied into a string if body() is called)
          */
 
         template
@@ -38,6 +45,7 @@ namespace bl
         {
         public:
 
+            typedef http::Parameters::HttpHeader                HttpHeader;
             typedef http::HeadersMap                            HeadersMap;
 
         private:
@@ -45,7 +53,28 @@ namespace bl
             const std::string                                   m_method;
             const std::string                                   m_uri;
             HeadersMap                                          m_headers;
-            const std::string                                   m_body;
+            om::ObjPtr< data::DataBlock >                       m_bodyBlock;
+            std::size_t                                         m_bodyOffset;
+            std::size_t                                         m_bodySize;
+
+            mutable os::mutex                                   m_lock;
+            mutable cpp::ScalarTypeIniter< bool >               m_isBodyMaterialized;
+            mutable std::string                                 m_body;
+
+            static auto createBodyBlock( SAA_in const std::string& body ) -> om::ObjPtr< data::DataBlock >
+            {
+                if( body.empty() )
+                {
+                    return nullptr;
+                }
+
+                auto block = data::DataBlock::getForSize( nullptr /* dataBlocksPool */, body.size() );
+
+                std::memcpy( block -> begin(), body.c_str(), body.size() );
+                block -> setSize( body.size() );
+
+                return block;
+            }
 
         protected:
 
@@ -59,8 +88,39 @@ namespace bl
                 m_method( BL_PARAM_FWD( method ) ),
                 m_uri( BL_PARAM_FWD( uri ) ),
                 m_headers( BL_PARAM_FWD( headers ) ),
-                m_body( BL_PARAM_FWD( body ) )
+                m_bodyBlock( createBodyBlock( body ) ),
+                m_bodyOffset( 0U ),
+                m_bodySize( body.size() )
+            {
+            }
+
+            /**
+             * @brief Creates a request which body is the slice [bodyOffset, bodyOffset + bodySize)
+             * of the specified data block (the block is shared and must not be modified after)
+             */
+
+            RequestT(
+                SAA_in      std::string&&                       method,
+                SAA_in      std::string&&                       uri,
+                SAA_in      HeadersMap&&                        headers,
+                SAA_in      om::ObjPtr< data::DataBlock >&&     bodyBlock,
+                SAA_in      const std::size_t                   bodyOffset,
+                SAA_in      const std::size_t                   bodySize
+                )
+                :
+                m_method( BL_PARAM_FWD( method ) ),
+                m_uri( BL_PARAM_FWD( uri ) ),
+                m_headers( BL_PARAM_FWD( headers ) ),
+                m_bodyBlock( BL_PARAM_FWD( bodyBlock ) ),
+                m_bodyOffset( bodyOffset ),
+                m_bodySize( bodySize )
             {
+                BL_CHK(
+                    false,
+                    m_bodySize == 0U || ( m_bodyBlock && m_bodyOffset + m_bodySize <= m_bodyBlock -> size() ),
+                    BL_MSG()
+                        << "The HTTP request body is outside of the data block"
+                    );
             }
 
         public:
@@ -80,10 +140,91 @@ namespace bl
                 return m_headers;
             }
 
-            auto body() const NOEXCEPT -> const std::string&
+            /**
+             * @brief Returns the body as a string - the string is copied from the data block on
+             * the first call only, but bodyData() / bodySize() should be preferred when the body
+             * can be large
+             */
+
+            auto body() const -> const std::string&
             {
+                BL_MUTEX_GUARD( m_lock );
+
+                if( ! m_isBodyMaterialized )
+                {
+                    if( m_bodySize )
+                    {
+                        m_body.assign( bodyData(), m_bodySize );
+                    }
+
+                    m_isBodyMaterialized = true;
+                }
+
                 return m_body;
             }
+
+            auto bodyData() const NOEXCEPT -> const char*
+            {
+                return m_bodySize ? m_bodyBlock -> begin() + m_bodyOffset : nullptr;
+            }
+
+            auto bodySize() const NOEXCEPT -> std::size_t
+            {
+                return m_bodySize;
+            }
+
+            auto bodyOffset() const NOEXCEPT -> std::size_t
+            {
+                return m_bodyOffset;
+            }
+
+            /**
+             * @brief The data block holding the body (it can be nullptr if the body is empty)
+             */
+
+            auto bodyBlock() const NOEXCEPT -> const om::ObjPtr< data::DataBlock >&
+            {
+                return m_bodyBlock;
+            }
+
+            /**
+             * @brief Returns true if the client has asked for a persistent connection
+             * (i.e. 'Connection: keep-alive' as we only speak HTTP/1.0)
+             *
+             * The header name is case-insensitive and its value is a comma separated list
+             * of tokens (e.g. 'Keep-Alive, Upgrade'); the 'close' token always wins
+             */
+
+            bool isKeepAliveRequested() const
+            {
+                bool keepAlive = false;
+
+                for( const auto& header : m_headers )
+                {
+                    if( ! str::iequals( header.first, HttpHeader::g_connection ) )
+                    {
+                        continue;
+                    }
+
+                    std::vector< std::string > tokens;
+
+                    str::split( tokens, header.second, str::is_equal_to( ',' ) );
+
+                    for( auto& token : tokens )
+                    {
+                        str::trim( token );
+
+                        if( str::iequals( token, HttpHeader::g_close ) )
+                        {
+                            return false;
+                        }
+
+                        keepAlive = keepAlive || str::iequals( token, HttpHeader::g_keepAlive );
+                    }
+                }
+
+                return keepAlive;
+            }
         };
 
         typedef om::ObjectImpl< RequestT<> > Request;
@@ -19,6 +19,8 @@
 
 #include <baselib/http/Globals.h>
 
+#include <baselib/data/DataBlock.h>
+
 #include <baselib/core/ObjModel.h>
 #include <baselib/core/BaseIncludes.h>
 
@@ -28,6 +30,22 @@ namespace bl
     {
         /**
          * @brief class HttpResponse
+         *
+         * The response is not serialized into a single string, but it is kept as three parts
+         * (the status line, the serialized headers and the content) which are sent as a
+         * scatter-gather buffer sequence, so the content is never copied
+         *
+         * The content can also be provided as a sequence of data blocks (e.g. the blocks the
+         * payload was received or read into) and then each block is sent as is, so the content
+         * doesn't have to be copied into a single contiguous string
+         *
+         * For large payloads the response can be streamed - i.e. the content is provided by a
+         * producer callback which the send task pulls the content blocks from one at a time
+         * while writing (only after the previous block has been written), so the content never
+         * has to exist in memory as a whole
+         *
+         * Since we only speak HTTP/1.0 (i.e. no chunked transfer encoding) a streamed response
+         * has no Content-Length header and its content is delimited by closing the connection
          */
 
         template
@@ -41,20 +59,54 @@ namespace bl
             typedef http::Parameters::HttpHeader                                HttpHeader;
             typedef http::HeadersMap                                            HeadersMap;
             typedef http::Parameters::HttpStatusCode                            HttpStatusCode;
+            typedef std::vector< om::ObjPtr< data::DataBlock > >                content_blocks_t;
+
+            /**
+             * @brief The content producer of a streamed response returns the next content block
+             * or nullptr when the content is complete
+             *
+             * It is invoked on the I/O thread once the previous block has been written, so it
+             * must not block, and it may return the same block each time (after refilling it)
+             */
+
+            typedef cpp::function< om::ObjPtr< data::DataBlock > () >           content_producer_t;
 
         private:
 
             const HttpStatusCode                                                m_status;
 
             const std::string                                                   m_content;
+            const content_blocks_t                                              m_contentBlocks;
+            const content_producer_t                                            m_contentProducer;
+            const std::size_t                                                   m_contentSize;
 
             HeadersMap                                                          m_headers;
 
-            std::string                                                         m_serialized;
+            std::string                                                         m_serializedHeaders;
+
+            static auto getContentSize( SAA_in const content_blocks_t& contentBlocks ) -> std::size_t
+            {
+                std::size_t contentSize = 0U;
+
+                for( const auto& block : contentBlocks )
+                {
+                    BL_CHK(
+                        false,
+                        nullptr != block,
+                        BL_MSG()
+                            << "HTTP response content blocks cannot be nullptr"
+                        );
+
+                    contentSize += block -> size();
+                }
+
+                return contentSize;
+            }
 
             static auto getRequiredHeaders(
-                SAA_in      const std::string&                                  content,
-                SAA_in      std::string&&                                       contentType
+                SAA_in      const std::size_t                                   contentSize,
+                SAA_in      std::string&&                                       contentType,
+                SAA_in_opt  const bool                                          isStreamed = false
                 )
                 -> HeadersMap
             {
@@ -64,10 +116,13 @@ namespace bl
                     HttpHeader::g_contentType,
                     BL_PARAM_FWD( contentType ) );
 
-                headers.emplace(
-                    HttpHeader::g_contentLength,
-                    utils::lexical_cast< std::string >( content.size() )
-                    );
+                if( ! isStreamed )
+                {
+                    headers.emplace(
+                        HttpHeader::g_contentLength,
+                        utils::lexical_cast< std::string >( contentSize )
+                        );
+                }
 
                 return headers;
             }
@@ -92,9 +147,10 @@ namespace bl
                 :
                 m_status( status ),
                 m_content( getStockResponse( status ) ),
-                m_headers( getRequiredHeaders( m_content, cpp::copy( HttpHeader::g_contentTypeDefault ) ) )
+                m_contentSize( m_content.size() ),
+                m_headers( getRequiredHeaders( m_contentSize, cpp::copy( HttpHeader::g_contentTypeDefault ) ) )
             {
-                m_serialized = buildResponse();
+                m_serializedHeaders = buildHeaders();
             }
 
             ResponseT(
@@ -106,13 +162,69 @@ namespace bl
                 :
                 m_status( status ),
                 m_content( BL_PARAM_FWD( content ) ),
-                m_headers(
-                    getRequiredHeaders( m_content,
+                m_contentSize( m_content.size() )
+            {
+                initHeaders( BL_PARAM_FWD( contentType ), BL_PARAM_FWD( customHeaders ) );
+            }
+
+            /**
+             * @brief Creates a response with content blocks - the content is the data of the
+             * blocks (from the beginning of each block up to its size) in the order provided
+             */
+
+            ResponseT(
+                SAA_in          const HttpStatusCode                            status,
+                SAA_in          content_blocks_t&&                              contentBlocks,
+                SAA_in_opt      std::string&&                                   contentType = std::string(),
+                SAA_in_opt      HeadersMap&&                                    customHeaders = HeadersMap()
+                )
+                :
+                m_status( status ),
+                m_contentBlocks( BL_PARAM_FWD( contentBlocks ) ),
+                m_contentSize( getContentSize( m_contentBlocks ) )
+            {
+                initHeaders( BL_PARAM_FWD( contentType ), BL_PARAM_FWD( customHeaders ) );
+            }
+
+            /**
+             * @brief Creates a streamed response - the content is pulled from the producer while
+             * the response is being sent (see content_producer_t above)
+             */
+
+            ResponseT(
+                SAA_in          const HttpStatusCode                            status,
+                SAA_in          content_producer_t&&                            contentProducer,
+                SAA_in_opt      std::string&&                                   contentType = std::string(),
+                SAA_in_opt      HeadersMap&&                                    customHeaders = HeadersMap()
+                )
+                :
+                m_status( status ),
+                m_contentProducer( BL_PARAM_FWD( contentProducer ) ),
+                m_contentSize( 0U )
+            {
+                BL_CHK(
+                    false,
+                    ! m_contentProducer.empty(),
+                    BL_MSG()
+                        << "HTTP response content producer cannot be empty"
+                    );
+
+                initHeaders( BL_PARAM_FWD( contentType ), BL_PARAM_FWD( customHeaders ) );
+            }
+
+            void initHeaders(
+                SAA_in          std::string&&                                   contentType,
+                SAA_in          HeadersMap&&                                    customHeaders
+                )
+            {
+                m_headers = getRequiredHeaders(
+                    m_contentSize,
                     contentType.empty() ?
                         cpp::copy( HttpHeader::g_contentTypeDefault ) :
-                        BL_PARAM_FWD( contentType ) )
-                    )
-            {
+                        BL_PARAM_FWD( contentType ),
+                    isStreamed()
+                    );
+
                 for( auto& header : customHeaders )
                 {
                     const auto pair = m_headers.emplace( std::move( header ) );
@@ -130,50 +242,87 @@ namespace bl
                         );
                 }
 
-                m_serialized = buildResponse();
+                m_serializedHeaders = buildHeaders();
             }
 
-            auto buildResponse() const -> std::string
-            {
-                cpp::SafeOutputStringStream oss;
-
-                /*
-                 * Get the string for the status code (the string ends with \r\n)
-                 */
+            /**
+             * @brief Serializes the headers followed by the empty line separating them from
+             * the content (i.e. everything between the status line and the content)
+             */
 
-                oss << http::StatusStrings::get( m_status );
+            auto buildHeaders() const -> std::string
+            {
+                std::size_t size = HttpHeader::g_crlf.size();
 
                 for( const auto& header : m_headers )
                 {
-                    oss
-                        << header.first
-                        << HttpHeader::g_nameSeparator
-                        << HttpHeader::g_space
-                        << header.second
-                        << HttpHeader::g_crlf;
+                    size +=
+                        header.first.size() +
+                        2U /* name separator and space */ +
+                        header.second.size() +
+                        HttpHeader::g_crlf.size();
                 }
 
-                /*
-                 * Add the empty line separating the headers from the content
-                 */
+                std::string serialized;
 
-                oss << HttpHeader::g_crlf;
+                serialized.reserve( size );
 
-                if( ! m_content.empty() )
+                for( const auto& header : m_headers )
                 {
-                    oss << m_content;
+                    serialized += header.first;
+                    serialized += HttpHeader::g_nameSeparator;
+                    serialized += HttpHeader::g_space;
+                    serialized += header.second;
+                    serialized += HttpHeader::g_crlf;
                 }
 
-                return oss.str();
+                serialized += HttpHeader::g_crlf;
+
+                return serialized;
             }
 
         public:
 
+            /**
+             * @brief The content of the response (it is empty if the response has content blocks
+             * or if it is streamed)
+             */
+
             auto content() const NOEXCEPT -> const std::string&
             {
                 return m_content;
             }
 
+            auto contentBlocks() const NOEXCEPT -> const content_blocks_t&
+            {
+                return m_contentBlocks;
+            }
+
+            auto contentProducer() const NOEXCEPT -> const content_producer_t&
+            {
+                return m_contentProducer;
+            }
+
+            /**
+             * @brief The size of the content (it is zero if the response is streamed as the size
+             * is not known upfront)
+             */
+
+            auto contentSize() const NOEXCEPT -> std::size_t
+            {
+                return m_contentSize;
+            }
+
+            bool hasContentBlocks() const NOEXCEPT
+            {
+                return ! m_contentBlocks.empty();
+            }
+
+            bool isStreamed() const NOEXCEPT
+            {
+                return ! m_contentProducer.empty();
+            }
+
             auto status() const NOEXCEPT -> HttpStatusCode
             {
                 return m_status;
@@ -184,9 +333,47 @@ namespace bl
                 return m_headers;
             }
 
-            auto getSerialized() const NOEXCEPT -> const std::string&
+            /**
+             * @brief The status line (the string ends with \r\n)
+             */
+
+            auto getStatusLine() const -> const std::string&
+            {
+                return http::StatusStrings::get( m_status );
+            }
+
+            auto getSerializedHeaders() const NOEXCEPT -> const std::string&
             {
-                return m_serialized;
+                return m_serializedHeaders;
+            }
+
+            /**
+             * @brief Returns the entire response as a single string
+             *
+             * The string is built (i.e. the content is copied) on each call, so it should only
+             * be used for diagnostics - the send path writes the parts above instead
+             *
+             * The content of a streamed response is not included as it can only be produced once
+             */
+
+            auto getSerialized() const -> std::string
+            {
+                const auto& statusLine = getStatusLine();
+
+                std::string serialized;
+
+                serialized.reserve( statusLine.size() + m_serializedHeaders.size() + m_contentSize );
+
+                serialized += statusLine;
+                serialized += m_serializedHeaders;
+                serialized += m_content;
+
+                for( const auto& block : m_contentBlocks )
+                {
+                    serialized.append( block -> begin(), block -> size() );
+                }
+
+                return serialized;
             }
         };
 
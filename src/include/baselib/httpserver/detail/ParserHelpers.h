@@ -19,6 +19,9 @@
 
 #include <baselib/http/Globals.h>
 
+#include <baselib/data/DataBlock.h>
+
+#include <baselib/core/ObjModel.h>
 #include <baselib/core/StringUtils.h>
 #include <baselib/core/BaseIncludes.h>
 
@@ -52,12 +55,17 @@ namespace bl
                 std::string                                                         m_method;
                 std::string                                                         m_uri;
                 http::HeadersMap                                                    m_headers;
-                std::string                                                         m_body;
 
-                std::string                                                         m_buffer;
+                /*
+                 * The raw request data - once the request is built the body is a slice of
+                 * this block and then the block is shared with the request
+                 */
+
+                om::ObjPtr< data::DataBlock >                                       m_buffer;
 
                 bool                                                                m_headersParsed;
                 bool                                                                m_parsed;
+                bool                                                                m_isBufferShared;
 
                 std::size_t                                                         m_bodyBeginPos;
                 std::size_t                                                         m_expectedBodyLength;
@@ -67,6 +75,7 @@ namespace bl
                     :
                     m_headersParsed( false ),
                     m_parsed( false ),
+                    m_isBufferShared( false ),
                     m_bodyBeginPos( 0U ),
                     m_expectedBodyLength( 0U ),
                     m_maxRequestLength( 0U )
@@ -180,6 +180,26 @@ namespace bl
 
                     case OperationId::Get:
                         {
+                            /*
+                             * If the storage can map the chunk data directly we use that block
+                             * instead of copying the data (and there is nothing to clear too)
+                             */
+
+                            auto mappedData =
+                                base_type::impl() -> readStorage() -> tryLoadMapped( m_sessionId, m_chunkId );
+
+                            if( mappedData )
+                            {
+                                if( m_data )
+                                {
+                                    base_type::impl() -> deallocateBlock( base_type::detachData() );
+                                }
+
+                                m_data = std::move( mappedData );
+
+                                break;
+                            }
+
                             handleAlloc( true /* isSecure */ );
 
                             base_type::impl() -> readStorage() -> load( m_sessionId, m_chunkId, m_data );
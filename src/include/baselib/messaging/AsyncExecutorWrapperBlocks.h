@@ -114,16 +114,22 @@ namespace bl
                 m_blockCapacity = blockCapacity;
             }
 
-            auto allocateBlock() const -> om::ObjPtr< data::DataBlock >
+            /**
+             * @brief Allocates a block with the configured block capacity or if the size of the
+             * data is known upfront (sizeHint) from the smallest size class which can fit it
+             */
+
+            auto allocateBlock( SAA_in_opt const std::size_t sizeHint = 0U ) const -> om::ObjPtr< data::DataBlock >
             {
-                auto newBlock = m_dataBlocksPool -> tryGet();
+                const auto capacity =
+                    sizeHint && sizeHint <= m_blockCapacity ?
+                        std::min( data::DataBlock::capacityForSize( sizeHint ), m_blockCapacity )
+                        :
+                        m_blockCapacity;
 
-                if( ! newBlock )
-                {
-                    newBlock = data::DataBlock::createInstance( m_blockCapacity );
-                }
+                auto newBlock = data::DataBlock::get( m_dataBlocksPool, capacity );
 
-                BL_ASSERT( newBlock -> capacity() == m_blockCapacity );
+                BL_ASSERT( newBlock -> capacity() == capacity );
 
                 newBlock -> reset();
 
@@ -135,7 +141,24 @@ namespace bl
                 BL_NOEXCEPT_BEGIN()
 
                 BL_ASSERT( block );
-                BL_ASSERT( block -> capacity() == m_blockCapacity );
+
+                if( block -> isExternal() )
+                {
+                    /*
+                     * External blocks (e.g. memory mapped chunks) are not pooled, releasing
+                     * the block releases the external memory
+                     */
+
+                    block.reset();
+
+                    return;
+                }
+
+                /*
+                 * Note that the block capacity can be different than m_blockCapacity as the blocks
+                 * can be allocated from a smaller size class or grown after allocation; the pool
+                 * will return the block to the respective size class
+                 */
 
                 block -> reset();
 
@@ -207,6 +230,7 @@ namespace bl
             uuid_t                                                                          m_sourcePeerId;
             uuid_t                                                                          m_targetPeerId;
             cpp::ScalarTypeIniter< CommandId >                                              m_commandId;
+            cpp::ScalarTypeIniter< std::size_t >                                            m_dataSizeHint;
 
             AsyncOperationStateBlockBaseT()
                 :
@@ -235,6 +259,7 @@ namespace bl
                 m_sourcePeerId = uuids::nil();
                 m_targetPeerId = uuids::nil();
                 m_commandId = CommandId::None;
+                m_dataSizeHint = 0U;
             }
 
             void data( SAA_in om::ObjPtr< data::DataBlock >&& data ) NOEXCEPT
@@ -246,7 +271,7 @@ namespace bl
             {
                 if( ! m_data )
                 {
-                    m_data = impl() -> allocateBlock();
+                    m_data = impl() -> allocateBlock( m_dataSizeHint );
                 }
 
                 if( isSecure )
@@ -363,6 +388,21 @@ namespace bl
                 m_commandId = commandId;
             }
 
+            /**
+             * @brief The size of the data if it is known upfront (or zero) - it is used to allocate
+             * the block from the smallest size class which can fit the data
+             */
+
+            std::size_t dataSizeHint() const NOEXCEPT
+            {
+                return m_dataSizeHint;
+            }
+
+            void dataSizeHint( SAA_in const std::size_t dataSizeHint ) NOEXCEPT
+            {
+                m_dataSizeHint = dataSizeHint;
+            }
+
             /**************************************************************************************
              * AsyncOperationState implementation
              */
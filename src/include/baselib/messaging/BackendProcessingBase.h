@@ -76,11 +76,12 @@ namespace bl
                 BL_NOEXCEPT_END()
             }
 
-            void validateParameters(
+            static void validateParameters(
                 SAA_in                  const OperationId                               operationId,
                 SAA_in                  const CommandId                                 commandId,
                 SAA_in                  const bl::uuid_t&                               sessionId,
-                SAA_in                  const bl::uuid_t&                               chunkId
+                SAA_in                  const bl::uuid_t&                               chunkId,
+                SAA_in_opt              const om::Proxy*                                hostServices
                 )
             {
                 BL_CHK(
@@ -95,12 +96,22 @@ namespace bl
 
                 BL_CHK(
                     false,
-                    nullptr != m_hostServices,
+                    nullptr != hostServices,
                     BL_MSG()
                         << "Host services are not configured properly"
                     );
             }
 
+            void validateParameters(
+                SAA_in                  const OperationId                               operationId,
+                SAA_in                  const CommandId                                 commandId,
+                SAA_in                  const bl::uuid_t&                               sessionId,
+                SAA_in                  const bl::uuid_t&                               chunkId
+                )
+            {
+                validateParameters( operationId, commandId, sessionId, chunkId, m_hostServices.get() );
+            }
+
             template
             <
                 typename SERVICE,
@@ -20,6 +20,7 @@
 #include <baselib/messaging/BackendProcessingBase.h>
 #include <baselib/messaging/BrokerErrorCodes.h>
 #include <baselib/messaging/AsyncBlockDispatcher.h>
+#include <baselib/messaging/BrokerProtocolRoutingInfo.h>
 
 #include <baselib/data/models/JsonMessaging.h>
 
@@ -39,6 +40,22 @@ namespace bl
          * The "logical target peer id" is the target peer id of a client which is behind
          * proxy / multiplexer while the "physical peer id" is the peer id of the proxy /
          * multiplexer client connection
+         *
+         * The cache is consulted for every routed message, but it is only modified when
+         * clients behind a proxy connect or disconnect, so the read path takes no locks
+         * and does no atomic read-modify-write operations (not even a shared lock)
+         *
+         * The map is split into shards by the hash of the target peer id and each shard
+         * is an open addressing hash table protected by a sequence lock - the writers
+         * are serialized by a per shard mutex and bump the sequence number before and
+         * after each modification, while the readers only load the sequence number
+         * before and after the lookup and retry if it has changed in the meantime
+         *
+         * All table slots are atomics, so the concurrent reads are well defined even
+         * when they observe a partially updated slot (such results are discarded). When
+         * a shard table has to grow the old table is retired, but not freed, as a reader
+         * may still be probing it - the retired tables are at most as large as the
+         * current table in total and they are freed when the cache is destroyed
          */
 
         template
@@ -49,10 +66,332 @@ namespace bl
         {
             BL_CTR_DEFAULT( PeerIdRoutingCacheT, protected )
 
+        public:
+
+            enum : std::size_t
+            {
+                SHARDS_COUNT_BITS = 6U,
+                SHARDS_COUNT = 1U << SHARDS_COUNT_BITS,
+                SHARD_CAPACITY_INITIAL = 16U,
+            };
+
         protected:
 
-            std::unordered_map< uuid_t, uuid_t >                                    m_routingTable;
-            mutable os::shared_mutex                                                m_lock;
+            enum : std::size_t
+            {
+                CACHE_LINE_SIZE = 64U,
+            };
+
+            enum : std::uint64_t
+            {
+                SLOT_EMPTY = 0U,
+                SLOT_USED = 1U,
+                SLOT_DELETED = 2U,
+            };
+
+            typedef std::array< std::uint64_t, 2U >                                 words_t;
+
+            struct Slot
+            {
+                std::atomic< std::uint64_t >                                        state;
+                std::atomic< std::uint64_t >                                        key[ 2U ];
+                std::atomic< std::uint64_t >                                        value[ 2U ];
+
+                Slot() NOEXCEPT
+                    :
+                    state( SLOT_EMPTY )
+                {
+                    key[ 0U ].store( 0U, std::memory_order_relaxed );
+                    key[ 1U ].store( 0U, std::memory_order_relaxed );
+                    value[ 0U ].store( 0U, std::memory_order_relaxed );
+                    value[ 1U ].store( 0U, std::memory_order_relaxed );
+                }
+            };
+
+            struct Table
+            {
+                const std::size_t                                                   capacity;
+                cpp::SafeUniquePtr< Slot[] >                                        slots;
+
+                /*
+                 * The counters below are only accessed by the writers (under the shard lock)
+                 */
+
+                std::size_t                                                         used;
+                std::size_t                                                         deleted;
+
+                Table( SAA_in const std::size_t capacity )
+                    :
+                    capacity( capacity ),
+                    slots( cpp::SafeUniquePtr< Slot[] >::attach( new Slot[ capacity ] ) ),
+                    used( 0U ),
+                    deleted( 0U )
+                {
+                }
+            };
+
+            struct Shard
+            {
+                std::atomic< std::uint64_t >                                        sequence;
+                std::atomic< Table* >                                               table;
+                char                                                                padding[ CACHE_LINE_SIZE ];
+
+                os::mutex                                                           lock;
+                std::vector< cpp::SafeUniquePtr< Table > >                          tables;
+
+                Shard()
+                    :
+                    sequence( 0U ),
+                    table( nullptr )
+                {
+                    BL_UNUSED( padding );
+
+                    tables.emplace_back( cpp::SafeUniquePtr< Table >::attach( new Table( SHARD_CAPACITY_INITIAL ) ) );
+                    table.store( tables.back().get(), std::memory_order_release );
+                }
+            };
+
+            std::array< Shard, SHARDS_COUNT >                                       m_shards;
+
+            static std::size_t getHash( SAA_in const uuid_t& peerId ) NOEXCEPT
+            {
+                return std::hash< uuid_t >()( peerId );
+            }
+
+            static words_t toWords( SAA_in const uuid_t& peerId ) NOEXCEPT
+            {
+                static_assert( sizeof( words_t ) == sizeof( uuid_t ), "uuid_t must be 16 bytes" );
+
+                words_t words;
+                std::memcpy( words.data(), &peerId, sizeof( words ) );
+
+                return words;
+            }
+
+            static uuid_t fromWords( SAA_in const words_t& words ) NOEXCEPT
+            {
+                uuid_t peerId;
+                std::memcpy( &peerId, words.data(), sizeof( words ) );
+
+                return peerId;
+            }
+
+            Shard& getShard( SAA_in const std::size_t hash ) NOEXCEPT
+            {
+                return m_shards[ hash & ( SHARDS_COUNT - 1U ) ];
+            }
+
+            const Shard& getShard( SAA_in const std::size_t hash ) const NOEXCEPT
+            {
+                return m_shards[ hash & ( SHARDS_COUNT - 1U ) ];
+            }
+
+            static std::size_t getStartIndex(
+                SAA_in          const Table&                                        table,
+                SAA_in          const std::size_t                                   hash
+                ) NOEXCEPT
+            {
+                /*
+                 * The low bits of the hash were already used to select the shard
+                 */
+
+                return ( hash >> SHARDS_COUNT_BITS ) & ( table.capacity - 1U );
+            }
+
+            static bool isKey(
+                SAA_in          const Slot&                                         slot,
+                SAA_in          const words_t&                                      key
+                ) NOEXCEPT
+            {
+                return
+                    slot.key[ 0U ].load( std::memory_order_relaxed ) == key[ 0U ] &&
+                    slot.key[ 1U ].load( std::memory_order_relaxed ) == key[ 1U ];
+            }
+
+            /**
+             * @brief Finds the slot of a key; it is also used by the readers, so it must
+             * tolerate inconsistent slot values (the probing is bounded by the capacity)
+             */
+
+            static Slot* findSlot(
+                SAA_in          const Table&                                        table,
+                SAA_in          const std::size_t                                   hash,
+                SAA_in          const words_t&                                      key
+                ) NOEXCEPT
+            {
+                auto index = getStartIndex( table, hash );
+
+                for( std::size_t i = 0U; i < table.capacity; ++i )
+                {
+                    auto& slot = table.slots[ index ];
+
+                    const auto state = slot.state.load( std::memory_order_relaxed );
+
+                    if( SLOT_EMPTY == state )
+                    {
+                        break;
+                    }
+
+                    if( SLOT_USED == state && isKey( slot, key ) )
+                    {
+                        return &slot;
+                    }
+
+                    index = ( index + 1U ) & ( table.capacity - 1U );
+                }
+
+                return nullptr;
+            }
+
+            static void storeSlot(
+                SAA_inout       Slot&                                               slot,
+                SAA_in          const words_t&                                      key,
+                SAA_in          const words_t&                                      value
+                ) NOEXCEPT
+            {
+                slot.key[ 0U ].store( key[ 0U ], std::memory_order_relaxed );
+                slot.key[ 1U ].store( key[ 1U ], std::memory_order_relaxed );
+                slot.value[ 0U ].store( value[ 0U ], std::memory_order_relaxed );
+                slot.value[ 1U ].store( value[ 1U ], std::memory_order_relaxed );
+                slot.state.store( SLOT_USED, std::memory_order_relaxed );
+            }
+
+            /**
+             * @brief Inserts a key which is known not to be in the table and the table
+             * is known to have a free slot (the caller must hold the shard lock)
+             */
+
+            static void insertSlot(
+                SAA_inout       Table&                                              table,
+                SAA_in          const std::size_t                                   hash,
+                SAA_in          const words_t&                                      key,
+                SAA_in          const words_t&                                      value
+                ) NOEXCEPT
+            {
+                auto index = getStartIndex( table, hash );
+
+                for( ;; )
+                {
+                    auto& slot = table.slots[ index ];
+
+                    const auto state = slot.state.load( std::memory_order_relaxed );
+
+                    if( SLOT_USED != state )
+                    {
+                        if( SLOT_DELETED == state )
+                        {
+                            BL_ASSERT( table.deleted );
+                            --table.deleted;
+                        }
+
+                        storeSlot( slot, key, value );
+                        ++table.used;
+
+                        return;
+                    }
+
+                    index = ( index + 1U ) & ( table.capacity - 1U );
+                }
+            }
+
+            /**
+             * @brief Ensures there is room for one more key - either by moving the keys
+             * into a new larger table or by purging the deleted slots of the current table
+             * in place (the caller must hold the shard lock and be in the write section)
+             */
+
+            static void reserveSlot( SAA_inout Shard& shard )
+            {
+                auto* table = shard.table.load( std::memory_order_relaxed );
+
+                /*
+                 * Keep the load factor (including the deleted slots) at or below 3/4
+                 */
+
+                if( 4U * ( table -> used + table -> deleted + 1U ) <= 3U * table -> capacity )
+                {
+                    return;
+                }
+
+                std::vector< std::pair< words_t, words_t > > entries;
+                entries.reserve( table -> used );
+
+                for( std::size_t i = 0U; i < table -> capacity; ++i )
+                {
+                    const auto& slot = table -> slots[ i ];
+
+                    if( SLOT_USED == slot.state.load( std::memory_order_relaxed ) )
+                    {
+                        entries.emplace_back(
+                            words_t {{
+                                slot.key[ 0U ].load( std::memory_order_relaxed ),
+                                slot.key[ 1U ].load( std::memory_order_relaxed )
+                                }},
+                            words_t {{
+                                slot.value[ 0U ].load( std::memory_order_relaxed ),
+                                slot.value[ 1U ].load( std::memory_order_relaxed )
+                                }}
+                            );
+                    }
+                }
+
+                if( 2U * ( table -> used + 1U ) > table -> capacity )
+                {
+                    /*
+                     * The table is genuinely full - the old table is retired (but kept
+                     * alive as readers may still be probing it) and a new one is published
+                     */
+
+                    shard.tables.reserve( shard.tables.size() + 1U );
+
+                    shard.tables.emplace_back(
+                        cpp::SafeUniquePtr< Table >::attach( new Table( 2U * table -> capacity ) )
+                        );
+
+                    table = shard.tables.back().get();
+                }
+                else
+                {
+                    /*
+                     * Mostly deleted slots - just rehash in place
+                     */
+
+                    for( std::size_t i = 0U; i < table -> capacity; ++i )
+                    {
+                        table -> slots[ i ].state.store( SLOT_EMPTY, std::memory_order_relaxed );
+                    }
+
+                    table -> used = 0U;
+                    table -> deleted = 0U;
+                }
+
+                for( const auto& entry : entries )
+                {
+                    insertSlot( *table, getHash( fromWords( entry.first ) ), entry.first, entry.second );
+                }
+
+                shard.table.store( table, std::memory_order_release );
+            }
+
+            static std::uint64_t beginWrite( SAA_inout Shard& shard ) NOEXCEPT
+            {
+                const auto sequence = shard.sequence.load( std::memory_order_relaxed );
+
+                BL_ASSERT( 0U == ( sequence & 1U ) );
+
+                shard.sequence.store( sequence + 1U, std::memory_order_relaxed );
+                std::atomic_thread_fence( std::memory_order_release );
+
+                return sequence;
+            }
+
+            static void endWrite(
+                SAA_inout       Shard&                                              shard,
+                SAA_in          const std::uint64_t                                 sequence
+                ) NOEXCEPT
+            {
+                shard.sequence.store( sequence + 2U, std::memory_order_release );
+            }
 
         public:
 
@@ -61,30 +400,105 @@ namespace bl
                 SAA_in_opt          const uuid_t&                                   targetPeerId
                 )
             {
-                os::unique_lock< decltype( m_lock ) > exclusiveLock( m_lock );
+                const auto hash = getHash( targetPeerId );
+                const auto key = toWords( targetPeerId );
+                const auto value = toWords( sourcePeerId );
+
+                auto& shard = getShard( hash );
+
+                BL_MUTEX_GUARD( shard.lock );
+
+                const auto sequence = beginWrite( shard );
+
+                BL_SCOPE_EXIT(
+                    {
+                        endWrite( shard, sequence );
+                    }
+                    );
 
-                m_routingTable[ targetPeerId ] = sourcePeerId;
+                auto* slot = findSlot( *shard.table.load( std::memory_order_relaxed ), hash, key );
+
+                if( slot )
+                {
+                    slot -> value[ 0U ].store( value[ 0U ], std::memory_order_relaxed );
+                    slot -> value[ 1U ].store( value[ 1U ], std::memory_order_relaxed );
+
+                    return;
+                }
+
+                reserveSlot( shard );
+
+                insertSlot( *shard.table.load( std::memory_order_relaxed ), hash, key, value );
             }
 
             bool dissociateTargetPeerId( SAA_in const uuid_t& targetPeerId )
             {
-                os::unique_lock< decltype( m_lock ) > exclusiveLock( m_lock );
+                const auto hash = getHash( targetPeerId );
+                const auto key = toWords( targetPeerId );
+
+                auto& shard = getShard( hash );
+
+                BL_MUTEX_GUARD( shard.lock );
+
+                auto* table = shard.table.load( std::memory_order_relaxed );
 
-                return 0U != m_routingTable.erase( targetPeerId );
+                auto* slot = findSlot( *table, hash, key );
+
+                if( ! slot )
+                {
+                    return false;
+                }
+
+                const auto sequence = beginWrite( shard );
+
+                slot -> state.store( SLOT_DELETED, std::memory_order_relaxed );
+
+                --table -> used;
+                ++table -> deleted;
+
+                endWrite( shard, sequence );
+
+                return true;
             }
 
             auto tryResolveTargetPeerId( SAA_in_opt const uuid_t& targetPeerId ) const -> uuid_t
             {
-                os::shared_lock< decltype( m_lock ) > sharedLock( m_lock );
+                const auto hash = getHash( targetPeerId );
+                const auto key = toWords( targetPeerId );
 
-                const auto pos = m_routingTable.find( targetPeerId );
+                const auto& shard = getShard( hash );
 
-                if( pos != m_routingTable.end() )
+                for( ;; )
                 {
-                    return pos -> second;
-                }
+                    const auto sequence = shard.sequence.load( std::memory_order_acquire );
+
+                    if( sequence & 1U )
+                    {
+                        /*
+                         * A writer is modifying the shard - the write sections are short
+                         */
+
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    const auto* slot = findSlot( *shard.table.load( std::memory_order_acquire ), hash, key );
+
+                    words_t value {{ 0U, 0U }};
 
-                return uuids::nil();
+                    if( slot )
+                    {
+                        value[ 0U ] = slot -> value[ 0U ].load( std::memory_order_relaxed );
+                        value[ 1U ] = slot -> value[ 1U ].load( std::memory_order_relaxed );
+                    }
+
+                    std::atomic_thread_fence( std::memory_order_acquire );
+
+                    if( shard.sequence.load( std::memory_order_relaxed ) == sequence )
+                    {
+                        return slot ? fromWords( value ) : uuids::nil();
+                    }
+                }
             }
         };
 
@@ -123,6 +537,7 @@ namespace bl
             const uuid_t                                                            m_sourcePeerId;
             uuid_t                                                                  m_targetPeerId;
 
+            BrokerProtocolRoutingInfo                                               m_routingInfo;
             om::ObjPtr< BrokerProtocol >                                            m_brokerProtocol;
 
             om::ObjPtr< SecurityPrincipal >                                         m_principal;
@@ -165,35 +580,235 @@ namespace bl
             {
                 BL_ASSERT( m_peerIdRoutingCache );
 
-                m_wrappedTask =
-                    SimpleTaskImpl::createInstance< Task >(
-                        cpp::bind( &this_type::parseAndProcessProtocolData, this )
-                        );
+                m_wrappedTask =
+                    SimpleTaskImpl::createInstance< Task >(
+                        cpp::bind( &this_type::parseAndProcessProtocolData, this )
+                        );
+            }
+
+            void serializeBrokerProtocolMessage( SAA_in_opt const std::string* principalIdentityInfoJson = nullptr )
+            {
+                if( m_routingInfo.isParsed() )
+                {
+                    ( void ) m_routingInfo.updateInBlock(
+                        m_data,
+                        m_sourcePeerId,
+                        m_targetPeerId,
+                        principalIdentityInfoJson
+                        );
+
+                    return;
+                }
+
+                MessagingUtils::updateBrokerProtocolMessageInBlock(
+                    m_brokerProtocol,
+                    m_data,
+                    m_sourcePeerId,
+                    m_targetPeerId
+                    );
+            }
+
+            void routeMessage(
+                SAA_in              const MessageType::Enum                         messageType,
+                SAA_in              const bool                                      hasSourcePeerId,
+                SAA_in              const uuid_t&                                   sourcePeerId,
+                SAA_in              const bool                                      hasTargetPeerId,
+                SAA_in              const uuid_t&                                   targetPeerId
+                )
+            {
+                /*
+                 * Check if this is an associate / dissociate target peer id message which
+                 * are meant for broker processing
+                 */
+
+                m_isBackendOnlyMessage = true;
+
+                switch( messageType )
+                {
+                    default:
+                        m_isBackendOnlyMessage = false;
+                        break;
+
+                    case MessageType::BackendAssociateTargetPeerId:
+                    {
+                        BL_CHK_SERVER_ERROR(
+                            true,
+                            ! hasSourcePeerId || ! hasTargetPeerId,
+                            BrokerErrorCodes::ProtocolValidationFailed,
+                            BL_MSG()
+                                << "The sourcePeerId and targetPeerId properties cannot be empty"
+                            );
+
+                        /*
+                         * Note that we want to allow target peer id routing *only* for target
+                         * peer ids which have not already connected directly to this backend
+                         *
+                         * Otherwise the proxy might try to keep trying to associate stale peer id
+                         * which has disconnected and connected directly to the broker
+                         *
+                         * Note also that for these cases we don't want to fail the message as it
+                         * is an expected situation (since the proxy can keep trying to associate
+                         * stale peer ids after they have disconnected)
+                         */
+
+                        BL_ASSERT( m_hostServices );
+
+                        os::mutex_unique_lock guard;
+
+                        const auto blockDispatcher =
+                            m_hostServices -> tryAcquireRef< dispatcher_t >( dispatcher_t::iid(), &guard );
+
+                        BL_CHK(
+                            false,
+                            nullptr != blockDispatcher,
+                            BL_MSG()
+                                << "Host services do not provide block dispatching service"
+                            );
+
+                        const auto targetQueue =
+                            blockDispatcher -> tryGetMessageBlockCompletionQueue( targetPeerId );
+
+                        if( targetQueue )
+                        {
+                            BL_LOG(
+                                Logging::trace(),
+                                BL_MSG()
+                                    << "Associate message for peer id "
+                                    << str::quoteString( uuids::uuid2string( targetPeerId ) )
+                                    << " was ignored as it is directly connected to the backend"
+                                );
+                        }
+                        else
+                        {
+                            m_peerIdRoutingCache -> associateTargetPeerId( sourcePeerId, targetPeerId );
+                        }
+                    }
+                    break;
+
+                    case MessageType::BackendDissociateTargetPeerId:
+                    {
+                        BL_CHK_SERVER_ERROR(
+                            true,
+                            ! hasTargetPeerId,
+                            BrokerErrorCodes::ProtocolValidationFailed,
+                            BL_MSG()
+                                << "The targetPeerId property cannot be empty"
+                            );
+
+                        ( void ) m_peerIdRoutingCache -> dissociateTargetPeerId( targetPeerId );
+                    }
+                    break;
+                }
+
+                if( ! m_isBackendOnlyMessage )
+                {
+                    m_resolvedTargetPeerId = m_peerIdRoutingCache -> tryResolveTargetPeerId( m_targetPeerId );
+                }
+            }
+
+            bool completeIfAuthorizationNotRequired( SAA_in const bool hasPrincipalIdentityInfo )
+            {
+                if( m_isBackendOnlyMessage || ! hasPrincipalIdentityInfo )
+                {
+                    /*
+                     * This message is broker only message or it does not carry authentication info -
+                     * we are done with the broker processing
+                     *
+                     * Note that we only serialize back the broker protocol message if it is not
+                     * meant for the broker backend
+                     *
+                     * If the message is for the broker backend (i.e. isBackendOnlyMessage=true) then
+                     * the message is IN only and there is no output data to be passed back to the
+                     * block dispatcher
+                     */
+
+                    if( m_isBackendOnlyMessage )
+                    {
+                        m_state = Process;
+                    }
+                    else
+                    {
+                        m_state = Dispatch;
+                        serializeBrokerProtocolMessage();
+                    }
+
+                    return true;
+                }
+
+                return false;
+            }
+
+            void authorizeToken(
+                SAA_in              const std::string&                              tokenType,
+                SAA_in              const std::string&                              cookiesText
+                )
+            {
+                BL_CHK_SERVER_ERROR(
+                    false,
+                    m_authorizationCache -> tokenType() == tokenType,
+                    BrokerErrorCodes::ProtocolValidationFailed,
+                    BL_MSG()
+                        << "The specified authentication token type "
+                        << str::quoteString( tokenType )
+                        << " is invalid or not supported"
+                    );
+
+                m_authenticationToken = AuthorizationCache::createAuthenticationToken( cookiesText );
+
+                m_principal = m_authorizationCache -> tryGetAuthorizedPrinciplal( m_authenticationToken );
+
+                if( ! m_principal )
+                {
+                    /*
+                     * The cache is not populated for this credential, so we need to do actual authorization
+                     * with the authorization service
+                     */
+
+                    m_authorizationTask = m_authorizationCache -> createAuthorizationTask( m_authenticationToken );
+                }
             }
 
-            void serializeBrokerProtocolMessage()
+            void parseAndProcessProtocolData()
             {
-                MessagingUtils::updateBrokerProtocolMessageInBlock(
-                    m_brokerProtocol,
-                    m_data,
-                    m_sourcePeerId,
-                    m_targetPeerId
+                /*
+                 * The JSON protocol messages are first scanned on the routing fast path which only
+                 * extracts the properties needed for routing and then patches the message in place
+                 *
+                 * Everything which the fast path does not handle (binary protocol messages, invalid
+                 * messages, etc.) is fully deserialized and validated on the slow path
+                 */
+
+                if( ! m_routingInfo.tryParse( m_data ) )
+                {
+                    parseProtocolMessage();
+
+                    return;
+                }
+
+                routeMessage(
+                    m_routingInfo.messageType(),
+                    m_routingInfo.hasSourcePeerId(),
+                    m_routingInfo.sourcePeerId(),
+                    m_routingInfo.hasTargetPeerId(),
+                    m_routingInfo.targetPeerId()
                     );
+
+                if( completeIfAuthorizationNotRequired( m_routingInfo.hasPrincipalIdentityInfo() ) )
+                {
+                    return;
+                }
+
+                authorizeToken( m_routingInfo.tokenType(), m_routingInfo.tokenData() );
             }
 
-            void parseAndProcessProtocolData()
+            void parseProtocolMessage()
             {
                 using namespace dm::messaging;
 
                 const auto protocolDataOffset = m_data -> offset1();
 
-                const std::string protocolData(
-                    m_data -> begin() + protocolDataOffset,
-                    m_data -> size() - protocolDataOffset
-                    );
-
                 /*
-                 * First we validate the message is in the expected JSON format
+                 * First we validate the message is in the expected format (JSON or binary)
                  */
 
                 m_brokerProtocol =  BrokerProtocol::createInstance();
@@ -202,8 +817,10 @@ namespace bl
                     "Error while trying to parse broker protocol message",
                     [ & ]() -> void
                     {
-                        m_brokerProtocol =
-                            dm::DataModelUtils::loadFromJsonText< BrokerProtocol >( protocolData );
+                        m_brokerProtocol = MessagingUtils::deserializeBrokerProtocol(
+                            m_data -> begin() + protocolDataOffset,
+                            m_data -> size() - protocolDataOffset
+                            );
                     },
                     []() -> void
                     {
@@ -304,121 +921,18 @@ namespace bl
                     targetPeerId = validateAsUuid( targetPeerIdAsString );
                 }
 
-                /*
-                 * Check if this is an associate / dissociate target peer id message which
-                 * are meant for broker processing
-                 */
-
-                m_isBackendOnlyMessage = true;
-
-                switch( messageType )
-                {
-                    default:
-                        m_isBackendOnlyMessage = false;
-                        break;
-
-                    case MessageType::BackendAssociateTargetPeerId:
-                    {
-                        BL_CHK_SERVER_ERROR(
-                            true,
-                            sourcePeerIdAsString.empty() || targetPeerIdAsString.empty(),
-                            BrokerErrorCodes::ProtocolValidationFailed,
-                            BL_MSG()
-                                << "The sourcePeerId and targetPeerId properties cannot be empty"
-                            );
-
-                        /*
-                         * Note that we want to allow target peer id routing *only* for target
-                         * peer ids which have not already connected directly to this backend
-                         *
-                         * Otherwise the proxy might try to keep trying to associate stale peer id
-                         * which has disconnected and connected directly to the broker
-                         *
-                         * Note also that for these cases we don't want to fail the message as it
-                         * is an expected situation (since the proxy can keep trying to associate
-                         * stale peer ids after they have disconnected)
-                         */
-
-                        BL_ASSERT( m_hostServices );
-
-                        os::mutex_unique_lock guard;
-
-                        const auto blockDispatcher =
-                            m_hostServices -> tryAcquireRef< dispatcher_t >( dispatcher_t::iid(), &guard );
-
-                        BL_CHK(
-                            false,
-                            nullptr != blockDispatcher,
-                            BL_MSG()
-                                << "Host services do not provide block dispatching service"
-                            );
-
-                        const auto targetQueue =
-                            blockDispatcher -> tryGetMessageBlockCompletionQueue( targetPeerId );
-
-                        if( targetQueue )
-                        {
-                            BL_LOG(
-                                Logging::trace(),
-                                BL_MSG()
-                                    << "Associate message for peer id "
-                                    << str::quoteString( uuids::uuid2string( targetPeerId ) )
-                                    << " was ignored as it is directly connected to the backend"
-                                );
-                        }
-                        else
-                        {
-                            m_peerIdRoutingCache -> associateTargetPeerId( sourcePeerId, targetPeerId );
-                        }
-                    }
-                    break;
-
-                    case MessageType::BackendDissociateTargetPeerId:
-                    {
-                        BL_CHK_SERVER_ERROR(
-                            true,
-                            targetPeerIdAsString.empty(),
-                            BrokerErrorCodes::ProtocolValidationFailed,
-                            BL_MSG()
-                                << "The targetPeerId property cannot be empty"
-                            );
-
-                        ( void ) m_peerIdRoutingCache -> dissociateTargetPeerId( targetPeerId );
-                    }
-                    break;
-                }
-
-                if( ! m_isBackendOnlyMessage )
-                {
-                    m_resolvedTargetPeerId = m_peerIdRoutingCache -> tryResolveTargetPeerId( m_targetPeerId );
-                }
+                routeMessage(
+                    messageType,
+                    ! sourcePeerIdAsString.empty()                  /* hasSourcePeerId */,
+                    sourcePeerId,
+                    ! targetPeerIdAsString.empty()                  /* hasTargetPeerId */,
+                    targetPeerId
+                    );
 
                 const auto& principalIdentityInfo = m_brokerProtocol -> principalIdentityInfo();
 
-                if( m_isBackendOnlyMessage || ! principalIdentityInfo )
+                if( completeIfAuthorizationNotRequired( nullptr != principalIdentityInfo ) )
                 {
-                    /*
-                     * This message is broker only message or it does not carry authentication info -
-                     * we are done with the broker processing
-                     *
-                     * Note that we only serialize back the broker protocol message if it is not
-                     * meant for the broker backend
-                     *
-                     * If the message is for the broker backend (i.e. isBackendOnlyMessage=true) then
-                     * the message is IN only and there is no output data to be passed back to the
-                     * block dispatcher
-                     */
-
-                    if( m_isBackendOnlyMessage )
-                    {
-                        m_state = Process;
-                    }
-                    else
-                    {
-                        m_state = Dispatch;
-                        serializeBrokerProtocolMessage();
-                    }
-
                     return;
                 }
 
@@ -442,33 +956,7 @@ namespace bl
                         << "Authentication token information is required"
                     );
 
-                const auto& tokenType = authenticationToken -> type();
-
-                BL_CHK_SERVER_ERROR(
-                    false,
-                    m_authorizationCache -> tokenType() == tokenType,
-                    BrokerErrorCodes::ProtocolValidationFailed,
-                    BL_MSG()
-                        << "The specified authentication token type "
-                        << str::quoteString( tokenType )
-                        << " is invalid or not supported"
-                    );
-
-                const auto& cookiesText = authenticationToken -> data();
-
-                m_authenticationToken = AuthorizationCache::createAuthenticationToken( cookiesText );
-
-                m_principal = m_authorizationCache -> tryGetAuthorizedPrinciplal( m_authenticationToken );
-
-                if( ! m_principal )
-                {
-                    /*
-                     * The cache is not populated for this credential, so we need to do actual authorization
-                     * with the authorization service
-                     */
-
-                    m_authorizationTask = m_authorizationCache -> createAuthorizationTask( m_authenticationToken );
-                }
+                authorizeToken( authenticationToken -> type(), authenticationToken -> data() );
             }
 
             void postAuthorization()
@@ -485,6 +973,22 @@ namespace bl
 
                 BL_ASSERT( m_principal );
 
+                if( m_routingInfo.isParsed() )
+                {
+                    /*
+                     * On the fast path only the principal identity info is encoded and it replaces
+                     * the original one in place
+                     */
+
+                    const auto principalIdentityInfoJson = dm::DataModelUtils::getDocAsPackedJsonString(
+                        createAuthorizedPrincipalIdentityInfo( m_principal )
+                        );
+
+                    serializeBrokerProtocolMessage( &principalIdentityInfoJson );
+
+                    return;
+                }
+
                 authorizeProtocolMessage( m_brokerProtocol, m_principal );
 
                 serializeBrokerProtocolMessage();
@@ -613,10 +1117,8 @@ namespace bl
              * code too much, but it should be moved to MessageHelpers in subsequent PRs
              */
 
-            static void authorizeProtocolMessage(
-                SAA_in                  const om::ObjPtr< BrokerProtocol >&             brokerProtocol,
-                SAA_in                  const om::ObjPtr< SecurityPrincipal >&          principal
-                )
+            static auto createAuthorizedPrincipalIdentityInfo( SAA_in const om::ObjPtr< SecurityPrincipal >& principal )
+                -> om::ObjPtr< PrincipalIdentityInfo >
             {
                 auto securityPrincipal = dm::messaging::SecurityPrincipal::createInstance();
 
@@ -625,14 +1127,19 @@ namespace bl
                 securityPrincipal -> familyName( principal -> familyName() );
                 securityPrincipal -> email( principal -> email() );
 
-                if( nullptr == brokerProtocol -> principalIdentityInfo() )
-                {
-                    const auto principalIdentityInfo = PrincipalIdentityInfo::createInstance();
-                    brokerProtocol -> principalIdentityInfo( principalIdentityInfo );
-                }
+                auto principalIdentityInfo = PrincipalIdentityInfo::createInstance();
+
+                principalIdentityInfo -> securityPrincipal( std::move( securityPrincipal ) );
+
+                return principalIdentityInfo;
+            }
 
-                brokerProtocol -> principalIdentityInfo() -> authenticationToken( nullptr );
-                brokerProtocol -> principalIdentityInfo() -> securityPrincipal( std::move( securityPrincipal ) );
+            static void authorizeProtocolMessage(
+                SAA_in                  const om::ObjPtr< BrokerProtocol >&             brokerProtocol,
+                SAA_in                  const om::ObjPtr< SecurityPrincipal >&          principal
+                )
+            {
+                brokerProtocol -> principalIdentityInfo( createAuthorizedPrincipalIdentityInfo( principal ) );
             }
         };
 
@@ -669,13 +1176,84 @@ namespace bl
             const om::ObjPtr< PeerIdRoutingCache >                                      m_peerIdRoutingCache;
             const om::ObjPtr< AuthorizationCache >                                      m_authorizationCache;
 
+            /*
+             * The host services are needed for every incoming block, but they only change when
+             * the backend is installed and disposed, so they are published as an atomic snapshot
+             * and createBackendProcessingTask() does not need to take m_lock
+             *
+             * The snapshot is only a raw pointer to the proxy held by m_hostServices, so a reader
+             * registers in the reader count of the current epoch before it loads the snapshot and
+             * until it has taken its own reference; when the snapshot is replaced the epoch is
+             * advanced and the old proxy is released only after the readers of the previous epoch
+             * are gone (the readers which registered in the new epoch can only load the new proxy)
+             */
+
+            std::atomic< om::Proxy* >                                                   m_hostServicesSnapshot;
+            std::atomic< std::uint64_t >                                                m_snapshotEpoch;
+            std::atomic< std::size_t >                                                  m_snapshotReaders[ 2U ];
+
         protected:
 
             BrokerBackendProcessingT( SAA_in om::ObjPtr< AuthorizationCache >&& authorizationCache )
                 :
                 m_peerIdRoutingCache( PeerIdRoutingCache::createInstance() ),
-                m_authorizationCache( BL_PARAM_FWD( authorizationCache ) )
+                m_authorizationCache( BL_PARAM_FWD( authorizationCache ) ),
+                m_hostServicesSnapshot( nullptr ),
+                m_snapshotEpoch( 0U )
+            {
+                m_snapshotReaders[ 0U ] = 0U;
+                m_snapshotReaders[ 1U ] = 0U;
+            }
+
+            /**
+             * @brief Replaces the host services snapshot and waits for the readers which could
+             * still be referencing the previous proxy (must be called under m_lock)
+             *
+             * Once this returns the previous proxy can be released
+             */
+
+            void publishHostServicesSnapshot( SAA_in_opt om::Proxy* hostServices ) NOEXCEPT
+            {
+                m_hostServicesSnapshot.store( hostServices );
+
+                const auto epoch = m_snapshotEpoch.fetch_add( 1U );
+
+                while( m_snapshotReaders[ epoch & 1U ].load() )
+                {
+                    /*
+                     * The readers only take a reference to the proxy, so they are gone shortly
+                     */
+
+                    std::this_thread::yield();
+                }
+            }
+
+            auto acquireHostServicesSnapshot() NOEXCEPT -> om::ObjPtr< om::Proxy >
             {
+                for( ;; )
+                {
+                    const auto epoch = m_snapshotEpoch.load();
+
+                    auto& readers = m_snapshotReaders[ epoch & 1U ];
+
+                    ++readers;
+
+                    /*
+                     * If the epoch has not changed after registering as a reader then the writer
+                     * which advances it next is going to wait for this reader
+                     */
+
+                    if( epoch == m_snapshotEpoch.load() )
+                    {
+                        auto hostServices = om::copy( m_hostServicesSnapshot.load() );
+
+                        --readers;
+
+                        return hostServices;
+                    }
+
+                    --readers;
+                }
             }
 
         public:
@@ -684,6 +1262,32 @@ namespace bl
              * BackendProcessing implementation
              */
 
+            virtual void dispose() NOEXCEPT OVERRIDE
+            {
+                BL_NOEXCEPT_BEGIN()
+
+                BL_MUTEX_GUARD( m_lock );
+
+                publishHostServicesSnapshot( nullptr );
+
+                base_type::disposeInternal();
+
+                BL_NOEXCEPT_END()
+            }
+
+            virtual void setHostServices( SAA_in om::ObjPtr< om::Proxy >&& hostServices ) NOEXCEPT OVERRIDE
+            {
+                BL_NOEXCEPT_BEGIN()
+
+                BL_MUTEX_GUARD( m_lock );
+
+                publishHostServicesSnapshot( hostServices.get() );
+
+                m_hostServices = BL_PARAM_FWD( hostServices );
+
+                BL_NOEXCEPT_END()
+            }
+
             virtual bool autoBlockDispatching() const NOEXCEPT OVERRIDE
             {
                 return false;
@@ -700,12 +1304,17 @@ namespace bl
                 )
                 -> om::ObjPtr< tasks::Task > OVERRIDE
                 {
-                    BL_MUTEX_GUARD( m_lock );
+                    /*
+                     * This is called for every incoming block on the I/O threads of all connections,
+                     * so it must not take any locks (see m_hostServicesSnapshot above)
+                     */
+
+                    auto hostServices = acquireHostServicesSnapshot();
 
-                    base_type::validateParameters( operationId, commandId, sessionId, chunkId );
+                    base_type::validateParameters( operationId, commandId, sessionId, chunkId, hostServices.get() );
 
                     return BrokerBackendTask::createInstance< tasks::Task >(
-                        m_hostServices,
+                        std::move( hostServices ),
                         m_peerIdRoutingCache,
                         m_authorizationCache,
                         data,
@@ -0,0 +1,778 @@
+/*
+ * This file is part of the swblocks-baselib library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __BL_MESSAGING_BROKERPROTOCOLROUTINGINFO_H_
+#define __BL_MESSAGING_BROKERPROTOCOLROUTINGINFO_H_
+
+#include <baselib/messaging/MessagingCommonTypes.h>
+
+#include <baselib/data/DataBlock.h>
+
+#include <baselib/core/JsonStreamReader.h>
+#include <baselib/core/Uuid.h>
+#include <baselib/core/ObjModel.h>
+#include <baselib/core/BaseIncludes.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace bl
+{
+    namespace messaging
+    {
+        /**
+         * @brief class BrokerProtocolRoutingInfo - the routing fast path for broker protocol messages
+         *
+         * It scans the JSON broker protocol data at the tail of a message block and extracts only
+         * the properties which are needed for routing (the message type, ids, peer ids and the
+         * authentication token) without building a BrokerProtocol object. The peer ids and the
+         * principal identity info can then be updated by patching the JSON text in place
+         *
+         * tryParse() returns false for anything the fast path does not handle (binary protocol
+         * data, escaped or malformed values, missing required properties, etc.), in which case
+         * the caller is expected to fall back to the full deserialization which also produces
+         * the appropriate validation errors
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class BrokerProtocolRoutingInfoT
+        {
+        public:
+
+            typedef json::StreamReader::view_t                                      view_t;
+
+        protected:
+
+            enum : std::size_t
+            {
+                UUID_STRING_LENGTH = 36U,
+                NO_VALUE = static_cast< std::size_t >( -1 ),
+            };
+
+            /**
+             * @brief The location of a property value in the protocol data; offset is NO_VALUE if
+             * the property is not present and length is 0 if its value is empty (or null)
+             */
+
+            struct ValueLocation
+            {
+                std::size_t                                                         offset;
+                std::size_t                                                         length;
+                bool                                                                isEmpty;
+            };
+
+            struct Edit
+            {
+                std::size_t                                                         offset;
+                std::size_t                                                         length;
+                std::string                                                         text;
+            };
+
+            MessageType::Enum                                                       m_messageType;
+            uuid_t                                                                  m_messageId;
+            uuid_t                                                                  m_conversationId;
+            uuid_t                                                                  m_sourcePeerId;
+            uuid_t                                                                  m_targetPeerId;
+            std::string                                                             m_tokenType;
+            std::string                                                             m_tokenData;
+
+            ValueLocation                                                           m_sourcePeerIdValue;
+            ValueLocation                                                           m_targetPeerIdValue;
+            ValueLocation                                                           m_principalIdentityInfoValue;
+            cpp::ScalarTypeIniter< std::size_t >                                    m_closingBraceOffset;
+            cpp::ScalarTypeIniter< std::size_t >                                    m_protocolDataSize;
+            cpp::ScalarTypeIniter< bool >                                           m_isParsed;
+
+            static bool isKey(
+                SAA_in              const view_t&                                   key,
+                SAA_in              const char*                                     name
+                ) NOEXCEPT
+            {
+                const auto length = std::strlen( name );
+
+                return key.second == length && 0 == std::memcmp( key.first, name, length );
+            }
+
+            static int hexDigitValue( SAA_in const char ch ) NOEXCEPT
+            {
+                if( ch >= '0' && ch <= '9' )
+                {
+                    return ch - '0';
+                }
+
+                if( ch >= 'a' && ch <= 'f' )
+                {
+                    return ch - 'a' + 10;
+                }
+
+                if( ch >= 'A' && ch <= 'F' )
+                {
+                    return ch - 'A' + 10;
+                }
+
+                return -1;
+            }
+
+            static bool isDashPosition( SAA_in const std::size_t pos ) NOEXCEPT
+            {
+                return 8U == pos || 13U == pos || 18U == pos || 23U == pos;
+            }
+
+            /**
+             * @brief Parses a UUID in the canonical 8-4-4-4-12 form; anything else is left
+             * to uuids::string2uuid() on the slow path
+             */
+
+            static bool tryParseUuid(
+                SAA_in              const view_t&                                   value,
+                SAA_out             uuid_t&                                         uuid
+                ) NOEXCEPT
+            {
+                if( UUID_STRING_LENGTH != value.second )
+                {
+                    return false;
+                }
+
+                std::size_t byte = 0U;
+
+                for( std::size_t pos = 0U; pos < UUID_STRING_LENGTH; )
+                {
+                    if( isDashPosition( pos ) )
+                    {
+                        if( '-' != value.first[ pos ] )
+                        {
+                            return false;
+                        }
+
+                        ++pos;
+
+                        continue;
+                    }
+
+                    const auto high = hexDigitValue( value.first[ pos ] );
+                    const auto low = hexDigitValue( value.first[ pos + 1U ] );
+
+                    if( high < 0 || low < 0 )
+                    {
+                        return false;
+                    }
+
+                    uuid.data[ byte++ ] = static_cast< std::uint8_t >( ( high << 4 ) | low );
+
+                    pos += 2U;
+                }
+
+                return true;
+            }
+
+            static void appendQuotedUuid(
+                SAA_inout           std::string&                                    text,
+                SAA_in              const uuid_t&                                   uuid
+                )
+            {
+                static const char* digits = "0123456789abcdef";
+
+                text.push_back( '"' );
+
+                for( std::size_t i = 0U; i < uuid.size(); ++i )
+                {
+                    if( 4U == i || 6U == i || 8U == i || 10U == i )
+                    {
+                        text.push_back( '-' );
+                    }
+
+                    text.push_back( digits[ uuid.data[ i ] >> 4 ] );
+                    text.push_back( digits[ uuid.data[ i ] & 0x0F ] );
+                }
+
+                text.push_back( '"' );
+            }
+
+            /**
+             * @brief Reads a string value which is expected to be a plain (unescaped) string
+             * or null; returns false if the value is anything else
+             */
+
+            static bool tryReadPlainString(
+                SAA_inout           json::StreamReader&                             reader,
+                SAA_in              const char*                                     protocolData,
+                SAA_out             ValueLocation&                                  location,
+                SAA_out             view_t&                                         value
+                )
+            {
+                const auto type = reader.peekType();
+
+                const auto raw = reader.captureValue();
+
+                location.offset = static_cast< std::size_t >( raw.first - protocolData );
+                location.length = raw.second;
+
+                if( json_spirit::null_type == type )
+                {
+                    location.isEmpty = true;
+                    value = view_t( raw.first, 0U );
+
+                    return true;
+                }
+
+                if( json_spirit::str_type != type )
+                {
+                    return false;
+                }
+
+                value = view_t( raw.first + 1, raw.second - 2U );
+
+                if( value.second && nullptr != std::memchr( value.first, '\\', value.second ) )
+                {
+                    return false;
+                }
+
+                location.isEmpty = 0U == value.second;
+
+                return true;
+            }
+
+            static bool tryReadPeerId(
+                SAA_inout           json::StreamReader&                             reader,
+                SAA_in              const char*                                     protocolData,
+                SAA_out             ValueLocation&                                  location,
+                SAA_out             uuid_t&                                         peerId
+                )
+            {
+                if( NO_VALUE != location.offset )
+                {
+                    /*
+                     * Duplicate property
+                     */
+
+                    reader.skipValue();
+
+                    return false;
+                }
+
+                view_t value;
+
+                if( ! tryReadPlainString( reader, protocolData, location, value ) )
+                {
+                    return false;
+                }
+
+                return location.isEmpty || tryParseUuid( value, peerId );
+            }
+
+            static bool tryReadRequiredUuid(
+                SAA_inout           json::StreamReader&                             reader,
+                SAA_in              const char*                                     protocolData,
+                SAA_inout           bool&                                           isFound,
+                SAA_out             uuid_t&                                         id
+                )
+            {
+                ValueLocation location;
+                view_t value;
+
+                if( isFound )
+                {
+                    reader.skipValue();
+
+                    return false;
+                }
+
+                if( ! tryReadPlainString( reader, protocolData, location, value ) )
+                {
+                    return false;
+                }
+
+                isFound = true;
+
+                return tryParseUuid( value, id );
+            }
+
+            /**
+             * @brief Scans the principal identity info object; the fast path only handles the
+             * case where an authentication token is provided (which is what the broker expects)
+             */
+
+            bool tryReadPrincipalIdentityInfo( SAA_in const view_t& raw )
+            {
+                json::StreamReader reader( raw );
+
+                if( json_spirit::obj_type != reader.peekType() )
+                {
+                    return false;
+                }
+
+                bool isValid = true;
+                bool hasToken = false;
+
+                reader.readObject(
+                    [ & ]( SAA_in const view_t& key ) -> void
+                    {
+                        if( ! isValid || ! isKey( key, "authenticationToken" ) || hasToken )
+                        {
+                            /*
+                             * Security principal info is only produced by the broker and for
+                             * null values or unknown properties we leave the validation to the
+                             * full deserialization
+                             */
+
+                            isValid = false;
+                            reader.skipValue();
+
+                            return;
+                        }
+
+                        hasToken = true;
+
+                        if( json_spirit::obj_type != reader.peekType() )
+                        {
+                            isValid = false;
+                            reader.skipValue();
+
+                            return;
+                        }
+
+                        reader.readObject(
+                            [ & ]( SAA_in const view_t& tokenKey ) -> void
+                            {
+                                std::string* target = nullptr;
+
+                                if( isKey( tokenKey, "type" ) )
+                                {
+                                    target = &m_tokenType;
+                                }
+                                else if( isKey( tokenKey, "data" ) )
+                                {
+                                    target = &m_tokenData;
+                                }
+
+                                if( ! target || json_spirit::str_type != reader.peekType() )
+                                {
+                                    isValid = false;
+                                    reader.skipValue();
+
+                                    return;
+                                }
+
+                                reader.read( *target );
+                            }
+                            );
+                    }
+                    );
+
+                return isValid && hasToken && ! m_tokenType.empty() && ! m_tokenData.empty();
+            }
+
+            bool tryParseInternal(
+                SAA_in_bcount( size )       const char*                                 protocolData,
+                SAA_in                      const std::size_t                           size
+                )
+            {
+                json::StreamReader reader( protocolData, size );
+
+                if( json_spirit::obj_type != reader.peekType() )
+                {
+                    return false;
+                }
+
+                bool isValid = true;
+                bool hasMessageType = false;
+                bool hasMessageId = false;
+                bool hasConversationId = false;
+
+                reader.readObject(
+                    [ & ]( SAA_in const view_t& key ) -> void
+                    {
+                        if( ! isValid )
+                        {
+                            reader.skipValue();
+
+                            return;
+                        }
+
+                        if( isKey( key, "messageType" ) )
+                        {
+                            ValueLocation location;
+                            view_t value;
+
+                            if( hasMessageType )
+                            {
+                                isValid = false;
+                                reader.skipValue();
+
+                                return;
+                            }
+
+                            hasMessageType = true;
+
+                            isValid =
+                                tryReadPlainString( reader, protocolData, location, value ) &&
+                                MessageType::tryToEnum( std::string( value.first, value.second ), m_messageType );
+                        }
+                        else if( isKey( key, "messageId" ) )
+                        {
+                            isValid = tryReadRequiredUuid( reader, protocolData, hasMessageId, m_messageId );
+                        }
+                        else if( isKey( key, "conversationId" ) )
+                        {
+                            isValid = tryReadRequiredUuid( reader, protocolData, hasConversationId, m_conversationId );
+                        }
+                        else if( isKey( key, "sourcePeerId" ) )
+                        {
+                            isValid = tryReadPeerId( reader, protocolData, m_sourcePeerIdValue, m_sourcePeerId );
+                        }
+                        else if( isKey( key, "targetPeerId" ) )
+                        {
+                            isValid = tryReadPeerId( reader, protocolData, m_targetPeerIdValue, m_targetPeerId );
+                        }
+                        else if( isKey( key, "principalIdentityInfo" ) )
+                        {
+                            const auto raw = reader.captureValue();
+
+                            m_principalIdentityInfoValue.offset = static_cast< std::size_t >( raw.first - protocolData );
+                            m_principalIdentityInfoValue.length = raw.second;
+                            m_principalIdentityInfoValue.isEmpty = false;
+
+                            isValid = tryReadPrincipalIdentityInfo( raw );
+                        }
+                        else
+                        {
+                            /*
+                             * Unknown properties are left to the full deserialization
+                             */
+
+                            isValid = false;
+                            reader.skipValue();
+                        }
+                    }
+                    );
+
+                reader.requireEof();
+
+                if( ! isValid || ! hasMessageType || ! hasMessageId || ! hasConversationId )
+                {
+                    return false;
+                }
+
+                /*
+                 * The closing brace of the top level object is the last non-whitespace character
+                 * as requireEof() has verified that there is no trailing data
+                 */
+
+                auto closingBraceOffset = size;
+
+                while( closingBraceOffset && '}' != protocolData[ closingBraceOffset - 1U ] )
+                {
+                    --closingBraceOffset;
+                }
+
+                BL_ASSERT( closingBraceOffset );
+
+                m_closingBraceOffset = closingBraceOffset - 1U;
+                m_protocolDataSize = size;
+
+                return true;
+            }
+
+            void appendPropertyEdit(
+                SAA_in              const ValueLocation&                            location,
+                SAA_in              const char*                                     name,
+                SAA_in              std::string&&                                   valueText,
+                SAA_inout           std::string&                                    appendText,
+                SAA_inout           std::vector< Edit >&                            edits
+                ) const
+            {
+                if( NO_VALUE != location.offset )
+                {
+                    edits.push_back( Edit{ location.offset, location.length, BL_PARAM_FWD( valueText ) } );
+
+                    return;
+                }
+
+                /*
+                 * The property is not present, so it is added at the end of the object; the required
+                 * properties are always present, so the object can't be empty at this point
+                 */
+
+                appendText.append( ",\"" );
+                appendText.append( name );
+                appendText.append( "\":" );
+                appendText.append( valueText );
+            }
+
+        public:
+
+            BrokerProtocolRoutingInfoT()
+                :
+                m_messageType( MessageType::AsyncRpcDispatch ),
+                m_messageId( uuids::nil() ),
+                m_conversationId( uuids::nil() ),
+                m_sourcePeerId( uuids::nil() ),
+                m_targetPeerId( uuids::nil() )
+            {
+                reset();
+            }
+
+            void reset()
+            {
+                m_messageId = uuids::nil();
+                m_conversationId = uuids::nil();
+                m_sourcePeerId = uuids::nil();
+                m_targetPeerId = uuids::nil();
+                m_tokenType.clear();
+                m_tokenData.clear();
+
+                m_sourcePeerIdValue = ValueLocation{ NO_VALUE, 0U, true };
+                m_targetPeerIdValue = ValueLocation{ NO_VALUE, 0U, true };
+                m_principalIdentityInfoValue = ValueLocation{ NO_VALUE, 0U, true };
+
+                m_closingBraceOffset = 0U;
+                m_protocolDataSize = 0U;
+                m_isParsed = false;
+            }
+
+            /**
+             * @brief Scans the broker protocol data and returns true if the message can be routed
+             * on the fast path; the protocol data is not modified and it is not referenced after
+             * the call returns (only offsets are kept)
+             */
+
+            bool tryParse(
+                SAA_in_bcount( size )       const char*                                 protocolData,
+                SAA_in                      const std::size_t                           size
+                )
+            {
+                reset();
+
+                if( dm::DataModelUtils::isBinaryDoc( protocolData, size ) )
+                {
+                    return false;
+                }
+
+                try
+                {
+                    m_isParsed = tryParseInternal( protocolData, size );
+                }
+                catch( JsonException& )
+                {
+                    /*
+                     * Malformed input is reported by the full deserialization
+                     */
+
+                    m_isParsed = false;
+                }
+
+                if( ! m_isParsed )
+                {
+                    reset();
+                }
+
+                return m_isParsed;
+            }
+
+            bool tryParse( SAA_in const om::ObjPtr< data::DataBlock >& data )
+            {
+                const auto protocolDataOffset = data -> offset1();
+
+                return tryParse( data -> begin() + protocolDataOffset, data -> size() - protocolDataOffset );
+            }
+
+            bool isParsed() const NOEXCEPT
+            {
+                return m_isParsed;
+            }
+
+            MessageType::Enum messageType() const NOEXCEPT
+            {
+                return m_messageType;
+            }
+
+            const uuid_t& messageId() const NOEXCEPT
+            {
+                return m_messageId;
+            }
+
+            const uuid_t& conversationId() const NOEXCEPT
+            {
+                return m_conversationId;
+            }
+
+            bool hasSourcePeerId() const NOEXCEPT
+            {
+                return ! m_sourcePeerIdValue.isEmpty;
+            }
+
+            const uuid_t& sourcePeerId() const NOEXCEPT
+            {
+                return m_sourcePeerId;
+            }
+
+            bool hasTargetPeerId() const NOEXCEPT
+            {
+                return ! m_targetPeerIdValue.isEmpty;
+            }
+
+            const uuid_t& targetPeerId() const NOEXCEPT
+            {
+                return m_targetPeerId;
+            }
+
+            bool hasPrincipalIdentityInfo() const NOEXCEPT
+            {
+                return NO_VALUE != m_principalIdentityInfoValue.offset;
+            }
+
+            const std::string& tokenType() const NOEXCEPT
+            {
+                return m_tokenType;
+            }
+
+            const std::string& tokenData() const NOEXCEPT
+            {
+                return m_tokenData;
+            }
+
+            /**
+             * @brief Updates the protocol data in the block in place the same way as
+             * MessagingUtils::updateBrokerProtocolMessageInBlock does, i.e. the peer ids are only
+             * set if they were not provided and the principal identity info is replaced with the
+             * packed JSON provided (if any)
+             *
+             * Only the affected values are patched (the rest of the text is moved as needed), so
+             * in the common case of both peer ids missing this just inserts them before the
+             * closing brace at the end of the block
+             *
+             * Returns true if the message was changed; the routing info is reset after the update
+             * as the offsets are no longer valid
+             */
+
+            bool updateInBlock(
+                SAA_in              const om::ObjPtr< data::DataBlock >&            data,
+                SAA_in              const uuid_t&                                   sourcePeerId,
+                SAA_in              const uuid_t&                                   targetPeerId,
+                SAA_in_opt          const std::string*                              principalIdentityInfoJson = nullptr
+                )
+            {
+                BL_ASSERT( m_isParsed );
+
+                const auto protocolDataOffset = data -> offset1();
+
+                BL_CHK(
+                    false,
+                    data -> size() - protocolDataOffset == m_protocolDataSize,
+                    BL_MSG()
+                        << "The broker protocol data has changed since it was parsed"
+                    );
+
+                std::vector< Edit > edits;
+                std::string appendText;
+
+                edits.reserve( 4U );
+
+                if( m_sourcePeerIdValue.isEmpty )
+                {
+                    std::string valueText;
+                    appendQuotedUuid( valueText, sourcePeerId );
+
+                    appendPropertyEdit( m_sourcePeerIdValue, "sourcePeerId", std::move( valueText ), appendText, edits );
+                }
+
+                if( m_targetPeerIdValue.isEmpty )
+                {
+                    std::string valueText;
+                    appendQuotedUuid( valueText, targetPeerId );
+
+                    appendPropertyEdit( m_targetPeerIdValue, "targetPeerId", std::move( valueText ), appendText, edits );
+                }
+
+                if( principalIdentityInfoJson )
+                {
+                    appendPropertyEdit(
+                        m_principalIdentityInfoValue,
+                        "principalIdentityInfo",
+                        std::string( *principalIdentityInfoJson ),
+                        appendText,
+                        edits
+                        );
+                }
+
+                if( ! appendText.empty() )
+                {
+                    edits.push_back( Edit{ m_closingBraceOffset, 0U, std::move( appendText ) } );
+                }
+
+                if( edits.empty() )
+                {
+                    reset();
+
+                    return false;
+                }
+
+                /*
+                 * The edits are applied from the end of the text towards the beginning, so the
+                 * offsets of the edits which are yet to be applied remain valid
+                 */
+
+                std::sort(
+                    edits.begin(),
+                    edits.end(),
+                    []( SAA_in const Edit& lhs, SAA_in const Edit& rhs ) -> bool
+                    {
+                        return lhs.offset > rhs.offset;
+                    }
+                    );
+
+                std::size_t maxSize = data -> size();
+
+                for( const auto& edit : edits )
+                {
+                    maxSize += edit.text.size();
+                }
+
+                data -> reserve( maxSize );
+
+                std::size_t size = data -> size();
+
+                for( const auto& edit : edits )
+                {
+                    auto* pos = data -> begin() + protocolDataOffset + edit.offset;
+
+                    const auto tailSize = size - ( protocolDataOffset + edit.offset + edit.length );
+
+                    std::memmove( pos + edit.text.size(), pos + edit.length, tailSize );
+                    std::memcpy( pos, edit.text.data(), edit.text.size() );
+
+                    size = size - edit.length + edit.text.size();
+                }
+
+                data -> setSize( size );
+
+                reset();
+
+                return true;
+            }
+        };
+
+        typedef BrokerProtocolRoutingInfoT<> BrokerProtocolRoutingInfo;
+
+    } // messaging
+
+} // bl
+
+#endif /* __BL_MESSAGING_BROKERPROTOCOLROUTINGINFO_H_ */
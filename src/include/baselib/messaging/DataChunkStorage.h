@@ -75,6 +75,21 @@ namespace bl
                 SAA_in                  const om::ObjPtr< DataBlock >&                  data
                 ) = 0;
 
+            /**
+             * @brief Returns a data block which references the stored chunk data directly
+             * (e.g. a memory mapped file region) without copying it or nullptr if this is
+             * not supported for the chunk, in which case load() should be used instead
+             *
+             * The returned block keeps the underlying mapping alive for as long as it is
+             * referenced and it must not be returned to a data blocks pool
+             */
+
+            virtual auto tryLoadMapped(
+                SAA_in                  const uuid_t&                                   sessionId,
+                SAA_in                  const uuid_t&                                   chunkId
+                )
+                -> om::ObjPtr< DataBlock > = 0;
+
             virtual void save(
                 SAA_in                  const uuid_t&                                   sessionId,
                 SAA_in                  const uuid_t&                                   chunkId,
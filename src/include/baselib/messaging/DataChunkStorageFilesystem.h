@@ -21,6 +21,8 @@
 
 #include <baselib/data/DataBlock.h>
 
+#include <baselib/tasks/TasksUtils.h>
+
 #include <baselib/core/Uuid.h>
 #include <baselib/core/ObjModel.h>
 #include <baselib/core/ObjModelDefs.h>
@@ -28,10 +30,59 @@
 #include <baselib/core/OS.h>
 #include <baselib/core/BaseIncludes.h>
 
+#include <algorithm>
+#include <map>
+#include <set>
+
 namespace bl
 {
     namespace data
     {
+        /**
+         * @brief class MappedFileRegion - a memory mapped region of a file which is used as
+         * the external owner of the data blocks returned by tryLoadMapped()
+         *
+         * The region is mapped copy on write, so the data blocks can be modified freely
+         * without the changes ever being written back to the file
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class MappedFileRegionT : public om::Object
+        {
+            BL_DECLARE_OBJECT_IMPL_DEFAULT( MappedFileRegionT )
+
+        protected:
+
+            os::ipc::mapped_region                                                      m_region;
+
+            MappedFileRegionT(
+                SAA_in                      const os::ipc::file_mapping&                mapping,
+                SAA_in                      const std::uint64_t                         offset,
+                SAA_in                      const std::size_t                           size
+                )
+                :
+                m_region( mapping, os::ipc::copy_on_write, static_cast< os::ipc::offset_t >( offset ), size )
+            {
+            }
+
+        public:
+
+            auto address() const NOEXCEPT -> void*
+            {
+                return m_region.get_address();
+            }
+
+            auto size() const NOEXCEPT -> std::size_t
+            {
+                return m_region.get_size();
+            }
+        };
+
+        typedef om::ObjectImpl< MappedFileRegionT<> > MappedFileRegion;
+
         /**
          * @brief class DataChunkStorageFilesystemBase - a file system base implementation of
          * the DataChunkStorage interface
@@ -45,18 +96,42 @@ namespace bl
         {
             BL_DECLARE_OBJECT_IMPL_ONEIFACE_DISPOSABLE_NO_DESTRUCTOR( DataChunkStorageFilesystemBaseT, DataChunkStorage )
 
+        public:
+
+            /*
+             * Mapping small chunks costs more (mmap / munmap calls and TLB shootdowns)
+             * than simply copying them, so only chunks of at least this size are mapped
+             */
+
+            enum : std::size_t
+            {
+                MAPPED_READ_SIZE_MIN = 64U * 1024U,
+            };
+
         protected:
 
             cpp::SafeUniquePtr< fs::TmpDir >                                            m_tempDirectory;
             fs::path                                                                    m_rootPath;
             fs::path                                                                    m_rootPathChunks;
             cpp::ScalarTypeIniter< bool >                                               m_disposed;
+            cpp::ScalarTypeIniter< bool >                                               m_mappedReadsEnabled;
 
             DataChunkStorageFilesystemBaseT(
                 SAA_in_opt                  fs::path&&                                  rootPath = fs::path(),
                 SAA_in_opt                  const bool                                  isRootTemp = false
                 )
             {
+                /*
+                 * On Windows files can't be deleted while they are mapped, so the chunks
+                 * can't be removed (or compacted) while the mapped blocks are in flight
+                 */
+
+                #ifdef _WIN32
+                m_mappedReadsEnabled = false;
+                #else
+                m_mappedReadsEnabled = true;
+                #endif
+
                 if( rootPath.empty() )
                 {
                     m_tempDirectory = cpp::SafeUniquePtr< fs::TmpDir >::attach(
@@ -121,6 +196,26 @@ namespace bl
                     );
             }
 
+            bool isMappedRead( SAA_in const std::uint64_t size ) const NOEXCEPT
+            {
+                return m_mappedReadsEnabled && size >= MAPPED_READ_SIZE_MIN && size <= DataBlock::defaultCapacity();
+            }
+
+            static auto createMappedBlock(
+                SAA_in                  const os::ipc::file_mapping&                    mapping,
+                SAA_in                  const std::uint64_t                             offset,
+                SAA_in                  const std::uint64_t                             size
+                )
+                -> om::ObjPtr< DataBlock >
+            {
+                const auto region =
+                    MappedFileRegion::createInstance( mapping, offset, static_cast< std::size_t >( size ) );
+
+                const auto address = region -> address();
+
+                return DataBlock::createInstance( om::qi< om::Object >( region ), address, region -> size() );
+            }
+
             void chkBlockSize(
                 SAA_in                  const std::uint64_t                             size,
                 SAA_in                  const om::ObjPtr< DataBlock >&                  data
@@ -139,6 +234,16 @@ namespace bl
 
         public:
 
+            bool mappedReadsEnabled() const NOEXCEPT
+            {
+                return m_mappedReadsEnabled;
+            }
+
+            void mappedReadsEnabled( SAA_in const bool mappedReadsEnabled ) NOEXCEPT
+            {
+                m_mappedReadsEnabled = mappedReadsEnabled;
+            }
+
             /*
              * om::Disposable implementation
              */
@@ -240,6 +345,35 @@ namespace bl
                 }
             }
 
+            virtual auto tryLoadMapped(
+                SAA_in                  const uuid_t&                                   sessionId,
+                SAA_in                  const uuid_t&                                   chunkId
+                )
+                -> om::ObjPtr< DataBlock > OVERRIDE
+            {
+                BL_UNUSED( sessionId );
+
+                chkNotDisposed();
+
+                const auto chunkPath = getExistingChunkPath( chunkId );
+
+                const auto size = fs::file_size( chunkPath );
+
+                if( ! base_type::isMappedRead( size ) )
+                {
+                    return nullptr;
+                }
+
+                /*
+                 * The mapping object (the file handle) can be closed right away as the mapped
+                 * region keeps the file data alive even if the chunk is removed later on
+                 */
+
+                const os::ipc::file_mapping mapping( chunkPath.string().c_str(), os::ipc::read_only );
+
+                return base_type::createMappedBlock( mapping, 0U /* offset */, size );
+            }
+
             virtual void save(
                 SAA_in                  const uuid_t&                                   sessionId,
                 SAA_in                  const uuid_t&                                   chunkId,
@@ -250,12 +384,41 @@ namespace bl
 
                 chkNotDisposed();
 
-                const auto filePtr = os::fopen( getChunkPath( chunkId ), "wb" );
+                /*
+                 * The chunk file must not be truncated and re-written in place as it may still
+                 * be mapped by a block returned from tryLoadMapped() - the data is written into
+                 * a temp file instead which is then renamed over the old one, so the existing
+                 * mappings keep referencing the old inode
+                 */
+
+                const auto chunkPath = getChunkPath( chunkId );
+
+                const auto tempPath = fs::path(
+                    resolveMessage(
+                        BL_MSG()
+                            << chunkPath.string()
+                            << "."
+                            << uuids::uuid2string( uuids::create() )
+                            << ".tmp"
+                        )
+                    );
+
+                auto tempGuard = BL_SCOPE_GUARD(
+                    fs::safeDeletePathNothrow( tempPath );
+                    );
 
-                if( data -> size() )
                 {
-                    os::fwrite( filePtr, data -> pv(), data -> size() );
+                    const auto filePtr = os::fopen( tempPath, "wb" );
+
+                    if( data -> size() )
+                    {
+                        os::fwrite( filePtr, data -> pv(), data -> size() );
+                    }
                 }
+
+                fs::safeRename( tempPath, chunkPath );
+
+                tempGuard.dismiss();
             }
 
             virtual void remove(
@@ -277,7 +440,27 @@ namespace bl
 
         /**
          * @brief class DataChunkStorageFilesystemSingleFile - a file system implementation of
-         * the DataChunkStorage interface with multiple files (one file per chunk)
+         * the DataChunkStorage interface which appends all chunks to a log of segment files
+         *
+         * The chunks are appended to the last (active) segment file and when it grows beyond
+         * the max segment size a new segment file is started. The first segment file is
+         * called data.bin (which is also the name of the file before segments were introduced,
+         * so old storage files can still be loaded) and the next ones are data.<id>.bin
+         *
+         * Deleting a chunk only marks its header as deleted and the space is reclaimed by
+         * compact() which copies the live chunks of the sealed segments with enough deleted
+         * space to the active segment and then deletes the sealed segment file; compact() can
+         * be called while the storage is in use (the lock is only held while a single chunk
+         * is being copied) and it can also be called periodically in background if a
+         * compaction interval is provided
+         *
+         * On a clean shutdown an index checkpoint is written, so the next time the storage is
+         * opened the active chunks map is loaded from it without having to read all chunk
+         * headers; if the storage was not shut down cleanly then all segments are scanned
+         *
+         * compact() makes the copied chunks and a new index checkpoint durable (fsync) before
+         * it deletes the compacted segment files, so a crash can't lose live chunks; the
+         * checkpoint is removed again on the next modification of the storage
          */
 
         template
@@ -288,6 +471,18 @@ namespace bl
         {
             BL_DECLARE_OBJECT_IMPL_NO_DESTRUCTOR( DataChunkStorageFilesystemSingleFileT )
 
+        public:
+
+            enum : std::uint64_t
+            {
+                SEGMENT_SIZE_MAX_DEFAULT = 256ULL * 1024ULL * 1024ULL,
+            };
+
+            enum : std::uint32_t
+            {
+                COMPACTION_DELETED_PERCENT_DEFAULT = 50U,
+            };
+
         protected:
 
             typedef DataChunkStorageFilesystemSingleFileT< E >                          this_type;
@@ -298,6 +493,16 @@ namespace bl
                 CHUNK_FLAG_DELETED = 1U,
             };
 
+            enum : std::uint64_t
+            {
+                INDEX_MAGIC = 0x31584449534c4242ULL /* "BBLSIDX1" */,
+            };
+
+            enum : std::uint32_t
+            {
+                INDEX_VERSION = 1U,
+            };
+
             struct ChunkHeader
             {
                 bl::uuid_t          chunkId;
@@ -315,22 +520,92 @@ namespace bl
                 }
             };
 
-            os::stdio_file_ptr                                                          m_file;
+            struct ChunkLocation
+            {
+                ChunkHeader         header;
+                std::uint32_t       segmentId;
+            };
+
+            struct Segment
+            {
+                os::stdio_file_ptr                                  file;
+                cpp::SafeUniquePtr< os::ipc::file_mapping >         mapping;
+                std::uint64_t                                       size;
+                std::uint64_t                                       deletedSize;
+            };
+
+            /*
+             * The on disk layout of the index checkpoint file (index.bin)
+             */
+
+            struct IndexHeader
+            {
+                std::uint64_t       magic;
+                std::uint32_t       version;
+                std::uint32_t       segmentsCount;
+                std::uint64_t       chunksCount;
+            };
+
+            struct IndexSegmentEntry
+            {
+                std::uint32_t       segmentId;
+                std::uint32_t       reserved;
+                std::uint64_t       size;
+                std::uint64_t       deletedSize;
+            };
+
+            struct IndexChunkEntry
+            {
+                ChunkHeader         header;
+                std::uint32_t       segmentId;
+                std::uint32_t       reserved;
+            };
+
+            const std::uint64_t                                                         m_maxSegmentSize;
+            const std::uint32_t                                                         m_compactionDeletedPercent;
             fs::path                                                                    m_filePath;
-            std::unordered_map< uuid_t, ChunkHeader >                                   m_activeChunks;
+            fs::path                                                                    m_indexPath;
+            std::map< std::uint32_t, Segment >                                          m_segments;
+            std::unordered_map< uuid_t, ChunkLocation >                                 m_activeChunks;
+            cpp::ScalarTypeIniter< bool >                                               m_isIndexCheckpointSaved;
+            cpp::ScalarTypeIniter< bool >                                               m_isIndexCheckpointLoaded;
             os::mutex                                                                   m_lock;
+            os::mutex                                                                   m_compactionLock;
+            cpp::SafeUniquePtr< tasks::SimpleTimer >                                    m_compactionTimer;
 
             DataChunkStorageFilesystemSingleFileT(
                 SAA_in_opt                  fs::path&&                                  rootPath = fs::path(),
-                SAA_in_opt                  const bool                                  isRootTemp = false
+                SAA_in_opt                  const bool                                  isRootTemp = false,
+                SAA_in_opt                  const std::uint64_t                         maxSegmentSize = SEGMENT_SIZE_MAX_DEFAULT,
+                SAA_in_opt                  time::time_duration&&                       compactionInterval = time::time_duration(),
+                SAA_in_opt                  const std::uint32_t                         compactionDeletedPercent =
+                    COMPACTION_DELETED_PERCENT_DEFAULT
                 )
                 :
-                base_type( BL_PARAM_FWD( rootPath ), isRootTemp )
+                base_type( BL_PARAM_FWD( rootPath ), isRootTemp ),
+                m_maxSegmentSize( maxSegmentSize ),
+                m_compactionDeletedPercent( compactionDeletedPercent )
             {
-                m_filePath = m_rootPathChunks / "data.bin";
-                m_file = os::fopen( m_filePath, "ab+" );
+                BL_CHK_ARG( maxSegmentSize, maxSegmentSize );
+                BL_CHK_ARG( compactionDeletedPercent <= 100U, compactionDeletedPercent );
+
+                m_filePath = getSegmentPath( 0U );
+                m_indexPath = m_rootPathChunks / "index.bin";
+
+                openSegments();
 
                 loadChunksData();
+
+                if( ! compactionInterval.is_special() && compactionInterval.total_milliseconds() > 0 )
+                {
+                    m_compactionTimer = cpp::SafeUniquePtr< tasks::SimpleTimer >::attach(
+                        new tasks::SimpleTimer(
+                            cpp::bind( &this_type::onCompactionTimer, this, compactionInterval ),
+                            cpp::copy( compactionInterval )     /* defaultDuration */,
+                            cpp::copy( compactionInterval )     /* initDelay */
+                            )
+                        );
+                }
             }
 
             ~DataChunkStorageFilesystemSingleFileT() NOEXCEPT
@@ -338,10 +613,108 @@ namespace bl
                 disposeInternal();
             }
 
+            auto getSegmentPath( SAA_in const std::uint32_t segmentId ) const -> fs::path
+            {
+                if( 0U == segmentId )
+                {
+                    return m_rootPathChunks / "data.bin";
+                }
+
+                return m_rootPathChunks / resolveMessage( BL_MSG() << "data." << segmentId << ".bin" );
+            }
+
+            static os::stdio_file_ptr openSegmentFile( SAA_in const fs::path& path )
+            {
+                /*
+                 * The file is first created (if it doesn't exist) and then opened in
+                 * update mode as in append mode all writes go to the end of the file
+                 * and we need to update the chunk headers in place
+                 */
+
+                if( ! fs::path_exists( path ) )
+                {
+                    os::fopen( path, "ab" );
+                }
+
+                return os::fopen( path, "rb+" );
+            }
+
+            auto activeSegmentId() const NOEXCEPT -> std::uint32_t
+            {
+                BL_ASSERT( ! m_segments.empty() );
+
+                return m_segments.rbegin() -> first;
+            }
+
+            void openSegments()
+            {
+                std::set< std::uint32_t > segmentIds;
+
+                /*
+                 * The segments are loaded from the segment files which exist (data.bin can be
+                 * deleted by compaction too) and segment 0 is only created for a new storage
+                 */
+
+                if( fs::path_exists( getSegmentPath( 0U ) ) )
+                {
+                    segmentIds.insert( 0U );
+                }
+
+                for( fs::directory_iterator i( m_rootPathChunks ), end; i != end; ++i )
+                {
+                    const auto name = i -> path().filename().string();
+
+                    if( name.size() > 9U && str::starts_with( name, "data." ) && str::ends_with( name, ".bin" ) )
+                    {
+                        const auto id = name.substr( 5U, name.size() - 9U );
+
+                        if( std::all_of( id.begin(), id.end(), []( SAA_in const char ch ) { return ch >= '0' && ch <= '9'; } ) )
+                        {
+                            segmentIds.insert( utils::lexical_cast< std::uint32_t >( id ) );
+                        }
+                    }
+                }
+
+                for( const auto segmentId : segmentIds )
+                {
+                    const auto path = getSegmentPath( segmentId );
+
+                    Segment segment;
+
+                    segment.file = openSegmentFile( path );
+                    segment.size = fs::file_size( path );
+                    segment.deletedSize = 0U;
+
+                    m_segments.emplace( segmentId, std::move( segment ) );
+                }
+
+                if( segmentIds.empty() )
+                {
+                    Segment segment;
+
+                    segment.file = openSegmentFile( getSegmentPath( 0U ) );
+                    segment.size = 0U;
+                    segment.deletedSize = 0U;
+
+                    m_segments.emplace( 0U, std::move( segment ) );
+                }
+            }
+
             void disposeInternal() NOEXCEPT
             {
                 BL_WARN_NOEXCEPT_BEGIN()
 
+                /*
+                 * The timer must be stopped before we take the lock as the
+                 * compaction callback takes it too
+                 */
+
+                if( m_compactionTimer )
+                {
+                    m_compactionTimer -> stop();
+                }
+
+                BL_MUTEX_GUARD( m_compactionLock );
                 BL_MUTEX_GUARD( m_lock );
 
                 if( m_disposed )
@@ -349,7 +722,9 @@ namespace bl
                     return;
                 }
 
-                m_file.reset();
+                saveIndexCheckpoint();
+
+                m_segments.clear();
 
                 base_type::disposeInternal();
 
@@ -358,61 +733,397 @@ namespace bl
                 BL_WARN_NOEXCEPT_END( "DataChunkStorageFilesystemSingleFileT::dispose()" )
             }
 
-            void chkFileFormatInvariant( SAA_in const bool cond )
+            void chkFileFormatInvariant(
+                SAA_in                  const bool                                      cond,
+                SAA_in                  const fs::path&                                 path
+                )
             {
                 BL_CHK(
                     false,
                     cond,
                     BL_MSG()
                         << "The file format of "
-                        << m_filePath
+                        << path
                         << " in invalid"
                     );
             }
 
-            void loadChunksData()
+            static std::uint64_t getChunkRecordSize( SAA_in const ChunkHeader& header ) NOEXCEPT
             {
-                BL_MUTEX_GUARD( m_lock );
-
-                const auto size = fs::file_size( m_filePath );
+                return sizeof( header ) + header.size;
+            }
 
-                m_activeChunks.clear();
+            void supersedeChunk( SAA_in const uuid_t& chunkId )
+            {
+                const auto pos = m_activeChunks.find( chunkId );
 
-                if( ! size )
+                if( pos != m_activeChunks.end() )
                 {
-                    return;
+                    m_segments[ pos -> second.segmentId ].deletedSize += getChunkRecordSize( pos -> second.header );
+
+                    m_activeChunks.erase( pos );
                 }
+            }
+
+            void loadSegmentChunksData( SAA_in const std::uint32_t segmentId )
+            {
+                auto& segment = m_segments[ segmentId ];
+
+                const auto path = getSegmentPath( segmentId );
+                const auto size = segment.size;
 
                 std::uint64_t pos = 0U;
 
-                os::fseek( m_file, 0U, SEEK_SET );
+                os::fseek( segment.file, 0U, SEEK_SET );
 
                 while( pos < size )
                 {
                     ChunkHeader header;
 
-                    chkFileFormatInvariant( ( pos + sizeof( header ) ) <= size );
+                    chkFileFormatInvariant( ( pos + sizeof( header ) ) <= size, path );
 
-                    os::fread( m_file, &header, sizeof( header ) );
+                    os::fread( segment.file, &header, sizeof( header ) );
 
-                    chkFileFormatInvariant( header.pos == pos );
+                    chkFileFormatInvariant( header.pos == pos, path );
 
                     pos += sizeof( header );
 
                     if( header.size )
                     {
-                        chkFileFormatInvariant( ( pos + header.size ) <= size );
+                        chkFileFormatInvariant( ( pos + header.size ) <= size, path );
 
                         pos += header.size;
 
-                        os::fseek( m_file, pos, SEEK_SET );
+                        os::fseek( segment.file, pos, SEEK_SET );
+                    }
+
+                    /*
+                     * The segments are scanned in order, so the last record for a chunk id
+                     * always wins (e.g. a chunk which was copied to a newer segment by the
+                     * compaction, but the old segment was not deleted yet)
+                     */
+
+                    supersedeChunk( header.chunkId );
+
+                    if( header.flags & CHUNK_FLAG_DELETED )
+                    {
+                        segment.deletedSize += getChunkRecordSize( header );
+                    }
+                    else
+                    {
+                        ChunkLocation location;
+
+                        location.header = header;
+                        location.segmentId = segmentId;
+
+                        m_activeChunks.emplace( header.chunkId, location );
+                    }
+                }
+            }
+
+            bool tryLoadIndexCheckpoint()
+            {
+                if( ! fs::path_exists( m_indexPath ) )
+                {
+                    return false;
+                }
+
+                const auto fileSize = fs::file_size( m_indexPath );
+
+                if( fileSize < sizeof( IndexHeader ) )
+                {
+                    return false;
+                }
+
+                const auto file = os::fopen( m_indexPath, "rb" );
+
+                IndexHeader indexHeader;
+
+                os::fread( file, &indexHeader, sizeof( indexHeader ) );
+
+                if(
+                    INDEX_MAGIC != indexHeader.magic ||
+                    INDEX_VERSION != indexHeader.version ||
+                    indexHeader.segmentsCount != m_segments.size() ||
+                    fileSize !=
+                        sizeof( IndexHeader ) +
+                        indexHeader.segmentsCount * sizeof( IndexSegmentEntry ) +
+                        indexHeader.chunksCount * sizeof( IndexChunkEntry )
+                    )
+                {
+                    return false;
+                }
+
+                /*
+                 * The checkpoint is only valid if the segments have not changed since
+                 * it was written
+                 */
+
+                std::map< std::uint32_t, IndexSegmentEntry > segments;
+
+                for( std::uint32_t i = 0U; i < indexHeader.segmentsCount; ++i )
+                {
+                    IndexSegmentEntry entry;
+
+                    os::fread( file, &entry, sizeof( entry ) );
+
+                    const auto pos = m_segments.find( entry.segmentId );
+
+                    if( pos == m_segments.end() || pos -> second.size != entry.size )
+                    {
+                        return false;
+                    }
+
+                    segments[ entry.segmentId ] = entry;
+                }
+
+                std::unordered_map< uuid_t, ChunkLocation > activeChunks;
+
+                activeChunks.reserve( static_cast< std::size_t >( indexHeader.chunksCount ) );
+
+                for( std::uint64_t i = 0U; i < indexHeader.chunksCount; ++i )
+                {
+                    IndexChunkEntry entry;
+
+                    os::fread( file, &entry, sizeof( entry ) );
+
+                    const auto pos = segments.find( entry.segmentId );
+
+                    if(
+                        pos == segments.end() ||
+                        entry.header.pos + getChunkRecordSize( entry.header ) > pos -> second.size
+                        )
+                    {
+                        return false;
+                    }
+
+                    ChunkLocation location;
+
+                    location.header = entry.header;
+                    location.segmentId = entry.segmentId;
+
+                    activeChunks.emplace( entry.header.chunkId, location );
+                }
+
+                for( const auto& entry : segments )
+                {
+                    m_segments[ entry.first ].deletedSize = entry.second.deletedSize;
+                }
+
+                m_activeChunks.swap( activeChunks );
+
+                return true;
+            }
+
+            auto getIndexTempPath() const -> fs::path
+            {
+                return fs::path( m_indexPath.string() + ".tmp" );
+            }
+
+            /**
+             * @brief Writes the index checkpoint durably: all segment files are flushed to the
+             * disk first and then the index is written to a temp file which is flushed and
+             * renamed over index.bin
+             */
+
+            void saveIndexCheckpoint()
+            {
+                for( const auto& segment : m_segments )
+                {
+                    os::fsync( segment.second.file );
+                }
+
+                const auto tempPath = getIndexTempPath();
+
+                auto file = os::fopen( tempPath, "wb" );
+
+                auto guard = BL_SCOPE_GUARD(
+                    {
+                        file.reset();
+
+                        fs::safeDeletePathNothrow( tempPath );
+                    }
+                    );
+
+                IndexHeader indexHeader;
+
+                indexHeader.magic = INDEX_MAGIC;
+                indexHeader.version = INDEX_VERSION;
+                indexHeader.segmentsCount = static_cast< std::uint32_t >( m_segments.size() );
+                indexHeader.chunksCount = m_activeChunks.size();
+
+                os::fwrite( file, &indexHeader, sizeof( indexHeader ), true /* noflush */ );
+
+                for( const auto& segment : m_segments )
+                {
+                    IndexSegmentEntry entry;
+
+                    entry.segmentId = segment.first;
+                    entry.reserved = 0U;
+                    entry.size = segment.second.size;
+                    entry.deletedSize = segment.second.deletedSize;
+
+                    os::fwrite( file, &entry, sizeof( entry ), true /* noflush */ );
+                }
+
+                for( const auto& chunk : m_activeChunks )
+                {
+                    IndexChunkEntry entry;
+
+                    entry.header = chunk.second.header;
+                    entry.segmentId = chunk.second.segmentId;
+                    entry.reserved = 0U;
+
+                    os::fwrite( file, &entry, sizeof( entry ), true /* noflush */ );
+                }
+
+                os::fsync( file );
+
+                file.reset();
+
+                fs::safeRename( tempPath, m_indexPath );
+
+                guard.dismiss();
+
+                os::fsyncDirectory( m_rootPathChunks );
+
+                m_isIndexCheckpointSaved = true;
+            }
+
+            void invalidateIndexCheckpoint()
+            {
+                /*
+                 * The checkpoint is only valid until the storage is modified
+                 *
+                 * The removal must be durable before the storage is modified (e.g. before a
+                 * deleted flag is written in place), otherwise after a crash the stale checkpoint
+                 * can still be there and be loaded, which would resurrect the deleted chunks
+                 */
+
+                if( m_isIndexCheckpointSaved )
+                {
+                    fs::safeRemoveIfExists( m_indexPath );
+
+                    os::fsyncDirectory( m_rootPathChunks );
+
+                    m_isIndexCheckpointSaved = false;
+                }
+            }
+
+            void loadChunksData()
+            {
+                BL_MUTEX_GUARD( m_lock );
+
+                m_activeChunks.clear();
+
+                bool loaded = false;
+
+                utils::tryCatchLog(
+                    "Cannot load the chunks index checkpoint file",
+                    [ & ]() -> void
+                    {
+                        loaded = tryLoadIndexCheckpoint();
                     }
+                    );
+
+                m_isIndexCheckpointLoaded = loaded;
+
+                if( ! loaded )
+                {
+                    m_activeChunks.clear();
 
-                    if( ! ( header.flags & CHUNK_FLAG_DELETED ) )
+                    for( auto& segment : m_segments )
                     {
-                        m_activeChunks.emplace( header.chunkId, header );
+                        segment.second.deletedSize = 0U;
+
+                        loadSegmentChunksData( segment.first );
                     }
                 }
+
+                /*
+                 * The checkpoint is only valid until the storage is modified, so
+                 * it is removed now (durably, see invalidateIndexCheckpoint) and written
+                 * again on a clean shutdown
+                 */
+
+                fs::safeRemoveIfExists( m_indexPath );
+                fs::safeRemoveIfExists( getIndexTempPath() );
+
+                os::fsyncDirectory( m_rootPathChunks );
+            }
+
+            void rotateSegmentIfNeeded()
+            {
+                if( m_segments.rbegin() -> second.size >= m_maxSegmentSize )
+                {
+                    addSegment();
+                }
+            }
+
+            void addSegment()
+            {
+                const auto segmentId = activeSegmentId() + 1U;
+
+                Segment segment;
+
+                segment.file = openSegmentFile( getSegmentPath( segmentId ) );
+                segment.size = 0U;
+                segment.deletedSize = 0U;
+
+                m_segments.emplace( segmentId, std::move( segment ) );
+            }
+
+            void appendChunk(
+                SAA_in                  const uuid_t&                                   chunkId,
+                SAA_in_bcount( size )   const void*                                     data,
+                SAA_in                  const std::uint64_t                             size
+                )
+            {
+                invalidateIndexCheckpoint();
+
+                rotateSegmentIfNeeded();
+
+                const auto segmentId = activeSegmentId();
+                auto& segment = m_segments[ segmentId ];
+
+                ChunkLocation location;
+
+                location.segmentId = segmentId;
+                location.header.chunkId = chunkId;
+                location.header.pos = segment.size;
+                location.header.size = size;
+
+                os::fseek( segment.file, segment.size, SEEK_SET );
+
+                os::fwrite(
+                    segment.file,
+                    &location.header,
+                    sizeof( location.header ),
+                    0U != size /* noflush */
+                    );
+
+                if( size )
+                {
+                    os::fwrite( segment.file, data, static_cast< std::size_t >( size ) );
+                }
+
+                segment.size += getChunkRecordSize( location.header );
+
+                BL_VERIFY( m_activeChunks.emplace( chunkId, location ).second );
+            }
+
+            void readChunk(
+                SAA_in                  const ChunkLocation&                            location,
+                SAA_out_bcount( location.header.size ) void*                            data
+                )
+            {
+                if( location.header.size )
+                {
+                    const auto& segment = m_segments[ location.segmentId ];
+
+                    os::fseek( segment.file, location.header.pos + sizeof( location.header ), SEEK_SET );
+                    os::fread( segment.file, data, static_cast< std::size_t >( location.header.size ) );
+                }
             }
 
             void removeChunk(
@@ -432,16 +1143,114 @@ namespace bl
                     return;
                 }
 
-                auto& header = pos -> second;
+                invalidateIndexCheckpoint();
 
-                header.flags |= CHUNK_FLAG_DELETED;
+                auto& location = pos -> second;
+                auto& segment = m_segments[ location.segmentId ];
 
-                os::fseek( m_file, header.pos, SEEK_SET );
-                os::fwrite( m_file, &header, sizeof( header ) );
+                location.header.flags |= CHUNK_FLAG_DELETED;
+
+                os::fseek( segment.file, location.header.pos, SEEK_SET );
+                os::fwrite( segment.file, &location.header, sizeof( location.header ) );
+
+                segment.deletedSize += getChunkRecordSize( location.header );
 
                 m_activeChunks.erase( pos );
             }
 
+            bool isSegmentCompactionCandidate( SAA_in const Segment& segment ) const NOEXCEPT
+            {
+                if( ! segment.size )
+                {
+                    return false;
+                }
+
+                return segment.deletedSize * 100U >= segment.size * m_compactionDeletedPercent;
+            }
+
+            void compactSegment( SAA_in const std::uint32_t segmentId )
+            {
+                std::vector< uuid_t > chunkIds;
+
+                {
+                    BL_MUTEX_GUARD( m_lock );
+
+                    chkNotDisposed();
+
+                    for( const auto& chunk : m_activeChunks )
+                    {
+                        if( chunk.second.segmentId == segmentId )
+                        {
+                            chunkIds.push_back( chunk.first );
+                        }
+                    }
+                }
+
+                std::vector< char > buffer;
+
+                for( const auto& chunkId : chunkIds )
+                {
+                    /*
+                     * The lock is taken per chunk, so the storage can continue to be used
+                     * while the segment is being compacted
+                     */
+
+                    BL_MUTEX_GUARD( m_lock );
+
+                    chkNotDisposed();
+
+                    const auto pos = m_activeChunks.find( chunkId );
+
+                    if( pos == m_activeChunks.end() || pos -> second.segmentId != segmentId )
+                    {
+                        /*
+                         * The chunk was removed or replaced in the meantime
+                         */
+
+                        continue;
+                    }
+
+                    const auto location = pos -> second;
+
+                    buffer.resize( static_cast< std::size_t >( location.header.size ) );
+
+                    readChunk( location, buffer.data() );
+
+                    m_activeChunks.erase( pos );
+
+                    m_segments[ segmentId ].deletedSize += getChunkRecordSize( location.header );
+
+                    appendChunk( chunkId, buffer.data(), location.header.size );
+                }
+
+                /*
+                 * All live chunks were copied to the active segment, so the segment file can
+                 * now be deleted, but first the copies and an index checkpoint which no longer
+                 * refers to the segment are made durable (saveIndexCheckpoint flushes all
+                 * segment files and the directory), so a crash at any point can't lose
+                 * live chunks
+                 */
+
+                BL_MUTEX_GUARD( m_lock );
+
+                chkNotDisposed();
+
+                m_segments.erase( segmentId );
+
+                saveIndexCheckpoint();
+
+                fs::safeRemove( getSegmentPath( segmentId ) );
+
+                os::fsyncDirectory( m_rootPathChunks );
+            }
+
+            auto onCompactionTimer( SAA_in const time::time_duration& compactionInterval ) -> time::time_duration
+            {
+                compact();
+
+                return compactionInterval;
+            }
+
         public:
 
             /*
@@ -453,6 +1262,106 @@ namespace bl
                 disposeInternal();
             }
 
+            /**
+             * @brief Compacts all sealed segments (i.e. not the active one) which have enough
+             * deleted space and returns the number of segments which were compacted
+             *
+             * Set force=true to compact all sealed segments which have any deleted space or
+             * to rotate the active segment first if it has deleted space, so it can be
+             * compacted too
+             */
+
+            std::size_t compact( SAA_in_opt const bool force = false )
+            {
+                BL_MUTEX_GUARD( m_compactionLock );
+
+                std::vector< std::uint32_t > candidates;
+
+                {
+                    BL_MUTEX_GUARD( m_lock );
+
+                    chkNotDisposed();
+
+                    if( force && m_segments.rbegin() -> second.deletedSize )
+                    {
+                        addSegment();
+                    }
+
+                    const auto activeId = activeSegmentId();
+
+                    for( const auto& segment : m_segments )
+                    {
+                        if( segment.first == activeId )
+                        {
+                            continue;
+                        }
+
+                        if( force ? 0U != segment.second.deletedSize : isSegmentCompactionCandidate( segment.second ) )
+                        {
+                            candidates.push_back( segment.first );
+                        }
+                    }
+                }
+
+                for( const auto segmentId : candidates )
+                {
+                    compactSegment( segmentId );
+
+                    BL_LOG(
+                        Logging::debug(),
+                        BL_MSG()
+                            << "Data chunk storage segment "
+                            << getSegmentPath( segmentId )
+                            << " was compacted"
+                        );
+                }
+
+                return candidates.size();
+            }
+
+            /**
+             * @brief Returns the total size of all segment files and the size of the
+             * deleted chunks which has not been reclaimed by compaction yet
+             */
+
+            auto getSegmentsSize( SAA_out_opt std::uint64_t* deletedSize = nullptr ) -> std::uint64_t
+            {
+                BL_MUTEX_GUARD( m_lock );
+
+                std::uint64_t totalSize = 0U;
+                std::uint64_t totalDeletedSize = 0U;
+
+                for( const auto& segment : m_segments )
+                {
+                    totalSize += segment.second.size;
+                    totalDeletedSize += segment.second.deletedSize;
+                }
+
+                if( deletedSize )
+                {
+                    *deletedSize = totalDeletedSize;
+                }
+
+                return totalSize;
+            }
+
+            auto getSegmentsCount() -> std::size_t
+            {
+                BL_MUTEX_GUARD( m_lock );
+
+                return m_segments.size();
+            }
+
+            /**
+             * @brief Returns true if the chunks were loaded from the index checkpoint when
+             * the storage was opened (i.e. without scanning the segments)
+             */
+
+            bool isIndexCheckpointLoaded() const NOEXCEPT
+            {
+                return m_isIndexCheckpointLoaded;
+            }
+
             /*
              * partial data::DataChunkStorage implementation
              */
@@ -476,25 +1385,21 @@ namespace bl
                     base_type::throwChunkDoesNotExist( chunkId );
                 }
 
-                const auto& header = pos -> second;
+                const auto& location = pos -> second;
 
-                base_type::chkBlockSize( header.size, data );
+                base_type::chkBlockSize( location.header.size, data );
 
-                data -> setSize( static_cast< std::size_t >( header.size ) );
+                data -> setSize( static_cast< std::size_t >( location.header.size ) );
                 data -> setOffset1( 0U );
 
-                if( header.size )
-                {
-                    os::fseek( m_file, header.pos + sizeof( header ), SEEK_SET );
-                    os::fread( m_file, data -> pv(), data -> size() );
-                }
+                readChunk( location, data -> pv() );
             }
 
-            virtual void save(
+            virtual auto tryLoadMapped(
                 SAA_in                  const uuid_t&                                   sessionId,
-                SAA_in                  const uuid_t&                                   chunkId,
-                SAA_in                  const om::ObjPtr< DataBlock >&                  data
-                ) OVERRIDE
+                SAA_in                  const uuid_t&                                   chunkId
+                )
+                -> om::ObjPtr< DataBlock > OVERRIDE
             {
                 BL_UNUSED( sessionId );
 
@@ -502,24 +1407,59 @@ namespace bl
 
                 chkNotDisposed();
 
-                removeChunk( chunkId, false /* throwIfDoesNotExist */ );
+                const auto pos = m_activeChunks.find( chunkId );
 
-                os::fseek( m_file, 0U, SEEK_END );
+                if( pos == m_activeChunks.end() )
+                {
+                    base_type::throwChunkDoesNotExist( chunkId );
+                }
 
-                ChunkHeader header;
+                const auto& location = pos -> second;
 
-                header.chunkId = chunkId;
-                header.pos = os::ftell( m_file );
-                header.size = data -> size();
+                if( ! base_type::isMappedRead( location.header.size ) )
+                {
+                    return nullptr;
+                }
 
-                os::fwrite( m_file, &header, sizeof( header ) );
+                /*
+                 * The chunk data is flushed to the file when it is appended, so it is
+                 * already visible through the mapping
+                 */
 
-                if( header.size )
+                auto& segment = m_segments[ location.segmentId ];
+
+                if( ! segment.mapping )
                 {
-                    os::fwrite( m_file, data -> pv(), data -> size() );
+                    segment.mapping = cpp::SafeUniquePtr< os::ipc::file_mapping >::attach(
+                        new os::ipc::file_mapping(
+                            getSegmentPath( location.segmentId ).string().c_str(),
+                            os::ipc::read_only
+                            )
+                        );
                 }
 
-                BL_VERIFY( m_activeChunks.emplace( header.chunkId, header ).second );
+                return base_type::createMappedBlock(
+                    *segment.mapping,
+                    location.header.pos + sizeof( location.header ),
+                    location.header.size
+                    );
+            }
+
+            virtual void save(
+                SAA_in                  const uuid_t&                                   sessionId,
+                SAA_in                  const uuid_t&                                   chunkId,
+                SAA_in                  const om::ObjPtr< DataBlock >&                  data
+                ) OVERRIDE
+            {
+                BL_UNUSED( sessionId );
+
+                BL_MUTEX_GUARD( m_lock );
+
+                chkNotDisposed();
+
+                removeChunk( chunkId, false /* throwIfDoesNotExist */ );
+
+                appendChunk( chunkId, data -> pv(), data -> size() );
             }
 
             virtual void remove(
@@ -18,6 +18,7 @@
 #define __BL_MESSAGING_MESSAGINGUTILS_H_
 
 #include <baselib/messaging/MessagingCommonTypes.h>
+#include <baselib/messaging/BrokerProtocolRoutingInfo.h>
 #include <baselib/messaging/MessagingClientBlock.h>
 #include <baselib/messaging/MessagingClientBlockDispatch.h>
 #include <baselib/messaging/MessagingClientObject.h>
@@ -67,11 +68,6 @@ namespace bl
                     );
             }
 
-            static std::size_t defaultCapacity() NOEXCEPT
-            {
-                return DataBlock::defaultCapacity();
-            }
-
         public:
 
             typedef data::datablocks_pool_type                                          datablocks_pool_type;
@@ -199,6 +195,54 @@ namespace bl
                 }
             }
 
+            /**
+             * @brief Serializes the broker protocol message either as packed JSON or in the compact
+             * binary data model format
+             *
+             * The two formats are told apart by the first byte of the protocol data, so the receiving
+             * side always accepts both and the format is chosen by the sender (per connection)
+             *
+             * Binary protocol data is only sent as is to peers which have acknowledged the
+             * CommandBlock::CapabilityBinaryProtocolData capability during the protocol version
+             * negotiation; for older peers it is re-encoded as JSON by the block transfer client
+             * connection before it is sent (see TcpBlockTransferClientConnectionT::getDataToSend)
+             */
+
+            static auto serializeBrokerProtocol(
+                SAA_in              const om::ObjPtr< BrokerProtocol >&             brokerProtocol,
+                SAA_in_opt          const bool                                      useBinaryProtocol = false
+                )
+                -> std::string
+            {
+                return useBinaryProtocol ?
+                    dm::DataModelUtils::getBinaryString( brokerProtocol ) :
+                    dm::DataModelUtils::getDocAsPackedJsonString( brokerProtocol );
+            }
+
+            static auto deserializeBrokerProtocol(
+                SAA_in_bcount( size )       const char*                         data,
+                SAA_in                      const std::size_t                   size
+                )
+                -> om::ObjPtr< BrokerProtocol >
+            {
+                if( dm::DataModelUtils::isBinaryDoc( data, size ) )
+                {
+                    return dm::DataModelUtils::loadFromBinary< BrokerProtocol >( data, size );
+                }
+
+                return dm::DataModelUtils::loadFromJsonText< BrokerProtocol >( data, size );
+            }
+
+            static bool isBinaryProtocolData( SAA_in const om::ObjPtr< DataBlock >& data )
+            {
+                const auto protocolDataOffset = data -> offset1();
+
+                return dm::DataModelUtils::isBinaryDoc(
+                    data -> begin() + protocolDataOffset,
+                    data -> size() - protocolDataOffset
+                    );
+            }
+
             static void updateBrokerProtocolMessageInBlock(
                 SAA_in              const om::ObjPtr< BrokerProtocol >&             brokerProtocol,
                 SAA_in              const om::ObjPtr< DataBlock >&                  data,
@@ -226,33 +270,69 @@ namespace bl
                     return;
                 }
 
-                const auto jsonString = dm::DataModelUtils::getDocAsPackedJsonString( brokerProtocol );
+                /*
+                 * The message is re-encoded in the format it was sent in by the source peer
+                 */
+
+                const auto protocolString = serializeBrokerProtocol( brokerProtocol, isBinaryProtocolData( data ) );
 
                 const auto protocolDataOffset = data -> offset1();
 
-                if( protocolDataOffset + jsonString.size() > data -> capacity() )
-                {
-                    BL_THROW_SERVER_ERROR(
-                        BrokerErrorCodes::ProtocolValidationFailed,
-                        BL_MSG()
-                            << "DataBlock capacity is too small. capacity "
-                            <<  data -> capacity()
-                            << ", size "
-                            <<  data -> size()
-                            << ", old protocol data size "
-                            <<  data -> size() - protocolDataOffset
-                            << ", new protocol data size "
-                            <<  jsonString.size()
-                        );
-                }
+                /*
+                 * The blocks are allocated from the smallest size class which can fit the message
+                 * as it was received, so the block is grown (if necessary) to fit the updated
+                 * protocol data
+                 */
+
+                data -> reserve( protocolDataOffset + protocolString.size() );
 
                 std::memcpy(
                     data -> begin() + protocolDataOffset,
-                    jsonString.data(),
-                    jsonString.size()
+                    protocolString.data(),
+                    protocolString.size()
+                    );
+
+                data -> setSize( protocolDataOffset + protocolString.size() );
+            }
+
+            /**
+             * @brief Sets the source and target peer ids in the broker protocol message in the block
+             * if they were not provided by the sender
+             *
+             * JSON protocol messages are patched in place via BrokerProtocolRoutingInfo and only
+             * the messages which can't be handled by the routing fast path are deserialized, verified
+             * and re-encoded via updateBrokerProtocolMessageInBlock()
+             */
+
+            static void updateBrokerProtocolPeerIdsInBlock(
+                SAA_in              const om::ObjPtr< DataBlock >&                  data,
+                SAA_in              const uuid_t&                                   sourcePeerId,
+                SAA_in              const uuid_t&                                   targetPeerId
+                )
+            {
+                BrokerProtocolRoutingInfo routingInfo;
+
+                if( routingInfo.tryParse( data ) )
+                {
+                    ( void ) routingInfo.updateInBlock( data, sourcePeerId, targetPeerId );
+
+                    return;
+                }
+
+                const auto brokerProtocol = deserializeBrokerProtocol(
+                    data -> begin() + data -> offset1(),
+                    data -> size() - data -> offset1()
                     );
 
-                data -> setSize( protocolDataOffset + jsonString.size() );
+                verifyBrokerProtocolMessage( brokerProtocol );
+
+                updateBrokerProtocolMessageInBlock(
+                    brokerProtocol,
+                    data,
+                    sourcePeerId,
+                    targetPeerId,
+                    true                /* skipUpdateIfUnchanged */
+                    );
             }
 
             static void verifyPayloadMessage(
@@ -410,19 +490,33 @@ namespace bl
                 SAA_in                  const om::ObjPtr< BrokerProtocol >&             brokerProtocol,
                 SAA_in_opt              const om::ObjPtr< Payload >&                    payload,
                 SAA_in_opt              const om::ObjPtr< datablocks_pool_type >&       dataBlocksPool = nullptr,
-                SAA_in_opt              const std::size_t                               capacity = defaultCapacity()
+                SAA_in_opt              const std::size_t                               capacity = 0U,
+                SAA_in_opt              const bool                                      useBinaryProtocol = false
                 )
                 -> om::ObjPtr< DataBlock >
             {
-                auto dataBlock = DataBlock::get( dataBlocksPool, capacity );
-
-                const auto protocolDataString =
-                    dm::DataModelUtils::getDocAsPackedJsonString( brokerProtocol );
+                const auto protocolDataString = serializeBrokerProtocol( brokerProtocol, useBinaryProtocol );
 
                 const auto payloadDataString =
                     payload ? dm::DataModelUtils::getDocAsPackedJsonString( payload ) : std::string();
 
-                dataBlock -> setSize( payloadDataString.size() + protocolDataString.size() );
+                const auto dataSize = payloadDataString.size() + protocolDataString.size();
+
+                /*
+                 * If capacity is not specified the block is allocated from the smallest size class
+                 * which can fit the message; if it is specified, but it is too small then the block
+                 * is grown as necessary
+                 */
+
+                auto dataBlock =
+                    capacity ?
+                        DataBlock::get( dataBlocksPool, capacity )
+                        :
+                        DataBlock::getForSize( dataBlocksPool, dataSize );
+
+                dataBlock -> reserve( dataSize );
+
+                dataBlock -> setSize( dataSize );
                 dataBlock -> setOffset1( payloadDataString.size() );
 
                 if( payloadDataString.size() )
@@ -449,27 +543,22 @@ namespace bl
                 )
                 -> std::pair< om::ObjPtr< BrokerProtocol >, om::ObjPtr< Payload > /* optional */ >
             {
-                const std::string protocolDataString(
+                auto brokerProtocol = deserializeBrokerProtocol(
                     dataBlock -> begin() + dataBlock -> offset1(),
-                    dataBlock -> begin() + dataBlock -> size()
+                    dataBlock -> size() - dataBlock -> offset1()
                     );
 
-                auto brokerProtocol =
-                    dm::DataModelUtils::loadFromJsonText< BrokerProtocol >( protocolDataString );
-
                 verifyBrokerProtocolMessage( brokerProtocol );
 
                 om::ObjPtr< Payload > payload;
 
                 if( dataBlock -> offset1() && ! brokerProtocolOnly )
                 {
-                    const std::string payloadDataString(
+                    payload = dm::DataModelUtils::loadFromJsonText< Payload >(
                         dataBlock -> begin(),
-                        dataBlock -> begin() + dataBlock -> offset1()
+                        dataBlock -> offset1()
                         );
 
-                    payload = dm::DataModelUtils::loadFromJsonText< Payload >( payloadDataString );
-
                     verifyPayloadMessage( brokerProtocol, payload );
                 }
 
@@ -544,14 +633,17 @@ namespace bl
 
             const om::ObjPtr< block_dispatch_t >                                        m_target;
             const om::ObjPtr< datablocks_pool_type >                                    m_dataBlocksPool;
+            const bool                                                                  m_useBinaryProtocol;
 
             MessagingClientObjectDispatchFromBlockT(
                 SAA_in                  om::ObjPtr< block_dispatch_t >&&                target,
-                SAA_in_opt              om::ObjPtr< datablocks_pool_type >&&            dataBlocksPool = nullptr
+                SAA_in_opt              om::ObjPtr< datablocks_pool_type >&&            dataBlocksPool = nullptr,
+                SAA_in_opt              const bool                                      useBinaryProtocol = false
                 )
                 :
                 m_target( BL_PARAM_FWD( target ) ),
-                m_dataBlocksPool( BL_PARAM_FWD( dataBlocksPool ) )
+                m_dataBlocksPool( BL_PARAM_FWD( dataBlocksPool ) ),
+                m_useBinaryProtocol( useBinaryProtocol )
             {
             }
 
@@ -573,8 +665,13 @@ namespace bl
                 SAA_in_opt              CompletionCallback&&                            completionCallback = CompletionCallback()
                 ) OVERRIDE
             {
-                const auto dataBlock =
-                    MessagingUtils::serializeObjectsToBlock( brokerProtocol, payload, m_dataBlocksPool );
+                const auto dataBlock = MessagingUtils::serializeObjectsToBlock(
+                    brokerProtocol,
+                    payload,
+                    m_dataBlocksPool,
+                    0U                                  /* capacity */,
+                    m_useBinaryProtocol
+                    );
 
                 m_target -> pushBlock( targetPeerId, dataBlock, BL_PARAM_FWD( completionCallback ) );
             }
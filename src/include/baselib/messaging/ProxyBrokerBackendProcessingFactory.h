@@ -335,10 +335,10 @@ namespace bl
 
                         /*
                          * Block size should be 130% larger than the minimum / default required size and then
-                         * also aligned on 0.5K
+                         * also rounded up to a data block size class, so the blocks can be pooled
                          */
 
-                        return alignedOf( ( 130U * protocolDataString.size() ) / 100U, 512U );
+                        return data::DataBlock::capacityForSize( ( 130U * protocolDataString.size() ) / 100U );
                     }
 
                     static std::size_t getDeltaToLog( SAA_in const std::size_t maxNoOfSmallBlocks ) NOEXCEPT
@@ -1075,27 +1075,12 @@ namespace bl
                          * This will ensure that the final target peer of the message will receive the
                          * correct source peer id (instead of the peer id of the proxy connection)
                          *
-                         * TODO: note that this code which serializes and de-serializes the broker
-                         * protocol message must be done as part of the task instead of executing here
-                         * which can be on one of the non-blocking I/O threads, but this re-factoring
-                         * will be done as part of a subsequent change (this parsing operation should
-                         * be fast enough to not impact the server even if it is loaded)
+                         * Note that this code executes on one of the non-blocking I/O threads, but
+                         * in the common case the peer ids are patched in place by the routing fast
+                         * path (see BrokerProtocolRoutingInfo) without deserializing the message
                          */
 
-                        const auto messagesPair =
-                            MessagingUtils::deserializeBlockToObjects( data, true /* brokerProtocolOnly */ );
-
-                        BL_ASSERT( nullptr == messagesPair.second /* payload */ );
-
-                        const auto& brokerProtocol = messagesPair.first;
-
-                        MessagingUtils::updateBrokerProtocolMessageInBlock(
-                            brokerProtocol,
-                            data,
-                            sourcePeerId,
-                            targetPeerId,
-                            true                /* skipUpdateIfUnchanged */
-                            );
+                        MessagingUtils::updateBrokerProtocolPeerIdsInBlock( data, sourcePeerId, targetPeerId );
 
                         /*
                          * At this point we are ready to create the task that will dispatch the message
@@ -555,6 +555,22 @@ namespace bl
                 executeCommand( transfer_task_t::CommandId::ReceiveChunk, chunkId, data );
             }
 
+            virtual auto tryLoadMapped(
+                SAA_in                  const uuid_t&                                               sessionId,
+                SAA_in                  const uuid_t&                                               chunkId
+                )
+                -> om::ObjPtr< data::DataBlock > OVERRIDE
+            {
+                BL_UNUSED( sessionId );
+                BL_UNUSED( chunkId );
+
+                /*
+                 * The chunks are received from a remote storage, so they always have to be copied
+                 */
+
+                return nullptr;
+            }
+
             virtual void save(
                 SAA_in                  const uuid_t&                                               sessionId,
                 SAA_in                  const uuid_t&                                               chunkId,
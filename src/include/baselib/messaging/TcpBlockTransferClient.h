@@ -18,6 +18,7 @@
 #define __BL_MESSAGING_TCPBLOCKTRANSFERCLIENT_H_
 
 #include <baselib/messaging/TcpBlockTransferCommon.h>
+#include <baselib/messaging/MessagingCommonTypes.h>
 #include <baselib/messaging/BrokerErrorCodes.h>
 #include <baselib/messaging/AcceptorNotify.h>
 
@@ -68,12 +69,16 @@ namespace bl
             const om::ObjPtr< data::datablocks_pool_type >                                  m_dataBlocksPool;
             data::DataBlock*                                                                m_dataRawPtr;
             om::ObjPtr< data::DataBlock >                                                   m_dataLocalCopy;
+            data::DataBlock*                                                                m_dataToSend;
+            om::ObjPtr< data::DataBlock >                                                   m_dataProtocolFallback;
             cpp::ScalarTypeIniter< BlockTransferDefs::BlockType >                           m_blockType;
 
             CommandId                                                                       m_commandId;
             uuid_t                                                                          m_targetPeerId;
             cpp::ScalarTypeIniter< bool >                                                   m_clientVersionNegotiated;
             std::uint32_t                                                                   m_clientVersion;
+            cpp::ScalarTypeIniter< std::uint16_t >                                          m_peerCapabilities;
+            cpp::ScalarTypeIniter< bool >                                                   m_hasBrokerProtocolData;
             cpp::ScalarTypeIniter< bool >                                                   m_protocolOperationsOnly;
             cpp::ScalarTypeIniter< bool >                                                   m_isAuthenticated;
 
@@ -88,6 +93,7 @@ namespace bl
                 base_type( peerId ),
                 m_dataBlocksPool( om::copy( dataBlocksPool ) ),
                 m_dataRawPtr( nullptr ),
+                m_dataToSend( nullptr ),
                 m_blockType( blockType ),
                 m_commandId( commandId ),
                 m_targetPeerId( uuids::nil() ),
@@ -213,7 +219,16 @@ namespace bl
             {
                 if( ! m_dataRawPtr )
                 {
-                    m_dataLocalCopy = data::DataBlock::get( m_dataBlocksPool );
+                    /*
+                     * The chunk size is known at this point, so the block is allocated from the
+                     * smallest size class which can fit it (up to the default block capacity)
+                     */
+
+                    m_dataLocalCopy = data::DataBlock::getForSize(
+                        m_dataBlocksPool,
+                        std::min< std::size_t >( size, data::DataBlock::defaultCapacity() )
+                        );
+
                     m_dataRawPtr = m_dataLocalCopy.get();
                 }
 
@@ -334,6 +349,43 @@ namespace bl
 
                 m_cmdBuffer.host2Network();
 
+                if(
+                    CommandBlock::CntrlCodePutDataBlock == cntrlCode &&
+                    ( m_peerCapabilities & CommandBlock::CapabilityPutDataWithCommand )
+                    )
+                {
+                    /*
+                     * The server accepts the data right after the command, so the command block
+                     * and the data are sent with a single gather write (normally a single writev
+                     * call) and then there is only the final acknowledgment to read
+                     */
+
+                    BL_ASSERT( m_dataToSend );
+
+                    const std::array< asio::const_buffer, 2U > buffers =
+                    {{
+                        asio::buffer( &m_cmdBuffer, sizeof( m_cmdBuffer ) ),
+                        asio::buffer( m_dataToSend -> begin(), m_dataToSend -> size() )
+                    }};
+
+                    asio::async_write(
+                        getStream(),
+                        buffers,
+                        untilCanceled(),
+                        cpp::bind(
+                            &this_type::onCommandAckRead,
+                            om::ObjPtrCopyable< this_type >::acquireRef( this ),
+                            sizeof( m_cmdBuffer ) + m_dataToSend -> size()          /* bytesExpected */,
+                            cntrlCode                                               /* cntrlCodeExpected */,
+                            true                                                    /* terminationPacket */,
+                            asio::placeholders::error,
+                            asio::placeholders::bytes_transferred
+                            )
+                        );
+
+                    return;
+                }
+
                 asio::async_write(
                     getStream(),
                     asio::buffer( &m_cmdBuffer, sizeof( m_cmdBuffer ) ),
@@ -357,10 +409,67 @@ namespace bl
                 sendCtrlCode( CommandBlock::CntrlCodePeerSessionsDataFlushRequest );
             }
 
+            /**
+             * @brief Returns the block to be sent for the current put data command
+             *
+             * If the connection carries messaging blocks and the broker protocol data in the block is
+             * in the binary format, but the peer has not acknowledged that it can parse it (e.g. an
+             * older broker or receiver) then a copy of the block with the protocol data re-encoded
+             * as JSON is sent instead
+             */
+
+            data::DataBlock* getDataToSend()
+            {
+                const auto protocolDataOffset = m_dataRawPtr -> offset1();
+
+                if(
+                    ! m_hasBrokerProtocolData ||
+                    BlockTransferDefs::BlockType::Normal != m_blockType ||
+                    ( m_peerCapabilities & CommandBlock::CapabilityBinaryProtocolData ) ||
+                    ! dm::DataModelUtils::isBinaryDoc(
+                        m_dataRawPtr -> begin() + protocolDataOffset,
+                        m_dataRawPtr -> size() - protocolDataOffset
+                        )
+                    )
+                {
+                    return m_dataRawPtr;
+                }
+
+                const auto protocolString = dm::DataModelUtils::getDocAsPackedJsonString(
+                    dm::DataModelUtils::loadFromBinary< dm::messaging::BrokerProtocol >(
+                        m_dataRawPtr -> begin() + protocolDataOffset,
+                        m_dataRawPtr -> size() - protocolDataOffset
+                        )
+                    );
+
+                const auto size = protocolDataOffset + protocolString.size();
+
+                m_dataProtocolFallback = data::DataBlock::getForSize( m_dataBlocksPool, size );
+
+                std::memcpy( m_dataProtocolFallback -> begin(), m_dataRawPtr -> begin(), protocolDataOffset );
+
+                std::memcpy(
+                    m_dataProtocolFallback -> begin() + protocolDataOffset,
+                    protocolString.data(),
+                    protocolString.size()
+                    );
+
+                m_dataProtocolFallback -> setSize( size );
+                m_dataProtocolFallback -> setOffset1( protocolDataOffset );
+
+                return m_dataProtocolFallback.get();
+            }
+
             void scheduleSendData()
             {
                 BL_ASSERT( m_dataRawPtr && m_dataRawPtr -> size() );
-                m_cmdBuffer.chunkSize = ( std::uint32_t ) m_dataRawPtr -> size();
+
+                chkProtocolDataSize( m_dataRawPtr );
+
+                m_dataProtocolFallback.reset();
+                m_dataToSend = getDataToSend();
+
+                m_cmdBuffer.chunkSize = ( std::uint32_t ) m_dataToSend -> size();
 
                 sendCtrlCode( CommandBlock::CntrlCodePutDataBlock );
             }
@@ -402,14 +511,14 @@ namespace bl
 
                 if( CommandBlock::CntrlCodePutDataBlock == ctrlCode )
                 {
-                    chkProtocolDataSize( m_dataRawPtr );
+                    chkProtocolDataSize( m_dataToSend );
 
                     /*
                      * Note: this cast below is safe because the value of protocolDataOffset will be
                      * validated by chkProtocolDataSize call above to ensure that it fits into std::uint32_t
                      */
 
-                    m_cmdBuffer.data.blockInfo.protocolDataOffset = static_cast< std::uint32_t >( m_dataRawPtr -> offset1() );
+                    m_cmdBuffer.data.blockInfo.protocolDataOffset = static_cast< std::uint32_t >( m_dataToSend -> offset1() );
                 }
 
                 sendCommandPacket( ctrlCode, isTerminationPacket );
@@ -448,6 +557,7 @@ namespace bl
                 m_cmdBuffer = CommandBlock();
 
                 m_cmdBuffer.data.version.value = m_clientVersion;
+                m_cmdBuffer.data.version.capabilitiesRequested = CommandBlock::CapabilitiesSupported;
 
                 sendCommandPacket( CommandBlock::CntrlCodeSetProtocolVersion, isTerminationPacket );
             }
@@ -555,6 +665,9 @@ namespace bl
 
                     if( CommandBlock::CntrlCodePutDataBlock == cntrlCodeExpected )
                     {
+                        m_dataToSend = nullptr;
+                        m_dataProtocolFallback.reset();
+
                         if( m_blockType == BlockTransferDefs::BlockType::Authentication )
                         {
                             isAuthenticated( true );
@@ -632,6 +745,18 @@ namespace bl
 
                 m_cmdBuffer.flags &= ~( CommandBlock::AckBit | CommandBlock::ErrBit );
 
+                if( CommandBlock::CntrlCodeSetProtocolVersion == m_cmdBuffer.cntrlCode )
+                {
+                    /*
+                     * Older servers echo back the command block as it was sent and thus
+                     * capabilitiesAccepted will be zero (i.e. no optional capabilities)
+                     */
+
+                    m_peerCapabilities = static_cast< std::uint16_t >(
+                        m_cmdBuffer.data.version.capabilitiesAccepted & CommandBlock::CapabilitiesSupported
+                        );
+                }
+
                 if(
                     CommandBlock::CntrlCodeSetProtocolVersion == m_cmdBuffer.cntrlCode &&
                     m_cmdBuffer.peerId != base_type::m_remotePeerId &&
@@ -661,16 +786,16 @@ namespace bl
                      * We're sending data
                      */
 
-                    BL_ASSERT( m_dataRawPtr );
+                    BL_ASSERT( m_dataToSend );
 
                     asio::async_write(
                         getStream(),
-                        asio::buffer( m_dataRawPtr -> begin(), m_dataRawPtr -> size() ),
+                        asio::buffer( m_dataToSend -> begin(), m_dataToSend -> size() ),
                         untilCanceled(),
                         cpp::bind(
                             &this_type::onCommandAckRead,
                             om::ObjPtrCopyable< this_type >::acquireRef( this ),
-                            m_dataRawPtr -> size()                                      /* bytesExpected */,
+                            m_dataToSend -> size()                                      /* bytesExpected */,
                             CommandBlock::CntrlCodePutDataBlock                         /* cntrlCodeExpected */,
                             true                                                        /* terminationPacket */,
                             asio::placeholders::error,
@@ -844,6 +969,7 @@ namespace bl
                  */
 
                 m_clientVersionNegotiated = false;
+                m_peerCapabilities = 0U;
                 base_type::m_remotePeerId = uuids::nil();
             }
 
@@ -859,6 +985,31 @@ namespace bl
                 return m_isAuthenticated;
             }
 
+            /**
+             * @brief The optional capabilities (CommandBlock::Capability*) acknowledged by the
+             * server during the last protocol version negotiation
+             */
+
+            std::uint16_t peerCapabilities() const NOEXCEPT
+            {
+                return m_peerCapabilities;
+            }
+
+            /**
+             * @brief If the blocks sent on this connection are messaging blocks (i.e. the data
+             * after offset1() is the broker protocol message)
+             */
+
+            bool hasBrokerProtocolData() const NOEXCEPT
+            {
+                return m_hasBrokerProtocolData;
+            }
+
+            void hasBrokerProtocolData( SAA_in const bool hasBrokerProtocolData ) NOEXCEPT
+            {
+                m_hasBrokerProtocolData = hasBrokerProtocolData;
+            }
+
             void isAuthenticated( SAA_in const bool isAuthenticated ) NOEXCEPT
             {
                 m_isAuthenticated = isAuthenticated;
@@ -997,6 +1148,7 @@ namespace bl
                  */
 
                 m_clientVersionNegotiated = false;
+                m_peerCapabilities = 0U;
                 base_type::m_remotePeerId = uuids::nil();
             }
 
@@ -1392,6 +1544,7 @@ namespace bl
             {
                 m_connectionImpl -> attachStream( BL_PARAM_FWD( connectedStream ) );
                 m_connectionImpl -> clientVersion( tasks::detail::CommandBlock::BLOB_TRANSFER_PROTOCOL_CLIENT_VERSION_V2 );
+                m_connectionImpl -> hasBrokerProtocolData( true );
 
                 m_wrappedTask = om::copy( m_connectionTask );
             }
@@ -1466,6 +1619,25 @@ namespace bl
                 }
 
                 base_type::scheduleNothrow( eq, BL_PARAM_FWD( callbackReady ) );
+
+                BL_NOEXCEPT_BEGIN()
+
+                /*
+                 * If a block (or a heartbeat) was requested after continuationTask() has selected
+                 * the heartbeat timer task, but before it was (re-)scheduled above, the cancel
+                 * request issued by scheduleNow() was lost as it is cleared when the task is
+                 * restarted, so we need to re-check here or the block will sit in the queue for
+                 * the entire heartbeat interval
+                 */
+
+                BL_MUTEX_GUARD( m_lock );
+
+                if( ! m_pendingQueue.empty() || m_heartbeatWasRequested )
+                {
+                    scheduleNow();
+                }
+
+                BL_NOEXCEPT_END()
             }
 
             virtual void requestCancel() NOEXCEPT OVERRIDE
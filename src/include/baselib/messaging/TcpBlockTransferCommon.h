@@ -173,6 +173,40 @@ namespace bl
                     IgnoreIfNotFound                    = 0x0001,
                 };
 
+                /*
+                 * Optional peer capabilities (for the version.capabilitiesRequested and capabilitiesAccepted fields)
+                 *
+                 * The client sends the capabilities it supports in version.capabilitiesRequested
+                 * as part of the set protocol version command and the server acknowledges the ones
+                 * it supports too in version.capabilitiesAccepted; older servers simply echo back
+                 * the command block and since the client always sends capabilitiesAccepted as zero
+                 * they will be seen as not supporting any of the optional capabilities
+                 */
+
+                enum : std::uint16_t
+                {
+                    /*
+                     * @brief The peer can parse the broker protocol data encoded in the compact
+                     * binary data model format (in addition to JSON)
+                     */
+
+                    CapabilityBinaryProtocolData        = 0x0001,
+
+                    /*
+                     * @brief The peer accepts the data of a put data command right after the
+                     * command block (i.e. without acknowledging the command first), so the client
+                     * sends both with a single gather write and only the final acknowledgment is
+                     * sent back (after the data is processed)
+                     *
+                     * If the command fails before the data is read the server reads and discards
+                     * the data before it responds with the error
+                     */
+
+                    CapabilityPutDataWithCommand        = 0x0002,
+
+                    CapabilitiesSupported               = CapabilityBinaryProtocolData | CapabilityPutDataWithCommand,
+                };
+
                 union DataHeader
                 {
                     /*
@@ -196,9 +230,21 @@ namespace bl
                     }
                     reserved;
 
+                    /*
+                     * 'value' and 'capabilitiesRequested' fields match to 'reserved1' and
+                     * 'reserved2' fields above and 'capabilitiesAccepted' matches to the
+                     * 'reserved4' field
+                     *
+                     * The 'unused' field matches to 'reserved3' which is also the block type
+                     * (see below) and it is left as zero
+                     */
+
                     struct tagVersion
                     {
                         std::uint32_t                   value;
+                        std::uint32_t                   capabilitiesRequested;
+                        std::uint16_t                   unused;
+                        std::uint16_t                   capabilitiesAccepted;
                     }
                     version;
 
@@ -19,6 +19,8 @@
 
 #include <baselib/messaging/TcpBlockTransferCommon.h>
 
+#include <array>
+
 namespace bl
 {
     namespace tasks
@@ -155,6 +157,8 @@ namespace bl
 
             uuid_t                                                                      m_connectedSessionId;
             cpp::ScalarTypeIniter< std::uint32_t >                                      m_clientProtocolVersion;
+            cpp::ScalarTypeIniter< std::uint16_t >                                      m_clientCapabilities;
+            cpp::ScalarTypeIniter< std::uint32_t >                                      m_putDataPendingSize;
             cpp::ScalarTypeIniter< bool >                                               m_isFatalServerError;
             cpp::ScalarTypeIniter< bool >                                               m_isClientAuthenticated;
             cpp::ScalarTypeIniter< bool >                                               m_skipShutdownContinuation;
@@ -475,11 +479,7 @@ namespace bl
                     );
             }
 
-            void scheduleResponseCommand(
-                SAA_in                  const bool                                      newCommand,
-                SAA_in                  const callback_t&                               callback =
-                    &this_type::onTransferCompleted
-                )
+            void prepareResponseCommand() NOEXCEPT
             {
                 m_cmdBuffer.flags |= CommandBlock::AckBit;
 
@@ -503,6 +503,28 @@ namespace bl
                 }
 
                 m_cmdBuffer.host2Network();
+            }
+
+            void scheduleResponseCommand(
+                SAA_in                  const bool                                      newCommand,
+                SAA_in                  const callback_t&                               callback =
+                    &this_type::onTransferCompleted
+                )
+            {
+                if( m_putDataPendingSize )
+                {
+                    /*
+                     * The put data command is responded to (with an error) before its data was
+                     * read, so the data which follows the command must be read and discarded
+                     * first or otherwise it will be read as the next command
+                     */
+
+                    scheduleDiscardPutData( newCommand, callback );
+
+                    return;
+                }
+
+                prepareResponseCommand();
 
                 asio::async_write(
                     base_type::getStream(),
@@ -519,6 +541,60 @@ namespace bl
                     );
             }
 
+            void scheduleDiscardPutData(
+                SAA_in                  const bool                                      newCommand,
+                SAA_in                  const callback_t&                               callback
+                )
+            {
+                BL_ASSERT( m_putDataPendingSize );
+
+                detail::chkChunkSize( m_putDataPendingSize < base_type::MAX_CHUNK_SIZE );
+
+                auto block = data::DataBlock::get( m_serverState -> dataBlocksPool() );
+
+                const auto size = std::min< std::size_t >( m_putDataPendingSize, block -> capacity() );
+
+                const auto buffer = asio::buffer( block -> begin(), size );
+
+                asio::async_read(
+                    base_type::getStream(),
+                    buffer,
+                    untilCanceled(),
+                    cpp::bind(
+                        &this_type::onPutDataDiscarded,
+                        om::ObjPtrCopyable< this_type >::acquireRef( this ),
+                        om::ObjPtrCopyable< data::DataBlock >( std::move( block ) ),
+                        newCommand,
+                        callback,
+                        asio::placeholders::error,
+                        asio::placeholders::bytes_transferred
+                        )
+                    );
+            }
+
+            void onPutDataDiscarded(
+                SAA_in                  const om::ObjPtrCopyable< data::DataBlock >&    block,
+                SAA_in                  const bool                                      newCommand,
+                SAA_in                  const callback_t&                               callback,
+                SAA_in                  const eh::error_code&                           ec,
+                SAA_in                  const std::size_t                               bytesTransferred
+                ) NOEXCEPT
+            {
+                BL_TASKS_HANDLER_BEGIN_CHK_EC()
+
+                detail::chkPartialDataTransfer(
+                    bytesTransferred == std::min< std::size_t >( m_putDataPendingSize, block -> capacity() )
+                    );
+
+                m_putDataPendingSize.lvalue() -= static_cast< std::uint32_t >( bytesTransferred );
+
+                m_serverState -> dataBlocksPool() -> put( om::copy( block ) );
+
+                scheduleResponseCommand( newCommand, callback );
+
+                BL_TASKS_HANDLER_END_NOTREADY()
+            }
+
             void onCommandRead(
                 SAA_in                  const eh::error_code&                           ec,
                 SAA_in                  const std::size_t                               bytesTransferred
@@ -575,6 +651,18 @@ namespace bl
                         << m_cmdBuffer.flags
                     );
 
+                /*
+                 * If the client has negotiated CommandBlock::CapabilityPutDataWithCommand then
+                 * the data of a put data command follows the command block immediately
+                 */
+
+                m_putDataPendingSize =
+                    (
+                        CommandBlock::CntrlCodePutDataBlock == m_cmdBuffer.cntrlCode &&
+                        ( m_clientCapabilities & CommandBlock::CapabilityPutDataWithCommand )
+                    ) ?
+                        m_cmdBuffer.chunkSize : 0U;
+
                 if( ! m_clientProtocolVersion )
                 {
                     /*
@@ -786,6 +874,15 @@ namespace bl
 
                 if( CommandBlock::CntrlCodeSetProtocolVersion == m_cmdBuffer.cntrlCode )
                 {
+                    /*
+                     * Acknowledge the optional capabilities requested by the client which
+                     * are supported by the server too
+                     */
+
+                    m_cmdBuffer.data.version.capabilitiesAccepted = static_cast< std::uint16_t >(
+                        m_cmdBuffer.data.version.capabilitiesRequested & CommandBlock::CapabilitiesSupported
+                        );
+
                     if( m_cmdBuffer.data.version.value > CommandBlock::BLOB_TRANSFER_PROTOCOL_SERVER_VERSION )
                     {
                         /*
@@ -800,6 +897,7 @@ namespace bl
                     else
                     {
                         m_clientProtocolVersion = m_cmdBuffer.data.version.value;
+                        m_clientCapabilities = m_cmdBuffer.data.version.capabilitiesAccepted;
                     }
                 }
                 else
@@ -1032,7 +1130,7 @@ namespace bl
                             << chunkSizeExpected
                         );
 
-                    scheduleResponseCommand( true /* newCommand */, &this_type::onGetDataAck );
+                    scheduleGetDataResponse();
                 }
                 else
                 {
@@ -1197,38 +1295,43 @@ namespace bl
                      * Otherwise it will be responded later in the async callback
                      */
 
-                    scheduleResponseCommand( true /* newCommand */, &this_type::onGetDataAck );
+                    scheduleGetDataResponse();
                 }
             }
 
-            void onGetDataAck(
-                SAA_in                  const bool                                      newCommand,
-                SAA_in                  const std::size_t                               bytesExpected,
-                SAA_in                  const eh::error_code&                           ec,
-                SAA_in                  const std::size_t                               bytesTransferred
-                ) NOEXCEPT
+            void scheduleGetDataResponse()
             {
-                BL_TASKS_HANDLER_BEGIN_CHK_EC()
-
-                detail::chkPartialDataTransfer( bytesExpected == bytesTransferred );
+                /*
+                 * The response command block and the chunk data are sent with a single
+                 * gather write, so they normally go out in a single writev call (and
+                 * TCP segment for small chunks) instead of two separate writes
+                 */
 
                 BL_ASSERT( m_operationState -> data() && m_operationState -> data() -> size() );
 
+                prepareResponseCommand();
+
+                const auto& data = m_operationState -> data();
+
+                const std::array< asio::const_buffer, 2U > buffers =
+                {{
+                    asio::buffer( &m_cmdBuffer, sizeof( m_cmdBuffer ) ),
+                    asio::buffer( data -> begin(), data -> size() )
+                }};
+
                 asio::async_write(
                     base_type::getStream(),
-                    asio::buffer( m_operationState -> data() -> begin(), m_operationState -> data() -> size() ),
+                    buffers,
                     untilCanceled(),
                     cpp::bind(
                         &this_type::onTransferCompleted,
                         om::ObjPtrCopyable< this_type >::acquireRef( this ),
-                        newCommand,
-                        m_operationState -> data() -> size(),
+                        true /* newCommand */,
+                        sizeof( m_cmdBuffer ) + data -> size(),
                         asio::placeholders::error,
                         asio::placeholders::bytes_transferred
                         )
                     );
-
-                BL_TASKS_HANDLER_END_NOTREADY()
             }
 
             void schedulePutRequest()
@@ -1246,13 +1349,38 @@ namespace bl
                     m_cmdBuffer.peerId           /* targetPeerId */
                     );
 
-                const cpp::void_callback_t postAllocCallback =
-                    cpp::bind(
+                if( m_operationBlockType.value() != BlockTransferDefs::BlockType::TransferOnly )
+                {
+                    /*
+                     * The chunk size is known upfront, so the block can be allocated from
+                     * the smallest size class which can fit it
+                     */
+
+                    m_operationState -> dataSizeHint( m_cmdBuffer.chunkSize );
+                }
+
+                /*
+                 * If the data follows the command (see CommandBlock::CapabilityPutDataWithCommand)
+                 * it is read right after the block is allocated, otherwise the command must be
+                 * acknowledged first and then the client sends the data
+                 */
+
+                const cpp::void_callback_t postAllocCallback = m_putDataPendingSize ?
+                    cpp::void_callback_t(
+                        cpp::bind(
+                            &this_type::scheduleReadPutData,
+                            om::ObjPtrCopyable< this_type >::acquireRef( this )
+                            )
+                        )
+                    :
+                    cpp::void_callback_t(
+                        cpp::bind(
                             &this_type::scheduleResponseCommand,
                             om::ObjPtrCopyable< this_type >::acquireRef( this ),
                             false /* newCommand */,
                             &this_type::onPutDataAck
-                            );
+                            )
+                        );
 
                 m_serverState -> asyncWrapper() -> asyncExecutor() -> asyncBegin(
                     m_operation,
@@ -1295,28 +1423,41 @@ namespace bl
                      * We're now ready to receive the data
                      */
 
-                    BL_ASSERT(
-                        m_operationState -> data() &&
-                        m_operationState -> data() -> size() &&
-                        m_cmdBuffer.chunkSize == m_operationState -> data() -> size()
-                        );
-
-                    asio::async_read(
-                        base_type::getStream(),
-                        asio::buffer( m_operationState -> data() -> begin(), m_operationState -> data() -> size() ),
-                        untilCanceled(),
-                        cpp::bind(
-                                &this_type::onChunkReceived,
-                                om::ObjPtrCopyable< this_type >::acquireRef( this ),
-                                asio::placeholders::error,
-                                asio::placeholders::bytes_transferred
-                            )
-                        );
+                    scheduleReadPutData();
                 }
 
                 BL_TASKS_HANDLER_END_NOTREADY()
             }
 
+            void scheduleReadPutData()
+            {
+                BL_ASSERT(
+                    m_operationState -> data() &&
+                    m_operationState -> data() -> size() &&
+                    m_cmdBuffer.chunkSize == m_operationState -> data() -> size()
+                    );
+
+                /*
+                 * The acknowledgment is sent after the data is processed (if the data follows
+                 * the command it was not acknowledged yet)
+                 */
+
+                m_cmdBuffer.flags |= CommandBlock::AckBit;
+                m_putDataPendingSize = 0U;
+
+                asio::async_read(
+                    base_type::getStream(),
+                    asio::buffer( m_operationState -> data() -> begin(), m_operationState -> data() -> size() ),
+                    untilCanceled(),
+                    cpp::bind(
+                            &this_type::onChunkReceived,
+                            om::ObjPtrCopyable< this_type >::acquireRef( this ),
+                            asio::placeholders::error,
+                            asio::placeholders::bytes_transferred
+                        )
+                    );
+            }
+
             void clientSessionsDataFlush()
             {
                 /*
@@ -1518,6 +1659,7 @@ namespace bl
                  */
 
                 m_clientProtocolVersion = 0U;
+                m_clientCapabilities = 0U;
                 m_connectedSessionId = uuids::create();
             }
 
@@ -32,6 +32,9 @@
 #include <baselib/core/ObjModelDefs.h>
 #include <baselib/core/BaseIncludes.h>
 
+#include <algorithm>
+#include <deque>
+
 namespace bl
 {
     namespace messaging
@@ -121,6 +124,46 @@ namespace bl
                 MAX_MESSAGE_DELIVERY_ATTEMPTS           = 5
             };
 
+            enum : std::size_t
+            {
+                /*
+                 * The send window is the max # of messages which can be sent before their
+                 * acknowledgments are received
+                 *
+                 * The default of one message means strict stop-and-wait (i.e. each message
+                 * has to be acknowledged before the next one is sent) and the max is
+                 * bounded by the size of the pending queue of the remote peer as sending
+                 * more than that would just overflow it
+                 */
+
+                SEND_WINDOW_SIZE_DEFAULT                = 1U,
+                SEND_WINDOW_SIZE_MAX                    = BLOCK_QUEUE_SIZE,
+            };
+
+            /*
+             * A message which was passed to sendMessage(...) and which is yet to be handed
+             * over to the object dispatcher (or is being handed over currently)
+             *
+             * The delivery attempts are tracked per message, so a message which keeps
+             * failing does not consume the retries of the messages which follow it
+             */
+
+            struct OutgoingMessage
+            {
+                MessageInfo                                                             message;
+                cpp::ScalarTypeIniter< std::size_t >                                    retryCount;
+            };
+
+            /*
+             * A message which was sent and which is still waiting for acknowledgment
+             */
+
+            struct UnacknowledgedMessage
+            {
+                uuid_t                                                                  messageId;
+                time::ptime                                                             timeSent;
+            };
+
             enum : long
             {
                 TIMEOUT_IN_MILLISECONDS_DEFAULT         = 1000L,
@@ -150,18 +193,18 @@ namespace bl
             time::time_duration                                                         m_ackTimeout;
             time::time_duration                                                         m_msgTimeout;
             cpp::circular_buffer< MessageInfo >                                         m_pendingQueue;
-            time::ptime                                                                 m_lastUnacknowledgedMessageSent;
+            cpp::circular_buffer< MessageInfo >                                         m_pendingAcknowledgments;
+            cpp::circular_buffer< uuid_t >                                              m_receivedMessageIds;
             time::ptime                                                                 m_lastMessageReceived;
             time::time_duration                                                         m_timeout;
             cpp::ScalarTypeIniter< bool >                                               m_isFinished;
             cpp::ScalarTypeIniter< bool >                                               m_wasLastMessageSent;
-            cpp::ScalarTypeIniter< bool >                                               m_isAckExpected;
-            uuid_t                                                                      m_lastSentMessageId;
             MessageInfo                                                                 m_currentMessage;
-            om::ObjPtr< tasks::Task >                                                   m_processingTask;
 
-            cpp::ScalarTypeIniter< std::size_t >                                        m_retryCount;
-            MessageInfo                                                                 m_retryMessage;
+            std::size_t                                                                 m_sendWindowSize;
+            std::deque< UnacknowledgedMessage >                                         m_unacknowledgedMessages;
+            std::deque< OutgoingMessage >                                               m_outgoingQueue;
+            OutgoingMessage                                                             m_deliveryMessage;
 
             mutable os::mutex                                                           m_lock;
 
@@ -183,9 +226,11 @@ namespace bl
                 m_ackTimeout( time::milliseconds( TIMEOUT_IN_MILLISECONDS_ACK ) ),
                 m_msgTimeout( time::milliseconds( TIMEOUT_IN_MILLISECONDS_MSG ) ),
                 m_pendingQueue( BLOCK_QUEUE_SIZE ),
-                m_lastUnacknowledgedMessageSent( time::neg_infin ),
+                m_pendingAcknowledgments( BLOCK_QUEUE_SIZE ),
+                m_receivedMessageIds( BLOCK_QUEUE_SIZE ),
                 m_lastMessageReceived( time::microsec_clock::universal_time() ),
-                m_timeout( time::milliseconds( TIMEOUT_IN_MILLISECONDS_DEFAULT ) )
+                m_timeout( time::milliseconds( TIMEOUT_IN_MILLISECONDS_DEFAULT ) ),
+                m_sendWindowSize( SEND_WINDOW_SIZE_DEFAULT )
             {
             }
 
@@ -329,39 +374,113 @@ namespace bl
                         << payload
                     );
 
-                createProcessingTask( brokerProtocol, payload );
+                /*
+                 * The message is only queued here and it will be handed over to the object
+                 * dispatcher by the conversation processing task (see tryPopProcessingTask)
+                 */
+
+                OutgoingMessage outgoingMessage;
 
-                m_retryCount = 0;
-                m_retryMessage.brokerProtocol = om::copy( brokerProtocol );
-                m_retryMessage.payload = om::copy( payload );
+                outgoingMessage.message.brokerProtocol = om::copy( brokerProtocol );
+                outgoingMessage.message.payload = om::copy( payload );
+
+                m_outgoingQueue.push_back( std::move( outgoingMessage ) );
 
                 if( ! isAckMessage )
                 {
-                    m_lastSentMessageId = uuids::string2uuid( brokerProtocol -> messageId() );
-                    m_lastUnacknowledgedMessageSent = time::microsec_clock::universal_time();
-                    m_isAckExpected = true;
+                    UnacknowledgedMessage unacknowledgedMessage;
+
+                    unacknowledgedMessage.messageId = uuids::string2uuid( brokerProtocol -> messageId() );
+                    unacknowledgedMessage.timeSent = time::microsec_clock::universal_time();
+
+                    m_unacknowledgedMessages.push_back( std::move( unacknowledgedMessage ) );
+
                     m_wasLastMessageSent = isLastMessage;
                 }
             }
 
-            void createProcessingTask(
+            auto createProcessingTask(
                 SAA_in              const om::ObjPtr< BrokerProtocol >&                 brokerProtocol,
                 SAA_in_opt          const om::ObjPtr< payload_t >&                      payload
                 )
+                -> om::ObjPtr< tasks::Task >
             {
-                m_processingTask =
-                    tasks::ExternalCompletionTaskImpl::createInstance< tasks::Task >(
-                        cpp::bind(
-                            &object_dispatch_t::pushMessageCopyCallback,
-                            om::ObjPtrCopyable< object_dispatch_t >::acquireRef( m_objectDispatcher.get() ),
-                            m_targetPeerId,
-                            om::ObjPtrCopyable< BrokerProtocol >( brokerProtocol ),
-                            om::ObjPtrCopyable< Payload >(
-                                payload ? ASYNCRPCPOLICY::castToBasePayload( payload ) : nullptr
-                                ),
-                            _1 /* onReady - the completion callback */
-                            )
+                return tasks::ExternalCompletionTaskImpl::createInstance< tasks::Task >(
+                    cpp::bind(
+                        &object_dispatch_t::pushMessageCopyCallback,
+                        om::ObjPtrCopyable< object_dispatch_t >::acquireRef( m_objectDispatcher.get() ),
+                        m_targetPeerId,
+                        om::ObjPtrCopyable< BrokerProtocol >( brokerProtocol ),
+                        om::ObjPtrCopyable< Payload >(
+                            payload ? ASYNCRPCPOLICY::castToBasePayload( payload ) : nullptr
+                            ),
+                        _1 /* onReady - the completion callback */
+                        )
+                    );
+            }
+
+            void processAcknowledgments()
+            {
+                /*
+                 * The acknowledgments are selective - i.e. each one acknowledges exactly the
+                 * message with the same message id, so they can arrive in any order relative
+                 * to each other and to the messages which were sent in the same window
+                 */
+
+                while( ! m_pendingAcknowledgments.empty() )
+                {
+                    const auto& messageInfo = m_pendingAcknowledgments.front();
+
+                    BL_LOG_MULTILINE(
+                        Logging::trace(),
+                        BL_MSG()
+                            << "Acknowledgment message received:\n"
+                            << messageInfo
                         );
+
+                    const auto messageId = uuids::string2uuid( messageInfo.brokerProtocol -> messageId() );
+
+                    const auto pos = std::find_if(
+                        m_unacknowledgedMessages.begin(),
+                        m_unacknowledgedMessages.end(),
+                        [ & ]( SAA_in const UnacknowledgedMessage& unacknowledgedMessage ) -> bool
+                        {
+                            return unacknowledgedMessage.messageId == messageId;
+                        }
+                        );
+
+                    if( messageInfo.payload || pos == m_unacknowledgedMessages.end() )
+                    {
+                        BL_LOG_MULTILINE(
+                            Logging::debug(),
+                            BL_MSG()
+                                << "Acknowledgment message was received, but it has a payload or its "
+                                << "message id does not match any message awaiting acknowledgment:\n"
+                                << messageInfo
+                            );
+
+                        BL_THROW_EC(
+                            eh::errc::make_error_code( eh::errc::invalid_argument ),
+                            BL_MSG()
+                                << "Acknowledgment message was received, but it has a payload or its "
+                                << "message id does not match any message awaiting acknowledgment"
+                            );
+                    }
+
+                    m_unacknowledgedMessages.erase( pos );
+                    m_pendingAcknowledgments.pop_front();
+                }
+            }
+
+            bool wasMessageReceived( SAA_in const uuid_t& messageId ) const NOEXCEPT
+            {
+                return
+                    std::find(
+                        m_receivedMessageIds.begin(),
+                        m_receivedMessageIds.end(),
+                        messageId
+                        )
+                    != m_receivedMessageIds.end();
             }
 
             void sendErrorResponse(
@@ -462,16 +581,69 @@ namespace bl
                 m_msgTimeout = msgTimeout;
             }
 
-            auto tryPopProcessingTask() NOEXCEPT -> om::ObjPtr< tasks::Task >
+            auto sendWindowSize() const NOEXCEPT -> std::size_t
             {
-                return om::moveAs< tasks::Task >( m_processingTask );
+                return m_sendWindowSize;
+            }
+
+            void sendWindowSize( SAA_in const std::size_t sendWindowSize )
+            {
+                BL_CHK(
+                    false,
+                    sendWindowSize >= 1U && sendWindowSize <= SEND_WINDOW_SIZE_MAX,
+                    BL_MSG()
+                        << "Invalid send window size "
+                        << sendWindowSize
+                    );
+
+                BL_MUTEX_GUARD( m_lock );
+
+                m_sendWindowSize = sendWindowSize;
+            }
+
+            auto unacknowledgedMessagesCount() const NOEXCEPT -> std::size_t
+            {
+                BL_MUTEX_GUARD( m_lock );
+
+                return m_unacknowledgedMessages.size();
+            }
+
+            auto tryPopProcessingTask() -> om::ObjPtr< tasks::Task >
+            {
+                BL_MUTEX_GUARD( m_lock );
+
+                /*
+                 * If we are here then the previous task has completed successfully (or it was
+                 * re-queued for retry), so the message which was being delivered is done
+                 *
+                 * The outgoing messages are handed over to the object dispatcher one at a
+                 * time and in the order they were sent (a message which is retried is put
+                 * back in the front of the queue), so the receiver gets them in order
+                 */
+
+                m_deliveryMessage = OutgoingMessage();
+
+                if( m_outgoingQueue.empty() )
+                {
+                    return nullptr;
+                }
+
+                m_deliveryMessage = std::move( m_outgoingQueue.front() );
+                m_outgoingQueue.pop_front();
+
+                return createProcessingTask(
+                    m_deliveryMessage.message.brokerProtocol,
+                    m_deliveryMessage.message.payload
+                    );
             }
 
             bool retryProcessingTask( SAA_in const std::exception_ptr& eptr )
             {
+                BL_MUTEX_GUARD( m_lock );
+
                 if(
-                    ++m_retryCount >= MAX_MESSAGE_DELIVERY_ATTEMPTS ||
-                    m_retryMessage.brokerProtocol == nullptr
+                    m_deliveryMessage.message.brokerProtocol == nullptr ||
+                    ++m_deliveryMessage.retryCount.lvalue() >= MAX_MESSAGE_DELIVERY_ATTEMPTS
                     )
                 {
                     return false;
@@ -485,12 +657,16 @@ namespace bl
                         Logging::debug(),
                         BL_MSG()
                             << "Retry # "
-                            << m_retryCount
-                            << " to send message payload to peer with id "
+                            << m_deliveryMessage.retryCount
+                            << " to send message "
+                            << m_deliveryMessage.message.brokerProtocol -> messageId()
+                            << " to peer with id "
                             << m_targetPeerId
                         );
 
-                    createProcessingTask( m_retryMessage.brokerProtocol, m_retryMessage.payload );
+                    m_outgoingQueue.push_front( std::move( m_deliveryMessage ) );
+
+                    m_deliveryMessage = OutgoingMessage();
                 }
 
                 return doRetry;
@@ -502,30 +678,32 @@ namespace bl
                  * The basic state machine loop is as follows - unless finished:
                  *
                  * 1. if it is finished then exit
-                 * 2. if acknowledgment message is expected then wait until it gets delivered
-                 * 3. if there are no current message pop one from the queue (if any)
-                 * 4. call processing of the current message
-                 * 5. if the processing function is done processing the message it should set
+                 * 2. process the acknowledgments received for the messages in the send window
+                 * 3. if the send window is full then wait until acknowledgments get delivered
+                 * 4. if there are no current message pop one from the queue (if any)
+                 * 5. call processing of the current message
+                 * 6. if the processing function is done processing the message it should set
                  *    it to empty
                  */
 
                 BL_MUTEX_GUARD( m_lock );
 
-                if( m_isFinished || m_processingTask )
+                if( m_isFinished )
                 {
                     return;
                 }
 
-                if( m_isAckExpected )
-                {
-                    BL_ASSERT( ! m_lastUnacknowledgedMessageSent.is_special() );
+                processAcknowledgments();
 
+                if( ! m_unacknowledgedMessages.empty() )
+                {
                     /*
-                     * We are waiting for acknowledgment message for a message that we just sent
+                     * We are waiting for acknowledgment messages for messages that we have sent
+                     * and the oldest one is the first in the window
                      */
 
                     const auto delta =
-                        time::microsec_clock::universal_time() - m_lastUnacknowledgedMessageSent;
+                        time::microsec_clock::universal_time() - m_unacknowledgedMessages.front().timeSent;
 
                     BL_CHK_T_USER_FRIENDLY(
                         true,
@@ -536,53 +714,15 @@ namespace bl
                             << "Messaging client did not receive acknowledgment within the specified interval "
                             << m_ackTimeout
                         );
+                }
 
-                    if( m_pendingQueue.empty() )
+                if( m_wasLastMessageSent )
+                {
+                    if( ! m_unacknowledgedMessages.empty() )
                     {
                         return;
                     }
 
-                    const auto& messageInfo = m_pendingQueue.front();
-                    const auto& protocol = messageInfo.brokerProtocol;
-
-                    BL_LOG_MULTILINE(
-                        Logging::trace(),
-                        BL_MSG()
-                            << "Acknowledgment message received:\n"
-                            << messageInfo
-                        );
-
-                    if(
-                        messageInfo.payload ||
-                        MessageType::AsyncRpcAcknowledgment != MessageType::toEnum( protocol -> messageType() ) ||
-                        m_lastSentMessageId != uuids::string2uuid( protocol -> messageId() )
-                        )
-                    {
-                        BL_LOG_MULTILINE(
-                            Logging::debug(),
-                            BL_MSG()
-                                << "Acknowledgment message is expected but a different "
-                                << "one was received or the message id does not match:\n"
-                                << messageInfo
-                            );
-
-                        BL_THROW_EC(
-                            eh::errc::make_error_code( eh::errc::invalid_argument ),
-                            BL_MSG()
-                                << "Acknowledgment message is expected but a different "
-                                << "one was received or the message id does not match"
-                            );
-                    }
-
-                    m_lastSentMessageId = uuids::nil();
-                    m_pendingQueue.pop_front();
-
-                    m_lastUnacknowledgedMessageSent = time::neg_infin;
-                    m_isAckExpected = false;
-                }
-
-                if( m_wasLastMessageSent )
-                {
                     /*
                      * The last message was sent and acknowledged for this conversation
                      * and we are ready to finish the processing now
@@ -613,6 +753,11 @@ namespace bl
                     return;
                 }
 
+                if( m_unacknowledgedMessages.size() >= m_sendWindowSize )
+                {
+                    return;
+                }
+
                 if( m_seedMessage.brokerProtocol )
                 {
                     /*
@@ -630,83 +775,107 @@ namespace bl
                     return;
                 }
 
-                if( nullptr == m_currentMessage.brokerProtocol && ! m_pendingQueue.empty() )
+                for( ;; )
                 {
-                    /*
-                     * Check if this is a request type message and if so then we will insist that it
-                     * is authenticated
-                     */
-
-                    m_currentMessage = std::move( m_pendingQueue.front() );
-                    m_pendingQueue.pop_front();
+                    if( nullptr == m_currentMessage.brokerProtocol && ! m_pendingQueue.empty() )
+                    {
+                        /*
+                         * Check if this is a request type message and if so then we will insist that it
+                         * is authenticated
+                         */
 
-                    const auto messageType =
-                        MessageType::toEnum( m_currentMessage.brokerProtocol -> messageType() );
+                        m_currentMessage = std::move( m_pendingQueue.front() );
+                        m_pendingQueue.pop_front();
 
-                    BL_LOG_MULTILINE(
-                        Logging::trace(),
-                        BL_MSG()
-                            << "Processing message:\n"
-                            << m_currentMessage
-                        );
+                        const auto messageType =
+                            MessageType::toEnum( m_currentMessage.brokerProtocol -> messageType() );
 
-                    if(
-                        MessageType::AsyncRpcDispatch == messageType &&
-                        m_currentMessage.payload &&
-                        m_currentMessage.payload -> asyncRpcRequest()
-                        )
-                    {
-                        const auto& identityInfo =
-                            m_currentMessage.brokerProtocol -> principalIdentityInfo();
+                        BL_LOG_MULTILINE(
+                            Logging::trace(),
+                            BL_MSG()
+                                << "Processing message:\n"
+                                << m_currentMessage
+                            );
 
-                        if( ! identityInfo || ! identityInfo -> securityPrincipal() )
+                        if(
+                            MessageType::AsyncRpcDispatch == messageType &&
+                            m_currentMessage.payload &&
+                            m_currentMessage.payload -> asyncRpcRequest()
+                            )
                         {
-                            sendErrorResponse(
-                                eh::errc::permission_denied                 /* errorCondition */,
-                                "Request messages must be authenticated"        /* message */
-                                );
+                            const auto& identityInfo =
+                                m_currentMessage.brokerProtocol -> principalIdentityInfo();
 
-                            m_currentMessage = MessageInfo();
+                            if( ! identityInfo || ! identityInfo -> securityPrincipal() )
+                            {
+                                sendErrorResponse(
+                                    eh::errc::permission_denied                 /* errorCondition */,
+                                    "Request messages must be authenticated"        /* message */
+                                    );
 
-                            return;
+                                m_currentMessage = MessageInfo();
+
+                                return;
+                            }
                         }
+
+                        m_lastMessageReceived = time::microsec_clock::universal_time();
                     }
 
-                    m_lastMessageReceived = time::microsec_clock::universal_time();
-                }
+                    const auto outgoingCount = m_outgoingQueue.size();
+
+                    if( m_currentMessage.brokerProtocol )
+                    {
+                        utils::tryCatchLog(
+                            "Message conversation failed to process current message",
+                            [ & ]() -> void
+                            {
+                                processCurrentMessage();
+                            } /* cbBlock */,
+                            [ & ]() -> void
+                            {
+                                throw;
+                            } /* cbOnError */
+                            );
+                    }
+                    else
+                    {
+                        /*
+                         * Check if we have waited too much and we should timeout
+                         */
+
+                        const auto delta =
+                            time::microsec_clock::universal_time() - m_lastMessageReceived;
+
+                        BL_CHK_T_USER_FRIENDLY(
+                            true,
+                            delta >= m_msgTimeout,
+                            TimeoutException()
+                                << eh::errinfo_error_uuid( uuiddefs::ErrorUuidResponseTimeout() ),
+                            BL_MSG()
+                                << "Messaging client did not receive response within the specified interval "
+                                << m_msgTimeout
+                            );
+
+                        return;
+                    }
 
-                if( m_currentMessage.brokerProtocol )
-                {
-                    utils::tryCatchLog(
-                        "Message conversation failed to process current message",
-                        [ & ]() -> void
-                        {
-                            processCurrentMessage();
-                        } /* cbBlock */,
-                        [ & ]() -> void
-                        {
-                            throw;
-                        } /* cbOnError */
-                        );
-                }
-                else
-                {
                     /*
-                     * Check if we have waited too much and we should timeout
+                     * If the current message was processed completely and nothing was sent
+                     * then continue with the next queued message right away rather than in
+                     * the next round, so a receiver does not fall behind a sender which can
+                     * deliver up to a whole send window of messages per round
                      */
 
-                    const auto delta =
-                        time::microsec_clock::universal_time() - m_lastMessageReceived;
-
-                    BL_CHK_T_USER_FRIENDLY(
-                        true,
-                        delta >= m_msgTimeout,
-                        TimeoutException()
-                            << eh::errinfo_error_uuid( uuiddefs::ErrorUuidResponseTimeout() ),
-                        BL_MSG()
-                            << "Messaging client did not receive response within the specified interval "
-                            << m_msgTimeout
-                        );
+                    if(
+                        m_isFinished ||
+                        m_currentMessage.brokerProtocol ||
+                        m_pendingQueue.empty() ||
+                        m_outgoingQueue.size() != outgoingCount
+                        )
+                    {
+                        return;
+                    }
                 }
             }
 
@@ -728,7 +897,19 @@ namespace bl
                         << str::quoteString( uuids::uuid2string( m_peerId ) )
                     );
 
-                if( m_pendingQueue.full() )
+                const auto messageType = MessageType::toEnum( brokerProtocol -> messageType() );
+
+                const bool isAckMessage = MessageType::AsyncRpcAcknowledgment == messageType;
+
+                /*
+                 * The acknowledgment messages are kept in a separate queue, so they can be
+                 * processed as soon as they arrive and don't have to wait behind the
+                 * messages which are still pending processing
+                 */
+
+                auto& queue = isAckMessage ? m_pendingAcknowledgments : m_pendingQueue;
+
+                if( queue.full() )
                 {
                     BL_THROW_EC(
                         eh::errc::make_error_code( BrokerErrorCodes::TargetPeerQueueFull ),
@@ -746,9 +927,7 @@ namespace bl
                  * of acknowledgment message type of course)
                  */
 
-                const auto messageType = MessageType::toEnum( brokerProtocol -> messageType() );
-
-                if( MessageType::AsyncRpcAcknowledgment != messageType )
+                if( ! isAckMessage )
                 {
                     const auto& sourcePeerId = brokerProtocol -> sourcePeerId();
 
@@ -770,12 +949,32 @@ namespace bl
                             << str::quoteString( uuids::uuid2string( m_targetPeerId ) )
                         );
 
+                    const auto messageId = uuids::string2uuid( brokerProtocol -> messageId() );
+
+                    if( wasMessageReceived( messageId ) )
+                    {
+                        /*
+                         * The message is a duplicate caused by a delivery retry on the remote
+                         * peer side - it was already acknowledged and queued, so just drop it
+                         */
+
+                        BL_LOG_MULTILINE(
+                            Logging::debug(),
+                            BL_MSG()
+                                << "Duplicate message was received for conversation "
+                                << str::quoteString( uuids::uuid2string( m_conversationId ) )
+                                << ":\n"
+                                << brokerProtocol
+                            );
+
+                        return;
+                    }
+
+                    m_receivedMessageIds.push_back( messageId );
+
                     sendMessage(
                         false /* isLastMessage */,
-                        MessagingUtils::createAcknowledgmentMessage(
-                            m_conversationId,
-                            uuids::string2uuid( brokerProtocol -> messageId() )
-                            ),
+                        MessagingUtils::createAcknowledgmentMessage( m_conversationId, messageId ),
                         nullptr /* payload */
                         );
                 }
@@ -785,7 +984,7 @@ namespace bl
                 messageInfo.brokerProtocol = brokerProtocol;
                 messageInfo.payload = payload ? ASYNCRPCPOLICY::castToPayload( payload ) : nullptr;
 
-                m_pendingQueue.push_back( std::move( messageInfo ) );
+                queue.push_back( std::move( messageInfo ) );
             }
 
             bool isConnected() const NOEXCEPT
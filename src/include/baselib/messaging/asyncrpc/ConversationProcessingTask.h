@@ -131,8 +131,31 @@ namespace bl
 
                 BL_MUTEX_GUARD( m_lock );
 
+                /*
+                 * The tasks which deliver the outgoing messages are interleaved with the
+                 * processing task, so the processing of the received messages can't be
+                 * starved by a steady stream of acknowledgments to be sent
+                 */
+
+                const bool wasImplTask =
+                    m_wrappedTask != m_processingTask && m_wrappedTask != m_timerTask;
+
                 if( m_impl -> isFinished() )
                 {
+                    /*
+                     * Deliver the messages which are still queued (e.g. the acknowledgments
+                     * for the last messages received) before finishing
+                     */
+
+                    auto implTask = exception ? nullptr : m_impl -> tryPopProcessingTask();
+
+                    if( implTask )
+                    {
+                        m_wrappedTask = std::move( implTask );
+
+                        return om::copyAs< Task >( this );
+                    }
+
                     return nullptr;
                 }
 
@@ -166,7 +189,7 @@ namespace bl
                  * implementation's own processing task, execute it now if so
                  */
 
-                auto implTask = m_impl -> tryPopProcessingTask();
+                auto implTask = wasImplTask ? nullptr : m_impl -> tryPopProcessingTask();
 
                 if( implTask )
                 {
@@ -29,14 +29,344 @@
 
 #include <baselib/core/ObjModel.h>
 #include <baselib/core/ObjModelDefs.h>
+#include <baselib/core/Random.h>
 #include <baselib/core/OS.h>
 
 #include <baselib/core/BaseIncludes.h>
 
+#include <atomic>
+#include <list>
+#include <unordered_map>
+
+BL_IID_DECLARE( AuthorizationRefreshWaiter, "f6e78701-2d3c-43ee-be27-992554233f58" )
+
 namespace bl
 {
     namespace security
     {
+        namespace detail
+        {
+            /**
+             * @brief class AuthorizationRefresh - the state of an authorization refresh which is
+             * in flight for a particular authentication token
+             *
+             * The waiters are the completion callbacks of the tasks which wait for the refresh
+             * to complete instead of issuing their own authorization requests
+             */
+
+            template
+            <
+                typename E = void
+            >
+            class AuthorizationRefreshT : public om::ObjectDefaultBase
+            {
+                BL_CTR_DEFAULT( AuthorizationRefreshT, protected )
+                BL_DECLARE_OBJECT_IMPL_DEFAULT( AuthorizationRefreshT )
+
+            protected:
+
+                mutable os::mutex                                                   m_lock;
+                cpp::ScalarTypeIniter< bool >                                       m_completed;
+                om::ObjPtrCopyable< SecurityPrincipal >                             m_principal;
+                std::exception_ptr                                                  m_exception;
+                std::vector< tasks::CompletionCallback >                            m_waiters;
+
+            public:
+
+                /**
+                 * @brief Returns false if the refresh has already completed successfully (i.e. the
+                 * wait completed synchronously) and throws if it has already failed, otherwise the
+                 * callback is registered and will be invoked when the refresh completes
+                 */
+
+                bool tryWait( SAA_in const tasks::CompletionCallback& onReady )
+                {
+                    BL_MUTEX_GUARD( m_lock );
+
+                    if( m_completed )
+                    {
+                        if( m_exception )
+                        {
+                            cpp::safeRethrowException( m_exception );
+                        }
+
+                        return false;
+                    }
+
+                    m_waiters.push_back( onReady );
+
+                    return true;
+                }
+
+                void complete(
+                    SAA_in_opt          const om::ObjPtr< SecurityPrincipal >&      principal,
+                    SAA_in_opt          const std::exception_ptr&                   eptr
+                    ) NOEXCEPT
+                {
+                    BL_NOEXCEPT_BEGIN()
+
+                    std::vector< tasks::CompletionCallback > waiters;
+
+                    {
+                        BL_MUTEX_GUARD( m_lock );
+
+                        if( m_completed )
+                        {
+                            return;
+                        }
+
+                        m_completed = true;
+                        m_principal = om::copy( principal );
+                        m_exception = eptr;
+
+                        waiters.swap( m_waiters );
+                    }
+
+                    /*
+                     * The waiters are notified outside of the lock as the notification
+                     * takes the lock of the waiting task
+                     */
+
+                    for( const auto& onReady : waiters )
+                    {
+                        onReady( eptr );
+                    }
+
+                    BL_NOEXCEPT_END()
+                }
+
+                auto principal() const -> om::ObjPtr< SecurityPrincipal >
+                {
+                    BL_MUTEX_GUARD( m_lock );
+
+                    return om::copy( m_principal );
+                }
+            };
+
+            typedef om::ObjectImpl< AuthorizationRefreshT<> > AuthorizationRefresh;
+
+            /**
+             * @brief interface AuthorizationRefreshWaiter - implemented by the tasks which are
+             * created by the authorization cache and which obtain the security principal as part
+             * of an authorization refresh (either by issuing it or by waiting for it)
+             */
+
+            class AuthorizationRefreshWaiter : public om::Object
+            {
+                BL_DECLARE_INTERFACE( AuthorizationRefreshWaiter )
+
+            public:
+
+                /**
+                 * @brief Returns the security principal obtained once the task has executed
+                 * successfully
+                 */
+
+                virtual auto principal() const -> om::ObjPtr< SecurityPrincipal > = 0;
+            };
+
+            /**
+             * @brief class AuthorizationRefreshWaiterTask - a task which completes when the
+             * authorization refresh completes (and with the same result)
+             */
+
+            template
+            <
+                typename E = void
+            >
+            class AuthorizationRefreshWaiterTaskT :
+                public tasks::ExternalCompletionTaskIfT<>,
+                public AuthorizationRefreshWaiter
+            {
+            protected:
+
+                typedef tasks::ExternalCompletionTaskIfT<>                          base_type;
+
+            private:
+
+                BL_DECLARE_OBJECT_IMPL( AuthorizationRefreshWaiterTaskT )
+
+                BL_QITBL_BEGIN()
+                    BL_QITBL_ENTRY_CHAIN_BASE( base_type )
+                    BL_QITBL_ENTRY( AuthorizationRefreshWaiter )
+                BL_QITBL_END( tasks::Task )
+
+            protected:
+
+                const om::ObjPtr< AuthorizationRefresh >                            m_refresh;
+
+                AuthorizationRefreshWaiterTaskT( SAA_in om::ObjPtr< AuthorizationRefresh >&& refresh )
+                    :
+                    base_type(
+                        cpp::bind(
+                            &AuthorizationRefresh::tryWait,
+                            om::ObjPtrCopyable< AuthorizationRefresh >( refresh ),
+                            _1 /* onReady */
+                            )
+                        ),
+                    m_refresh( BL_PARAM_FWD( refresh ) )
+                {
+                }
+
+            public:
+
+                virtual auto principal() const -> om::ObjPtr< SecurityPrincipal > OVERRIDE
+                {
+                    return m_refresh -> principal();
+                }
+            };
+
+            typedef om::ObjectImpl< AuthorizationRefreshWaiterTaskT<> > AuthorizationRefreshWaiterTask;
+
+            /**
+             * @brief class AuthorizationRefreshLeaderTask - a task which wraps the authorization task
+             * issued for a refresh and completes the refresh once it has executed (successfully or not)
+             *
+             * The refresh is completed by a continuation task (and not in continuationTask() itself)
+             * as the waiters can't be notified while the execution queue lock is held
+             *
+             * If the task is released before it has completed the refresh (e.g. because it was never
+             * executed) then the completion callback is invoked from the destructor with nullptr task,
+             * so the refresh is abandoned and the tasks waiting for it fail instead of hanging
+             */
+
+            template
+            <
+                typename E = void
+            >
+            class AuthorizationRefreshLeaderTaskT :
+                public tasks::WrapperTaskBase,
+                public AuthorizationRefreshWaiter
+            {
+            public:
+
+                typedef cpp::function
+                <
+                    om::ObjPtr< SecurityPrincipal > (
+                        SAA_in_opt          const om::ObjPtr< tasks::Task >&        executedAuthorizationTask,
+                        SAA_in_opt          const std::exception_ptr&               taskException,
+                        SAA_out             std::exception_ptr&                     eptr
+                        ) NOEXCEPT
+                >
+                completion_callback_t;
+
+            protected:
+
+                typedef AuthorizationRefreshLeaderTaskT< E >                        this_type;
+                typedef tasks::WrapperTaskBase                                      base_type;
+
+            private:
+
+                BL_DECLARE_OBJECT_IMPL_NO_DESTRUCTOR( AuthorizationRefreshLeaderTaskT )
+
+                BL_QITBL_BEGIN()
+                    BL_QITBL_ENTRY_CHAIN_BASE( base_type )
+                    BL_QITBL_ENTRY( AuthorizationRefreshWaiter )
+                BL_QITBL_END( tasks::Task )
+
+            protected:
+
+                const om::ObjPtr< tasks::Task >                                     m_authorizationTask;
+                completion_callback_t                                               m_completionCallback;
+                std::exception_ptr                                                  m_taskException;
+                om::ObjPtr< SecurityPrincipal >                                     m_principal;
+                cpp::ScalarTypeIniter< bool >                                       m_completing;
+
+                AuthorizationRefreshLeaderTaskT(
+                    SAA_in          om::ObjPtr< tasks::Task >&&                     authorizationTask,
+                    SAA_in          completion_callback_t&&                         completionCallback
+                    )
+                    :
+                    base_type( om::copy( authorizationTask ) ),
+                    m_authorizationTask( BL_PARAM_FWD( authorizationTask ) ),
+                    m_completionCallback( BL_PARAM_FWD( completionCallback ) )
+                {
+                }
+
+                ~AuthorizationRefreshLeaderTaskT() NOEXCEPT
+                {
+                    if( m_completionCallback )
+                    {
+                        std::exception_ptr eptr;
+
+                        ( void ) m_completionCallback( nullptr /* executedAuthorizationTask */, nullptr, eptr );
+                    }
+                }
+
+                void completeRefresh()
+                {
+                    completion_callback_t completionCallback;
+                    std::exception_ptr taskException;
+
+                    {
+                        BL_MUTEX_GUARD( m_lock );
+
+                        completionCallback.swap( m_completionCallback );
+                        taskException = m_taskException;
+                    }
+
+                    BL_ASSERT( completionCallback );
+
+                    std::exception_ptr eptr;
+
+                    auto principal = completionCallback( m_authorizationTask, taskException, eptr );
+
+                    if( eptr )
+                    {
+                        cpp::safeRethrowException( eptr );
+                    }
+
+                    BL_MUTEX_GUARD( m_lock );
+
+                    m_principal = std::move( principal );
+                }
+
+            public:
+
+                virtual auto principal() const -> om::ObjPtr< SecurityPrincipal > OVERRIDE
+                {
+                    BL_MUTEX_GUARD( m_lock );
+
+                    return om::copy( m_principal );
+                }
+
+                virtual om::ObjPtr< tasks::Task > continuationTask() OVERRIDE
+                {
+                    auto task = base_type::handleContinuationForward();
+
+                    if( task )
+                    {
+                        return task;
+                    }
+
+                    BL_MUTEX_GUARD( m_lock );
+
+                    if( m_completing )
+                    {
+                        return nullptr;
+                    }
+
+                    /*
+                     * The authorization task has executed - complete the refresh in a continuation
+                     * task which fails with the authorization failure (if any)
+                     */
+
+                    m_taskException = m_wrappedTask -> exception();
+
+                    m_wrappedTask = tasks::SimpleTaskImpl::createInstance< tasks::Task >(
+                        cpp::bind( &this_type::completeRefresh, this )
+                        );
+
+                    m_completing = true;
+
+                    return om::copyAs< tasks::Task >( this );
+                }
+            };
+
+            typedef om::ObjectImpl< AuthorizationRefreshLeaderTaskT<> > AuthorizationRefreshLeaderTask;
+
+        } // detail
+
         /**
          * @brief class AuthorizationCacheImpl - an implementation of the authorization cache interface
          * based on an authorization service implementation
@@ -61,6 +391,26 @@ namespace bl
          *     [static] auto extractSecurityPrincipal( SAA_in const om::ObjPtr< tasks::Task >& executedAuthorizationTask )
          *         -> om::ObjPtr< SecurityPrincipal >;
          * };
+         *
+         * The cache is split into STRIPES_COUNT stripes (selected by the key hash) each with its own
+         * lock and its own LRU list, so the number of entries is bounded (the least recently used
+         * entries of a stripe are evicted when the stripe is full) and the requests for different
+         * tokens do not contend on a single lock
+         *
+         * The authorization requests are coalesced per token (single-flight) - i.e. while one
+         * authorization task for a token is in flight createAuthorizationTask( ... ) returns tasks
+         * which simply wait for it to complete and then update( ... ) returns the principal obtained
+         * by it (if the task issued is stuck then another one is issued after REFRESH_TIMEOUT)
+         *
+         * The task issued completes the refresh itself when it executes (successfully or not) or
+         * when it is released without being executed, so the waiting tasks never depend on the
+         * caller to invoke update( ... ) for it
+         *
+         * If a stale interval is configured then an entry which is older than the freshness interval
+         * but not older than the freshness interval plus the stale interval is still returned by
+         * tryGetAuthorizedPrinciplal( ... ) to all callers but one which gets nullptr and is
+         * expected to refresh it (stale-while-revalidate), so when the freshness interval of a
+         * popular token expires only one request pays the latency of the authorization service
          */
 
         template
@@ -76,33 +426,108 @@ namespace bl
             enum : std::size_t
             {
                 FRESHNESS_INTERVAL_DEFAULT_IN_SECONDS = 15U * 60U,
+                REFRESH_TIMEOUT_IN_SECONDS = 60U,
+                MAX_ENTRIES_DEFAULT = 64U * 1024U,
+                STRIPES_COUNT = 16U,
+            };
+
+            /**
+             * @brief How the authentication tokens are hashed into the cache keys
+             *
+             * The cryptographic hash (SHA-512) is the default, but it is expensive for long tokens, so
+             * alternatively a keyed 64-bit hash (SipHash-2-4 with a random per cache key) can be used
+             * in which case the tokens are also kept in the cache and compared on lookup
+             */
+
+            enum KeyHashing
+            {
+                CryptographicKeyHashing,
+                KeyedFastHashing,
             };
 
+        protected:
+
+            typedef detail::AuthorizationRefresh                                    refresh_t;
+            typedef detail::AuthorizationRefreshWaiter                              waiter_t;
+            typedef detail::AuthorizationRefreshWaiterTask                          waiter_task_t;
+            typedef detail::AuthorizationRefreshLeaderTask                          leader_task_t;
+            typedef AuthorizationCacheImpl< SERVICE >                               this_type;
+
             struct AuthorizationInfo
             {
+                std::string                                                         key;
+                std::string                                                         token;
                 om::ObjPtrCopyable< SecurityPrincipal >                             principal;
                 time::ptime                                                         timestamp;
             };
 
+            /*
+             * The leader id identifies the task which is expected to complete the refresh (zero
+             * means that the refresh is only reserved and no task has been issued yet)
+             */
+
+            struct RefreshInfo
+            {
+                om::ObjPtrCopyable< refresh_t >                                     refresh;
+                std::string                                                         token;
+                cpp::ScalarTypeIniter< std::uint64_t >                              leaderId;
+                time::ptime                                                         started;
+            };
+
+            typedef std::list< AuthorizationInfo >                                  lru_list_t;
+            typedef typename lru_list_t::iterator                                   lru_iterator_t;
+
+            struct Stripe
+            {
+                os::mutex                                                           lock;
+                lru_list_t                                                          lru;
+                std::unordered_map< std::string, lru_iterator_t >                   entries;
+                std::unordered_map< std::string, RefreshInfo >                      refreshes;
+                cpp::ScalarTypeIniter< std::uint64_t >                              lastLeaderId;
+            };
+
             const om::ObjPtr< SERVICE >                                             m_authorizationService;
-            time::time_duration                                                     m_freshnessInterval;
-            os::mutex                                                               m_lock;
-            std::unordered_map< std::string, AuthorizationInfo >                    m_cache;
+            std::atomic< std::int64_t >                                             m_freshnessIntervalInMicroseconds;
+            const time::time_duration                                               m_staleInterval;
+            const std::size_t                                                       m_maxEntriesPerStripe;
+            const KeyHashing                                                        m_keyHashing;
+            std::uint8_t                                                            m_hashKey[ hash::SipHash24::KEY_SIZE ];
+            Stripe                                                                  m_stripes[ STRIPES_COUNT ];
 
             AuthorizationCacheImpl(
                 SAA_in              om::ObjPtr< SERVICE >&&                         authorizationService,
-                SAA_in_opt          const time::time_duration&                      freshnessInterval = time::neg_infin
+                SAA_in_opt          const time::time_duration&                      freshnessInterval = time::neg_infin,
+                SAA_in_opt          const std::size_t                               maxEntries = MAX_ENTRIES_DEFAULT,
+                SAA_in_opt          const time::time_duration&                      staleInterval = time::neg_infin,
+                SAA_in_opt          const KeyHashing                                keyHashing = CryptographicKeyHashing
                 )
                 :
                 m_authorizationService( BL_PARAM_FWD( authorizationService ) ),
-                m_freshnessInterval(
-                    freshnessInterval.is_special() ? freshnessIntervalDefault() : BL_PARAM_FWD( freshnessInterval )
-                    )
+                m_freshnessIntervalInMicroseconds(
+                    ( freshnessInterval.is_special() ? freshnessIntervalDefault() : freshnessInterval ).total_microseconds()
+                    ),
+                m_staleInterval( staleInterval.is_special() ? time::seconds( 0 ) : staleInterval ),
+                m_maxEntriesPerStripe( std::max< std::size_t >( 1U, ( maxEntries + STRIPES_COUNT - 1U ) / STRIPES_COUNT ) ),
+                m_keyHashing( keyHashing )
             {
+                random::getRandomBytes( m_hashKey, sizeof( m_hashKey ) );
+            }
+
+            auto freshnessInterval() const NOEXCEPT -> time::time_duration
+            {
+                return time::microseconds( m_freshnessIntervalInMicroseconds.load() );
             }
 
             auto getKey( SAA_in const om::ObjPtr< data::DataBlock >& authenticationToken ) -> std::string
             {
+                if( KeyedFastHashing == m_keyHashing )
+                {
+                    const auto value =
+                        hash::SipHash24::hash( m_hashKey, authenticationToken -> pv(), authenticationToken -> size() );
+
+                    return std::string( reinterpret_cast< const char* >( &value ), sizeof( value ) );
+                }
+
                 hash::HashCalculatorDefault hash;
 
                 hash.update( authenticationToken -> pv(), authenticationToken -> size() );
@@ -111,22 +536,263 @@ namespace bl
                 return hash.digestStr();
             }
 
-            auto tryGetAuthorizationInfo( SAA_in const om::ObjPtr< data::DataBlock >& authenticationToken )
+            auto getStripe( SAA_in const std::string& key ) -> Stripe&
+            {
+                return m_stripes[ std::hash< std::string >()( key ) % STRIPES_COUNT ];
+            }
+
+            /**
+             * @brief Checks if the token kept for an entry or a refresh is the one provided (only
+             * the keyed 64-bit hashes can collide, so the tokens are only kept and compared then)
+             */
+
+            bool isTokenMatching(
+                SAA_in              const std::string&                              token,
+                SAA_in              const om::ObjPtr< data::DataBlock >&            authenticationToken
+                ) const NOEXCEPT
+            {
+                if( KeyedFastHashing != m_keyHashing )
+                {
+                    return true;
+                }
+
+                return
+                    token.size() == authenticationToken -> size() &&
+                    std::equal( token.begin(), token.end(), authenticationToken -> begin() );
+            }
+
+            void assignToken(
+                SAA_inout           std::string&                                    token,
+                SAA_in              const om::ObjPtr< data::DataBlock >&            authenticationToken
+                ) const
+            {
+                if( KeyedFastHashing == m_keyHashing )
+                {
+                    token.assign( authenticationToken -> begin(), authenticationToken -> end() );
+                }
+            }
+
+            static bool isRefreshAbandoned(
+                SAA_in              const RefreshInfo&                              refreshInfo,
+                SAA_in              const time::ptime&                              now
+                )
+            {
+                return ( now - refreshInfo.started ) > time::seconds( REFRESH_TIMEOUT_IN_SECONDS );
+            }
+
+            /**
+             * @brief Finds the authorization info and marks it as the most recently used one
+             * (the stripe lock must be held)
+             */
+
+            auto tryGetAuthorizationInfo(
+                SAA_inout           Stripe&                                         stripe,
+                SAA_in              const std::string&                              key,
+                SAA_in              const om::ObjPtr< data::DataBlock >&            authenticationToken
+                )
                 -> AuthorizationInfo*
             {
-                const auto pos = m_cache.find( getKey( authenticationToken ) );
+                const auto pos = stripe.entries.find( key );
 
-                if( pos == m_cache.end() )
+                if( pos == stripe.entries.end() || ! isTokenMatching( pos -> second -> token, authenticationToken ) )
                 {
                     return nullptr;
                 }
 
-                return &pos -> second;
+                stripe.lru.splice( stripe.lru.begin(), stripe.lru, pos -> second );
+
+                return &*pos -> second;
+            }
+
+            void putAuthorizationInfo(
+                SAA_inout           Stripe&                                         stripe,
+                SAA_in              const std::string&                              key,
+                SAA_in              const om::ObjPtr< data::DataBlock >&            authenticationToken,
+                SAA_in              const om::ObjPtr< SecurityPrincipal >&          principal
+                )
+            {
+                AuthorizationInfo* info = nullptr;
+
+                const auto pos = stripe.entries.find( key );
+
+                if( pos != stripe.entries.end() )
+                {
+                    stripe.lru.splice( stripe.lru.begin(), stripe.lru, pos -> second );
+
+                    info = &*pos -> second;
+                }
+                else
+                {
+                    if( stripe.lru.size() >= m_maxEntriesPerStripe )
+                    {
+                        stripe.entries.erase( stripe.lru.back().key );
+                        stripe.lru.pop_back();
+                    }
+
+                    stripe.lru.emplace_front();
+
+                    try
+                    {
+                        stripe.entries.emplace( key, stripe.lru.begin() );
+                    }
+                    catch( std::exception& )
+                    {
+                        stripe.lru.pop_front();
+
+                        throw;
+                    }
+
+                    info = &stripe.lru.front();
+
+                    info -> key = key;
+                }
+
+                assignToken( info -> token, authenticationToken );
+
+                info -> principal = om::copy( principal );
+                info -> timestamp = time::microsec_clock::universal_time();
+            }
+
+            /**
+             * @brief Reserves the refresh of a stale entry for the caller if it is not reserved
+             * already (the stripe lock must be held)
+             */
+
+            bool tryReserveRefresh(
+                SAA_inout           Stripe&                                         stripe,
+                SAA_in              const std::string&                              key,
+                SAA_in              const om::ObjPtr< data::DataBlock >&            authenticationToken,
+                SAA_in              const time::ptime&                              now
+                )
+            {
+                const auto pos = stripe.refreshes.find( key );
+
+                if( pos != stripe.refreshes.end() && ! isRefreshAbandoned( pos -> second, now ) )
+                {
+                    return false;
+                }
+
+                auto& refreshInfo = stripe.refreshes[ key ];
+
+                refreshInfo = RefreshInfo();
+
+                assignToken( refreshInfo.token, authenticationToken );
+                refreshInfo.started = now;
+
+                return true;
+            }
+
+            /**
+             * @brief Completes the refresh once the authorization task issued for it has executed
+             * or when it has been abandoned (executedAuthorizationTask is nullptr then)
+             *
+             * Each issued task completes its own refresh object, so the tasks waiting for a task
+             * which got stuck and was replaced are not affected by the replacement, and the refresh
+             * in flight for the key is removed only if it is still the one issued by this task
+             */
+
+            auto completeRefresh(
+                SAA_in              const std::string&                              key,
+                SAA_in              const om::ObjPtrCopyable< data::DataBlock >&    authenticationToken,
+                SAA_in              const std::uint64_t                             leaderId,
+                SAA_in              const om::ObjPtrCopyable< refresh_t >&          refresh,
+                SAA_in_opt          const om::ObjPtr< tasks::Task >&                executedAuthorizationTask,
+                SAA_in_opt          const std::exception_ptr&                       taskException,
+                SAA_out             std::exception_ptr&                             eptr
+                ) NOEXCEPT
+                -> om::ObjPtr< SecurityPrincipal >
+            {
+                om::ObjPtr< SecurityPrincipal > principal;
+
+                BL_NOEXCEPT_BEGIN()
+
+                if( ! executedAuthorizationTask )
+                {
+                    eptr = BL_MAKE_EXCEPTION_PTR(
+                        SecurityException(),
+                        BL_MSG()
+                            << "Authorization request to the authorization service has been abandoned"
+                        );
+                }
+                else if( taskException )
+                {
+                    eptr = taskException;
+                }
+                else
+                {
+                    try
+                    {
+                        principal = m_authorizationService -> extractSecurityPrincipal( executedAuthorizationTask );
+                    }
+                    catch( std::exception& )
+                    {
+                        eptr = std::current_exception();
+                    }
+
+                    if( ! principal && ! eptr )
+                    {
+                        eptr = BL_MAKE_EXCEPTION_PTR(
+                            UnexpectedException(),
+                            BL_MSG()
+                                << "Security principal cannot be nullptr"
+                            );
+                    }
+                }
+
+                auto& stripe = getStripe( key );
+
+                {
+                    BL_MUTEX_GUARD( stripe.lock );
+
+                    if( principal )
+                    {
+                        putAuthorizationInfo( stripe, key, authenticationToken, principal );
+                    }
+
+                    const auto pos = stripe.refreshes.find( key );
+
+                    if( 0U != leaderId && pos != stripe.refreshes.end() && leaderId == pos -> second.leaderId )
+                    {
+                        stripe.refreshes.erase( pos );
+                    }
+                }
+
+                refresh -> complete( principal, eptr );
+
+                BL_NOEXCEPT_END()
+
+                return principal;
             }
 
             auto createAuthorizationTaskImpl( SAA_in const om::ObjPtr< data::DataBlock >& authenticationToken )
                 -> om::ObjPtr< tasks::Task >
             {
+                const auto key = getKey( authenticationToken );
+
+                auto& stripe = getStripe( key );
+
+                BL_MUTEX_GUARD( stripe.lock );
+
+                const auto now = time::microsec_clock::universal_time();
+
+                const auto pos = stripe.refreshes.find( key );
+
+                const bool isInFlight =
+                    pos != stripe.refreshes.end() && ! isRefreshAbandoned( pos -> second, now );
+
+                const bool isTokenInFlight =
+                    isInFlight && isTokenMatching( pos -> second.token, authenticationToken );
+
+                if( isTokenInFlight && 0U != pos -> second.leaderId )
+                {
+                    /*
+                     * There is already an authorization task in flight for this token, so we simply
+                     * wait for it instead of issuing another request to the authorization service
+                     */
+
+                    return waiter_task_t::createInstance< tasks::Task >( om::copy( pos -> second.refresh ) );
+                }
+
                 /*
                  * The authentication token is assumed to be a string (if the authorization service is REST
                  * usually the same format usually passed as HTTP cookies)
@@ -136,17 +802,80 @@ namespace bl
                  * use the original authentication token provided by the caller)
                  */
 
-                BL_MUTEX_GUARD( m_lock );
-
-                const auto* info = tryGetAuthorizationInfo( authenticationToken );
+                const auto* info = tryGetAuthorizationInfo( stripe, key, authenticationToken );
 
                 const auto& latestAuthenticationToken =
                     info ?  info -> principal -> authenticationToken() : authenticationToken;
 
-                return m_authorizationService -> createAuthorizationTask( latestAuthenticationToken );
+                auto authorizationTask = m_authorizationService -> createAuthorizationTask( latestAuthenticationToken );
+
+                auto refresh = refresh_t::createInstance();
+
+                std::uint64_t leaderId = 0U;
+
+                if( ! isInFlight || isTokenInFlight )
+                {
+                    /*
+                     * The task is registered as the one in flight for the key unless the refresh in
+                     * flight is for another token with colliding hash (in which case the task is
+                     * issued, but it is not coalesced with)
+                     */
+
+                    auto& refreshInfo = stripe.refreshes[ key ];
+
+                    leaderId = ++stripe.lastLeaderId.lvalue();
+
+                    refreshInfo.refresh = om::copy( refresh );
+                    assignToken( refreshInfo.token, authenticationToken );
+                    refreshInfo.leaderId = leaderId;
+                    refreshInfo.started = now;
+                }
+
+                return leader_task_t::createInstance< tasks::Task >(
+                    std::move( authorizationTask ),
+                    cpp::bind(
+                        &this_type::completeRefresh,
+                        om::ObjPtrCopyable< this_type >::acquireRef( this ),
+                        key,
+                        om::ObjPtrCopyable< data::DataBlock >( authenticationToken ),
+                        leaderId,
+                        om::ObjPtrCopyable< refresh_t >( refresh ),
+                        _1 /* executedAuthorizationTask */,
+                        _2 /* taskException */,
+                        _3 /* eptr */
+                        )
+                    );
             }
 
-            auto tryGetRefreshedPrincipal(
+            static auto handleAuthorizationFailure(
+                SAA_in              const std::exception_ptr&                       eptr,
+                SAA_in              const bool                                      tryOnly
+                )
+                -> om::ObjPtr< SecurityPrincipal >
+            {
+                if( tryOnly )
+                {
+                    return nullptr;
+                }
+
+                try
+                {
+                    cpp::safeRethrowException( eptr );
+                }
+                catch( std::exception& )
+                {
+                    BL_THROW(
+                        SecurityException()
+                            << eh::errinfo_nested_exception_ptr( std::current_exception() ),
+                        BL_MSG()
+                            << "Authorization request to the authorization service has failed"
+                        );
+                }
+
+                return nullptr;
+            }
+
+            auto updateInternal(
                 SAA_in              const om::ObjPtr< data::DataBlock >&            authenticationToken,
                 SAA_in_opt          const om::ObjPtr< tasks::Task >&                authorizationTask,
                 SAA_in_opt          const bool                                      tryOnly
@@ -187,59 +916,34 @@ namespace bl
                         << "The provided authorization task is not ready as it has not been executed"
                     );
 
-                if( executedAuthorizationTask -> isFailed() )
-                {
-                    if( tryOnly )
-                    {
-                        return nullptr;
-                    }
-
-                    try
-                    {
-                        cpp::safeRethrowException( executedAuthorizationTask -> exception() );
-                    }
-                    catch( std::exception& )
-                    {
-                        BL_THROW(
-                            SecurityException()
-                                << eh::errinfo_nested_exception_ptr( std::current_exception() ),
-                            BL_MSG()
-                                << "Authorization request to the authorization service has failed"
-                            );
-                    }
-                }
-
-                return m_authorizationService -> extractSecurityPrincipal( executedAuthorizationTask );
-            }
+                const auto waiter = om::tryQI< waiter_t >( executedAuthorizationTask );
 
-            auto updateInternal(
-                SAA_in              const om::ObjPtr< data::DataBlock >&            authenticationToken,
-                SAA_in_opt          const om::ObjPtr< tasks::Task >&                authorizationTask,
-                SAA_in_opt          const bool                                      tryOnly
-                )
-                -> om::ObjPtr< SecurityPrincipal >
-            {
-                auto principal = tryGetRefreshedPrincipal( authenticationToken, authorizationTask, tryOnly );
+                BL_CHK(
+                    nullptr,
+                    waiter,
+                    BL_MSG()
+                        << "The provided authorization task was not created by the authorization cache"
+                    );
 
-                BL_MUTEX_GUARD( m_lock );
+                /*
+                 * The cache has already been updated when the task has executed (either by the task
+                 * itself or by the task issued by another caller which it has waited for)
+                 */
 
-                if( tryOnly && nullptr == principal )
+                if( executedAuthorizationTask -> isFailed() )
                 {
-                    return nullptr;
+                    return handleAuthorizationFailure( executedAuthorizationTask -> exception(), tryOnly );
                 }
 
+                auto principal = waiter -> principal();
+
                 BL_CHK(
-                    false,
-                    nullptr != principal,
+                    nullptr,
+                    principal,
                     BL_MSG()
                         << "Security principal cannot be nullptr"
                     );
 
-                auto& info = m_cache[ getKey( authenticationToken ) ];
-
-                info.principal = principal;
-                info.timestamp = time::microsec_clock::universal_time();
-
                 return principal;
             }
 
@@ -259,9 +963,8 @@ namespace bl
                 SAA_in_opt          const time::time_duration&                  freshnessInterval = time::neg_infin
                 ) OVERRIDE
             {
-                BL_MUTEX_GUARD( m_lock );
-
-                m_freshnessInterval = freshnessInterval.is_special() ? freshnessIntervalDefault() : freshnessInterval;
+                m_freshnessIntervalInMicroseconds =
+                    ( freshnessInterval.is_special() ? freshnessIntervalDefault() : freshnessInterval ).total_microseconds();
             }
 
             virtual auto tryGetAuthorizedPrinciplal(
@@ -269,9 +972,13 @@ namespace bl
                 )
                 -> om::ObjPtr< SecurityPrincipal > OVERRIDE
             {
-                BL_MUTEX_GUARD( m_lock );
+                const auto key = getKey( authenticationToken );
+
+                auto& stripe = getStripe( key );
+
+                BL_MUTEX_GUARD( stripe.lock );
 
-                const auto* info = tryGetAuthorizationInfo( authenticationToken );
+                const auto* info = tryGetAuthorizationInfo( stripe, key, authenticationToken );
 
                 if( ! info )
                 {
@@ -293,7 +1000,24 @@ namespace bl
                         << "Invalid timestamp in the authorization cache"
                     );
 
-                if( ( now - timestamp ) > m_freshnessInterval )
+                const auto freshnessInterval = this -> freshnessInterval();
+
+                if( ( now - timestamp ) <= freshnessInterval )
+                {
+                    return om::copy( info -> principal );
+                }
+
+                if( ( now - timestamp ) > freshnessInterval + m_staleInterval )
+                {
+                    return nullptr;
+                }
+
+                /*
+                 * The entry is stale, but still usable - only the caller which reserves the refresh
+                 * gets nullptr (and is expected to refresh it), while the rest get the stale principal
+                 */
+
+                if( tryReserveRefresh( stripe, key, authenticationToken, now ) )
                 {
                     return nullptr;
                 }
@@ -331,9 +1055,19 @@ namespace bl
                 SAA_in              const om::ObjPtr< data::DataBlock >&    authenticationToken
                 ) OVERRIDE
             {
-                BL_MUTEX_GUARD( m_lock );
+                const auto key = getKey( authenticationToken );
 
-                m_cache.erase( getKey( authenticationToken ) );
+                auto& stripe = getStripe( key );
+
+                BL_MUTEX_GUARD( stripe.lock );
+
+                const auto pos = stripe.entries.find( key );
+
+                if( pos != stripe.entries.end() && isTokenMatching( pos -> second -> token, authenticationToken ) )
+                {
+                    stripe.lru.erase( pos -> second );
+                    stripe.entries.erase( pos );
+                }
             }
         };
 
@@ -81,6 +81,7 @@ namespace bl
         public:
 
             typedef tasks::SimpleHttpSslTaskImpl                                    task_impl_t;
+            typedef task_impl_t::connections_pool_t                                 connections_pool_t;
 
         protected:
 
@@ -125,6 +126,7 @@ namespace bl
             const fs::path                                                          m_configPath;
             const properties_map_t                                                  m_uniqueProperties;
             const str::regex                                                        m_regexUpdatedTokenProperty;
+            const om::ObjPtr< connections_pool_t >                                  m_connectionsPool;
 
             AuthorizationServiceRestT(
                 SAA_in          om::ObjPtr< rest_config_t >&&                       config,
@@ -147,7 +149,8 @@ namespace bl
                 m_config( BL_PARAM_FWD( config ) ),
                 m_configPath( BL_PARAM_FWD( configPath ) ),
                 m_uniqueProperties( getUniqueProperties( m_config ) ),
-                m_regexUpdatedTokenProperty( m_config -> regexUpdatedTokenProperty() )
+                m_regexUpdatedTokenProperty( m_config -> regexUpdatedTokenProperty() ),
+                m_connectionsPool( connections_pool_t::createInstance() )
             {
                 BL_CHK_T(
                     false,
@@ -172,6 +175,22 @@ namespace bl
                     );
             }
 
+            ~AuthorizationServiceRestT() NOEXCEPT
+            {
+                BL_NOEXCEPT_BEGIN()
+
+                /*
+                 * The pooled connections are bound to the I/O thread pool, so they must be
+                 * closed now (the authorization tasks which are still in flight may hold
+                 * a reference to the pool, but they won't be able to return connections
+                 * to it after it is disposed)
+                 */
+
+                m_connectionsPool -> dispose();
+
+                BL_NOEXCEPT_END()
+            }
+
             static auto getUniqueProperties( SAA_in const om::ObjPtr< rest_config_t >& config )
                 -> properties_map_t
             {
@@ -366,6 +385,13 @@ namespace bl
 
                 taskImpl -> isSecureMode( true );
 
+                /*
+                 * The authorization requests are normally made to the same endpoint, so
+                 * the connections and the TLS sessions are reused between the requests
+                 */
+
+                taskImpl -> setConnectionsPool( m_connectionsPool );
+
                 return om::moveAs< tasks::Task >( taskImpl );
             }
 
@@ -355,6 +355,35 @@ namespace bl
                 return m_wasShutdownInvoked;
             }
 
+            /**
+             * @brief Returns a reference to the current TLS session (if any) which can
+             * be used to resume the session on a new connection to the same endpoint
+             */
+
+            auto tryGetSession() const NOEXCEPT -> crypto::sslsession_ptr_t
+            {
+                return crypto::sslsession_ptr_t::attach( ::SSL_get1_session( getStream().native_handle() ) );
+            }
+
+            /**
+             * @brief Requests the TLS session to be resumed in the client handshake
+             *
+             * This must be called before the handshake has started and if the server
+             * declines the session a full handshake is performed as usual
+             */
+
+            void setSession( SAA_in ::SSL_SESSION* session )
+            {
+                BL_ASSERT( ! m_isServer );
+
+                BL_CHK_CRYPTO_API_NM( ::SSL_set_session( getStream().native_handle(), session ) );
+            }
+
+            bool isSessionReused() const NOEXCEPT
+            {
+                return 0 != ::SSL_session_reused( getStream().native_handle() );
+            }
+
             void enhanceException( SAA_in eh::exception& exception ) const
             {
                 /*
@@ -204,7 +204,17 @@ namespace bl
                 tasks_queue_t;
 
             typedef cpp::SafeUniquePtr< TaskInfo >                                  task_info_ptr_t;
-            typedef om::ObjectImpl< SimplePool< task_info_ptr_t > >                 taskinfo_pool_t;
+            typedef om::ObjectImpl< LockFreePool< task_info_ptr_t > >               taskinfo_pool_t;
+
+            /*
+             * The task info pool is per queue, so we keep its capacity small as the
+             * lock free pool pre-allocates its nodes
+             */
+
+            enum : std::size_t
+            {
+                TASKINFO_POOL_CAPACITY = 256U,
+            };
 
             typedef ExecutionQueueImplT< E >                                        this_type;
             typedef std::unordered_map< Task*, TaskInfo* >                          tasks_map_t;
@@ -245,7 +255,12 @@ namespace bl
                 m_executingCount( 0U ),
                 m_readyCount( 0U ),
                 m_eventsMask( 0 ),
-                m_taskInfoPool( taskinfo_pool_t::template createInstance< taskinfo_pool_t >() )
+                m_taskInfoPool(
+                    taskinfo_pool_t::template createInstance< taskinfo_pool_t >(
+                        std::string( "[task infos]" ),
+                        static_cast< std::size_t >( TASKINFO_POOL_CAPACITY )
+                        )
+                    )
             {
                 m_observerThis = om::ProxyImpl::createInstance< om::Proxy >();
                 m_observerThis -> connect( this );
@@ -366,6 +381,7 @@ namespace bl
             {
                 cpp::void_callback_noexcept_t onNotify;
                 cpp::void_callback_noexcept_t onNotifyAllCompleted;
+                bool notifyAllCompleted = false;
 
                 BL_MUTEX_GUARD( m_lockEvents );
 
@@ -452,6 +468,9 @@ namespace bl
 
                         m_cvReady.notify_all();
                     }
+
+                    notifyAllCompleted =
+                        m_notifyCB && ( m_eventsMask & ExecutionQueueNotify::AllTasksCompleted );
                 }
 
                 if( onNotify )
@@ -459,6 +478,13 @@ namespace bl
                     onNotify();
                 }
 
+                /*
+                 * The queue lock is only taken again if the AllTasksCompleted event is
+                 * requested (which is not the common case), so a completed task normally
+                 * acquires the queue lock just once
+                 */
+
+                if( notifyAllCompleted )
                 {
                     BL_MUTEX_GUARD( m_lock );
 
@@ -481,11 +507,26 @@ namespace bl
 
             void padExecutingQueueNothrow() NOEXCEPT
             {
+                if( m_pending.empty() )
+                {
+                    return;
+                }
+
                 BL_NOEXCEPT_BEGIN()
 
+                /*
+                 * The notify callback limit and the shared pointer of the queue are obtained
+                 * once per call rather than once per scheduled task as this code executes
+                 * while holding the queue lock
+                 *
+                 * The execution queue must support SharedPtr
+                 */
+
+                const auto maxReadyOrExecuting = getMaxReadyOrExecuting();
+                const auto eqThis = om::getSharedPtr< ExecutionQueue >( this );
+
                 while( ! m_pending.empty() )
                 {
-                    const auto maxReadyOrExecuting = getMaxReadyOrExecuting();
                     const auto readyOrExecuting = getReadyOrExecuting();
 
                     if(
@@ -502,12 +543,6 @@ namespace bl
 
                     auto& taskInfo = m_pending.front();
 
-                    /*
-                     * The execution queue must support SharedPtr
-                     */
-
-                    const auto eqThis = om::getSharedPtr< ExecutionQueue >( this );
-
                     taskInfo.getTask() -> scheduleNothrow(
                         eqThis,
                         cpp::bind(
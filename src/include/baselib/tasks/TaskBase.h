@@ -995,7 +995,7 @@ namespace bl
                      * be done by the BL_NOEXCEPT_* macros)
                      */
 
-                    getThreadPool( eq ) -> aioService().post(
+                    getThreadPool( eq ) -> post(
                         cpp::bind(
                             &this_type::notifyReadyImpl,
                             om::ObjPtrCopyable< this_type >::acquireRef( this ),
@@ -1127,7 +1127,7 @@ namespace bl
 
                 m_eq = eq;
 
-                getThreadPool() -> aioService().post(
+                getThreadPool() -> post(
                     cpp::bind(
                         &this_type::onExecute,
                         om::ObjPtrCopyable< this_type >::acquireRef( this )
@@ -24,6 +24,9 @@
 #include <baselib/tasks/TaskBase.h>
 #include <baselib/tasks/TasksIncludes.h>
 
+#include <baselib/core/ThreadPoolShards.h>
+
+#include <memory>
 #include <vector>
 #include <unordered_map>
 
@@ -847,17 +850,100 @@ namespace bl
             cpp::SafeUniquePtr< tcp::acceptor >                                         m_acceptor;
             tcp::endpoint                                                               m_localEndpoint;
             eh::error_code                                                              m_errorCode;
+            asio::io_service*                                                           m_acceptorService;
+            cpp::ScalarTypeIniter< bool >                                               m_isReusePort;
 
             TcpConnectionEstablisherAcceptor(
                 SAA_in                              std::string&&                       host,
                 SAA_in                              const unsigned short                port
                 )
                 :
-                base_type( std::forward< std::string >( host ), port )
+                base_type( std::forward< std::string >( host ), port ),
+                m_acceptorService( nullptr )
             {
                 TaskBase::m_name = "success:TcpTask_Acceptor";
             }
 
+            static bool isReusePortSupported() NOEXCEPT
+            {
+#if defined( SO_REUSEPORT )
+                return true;
+#else
+                return false;
+#endif
+            }
+
+            /**
+             * @brief Creates an acceptor which is bound to the specified endpoint and listening
+             *
+             * The acceptor is opened with the option to reuse the address (i.e. SO_REUSEADDR) and
+             * optionally with the option to reuse the port (i.e. SO_REUSEPORT) which allows for
+             * multiple acceptors to listen on the same port and the kernel to load balance the
+             * incoming connections between them
+             *
+             * Also set the linger option to false and zero timeout to ensure the acceptor
+             * is closed promptly once the task is terminated (to have predictable behavior
+             * for unit tests and in general)
+             */
+
+            static auto createAcceptor(
+                SAA_inout                           asio::io_service&                   aioService,
+                SAA_in                              const tcp::endpoint&                endpoint,
+                SAA_in                              const bool                          isReusePort
+                )
+                -> cpp::SafeUniquePtr< tcp::acceptor >
+            {
+                auto acceptor = cpp::SafeUniquePtr< tcp::acceptor >::attach( new tcp::acceptor( aioService ) );
+
+                acceptor -> open( endpoint.protocol() );
+                acceptor -> set_option( tcp::acceptor::reuse_address( true ) );
+
+                if( isReusePort )
+                {
+#if defined( SO_REUSEPORT )
+                    typedef asio::detail::socket_option::boolean< SOL_SOCKET, SO_REUSEPORT > reuse_port;
+
+                    acceptor -> set_option( reuse_port( true ) );
+#else
+                    BL_THROW(
+                        NotSupportedException(),
+                        BL_MSG()
+                            << "The SO_REUSEPORT socket option is not supported on this platform"
+                        );
+#endif
+                }
+
+                acceptor -> set_option( asio::socket_base::linger( false, 0 ) );
+                acceptor -> bind( endpoint );
+                acceptor -> listen();
+
+                return acceptor;
+            }
+
+            /**
+             * @brief The I/O service of the acceptor and of the sockets it accepts
+             *
+             * It is the I/O service of the I/O thread pool unless it was explicitly set
+             * by the derived class (e.g. to the I/O service of a shard)
+             */
+
+            auto acceptorService() -> asio::io_service&
+            {
+                if( m_acceptorService )
+                {
+                    return *m_acceptorService;
+                }
+
+                /*
+                 * All TCP tasks should always be scheduled on the I/O thread pool
+                 */
+
+                const auto threadPool = ThreadPoolDefault::getDefault( base_type::getThreadPoolId() );
+                BL_ASSERT( threadPool );
+
+                return threadPool -> aioService();
+            }
+
             virtual auto onTaskStoppedNothrow( SAA_in_opt const std::exception_ptr& eptrIn ) NOEXCEPT
                 -> std::exception_ptr OVERRIDE
             {
@@ -879,15 +965,8 @@ namespace bl
             {
                 BL_ASSERT( m_acceptor );
 
-                /*
-                 * All TCP tasks should always be scheduled on the I/O thread pool
-                 */
-
-                const auto threadPool = ThreadPoolDefault::getDefault( base_type::getThreadPoolId() );
-                BL_ASSERT( threadPool );
-
                 base_type::createSocket(
-                    threadPool -> aioService(),
+                    acceptorService(),
                     base_type::m_query.host_name(),
                     base_type::m_query.service_name()
                     );
@@ -1059,30 +1138,9 @@ namespace bl
             {
                 BL_ASSERT( ! m_acceptor );
 
-                /*
-                 * All TCP tasks should always be scheduled on the I/O thread pool
-                 */
-
-                const auto threadPool = ThreadPoolDefault::getDefault( base_type::getThreadPoolId() );
-                BL_ASSERT( threadPool );
-
-                m_acceptor.reset( new tcp::acceptor( threadPool -> aioService() ) );
-
                 const auto endpoint = base_type::getEndpoint( endpoints );
 
-                /*
-                 * Open the acceptor with the option to reuse the address (i.e. SO_REUSEADDR)
-                 *
-                 * Also set the linger option to false and zero timeout to ensure the acceptor
-                 * is closed promptly once the task is terminated (to have predictable behavior
-                 * for unit tests and in general)
-                 */
-
-                m_acceptor -> open( endpoint.protocol() );
-                m_acceptor -> set_option( tcp::acceptor::reuse_address( true ) );
-                m_acceptor -> set_option( asio::socket_base::linger( false, 0 ) );
-                m_acceptor -> bind( endpoint );
-                m_acceptor -> listen();
+                m_acceptor = createAcceptor( acceptorService(), endpoint, m_isReusePort );
 
                 /*
                  * We're ready to start accepting connections now (async)
@@ -1533,6 +1591,79 @@ namespace bl
                         );
                 }
             };
+
+            /**
+             * @brief class TcpServerShardAcceptor - the acceptor task of a shard of a sharded server
+             *
+             * The acceptor is created (and bound) by the server, so the task only accepts the
+             * connections on the I/O service of the shard. The accepted streams are handed off
+             * to the server via a callback which is posted on the I/O service of the shard, so
+             * the acceptor task lock is not held while the server lock is acquired (the server
+             * holds its lock while it cancels the shard acceptors)
+             */
+
+            template
+            <
+                typename STREAM
+            >
+            class TcpServerShardAcceptor :
+                public TcpConnectionEstablisherAcceptor< STREAM >
+            {
+                BL_DECLARE_OBJECT_IMPL( TcpServerShardAcceptor )
+
+            public:
+
+                typedef TcpConnectionEstablisherAcceptor< STREAM >                          base_type;
+                typedef typename STREAM::stream_ref                                         stream_ref;
+
+                typedef cpp::function
+                    <
+                        void ( SAA_in const std::shared_ptr< stream_ref >& connectedStream )
+                    >
+                    callback_t;
+
+            protected:
+
+                const callback_t                                                            m_callback;
+
+                TcpServerShardAcceptor(
+                    SAA_in                  std::string&&                                   host,
+                    SAA_in                  const unsigned short                            port,
+                    SAA_inout               asio::io_service&                               aioService,
+                    SAA_inout               cpp::SafeUniquePtr< tcp::acceptor >&&           acceptor,
+                    SAA_in                  callback_t&&                                    callback,
+                    SAA_in                  const std::string&                              privateKeyPem,
+                    SAA_in                  const std::string&                              certificatePem
+                    )
+                    :
+                    base_type( BL_PARAM_FWD( host ), port ),
+                    m_callback( BL_PARAM_FWD( callback ) )
+                {
+                    TaskBase::m_name = "success:TcpTask_ShardAcceptor";
+
+                    base_type::m_acceptorService = &aioService;
+                    base_type::m_isReusePort = true;
+                    base_type::m_localEndpoint = acceptor -> local_endpoint();
+                    base_type::m_acceptor = BL_PARAM_FWD( acceptor );
+
+                    if( base_type::isProtocolHandshakeNeeded )
+                    {
+                        base_type::initServerContext( privateKeyPem, certificatePem );
+                    }
+                }
+
+                virtual void processIncomingConnection( SAA_inout stream_ref&& connectedStream ) OVERRIDE
+                {
+                    /*
+                     * The stream is move only, so it is wrapped in a shared pointer to be
+                     * bound to the callback
+                     */
+
+                    const auto stream = std::make_shared< stream_ref >( BL_PARAM_FWD( connectedStream ) );
+
+                    base_type::acceptorService().post( cpp::bind( m_callback, stream ) );
+                }
+            };
         }
 
         /******************************************************************************************
@@ -1559,6 +1690,7 @@ namespace bl
             typedef TcpConnectionEstablisherAcceptor< STREAM >                                  base_type;
             typedef typename STREAM::stream_ref                                                 stream_ref;
             typedef SERVERPOLICY                                                                server_policy_t;
+            typedef om::ObjectImpl< detail::TcpServerShardAcceptor< STREAM > >                  shard_acceptor_t;
 
         private:
 
@@ -1583,6 +1715,11 @@ namespace bl
             om::ObjPtr< om::Proxy >                                                             m_executionServices;
             om::ObjPtrDisposable< ExecutionQueue >                                              m_eqSupportingTasks;
 
+            om::ObjPtr< ThreadPoolShards >                                                      m_shards;
+            om::ObjPtrDisposable< ExecutionQueue >                                              m_eqShardAcceptors;
+            const std::string                                                                   m_privateKeyPem;
+            const std::string                                                                   m_certificatePem;
+
             TcpServerBase(
                 SAA_in                  const om::ObjPtr< TaskControlTokenRW >&                 controlToken,
                 SAA_in                  std::string&&                                           host,
@@ -1593,7 +1730,9 @@ namespace bl
                 :
                 base_type( std::forward< std::string >( host ), port ),
                 m_controlToken( om::copy( controlToken ) ),
-                m_forceShutdown( true )
+                m_forceShutdown( true ),
+                m_privateKeyPem( privateKeyPem ),
+                m_certificatePem( certificatePem )
             {
                 if( base_type::isProtocolHandshakeNeeded )
                 {
@@ -1666,6 +1805,11 @@ namespace bl
                         m_executionServices -> disconnect();
                     }
 
+                    if( m_eqShardAcceptors )
+                    {
+                        m_eqShardAcceptors -> forceFlushNoThrow( true /* wait */ );
+                    }
+
                     m_eqSupportingTasks -> forceFlushNoThrow( true /* wait */ );
 
                     m_eqConnections -> forceFlushNoThrow( true /* wait */ );
@@ -1679,11 +1823,15 @@ namespace bl
                      * expected to be shutdown already (i.e. no outstanding connections)
                      */
 
-                    if( ! m_eqConnections -> isEmpty() || ! m_eqSupportingTasks -> isEmpty() )
+                    if(
+                        ! m_eqConnections -> isEmpty() ||
+                        ! m_eqSupportingTasks -> isEmpty() ||
+                        ( m_eqShardAcceptors && ! m_eqShardAcceptors -> isEmpty() )
+                        )
                     {
                         BL_RIP_MSG(
                             "Forcefully terminating a server task while there are "
-                            "outstanding connections or supporting tasks"
+                            "outstanding connections, supporting tasks or shard acceptors"
                             );
                     }
                 }
@@ -1819,6 +1967,17 @@ namespace bl
                     m_executionServices -> connect( m_eqSupportingTasks.get() );
                 }
 
+                if( m_shards && ! m_eqShardAcceptors )
+                {
+                    /*
+                     * The execution queue has ExecutionQueue::OptionKeepNone to ensure that
+                     * the shard acceptors are discarded automatically as they're stopped
+                     */
+
+                    m_eqShardAcceptors =
+                        ExecutionQueueImpl::createInstance< ExecutionQueue >( ExecutionQueue::OptionKeepNone );
+                }
+
                 m_notifyCB = om::ProxyImpl::createInstance< om::Proxy >();
                 m_notifyCB -> connect( static_cast< Task* >( this ) );
 
@@ -1841,7 +2000,7 @@ namespace bl
 
                 if( asio::error::operation_aborted != ec )
                 {
-                    if( m_eqConnections -> isEmpty() && m_eqSupportingTasks -> isEmpty() )
+                    if( m_eqConnections -> isEmpty() && m_eqSupportingTasks -> isEmpty() && areShardAcceptorsStopped() )
                     {
                         BL_LOG(
                             Logging::debug(),
@@ -1904,6 +2063,16 @@ namespace bl
 
                 base_type::m_acceptor -> close();
 
+                if( m_eqShardAcceptors )
+                {
+                    /*
+                     * The shard acceptors don't acquire the server lock while holding their own
+                     * lock (see detail::TcpServerShardAcceptor), so they can be canceled here
+                     */
+
+                    m_eqShardAcceptors -> cancelAll( false /* wait */ );
+                }
+
                 if( m_controlToken )
                 {
                     /*
@@ -1935,6 +2104,8 @@ namespace bl
                 const bool areSupportingTasksPending =
                     m_eqSupportingTasks && false == m_eqSupportingTasks -> isEmpty();
 
+                const bool areShardAcceptorsPending = ! areShardAcceptorsStopped();
+
                 if( areConnectionsPending )
                 {
                     BL_LOG(
@@ -1965,7 +2136,20 @@ namespace bl
                         );
                 }
 
-                if( areConnectionsPending || areSupportingTasksPending )
+                if( areShardAcceptorsPending )
+                {
+                    BL_LOG(
+                        Logging::debug(),
+                        BL_MSG()
+                            << "Stopped accepting from server "
+                            << this
+                            << " and waiting for "
+                            << m_eqShardAcceptors -> size()
+                            << " shard acceptors to stop"
+                        );
+                }
+
+                if( areConnectionsPending || areSupportingTasksPending || areShardAcceptorsPending )
                 {
                     if( m_forceShutdown )
                     {
@@ -2001,6 +2185,104 @@ namespace bl
                 return false;
             }
 
+            bool areShardAcceptorsStopped() const NOEXCEPT
+            {
+                return ! m_eqShardAcceptors || m_eqShardAcceptors -> isEmpty();
+            }
+
+            virtual bool continueAfterResolved( SAA_in tcp::resolver::iterator endpoints ) OVERRIDE
+            {
+                const bool result = base_type::continueAfterResolved( endpoints );
+
+                if( m_shards )
+                {
+                    startShardAcceptors();
+                }
+
+                return result;
+            }
+
+            /**
+             * @brief Starts the acceptors of the shards other than the first one (the server itself
+             * is the acceptor of the first shard)
+             *
+             * The acceptors are bound synchronously here, so if any of them can't listen on the port
+             * the server fails to start as it would if its own acceptor couldn't listen
+             */
+
+            void startShardAcceptors()
+            {
+                BL_ASSERT( m_shards && m_eqShardAcceptors );
+
+                const auto localEndpoint = base_type::m_acceptor -> local_endpoint();
+
+                for( std::size_t shardIndex = 1U; shardIndex < m_shards -> size(); ++shardIndex )
+                {
+                    auto& aioService = m_shards -> aioService( shardIndex );
+
+                    auto acceptor = base_type::createAcceptor( aioService, localEndpoint, true /* isReusePort */ );
+
+                    m_eqShardAcceptors -> push_back(
+                        om::qi< Task >(
+                            shard_acceptor_t::createInstance(
+                                localEndpoint.address().to_string(),
+                                localEndpoint.port(),
+                                aioService,
+                                std::move( acceptor ),
+                                cpp::bind(
+                                    &this_type::onShardConnectionAccepted,
+                                    om::ObjPtrCopyable< this_type, Task >::acquireRef( this ),
+                                    _1
+                                    ),
+                                m_privateKeyPem,
+                                m_certificatePem
+                                )
+                            )
+                        );
+                }
+
+                BL_LOG(
+                    Logging::debug(),
+                    BL_MSG()
+                        << "Accepting connections at "
+                        << net::formatEndpointId( localEndpoint )
+                        << " on "
+                        << m_shards -> size()
+                        << " shards"
+                    );
+            }
+
+            void onShardConnectionAccepted( SAA_in const std::shared_ptr< stream_ref >& connectedStream ) NOEXCEPT
+            {
+                BL_NOEXCEPT_BEGIN()
+
+                BL_MUTEX_GUARD( base_type::m_lock );
+
+                if(
+                    base_type::isCanceled() ||
+                    ! base_type::m_acceptor ||
+                    ! base_type::m_acceptor -> is_open()
+                    )
+                {
+                    /*
+                     * The server has stopped accepting connections already; the stream
+                     * will be closed when the last reference to it goes away
+                     */
+
+                    return;
+                }
+
+                utils::tryCatchLog(
+                    "Failed to establish a connection with endpoint; exception details",
+                    [ & ]() -> void
+                    {
+                        processIncomingConnection( std::move( *connectedStream ) );
+                    }
+                    );
+
+                BL_NOEXCEPT_END()
+            }
+
             virtual void processIncomingConnection( SAA_inout stream_ref&& connectedStream ) OVERRIDE
             {
                 ( void ) base_type::tryConfigureConnectedStream( *connectedStream );
@@ -2106,6 +2388,48 @@ namespace bl
 
         public:
 
+            /**
+             * @brief Enables the sharded mode; it must be called before the server is scheduled
+             *
+             * In the sharded mode each shard has its own acceptor listening on the same port
+             * (via SO_REUSEPORT, so the kernel load balances the incoming connections between
+             * them) and the sockets accepted by it are bound to the I/O service of the shard,
+             * so the completion handlers of each connection are always executed on the thread
+             * of the same shard
+             */
+
+            void enableSharding( SAA_in om::ObjPtr< ThreadPoolShards >&& shards )
+            {
+                BL_MUTEX_GUARD( base_type::m_lock );
+
+                BL_CHK(
+                    false,
+                    ! base_type::m_acceptor && ! m_eqConnections,
+                    BL_MSG()
+                        << "Sharding can only be enabled before the server is started"
+                    );
+
+                BL_CHK(
+                    false,
+                    shards && shards -> size(),
+                    BL_MSG()
+                        << "At least one shard is required to enable sharding"
+                    );
+
+                BL_CHK_T(
+                    false,
+                    base_type::isReusePortSupported(),
+                    NotSupportedException(),
+                    BL_MSG()
+                        << "Sharding requires the SO_REUSEPORT socket option which is not supported on this platform"
+                    );
+
+                m_shards = BL_PARAM_FWD( shards );
+
+                base_type::m_acceptorService = &m_shards -> aioService( 0U );
+                base_type::m_isReusePort = true;
+            }
+
             void setHostServices( SAA_in om::ObjPtr< om::Proxy >&& hostServices ) NOEXCEPT
             {
                 BL_NOEXCEPT_BEGIN()
@@ -0,0 +1,1330 @@
+/*
+ * This file is part of the swblocks-baselib library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __BL_TASKS_UTILS_ASYNCFILEIOSERVICE_H_
+#define __BL_TASKS_UTILS_ASYNCFILEIOSERVICE_H_
+
+#include <baselib/tasks/TaskBase.h>
+
+#include <baselib/data/DataBlock.h>
+
+#include <baselib/core/BoxedObjects.h>
+#include <baselib/core/OS.h>
+#include <baselib/core/ObjModel.h>
+#include <baselib/core/Logging.h>
+#include <baselib/core/BaseIncludes.h>
+
+#include <deque>
+#include <map>
+
+#if defined( __linux__ ) && defined( __has_include )
+#if __has_include( <linux/io_uring.h> )
+#define BL_TASKS_HAS_IO_URING
+#endif
+#endif
+
+#ifdef BL_TASKS_HAS_IO_URING
+#include <linux/io_uring.h>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace bl
+{
+    namespace tasks
+    {
+        namespace detail
+        {
+#ifdef BL_TASKS_HAS_IO_URING
+
+            /**
+             * @brief class IoUring - a minimal wrapper of the Linux io_uring interface
+             *
+             * It uses the raw system calls (i.e. it does not depend on liburing) and it is not
+             * thread safe; the submission queue and the completion queue must be synchronized
+             * by the caller (they can be accessed independently from different threads)
+             */
+
+            template
+            <
+                typename E = void
+            >
+            class IoUringT
+            {
+                BL_NO_COPY_OR_MOVE( IoUringT )
+
+            private:
+
+                int                                                     m_fd;
+
+                void*                                                   m_sqRing;
+                std::size_t                                             m_sqRingSize;
+                void*                                                   m_cqRing;
+                std::size_t                                             m_cqRingSize;
+                io_uring_sqe*                                           m_sqes;
+                std::size_t                                             m_sqesSize;
+
+                unsigned*                                               m_sqHead;
+                unsigned*                                               m_sqTail;
+                unsigned*                                               m_sqArray;
+                unsigned                                                m_sqMask;
+                unsigned                                                m_sqEntries;
+                unsigned                                                m_sqTailLocal;
+
+                unsigned*                                               m_cqHead;
+                unsigned*                                               m_cqTail;
+                io_uring_cqe*                                           m_cqes;
+                unsigned                                                m_cqMask;
+                unsigned                                                m_cqEntries;
+
+                template
+                <
+                    typename T
+                >
+                static T* ringPtr(
+                    SAA_in          void*                               ring,
+                    SAA_in          const std::uint32_t                 offset
+                    ) NOEXCEPT
+                {
+                    return reinterpret_cast< T* >( static_cast< char* >( ring ) + offset );
+                }
+
+                static void* mapRegion(
+                    SAA_in          const int                           fd,
+                    SAA_in          const std::size_t                   size,
+                    SAA_in          const off_t                         offset
+                    )
+                {
+                    void* region = ::mmap(
+                        nullptr,
+                        size,
+                        PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE,
+                        fd,
+                        offset
+                        );
+
+                    if( MAP_FAILED == region )
+                    {
+                        BL_THROW_EC(
+                            eh::error_code( errno, eh::generic_category() ),
+                            BL_MSG()
+                                << "Cannot map the io_uring rings"
+                            );
+                    }
+
+                    return region;
+                }
+
+                void close() NOEXCEPT
+                {
+                    if( m_sqes )
+                    {
+                        ::munmap( m_sqes, m_sqesSize );
+                        m_sqes = nullptr;
+                    }
+
+                    if( m_cqRing && m_cqRing != m_sqRing )
+                    {
+                        ::munmap( m_cqRing, m_cqRingSize );
+                    }
+
+                    m_cqRing = nullptr;
+
+                    if( m_sqRing )
+                    {
+                        ::munmap( m_sqRing, m_sqRingSize );
+                        m_sqRing = nullptr;
+                    }
+
+                    if( -1 != m_fd )
+                    {
+                        ::close( m_fd );
+                        m_fd = -1;
+                    }
+                }
+
+                IoUringT( SAA_in const int fd, SAA_in const io_uring_params& params )
+                    :
+                    m_fd( fd ),
+                    m_sqRing( nullptr ),
+                    m_sqRingSize( params.sq_off.array + params.sq_entries * sizeof( unsigned ) ),
+                    m_cqRing( nullptr ),
+                    m_cqRingSize( params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe ) ),
+                    m_sqes( nullptr ),
+                    m_sqesSize( params.sq_entries * sizeof( io_uring_sqe ) )
+                {
+                    auto guard = BL_SCOPE_GUARD( close(); );
+
+                    if( params.features & IORING_FEAT_SINGLE_MMAP )
+                    {
+                        /*
+                         * The SQ and CQ rings are mapped with a single mmap call
+                         */
+
+                        m_sqRingSize = m_cqRingSize = std::max( m_sqRingSize, m_cqRingSize );
+
+                        m_sqRing = mapRegion( m_fd, m_sqRingSize, IORING_OFF_SQ_RING );
+                        m_cqRing = m_sqRing;
+                    }
+                    else
+                    {
+                        m_sqRing = mapRegion( m_fd, m_sqRingSize, IORING_OFF_SQ_RING );
+                        m_cqRing = mapRegion( m_fd, m_cqRingSize, IORING_OFF_CQ_RING );
+                    }
+
+                    m_sqes = static_cast< io_uring_sqe* >( mapRegion( m_fd, m_sqesSize, IORING_OFF_SQES ) );
+
+                    m_sqHead = ringPtr< unsigned >( m_sqRing, params.sq_off.head );
+                    m_sqTail = ringPtr< unsigned >( m_sqRing, params.sq_off.tail );
+                    m_sqArray = ringPtr< unsigned >( m_sqRing, params.sq_off.array );
+                    m_sqMask = *ringPtr< unsigned >( m_sqRing, params.sq_off.ring_mask );
+                    m_sqEntries = *ringPtr< unsigned >( m_sqRing, params.sq_off.ring_entries );
+                    m_sqTailLocal = *m_sqTail;
+
+                    m_cqHead = ringPtr< unsigned >( m_cqRing, params.cq_off.head );
+                    m_cqTail = ringPtr< unsigned >( m_cqRing, params.cq_off.tail );
+                    m_cqes = ringPtr< io_uring_cqe >( m_cqRing, params.cq_off.cqes );
+                    m_cqMask = *ringPtr< unsigned >( m_cqRing, params.cq_off.ring_mask );
+                    m_cqEntries = *ringPtr< unsigned >( m_cqRing, params.cq_off.ring_entries );
+
+                    guard.dismiss();
+                }
+
+            public:
+
+                ~IoUringT() NOEXCEPT
+                {
+                    close();
+                }
+
+                /**
+                 * @brief Creates the ring or returns nullptr with the error code if io_uring is
+                 * not available (e.g. the kernel is too old or it is disabled by a policy)
+                 */
+
+                static auto tryCreate(
+                    SAA_in          const unsigned                      entries,
+                    SAA_out         eh::error_code&                     ec
+                    )
+                    -> cpp::SafeUniquePtr< IoUringT >
+                {
+                    io_uring_params params;
+                    std::memset( &params, 0, sizeof( params ) );
+
+                    const auto fd = static_cast< int >( ::syscall( __NR_io_uring_setup, entries, &params ) );
+
+                    if( fd < 0 )
+                    {
+                        ec = eh::error_code( errno, eh::generic_category() );
+
+                        return nullptr;
+                    }
+
+                    ec.clear();
+
+                    auto fdGuard = BL_SCOPE_GUARD( ::close( fd ); );
+
+                    auto ring = cpp::SafeUniquePtr< IoUringT >::attach( new IoUringT( fd, params ) );
+
+                    fdGuard.dismiss();
+
+                    return ring;
+                }
+
+                int fd() const NOEXCEPT
+                {
+                    return m_fd;
+                }
+
+                unsigned sqEntries() const NOEXCEPT
+                {
+                    return m_sqEntries;
+                }
+
+                unsigned cqEntries() const NOEXCEPT
+                {
+                    return m_cqEntries;
+                }
+
+                /**
+                 * @brief Returns the next free submission queue entry (zeroed) or nullptr if the
+                 * submission queue is full; the entries are made visible to the kernel by
+                 * publishSqes()
+                 */
+
+                io_uring_sqe* tryGetSqe() NOEXCEPT
+                {
+                    const auto head = __atomic_load_n( m_sqHead, __ATOMIC_ACQUIRE );
+
+                    if( m_sqTailLocal - head >= m_sqEntries )
+                    {
+                        return nullptr;
+                    }
+
+                    const auto index = m_sqTailLocal & m_sqMask;
+
+                    m_sqArray[ index ] = index;
+                    ++m_sqTailLocal;
+
+                    auto* sqe = &m_sqes[ index ];
+                    std::memset( sqe, 0, sizeof( *sqe ) );
+
+                    return sqe;
+                }
+
+                void publishSqes() NOEXCEPT
+                {
+                    __atomic_store_n( m_sqTail, m_sqTailLocal, __ATOMIC_RELEASE );
+                }
+
+                /**
+                 * @brief Takes back the entries which were not consumed by the kernel yet and
+                 * invokes the callback with their user data
+                 *
+                 * The kernel consumes the entries only in io_uring_enter calls with toSubmit > 0,
+                 * so the caller must ensure no such call can be made concurrently
+                 */
+
+                template
+                <
+                    typename CB
+                >
+                void withdrawSqes( SAA_in const CB& cb )
+                {
+                    const auto head = __atomic_load_n( m_sqHead, __ATOMIC_ACQUIRE );
+
+                    for( auto i = head; i != m_sqTailLocal; ++i )
+                    {
+                        cb( m_sqes[ m_sqArray[ i & m_sqMask ] ].user_data );
+                    }
+
+                    m_sqTailLocal = head;
+
+                    publishSqes();
+                }
+
+                /**
+                 * @brief Calls io_uring_enter and returns its result or -errno on failure
+                 */
+
+                int enter(
+                    SAA_in          const unsigned                      toSubmit,
+                    SAA_in          const unsigned                      minComplete,
+                    SAA_in          const unsigned                      flags
+                    ) NOEXCEPT
+                {
+                    const auto rc = static_cast< int >(
+                        ::syscall( __NR_io_uring_enter, m_fd, toSubmit, minComplete, flags, nullptr, 0 )
+                        );
+
+                    return rc < 0 ? -errno : rc;
+                }
+
+                const io_uring_cqe* tryPeekCqe() const NOEXCEPT
+                {
+                    const auto head = *m_cqHead;
+
+                    if( head == __atomic_load_n( m_cqTail, __ATOMIC_ACQUIRE ) )
+                    {
+                        return nullptr;
+                    }
+
+                    return &m_cqes[ head & m_cqMask ];
+                }
+
+                void advanceCq() NOEXCEPT
+                {
+                    __atomic_store_n( m_cqHead, *m_cqHead + 1U, __ATOMIC_RELEASE );
+                }
+
+                /**
+                 * @brief Registers the buffers with the ring and returns 0 or -errno on failure
+                 */
+
+                int registerBuffers(
+                    SAA_in          const struct iovec*                 iovecs,
+                    SAA_in          const unsigned                      count
+                    ) NOEXCEPT
+                {
+                    const auto rc = static_cast< int >(
+                        ::syscall( __NR_io_uring_register, m_fd, IORING_REGISTER_BUFFERS, iovecs, count )
+                        );
+
+                    return rc < 0 ? -errno : rc;
+                }
+            };
+
+            typedef IoUringT<> IoUring;
+
+#endif // BL_TASKS_HAS_IO_URING
+
+        } // detail
+
+        /**
+         * @brief class AsyncFileIoService - positional file reads and writes which complete
+         * asynchronously
+         *
+         * On Linux the operations are executed via io_uring: the submitters queue them in the
+         * submission queue and one of them submits all queued operations with one system call
+         * (so under load the submissions are batched) and a single reaper thread dispatches the
+         * completions, so thousands of concurrent reads / writes need only a handful of threads
+         *
+         * The buffers of a set of data blocks can be registered with the ring (see
+         * tryRegisterBuffers) and then the operations on these blocks use the fixed buffer
+         * opcodes which avoid mapping the pages on each operation
+         *
+         * If io_uring is not available (other platforms, old kernels or disabled by a policy)
+         * the operations are executed synchronously via os::fpread / os::fpwrite, i.e. on the
+         * thread pool thread which executes the task
+         *
+         * If io_uring_enter fails unexpectedly (e.g. due to the resource limits) the service
+         * switches to the synchronous mode permanently - the operations which were not yet
+         * submitted to the kernel are executed synchronously on the reaper thread and the new
+         * ones on the thread which schedules them
+         *
+         * The completion callbacks are invoked on the reaper thread, so they should not block
+         * and the service must be disposed explicitly (e.g. by holding it via
+         * om::ObjPtrDisposable) rather than be released from a completion callback
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class AsyncFileIoServiceT : public om::DisposableObjectBase
+        {
+        public:
+
+            typedef AsyncFileIoServiceT< E >                                        this_type;
+
+            enum : std::size_t
+            {
+                QUEUE_DEPTH_DEFAULT = 256U,
+            };
+
+        protected:
+
+#ifdef BL_TASKS_HAS_IO_URING
+
+            enum : std::size_t
+            {
+                /*
+                 * The size of a single read / write is limited to 1 GB (it must fit in 32 bits)
+                 * and the larger operations are resubmitted as partial completions
+                 */
+
+                MAX_OPERATION_SIZE = 0x40000000U,
+            };
+
+            struct Operation
+            {
+                bool                                                        isWrite;
+                int                                                         fd;
+                std::uint64_t                                               offset;
+                char*                                                       buffer;
+                std::size_t                                                 size;
+                std::size_t                                                 done;
+                int                                                         bufferIndex;
+                struct iovec                                                iov;
+                CompletionCallback                                          callback;
+            };
+
+            struct RegisteredBuffer
+            {
+                std::size_t                                                 size;
+                int                                                         index;
+            };
+
+            cpp::SafeUniquePtr< detail::IoUring >                                   m_ring;
+            cpp::SafeUniquePtr< os::thread >                                        m_reaper;
+            std::deque< cpp::SafeUniquePtr< Operation > >                           m_backlog;
+            std::map< const char*, RegisteredBuffer >                               m_registeredBuffers;
+            std::vector< om::ObjPtrCopyable< data::DataBlock > >                    m_registeredBlocks;
+            cpp::ScalarTypeIniter< std::size_t >                                    m_inflight;
+            cpp::ScalarTypeIniter< std::size_t >                                    m_toSubmit;
+            cpp::ScalarTypeIniter< bool >                                           m_flushing;
+            cpp::ScalarTypeIniter< int >                                            m_wakeupFd;
+            std::deque< cpp::SafeUniquePtr< Operation > >                           m_failed;
+            eh::error_code                                                          m_error;
+
+#endif // BL_TASKS_HAS_IO_URING
+
+            mutable os::mutex                                                       m_lock;
+            cpp::ScalarTypeIniter< bool >                                           m_disposed;
+
+            AsyncFileIoServiceT(
+                SAA_in_opt          const std::size_t                               queueDepth = QUEUE_DEPTH_DEFAULT,
+                SAA_in_opt          const bool                                      forceFallback = false
+                )
+            {
+#ifdef BL_TASKS_HAS_IO_URING
+                if( forceFallback )
+                {
+                    return;
+                }
+
+                eh::error_code ec;
+
+                auto ring = detail::IoUring::tryCreate( static_cast< unsigned >( queueDepth ), ec );
+
+                if( ! ring )
+                {
+                    BL_LOG(
+                        Logging::debug(),
+                        BL_MSG()
+                            << "io_uring is not available and the file I/O will be synchronous; reason: "
+                            << ec.message()
+                        );
+
+                    return;
+                }
+
+                /*
+                 * The reaper thread waits for the completions and for the wake up requests
+                 * (e.g. on dispose) with poll, so it never blocks in io_uring_enter
+                 */
+
+                const int wakeupFd = ::eventfd( 0U, EFD_CLOEXEC | EFD_NONBLOCK );
+
+                if( wakeupFd < 0 )
+                {
+                    BL_LOG(
+                        Logging::debug(),
+                        BL_MSG()
+                            << "io_uring is not available and the file I/O will be synchronous; reason: "
+                            << eh::error_code( errno, eh::generic_category() ).message()
+                        );
+
+                    return;
+                }
+
+                auto fdGuard = BL_SCOPE_GUARD( ::close( wakeupFd ); );
+
+                m_ring = std::move( ring );
+                m_wakeupFd = wakeupFd;
+
+                m_reaper = cpp::SafeUniquePtr< os::thread >::attach(
+                    new os::thread( cpp::bind( &this_type::runReaper, this ) )
+                    );
+
+                fdGuard.dismiss();
+#else
+                BL_UNUSED( queueDepth );
+                BL_UNUSED( forceFallback );
+#endif
+            }
+
+            ~AsyncFileIoServiceT() NOEXCEPT
+            {
+                disposeInternal();
+            }
+
+            void disposeInternal() NOEXCEPT
+            {
+                BL_NOEXCEPT_BEGIN()
+
+                {
+                    BL_MUTEX_GUARD( m_lock );
+
+                    if( m_disposed )
+                    {
+                        return;
+                    }
+
+                    m_disposed = true;
+                }
+
+#ifdef BL_TASKS_HAS_IO_URING
+                if( m_ring )
+                {
+                    /*
+                     * The reaper exits once all the outstanding operations have completed
+                     */
+
+                    wakeUpReaper();
+
+                    m_reaper -> join();
+
+                    m_reaper.reset();
+                    m_ring.reset();
+
+                    ::close( m_wakeupFd );
+
+                    m_registeredBuffers.clear();
+                    m_registeredBlocks.clear();
+                }
+#endif
+
+                BL_NOEXCEPT_END()
+            }
+
+#ifdef BL_TASKS_HAS_IO_URING
+
+            void prepareSqe(
+                SAA_inout           io_uring_sqe*                                   sqe,
+                SAA_inout           Operation*                                      op
+                ) NOEXCEPT
+            {
+                sqe -> user_data = reinterpret_cast< std::uint64_t >( op );
+
+                const auto remaining = op -> size - op -> done;
+
+                sqe -> fd = op -> fd;
+                sqe -> off = op -> offset + op -> done;
+
+                op -> iov.iov_base = op -> buffer + op -> done;
+                op -> iov.iov_len = remaining > MAX_OPERATION_SIZE ? MAX_OPERATION_SIZE : remaining;
+
+                if( op -> bufferIndex >= 0 )
+                {
+                    sqe -> opcode = op -> isWrite ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+                    sqe -> addr = reinterpret_cast< std::uint64_t >( op -> iov.iov_base );
+                    sqe -> len = static_cast< std::uint32_t >( op -> iov.iov_len );
+                    sqe -> buf_index = static_cast< std::uint16_t >( op -> bufferIndex );
+                }
+                else
+                {
+                    sqe -> opcode = op -> isWrite ? IORING_OP_WRITEV : IORING_OP_READV;
+                    sqe -> addr = reinterpret_cast< std::uint64_t >( &op -> iov );
+                    sqe -> len = 1U;
+                }
+            }
+
+            /**
+             * @brief Moves the queued operations into the submission queue while there are free
+             * entries and while the completion queue can't overflow
+             */
+
+            void fillSqNoLock() NOEXCEPT
+            {
+                bool published = false;
+
+                while( ! m_backlog.empty() && m_inflight < m_ring -> cqEntries() )
+                {
+                    auto* sqe = m_ring -> tryGetSqe();
+
+                    if( ! sqe )
+                    {
+                        break;
+                    }
+
+                    prepareSqe( sqe, m_backlog.front().release() );
+
+                    m_backlog.pop_front();
+
+                    ++m_inflight;
+                    ++m_toSubmit;
+
+                    published = true;
+                }
+
+                if( published )
+                {
+                    m_ring -> publishSqes();
+                }
+            }
+
+            /**
+             * @brief Submits the queued operations to the kernel
+             *
+             * Only one thread submits at a time and it keeps submitting until there is nothing
+             * left, so the operations queued by the other threads meanwhile are batched in the
+             * next io_uring_enter call
+             */
+
+            void flushSubmissions() NOEXCEPT
+            {
+                bool isFlusher = false;
+
+                for( ;; )
+                {
+                    unsigned toSubmit = 0U;
+
+                    {
+                        BL_MUTEX_GUARD( m_lock );
+
+                        fillSqNoLock();
+
+                        if( ! isFlusher )
+                        {
+                            if( m_flushing )
+                            {
+                                return;
+                            }
+
+                            m_flushing = true;
+                            isFlusher = true;
+                        }
+
+                        if( ! m_toSubmit )
+                        {
+                            m_flushing = false;
+
+                            return;
+                        }
+
+                        toSubmit = static_cast< unsigned >( m_toSubmit.value() );
+                        m_toSubmit = 0U;
+                    }
+
+                    const auto rc = m_ring -> enter( toSubmit, 0U /* minComplete */, 0U /* flags */ );
+
+                    if( rc < 0 && -EINTR != rc && -EAGAIN != rc && -EBUSY != rc )
+                    {
+                        switchToSynchronous( eh::error_code( -rc, eh::generic_category() ) );
+
+                        return;
+                    }
+
+                    const auto submitted = rc < 0 ? 0U : static_cast< unsigned >( rc );
+
+                    if( submitted < toSubmit )
+                    {
+                        /*
+                         * The kernel is temporarily out of resources; the remaining entries are
+                         * still in the submission queue and they will be submitted again
+                         */
+
+                        {
+                            BL_MUTEX_GUARD( m_lock );
+
+                            m_toSubmit += toSubmit - submitted;
+                        }
+
+                        os::sleep( time::milliseconds( 1 ) );
+                    }
+                }
+            }
+
+            void wakeUpReaper() NOEXCEPT
+            {
+                ::eventfd_write( m_wakeupFd, 1U );
+            }
+
+            /**
+             * @brief Called by the submitting thread when io_uring_enter fails unexpectedly
+             *
+             * Nothing is submitted after this point, so the entries which the kernel has not
+             * consumed yet are taken back and they are executed synchronously on the reaper
+             * thread together with the queued operations
+             */
+
+            void switchToSynchronous( SAA_in const eh::error_code& ec ) NOEXCEPT
+            {
+                BL_NOEXCEPT_BEGIN()
+
+                {
+                    BL_MUTEX_GUARD( m_lock );
+
+                    m_error = ec;
+
+                    m_ring -> withdrawSqes(
+                        [ this ]( SAA_in const std::uint64_t userData ) -> void
+                        {
+                            m_failed.push_back(
+                                cpp::SafeUniquePtr< Operation >::attach( reinterpret_cast< Operation* >( userData ) )
+                                );
+
+                            --m_inflight;
+                        }
+                        );
+
+                    while( ! m_backlog.empty() )
+                    {
+                        m_failed.push_back( std::move( m_backlog.front() ) );
+                        m_backlog.pop_front();
+                    }
+
+                    m_toSubmit = 0U;
+                    m_flushing = false;
+                }
+
+                BL_LOG(
+                    Logging::warning(),
+                    BL_MSG()
+                        << "io_uring_enter has failed unexpectedly and the file I/O will be synchronous; reason: "
+                        << ec.message()
+                    );
+
+                wakeUpReaper();
+
+                BL_NOEXCEPT_END()
+            }
+
+            /**
+             * @brief Returns false if the service has switched to the synchronous mode and the
+             * operation must be executed by the caller
+             */
+
+            bool queueOperation( SAA_inout cpp::SafeUniquePtr< Operation >&& op )
+            {
+                {
+                    BL_MUTEX_GUARD( m_lock );
+
+                    BL_CHK(
+                        true,
+                        m_disposed.value(),
+                        BL_MSG()
+                            << "The async file I/O service has been disposed already"
+                        );
+
+                    if( m_error )
+                    {
+                        return false;
+                    }
+
+                    const auto pos = m_registeredBuffers.upper_bound( op -> buffer );
+
+                    if( pos != m_registeredBuffers.begin() )
+                    {
+                        const auto& buffer = std::prev( pos );
+
+                        if( op -> buffer + op -> size <= buffer -> first + buffer -> second.size )
+                        {
+                            op -> bufferIndex = buffer -> second.index;
+                        }
+                    }
+
+                    m_backlog.push_back( BL_PARAM_FWD( op ) );
+                }
+
+                flushSubmissions();
+
+                return true;
+            }
+
+            static std::exception_ptr completionException(
+                SAA_in              const Operation&                                op,
+                SAA_in              const int                                       result
+                )
+            {
+                if( result < 0 )
+                {
+                    return std::make_exception_ptr(
+                        SystemException::create(
+                            eh::error_code( -result, eh::generic_category() ),
+                            op.isWrite ? "Cannot write to file" : "Cannot read from file"
+                            )
+                        );
+                }
+
+                return std::make_exception_ptr(
+                    SystemException::create(
+                        op.isWrite ?
+                            eh::error_code( EIO, eh::generic_category() ) :
+                            eh::errc::make_error_code( eh::errc::operation_not_permitted ),
+                        op.isWrite ? "Cannot write to file" : "Reading past the end of file"
+                        )
+                    );
+            }
+
+            /**
+             * @brief Executes the remainder of the operation with pread / pwrite (used once
+             * the service has switched to the synchronous mode)
+             */
+
+            static std::exception_ptr executeSynchronously( SAA_inout Operation& op )
+            {
+                while( op.done < op.size )
+                {
+                    const auto remaining = op.size - op.done;
+                    const auto size = remaining > MAX_OPERATION_SIZE ? MAX_OPERATION_SIZE : remaining;
+                    const auto offset = static_cast< off_t >( op.offset + op.done );
+
+                    const auto rc = op.isWrite ?
+                        ::pwrite( op.fd, op.buffer + op.done, size, offset ) :
+                        ::pread( op.fd, op.buffer + op.done, size, offset );
+
+                    if( rc < 0 )
+                    {
+                        const int errorCode = errno;
+
+                        if( EINTR == errorCode )
+                        {
+                            continue;
+                        }
+
+                        return completionException( op, -errorCode );
+                    }
+
+                    if( 0 == rc )
+                    {
+                        return completionException( op, 0 );
+                    }
+
+                    op.done += static_cast< std::size_t >( rc );
+                }
+
+                return nullptr;
+            }
+
+            /**
+             * @brief Waits until there are completions to reap or a wake up request
+             *
+             * In the synchronous mode nothing new is submitted, so the ring is polled only
+             * while the operations submitted before are still in flight
+             */
+
+            void waitForCompletions( SAA_in const bool pollRing ) NOEXCEPT
+            {
+                struct pollfd fds[ 2 ];
+
+                fds[ 0 ].fd = m_wakeupFd;
+                fds[ 0 ].events = POLLIN;
+                fds[ 0 ].revents = 0;
+
+                fds[ 1 ].fd = m_ring -> fd();
+                fds[ 1 ].events = POLLIN;
+                fds[ 1 ].revents = 0;
+
+                /*
+                 * EINTR (or any other error) simply causes the state to be re-checked
+                 */
+
+                if( ::poll( fds, pollRing ? 2U : 1U, -1 /* timeout */ ) > 0 && ( fds[ 0 ].revents & POLLIN ) )
+                {
+                    eventfd_t value;
+
+                    ::eventfd_read( m_wakeupFd, &value );
+                }
+            }
+
+            void runReaper() NOEXCEPT
+            {
+                BL_NOEXCEPT_BEGIN()
+
+                bool pollRing = true;
+                bool isIdle = true;
+
+                for( ;; )
+                {
+                    if( isIdle )
+                    {
+                        waitForCompletions( pollRing );
+                    }
+
+                    std::size_t completed = 0U;
+                    std::deque< cpp::SafeUniquePtr< Operation > > resubmit;
+
+                    while( const auto* cqe = m_ring -> tryPeekCqe() )
+                    {
+                        auto op = cpp::SafeUniquePtr< Operation >::attach(
+                            reinterpret_cast< Operation* >( cqe -> user_data )
+                            );
+
+                        const auto result = cqe -> res;
+
+                        m_ring -> advanceCq();
+
+                        ++completed;
+
+                        if( result > 0 )
+                        {
+                            op -> done += static_cast< std::size_t >( result );
+
+                            if( op -> done < op -> size )
+                            {
+                                /*
+                                 * Partial read or write (e.g. a large operation); we resubmit
+                                 * the remainder of it
+                                 */
+
+                                resubmit.push_back( std::move( op ) );
+
+                                continue;
+                            }
+                        }
+
+                        op -> callback( result > 0 ? nullptr : completionException( *op, result ) );
+                    }
+
+                    std::deque< cpp::SafeUniquePtr< Operation > > synchronous;
+                    bool isSynchronousMode;
+
+                    {
+                        BL_MUTEX_GUARD( m_lock );
+
+                        BL_ASSERT( m_inflight >= completed );
+
+                        m_inflight -= completed;
+
+                        isSynchronousMode = m_error ? true : false;
+
+                        if( isSynchronousMode )
+                        {
+                            synchronous.swap( m_failed );
+
+                            for( auto& op : resubmit )
+                            {
+                                synchronous.push_back( std::move( op ) );
+                            }
+                        }
+                        else
+                        {
+                            while( ! resubmit.empty() )
+                            {
+                                m_backlog.push_front( std::move( resubmit.back() ) );
+                                resubmit.pop_back();
+                            }
+                        }
+
+                        pollRing = ! isSynchronousMode || m_inflight > 0U;
+
+                        if( m_disposed && ! m_inflight && m_backlog.empty() && synchronous.empty() )
+                        {
+                            break;
+                        }
+                    }
+
+                    for( auto& op : synchronous )
+                    {
+                        op -> callback( executeSynchronously( *op ) );
+                    }
+
+                    isIdle = ! completed && synchronous.empty();
+
+                    if( completed && ! isSynchronousMode )
+                    {
+                        flushSubmissions();
+                    }
+                }
+
+                BL_NOEXCEPT_END()
+            }
+
+            bool scheduleOperation(
+                SAA_in              const bool                                      isWrite,
+                SAA_in              const os::stdio_file_ptr&                       fileptr,
+                SAA_in              const std::uint64_t                             offset,
+                SAA_in              void*                                           buffer,
+                SAA_in              const std::size_t                               size,
+                SAA_in              CompletionCallback&&                            callback
+                )
+            {
+                if( ! m_ring )
+                {
+                    return false;
+                }
+
+                auto op = cpp::SafeUniquePtr< Operation >::attach( new Operation() );
+
+                op -> isWrite = isWrite;
+                op -> fd = ::fileno( fileptr.get() );
+                op -> offset = offset;
+                op -> buffer = static_cast< char* >( buffer );
+                op -> size = size;
+                op -> bufferIndex = -1;
+                op -> callback = BL_PARAM_FWD( callback );
+
+                return queueOperation( std::move( op ) );
+            }
+
+#endif // BL_TASKS_HAS_IO_URING
+
+        public:
+
+            /**
+             * @brief Returns true if the operations complete asynchronously (i.e. io_uring is
+             * used) and false if they are executed synchronously
+             */
+
+            bool isAsync() const NOEXCEPT
+            {
+#ifdef BL_TASKS_HAS_IO_URING
+                BL_MUTEX_GUARD( m_lock );
+
+                return nullptr != m_ring && ! m_error;
+#else
+                return false;
+#endif
+            }
+
+            /**
+             * @brief Registers the buffers of the data blocks with the ring, so the operations on
+             * them use the fixed buffers and returns false if the buffers can't be registered
+             * (e.g. the operations are synchronous, some buffers are registered already or the
+             * locked memory limit is too low)
+             *
+             * The blocks are kept alive until the service is disposed
+             */
+
+            bool tryRegisterBuffers( SAA_in const std::vector< om::ObjPtrCopyable< data::DataBlock > >& blocks )
+            {
+#ifdef BL_TASKS_HAS_IO_URING
+                BL_MUTEX_GUARD( m_lock );
+
+                if( ! m_ring || m_disposed || ! m_registeredBlocks.empty() || blocks.empty() )
+                {
+                    return false;
+                }
+
+                std::vector< struct iovec > iovecs( blocks.size() );
+
+                for( std::size_t i = 0U; i < blocks.size(); ++i )
+                {
+                    iovecs[ i ].iov_base = blocks[ i ] -> begin();
+                    iovecs[ i ].iov_len = blocks[ i ] -> capacity();
+                }
+
+                const auto rc = m_ring -> registerBuffers( iovecs.data(), static_cast< unsigned >( iovecs.size() ) );
+
+                if( rc < 0 )
+                {
+                    BL_LOG(
+                        Logging::debug(),
+                        BL_MSG()
+                            << "Cannot register the buffers with io_uring; reason: "
+                            << eh::error_code( -rc, eh::generic_category() ).message()
+                        );
+
+                    return false;
+                }
+
+                for( std::size_t i = 0U; i < blocks.size(); ++i )
+                {
+                    RegisteredBuffer buffer;
+
+                    buffer.size = blocks[ i ] -> capacity();
+                    buffer.index = static_cast< int >( i );
+
+                    m_registeredBuffers[ blocks[ i ] -> begin() ] = buffer;
+                }
+
+                m_registeredBlocks = blocks;
+
+                return true;
+#else
+                BL_UNUSED( blocks );
+
+                return false;
+#endif
+            }
+
+            /**
+             * @brief Reads exactly size bytes at the specified offset
+             *
+             * Returns true if the read was scheduled and the callback will be invoked once it
+             * completes or false if the read has completed synchronously (in which case the
+             * errors are thrown) - i.e. it has the semantics of IfScheduleCallback
+             *
+             * The file and the buffer must be kept alive until the read completes
+             */
+
+            bool asyncRead(
+                SAA_in              const os::stdio_file_ptr&                       fileptr,
+                SAA_in              const std::uint64_t                             offset,
+                SAA_out_bcount( size ) void*                                        buffer,
+                SAA_in              const std::size_t                               size,
+                SAA_in              CompletionCallback&&                            callback
+                )
+            {
+#ifdef BL_TASKS_HAS_IO_URING
+                if( scheduleOperation( false /* isWrite */, fileptr, offset, buffer, size, BL_PARAM_FWD( callback ) ) )
+                {
+                    return true;
+                }
+#else
+                BL_UNUSED( callback );
+#endif
+
+                os::fpread( fileptr, offset, buffer, size );
+
+                return false;
+            }
+
+            /**
+             * @brief Writes size bytes at the specified offset (see asyncRead for the semantics)
+             */
+
+            bool asyncWrite(
+                SAA_in              const os::stdio_file_ptr&                       fileptr,
+                SAA_in              const std::uint64_t                             offset,
+                SAA_in_bcount( size ) const void*                                   buffer,
+                SAA_in              const std::size_t                               size,
+                SAA_in              CompletionCallback&&                            callback
+                )
+            {
+#ifdef BL_TASKS_HAS_IO_URING
+                if(
+                    scheduleOperation(
+                        true /* isWrite */,
+                        fileptr,
+                        offset,
+                        const_cast< void* >( buffer ),
+                        size,
+                        BL_PARAM_FWD( callback )
+                        )
+                    )
+                {
+                    return true;
+                }
+#else
+                BL_UNUSED( callback );
+#endif
+
+                os::fpwrite( fileptr, offset, buffer, size );
+
+                return false;
+            }
+
+            virtual void dispose() NOEXCEPT OVERRIDE
+            {
+                disposeInternal();
+            }
+        };
+
+        typedef om::ObjectImpl< AsyncFileIoServiceT<> > AsyncFileIoService;
+
+        /**
+         * @brief class AsyncFileIoTask - a task which reads or writes a data block at the
+         * specified offset of a file via the async file I/O service
+         *
+         * The read task reads size bytes at the beginning of the data block and sets its size
+         * and the write task writes the data block contents
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class AsyncFileIoTaskT : public ExternalCompletionTaskIfT<>
+        {
+            BL_DECLARE_OBJECT_IMPL( AsyncFileIoTaskT )
+
+        protected:
+
+            typedef AsyncFileIoTaskT< E >                                           this_type;
+            typedef ExternalCompletionTaskIfT<>                                     base_type;
+
+            const om::ObjPtrCopyable< AsyncFileIoService >                          m_service;
+            const om::ObjPtrCopyable< bo::stdio_file >                              m_file;
+            const om::ObjPtrCopyable< data::DataBlock >                             m_dataBlock;
+            const std::uint64_t                                                     m_offset;
+            const std::size_t                                                       m_size;
+            const bool                                                              m_isWrite;
+
+            AsyncFileIoTaskT(
+                SAA_in              const om::ObjPtr< AsyncFileIoService >&         service,
+                SAA_in              const om::ObjPtr< bo::stdio_file >&             file,
+                SAA_in              const std::uint64_t                             offset,
+                SAA_in              const om::ObjPtr< data::DataBlock >&            dataBlock,
+                SAA_in              const std::size_t                               size,
+                SAA_in              const bool                                      isWrite
+                )
+                :
+                base_type( cpp::bind( &this_type::scheduleOperation, this, _1 ) ),
+                m_service( om::copy( service ) ),
+                m_file( om::copy( file ) ),
+                m_dataBlock( om::copy( dataBlock ) ),
+                m_offset( offset ),
+                m_size( size ),
+                m_isWrite( isWrite )
+            {
+                BL_ASSERT( m_size <= m_dataBlock -> capacity() );
+
+                m_name = isWrite ? "AsyncFileIoTask_Write" : "AsyncFileIoTask_Read";
+            }
+
+            bool scheduleOperation( SAA_in const CompletionCallback& onReady )
+            {
+                auto callback = onReady;
+
+                if( m_isWrite )
+                {
+                    return m_service -> asyncWrite(
+                        m_file -> value(),
+                        m_offset,
+                        m_dataBlock -> pv(),
+                        m_size,
+                        std::move( callback )
+                        );
+                }
+
+                m_dataBlock -> setSize( m_size );
+
+                return m_service -> asyncRead(
+                    m_file -> value(),
+                    m_offset,
+                    m_dataBlock -> pv(),
+                    m_size,
+                    std::move( callback )
+                    );
+            }
+
+        public:
+
+            static auto createReadTask(
+                SAA_in              const om::ObjPtr< AsyncFileIoService >&         service,
+                SAA_in              const om::ObjPtr< bo::stdio_file >&             file,
+                SAA_in              const std::uint64_t                             offset,
+                SAA_in              const om::ObjPtr< data::DataBlock >&            dataBlock,
+                SAA_in              const std::size_t                               size
+                )
+                -> om::ObjPtr< Task >
+            {
+                return om::ObjectImpl< this_type >::template createInstance< Task >(
+                    service,
+                    file,
+                    offset,
+                    dataBlock,
+                    size,
+                    false /* isWrite */
+                    );
+            }
+
+            static auto createWriteTask(
+                SAA_in              const om::ObjPtr< AsyncFileIoService >&         service,
+                SAA_in              const om::ObjPtr< bo::stdio_file >&             file,
+                SAA_in              const std::uint64_t                             offset,
+                SAA_in              const om::ObjPtr< data::DataBlock >&            dataBlock
+                )
+                -> om::ObjPtr< Task >
+            {
+                return om::ObjectImpl< this_type >::template createInstance< Task >(
+                    service,
+                    file,
+                    offset,
+                    dataBlock,
+                    dataBlock -> size(),
+                    true /* isWrite */
+                    );
+            }
+
+            auto dataBlock() const NOEXCEPT -> const om::ObjPtrCopyable< data::DataBlock >&
+            {
+                return m_dataBlock;
+            }
+
+            std::uint64_t offset() const NOEXCEPT
+            {
+                return m_offset;
+            }
+        };
+
+        typedef om::ObjectImpl< AsyncFileIoTaskT<> > AsyncFileIoTaskImpl;
+
+    } // tasks
+
+} // bl
+
+#endif /* __BL_TASKS_UTILS_ASYNCFILEIOSERVICE_H_ */
@@ -64,17 +64,21 @@ namespace bl
             fs::path                                                                        m_path;
             const om::ObjPtr< bo::path >                                                    m_rootPath;
             std::vector< fs::directory_entry >                                              m_entries;
+            std::vector< os::DirectoryEntryStat >                                           m_entriesStats;
             const om::ObjPtr< DirectoryScannerControlToken >                                m_cbControl;
+            const os::DirectoryStatMode                                                     m_statMode;
 
             ScanDirectoryTaskT(
                 SAA_in              const fs::path&                                         path,
                 SAA_in              const om::ObjPtr< bo::path >&                           rootPath,
-                SAA_in_opt          const om::ObjPtr< DirectoryScannerControlToken >&       cbControl = nullptr
+                SAA_in_opt          const om::ObjPtr< DirectoryScannerControlToken >&       cbControl = nullptr,
+                SAA_in_opt          const os::DirectoryStatMode                             statMode = os::DirectoryStatNone
                 )
                 :
                 m_path( path ),
                 m_rootPath( om::copy( rootPath ) ),
-                m_cbControl( om::copy( cbControl ) )
+                m_cbControl( om::copy( cbControl ) ),
+                m_statMode( statMode )
             {
             }
 
@@ -83,6 +87,7 @@ namespace bl
                 std::vector< fs::path > dirsToScan;
 
                 const auto cbControl = om::copy( m_cbControl );
+                const auto statMode = m_statMode;
                 const auto eq = m_eq;
 
                 {
@@ -90,8 +95,17 @@ namespace bl
 
                     try
                     {
+                        /*
+                         * The directory is read in one pass with os::readDirectory() which
+                         * returns the entry types without calling stat on each entry (stat
+                         * is only called if it was requested via m_statMode), so the
+                         * directory entries below are created with cached statuses
+                         */
+
                         eh::error_code ec;
-                        fs::directory_iterator end, it( m_path, ec );
+                        std::vector< os::DirectoryEntryInfo > infos;
+
+                        os::readDirectory( m_path, m_statMode, infos, ec );
 
                         if( ec && ( nullptr == m_cbControl || false == m_cbControl -> isErrorAllowed( ec ) ) )
                         {
@@ -105,9 +119,25 @@ namespace bl
 
                         if( ! ec )
                         {
-                            for( ; it != end; ++it )
+                            m_entries.reserve( infos.size() );
+                            m_entriesStats.reserve( infos.size() );
+
+                            for( auto& info : infos )
                             {
-                                const auto& entry = *it;
+                                const auto type = info.symlinkStatus.type();
+
+                                /*
+                                 * The status of the symlink target is left unknown, so it
+                                 * will be resolved lazily if someone asks for it
+                                 */
+
+                                const bool isTargetStatusKnown = fs::symlink_file != type && fs::status_error != type;
+
+                                fs::directory_entry entry(
+                                    m_path / info.name,
+                                    isTargetStatusKnown ? info.symlinkStatus : fs::file_status(),
+                                    info.symlinkStatus
+                                    );
 
                                 const auto status = entry.symlink_status();
 
@@ -153,6 +183,7 @@ namespace bl
                                 }
 
                                 m_entries.push_back( std::move( entry ) );
+                                m_entriesStats.push_back( info.stat );
                             }
                         }
 
@@ -178,7 +209,7 @@ namespace bl
 
                 for( const auto& path : dirsToScan )
                 {
-                    const auto scanner = ScanDirectoryTaskImpl::createInstance( path, m_rootPath, cbControl );
+                    const auto scanner = ScanDirectoryTaskImpl::createInstance( path, m_rootPath, cbControl, statMode );
                     eq -> push_back( om::qi< Task >( scanner ) );
                 }
 
@@ -197,6 +228,18 @@ namespace bl
                 return m_entries;
             }
 
+            /**
+             * @brief The sizes and the last write times of the entries (parallel to entries())
+             *
+             * These are only known for the entries which were stat-ed as requested by the stat
+             * mode the task was created with
+             */
+
+            const std::vector< os::DirectoryEntryStat >& entriesStats() const NOEXCEPT
+            {
+                return m_entriesStats;
+            }
+
             const fs::path& rootPath() const NOEXCEPT
             {
                 return m_rootPath -> value();
@@ -122,11 +122,19 @@ namespace bl
 
                             /*
                              * Try to schedule as much as possible for this slice
+                             *
+                             * Duplicate chunks are skipped as their data was never stored (it
+                             * is the data of another chunk with the same hash)
                              */
 
                             while( false == m_chunksQueue.full() && m_chunksIterator -> hasCurrent() )
                             {
-                                m_chunksQueue.push_back( m_chunksIterator -> current() );
+                                const auto chunkId = m_chunksIterator -> current();
+
+                                if( ! m_fsmd -> loadChunkInfo( chunkId ).isChunkDuplicate )
+                                {
+                                    m_chunksQueue.push_back( chunkId );
+                                }
 
                                 m_chunksIterator -> loadNext();
                             }
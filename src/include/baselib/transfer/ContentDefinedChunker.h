@@ -0,0 +1,261 @@
+/*
+ * This file is part of the swblocks-baselib library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __BL_TRANSFER_CONTENTDEFINEDCHUNKER_H_
+#define __BL_TRANSFER_CONTENTDEFINEDCHUNKER_H_
+
+#include <baselib/core/BaseIncludes.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace bl
+{
+    namespace transfer
+    {
+        namespace detail
+        {
+            /**
+             * @brief class GearTable - the table of random 64 bit values used by the gear
+             * rolling hash (one value per byte value)
+             *
+             * The values are generated with splitmix64 from a fixed seed, so the chunk boundaries
+             * are stable across processes and versions (which is required for deduplication)
+             */
+
+            template
+            <
+                typename E = void
+            >
+            class GearTableT
+            {
+                BL_NO_COPY_OR_MOVE( GearTableT )
+
+            private:
+
+                GearTableT() NOEXCEPT
+                {
+                    std::uint64_t state = 0x42u;
+
+                    for( std::size_t i = 0U; i < 256U; ++i )
+                    {
+                        state += 0x9E3779B97F4A7C15ULL;
+
+                        std::uint64_t value = state;
+
+                        value = ( value ^ ( value >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+                        value = ( value ^ ( value >> 27 ) ) * 0x94D049BB133111EBULL;
+
+                        table[ i ] = value ^ ( value >> 31 );
+                    }
+                }
+
+            public:
+
+                std::uint64_t                                   table[ 256 ];
+
+                static auto get() NOEXCEPT -> const GearTableT&
+                {
+                    static const GearTableT g_table;
+
+                    return g_table;
+                }
+            };
+
+            typedef GearTableT<> GearTable;
+
+        } // detail
+
+        /**
+         * @brief class ContentDefinedChunker - FastCDC style content-defined chunking
+         *
+         * The chunk boundaries are chosen where the gear rolling hash of the data matches a mask
+         * and thus they move together with the content when bytes are inserted or removed (unlike
+         * fixed size chunks where every chunk after the change is different). The first minSize
+         * bytes of a chunk are never examined and the chunk sizes are normalized around avgSize
+         * by using a harder mask before avgSize and an easier mask after it
+         *
+         * The chunker is incremental - scan() can be called repeatedly for the same chunk as more
+         * data becomes available and the bytes which were already examined are not scanned again
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class ContentDefinedChunkerT
+        {
+        public:
+
+            enum : std::size_t
+            {
+                MIN_CHUNK_SIZE_DEFAULT = 64U * 1024U,
+                AVG_CHUNK_SIZE_DEFAULT = 256U * 1024U,
+                MAX_CHUNK_SIZE_DEFAULT = 1024U * 1024U,
+            };
+
+        protected:
+
+            enum : std::size_t
+            {
+                NORMALIZATION_LEVEL = 2U,
+            };
+
+            const std::size_t                                   m_minSize;
+            const std::size_t                                   m_avgSize;
+            const std::size_t                                   m_maxSize;
+            const std::uint64_t                                 m_maskSmall;
+            const std::uint64_t                                 m_maskLarge;
+
+            std::uint64_t                                       m_hash;
+            std::size_t                                         m_scanned;
+
+            static std::size_t log2Floor( SAA_in std::size_t value ) NOEXCEPT
+            {
+                std::size_t result = 0U;
+
+                while( value >>= 1 )
+                {
+                    ++result;
+                }
+
+                return result;
+            }
+
+            /**
+             * @brief A mask with the specified number of the most significant bits set (the high
+             * bits of the gear hash depend on the most recent 64 bytes, the low bits on fewer)
+             */
+
+            static std::uint64_t highBitsMask( SAA_in const std::size_t bits ) NOEXCEPT
+            {
+                return ~std::uint64_t( 0U ) << ( 64U - bits );
+            }
+
+        public:
+
+            ContentDefinedChunkerT(
+                SAA_in_opt          const std::size_t               minSize = MIN_CHUNK_SIZE_DEFAULT,
+                SAA_in_opt          const std::size_t               avgSize = AVG_CHUNK_SIZE_DEFAULT,
+                SAA_in_opt          const std::size_t               maxSize = MAX_CHUNK_SIZE_DEFAULT
+                )
+                :
+                m_minSize( minSize ),
+                m_avgSize( avgSize ),
+                m_maxSize( maxSize ),
+                m_maskSmall( highBitsMask( std::min< std::size_t >( log2Floor( avgSize ) + NORMALIZATION_LEVEL, 63U ) ) ),
+                m_maskLarge( highBitsMask( std::max< std::size_t >( log2Floor( avgSize ), NORMALIZATION_LEVEL + 1U ) - NORMALIZATION_LEVEL ) ),
+                m_hash( 0U ),
+                m_scanned( 0U )
+            {
+                BL_CHK(
+                    false,
+                    0U < minSize && minSize < avgSize && avgSize < maxSize,
+                    BL_MSG()
+                        << "Invalid content-defined chunk sizes; min: "
+                        << minSize
+                        << ", avg: "
+                        << avgSize
+                        << ", max: "
+                        << maxSize
+                    );
+            }
+
+            std::size_t minSize() const NOEXCEPT
+            {
+                return m_minSize;
+            }
+
+            std::size_t avgSize() const NOEXCEPT
+            {
+                return m_avgSize;
+            }
+
+            std::size_t maxSize() const NOEXCEPT
+            {
+                return m_maxSize;
+            }
+
+            /**
+             * @brief Starts a new chunk
+             */
+
+            void reset() NOEXCEPT
+            {
+                m_hash = 0U;
+                m_scanned = 0U;
+            }
+
+            /**
+             * @brief Continues scanning the chunk which begins at data and of which size bytes
+             * are available so far
+             *
+             * Returns the chunk size if a cut point was found (or the max chunk size if size has
+             * reached it) and zero if more data is needed; if there is no more data the caller
+             * should simply cut the chunk at size
+             */
+
+            auto scan(
+                SAA_in_bcount( size )   const void*                 data,
+                SAA_in                  std::size_t                 size
+                ) NOEXCEPT
+                -> std::size_t
+            {
+                const auto* bytes = static_cast< const unsigned char* >( data );
+                const auto& gear = detail::GearTable::get().table;
+
+                size = std::min( size, m_maxSize );
+
+                std::uint64_t hash = m_hash;
+                std::size_t pos = std::max( m_scanned, m_minSize );
+
+                const std::size_t normalSize = std::min( m_avgSize, size );
+
+                for( ; pos < normalSize; ++pos )
+                {
+                    hash = ( hash << 1 ) + gear[ bytes[ pos ] ];
+
+                    if( 0U == ( hash & m_maskSmall ) )
+                    {
+                        return pos + 1U;
+                    }
+                }
+
+                for( ; pos < size; ++pos )
+                {
+                    hash = ( hash << 1 ) + gear[ bytes[ pos ] ];
+
+                    if( 0U == ( hash & m_maskLarge ) )
+                    {
+                        return pos + 1U;
+                    }
+                }
+
+                m_hash = hash;
+                m_scanned = pos;
+
+                return size == m_maxSize ? m_maxSize : 0U;
+            }
+        };
+
+        typedef ContentDefinedChunkerT<> ContentDefinedChunker;
+
+    } // transfer
+
+} // bl
+
+#endif /* __BL_TRANSFER_CONTENTDEFINEDCHUNKER_H_ */
@@ -18,6 +18,7 @@
 #define __BL_TRANSFER_FILESPACKAGERUNIT_H_
 
 #include <baselib/core/Checksum.h>
+#include <baselib/transfer/ContentDefinedChunker.h>
 #include <baselib/transfer/FilesPkgUnpkgBase.h>
 #include <baselib/transfer/FilesPkgUnpkgIncludes.h>
 
@@ -26,6 +27,7 @@
 #include <baselib/core/FsUtils.h>
 
 #include <map>
+#include <unordered_set>
 
 namespace bl
 {
@@ -33,6 +35,42 @@ namespace bl
     {
         namespace detail
         {
+            /**
+             * @brief class ChunksDedupIndex - the set of the chunk hashes which were seen by
+             * the packager (shared by all block reader tasks of the packager)
+             */
+
+            template
+            <
+                typename E = void
+            >
+            class ChunksDedupIndexT : public om::ObjectDefaultBase
+            {
+                BL_NO_COPY_OR_MOVE( ChunksDedupIndexT )
+                BL_CTR_DEFAULT( ChunksDedupIndexT, protected )
+
+            protected:
+
+                os::mutex                                                                       m_lock;
+                std::unordered_set< std::string >                                               m_hashes;
+
+            public:
+
+                /**
+                 * @brief Returns true if the hash is seen for the first time (i.e. the chunk
+                 * data has to be transferred) and false if the chunk is a duplicate
+                 */
+
+                bool tryRegister( SAA_in const std::string& hash )
+                {
+                    BL_MUTEX_GUARD( m_lock );
+
+                    return m_hashes.insert( hash ).second;
+                }
+            };
+
+            typedef om::ObjectImpl< ChunksDedupIndexT<> > ChunksDedupIndex;
+
             /**
              * @brief class FileTask
              */
@@ -53,6 +91,7 @@ namespace bl
                 const om::ObjPtr< data::FilesystemMetadataWO >                                  m_fsmd;
                 const om::ObjPtrCopyable< tasks::ScanDirectoryTaskImpl >                        m_entryTask;
                 const fs::directory_entry&                                                      m_entry;
+                const os::DirectoryEntryStat&                                                   m_entryStat;
 
                 EntryInfo                                                                       m_info;
                 uuid_t                                                                          m_entryId;
@@ -62,12 +101,14 @@ namespace bl
                 FileTaskT(
                     SAA_in          const om::ObjPtr< data::FilesystemMetadataWO >&             fsmd,
                     SAA_in          const om::ObjPtrCopyable< tasks::ScanDirectoryTaskImpl >    entryTask,
-                    SAA_in          const fs::directory_entry&                                  entry
+                    SAA_in          const fs::directory_entry&                                  entry,
+                    SAA_in          const os::DirectoryEntryStat&                               entryStat
                     )
                     :
                     m_fsmd( om::copy( fsmd ) ),
                     m_entryTask( entryTask ),
-                    m_entry( entry )
+                    m_entry( entry ),
+                    m_entryStat( entryStat )
                 {
                 }
 
@@ -85,12 +126,21 @@ namespace bl
                         /*
                          * Just obtain the file size and open the file
                          * so it is ready for reading
+                         *
+                         * If the scanner has already called stat on the entry (relative
+                         * to its directory fd) then the status has the permissions and
+                         * we also have the size and the last write time, so no more
+                         * stat calls are needed; otherwise the cached status may only
+                         * have the type, so we get a full status here
                          */
 
-                        const auto status = m_entry.symlink_status();
                         const auto& path = m_entry.path();
 
-                        m_info.lastModified = fs::last_write_time( path );
+                        const auto status =
+                            m_entryStat.isKnown ? m_entry.symlink_status() : fs::symlink_status( path );
+
+                        m_info.lastModified =
+                            m_entryStat.isKnown ? m_entryStat.lastWriteTime : fs::last_write_time( path );
                         m_info.timeCreated = os::onWindows() ? fs::safeGetFileCreateTime( path ) : 0;
 
                         m_info.relPath = bo::path::createInstance();
@@ -110,7 +160,7 @@ namespace bl
                             }
 
                             m_info.type = data::FilesystemMetadata::File;
-                            m_info.size = fs::file_size( path );
+                            m_info.size = m_entryStat.isKnown ? m_entryStat.size : fs::file_size( path );
                         }
                         else if( fs::is_symlink( status ) )
                         {
@@ -223,33 +273,51 @@ namespace bl
 
             protected:
 
+                typedef BlockReaderTaskT< E >                                                   this_type;
                 typedef data::FilesystemMetadata::ChunkInfo                                     ChunkInfo;
 
+                enum : std::size_t
+                {
+                    READ_SLICE_SIZE = 64U * 1024U,
+                };
+
                 const om::ObjPtr< data::FilesystemMetadataWO >                                  m_fsmd;
+                const om::ObjPtr< ChunksDedupIndex >                                            m_dedupIndex;
+                const om::ObjPtr< tasks::AsyncFileIoService >                                   m_fileIoService;
 
+                cpp::SafeUniquePtr< ContentDefinedChunker >                                     m_chunker;
                 om::ObjPtr< FileTaskImpl >                                                      m_fileTask;
                 os::stdio_file_ptr                                                              m_filePtr;
                 om::ObjPtr< data::DataBlock >                                                   m_dataBlock;
                 cpp::ScalarTypeIniter< std::uint64_t >                                          m_filePos;
                 uuid_t                                                                          m_chunkId;
+                cpp::ScalarTypeIniter< bool >                                                   m_isChunkDuplicate;
+                cpp::ScalarTypeIniter< bool >                                                   m_readScheduled;
 
                 BlockReaderTaskT(
-                    SAA_in          const om::ObjPtr< data::FilesystemMetadataWO >&             fsmd
+                    SAA_in          const om::ObjPtr< data::FilesystemMetadataWO >&             fsmd,
+                    SAA_in_opt      const bool                                                  contentDefinedChunking = false,
+                    SAA_in_opt      const om::ObjPtr< ChunksDedupIndex >&                       dedupIndex = nullptr,
+                    SAA_in_opt      const om::ObjPtr< tasks::AsyncFileIoService >&              fileIoService = nullptr
                     )
                     :
-                    m_fsmd( om::copy( fsmd ) )
+                    m_fsmd( om::copy( fsmd ) ),
+                    m_dedupIndex( om::copy( dedupIndex ) ),
+                    m_fileIoService( om::copy( fileIoService ) )
                 {
+                    if( contentDefinedChunking )
+                    {
+                        m_chunker = cpp::SafeUniquePtr< ContentDefinedChunker >::attach( new ContentDefinedChunker() );
+                    }
                 }
 
-                void doExecute()
+                std::size_t readFixedSizeChunk(
+                    SAA_in          const std::uint64_t                                         bytesLeft,
+                    SAA_out         bool&                                                       isScheduled
+                    )
                 {
-                    /*
-                     * Just obtain the file size and open the file
-                     * so it is ready for reading
-                     */
+                    isScheduled = false;
 
-                    const std::uint64_t fileSize = m_fileTask -> fileSize();
-                    const std::uint64_t bytesLeft = ( fileSize - m_filePos );
                     const std::uint64_t capacity = m_dataBlock -> capacity64();
 
                     /*
@@ -258,12 +326,160 @@ namespace bl
 
                     const std::size_t bytesToRead = ( std::size_t )( ( bytesLeft <= capacity ) ? bytesLeft : capacity );
 
+                    if( ! m_fileIoService )
+                    {
+                        os::fread( m_filePtr, m_dataBlock -> pv(), bytesToRead );
+
+                        return bytesToRead;
+                    }
+
+                    /*
+                     * If the async file I/O service is configured the fixed size chunks are read
+                     * with positional reads (i.e. the file position is not used) and if the read
+                     * is scheduled the task will complete when it completes (see onReadCompleted)
+                     *
+                     * The flag is set before the read is submitted (under the task lock) since the
+                     * completion can run on the reaper thread as soon as it is submitted and it is
+                     * cleared if the read has completed synchronously; the caller must rely on the
+                     * returned isScheduled rather than on the flag to decide if the task completes
+                     * now
+                     */
+
+                    m_readScheduled = true;
+
+                    auto guard = BL_SCOPE_GUARD( { m_readScheduled = false; } );
+
+                    isScheduled = m_fileIoService -> asyncRead(
+                        m_filePtr,
+                        m_filePos,
+                        m_dataBlock -> pv(),
+                        bytesToRead,
+                        cpp::bind(
+                            &this_type::onReadCompleted,
+                            om::ObjPtrCopyable< this_type >::acquireRef( this ),
+                            bytesToRead,
+                            _1
+                            )
+                        );
+
+                    if( isScheduled )
+                    {
+                        guard.dismiss();
+                    }
+
+                    return bytesToRead;
+                }
+
+                void onReadCompleted(
+                    SAA_in          const std::size_t                                           bytesToRead,
+                    SAA_in_opt      const std::exception_ptr&                                   eptr
+                    ) NOEXCEPT
+                {
+                    BL_TASKS_HANDLER_BEGIN()
+
+                    BL_ASSERT( m_readScheduled );
+
+                    m_readScheduled = false;
+
+                    if( eptr )
+                    {
+                        cpp::safeRethrowException( eptr );
+                    }
+
+                    processChunk( bytesToRead );
+
+                    BL_TASKS_HANDLER_END()
+                }
+
+                std::size_t readContentDefinedChunk( SAA_in const std::uint64_t bytesLeft )
+                {
+                    /*
+                     * The data is read in slices until a cut point is found, so we don't read much
+                     * past the end of the chunk; the bytes read past the cut point (less than one
+                     * slice) are read again as the beginning of the next chunk
+                     *
+                     * If no cut point is found before the end of the file or before the block is
+                     * full (the block capacity can be smaller than the max chunk size) the chunk
+                     * is simply cut there
+                     */
+
+                    const std::uint64_t limit64 = std::min< std::uint64_t >(
+                        std::min< std::uint64_t >( m_dataBlock -> capacity64(), m_chunker -> maxSize() ),
+                        bytesLeft
+                        );
+
+                    const std::size_t limit = ( std::size_t ) limit64;
+
+                    m_chunker -> reset();
+
+                    std::size_t bytesRead = 0U;
+                    std::size_t chunkSize = 0U;
+
+                    while( 0U == chunkSize && bytesRead < limit )
+                    {
+                        const std::size_t sliceSize = std::min< std::size_t >(
+                            limit - bytesRead,
+                            bytesRead ? READ_SLICE_SIZE : m_chunker -> minSize() + READ_SLICE_SIZE
+                            );
+
+                        os::fread( m_filePtr, m_dataBlock -> begin() + bytesRead, sliceSize );
+
+                        bytesRead += sliceSize;
+
+                        chunkSize = m_chunker -> scan( m_dataBlock -> begin(), bytesRead );
+                    }
+
+                    if( 0U == chunkSize )
+                    {
+                        chunkSize = bytesRead;
+                    }
+
+                    if( chunkSize < bytesRead )
+                    {
+                        os::fseek( m_filePtr, m_filePos + chunkSize, SEEK_SET );
+                    }
+
+                    return chunkSize;
+                }
+
+                /**
+                 * @brief Reads the next chunk and returns true if the read was scheduled on the
+                 * async file I/O service (in which case the chunk is processed when it completes)
+                 */
+
+                bool doExecute()
+                {
+                    /*
+                     * Just obtain the file size and open the file
+                     * so it is ready for reading
+                     */
+
+                    const std::uint64_t fileSize = m_fileTask -> fileSize();
+                    const std::uint64_t bytesLeft = ( fileSize - m_filePos );
+
                     if( ! m_filePtr )
                     {
                         m_filePtr = os::fopen( m_fileTask -> entry().path(), "rb" );
                     }
 
-                    os::fread( m_filePtr, m_dataBlock -> pv(), bytesToRead );
+                    bool isScheduled = false;
+
+                    const std::size_t bytesToRead =
+                        m_chunker ? readContentDefinedChunk( bytesLeft ) : readFixedSizeChunk( bytesLeft, isScheduled );
+
+                    if( isScheduled )
+                    {
+                        return true;
+                    }
+
+                    processChunk( bytesToRead );
+
+                    return false;
+                }
+
+                void processChunk( SAA_in const std::size_t bytesToRead )
+                {
+                    const std::uint64_t fileSize = m_fileTask -> fileSize();
 
                     m_dataBlock -> setSize( bytesToRead );
 
@@ -280,15 +496,35 @@ namespace bl
                     BL_ASSERT( bytesToRead < std::numeric_limits< std::uint32_t >::max() );
                     chunk.size = ( std::uint32_t ) bytesToRead;
 
-                    cs::crc_32_type crcc;
-                    crcc.process_bytes( m_dataBlock -> pv(), bytesToRead );
+                    /*
+                     * The checksum and the hash are computed in a single pass over the block
+                     * and the checksum is CRC-32 as it is persisted in the metadata
+                     */
+
+                    cs::Crc32 crcc;
+                    hash::HashCalculatorDefault hashCalculator;
+
+                    cs::updateChecksumAndHash( crcc, hashCalculator, m_dataBlock -> pv(), bytesToRead );
+
                     chunk.checksum = crcc.checksum();
                     m_fileTask -> chunksChecksums()[ m_filePos ] = chunk.checksum;
 
-                    hash::HashCalculatorDefault hashCalculator;
-                    hashCalculator.update( m_dataBlock -> pv(), m_dataBlock -> size() );
                     hashCalculator.finalize();
-                    m_fileTask -> chunksHashes()[ m_filePos ] = hashCalculator.digestStr();
+
+                    auto digest = hashCalculator.digestStr();
+
+                    /*
+                     * The chunk hash is persisted in the metadata, so the receiver can find the
+                     * chunk which carries the data of a duplicate chunk (if deduplication is
+                     * enabled the data of duplicate chunks is not pushed out)
+                     */
+
+                    chunk.hash = bo::string::createInstance( digest.c_str() );
+
+                    m_isChunkDuplicate = m_dedupIndex && false == m_dedupIndex -> tryRegister( digest );
+                    chunk.isChunkDuplicate = m_isChunkDuplicate;
+
+                    m_fileTask -> chunksHashes()[ m_filePos ] = std::move( digest );
 
                     m_chunkId = m_fsmd -> createChunk( m_fileTask -> entryId(), std::move( chunk ) );
 
@@ -315,15 +551,15 @@ namespace bl
                     BL_TASKS_HANDLER_BEGIN()
 
                     /*
-                     * Simple tasks must complete in one shot
-                     * and then we notify the EQ we're done
+                     * Simple tasks must complete in one shot and then we notify the EQ we're
+                     * done unless the read was scheduled on the async file I/O service
                      */
 
                     BL_ASSERT( hasMoreBlocks() );
 
-                    if( false == isCanceled() )
+                    if( false == isCanceled() && doExecute() )
                     {
-                        doExecute();
+                        return;
                     }
 
                     BL_TASKS_HANDLER_END()
@@ -366,12 +602,18 @@ namespace bl
                     m_fileTask = om::copy( fileTask );
                     m_dataBlock = om::copy( dataBlock );
                     m_filePos = 0U;
+                    m_isChunkDuplicate = false;
                 }
 
                 const uuid_t& chunkId() const NOEXCEPT
                 {
                     return m_chunkId;
                 }
+
+                bool isChunkDuplicate() const NOEXCEPT
+                {
+                    return m_isChunkDuplicate;
+                }
             };
 
             typedef om::ObjectImpl< BlockReaderTaskT<> > BlockReaderTaskImpl;
@@ -398,6 +640,16 @@ namespace bl
          *
          * Because of the above reason our initial implementation will read the file
          * data and chunk it in memory before sending it over the socket.
+         *
+         * By default the files are split into chunks of the data block capacity, but the
+         * chunks can also be content-defined (see ContentDefinedChunker), so that the chunk
+         * boundaries (and hence the chunk hashes) of a file survive inserts and deletes
+         *
+         * When deduplication is enabled only the first chunk with a given hash is pushed out
+         * and the rest are marked as duplicates in the metadata (ChunkInfo::isChunkDuplicate
+         * with the same ChunkInfo::hash) - the unpackager writes their data from the chunk
+         * which was transferred. Note that the receiver must support duplicate chunks, which
+         * is why deduplication is not enabled by default
          */
 
         template
@@ -412,6 +664,12 @@ namespace bl
             typedef FilesPkgUnpkgBase< STREAM >                                             base_type;
             typedef typename base_type::context_t                                           context_t;
 
+            enum ChunkingMode
+            {
+                FixedSizeChunking,
+                ContentDefinedChunking,
+            };
+
         private:
 
             BL_DECLARE_OBJECT_IMPL( FilesPackagerUnitT )
@@ -420,18 +678,35 @@ namespace bl
 
             cpp::ScalarTypeIniter< std::uint64_t >                                          m_entriesTotalPushed;
             cpp::ScalarTypeIniter< std::uint64_t >                                          m_batchTotalPushed;
+            cpp::ScalarTypeIniter< std::uint64_t >                                          m_duplicateChunksTotal;
+            cpp::ScalarTypeIniter< std::uint64_t >                                          m_duplicateSizeTotal;
             const om::ObjPtr< data::FilesystemMetadataWO >                                  m_fsmd;
+            const ChunkingMode                                                              m_chunkingMode;
+            const om::ObjPtr< detail::ChunksDedupIndex >                                    m_dedupIndex;
 
             FilesPackagerUnitT(
                 SAA_in              const om::ObjPtr< context_t >&                          context,
-                SAA_in              const om::ObjPtr< data::FilesystemMetadataWO >&         fsmd
+                SAA_in              const om::ObjPtr< data::FilesystemMetadataWO >&         fsmd,
+                SAA_in_opt          const ChunkingMode                                      chunkingMode = FixedSizeChunking,
+                SAA_in_opt          const bool                                              deduplicateChunks = false
                 )
                 :
                 base_type( context, "success:Files_Packager" /* taskName */ ),
-                m_fsmd( om::copy( fsmd ) )
+                m_fsmd( om::copy( fsmd ) ),
+                m_chunkingMode( chunkingMode ),
+                m_dedupIndex( deduplicateChunks ? detail::ChunksDedupIndex::createInstance() : nullptr )
             {
             }
 
+            void updateFileTotals( SAA_in const om::ObjPtr< detail::BlockReaderTaskImpl >& packager )
+            {
+                if( ! packager -> hasMoreBlocks() )
+                {
+                    base_type::m_fileSizeTotal += packager -> fileTask() -> fileSize();
+                    ++base_type::m_filesTotal;
+                }
+            }
+
             virtual auto processTopReadyTask( SAA_in const om::ObjPtr< tasks::Task >& topReady ) -> typename base_type::ProcessTaskResult OVERRIDE
             {
                 /*
@@ -451,7 +726,25 @@ namespace bl
 
                 const auto& block = packager -> dataBlock();
 
-                if( block )
+                if( block && packager -> isChunkDuplicate() )
+                {
+                    /*
+                     * The data of this chunk is transferred with another chunk with the same
+                     * hash, so we don't push it out and the block is reused for reading the
+                     * next chunk (or returned to the pool if this was the last chunk)
+                     */
+
+                    ++m_duplicateChunksTotal;
+                    m_duplicateSizeTotal += block -> size();
+
+                    updateFileTotals( packager );
+
+                    if( ! packager -> hasMoreBlocks() )
+                    {
+                        base_type::m_context -> dataBlocksPool() -> put( packager -> detachDataBlock() );
+                    }
+                }
+                else if( block )
                 {
                     data::DataChunkBlock chunkInfo;
 
@@ -479,11 +772,7 @@ namespace bl
 
                     base_type::m_dataSizeTotal += block -> size();
 
-                    if( ! packager -> hasMoreBlocks() )
-                    {
-                        base_type::m_fileSizeTotal += packager -> fileTask() -> fileSize();
-                        ++base_type::m_filesTotal;
-                    }
+                    updateFileTotals( packager );
 
                     packager -> detachDataBlock();
                 }
@@ -495,7 +784,10 @@ namespace bl
                      * and continue searching for a ready packager task
                      */
 
-                    packager -> attachDataBlockOnly( data::DataBlock::get( base_type::m_context -> dataBlocksPool() ) );
+                    if( ! packager -> dataBlock() )
+                    {
+                        packager -> attachDataBlockOnly( data::DataBlock::get( base_type::m_context -> dataBlocksPool() ) );
+                    }
 
                     base_type::m_eqWorkerTasks -> push_back( topReady );
 
@@ -514,7 +806,7 @@ namespace bl
                 const auto& chunksChecksums = packager -> fileTask() -> chunksChecksums();
                 if( chunksChecksums.size() )
                 {
-                    cs::crc_32_type crcc;
+                    cs::Crc32 crcc;
 
                     for( const auto& pair : chunksChecksums )
                     {
@@ -560,6 +852,10 @@ namespace bl
                         << m_entriesTotalPushed
                         << "\n    batchTotalPushed: "
                         << m_batchTotalPushed
+                        << "\n    duplicateChunksTotal: "
+                        << m_duplicateChunksTotal
+                        << "\n    duplicateSizeTotal: "
+                        << m_duplicateSizeTotal
                     );
             }
 
@@ -589,7 +885,12 @@ namespace bl
 
                 if( base_type::m_eqWorkerTasks -> size() < base_type::m_tasksPoolSize )
                 {
-                    packager = detail::BlockReaderTaskImpl::createInstance( m_fsmd );
+                    packager = detail::BlockReaderTaskImpl::createInstance(
+                        m_fsmd,
+                        ContentDefinedChunking == m_chunkingMode /* contentDefinedChunking */,
+                        m_dedupIndex,
+                        base_type::m_context -> fileIoService()
+                        );
                 }
                 else
                 {
@@ -625,13 +926,19 @@ namespace bl
 
                 ++m_batchTotalPushed;
 
-                for( const auto& entry : scanner -> entries() )
+                const auto& entries = scanner -> entries();
+                const auto& entriesStats = scanner -> entriesStats();
+
+                BL_ASSERT( entries.size() == entriesStats.size() );
+
+                for( std::size_t i = 0U, count = entries.size(); i < count; ++i )
                 {
                     base_type::m_eqChildTasks -> push_back(
                         detail::FileTaskImpl::createInstance< tasks::Task >(
                             m_fsmd,
                             scanner,
-                            entry
+                            entries[ i ],
+                            entriesStats[ i ]
                             )
                         );
 
@@ -24,7 +24,10 @@
 #include <baselib/core/Checksum.h>
 #include <baselib/core/FsUtils.h>
 
+#include <deque>
 #include <map>
+#include <unordered_map>
+#include <vector>
 
 namespace bl
 {
@@ -32,6 +35,10 @@ namespace bl
     {
         /**
          * @brief class FilesUnpackagerUnit - the unpackager processing unit
+         *
+         * The data of duplicate chunks (see FilesPackagerUnit) is not received, but it is
+         * copied from the chunk with the same hash when that chunk arrives and then the
+         * duplicate chunks are written as if they had arrived
          */
 
         template
@@ -87,6 +94,7 @@ namespace bl
 
                 os::mutex                                                                   lock;
                 os::stdio_file_ptr                                                          filePtr;
+                cpp::ScalarTypeIniter< std::size_t >                                        writesPending;
                 cpp::ScalarTypeIniter< bool >                                               canceled;
                 std::map< std::uint64_t, ChunkInfo >                                        chunksWritten;
             };
@@ -442,6 +450,7 @@ namespace bl
 
             protected:
 
+                typedef IoOperationTaskT< E2 >                                              this_type;
                 typedef tasks::SimpleTaskBase                                               base_type;
 
                 const om::ObjPtr< data::FilesystemMetadataRO >                              m_fsmd;
@@ -451,6 +460,7 @@ namespace bl
                 ChunkInfo                                                                   m_chunkInfo;
                 data::DataChunkBlock                                                        m_chunkData;
                 cpp::ScalarTypeIniter< bool >                                               m_entryFinalized;
+                cpp::ScalarTypeIniter< bool >                                               m_writeScheduled;
 
                 IoOperationTaskT(
                     SAA_in          const om::ObjPtr< data::FilesystemMetadataRO >&         fsmd,
@@ -463,6 +473,11 @@ namespace bl
                     m_name = "FilesUnpackagerUnit_IoOperationTask";
                 }
 
+                static const char* openMode() NOEXCEPT
+                {
+                    return "wb";
+                }
+
                 fs::path getFullPath() const
                 {
                     return m_unpackager.m_targetTmpDir / m_entry -> info.relPath -> value();
@@ -506,7 +521,7 @@ namespace bl
 
                     const ChunkInfo* prev = nullptr;
 
-                    cs::crc_32_type crcc;
+                    cs::Crc32 crcc;
                     for( const auto& pair : m_entry -> chunksWritten )
                     {
                         const auto& chunkInfo = pair.second;
@@ -553,112 +568,214 @@ namespace bl
                     chkChunk( ( prev -> pos + prev -> size ) == m_entry -> info.size );
                 }
 
-                void handleFileInternal(
-                    SAA_in          const fs::path&                                         fullPath,
-                    SAA_in          const char*                                             openMode
-                    )
+                void openFileNoLock( SAA_in const fs::path& fullPath )
                 {
-                    if( ! m_entry -> filePtr )
+                    if( m_entry -> filePtr )
                     {
-                        m_entry -> filePtr = os::fopen( fullPath, openMode );
+                        return;
                     }
 
-                    if( ! m_entry -> chunksExpected )
+                    m_entry -> filePtr = os::fopen( fullPath, openMode() );
+
+                    if( m_entry -> chunksExpected > 1 )
                     {
                         /*
-                         * This is a zero length file; finalize immediately
+                         * The chunks of a large file are written concurrently at their offsets,
+                         * so we reserve the space for the entire file upfront, which avoids
+                         * fragmentation and also fails early if there is not enough space
                          */
 
-                        finalizeFile( fullPath );
+                        os::fpreallocate( m_entry -> filePtr, m_entry -> info.size );
+                    }
+                }
 
+                void verifyChunkChecksum()
+                {
+                    if( ! m_entry -> info.isChecksumSet )
+                    {
                         return;
                     }
 
-                    if( m_entry -> info.isChecksumSet )
-                    {
-                        cs::crc_32_type crcc;
+                    cs::Crc32 crcc;
 
-                        crcc.process_bytes( m_chunkData.data -> pv(), m_chunkInfo.size );
+                    crcc.process_bytes( m_chunkData.data -> pv(), m_chunkInfo.size );
 
-                        if( m_chunkInfo.checksum != crcc.checksum() )
-                        {
-                            BL_THROW(
-                                UnexpectedException(),
-                                BL_MSG()
-                                    << "Integrity check failed. Invalid chunk checksum, expected: "
-                                    << m_chunkInfo.checksum
-                                    << " computed: "
-                                    << crcc.checksum()
-                                    << " for file "
-                                    << m_entry -> info.relPath -> value()
-                                );
-                        }
+                    if( m_chunkInfo.checksum != crcc.checksum() )
+                    {
+                        BL_THROW(
+                            UnexpectedException(),
+                            BL_MSG()
+                                << "Integrity check failed. Invalid chunk checksum, expected: "
+                                << m_chunkInfo.checksum
+                                << " computed: "
+                                << crcc.checksum()
+                                << " for file "
+                                << m_entry -> info.relPath -> value()
+                            );
                     }
+                }
 
+                void writeChunk()
+                {
                     BL_ASSERT( m_entry -> filePtr );
 
-                    os::fseek( m_entry -> filePtr, m_chunkInfo.pos, SEEK_SET );
+                    /*
+                     * The chunk is written at its offset with a positional write (i.e. without
+                     * seeking and without going through the stdio buffer), so the chunks of the
+                     * same file can be written concurrently
+                     */
 
-                    os::fwrite( m_entry -> filePtr, m_chunkData.data -> pv(), m_chunkInfo.size );
+                    os::fpwrite( m_entry -> filePtr, m_chunkInfo.pos, m_chunkData.data -> pv(), m_chunkInfo.size );
+                }
 
-                    if( 1 == m_entry -> chunksExpected )
-                    {
-                        /*
-                         * This is the one and only chunk for this file
-                         *
-                         * Finalize the entry and return
-                         */
+                /**
+                 * @brief Writes the chunk or schedules the write on the async file I/O service
+                 * (if one is configured) and returns true if the write was scheduled, in which
+                 * case the task will complete in onWriteCompleted
+                 */
 
-                        chkChunk( ( m_chunkInfo.pos + m_chunkInfo.size ) == m_entry -> info.size );
+                bool writeChunkOrSchedule( SAA_in const fs::path& fullPath )
+                {
+                    const auto& fileIoService = m_unpackager.m_context -> fileIoService();
 
-                        finalizeFile( fullPath );
+                    if( ! fileIoService )
+                    {
+                        writeChunk();
 
-                        return;
+                        return false;
                     }
 
-                    if( m_entryFinalized )
-                    {
-                        return;
-                    }
+                    BL_ASSERT( m_entry -> filePtr );
 
                     /*
-                     * If we're here we need to update the chunks bookkeeping info
-                     * and check if this is the last chunk to mark the entry as
-                     * finalized
-                     *
-                     * Note that since we're holding the entry lock only the last
-                     * task will win in the check below and close the file and
-                     * only this task will have m_entryFinalized=true
+                     * The flag is set before the write is submitted (under the task lock) since the
+                     * completion can run on the reaper thread as soon as it is submitted and it is
+                     * cleared if the write has completed synchronously; the callers must rely on
+                     * the returned value rather than on the flag to decide if the task completes
+                     * now
                      */
 
-                    m_entry -> chunksWritten[ m_chunkInfo.pos ] = m_chunkInfo;
+                    m_writeScheduled = true;
+
+                    auto guard = BL_SCOPE_GUARD( { m_writeScheduled = false; } );
+
+                    const bool isScheduled = fileIoService -> asyncWrite(
+                        m_entry -> filePtr,
+                        m_chunkInfo.pos,
+                        m_chunkData.data -> pv(),
+                        m_chunkInfo.size,
+                        cpp::bind(
+                            &this_type::onWriteCompleted,
+                            om::ObjPtrCopyable< this_type >::acquireRef( this ),
+                            fullPath,
+                            _1
+                            )
+                        );
 
-                    if( m_entry -> chunksWritten.size() == m_entry -> chunksExpected )
+                    if( isScheduled )
+                    {
+                        guard.dismiss();
+                    }
+
+                    return isScheduled;
+                }
+
+                void onWriteCompleted(
+                    SAA_in          const fs::path&                                         fullPath,
+                    SAA_in_opt      const std::exception_ptr&                               eptr
+                    ) NOEXCEPT
+                {
+                    BL_TASKS_HANDLER_BEGIN()
+
+                    BL_ASSERT( m_writeScheduled );
+
+                    m_writeScheduled = false;
+
+                    handleFileAndEnhanceException(
+                        fullPath,
+                        [ & ]() -> void
+                        {
+                            if( m_entry -> chunksExpected > 1 )
+                            {
+                                if( eptr )
+                                {
+                                    BL_MUTEX_GUARD( m_entry -> lock );
+
+                                    endWriteNoLock();
+
+                                    cpp::safeRethrowException( eptr );
+                                }
+
+                                completeChunkWrite( fullPath );
+                            }
+                            else
+                            {
+                                if( eptr )
+                                {
+                                    cpp::safeRethrowException( eptr );
+                                }
+
+                                completeFileWrite( fullPath );
+                            }
+                        }
+                        );
+
+                    BL_TASKS_HANDLER_END()
+                }
+
+                void endWriteNoLock() NOEXCEPT
+                {
+                    BL_ASSERT( m_entry -> writesPending );
+
+                    --m_entry -> writesPending;
+
+                    if( m_entry -> canceled && ! m_entry -> writesPending )
                     {
                         /*
-                         * This is expected to be the last chunk
-                         *
-                         * Verify all chunks have arrived and that file checksum
-                         * is correct before we mark the entry for finalization
+                         * The entry was canceled while the chunk was being written, so the
+                         * last writer is responsible to close the file handle
                          */
 
-                        verifyChecksumAndAllChunksPresent();
-
-                        finalizeFile( fullPath );
+                        closeFailedFileNoLock();
                     }
                 }
 
-                void verifyEntryOnlyTask()
+                void closeFailedFileNoLock() NOEXCEPT
                 {
-                    BL_ASSERT( m_entry );
-                    BL_ASSERT( ! m_entry -> chunksExpected );
+                    if( ! m_entry -> filePtr )
+                    {
+                        return;
+                    }
 
-                    BL_ASSERT( 0U == m_chunkInfo.size && 0U == m_chunkInfo.pos );
-                    BL_ASSERT( uuids::nil() == m_chunkData.chunkId );
-                    BL_ASSERT( ! m_chunkData.data );
+                    m_entry -> filePtr.reset();
+
+                    if( m_entry -> chunksExpected > 1 )
+                    {
+                        /*
+                         * The file was preallocated with its full size (see openFileNoLock), so
+                         * we truncate it to not leave behind a full size file with partial
+                         * content when the unpack has failed or has been canceled
+                         */
+
+                        eh::error_code ec;
+
+                        fs::resize_file( getFullPath(), 0U, ec );
+
+                        if( ec )
+                        {
+                            BL_LOG(
+                                Logging::debug(),
+                                BL_MSG()
+                                    << "Cannot truncate file "
+                                    << getFullPath()
+                                    << " after the unpack has failed; error: "
+                                    << ec.message()
+                                );
+                        }
+                    }
                 }
 
-                void handleFileNoLock( SAA_in const fs::path& fullPath )
+                void chkNotCanceledNoLock()
                 {
                     if( m_entry -> canceled )
                     {
@@ -681,11 +798,16 @@ namespace bl
                                 << "This entry has been canceled already"
                             );
                     }
+                }
+
+                void prepareFileNoLock( SAA_in const fs::path& fullPath )
+                {
+                    chkNotCanceledNoLock();
 
                     /*
                      * Check if the file is to be created and ensure it doesn't exist already
                      * and also ensure the parent directory is created before we attempt
-                     * to open the file for writing (in handleFileInternal call below)
+                     * to open the file for writing
                      */
 
                     if( ! m_entry -> filePtr )
@@ -702,31 +824,202 @@ namespace bl
                         fs::safeMkdirs( fullPath.parent_path() );
                     }
 
+                    openFileNoLock( fullPath );
+                }
+
+                bool handleFileInternal( SAA_in const fs::path& fullPath )
+                {
+                    prepareFileNoLock( fullPath );
+
+                    if( ! m_entry -> chunksExpected )
+                    {
+                        /*
+                         * This is a zero length file; finalize immediately
+                         */
+
+                        finalizeFile( fullPath );
+
+                        return false;
+                    }
+
+                    /*
+                     * This is the one and only chunk for this file
+                     *
+                     * Write it, finalize the entry and return
+                     */
+
+                    BL_ASSERT( 1 == m_entry -> chunksExpected );
+
+                    verifyChunkChecksum();
+
+                    if( writeChunkOrSchedule( fullPath ) )
+                    {
+                        return true;
+                    }
+
+                    completeFileWrite( fullPath );
+
+                    return false;
+                }
+
+                void completeFileWrite( SAA_in const fs::path& fullPath )
+                {
+                    chkChunk( ( m_chunkInfo.pos + m_chunkInfo.size ) == m_entry -> info.size );
+
+                    finalizeFile( fullPath );
+                }
+
+                bool handleFileChunkInternal( SAA_in const fs::path& fullPath )
+                {
+                    /*
+                     * The entry lock is only held while the file is opened and while the chunks
+                     * bookkeeping info is updated, but not while the chunk checksum is verified
+                     * and while the chunk is written, so the chunks of the same file are written
+                     * concurrently
+                     *
+                     * The file handle can't be closed while there are writes pending (see
+                     * endWriteNoLock and onTaskStoppedNothrow)
+                     */
+
+                    verifyChunkChecksum();
+
+                    {
+                        BL_MUTEX_GUARD( m_entry -> lock );
+
+                        prepareFileNoLock( fullPath );
+
+                        ++m_entry -> writesPending;
+                    }
+
+                    try
+                    {
+                        if( writeChunkOrSchedule( fullPath ) )
+                        {
+                            return true;
+                        }
+                    }
+                    catch( std::exception& )
+                    {
+                        BL_MUTEX_GUARD( m_entry -> lock );
+
+                        endWriteNoLock();
+
+                        throw;
+                    }
+
+                    completeChunkWrite( fullPath );
+
+                    return false;
+                }
+
+                void completeChunkWrite( SAA_in const fs::path& fullPath )
+                {
+                    BL_MUTEX_GUARD( m_entry -> lock );
+
+                    endWriteNoLock();
+
+                    chkNotCanceledNoLock();
+
+                    if( m_entryFinalized )
+                    {
+                        return;
+                    }
+
+                    /*
+                     * If we're here we need to update the chunks bookkeeping info
+                     * and check if this is the last chunk to mark the entry as
+                     * finalized
+                     *
+                     * Note that since we're holding the entry lock only the last
+                     * task will win in the check below and close the file and
+                     * only this task will have m_entryFinalized=true
+                     *
+                     * Also note that when all chunks are accounted for all writes
+                     * have completed (since the bookkeeping is done after the write)
+                     */
+
+                    m_entry -> chunksWritten[ m_chunkInfo.pos ] = m_chunkInfo;
+
+                    if( m_entry -> chunksWritten.size() == m_entry -> chunksExpected )
+                    {
+                        /*
+                         * This is expected to be the last chunk
+                         *
+                         * Verify all chunks have arrived and that file checksum
+                         * is correct before we mark the entry for finalization
+                         */
+
+                        verifyChecksumAndAllChunksPresent();
+
+                        finalizeFile( fullPath );
+                    }
+                }
+
+                void verifyEntryOnlyTask()
+                {
+                    BL_ASSERT( m_entry );
+                    BL_ASSERT( ! m_entry -> chunksExpected );
+
+                    BL_ASSERT( 0U == m_chunkInfo.size && 0U == m_chunkInfo.pos );
+                    BL_ASSERT( uuids::nil() == m_chunkData.chunkId );
+                    BL_ASSERT( ! m_chunkData.data );
+                }
+
+                template
+                <
+                    typename Callback
+                >
+                void handleFileAndEnhanceException(
+                    SAA_in          const fs::path&                                         fullPath,
+                    SAA_in          const Callback&                                         callback
+                    )
+                {
                     /*
                      * Catch all exceptions and rethrow after enhancing the exception
                      * with the file name and open mode info
                      */
 
-                    const auto openMode = "wb";
-
                     try
                     {
-                        handleFileInternal( fullPath, openMode );
+                        callback();
                     }
                     catch( BaseException& e )
                     {
                         e   << eh::errinfo_file_name( fullPath.string() )
-                            << eh::errinfo_file_open_mode( openMode );
+                            << eh::errinfo_file_open_mode( openMode() );
 
                         throw;
                     }
                 }
 
-                void handleFileWithLock( SAA_in const fs::path& fullPath )
+                bool handleFileNoLock( SAA_in const fs::path& fullPath )
                 {
-                    BL_MUTEX_GUARD( m_entry -> lock );
+                    bool isScheduled = false;
 
-                    handleFileNoLock( fullPath );
+                    handleFileAndEnhanceException(
+                        fullPath,
+                        [ & ]() -> void
+                        {
+                            isScheduled = handleFileInternal( fullPath );
+                        }
+                        );
+
+                    return isScheduled;
+                }
+
+                bool handleFileChunk( SAA_in const fs::path& fullPath )
+                {
+                    bool isScheduled = false;
+
+                    handleFileAndEnhanceException(
+                        fullPath,
+                        [ & ]() -> void
+                        {
+                            isScheduled = handleFileChunkInternal( fullPath );
+                        }
+                        );
+
+                    return isScheduled;
                 }
 
                 bool verifySymlinkIsSupported( SAA_in const fs::path& fullPath )
@@ -801,7 +1094,12 @@ namespace bl
                     return false;
                 }
 
-                void doExecute()
+                /**
+                 * @brief Handles the entry and returns true if the chunk write was scheduled on
+                 * the async file I/O service (in which case the task completes in onWriteCompleted)
+                 */
+
+                bool doExecute()
                 {
                     BL_ASSERT( m_entry );
 
@@ -828,16 +1126,10 @@ namespace bl
 
                         case File:
                             {
-                                if( m_entry -> chunksExpected > 1 )
-                                {
-                                    handleFileWithLock( fullPath );
-                                }
-                                else
-                                {
+                                return m_entry -> chunksExpected > 1 ?
+                                    handleFileChunk( fullPath ) :
                                     handleFileNoLock( fullPath );
-                                }
                             }
-                            break;
 
                         case Directory:
                             {
@@ -898,6 +1190,8 @@ namespace bl
                             }
                             break;
                     }
+
+                    return false;
                 }
 
                 virtual auto onTaskStoppedNothrow( SAA_in_opt const std::exception_ptr& eptrIn ) NOEXCEPT
@@ -920,7 +1214,16 @@ namespace bl
 
                     if( eptrIn || isFailedOrFailing() || isCanceled() )
                     {
-                        m_entry -> filePtr.reset();
+                        /*
+                         * If there are chunks of the file still being written by other tasks then
+                         * the last one of them will close the file handle (see endWriteNoLock)
+                         */
+
+                        if( ! m_entry -> writesPending )
+                        {
+                            closeFailedFileNoLock();
+                        }
+
                         m_entry -> canceled = true;
                     }
 
@@ -934,13 +1237,14 @@ namespace bl
                     BL_TASKS_HANDLER_BEGIN()
 
                     /*
-                     * Simple tasks must complete in one shot
-                     * and then we notify the EQ we're done
+                     * Simple tasks must complete in one shot and then we notify the EQ we're
+                     * done unless the chunk write was scheduled on the async file I/O service
+                     * in which case we complete when the write completes (see onWriteCompleted)
                      */
 
-                    if( false == isCanceled() )
+                    if( false == isCanceled() && doExecute() )
                     {
-                        doExecute();
+                        return;
                     }
 
                     BL_TASKS_HANDLER_END()
@@ -993,6 +1297,12 @@ namespace bl
 
             typedef om::ObjectImpl< IoOperationTaskT<> >                                    io_operation_t;
 
+            struct PendingDuplicates
+            {
+                om::ObjPtrCopyable< data::DataBlock >                                       data;
+                std::vector< uuid_t >                                                       chunkIds;
+            };
+
             const SymlinkUnsupportedAction                                                  m_symlinksUnsupportedAction;
             const om::ObjPtr< data::FilesystemMetadataRO >                                  m_fsmd;
             fs::path                                                                        m_targetTmpDir;
@@ -1002,6 +1312,10 @@ namespace bl
             std::unordered_map< uuid_t, om::ObjPtr< entry_obj_t > >                         m_entriesInProgress;
             std::unordered_set< uuid_t >                                                    m_entriesCompleted;
 
+            std::unordered_map< std::string, std::vector< uuid_t > >                        m_duplicateChunks;
+            cpp::ScalarTypeIniter< bool >                                                   m_duplicateChunksLoaded;
+            std::deque< PendingDuplicates >                                                 m_duplicatesPending;
+
             FilesUnpackagerUnitT(
                 SAA_in              const SymlinkUnsupportedAction                          symlinksUnsupportedAction,
                 SAA_in              const om::ObjPtr< SendRecvContextImpl< STREAM > >&      context,
@@ -1055,6 +1369,7 @@ namespace bl
             {
                 return (
                     base_type::m_inputDisconnected &&
+                    m_duplicatesPending.empty() &&
                     base_type::m_eqWorkerTasks -> size() == base_type::m_eqWorkerTasks -> getQueueSize( tasks::ExecutionQueue::Ready )
                     );
             }
@@ -1114,6 +1429,96 @@ namespace bl
                 return true;
             }
 
+            /**
+             * @brief Loads the duplicate chunks from the metadata (grouped by hash)
+             */
+
+            void chk2LoadDuplicateChunks()
+            {
+                if( m_duplicateChunksLoaded )
+                {
+                    return;
+                }
+
+                const auto chunksIterator = m_fsmd -> queryAllChunks();
+
+                while( chunksIterator -> hasCurrent() )
+                {
+                    const auto chunkId = chunksIterator -> current();
+
+                    const auto chunkInfo = m_fsmd -> loadChunkInfo( chunkId );
+
+                    if( chunkInfo.isChunkDuplicate )
+                    {
+                        BL_CHK(
+                            false,
+                            nullptr != chunkInfo.hash,
+                            BL_MSG()
+                                << "Duplicate chunk '"
+                                << uuids::uuid2string( chunkId )
+                                << "' does not have a hash"
+                            );
+
+                        m_duplicateChunks[ chunkInfo.hash -> value() ].push_back( chunkId );
+                    }
+
+                    chunksIterator -> loadNext();
+                }
+
+                m_duplicateChunksLoaded = true;
+            }
+
+            /**
+             * @brief Schedules the duplicate chunks whose data has arrived already; returns
+             * false if not all of them could be scheduled
+             */
+
+            bool chk2ScheduleDuplicateChunks()
+            {
+                while( ! m_duplicatesPending.empty() )
+                {
+                    om::ObjPtr< io_operation_t > unpackager;
+
+                    const auto topReady = getTopReady( unpackager );
+
+                    if( ! topReady )
+                    {
+                        return false;
+                    }
+
+                    BL_ASSERT( unpackager );
+
+                    auto& pending = m_duplicatesPending.front();
+
+                    BL_ASSERT( pending.data && ! pending.chunkIds.empty() );
+
+                    data::DataChunkBlock chunkData;
+
+                    chunkData.chunkId = pending.chunkIds.back();
+
+                    if( 1U == pending.chunkIds.size() )
+                    {
+                        /*
+                         * This is the last duplicate of this data, so it can take the copy
+                         */
+
+                        chunkData.data = std::move( pending.data );
+
+                        m_duplicatesPending.pop_front();
+                    }
+                    else
+                    {
+                        chunkData.data = data::DataBlock::copy( pending.data, base_type::m_context -> dataBlocksPool() );
+
+                        pending.chunkIds.pop_back();
+                    }
+
+                    scheduleChunk( topReady, unpackager, std::move( chunkData ) );
+                }
+
+                return true;
+            }
+
             /**
              * @brief Handle incoming chunk data block
              */
@@ -1122,6 +1527,16 @@ namespace bl
             {
                 BL_MUTEX_GUARD( base_type::m_lock );
 
+                /*
+                 * The pending duplicate chunks are scheduled first, so the number of data
+                 * blocks they hold stays bounded
+                 */
+
+                if( ! chk2ScheduleDuplicateChunks() )
+                {
+                    return false;
+                }
+
                 om::ObjPtr< io_operation_t > unpackager;
 
                 const auto topReady = getTopReady( unpackager );
@@ -1133,6 +1548,46 @@ namespace bl
 
                 BL_ASSERT( unpackager );
 
+                chk2LoadDuplicateChunks();
+
+                if( ! m_duplicateChunks.empty() )
+                {
+                    const auto chunkInfo = m_fsmd -> loadChunkInfo( info.chunkId );
+
+                    const auto pos = chunkInfo.hash ?
+                        m_duplicateChunks.find( chunkInfo.hash -> value() ) : m_duplicateChunks.end();
+
+                    if( pos != m_duplicateChunks.end() )
+                    {
+                        /*
+                         * The data of this chunk is also the data of some duplicate chunks; we
+                         * keep a copy of it to write them once there are available worker tasks
+                         */
+
+                        PendingDuplicates pending;
+
+                        pending.data = data::DataBlock::copy( info.data, base_type::m_context -> dataBlocksPool() );
+                        pending.chunkIds.swap( pos -> second );
+
+                        m_duplicateChunks.erase( pos );
+
+                        m_duplicatesPending.push_back( std::move( pending ) );
+                    }
+                }
+
+                scheduleChunk( topReady, unpackager, BL_PARAM_FWD( info ) );
+
+                chk2ScheduleDuplicateChunks();
+
+                return true;
+            }
+
+            void scheduleChunk(
+                SAA_in              const om::ObjPtr< tasks::Task >&                        topReady,
+                SAA_in              const om::ObjPtr< io_operation_t >&                     unpackager,
+                SAA_in              data::DataChunkBlock&&                                  info
+                )
+            {
                 const auto entryId = m_fsmd -> queryEntryId( info.chunkId );
 
                 /*
@@ -1197,8 +1652,6 @@ namespace bl
                     );
 
                 base_type::m_eqWorkerTasks -> push_back( topReady );
-
-                return true;
             }
 
             virtual auto processTopReadyTask( SAA_in const om::ObjPtr< tasks::Task >& topReady ) -> typename base_type::ProcessTaskResult OVERRIDE
@@ -1322,11 +1775,14 @@ namespace bl
                 }
 
                 /*
-                 * First we try to process the current queue as much as
-                 * possible and if the queue isn't fully processed we
-                 * will continue re-scheduling
+                 * First we try to schedule the pending duplicate chunks (they
+                 * may be left after the last chunk has arrived) and then to
+                 * process the current queue as much as possible and if the
+                 * queue isn't fully processed we will continue re-scheduling
                  */
 
+                chk2ScheduleDuplicateChunks();
+
                 auto& queue = m_scheduler -> entriesQueue();
 
                 while( ! queue.empty() )
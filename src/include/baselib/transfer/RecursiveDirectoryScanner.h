@@ -49,9 +49,16 @@ namespace bl
             om::ObjPtr< tasks::ScanDirectoryTaskImpl >                                      m_seed;
             om::ObjPtrCopyable< tasks::Task >                                               m_current;
 
+            /*
+             * The default stat mode is to stat all entries while scanning since the consumers
+             * (e.g. the files packager) need the permissions, the sizes and the last write times
+             * and this way they are obtained in parallel with a single fstatat call per entry
+             */
+
             RecursiveDirectoryScannerT(
                 SAA_in              const fs::path&                                         root,
-                SAA_in_opt          const om::ObjPtr< DirectoryScannerControlToken >&       cbControl = nullptr
+                SAA_in_opt          const om::ObjPtr< DirectoryScannerControlToken >&       cbControl = nullptr,
+                SAA_in_opt          const os::DirectoryStatMode                             statMode = os::DirectoryStatAll
                 )
             {
                 const auto boxedRootPath = bo::path::createInstance();
@@ -60,7 +67,8 @@ namespace bl
                 m_seed = tasks::ScanDirectoryTaskImpl::createInstance(
                         root,
                         boxedRootPath,
-                        cbControl
+                        cbControl,
+                        statMode
                         );
 
                 m_name = "success:Directory_Scanner";
@@ -21,6 +21,7 @@
 
 #include <baselib/tasks/TcpBaseTasks.h>
 #include <baselib/tasks/TcpSslBaseTasks.h>
+#include <baselib/tasks/utils/AsyncFileIoService.h>
 
 #include <baselib/core/Pool.h>
 #include <baselib/core/ObjModel.h>
@@ -76,6 +77,7 @@ namespace bl
             long                                                    m_maxIdleTimeoutInSeconds;
             std::string                                             m_authenticationToken;
             om::ObjPtr< data::DataBlock >                           m_authenticationDataBlock;
+            om::ObjPtr< tasks::AsyncFileIoService >                 m_fileIoService;
             os::mutex                                               m_lock;
 
         protected:
@@ -129,6 +131,23 @@ namespace bl
                 return m_dataBlocksPool;
             }
 
+            /**
+             * @brief The optional service which is used by the files packager and unpackager to
+             * read and write the chunks asynchronously (if not set the file I/O is synchronous)
+             *
+             * It should be set before the transfer starts and the owner is responsible to dispose it
+             */
+
+            auto fileIoService() const NOEXCEPT -> const om::ObjPtr< tasks::AsyncFileIoService >&
+            {
+                return m_fileIoService;
+            }
+
+            void fileIoService( SAA_in_opt om::ObjPtr< tasks::AsyncFileIoService >&& fileIoService ) NOEXCEPT
+            {
+                m_fileIoService = BL_PARAM_FWD( fileIoService );
+            }
+
             long maxIdleTimeoutInSeconds() const NOEXCEPT
             {
                 return m_maxIdleTimeoutInSeconds;
@@ -213,10 +213,17 @@ namespace bltool
                             const auto boxedRootPath = bo::path::createInstance();
                             boxedRootPath -> swapValue( cpp::copy( rootDir ) );
 
+                            /*
+                             * The scanner tasks obtain the file sizes in parallel while
+                             * scanning (with fstatat relative to the directory fd) and here
+                             * we only aggregate them as the scanner tasks complete
+                             */
+
                             const auto scanner = ScanDirectoryTaskImpl::createInstance(
                                 rootDir,
                                 boxedRootPath,
-                                om::qi< DirectoryScannerControlToken >( controlToken )
+                                om::qi< DirectoryScannerControlToken >( controlToken ),
+                                os::DirectoryStatRegularFiles
                                 );
 
                             const auto scannerTask = om::qi< Task >( scanner );
@@ -242,13 +249,30 @@ namespace bltool
 
                             const auto scanner = om::qi< ScanDirectoryTaskImpl >( scannerTask );
 
-                            for( const auto& entry : scanner -> entries() )
+                            const auto& entries = scanner -> entries();
+                            const auto& entriesStats = scanner -> entriesStats();
+
+                            /*
+                             * All entries of a scanner task are in the same directory, so
+                             * unless this is the root directory (where each entry is its own
+                             * prefix) the path prefix only needs to be looked up once per task
+                             */
+
+                            const bool isRootDirectory =
+                                ! entries.empty() && entries.front().path().parent_path() == rootDir;
+
+                            auto pos = map.end();
+
+                            for( std::size_t index = 0U, count = entries.size(); index < count; ++index )
                             {
                                 ++entriesCount;
 
+                                const auto& entry = entries[ index ];
+                                const auto& entryStat = entriesStats[ index ];
+
                                 const auto status = entry.symlink_status();
 
-                                if( fs::is_regular_file( status ) )
+                                if( fs::is_regular_file( status ) && ( isRootDirectory || pos == map.end() ) )
                                 {
                                     const auto& entryPath = entry.path();
 
@@ -278,7 +302,7 @@ namespace bltool
                                         }
                                     }
 
-                                    const auto pos = map.find( pathPrefix );
+                                    pos = map.find( pathPrefix );
 
                                     BL_CHK(
                                         false,
@@ -287,6 +311,23 @@ namespace bltool
                                             << "Cannot find the following path prefix "
                                             << pathPrefix
                                         );
+                                }
+
+                                if( fs::is_regular_file( status ) )
+                                {
+                                    if( entryStat.isKnown )
+                                    {
+                                        pos -> second += entryStat.size;
+
+                                        continue;
+                                    }
+
+                                    /*
+                                     * The stat call in the scanner has failed, so we retry it
+                                     * here to check if the error can be ignored
+                                     */
+
+                                    const auto& entryPath = entry.path();
 
                                     const auto size = fs::file_size( entryPath, ec );
 
@@ -0,0 +1,30 @@
+/*
+ * This file is part of the swblocks-baselib library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define UTF_TEST_MODULE bench_baselib
+
+/*
+ * The benchmark args parser needs to be declared before UtfMain.h is included
+ * as it replaces the default UTF args parser (see DefaultUtfConfigT)
+ */
+
+#define UTF_TEST_APP_INIT_UTF_ARGS_PARSER test::BenchArgsParser
+#include <utests/baselib/BenchUtils.h>
+
+#include <utests/baselib/UtfMain.h>
+
+#include "BenchCore.h"
+#include "BenchMessaging.h"
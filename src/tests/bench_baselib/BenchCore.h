@@ -0,0 +1,341 @@
+/*
+ * This file is part of the swblocks-baselib library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <baselib/async/AsyncExecutorWrapperCallback.h>
+
+#include <baselib/data/DataBlock.h>
+
+#include <baselib/tasks/ExecutionQueueImpl.h>
+#include <baselib/tasks/TaskBase.h>
+
+#include <baselib/core/Pool.h>
+#include <baselib/core/ObjModel.h>
+#include <baselib/core/BaseIncludes.h>
+
+#include <utests/baselib/BenchUtils.h>
+
+#include <vector>
+
+/************************************************************************
+ * Micro-benchmarks for the core primitives
+ */
+
+namespace benchcore
+{
+    using bl::data::DataBlock;
+
+    typedef bl::om::ObjPtr< DataBlock >                                             block_ptr_t;
+
+    typedef bl::om::ObjectImpl< bl::SimplePool< block_ptr_t > >                     simple_pool_t;
+    typedef bl::om::ObjectImpl< bl::LockFreePool< block_ptr_t > >                   lock_free_pool_t;
+
+    enum : std::size_t
+    {
+        BATCH_SIZE                  = 256U,
+        POOL_BLOCK_CAPACITY         = 4U * 1024U,
+        COPY_BLOCK_SIZE             = 64U * 1024U,
+        CONTENDED_THREADS_MAX       = 4U,
+    };
+
+    inline std::size_t contendedThreadsCount() NOEXCEPT
+    {
+        return std::max< std::size_t >(
+            2U,
+            std::min< std::size_t >( static_cast< std::size_t >( bl::os::thread::hardware_concurrency() ), CONTENDED_THREADS_MAX )
+            );
+    }
+
+    template
+    <
+        typename POOL
+    >
+    void poolGetPut(
+        SAA_in          const bl::om::ObjPtr< POOL >&                       pool,
+        SAA_in          const std::size_t                                   iterations
+        )
+    {
+        for( std::size_t i = 0U; i < iterations; ++i )
+        {
+            auto block = pool -> tryGet();
+
+            if( ! block )
+            {
+                block = DataBlock::createInstance( POOL_BLOCK_CAPACITY );
+            }
+
+            pool -> put( std::move( block ) );
+        }
+    }
+
+    template
+    <
+        typename POOL
+    >
+    void benchPool( SAA_in const std::string& name )
+    {
+        const auto pool = POOL::template createInstance< POOL >();
+
+        test::Bench::measure(
+            name + ".GetPut",
+            [ & ]( SAA_in const std::size_t iterations ) -> void
+            {
+                poolGetPut( pool, iterations );
+            }
+            );
+
+        const auto threadsCount = contendedThreadsCount();
+
+        test::Bench::measure(
+            name + ".GetPutContended",
+            [ & ]( SAA_in const std::size_t iterations ) -> void
+            {
+                std::vector< bl::os::thread > threads;
+                threads.reserve( threadsCount );
+
+                for( std::size_t i = 0U; i < threadsCount; ++i )
+                {
+                    threads.emplace_back(
+                        [ & ]() -> void
+                        {
+                            poolGetPut( pool, iterations );
+                        }
+                        );
+                }
+
+                for( auto& thread : threads )
+                {
+                    thread.join();
+                }
+            },
+            threadsCount /* operationsPerIteration */
+            );
+    }
+
+} // benchcore
+
+UTF_AUTO_TEST_CASE( Bench_ExecutionQueue )
+{
+    using namespace bl;
+    using namespace bl::tasks;
+
+    const auto eq = om::lockDisposable(
+        ExecutionQueueImpl::createInstance< ExecutionQueue >( ExecutionQueue::OptionKeepNone )
+        );
+
+    /*
+     * The tasks are pushed and flushed in batches, so the queue never grows
+     * beyond BATCH_SIZE pending tasks regardless of the # of iterations
+     */
+
+    test::Bench::measure(
+        "ExecutionQueueImpl.PushExecuteFlush",
+        [ & ]( SAA_in const std::size_t iterations ) -> void
+        {
+            std::size_t pushed = 0U;
+
+            while( pushed < iterations )
+            {
+                const auto batchSize = std::min< std::size_t >( iterations - pushed, benchcore::BATCH_SIZE );
+
+                for( std::size_t i = 0U; i < batchSize; ++i )
+                {
+                    eq -> push_back(
+                        SimpleTaskImpl::createInstance< Task >(
+                            []() -> void
+                            {
+                            }
+                            )
+                        );
+                }
+
+                eq -> flush();
+
+                pushed += batchSize;
+            }
+        }
+        );
+}
+
+UTF_AUTO_TEST_CASE( Bench_Pools )
+{
+    benchcore::benchPool< benchcore::simple_pool_t >( "SimplePool" );
+    benchcore::benchPool< benchcore::lock_free_pool_t >( "LockFreePool" );
+}
+
+UTF_AUTO_TEST_CASE( Bench_DataBlock )
+{
+    using namespace bl;
+    using namespace bl::data;
+
+    test::Bench::measure(
+        "DataBlock.CreateDefaultCapacity",
+        []( SAA_in const std::size_t iterations ) -> void
+        {
+            for( std::size_t i = 0U; i < iterations; ++i )
+            {
+                const auto block = DataBlock::createInstance();
+
+                BL_ASSERT( block -> capacity() == DataBlock::defaultCapacity() );
+            }
+        }
+        );
+
+    const auto dataBlocksPool = datablocks_pool_type::createInstance();
+
+    test::Bench::measure(
+        "DataBlock.GetFromPool",
+        [ & ]( SAA_in const std::size_t iterations ) -> void
+        {
+            for( std::size_t i = 0U; i < iterations; ++i )
+            {
+                auto block = DataBlock::get( dataBlocksPool );
+
+                dataBlocksPool -> put( std::move( block ) );
+            }
+        }
+        );
+
+    const auto source = DataBlock::createInstance();
+
+    for( std::size_t i = 0U; i < benchcore::COPY_BLOCK_SIZE; ++i )
+    {
+        source -> begin()[ i ] = static_cast< char >( i );
+    }
+
+    source -> setSize( benchcore::COPY_BLOCK_SIZE );
+
+    const auto nsPerCopy = test::Bench::measure(
+        "DataBlock.Copy64KBFromPool",
+        [ & ]( SAA_in const std::size_t iterations ) -> void
+        {
+            for( std::size_t i = 0U; i < iterations; ++i )
+            {
+                auto copy = DataBlock::copy( source, dataBlocksPool );
+
+                dataBlocksPool -> put( std::move( copy ) );
+            }
+        }
+        );
+
+    test::Bench::record(
+        "DataBlock.Copy64KBFromPool.Bandwidth",
+        "MB/s",
+        ( benchcore::COPY_BLOCK_SIZE * 1000.0 * 1000.0 * 1000.0 ) / ( nsPerCopy * 1024.0 * 1024.0 ),
+        true /* higherIsBetter */
+        );
+}
+
+UTF_AUTO_TEST_CASE( Bench_AsyncExecutor )
+{
+    using namespace bl;
+
+    typedef AsyncExecutorWrapperCallbackImpl                            wrapper_t;
+    typedef wrapper_t::AsyncOperationStateImpl                          operation_state_t;
+
+    const auto wrapperImpl = wrapper_t::createInstance();
+
+    os::mutex lock;
+    os::condition_variable completedEvent;
+    std::size_t completed = 0U;
+
+    /*
+     * Each iteration is a complete async call round-trip through AsyncExecutorImpl
+     * (createOperation + asyncBegin + execute + completion callback); the calls are
+     * issued in batches of up to BATCH_SIZE concurrent operations
+     */
+
+    test::Bench::measure(
+        "AsyncExecutorImpl.AsyncCallRoundTrip",
+        [ & ]( SAA_in const std::size_t iterations ) -> void
+        {
+            std::vector< om::ObjPtr< AsyncOperation > > operations;
+            operations.reserve( benchcore::BATCH_SIZE );
+
+            std::size_t issued = 0U;
+
+            while( issued < iterations )
+            {
+                const auto batchSize = std::min< std::size_t >( iterations - issued, benchcore::BATCH_SIZE );
+
+                {
+                    BL_MUTEX_GUARD( lock );
+
+                    completed = 0U;
+                }
+
+                for( std::size_t i = 0U; i < batchSize; ++i )
+                {
+                    const auto operationState = wrapperImpl -> createOperationState< operation_state_t >(
+                        []() -> void
+                        {
+                        },
+                        wrapper_t::create_task_callback_t()
+                        );
+
+                    operations.push_back(
+                        wrapperImpl -> asyncExecutor() -> createOperation(
+                            om::qi< AsyncOperationState >( operationState )
+                            )
+                        );
+
+                    wrapperImpl -> asyncExecutor() -> asyncBegin(
+                        operations.back(),
+                        [ & ]( SAA_in const AsyncOperation::Result& result ) NOEXCEPT -> void
+                        {
+                            BL_NOEXCEPT_BEGIN()
+
+                            BL_CHK(
+                                true,
+                                result.isFailed(),
+                                BL_MSG()
+                                    << "Async operation has failed unexpectedly"
+                                );
+
+                            BL_MUTEX_GUARD( lock );
+
+                            ++completed;
+
+                            completedEvent.notify_one();
+
+                            BL_NOEXCEPT_END()
+                        }
+                        );
+                }
+
+                {
+                    os::mutex_unique_lock guard( lock );
+
+                    completedEvent.wait(
+                        guard,
+                        [ & ]() -> bool
+                        {
+                            return completed == batchSize;
+                        }
+                        );
+                }
+
+                for( auto& operation : operations )
+                {
+                    wrapperImpl -> asyncExecutor() -> releaseOperation( operation );
+                }
+
+                operations.clear();
+
+                issued += batchSize;
+            }
+        }
+        );
+}
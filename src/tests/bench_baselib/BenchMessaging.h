@@ -0,0 +1,630 @@
+/*
+ * This file is part of the swblocks-baselib library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <utests/baselib/BenchUtils.h>
+#include <utests/baselib/TestMessagingUtils.h>
+#include <utests/baselib/MachineGlobalTestLock.h>
+#include <utests/baselib/UtfCrypto.h>
+
+#include <baselib/messaging/BrokerFacade.h>
+#include <baselib/messaging/BrokerBackendProcessing.h>
+#include <baselib/messaging/MessagingClientFactory.h>
+#include <baselib/messaging/MessagingUtils.h>
+#include <baselib/messaging/BrokerErrorCodes.h>
+
+#include <baselib/core/ObjModel.h>
+#include <baselib/core/BaseIncludes.h>
+
+#include <vector>
+
+/************************************************************************
+ * End-to-end loopback benchmarks through a local broker
+ */
+
+namespace benchmessaging
+{
+    enum : std::size_t
+    {
+        WARM_UP_ATTEMPTS_MAX            = 60U,
+        LATENCY_ROUND_TRIPS             = 2000U,
+        THROUGHPUT_ROUND_TRIPS          = 20000U,
+        THROUGHPUT_ROUND_TRIPS_LARGE    = 2000U,
+        THROUGHPUT_WINDOW_SIZE          = 64U,
+        THROUGHPUT_ROUND_TRIPS_PER_PAIR = 5000U,
+        LOOPBACK_PAIRS_MAX              = 4U,
+        CONTENDED_THREADS_MAX           = 4U,
+        LARGE_PAYLOAD_SIZE              = 64U * 1024U,
+        RECEIVE_TIMEOUT_IN_SECONDS      = 30U,
+    };
+
+    /**
+     * @brief class LoopbackPair - two messaging clients connected to the local broker
+     * where the 'echo' client sends back every message it receives to the 'ping' client
+     *
+     * The ping side counts the messages received back, so the benchmarks can measure
+     * the round-trip latency (one message in flight) and the throughput (a window of
+     * messages in flight) of the full client -> broker -> client path, which includes
+     * the data model serialization, the data blocks and the block transfer protocol
+     */
+
+    template
+    <
+        typename E = void
+    >
+    class LoopbackPairT
+    {
+        BL_NO_COPY_OR_MOVE( LoopbackPairT )
+
+    public:
+
+        typedef bl::messaging::MessagingClientObjectDispatch                object_dispatch_t;
+        typedef bl::messaging::BrokerProtocol                               BrokerProtocol;
+        typedef bl::messaging::Payload                                      Payload;
+
+    private:
+
+        const bl::uuid_t                                                    m_pingPeerId;
+        const bl::uuid_t                                                    m_echoPeerId;
+        const bl::om::ObjPtr< bl::data::datablocks_pool_type >              m_dataBlocksPool;
+        const bl::om::ObjPtrCopyable< bl::om::Proxy >                       m_echoSink;
+
+        bl::os::mutex                                                       m_lock;
+        bl::os::condition_variable                                          m_receivedEvent;
+        std::size_t                                                         m_received;
+
+        bl::om::ObjPtr< BrokerProtocol >                                    m_pingProtocol;
+        bl::om::ObjPtr< BrokerProtocol >                                    m_echoProtocol;
+
+        bl::om::ObjPtrDisposable< object_dispatch_t >                       m_pingIncoming;
+        bl::om::ObjPtrDisposable< object_dispatch_t >                       m_echoIncoming;
+        bl::om::ObjPtrDisposable< bl::messaging::MessagingClientObject >    m_pingClient;
+        bl::om::ObjPtrDisposable< bl::messaging::MessagingClientObject >    m_echoClient;
+
+        void onPingReceived() NOEXCEPT
+        {
+            BL_MUTEX_GUARD( m_lock );
+
+            ++m_received;
+
+            m_receivedEvent.notify_all();
+        }
+
+        void onEchoReceived( SAA_in_opt const bl::om::ObjPtr< Payload >& payload )
+        {
+            bl::os::mutex_unique_lock guard;
+
+            const auto target = m_echoSink -> tryAcquireRef< object_dispatch_t >( object_dispatch_t::iid(), &guard );
+
+            if( target )
+            {
+                pushWithRetries( target, m_pingPeerId, m_echoProtocol, payload );
+            }
+        }
+
+        static void pushWithRetries(
+            SAA_in          const bl::om::ObjPtr< object_dispatch_t >&      channel,
+            SAA_in          const bl::uuid_t&                               targetPeerId,
+            SAA_in          const bl::om::ObjPtr< BrokerProtocol >&         brokerProtocol,
+            SAA_in_opt      const bl::om::ObjPtr< Payload >&                payload
+            )
+        {
+            for( ;; )
+            {
+                try
+                {
+                    channel -> pushMessage( targetPeerId, brokerProtocol, payload );
+
+                    return;
+                }
+                catch( bl::ServerErrorException& e )
+                {
+                    const auto* ec = e.errorCode();
+
+                    if( ! ec || bl::eh::errc::make_error_code( bl::messaging::BrokerErrorCodes::TargetPeerQueueFull ) != *ec )
+                    {
+                        throw;
+                    }
+                }
+
+                /*
+                 * The sender queue is full; back off for a bit and retry
+                 */
+
+                bl::os::sleep( bl::time::milliseconds( 1L ) );
+            }
+        }
+
+    public:
+
+        LoopbackPairT( SAA_in const bl::om::ObjPtr< bl::data::datablocks_pool_type >& dataBlocksPool )
+            :
+            m_pingPeerId( bl::uuids::create() ),
+            m_echoPeerId( bl::uuids::create() ),
+            m_dataBlocksPool( bl::om::copy( dataBlocksPool ) ),
+            m_echoSink( bl::om::ProxyImpl::createInstance< bl::om::Proxy >( true /* strongRef */ ) ),
+            m_received( 0U )
+        {
+            using namespace bl;
+            using namespace bl::messaging;
+
+            const auto& cookiesText = utest::TestMessagingUtils::getTokenData();
+
+            m_pingProtocol = utest::TestMessagingUtils::createBrokerProtocolMessage(
+                MessageType::AsyncRpcDispatch,
+                uuids::create()                                         /* conversationId */,
+                cookiesText
+                );
+
+            m_echoProtocol = utest::TestMessagingUtils::createBrokerProtocolMessage(
+                MessageType::AsyncRpcDispatch,
+                uuids::create()                                         /* conversationId */,
+                cookiesText
+                );
+
+            m_pingIncoming = om::lockDisposable(
+                MessagingClientObjectDispatchFromCallback::createInstance< object_dispatch_t >(
+                    [ this ](
+                        SAA_in              const uuid_t&                                   targetPeerId,
+                        SAA_in              const om::ObjPtr< BrokerProtocol >&             brokerProtocol,
+                        SAA_in_opt          const om::ObjPtr< Payload >&                    payload
+                        )
+                        -> void
+                    {
+                        BL_UNUSED( targetPeerId );
+                        BL_UNUSED( brokerProtocol );
+                        BL_UNUSED( payload );
+
+                        onPingReceived();
+                    }
+                    )
+                );
+
+            m_echoIncoming = om::lockDisposable(
+                MessagingClientObjectDispatchFromCallback::createInstance< object_dispatch_t >(
+                    [ this ](
+                        SAA_in              const uuid_t&                                   targetPeerId,
+                        SAA_in              const om::ObjPtr< BrokerProtocol >&             brokerProtocol,
+                        SAA_in_opt          const om::ObjPtr< Payload >&                    payload
+                        )
+                        -> void
+                    {
+                        BL_UNUSED( targetPeerId );
+                        BL_UNUSED( brokerProtocol );
+
+                        onEchoReceived( payload );
+                    }
+                    )
+                );
+
+            auto pingConnections = MessagingClientFactorySsl::createEstablishedConnections(
+                test::UtfArgsParser::host(),
+                test::UtfArgsParser::port()                             /* inboundPort */,
+                test::UtfArgsParser::port() + 1                         /* outboundPort */
+                );
+
+            auto echoConnections = MessagingClientFactorySsl::createEstablishedConnections(
+                test::UtfArgsParser::host(),
+                test::UtfArgsParser::port()                             /* inboundPort */,
+                test::UtfArgsParser::port() + 1                         /* outboundPort */
+                );
+
+            m_pingClient = om::lockDisposable(
+                MessagingClientObjectFactory::createFromObjectDispatchTcp(
+                    om::qi< object_dispatch_t >( m_pingIncoming ),
+                    m_dataBlocksPool,
+                    m_pingPeerId,
+                    test::UtfArgsParser::host(),
+                    test::UtfArgsParser::port()                         /* inboundPort */,
+                    test::UtfArgsParser::port() + 1                     /* outboundPort */,
+                    std::move( pingConnections.first )                  /* inboundConnection */,
+                    std::move( pingConnections.second )                 /* outboundConnection */
+                    )
+                );
+
+            m_echoClient = om::lockDisposable(
+                MessagingClientObjectFactory::createFromObjectDispatchTcp(
+                    om::qi< object_dispatch_t >( m_echoIncoming ),
+                    m_dataBlocksPool,
+                    m_echoPeerId,
+                    test::UtfArgsParser::host(),
+                    test::UtfArgsParser::port()                         /* inboundPort */,
+                    test::UtfArgsParser::port() + 1                     /* outboundPort */,
+                    std::move( echoConnections.first )                  /* inboundConnection */,
+                    std::move( echoConnections.second )                 /* outboundConnection */
+                    )
+                );
+
+            m_echoSink -> connect( m_echoClient -> outgoingObjectChannel().get() );
+        }
+
+        ~LoopbackPairT() NOEXCEPT
+        {
+            m_echoSink -> disconnect();
+        }
+
+        std::size_t received() NOEXCEPT
+        {
+            BL_MUTEX_GUARD( m_lock );
+
+            return m_received;
+        }
+
+        bool waitForReceived(
+            SAA_in          const std::size_t                               expected,
+            SAA_in          const bl::time::time_duration&                  timeout
+            )
+        {
+            bl::os::mutex_unique_lock guard( m_lock );
+
+            return m_receivedEvent.wait_for(
+                guard,
+                bl::os::chrono::milliseconds( timeout.total_milliseconds() ),
+                [ & ]() -> bool
+                {
+                    return m_received >= expected;
+                }
+                );
+        }
+
+        void ping( SAA_in_opt const bl::om::ObjPtr< Payload >& payload = nullptr )
+        {
+            pushWithRetries( m_pingClient -> outgoingObjectChannel(), m_echoPeerId, m_pingProtocol, payload );
+        }
+
+        /**
+         * @brief Sends pings until the first one makes it back, so the broker knows
+         * about both peers before any measurements are taken
+         */
+
+        void warmUp()
+        {
+            for( std::size_t i = 0U; i < WARM_UP_ATTEMPTS_MAX; ++i )
+            {
+                const auto expected = received() + 1U;
+
+                ping();
+
+                if( waitForReceived( expected, bl::time::seconds( 1L ) ) )
+                {
+                    return;
+                }
+            }
+
+            BL_THROW(
+                bl::UnexpectedException(),
+                BL_MSG()
+                    << "The loopback messaging clients were not able to exchange messages via the broker"
+                );
+        }
+
+        /**
+         * @brief Executes the specified # of round-trips keeping up to windowSize messages
+         * in flight and returns the elapsed time in nanoseconds
+         */
+
+        double runRoundTrips(
+            SAA_in          const std::size_t                               roundTrips,
+            SAA_in          const std::size_t                               windowSize,
+            SAA_in_opt      const bl::om::ObjPtr< Payload >&                payload = nullptr,
+            SAA_inout_opt   std::vector< double >*                          latencies = nullptr
+            )
+        {
+            const auto base = received();
+            const auto timeout = bl::time::seconds( static_cast< long >( RECEIVE_TIMEOUT_IN_SECONDS ) );
+
+            const auto startTime = test::Bench::now();
+
+            for( std::size_t sent = 0U; sent < roundTrips; ++sent )
+            {
+                if( sent >= windowSize )
+                {
+                    BL_CHK(
+                        false,
+                        waitForReceived( base + sent - windowSize + 1U, timeout ),
+                        BL_MSG()
+                            << "Timed out waiting for a loopback message to be received"
+                        );
+                }
+
+                const auto pingTime = test::Bench::now();
+
+                ping( payload );
+
+                if( latencies )
+                {
+                    BL_CHK(
+                        false,
+                        waitForReceived( base + sent + 1U, timeout ),
+                        BL_MSG()
+                            << "Timed out waiting for a loopback message to be received"
+                        );
+
+                    latencies -> push_back( test::Bench::elapsedSince( pingTime ) / 1000.0 );
+                }
+            }
+
+            BL_CHK(
+                false,
+                waitForReceived( base + roundTrips, timeout ),
+                BL_MSG()
+                    << "Timed out waiting for a loopback message to be received"
+                );
+
+            return test::Bench::elapsedSince( startTime );
+        }
+    };
+
+    typedef LoopbackPairT<> LoopbackPair;
+
+    inline std::size_t contendedThreadsCount() NOEXCEPT
+    {
+        return std::max< std::size_t >(
+            2U,
+            std::min< std::size_t >( static_cast< std::size_t >( bl::os::thread::hardware_concurrency() ), CONTENDED_THREADS_MAX )
+            );
+    }
+
+    /**
+     * @brief Executes the callback on the specified # of threads concurrently and waits
+     * for all of them to finish
+     */
+
+    template
+    <
+        typename CB
+    >
+    void runOnThreads(
+        SAA_in          const std::size_t                                   threadsCount,
+        SAA_in          const CB&                                           callback
+        )
+    {
+        std::vector< bl::os::thread > threads;
+        threads.reserve( threadsCount );
+
+        for( std::size_t i = 0U; i < threadsCount; ++i )
+        {
+            threads.emplace_back(
+                [ &callback, i ]() -> void
+                {
+                    callback( i );
+                }
+                );
+        }
+
+        for( auto& thread : threads )
+        {
+            thread.join();
+        }
+    }
+
+} // benchmessaging
+
+UTF_AUTO_TEST_CASE( Bench_BrokerBackendTaskCreation )
+{
+    using namespace bl;
+    using namespace bl::messaging;
+    using namespace benchmessaging;
+
+    /*
+     * Every block received by the broker (on the I/O threads of all connections) goes
+     * through createBackendProcessingTask(), so it must scale with the # of connections
+     */
+
+    const auto backend = om::lockDisposable(
+        BrokerBackendProcessing::createInstance< BackendProcessing >(
+            utest::DummyAuthorizationCache::createInstance< security::AuthorizationCache >()
+            )
+        );
+
+    const auto hostServices = om::ProxyImpl::createInstance< om::Proxy >();
+
+    backend -> setHostServices( om::copy( hostServices ) );
+
+    const auto dataBlock = data::DataBlock::createInstance();
+
+    const auto createTasks = [ & ]( SAA_in const std::size_t iterations ) -> void
+    {
+        for( std::size_t i = 0U; i < iterations; ++i )
+        {
+            const auto task = backend -> createBackendProcessingTask(
+                BackendProcessing::OperationId::Put,
+                BackendProcessing::CommandId::None,
+                uuids::nil()                                    /* sessionId */,
+                uuids::nil()                                    /* chunkId */,
+                uuids::nil()                                    /* sourcePeerId */,
+                uuids::nil()                                    /* targetPeerId */,
+                dataBlock
+                );
+
+            BL_ASSERT( task );
+        }
+    };
+
+    test::Bench::measure( "BrokerBackendProcessing.CreateTask", createTasks );
+
+    const auto threadsCount = contendedThreadsCount();
+
+    test::Bench::measure(
+        "BrokerBackendProcessing.CreateTaskContended",
+        [ & ]( SAA_in const std::size_t iterations ) -> void
+        {
+            runOnThreads(
+                threadsCount,
+                [ & ]( SAA_in const std::size_t /* threadIndex */ ) -> void
+                {
+                    createTasks( iterations );
+                }
+                );
+        },
+        threadsCount /* operationsPerIteration */
+        );
+
+    backend -> setHostServices( nullptr );
+}
+
+UTF_AUTO_TEST_CASE( Bench_MessagingLoopback )
+{
+    using namespace bl;
+    using namespace bl::messaging;
+    using namespace benchmessaging;
+
+    const auto callback = []() -> void
+    {
+        const auto dataBlocksPool = data::datablocks_pool_type::createInstance();
+
+        LoopbackPair loopback( dataBlocksPool );
+
+        loopback.warmUp();
+
+        /*
+         * Round-trip latency with a single message in flight
+         */
+
+        {
+            std::vector< double > latencies;
+            latencies.reserve( LATENCY_ROUND_TRIPS );
+
+            loopback.runRoundTrips( LATENCY_ROUND_TRIPS, 1U /* windowSize */, nullptr /* payload */, &latencies );
+
+            test::Bench::record(
+                "Messaging.Loopback.RoundTripLatency.p50",
+                "us",
+                test::Bench::percentile( latencies, 50.0 ),
+                false /* higherIsBetter */,
+                LATENCY_ROUND_TRIPS
+                );
+
+            test::Bench::record(
+                "Messaging.Loopback.RoundTripLatency.p99",
+                "us",
+                test::Bench::percentile( latencies, 99.0 ),
+                false /* higherIsBetter */,
+                LATENCY_ROUND_TRIPS
+                );
+        }
+
+        /*
+         * Throughput with a window of messages in flight (small messages and then
+         * messages with a large payload to exercise the block transfer path)
+         */
+
+        {
+            const auto elapsed = loopback.runRoundTrips( THROUGHPUT_ROUND_TRIPS, THROUGHPUT_WINDOW_SIZE );
+
+            test::Bench::record(
+                "Messaging.Loopback.Throughput",
+                "msgs/s",
+                THROUGHPUT_ROUND_TRIPS * 1000.0 * 1000.0 * 1000.0 / elapsed,
+                true /* higherIsBetter */,
+                THROUGHPUT_ROUND_TRIPS
+                );
+        }
+
+        {
+            const auto payload = dm::DataModelUtils::loadFromJsonText< Payload >(
+                resolveMessage(
+                    BL_MSG()
+                        << "{\"asyncRpcRequest\":{\"data\":\""
+                        << std::string( LARGE_PAYLOAD_SIZE, 'x' )
+                        << "\"}}"
+                    )
+                );
+
+            const auto elapsed = loopback.runRoundTrips( THROUGHPUT_ROUND_TRIPS_LARGE, THROUGHPUT_WINDOW_SIZE, payload );
+
+            const auto messagesPerSecond = THROUGHPUT_ROUND_TRIPS_LARGE * 1000.0 * 1000.0 * 1000.0 / elapsed;
+
+            test::Bench::record(
+                "Messaging.Loopback.Throughput64KB",
+                "msgs/s",
+                messagesPerSecond,
+                true /* higherIsBetter */,
+                THROUGHPUT_ROUND_TRIPS_LARGE
+                );
+
+            /*
+             * Each round-trip transfers the payload twice (there and back)
+             */
+
+            test::Bench::record(
+                "Messaging.Loopback.Throughput64KB.Bandwidth",
+                "MB/s",
+                2.0 * messagesPerSecond * LARGE_PAYLOAD_SIZE / ( 1024.0 * 1024.0 ),
+                true /* higherIsBetter */,
+                THROUGHPUT_ROUND_TRIPS_LARGE
+                );
+        }
+
+        /*
+         * Aggregate throughput of several loopback pairs (i.e. connections) running through
+         * the broker concurrently, which shows how the broker dispatch scales
+         */
+
+        {
+            std::vector< cpp::SafeUniquePtr< LoopbackPair > > pairs;
+
+            for( std::size_t i = 0U; i < LOOPBACK_PAIRS_MAX; ++i )
+            {
+                pairs.emplace_back( cpp::SafeUniquePtr< LoopbackPair >::attach( new LoopbackPair( dataBlocksPool ) ) );
+
+                pairs.back() -> warmUp();
+            }
+
+            const auto startTime = test::Bench::now();
+
+            runOnThreads(
+                pairs.size(),
+                [ & ]( SAA_in const std::size_t index ) -> void
+                {
+                    pairs[ index ] -> runRoundTrips( THROUGHPUT_ROUND_TRIPS_PER_PAIR, THROUGHPUT_WINDOW_SIZE );
+                }
+                );
+
+            const auto elapsed = test::Bench::elapsedSince( startTime );
+
+            const auto roundTrips = pairs.size() * THROUGHPUT_ROUND_TRIPS_PER_PAIR;
+
+            test::Bench::record(
+                "Messaging.Loopback.ThroughputMultiConnection",
+                "msgs/s",
+                roundTrips * 1000.0 * 1000.0 * 1000.0 / elapsed,
+                true /* higherIsBetter */,
+                roundTrips
+                );
+        }
+    };
+
+    /*
+     * This global lock needed to avoid conflicts with the default ports used below
+     */
+
+    test::MachineGlobalTestLock lock;
+
+    const auto processingBackend = om::lockDisposable(
+        utest::TestMessagingUtils::createTestMessagingBackend()
+        );
+
+    BrokerFacade::execute(
+        processingBackend,
+        test::UtfCrypto::getDefaultServerKey()              /* privateKeyPem */,
+        test::UtfCrypto::getDefaultServerCertificate()      /* certificatePem */,
+        test::UtfArgsParser::port()                         /* inboundPort */,
+        test::UtfArgsParser::port() + 1                     /* outboundPort */,
+        test::UtfArgsParser::threadsCount(),
+        0U                                                  /* maxConcurrentTasks */,
+        callback
+        );
+}
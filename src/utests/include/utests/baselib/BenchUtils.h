@@ -0,0 +1,531 @@
+/*
+ * This file is part of the swblocks-baselib library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTESTS_SHARED_BENCHUTILS_H_
+#define __UTESTS_SHARED_BENCHUTILS_H_
+
+#include <utests/baselib/UtfArgsParser.h>
+#include <utests/baselib/Utf.h>
+
+#include <baselib/core/FileEncoding.h>
+#include <baselib/core/JsonUtils.h>
+#include <baselib/core/OS.h>
+#include <baselib/core/BaseIncludes.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace test
+{
+    /**
+     * @brief The argument parser for the benchmark modules
+     *
+     * It adds the benchmark specific options (results file, baseline file, regression
+     * tolerance and sampling parameters) on top of the generic UTF options and it is
+     * meant to be plugged in via the UTF_TEST_APP_INIT_UTF_ARGS_PARSER macro
+     */
+
+    template
+    <
+        typename E = void
+    >
+    class BenchArgsParserT : public UtfArgsParserImpl< BenchArgsParserT< E > >
+    {
+        BL_NO_CREATE( BenchArgsParserT )
+
+    public:
+
+        enum : std::size_t
+        {
+            TOLERANCE_IN_PERCENT_DEFAULT        = 15U,
+            MIN_TIME_IN_MILLISECONDS_DEFAULT    = 250U,
+            SAMPLES_COUNT_DEFAULT               = 5U,
+        };
+
+    protected:
+
+        static std::string      g_benchResultsPath;
+        static std::string      g_benchBaselinePath;
+        static std::size_t      g_benchToleranceInPercent;
+        static std::size_t      g_benchMinTimeInMilliseconds;
+        static std::size_t      g_benchSamplesCount;
+
+    public:
+
+        static const std::string& benchResultsPath() NOEXCEPT
+        {
+            return g_benchResultsPath;
+        }
+
+        static const std::string& benchBaselinePath() NOEXCEPT
+        {
+            return g_benchBaselinePath;
+        }
+
+        static std::size_t benchToleranceInPercent() NOEXCEPT
+        {
+            return g_benchToleranceInPercent;
+        }
+
+        static std::size_t benchMinTimeInMilliseconds() NOEXCEPT
+        {
+            return g_benchMinTimeInMilliseconds;
+        }
+
+        static std::size_t benchSamplesCount() NOEXCEPT
+        {
+            return g_benchSamplesCount;
+        }
+
+        static void addOptions( SAA_inout bl::po::options_description& desc )
+        {
+            UtfArgsParserBase::addOptions( desc );
+
+            desc.add_options()
+                ( "bench-results", bl::po::value< std::string >() -> default_value( "" ), "The JSON file to save the benchmark results into" )
+                ( "bench-baseline", bl::po::value< std::string >() -> default_value( "" ), "The JSON file with the baseline results to compare against" )
+                ( "bench-tolerance", bl::po::value< std::size_t >() -> default_value( TOLERANCE_IN_PERCENT_DEFAULT ), "The regression tolerance relative to the baseline (in percent)" )
+                ( "bench-min-time", bl::po::value< std::size_t >() -> default_value( MIN_TIME_IN_MILLISECONDS_DEFAULT ), "The minimum time of a single benchmark sample (in milliseconds)" )
+                ( "bench-samples", bl::po::value< std::size_t >() -> default_value( SAMPLES_COUNT_DEFAULT ), "The number of samples per benchmark (the median is reported)" )
+            ;
+        }
+
+        static void loadOptions( SAA_inout bl::po::variables_map& vm )
+        {
+            UtfArgsParserBase::loadOptions( vm );
+
+            if( vm.count( "bench-results" ) )
+            {
+                g_benchResultsPath = vm[ "bench-results" ].as< std::string >();
+            }
+
+            if( vm.count( "bench-baseline" ) )
+            {
+                g_benchBaselinePath = vm[ "bench-baseline" ].as< std::string >();
+            }
+
+            if( vm.count( "bench-tolerance" ) )
+            {
+                g_benchToleranceInPercent = vm[ "bench-tolerance" ].as< std::size_t >();
+            }
+
+            if( vm.count( "bench-min-time" ) )
+            {
+                g_benchMinTimeInMilliseconds = std::max< std::size_t >( vm[ "bench-min-time" ].as< std::size_t >(), 1U );
+            }
+
+            if( vm.count( "bench-samples" ) )
+            {
+                g_benchSamplesCount = std::min< std::size_t >( std::max< std::size_t >( vm[ "bench-samples" ].as< std::size_t >(), 1U ), 101U );
+            }
+        }
+
+        static void dumpOptions()
+        {
+            UtfArgsParserBase::dumpOptions();
+
+            BL_LOG( bl::Logging::debug(), BL_MSG() << "ARGPARSE: UTF argument 'benchResultsPath' is " << g_benchResultsPath );
+            BL_LOG( bl::Logging::debug(), BL_MSG() << "ARGPARSE: UTF argument 'benchBaselinePath' is " << g_benchBaselinePath );
+            BL_LOG( bl::Logging::debug(), BL_MSG() << "ARGPARSE: UTF argument 'benchToleranceInPercent' is " << g_benchToleranceInPercent );
+            BL_LOG( bl::Logging::debug(), BL_MSG() << "ARGPARSE: UTF argument 'benchMinTimeInMilliseconds' is " << g_benchMinTimeInMilliseconds );
+            BL_LOG( bl::Logging::debug(), BL_MSG() << "ARGPARSE: UTF argument 'benchSamplesCount' is " << g_benchSamplesCount );
+        }
+    };
+
+    BL_DEFINE_STATIC_MEMBER( BenchArgsParserT, std::string, g_benchResultsPath );
+
+    BL_DEFINE_STATIC_MEMBER( BenchArgsParserT, std::string, g_benchBaselinePath );
+
+    BL_DEFINE_STATIC_MEMBER( BenchArgsParserT, std::size_t, g_benchToleranceInPercent ) = BenchArgsParserT< TCLASS >::TOLERANCE_IN_PERCENT_DEFAULT;
+
+    BL_DEFINE_STATIC_MEMBER( BenchArgsParserT, std::size_t, g_benchMinTimeInMilliseconds ) = BenchArgsParserT< TCLASS >::MIN_TIME_IN_MILLISECONDS_DEFAULT;
+
+    BL_DEFINE_STATIC_MEMBER( BenchArgsParserT, std::size_t, g_benchSamplesCount ) = BenchArgsParserT< TCLASS >::SAMPLES_COUNT_DEFAULT;
+
+    typedef BenchArgsParserT<> BenchArgsParser;
+
+    /**
+     * @brief class Bench - the benchmark measurement and reporting helpers
+     *
+     * measure() auto-calibrates the number of iterations so a single sample runs for at
+     * least --bench-min-time, takes --bench-samples samples and reports the median in
+     * nanoseconds per operation; record() can be used directly for metrics which are
+     * not time per operation (e.g. latency percentiles or throughput)
+     *
+     * Every recorded result is appended to the --bench-results JSON file (the whole file
+     * is re-written, so it is complete even if a later benchmark fails) and if a baseline
+     * file is provided (which is simply a results file from an earlier run) the result is
+     * compared with the baseline value and a regression beyond --bench-tolerance fails
+     * the current test case
+     *
+     * The results file format is:
+     *
+     * {
+     *     "results" : [
+     *         {
+     *             "name" : "...", "unit" : "ns/op", "value" : 12.5, "higherIsBetter" : false,
+     *             "min" : 12.1, "max" : 13.0, "iterations" : 1048576, "samples" : 5,
+     *             "baseline" : 12.4, "regressed" : false
+     *         },
+     *         ...
+     *     ]
+     * }
+     */
+
+    template
+    <
+        typename E = void
+    >
+    class BenchT
+    {
+        BL_DECLARE_STATIC( BenchT )
+
+    public:
+
+        typedef bl::cpp::function< void ( SAA_in const std::size_t iterations ) >   callback_t;
+
+        typedef bl::os::chrono::steady_clock                                        clock_t;
+
+        typedef std::unordered_map< std::string, double >                           baseline_map_t;
+
+    private:
+
+        static bl::os::mutex                                                        g_lock;
+        static bl::json::Array                                                      g_results;
+        static baseline_map_t                                                       g_baseline;
+        static bool                                                                 g_baselineLoaded;
+
+        static void loadBaselineNoLock()
+        {
+            if( g_baselineLoaded )
+            {
+                return;
+            }
+
+            g_baselineLoaded = true;
+
+            const auto& baselinePath = BenchArgsParser::benchBaselinePath();
+
+            if( baselinePath.empty() )
+            {
+                return;
+            }
+
+            const auto rootValue = bl::json::readFromString(
+                bl::encoding::readTextFile( bl::fs::absolute( baselinePath ) )
+                );
+
+            const auto& rootObject = rootValue.get_obj();
+
+            const auto pos = rootObject.find( "results" );
+
+            BL_CHK(
+                false,
+                pos != rootObject.end(),
+                BL_MSG()
+                    << "The benchmark baseline file "
+                    << baselinePath
+                    << " does not have 'results' property"
+                );
+
+            for( const auto& entry : pos -> second.get_array() )
+            {
+                const auto& entryObject = entry.get_obj();
+
+                g_baseline[ entryObject.at( "name" ).get_str() ] = entryObject.at( "value" ).get_real();
+            }
+
+            BL_LOG(
+                bl::Logging::debug(),
+                BL_MSG()
+                    << "Loaded "
+                    << g_baseline.size()
+                    << " benchmark baseline results from "
+                    << baselinePath
+                );
+        }
+
+        static void saveResultsNoLock()
+        {
+            const auto& resultsPath = BenchArgsParser::benchResultsPath();
+
+            if( resultsPath.empty() )
+            {
+                return;
+            }
+
+            bl::json::Object rootObject;
+
+            rootObject.emplace( "results", g_results );
+
+            bl::encoding::writeTextFile(
+                bl::fs::absolute( resultsPath ),
+                bl::json::saveToString( rootObject, true /* prettyPrint */ ),
+                bl::encoding::TextFileEncoding::Utf8_NoPreamble
+                );
+        }
+
+        static double elapsedInNanoseconds( SAA_in const clock_t::time_point& startTime ) NOEXCEPT
+        {
+            return static_cast< double >(
+                bl::os::chrono::duration_cast< bl::os::chrono::nanoseconds >( clock_t::now() - startTime ).count()
+                );
+        }
+
+        static double runInNanoseconds(
+            SAA_in          const callback_t&                       callback,
+            SAA_in          const std::size_t                       iterations
+            )
+        {
+            const auto startTime = clock_t::now();
+
+            callback( iterations );
+
+            return elapsedInNanoseconds( startTime );
+        }
+
+        static void recordInternal(
+            SAA_in          const std::string&                      name,
+            SAA_in          const std::string&                      unit,
+            SAA_in          const double                            value,
+            SAA_in          const bool                              higherIsBetter,
+            SAA_in          const double                            minValue,
+            SAA_in          const double                            maxValue,
+            SAA_in          const std::size_t                       iterations,
+            SAA_in          const std::size_t                       samples
+            )
+        {
+            BL_MUTEX_GUARD( g_lock );
+
+            loadBaselineNoLock();
+
+            bl::json::Object result;
+
+            result.emplace( "name", name );
+            result.emplace( "unit", unit );
+            result.emplace( "value", value );
+            result.emplace( "higherIsBetter", higherIsBetter );
+            result.emplace( "min", minValue );
+            result.emplace( "max", maxValue );
+            result.emplace( "iterations", static_cast< std::uint64_t >( iterations ) );
+            result.emplace( "samples", static_cast< std::uint64_t >( samples ) );
+
+            BL_LOG(
+                bl::Logging::debug(),
+                BL_MSG()
+                    << "BENCH: "
+                    << name
+                    << " = "
+                    << value
+                    << " "
+                    << unit
+                    << " [min="
+                    << minValue
+                    << "; max="
+                    << maxValue
+                    << "; iterations="
+                    << iterations
+                    << "; samples="
+                    << samples
+                    << "]"
+                );
+
+            const auto pos = g_baseline.find( name );
+
+            if( pos != g_baseline.end() && pos -> second > 0.0 )
+            {
+                const auto baseline = pos -> second;
+                const auto tolerance = BenchArgsParser::benchToleranceInPercent() / 100.0;
+
+                const bool regressed = higherIsBetter ?
+                    value < baseline * ( 1.0 - tolerance ) : value > baseline * ( 1.0 + tolerance );
+
+                result.emplace( "baseline", baseline );
+                result.emplace( "regressed", regressed );
+
+                BL_LOG(
+                    bl::Logging::debug(),
+                    BL_MSG()
+                        << "BENCH: "
+                        << name
+                        << " baseline is "
+                        << baseline
+                        << " "
+                        << unit
+                        << "; the change is "
+                        << ( ( value - baseline ) * 100.0 / baseline )
+                        << "%"
+                    );
+
+                if( regressed )
+                {
+                    UTF_ERROR_MESSAGE(
+                        BL_MSG()
+                            << "Benchmark '"
+                            << name
+                            << "' regressed beyond the tolerance of "
+                            << BenchArgsParser::benchToleranceInPercent()
+                            << "%: the value is "
+                            << value
+                            << " "
+                            << unit
+                            << " while the baseline is "
+                            << baseline
+                            << " "
+                            << unit
+                        );
+                }
+            }
+
+            g_results.push_back( bl::json::Value( result ) );
+
+            saveResultsNoLock();
+        }
+
+    public:
+
+        /**
+         * @brief Records a single benchmark result which was measured by the caller
+         */
+
+        static void record(
+            SAA_in          const std::string&                      name,
+            SAA_in          const std::string&                      unit,
+            SAA_in          const double                            value,
+            SAA_in          const bool                              higherIsBetter,
+            SAA_in_opt      const std::size_t                       iterations = 0U
+            )
+        {
+            recordInternal( name, unit, value, higherIsBetter, value, value, iterations, 1U /* samples */ );
+        }
+
+        /**
+         * @brief Measures the time per operation of the callback which is expected to execute
+         * the operation 'iterations' times (or 'iterations * operationsPerIteration' times if
+         * each iteration does more than one operation) and records the median of all samples
+         *
+         * Returns the median in nanoseconds per operation
+         */
+
+        static double measure(
+            SAA_in          const std::string&                      name,
+            SAA_in          const callback_t&                       callback,
+            SAA_in_opt      const std::size_t                       operationsPerIteration = 1U
+            )
+        {
+            BL_ASSERT( operationsPerIteration );
+
+            const double minTimeInNanoseconds = BenchArgsParser::benchMinTimeInMilliseconds() * 1000.0 * 1000.0;
+
+            /*
+             * Warm up and calibrate the # of iterations, so each sample runs for at least
+             * the minimum time (the growth factor is capped to avoid overshooting when the
+             * first few runs are dominated by warm up costs)
+             */
+
+            std::size_t iterations = 1U;
+
+            for( ;; )
+            {
+                const auto elapsed = runInNanoseconds( callback, iterations );
+
+                if( elapsed >= minTimeInNanoseconds )
+                {
+                    break;
+                }
+
+                const auto factor = elapsed > 0.0 ? ( 1.2 * minTimeInNanoseconds / elapsed ) : 10.0;
+
+                iterations = static_cast< std::size_t >(
+                    iterations * std::min< double >( std::max< double >( factor, 2.0 ), 10.0 )
+                    );
+            }
+
+            std::vector< double > samples;
+            samples.reserve( BenchArgsParser::benchSamplesCount() );
+
+            for( std::size_t i = 0U; i < BenchArgsParser::benchSamplesCount(); ++i )
+            {
+                samples.push_back(
+                    runInNanoseconds( callback, iterations ) / ( iterations * operationsPerIteration )
+                    );
+            }
+
+            std::sort( samples.begin(), samples.end() );
+
+            const auto median = samples[ samples.size() / 2U ];
+
+            recordInternal(
+                name,
+                "ns/op",
+                median,
+                false /* higherIsBetter */,
+                samples.front(),
+                samples.back(),
+                iterations * operationsPerIteration,
+                samples.size()
+                );
+
+            return median;
+        }
+
+        /**
+         * @brief Returns the value at the specified percentile (0 - 100) of a set of
+         * measurements (the measurements vector is sorted in place)
+         */
+
+        static double percentile(
+            SAA_inout       std::vector< double >&                  measurements,
+            SAA_in          const double                            percent
+            )
+        {
+            BL_CHK_ARG( ! measurements.empty(), measurements );
+
+            std::sort( measurements.begin(), measurements.end() );
+
+            const auto index = static_cast< std::size_t >( percent * ( measurements.size() - 1U ) / 100.0 + 0.5 );
+
+            return measurements[ std::min< std::size_t >( index, measurements.size() - 1U ) ];
+        }
+
+        static auto now() NOEXCEPT -> clock_t::time_point
+        {
+            return clock_t::now();
+        }
+
+        static double elapsedSince( SAA_in const clock_t::time_point& startTime ) NOEXCEPT
+        {
+            return elapsedInNanoseconds( startTime );
+        }
+    };
+
+    BL_DEFINE_STATIC_MEMBER( BenchT, bl::os::mutex, g_lock );
+
+    BL_DEFINE_STATIC_MEMBER( BenchT, bl::json::Array, g_results );
+
+    BL_DEFINE_STATIC_MEMBER( BenchT, typename BenchT< TCLASS >::baseline_map_t, g_baseline );
+
+    BL_DEFINE_STATIC_MEMBER( BenchT, bool, g_baselineLoaded ) = false;
+
+    typedef BenchT<> Bench;
+
+} // test
+
+#endif /* __UTESTS_SHARED_BENCHUTILS_H_ */
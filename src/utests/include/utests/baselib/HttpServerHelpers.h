@@ -153,6 +153,146 @@ namespace utest
         >
         ServerBackendProcessingImplTest;
 
+        /**
+         * @brief Produces the content of a streamed response by refilling the same block, so
+         * the content can be much larger than any block which is allocated for it
+         *
+         * The byte at offset N of the content is ( N % 251 ) - i.e. a prime, so the pattern is
+         * not aligned to the block size and misplaced or repeated blocks are detected
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class TestStreamedContentT : public bl::om::ObjectDefaultBase
+        {
+            BL_DECLARE_OBJECT_IMPL( TestStreamedContentT )
+
+        public:
+
+            typedef TestStreamedContentT< E >                                           this_type;
+
+            enum : std::size_t
+            {
+                PATTERN_MODULO = 251U,
+            };
+
+        protected:
+
+            const std::uint64_t                                                         m_contentSize;
+            const bl::om::ObjPtr< bl::data::DataBlock >                                 m_block;
+            bl::cpp::ScalarTypeIniter< std::uint64_t >                                  m_offset;
+            bl::cpp::ScalarTypeIniter< std::size_t >                                    m_blocksProduced;
+
+            TestStreamedContentT(
+                SAA_in          const std::uint64_t                                     contentSize,
+                SAA_in          const std::size_t                                       blockSize
+                )
+                :
+                m_contentSize( contentSize ),
+                m_block( bl::data::DataBlock::createInstance( blockSize ) )
+            {
+            }
+
+            auto produceNextBlock() -> bl::om::ObjPtr< bl::data::DataBlock >
+            {
+                if( m_offset == m_contentSize )
+                {
+                    return nullptr;
+                }
+
+                const auto size = static_cast< std::size_t >(
+                    std::min< std::uint64_t >( m_block -> capacity(), m_contentSize - m_offset )
+                    );
+
+                auto* data = reinterpret_cast< unsigned char* >( m_block -> begin() );
+
+                for( std::size_t i = 0U; i < size; ++i )
+                {
+                    data[ i ] = static_cast< unsigned char >( ( m_offset + i ) % PATTERN_MODULO );
+                }
+
+                m_block -> setSize( size );
+
+                m_offset.lvalue() += size;
+                ++m_blocksProduced.lvalue();
+
+                return bl::om::copy( m_block );
+            }
+
+        public:
+
+            static bool isExpectedByte(
+                SAA_in          const std::uint64_t                                     offset,
+                SAA_in          const char                                              value
+                ) NOEXCEPT
+            {
+                return static_cast< unsigned char >( value ) == ( offset % PATTERN_MODULO );
+            }
+
+            auto blocksProduced() const NOEXCEPT -> std::size_t
+            {
+                return m_blocksProduced;
+            }
+
+            auto getProducer() -> Response::content_producer_t
+            {
+                return bl::cpp::bind(
+                    &this_type::produceNextBlock,
+                    bl::om::ObjPtrCopyable< this_type >::acquireRef( this )
+                    );
+            }
+        };
+
+        typedef bl::om::ObjectImpl< TestStreamedContentT<> > TestStreamedContent;
+
+        /**
+         * @brief A backend which responds to every request with a streamed response
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class TestStreamedBackendT :
+            public ServerBackendProcessingImplDefault< DummyBackendStateImpl, TestHttpServerProcessingTask >
+        {
+            BL_DECLARE_OBJECT_IMPL( TestStreamedBackendT )
+
+        protected:
+
+            const std::uint64_t                                                         m_contentSize;
+            const std::size_t                                                           m_blockSize;
+
+            TestStreamedBackendT(
+                SAA_in          const std::uint64_t                                     contentSize,
+                SAA_in          const std::size_t                                       blockSize
+                )
+                :
+                m_contentSize( contentSize ),
+                m_blockSize( blockSize )
+            {
+            }
+
+        public:
+
+            virtual bl::om::ObjPtr< Response > getResponse( SAA_in const bl::om::ObjPtr< Task >& task ) OVERRIDE
+            {
+                BL_UNUSED( task );
+
+                const auto content = TestStreamedContent::createInstance( m_contentSize, m_blockSize );
+
+                return Response::createInstance(
+                    HttpStatusCode::HTTP_SUCCESS_OK,
+                    content -> getProducer(),
+                    bl::cpp::copy( HttpHeader::g_contentTypeDefault )
+                    );
+            }
+        };
+
+        typedef bl::om::ObjectImpl< TestStreamedBackendT<> > TestStreamedBackend;
+
         template
         <
             typename E = void
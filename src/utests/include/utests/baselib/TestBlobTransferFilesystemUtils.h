@@ -76,12 +76,54 @@ namespace utest
 
         typedef TestBlobTransferUtils                                                               base_type;
         typedef base_type::CancelType                                                               CancelType;
+        typedef base_type::ChunkingMode                                                             ChunkingMode;
 
         static void filesPackagerTestsWrap(
             SAA_in                  const unsigned short                                                blobServerPort,
             SAA_in                  const bl::om::ObjPtrCopyable< FilesystemMetadataStore >&            metadataStore,
             SAA_in                  const CancelType                                                    cancelType
             )
+        {
+            filesPackagerWithChunkingTestsWrap(
+                blobServerPort,
+                metadataStore,
+                cancelType,
+                bl::transfer::FilesPackagerUnit::FixedSizeChunking,
+                false /* deduplicateChunks */
+                );
+        }
+
+        static void filesPackagerWithChunkingTestsWrap(
+            SAA_in                  const unsigned short                                                blobServerPort,
+            SAA_in                  const bl::om::ObjPtrCopyable< FilesystemMetadataStore >&            metadataStore,
+            SAA_in                  const CancelType                                                    cancelType,
+            SAA_in                  const ChunkingMode                                                  chunkingMode,
+            SAA_in                  const bool                                                          deduplicateChunks
+            )
+        {
+            filesPackagerTestsWrapInternal(
+                bl::cpp::bind(
+                    &executeFilesystemTransferTests,
+                    _1      /* cbTransferTest */,
+                    _2      /* controlToken */,
+                    _3      /* context */,
+                    _4      /* blobServerPort */,
+                    0U      /* threadsCount */,
+                    0U      /* maxConcurrentTasks */
+                    ),
+                blobServerPort,
+                metadataStore,
+                cancelType,
+                chunkingMode,
+                deduplicateChunks
+                );
+        }
+
+        static void filesPackagerAsyncFileIoTestsWrap(
+            SAA_in                  const unsigned short                                                blobServerPort,
+            SAA_in                  const bl::om::ObjPtrCopyable< FilesystemMetadataStore >&            metadataStore,
+            SAA_in                  const CancelType                                                    cancelType
+            )
         {
             filesPackagerTestsWrapInternal(
                 bl::cpp::bind(
@@ -95,7 +137,10 @@ namespace utest
                     ),
                 blobServerPort,
                 metadataStore,
-                cancelType
+                cancelType,
+                bl::transfer::FilesPackagerUnit::FixedSizeChunking,
+                false /* deduplicateChunks */,
+                true /* asyncFileIo */
                 );
         }
 
@@ -192,6 +192,7 @@ namespace utest
         };
 
         typedef bl::data::DataChunkStorage                                                      DataChunkStorage;
+        typedef bl::transfer::FilesPackagerUnit::ChunkingMode                                   ChunkingMode;
 
     protected:
 
@@ -225,7 +226,9 @@ namespace utest
             SAA_in_opt          const unsigned short                                            port = test::UtfArgsParser::PORT_DEFAULT,
             SAA_in_opt          const CancelType                                                cancelType = CancelType::NoCancel,
             SAA_in_opt          const bl::cpp::void_callback_t&                                 cancelCallback = bl::cpp::void_callback_t(),
-            SAA_in_opt          const bl::om::ObjPtr< bl::tasks::ExecutionQueue >&              executionQueue = nullptr
+            SAA_in_opt          const bl::om::ObjPtr< bl::tasks::ExecutionQueue >&              executionQueue = nullptr,
+            SAA_in_opt          const ChunkingMode                                              chunkingMode = bl::transfer::FilesPackagerUnit::FixedSizeChunking,
+            SAA_in_opt          const bool                                                      deduplicateChunks = false
             )
         {
             using namespace bl;
@@ -280,6 +283,8 @@ namespace utest
                 context = bl::transfer::SendRecvContext::createInstance(
                     SimpleEndpointSelectorImpl::createInstance< EndpointSelector >( cpp::copy( host ), port )
                     );
+
+                context -> fileIoService( om::copy( contextIn -> fileIoService() ) );
             }
 
             {
@@ -320,7 +325,12 @@ namespace utest
                                 true /* enableSharedPtr */
                             > unit_packager_t;
 
-                        const auto unitPackager = unit_packager_t::createInstance( context, fsmd );
+                        const auto unitPackager = unit_packager_t::createInstance(
+                            context,
+                            fsmd,
+                            chunkingMode,
+                            deduplicateChunks
+                            );
 
                         scanner -> subscribe(
                             unitPackager -> bindInputConnector< unit_packager_t >(
@@ -383,6 +393,35 @@ namespace utest
 
                         BL_ASSERT( fsmd -> isFinalized() );
 
+                        if( deduplicateChunks && CancelType::NoCancel == cancelType )
+                        {
+                            /*
+                             * The test directory has many files with the same content, so
+                             * some of the chunks must have been deduplicated
+                             */
+
+                            const auto fsmdRO = om::qi< FilesystemMetadataRO >( fsmd );
+                            const auto chunksIterator = fsmdRO -> queryAllChunks();
+
+                            std::size_t duplicateChunksCount = 0U;
+
+                            while( chunksIterator -> hasCurrent() )
+                            {
+                                const auto chunkInfo = fsmdRO -> loadChunkInfo( chunksIterator -> current() );
+
+                                UTF_REQUIRE( chunkInfo.hash );
+
+                                if( chunkInfo.isChunkDuplicate )
+                                {
+                                    ++duplicateChunksCount;
+                                }
+
+                                chunksIterator -> loadNext();
+                            }
+
+                            UTF_REQUIRE( duplicateChunksCount > 0U );
+                        }
+
                         artifactId = metadataStore -> saveArtifact( fsmd );
                     },
                     executionQueue
@@ -838,7 +877,10 @@ namespace utest
             SAA_in                  const execute_transfer_tests_callback_t&                            cbExecuteTests,
             SAA_in                  const unsigned short                                                blobServerPort,
             SAA_in                  const bl::om::ObjPtrCopyable< FilesystemMetadataStore >&            metadataStore,
-            SAA_in                  const CancelType                                                    cancelType
+            SAA_in                  const CancelType                                                    cancelType,
+            SAA_in_opt              const ChunkingMode                                                  chunkingMode = bl::transfer::FilesPackagerUnit::FixedSizeChunking,
+            SAA_in_opt              const bool                                                          deduplicateChunks = false,
+            SAA_in_opt              const bool                                                          asyncFileIo = false
             )
         {
             using namespace bl;
@@ -856,6 +898,15 @@ namespace utest
                     )
                 );
 
+            om::ObjPtrDisposable< AsyncFileIoService > fileIoService;
+
+            if( asyncFileIo )
+            {
+                fileIoService = om::lockDisposable( AsyncFileIoService::createInstance() );
+
+                context -> fileIoService( om::copy( fileIoService ) );
+            }
+
             BL_LOG(
                 Logging::debug(),
                 BL_MSG()
@@ -871,7 +922,9 @@ namespace utest
                 metadataStore,
                 test::UtfArgsParser::host(),
                 blobServerPort,
-                cancelType
+                cancelType,
+                chunkingMode,
+                deduplicateChunks
                 );
 
             cbExecuteTests(
@@ -931,7 +984,9 @@ namespace utest
                 metadataStore,
                 test::UtfArgsParser::host(),
                 blobServerPort,
-                CancelType::NoCancel
+                CancelType::NoCancel,
+                bl::transfer::FilesPackagerUnit::FixedSizeChunking,
+                false /* deduplicateChunks */
                 );
 
             const auto cbProxyTransferTests =
@@ -1203,7 +1258,9 @@ namespace utest
             SAA_in              const bl::om::ObjPtrCopyable< FilesystemMetadataStore >&        metadataStore,
             SAA_in_opt          const std::string&                                              host = "localhost",
             SAA_in_opt          const unsigned short                                            port = test::UtfArgsParser::PORT_DEFAULT,
-            SAA_in_opt          const CancelType                                                cancelType = CancelType::NoCancel
+            SAA_in_opt          const CancelType                                                cancelType = CancelType::NoCancel,
+            SAA_in_opt          const ChunkingMode                                              chunkingMode = bl::transfer::FilesPackagerUnit::FixedSizeChunking,
+            SAA_in_opt          const bool                                                      deduplicateChunks = false
             )
         {
             switch( cancelType )
@@ -1220,7 +1277,11 @@ namespace utest
                             metadataStore,
                             host,
                             port,
-                            CancelType::NoCancel
+                            CancelType::NoCancel,
+                            bl::cpp::void_callback_t() /* cancelCallback */,
+                            nullptr /* executionQueue */,
+                            chunkingMode,
+                            deduplicateChunks
                             );
                     }
                     break;
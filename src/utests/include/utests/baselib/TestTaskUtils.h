@@ -280,6 +280,18 @@ namespace utest
             data -> setSize( m_data -> size() );
         }
 
+        virtual auto tryLoadMapped(
+            SAA_in                  const bl::uuid_t&                               sessionId,
+            SAA_in                  const bl::uuid_t&                               chunkId
+            )
+            -> bl::om::ObjPtr< bl::data::DataBlock > OVERRIDE
+        {
+            BL_UNUSED( sessionId );
+            BL_UNUSED( chunkId );
+
+            return nullptr;
+        }
+
         virtual void save(
             SAA_in                  const bl::uuid_t&                               sessionId,
             SAA_in                  const bl::uuid_t&                               chunkId,
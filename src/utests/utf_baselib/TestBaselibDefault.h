@@ -1330,6 +1330,293 @@ UTF_AUTO_TEST_CASE( BaseLib_LoggingConcurrencyTests )
     UTF_MESSAGE( BL_MSG() << "********************* Logging concurrency tests end *********************" );
 }
 
+UTF_AUTO_TEST_CASE( BaseLib_LoggingAsyncModeTests )
+{
+    using bl::Logging;
+
+    bl::cpp::SafeOutputStringStream os;
+
+    const Logging::line_logger_t ll(
+            bl::cpp::bind( &Logging::defaultLineLoggerWithLock, _1, _2, _3, _4, true /*addNewLine */, bl::cpp::ref( os ) )
+            );
+
+    Logging::LineLoggerPusher pushLogger( ll );
+
+    Logging::LevelPusher pushLevel( Logging::LL_INFO, true /* global */ );
+
+    /*
+     * The message should not be formatted at all if the channel is disabled
+     */
+
+    std::size_t formatCount = 0U;
+
+    const auto format = [ & ]() -> std::size_t
+    {
+        return ++formatCount;
+    };
+
+    BL_LOG( Logging::debug(), BL_MSG() << "Not formatted " << format() );
+    UTF_CHECK_EQUAL( formatCount, 0U );
+
+    BL_LOG( Logging::info(), BL_MSG() << "Formatted " << format() );
+    UTF_CHECK_EQUAL( formatCount, 1U );
+
+    UTF_CHECK( ! Logging::isAsyncModeEnabled() );
+
+    const std::size_t threadsCount = 4U;
+    const std::size_t messagesCount = 1000U;
+
+    {
+        /*
+         * Use a small queue to exercise the back pressure
+         */
+
+        Logging::AsyncModePusher pushAsyncMode( 64U /* queueCapacity */ );
+
+        UTF_CHECK( Logging::isAsyncModeEnabled() );
+
+        UTF_CHECK_THROW( Logging::enableAsyncMode(), bl::UnexpectedException );
+
+        UTF_CHECK_THROW( Logging::enableAsyncMode( 100U /* queueCapacity */ ), bl::ArgumentException );
+
+        std::vector< bl::cpp::SafeUniquePtr< bl::os::thread > > threads;
+
+        for( std::size_t i = 0U; i < threadsCount; ++i )
+        {
+            threads.push_back(
+                bl::cpp::SafeUniquePtr< bl::os::thread >::attach(
+                    new bl::os::thread(
+                        [ = ]() -> void
+                        {
+                            for( std::size_t j = 0U; j < messagesCount; ++j )
+                            {
+                                if( 0U == ( j % 10U ) )
+                                {
+                                    BL_LOG_MULTILINE(
+                                        Logging::info(),
+                                        BL_MSG()
+                                            << "Thread "
+                                            << i
+                                            << " message "
+                                            << j
+                                            << "\nThread "
+                                            << i
+                                            << " continuation "
+                                            << j
+                                        );
+                                }
+                                else
+                                {
+                                    BL_LOG(
+                                        Logging::info(),
+                                        BL_MSG()
+                                            << "Thread "
+                                            << i
+                                            << " message "
+                                            << j
+                                        );
+                                }
+                            }
+                        }
+                        )
+                    )
+                );
+        }
+
+        for( auto& thread : threads )
+        {
+            thread -> join();
+        }
+    }
+
+    UTF_CHECK( ! Logging::isAsyncModeEnabled() );
+
+    /*
+     * All messages must be written in order for each thread and the lines of
+     * the multi-line messages must be kept together
+     */
+
+    bl::cpp::SafeInputStringStream is( os.str() );
+
+    std::string line;
+
+    std::getline( is, line );
+    UTF_CHECK_EQUAL( line, "INFO: Formatted 1" );
+
+    std::vector< std::size_t > nextMessage( threadsCount, 0U );
+    std::size_t linesCount = 0U;
+
+    for( ;; )
+    {
+        std::getline( is, line );
+
+        if( line.empty() )
+        {
+            UTF_REQUIRE( is.eof() );
+            break;
+        }
+
+        ++linesCount;
+
+        std::size_t i = 0U;
+        std::size_t j = 0U;
+
+        UTF_REQUIRE( 2 == std::sscanf( line.c_str(), "INFO: Thread %zu message %zu", &i, &j ) );
+        UTF_REQUIRE( i < threadsCount );
+        UTF_REQUIRE_EQUAL( j, nextMessage[ i ] );
+
+        ++nextMessage[ i ];
+
+        if( 0U == ( j % 10U ) )
+        {
+            std::getline( is, line );
+            UTF_REQUIRE_EQUAL( line, bl::resolveMessage( BL_MSG() << "INFO: Thread " << i << " continuation " << j ) );
+        }
+    }
+
+    UTF_CHECK_EQUAL( linesCount, threadsCount * messagesCount );
+
+    /*
+     * With the drop policy the info messages can be dropped, but the warnings
+     * never are
+     */
+
+    os.str( "" );
+
+    {
+        Logging::AsyncModePusher pushAsyncMode( 2U /* queueCapacity */, Logging::OVERFLOW_DROP, 1000U /* flushIntervalInMilliseconds */ );
+
+        for( std::size_t j = 0U; j < 100U; ++j )
+        {
+            BL_LOG( Logging::info(), BL_MSG() << "Info " << j );
+            BL_LOG( Logging::warning(), BL_MSG() << "Warning " << j );
+        }
+    }
+
+    std::size_t warningsCount = 0U;
+    std::size_t infoCount = 0U;
+    std::size_t droppedCount = 0U;
+
+    bl::cpp::SafeInputStringStream isDrop( os.str() );
+
+    while( std::getline( isDrop, line ) )
+    {
+        std::size_t count = 0U;
+
+        if( 0U == line.find( "WARNING: Warning " ) )
+        {
+            ++warningsCount;
+        }
+        else if( 0U == line.find( "INFO: Info " ) )
+        {
+            ++infoCount;
+        }
+        else if( 1 == std::sscanf( line.c_str(), "WARNING: %zu log message(s) were dropped", &count ) )
+        {
+            droppedCount += count;
+        }
+        else
+        {
+            UTF_FAIL( BL_MSG() << "Unexpected log line: " << line );
+        }
+    }
+
+    UTF_CHECK_EQUAL( warningsCount, 100U );
+    UTF_CHECK( droppedCount > 0U );
+    UTF_CHECK_EQUAL( infoCount + droppedCount, 100U );
+
+    /*
+     * A line logger which logs itself (more than the queue capacity) and fails must
+     * neither deadlock nor stop the flusher thread; the nested records are written
+     * synchronously and the failure is reported
+     */
+
+    os.str( "" );
+
+    {
+        /*
+         * The line logger is always invoked with the logging lock held
+         */
+
+        std::size_t failuresCount = 0U;
+
+        const Logging::line_logger_t failingLogger(
+            [ & ](
+                SAA_in      const std::string&          prefix,
+                SAA_in      const std::string&          text,
+                SAA_in      const bool                  enableTimestamp,
+                SAA_in      const Logging::Level        level
+                ) -> void
+            {
+                if( 0U == text.find( "Fail " ) )
+                {
+                    for( std::size_t k = 0U; k < 4U; ++k )
+                    {
+                        BL_LOG( Logging::warning(), BL_MSG() << "Nested " << text << " " << k );
+                    }
+
+                    if( 1U == ++failuresCount )
+                    {
+                        BL_THROW( bl::UnexpectedException(), BL_MSG() << "Write error" );
+                    }
+                }
+
+                ll( prefix, text, enableTimestamp, level );
+            }
+            );
+
+        Logging::LineLoggerPusher pushFailingLogger( failingLogger );
+
+        Logging::AsyncModePusher pushAsyncMode( 2U /* queueCapacity */, Logging::OVERFLOW_BLOCK, 1000U /* flushIntervalInMilliseconds */ );
+
+        for( std::size_t j = 0U; j < 100U; ++j )
+        {
+            BL_LOG( Logging::info(), BL_MSG() << "Message " << j );
+
+            if( 0U == ( j % 10U ) )
+            {
+                BL_LOG( Logging::info(), BL_MSG() << "Fail " << j );
+            }
+        }
+    }
+
+    std::size_t messagesLinesCount = 0U;
+    std::size_t failLinesCount = 0U;
+    std::size_t nestedLinesCount = 0U;
+    std::size_t failureReportsCount = 0U;
+
+    bl::cpp::SafeInputStringStream isFailing( os.str() );
+
+    while( std::getline( isFailing, line ) )
+    {
+        if( 0U == line.find( "INFO: Message " ) )
+        {
+            ++messagesLinesCount;
+        }
+        else if( 0U == line.find( "INFO: Fail " ) )
+        {
+            ++failLinesCount;
+        }
+        else if( 0U == line.find( "WARNING: Nested Fail " ) )
+        {
+            ++nestedLinesCount;
+        }
+        else if( 0U == line.find( "WARNING: Flushing of the async logging queues has failed: Write error" ) )
+        {
+            ++failureReportsCount;
+        }
+        else
+        {
+            UTF_FAIL( BL_MSG() << "Unexpected log line: " << line );
+        }
+    }
+
+    UTF_CHECK_EQUAL( messagesLinesCount, 100U );
+    UTF_CHECK_EQUAL( failLinesCount, 9U );
+    UTF_CHECK_EQUAL( nestedLinesCount, 40U );
+    UTF_CHECK_EQUAL( failureReportsCount, 1U );
+}
+
 /************************************************************************
  * ThreadPool tests
  */
@@ -1385,6 +1672,264 @@ UTF_AUTO_TEST_CASE( BaseLib_ThreadPoolTests )
     }
 }
 
+namespace
+{
+    bl::time::time_duration threadPoolShortTasksRun(
+        SAA_in          const bl::om::ObjPtr< bl::ThreadPool >&     tp,
+        SAA_in          const std::size_t                           tasksCount,
+        SAA_in_opt      const std::size_t                           maxExecuting = 0U
+        )
+    {
+        std::atomic< std::size_t > executed( 0U );
+        std::atomic< std::size_t > executing( 0U );
+        std::atomic< std::size_t > maxExecutingSeen( 0U );
+
+        const auto eq = bl::om::lockDisposable(
+            bl::tasks::ExecutionQueueImpl::createInstance< bl::tasks::ExecutionQueue >(
+                bl::tasks::ExecutionQueue::OptionKeepNone
+                )
+            );
+
+        eq -> setLocalThreadPool( tp.get() );
+        eq -> setThrottleLimit( maxExecuting );
+
+        const auto t1 = bl::time::microsec_clock::universal_time();
+
+        for( std::size_t i = 0; i < tasksCount; ++i )
+        {
+            eq -> push_back(
+                [ & ]() -> void
+                {
+                    const auto current = ++executing;
+
+                    auto seen = maxExecutingSeen.load();
+
+                    while( current > seen && ! maxExecutingSeen.compare_exchange_weak( seen, current ) )
+                    {
+                    }
+
+                    ++executed;
+                    --executing;
+                }
+                );
+        }
+
+        eq -> flush();
+
+        const auto duration = bl::time::microsec_clock::universal_time() - t1;
+
+        UTF_REQUIRE_EQUAL( executed.load(), tasksCount );
+
+        if( maxExecuting )
+        {
+            UTF_REQUIRE( maxExecutingSeen.load() <= maxExecuting );
+        }
+
+        return duration;
+    }
+}
+
+UTF_AUTO_TEST_CASE( BaseLib_ThreadPoolWorkStealingTests )
+{
+    const auto tp = bl::om::lockDisposable(
+        bl::ThreadPoolImpl::createInstance< bl::ThreadPool >(
+            bl::os::getAbstractPriorityDefault(),
+            8U /* threadsCount */,
+            false /* abortIfUnhandled */,
+            bl::eh::eh_callback_t(),
+            true /* workStealing */
+            )
+        );
+
+    UTF_CHECK_EQUAL( tp -> size(), 8U );
+    UTF_CHECK_EQUAL( tp -> resize( 12 ), 12U );
+
+    /*
+     * Post callbacks from both a non thread pool thread and from the thread pool
+     * threads themselves (the latter go on the local deques)
+     */
+
+    {
+        const std::size_t count = 1000U;
+
+        std::atomic< std::size_t > executed( 0U );
+
+        bl::os::mutex lock;
+        bl::os::condition_variable cv;
+
+        const auto notifyIfDone = [ & ]() -> void
+        {
+            if( 2U * count == ++executed )
+            {
+                BL_MUTEX_GUARD( lock );
+                cv.notify_one();
+            }
+        };
+
+        for( std::size_t i = 0; i < count; ++i )
+        {
+            tp -> post(
+                [ & ]() -> void
+                {
+                    tp -> post( notifyIfDone );
+
+                    notifyIfDone();
+                }
+                );
+        }
+
+        bl::os::mutex_unique_lock guard( lock );
+
+        cv.wait( guard, [ & ]() -> bool { return 2U * count == executed; } );
+    }
+
+    /*
+     * The I/O service handlers (e.g. timers) must not be starved while the deques
+     * are never empty - a callback which keeps re-posting itself keeps a single
+     * threaded thread pool busy until the timer has fired
+     */
+
+    {
+        std::atomic< bool > timerFired( false );
+
+        bl::cpp::void_callback_t busyCallback;
+
+        const auto tpSingle = bl::om::lockDisposable(
+            bl::ThreadPoolImpl::createInstance< bl::ThreadPool >(
+                bl::os::getAbstractPriorityDefault(),
+                1U /* threadsCount */,
+                false /* abortIfUnhandled */,
+                bl::eh::eh_callback_t(),
+                true /* workStealing */
+                )
+            );
+
+        busyCallback = [ & ]() -> void
+        {
+            if( ! timerFired )
+            {
+                tpSingle -> post( bl::cpp::copy( busyCallback ) );
+            }
+        };
+
+        tpSingle -> post( bl::cpp::copy( busyCallback ) );
+
+        bl::asio::deadline_timer timer( tpSingle -> aioService(), bl::time::milliseconds( 10 ) );
+
+        timer.async_wait(
+            [ & ]( SAA_in const bl::eh::error_code& ec ) -> void
+            {
+                BL_UNUSED( ec );
+
+                timerFired = true;
+            }
+            );
+
+        const auto deadline = bl::time::microsec_clock::universal_time() + bl::time::seconds( 10 );
+
+        while( ! timerFired && bl::time::microsec_clock::universal_time() < deadline )
+        {
+            bl::os::sleep( bl::time::milliseconds( 10 ) );
+        }
+
+        const bool wasTimerFired = timerFired;
+
+        timerFired = true;
+
+        UTF_REQUIRE( wasTimerFired );
+    }
+
+    /*
+     * While one thread is kept busy (and polls the I/O service between its callbacks)
+     * the callbacks posted from outside must still be executed by the idle thread, i.e.
+     * the wake ups meant for the idle thread must not be lost by the busy one
+     */
+
+    {
+        std::atomic< bool > stopBusy( false );
+        std::atomic< std::size_t > executed( 0U );
+
+        bl::cpp::void_callback_t busyCallback;
+
+        const auto tpPair = bl::om::lockDisposable(
+            bl::ThreadPoolImpl::createInstance< bl::ThreadPool >(
+                bl::os::getAbstractPriorityDefault(),
+                2U /* threadsCount */,
+                false /* abortIfUnhandled */,
+                bl::eh::eh_callback_t(),
+                true /* workStealing */
+                )
+            );
+
+        busyCallback = [ & ]() -> void
+        {
+            if( ! stopBusy )
+            {
+                tpPair -> post( bl::cpp::copy( busyCallback ) );
+            }
+        };
+
+        tpPair -> post( bl::cpp::copy( busyCallback ) );
+
+        const std::size_t count = 1000U;
+
+        for( std::size_t i = 0U; i < count; ++i )
+        {
+            tpPair -> post(
+                [ & ]() -> void
+                {
+                    ++executed;
+                }
+                );
+
+            if( 0U == i % 100U )
+            {
+                bl::os::sleep( bl::time::milliseconds( 1 ) );
+            }
+        }
+
+        const auto deadline = bl::time::microsec_clock::universal_time() + bl::time::seconds( 10 );
+
+        while( executed < count && bl::time::microsec_clock::universal_time() < deadline )
+        {
+            bl::os::sleep( bl::time::milliseconds( 10 ) );
+        }
+
+        const std::size_t executedCount = executed;
+
+        stopBusy = true;
+
+        UTF_REQUIRE_EQUAL( executedCount, count );
+    }
+
+    /*
+     * The execution queue semantics (including the throttling) must be preserved
+     * and compare the performance vs. the I/O service based dispatching
+     */
+
+    const auto tpDefault = bl::om::lockDisposable(
+        bl::ThreadPoolImpl::createInstance< bl::ThreadPool >( bl::os::getAbstractPriorityDefault(), 12U )
+        );
+
+    UTF_REQUIRE( threadPoolShortTasksRun( tp, 1000U, 2U /* maxExecuting */ ) < bl::time::seconds( 60 ) );
+
+    const std::size_t tasksCount = 100000U;
+
+    const auto durationDefault = threadPoolShortTasksRun( tpDefault, tasksCount );
+    const auto durationWorkStealing = threadPoolShortTasksRun( tp, tasksCount );
+
+    UTF_MESSAGE(
+        BL_MSG()
+            << "Executing "
+            << tasksCount
+            << " short tasks took "
+            << durationDefault
+            << " with the default scheduler and "
+            << durationWorkStealing
+            << " with the work stealing scheduler"
+        );
+}
+
 /************************************************************************
  * os::< shared library support > tests
  */
@@ -2522,92 +3067,269 @@ UTF_AUTO_TEST_CASE( BaseLib_OSLongFileNamesAppVerifCrashTests )
 
     const std::string lfnTest2( lfnTest1 );
 
-    const bl::fs::path path1( lfnTest1 );
-    UTF_REQUIRE( ! path1.empty() );
+    const bl::fs::path path1( lfnTest1 );
+    UTF_REQUIRE( ! path1.empty() );
+
+    const bl::fs::path path2( lfnTest2 );
+    UTF_REQUIRE_EQUAL( path1, path2 );
+
+    bl::fs::path path3;
+    path3 = lfnTest1;
+    UTF_REQUIRE_EQUAL( path1, path3 );
+
+    bl::fs::path path4;
+    path4 = lfnTest2;
+    UTF_REQUIRE_EQUAL( path1, path4 );
+}
+
+UTF_AUTO_TEST_CASE( BaseLib_OSDeletePathTests )
+{
+    const auto& path = test::UtfArgsParser::path();
+
+    if( path.empty() )
+    {
+        /*
+         * Path parameter is required
+         */
+
+        return;
+    }
+
+    UTF_MESSAGE(
+        BL_MSG()
+            << "Deleting path "
+            << path
+            );
+
+    bl::fs::safeRemoveAll( path );
+}
+
+/************************************************************************
+ * os::< stdio std::FILE* operations and large file support > tests
+ */
+
+UTF_AUTO_TEST_CASE( BaseLib_OSLargeFileSupportTests )
+{
+    bl::fs::TmpDir tmpDir;
+
+    const auto& tmpPath = tmpDir.path();
+
+    const auto largeFilePath = tmpPath / "large_file.bin";
+
+    const unsigned char pattern[] = { 1, 2, 3, 4, 5 };
+    unsigned char buffer[ BL_ARRAY_SIZE( pattern ) ];
+
+    ::memset( buffer, 0, BL_ARRAY_SIZE( buffer ) );
+
+    std::uint64_t pos = 0;
+
+    /*
+     * Seek at 5 GB and write something then read it later
+     */
+
+    pos += 1024U * 1024U;
+    pos *= 1024U;
+    pos *= 5U;
+
+    {
+        const auto fileptr = bl::os::fopen( largeFilePath, "wb" );
+        bl::os::fseek( fileptr, pos, SEEK_SET );
+        bl::os::fwrite( fileptr, pattern, BL_ARRAY_SIZE( pattern ) );
+
+        const auto newPos = bl::os::ftell( fileptr );
+        UTF_REQUIRE_EQUAL( ( pos + BL_ARRAY_SIZE( pattern ) ), newPos );
+    }
+
+    {
+        const auto fileptr = bl::os::fopen( largeFilePath, "rb" );
+        bl::os::fseek( fileptr, pos, SEEK_SET );
+        bl::os::fread( fileptr, buffer, BL_ARRAY_SIZE( buffer ) );
+
+        static_assert(
+            BL_ARRAY_SIZE( buffer ) == BL_ARRAY_SIZE( pattern ),
+            "Buffer and pattern must have the same size"
+            );
+        UTF_REQUIRE( 0 == ::memcmp( buffer, pattern, BL_ARRAY_SIZE( buffer ) ) );
+
+        const auto newPos = bl::os::ftell( fileptr );
+        UTF_REQUIRE( ( pos + BL_ARRAY_SIZE( buffer ) ) == newPos );
+    }
+}
+
+/************************************************************************
+ * os::< fpread() / fpwrite() / fpreallocate() > tests
+ */
+
+UTF_AUTO_TEST_CASE( BaseLib_OSPositionalReadWriteTests )
+{
+    bl::fs::TmpDir tmpDir;
+
+    const auto& tmpPath = tmpDir.path();
+
+    const auto makeBlock = []( SAA_in const std::size_t index, SAA_in const std::size_t blockSize )
+        -> std::vector< unsigned char >
+    {
+        std::vector< unsigned char > block( blockSize );
+
+        for( std::size_t i = 0; i < blockSize; ++i )
+        {
+            block[ i ] = static_cast< unsigned char >( ( index * 31U + i ) % 251U );
+        }
+
+        return block;
+    };
+
+    {
+        /*
+         * Write blocks at their offsets out of order and leaving a gap and then verify the
+         * file position isn't moved and read everything back at the same offsets
+         */
+
+        const auto filePath = tmpPath / "offsets.bin";
+
+        const std::size_t blockSize = 1000U;
+
+        const auto fileptr = bl::os::fopen( filePath, "w+b" );
+
+        const std::size_t order[] = { 3U, 0U, 5U, 1U, 2U };
+
+        for( const auto index : order )
+        {
+            const auto block = makeBlock( index, blockSize );
+
+            bl::os::fpwrite( fileptr, index * blockSize, block.data(), block.size() );
+
+            UTF_REQUIRE_EQUAL( 0U, bl::os::ftell( fileptr ) );
+        }
+
+        UTF_REQUIRE_EQUAL( 6U * blockSize, bl::fs::file_size( filePath ) );
+
+        std::vector< unsigned char > buffer( blockSize );
+
+        for( const auto index : order )
+        {
+            bl::os::fpread( fileptr, index * blockSize, buffer.data(), buffer.size() );
+
+            UTF_REQUIRE( makeBlock( index, blockSize ) == buffer );
+        }
+
+        /*
+         * The gap (block #4) must read back as zeros and reading past the end of file must fail
+         */
+
+        bl::os::fpread( fileptr, 4U * blockSize, buffer.data(), buffer.size() );
+
+        UTF_REQUIRE( std::vector< unsigned char >( blockSize ) == buffer );
+
+        UTF_REQUIRE_THROW( bl::os::fpread( fileptr, 5U * blockSize + 1U, buffer.data(), buffer.size() ), std::exception );
+
+        /*
+         * Overwrite a block partially in the middle
+         */
+
+        const auto patch = makeBlock( 100U, blockSize / 2U );
 
-    const bl::fs::path path2( lfnTest2 );
-    UTF_REQUIRE_EQUAL( path1, path2 );
+        bl::os::fpwrite( fileptr, blockSize + blockSize / 4U, patch.data(), patch.size() );
 
-    bl::fs::path path3;
-    path3 = lfnTest1;
-    UTF_REQUIRE_EQUAL( path1, path3 );
+        bl::os::fpread( fileptr, blockSize, buffer.data(), buffer.size() );
 
-    bl::fs::path path4;
-    path4 = lfnTest2;
-    UTF_REQUIRE_EQUAL( path1, path4 );
-}
+        auto expected = makeBlock( 1U, blockSize );
+        std::copy( patch.begin(), patch.end(), expected.begin() + blockSize / 4U );
 
-UTF_AUTO_TEST_CASE( BaseLib_OSDeletePathTests )
-{
-    const auto& path = test::UtfArgsParser::path();
+        UTF_REQUIRE( expected == buffer );
+    }
 
-    if( path.empty() )
     {
         /*
-         * Path parameter is required
+         * Preallocate the file and then write its blocks concurrently from multiple threads
+         * (similar to how the unpackager writes the chunks of a large file)
          */
 
-        return;
-    }
+        const auto filePath = tmpPath / "concurrent.bin";
 
-    UTF_MESSAGE(
-        BL_MSG()
-            << "Deleting path "
-            << path
-            );
+        const std::size_t blockSize = 64U * 1024U + 17U;
+        const std::size_t blocksCount = 64U;
+        const std::size_t threadsCount = 8U;
+        const std::uint64_t fileSize = blockSize * blocksCount;
 
-    bl::fs::safeRemoveAll( path );
-}
+        {
+            const auto fileptr = bl::os::fopen( filePath, "wb" );
 
-/************************************************************************
- * os::< stdio std::FILE* operations and large file support > tests
- */
+            bl::os::fpreallocate( fileptr, fileSize );
 
-UTF_AUTO_TEST_CASE( BaseLib_OSLargeFileSupportTests )
-{
-    bl::fs::TmpDir tmpDir;
+            /*
+             * If preallocation isn't supported by the file system it is a no-op, but
+             * when it is done the file must be extended to the requested size
+             */
 
-    const auto& tmpPath = tmpDir.path();
+            const auto sizeAfterPreallocate = bl::fs::file_size( filePath );
 
-    const auto largeFilePath = tmpPath / "large_file.bin";
+            UTF_REQUIRE( 0U == sizeAfterPreallocate || fileSize == sizeAfterPreallocate );
 
-    const unsigned char pattern[] = { 1, 2, 3, 4, 5 };
-    unsigned char buffer[ BL_ARRAY_SIZE( pattern ) ];
+            UTF_MESSAGE(
+                BL_MSG()
+                    << "File size after preallocation: "
+                    << sizeAfterPreallocate
+                );
 
-    ::memset( buffer, 0, BL_ARRAY_SIZE( buffer ) );
+            std::atomic< std::size_t > nextBlock( 0U );
 
-    std::uint64_t pos = 0;
+            std::vector< bl::os::thread > threads;
 
-    /*
-     * Seek at 5 GB and write something then read it later
-     */
+            for( std::size_t i = 0; i < threadsCount; ++i )
+            {
+                threads.push_back(
+                    bl::os::thread( [ & ]() -> void
+                        {
+                            for( ;; )
+                            {
+                                const auto index = nextBlock++;
 
-    pos += 1024U * 1024U;
-    pos *= 1024U;
-    pos *= 5U;
+                                if( index >= blocksCount )
+                                {
+                                    break;
+                                }
 
-    {
-        const auto fileptr = bl::os::fopen( largeFilePath, "wb" );
-        bl::os::fseek( fileptr, pos, SEEK_SET );
-        bl::os::fwrite( fileptr, pattern, BL_ARRAY_SIZE( pattern ) );
+                                /*
+                                 * Write the blocks in reverse order, so the file is not
+                                 * extended sequentially
+                                 */
 
-        const auto newPos = bl::os::ftell( fileptr );
-        UTF_REQUIRE_EQUAL( ( pos + BL_ARRAY_SIZE( pattern ) ), newPos );
-    }
+                                const auto blockIndex = blocksCount - 1U - index;
 
-    {
-        const auto fileptr = bl::os::fopen( largeFilePath, "rb" );
-        bl::os::fseek( fileptr, pos, SEEK_SET );
-        bl::os::fread( fileptr, buffer, BL_ARRAY_SIZE( buffer ) );
+                                const auto block = makeBlock( blockIndex, blockSize );
 
-        static_assert(
-            BL_ARRAY_SIZE( buffer ) == BL_ARRAY_SIZE( pattern ),
-            "Buffer and pattern must have the same size"
-            );
-        UTF_REQUIRE( 0 == ::memcmp( buffer, pattern, BL_ARRAY_SIZE( buffer ) ) );
+                                bl::os::fpwrite( fileptr, blockIndex * blockSize, block.data(), block.size() );
+                            }
+                        })
+                    );
+            }
 
-        const auto newPos = bl::os::ftell( fileptr );
-        UTF_REQUIRE( ( pos + BL_ARRAY_SIZE( buffer ) ) == newPos );
+            for( auto& thread : threads )
+            {
+                thread.join();
+            }
+
+            /*
+             * Preallocating a size smaller than the file or zero size must not truncate it
+             */
+
+            bl::os::fpreallocate( fileptr, blockSize );
+            bl::os::fpreallocate( fileptr, 0U );
+        }
+
+        UTF_REQUIRE_EQUAL( fileSize, bl::fs::file_size( filePath ) );
+
+        const auto fileptr = bl::os::fopen( filePath, "rb" );
+
+        std::vector< unsigned char > buffer( blockSize );
+
+        for( std::size_t i = 0; i < blocksCount; ++i )
+        {
+            bl::os::fpread( fileptr, i * blockSize, buffer.data(), buffer.size() );
+
+            UTF_REQUIRE( makeBlock( i, blockSize ) == buffer );
+        }
     }
 }
 
@@ -3324,6 +4046,230 @@ UTF_AUTO_TEST_CASE( BaseLib_DataBlockTests )
     }
 }
 
+UTF_AUTO_TEST_CASE( BaseLib_DataBlocksPoolSizeClassesTests )
+{
+    using bl::data::DataBlock;
+    using bl::data::datablocks_pool_type;
+
+    UTF_CHECK_EQUAL( DataBlock::capacityForSize( 0U ), 512U );
+    UTF_CHECK_EQUAL( DataBlock::capacityForSize( 1U ), 512U );
+    UTF_CHECK_EQUAL( DataBlock::capacityForSize( 512U ), 512U );
+    UTF_CHECK_EQUAL( DataBlock::capacityForSize( 513U ), 1024U );
+    UTF_CHECK_EQUAL( DataBlock::capacityForSize( 4096U ), 4096U );
+    UTF_CHECK_EQUAL( DataBlock::capacityForSize( 5000U ), 8192U );
+    UTF_CHECK_EQUAL( DataBlock::capacityForSize( DataBlock::defaultCapacity() ), DataBlock::defaultCapacity() );
+    UTF_CHECK_EQUAL( DataBlock::capacityForSize( DataBlock::defaultCapacity() + 1U ), DataBlock::defaultCapacity() + 1U );
+
+    UTF_CHECK( datablocks_pool_type::isSizeClass( 512U ) );
+    UTF_CHECK( datablocks_pool_type::isSizeClass( DataBlock::defaultCapacity() ) );
+    UTF_CHECK( ! datablocks_pool_type::isSizeClass( 1234U ) );
+
+    const auto pool = datablocks_pool_type::createInstance( "[test pool]" );
+
+    /*
+     * Blocks are handed out and returned to the respective size class
+     */
+
+    auto small = DataBlock::getForSize( pool, 300U );
+    UTF_REQUIRE_EQUAL( small -> capacity(), 512U );
+
+    const auto* smallPtr = small.get();
+    pool -> put( std::move( small ) );
+
+    UTF_REQUIRE( ! pool -> tryGet( 1024U ) );
+
+    const auto smallAgain = DataBlock::getForSize( pool, 400U );
+    UTF_REQUIRE( smallAgain.get() == smallPtr );
+    UTF_REQUIRE_EQUAL( smallAgain -> size(), 0U );
+
+    const auto large = DataBlock::get( pool );
+    UTF_REQUIRE_EQUAL( large -> capacity(), DataBlock::defaultCapacity() );
+
+    /*
+     * Blocks which capacity is not a size class are not pooled
+     */
+
+    pool -> put( DataBlock::createInstance( 1234U ) );
+    UTF_REQUIRE( ! pool -> tryGet( 1234U ) );
+
+    /*
+     * Copies are taken from the smallest size class which fits the data
+     */
+
+    large -> setSize( 1000U );
+
+    for( std::size_t i = 0U; i < large -> size(); ++i )
+    {
+        large -> begin()[ i ] = static_cast< char >( i );
+    }
+
+    large -> setOffset1( 10U );
+
+    const auto copy = DataBlock::copy( large, pool );
+
+    UTF_REQUIRE_EQUAL( copy -> capacity(), 1024U );
+    UTF_REQUIRE_EQUAL( copy -> size(), large -> size() );
+    UTF_REQUIRE_EQUAL( copy -> offset1(), large -> offset1() );
+    UTF_REQUIRE_EQUAL( 0, std::memcmp( copy -> begin(), large -> begin(), large -> size() ) );
+
+    /*
+     * Growing a block preserves the data and rounds up the capacity to a size class
+     */
+
+    copy -> reserve( 3000U );
+
+    UTF_REQUIRE_EQUAL( copy -> capacity(), 4096U );
+    UTF_REQUIRE_EQUAL( copy -> size(), large -> size() );
+    UTF_REQUIRE_EQUAL( copy -> offset1(), large -> offset1() );
+    UTF_REQUIRE_EQUAL( 0, std::memcmp( copy -> begin(), large -> begin(), large -> size() ) );
+
+    copy -> reserve( 100U );
+    UTF_REQUIRE_EQUAL( copy -> capacity(), 4096U );
+
+    copy -> reserve( DataBlock::defaultCapacity() + 1U );
+    UTF_REQUIRE_EQUAL( copy -> capacity(), DataBlock::defaultCapacity() + 1U );
+    UTF_REQUIRE_EQUAL( 0, std::memcmp( copy -> begin(), large -> begin(), large -> size() ) );
+}
+
+/************************************************************************
+ * Pool.h tests
+ */
+
+namespace
+{
+    template
+    <
+        typename POOL
+    >
+    bl::time::time_duration poolContentionRun(
+        SAA_in          const bl::om::ObjPtr< POOL >&               pool,
+        SAA_in          const std::size_t                           threadsCount,
+        SAA_in          const std::size_t                           iterations
+        )
+    {
+        const auto t1 = bl::time::microsec_clock::universal_time();
+
+        std::vector< bl::os::thread > threads;
+
+        for( std::size_t i = 0; i < threadsCount; ++i )
+        {
+            threads.push_back(
+                bl::os::thread( [ & ]() -> void
+                    {
+                        for( std::size_t j = 0; j < iterations; ++j )
+                        {
+                            auto block = pool -> tryGet();
+
+                            if( ! block )
+                            {
+                                block = bl::data::DataBlock::createInstance( 64U /* capacity */ );
+                            }
+
+                            block -> setSize( j % block -> capacity() );
+
+                            pool -> put( std::move( block ) );
+                        }
+                    })
+                );
+        }
+
+        for( auto& thread : threads )
+        {
+            thread.join();
+        }
+
+        return bl::time::microsec_clock::universal_time() - t1;
+    }
+}
+
+UTF_AUTO_TEST_CASE( BaseLib_LockFreePoolTests )
+{
+    typedef bl::om::ObjectImpl< bl::LockFreePool< bl::om::ObjPtr< bl::data::DataBlock > > > pool_t;
+
+    const auto pool = pool_t::createInstance( "[test pool]", 2U /* capacity */ );
+
+    UTF_REQUIRE_EQUAL( pool -> capacity(), 2U );
+    UTF_REQUIRE( ! pool -> tryGet() );
+
+    const auto b1 = bl::data::DataBlock::createInstance( 16U );
+    const auto b2 = bl::data::DataBlock::createInstance( 16U );
+    const auto b3 = bl::data::DataBlock::createInstance( 16U );
+
+    pool -> put( bl::om::copy( b1 ) );
+    pool -> put( bl::om::copy( b2 ) );
+
+    /*
+     * The pool is full at this point, so the last one will be dropped
+     */
+
+    pool -> put( bl::om::copy( b3 ) );
+
+    /*
+     * The pool is LIFO, so the most recently returned block is handed out first
+     */
+
+    auto value = pool -> tryGet();
+    UTF_REQUIRE( value.get() == b2.get() );
+    UTF_REQUIRE( ! value -> freed() );
+
+    value = pool -> tryGet();
+    UTF_REQUIRE( value.get() == b1.get() );
+
+    UTF_REQUIRE( ! pool -> tryGet() );
+
+    pool -> put( std::move( value ) );
+    UTF_REQUIRE( b1 -> freed() );
+    UTF_REQUIRE( pool -> tryGet().get() == b1.get() );
+
+    UTF_CHECK_THROW( pool_t::createInstance( "[test pool]", 0U /* capacity */ ), bl::ArgumentException );
+}
+
+UTF_AUTO_TEST_CASE( BaseLib_PoolContentionPerformanceTests )
+{
+    /*
+     * Compare the lock based SimplePool vs. the LockFreePool under contention
+     */
+
+    typedef bl::om::ObjPtr< bl::data::DataBlock >                                   block_ptr_t;
+    typedef bl::om::ObjectImpl< bl::SimplePool< block_ptr_t > >                     simple_pool_t;
+    typedef bl::om::ObjectImpl< bl::LockFreePool< block_ptr_t > >                   lock_free_pool_t;
+
+    const std::size_t iterations = 200000U;
+
+    const auto maxThreads =
+        std::max< std::size_t >( 2U, std::min< std::size_t >( 32U, bl::os::thread::hardware_concurrency() ) );
+
+    for( std::size_t threadsCount = 1U; threadsCount <= maxThreads; threadsCount *= 2U )
+    {
+        const auto simpleDuration = poolContentionRun(
+            simple_pool_t::createInstance< simple_pool_t >(),
+            threadsCount,
+            iterations
+            );
+
+        const auto lockFreeDuration = poolContentionRun(
+            lock_free_pool_t::createInstance< lock_free_pool_t >(),
+            threadsCount,
+            iterations
+            );
+
+        UTF_CHECK( simpleDuration < bl::time::seconds( 60 ) );
+        UTF_CHECK( lockFreeDuration < bl::time::seconds( 60 ) );
+
+        UTF_MESSAGE(
+            BL_MSG()
+                << "Pool contention with "
+                << threadsCount
+                << " threads and "
+                << iterations
+                << " get/put iterations per thread; SimplePool: "
+                << simpleDuration
+                << "; LockFreePool: "
+                << lockFreeDuration
+            );
+    }
+}
+
 UTF_AUTO_TEST_CASE( BaseLib_NetworkByteOrderFunctionsTests )
 {
     /*
@@ -7633,3 +8579,118 @@ UTF_AUTO_TEST_CASE( BaseLib_ProfilesDirectoryTests )
             << profilesDirectory.string()
         );
 }
+
+namespace
+{
+    /*
+     * A trivial "hash" which just records the data passed to it, so we can verify
+     * the fused checksum and hash calculation sees all the data in order
+     */
+
+    class RecordingHash
+    {
+    public:
+
+        std::string                                 data;
+
+        void update(
+            SAA_in      const void*                 buffer,
+            SAA_in      const std::size_t           size
+            )
+        {
+            data.append( static_cast< const char* >( buffer ), size );
+        }
+    };
+
+} // __unnamed
+
+UTF_AUTO_TEST_CASE( BaseLib_ChecksumTests )
+{
+    using namespace bl;
+
+    /*
+     * The standard check values for "123456789"
+     */
+
+    const std::string check = "123456789";
+
+    {
+        cs::Crc32 crc32;
+        crc32.process_bytes( check.c_str(), check.size() );
+        UTF_REQUIRE_EQUAL( crc32.checksum(), 0xCBF43926U );
+
+        cs::Crc32c crc32c;
+        crc32c.process_bytes( check.c_str(), check.size() );
+        UTF_REQUIRE_EQUAL( crc32c.checksum(), 0xE3069283U );
+
+        cs::Crc32c crc32cSoftware( true /* forceSoftware */ );
+        crc32cSoftware.process_bytes( check.c_str(), check.size() );
+        UTF_REQUIRE_EQUAL( crc32cSoftware.checksum(), 0xE3069283U );
+    }
+
+    BL_LOG(
+        Logging::debug(),
+        BL_MSG()
+            << "CRC32C is hardware accelerated: "
+            << cs::Crc32c::isHardwareAccelerated()
+        );
+
+    std::vector< unsigned char > buffer( 64U * 1024U + 13U );
+
+    for( std::size_t i = 0U; i < buffer.size(); ++i )
+    {
+        buffer[ i ] = static_cast< unsigned char >( i * 131U + ( i >> 7 ) );
+    }
+
+    /*
+     * CRC-32 must be identical to boost::crc_32_type (the values persisted in the metadata)
+     * and the hardware and software CRC32C must agree for all alignments and sizes, also
+     * when the data is processed in pieces
+     */
+
+    const std::size_t sizes[] = { 0U, 1U, 7U, 8U, 9U, 63U, 4096U, 60000U };
+
+    for( std::size_t offset = 0U; offset < 8U; ++offset )
+    {
+        for( const auto size : sizes )
+        {
+            const auto data = buffer.data() + offset;
+
+            cs::crc_32_type expected;
+            expected.process_bytes( data, size );
+
+            cs::Crc32 crc32;
+            crc32.process_bytes( data, size / 3U );
+            crc32.process_bytes( data + size / 3U, size - size / 3U );
+
+            UTF_REQUIRE_EQUAL( crc32.checksum(), expected.checksum() );
+
+            cs::Crc32c crc32c;
+            crc32c.process_bytes( data, size );
+
+            cs::Crc32c crc32cSoftware( true /* forceSoftware */ );
+            crc32cSoftware.process_bytes( data, size / 2U );
+            crc32cSoftware.process_bytes( data + size / 2U, size - size / 2U );
+
+            UTF_REQUIRE_EQUAL( crc32c.checksum(), crc32cSoftware.checksum() );
+        }
+    }
+
+    /*
+     * The fused calculation must produce the same checksum and pass all the data to the hash
+     */
+
+    {
+        cs::Crc32 crc32;
+        RecordingHash hash;
+
+        cs::updateChecksumAndHash( crc32, hash, buffer.data(), buffer.size() );
+
+        cs::crc_32_type expected;
+        expected.process_bytes( buffer.data(), buffer.size() );
+
+        UTF_REQUIRE_EQUAL( crc32.checksum(), expected.checksum() );
+        UTF_REQUIRE_EQUAL( hash.data.size(), buffer.size() );
+        UTF_REQUIRE( 0 == std::memcmp( hash.data.data(), buffer.data(), buffer.size() ) );
+    }
+}
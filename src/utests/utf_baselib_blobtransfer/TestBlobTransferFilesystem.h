@@ -30,6 +30,57 @@ UTF_AUTO_TEST_CASE( BlobTransfer_FilesPackagerInMemoryTests )
         );
 }
 
+UTF_AUTO_TEST_CASE( BlobTransfer_FilesPackagerInMemoryDedupTests )
+{
+    test::MachineGlobalTestLock lockBlobServer;
+
+    /*
+     * The content-defined chunking and the deduplication are tested together and
+     * the fixed size chunking is tested with deduplication only
+     */
+
+    utest::TestBlobTransferFilesystemUtilsImpl::executeTransferTestsWrap(
+        bl::cpp::bind(
+            &utest::TestBlobTransferFilesystemUtilsImpl::filesPackagerWithChunkingTestsWrap,
+            test::UtfArgsParser::port() /* blobServerPort */,
+            utest::TestBlobTransferUtils::getInMemoryMetadataStore(),
+            utest::TestBlobTransferUtils::CancelType::NoCancel,
+            bl::transfer::FilesPackagerUnit::ContentDefinedChunking,
+            true /* deduplicateChunks */
+            )
+        );
+
+    utest::TestBlobTransferFilesystemUtilsImpl::executeTransferTestsWrap(
+        bl::cpp::bind(
+            &utest::TestBlobTransferFilesystemUtilsImpl::filesPackagerWithChunkingTestsWrap,
+            test::UtfArgsParser::port() /* blobServerPort */,
+            utest::TestBlobTransferUtils::getInMemoryMetadataStore(),
+            utest::TestBlobTransferUtils::CancelType::NoCancel,
+            bl::transfer::FilesPackagerUnit::FixedSizeChunking,
+            true /* deduplicateChunks */
+            )
+        );
+}
+
+UTF_AUTO_TEST_CASE( BlobTransfer_FilesPackagerInMemoryAsyncFileIoTests )
+{
+    test::MachineGlobalTestLock lockBlobServer;
+
+    /*
+     * The chunks are read and written via the async file I/O service (io_uring if it
+     * is available)
+     */
+
+    utest::TestBlobTransferFilesystemUtilsImpl::executeTransferTestsWrap(
+        bl::cpp::bind(
+            &utest::TestBlobTransferFilesystemUtilsImpl::filesPackagerAsyncFileIoTestsWrap,
+            test::UtfArgsParser::port() /* blobServerPort */,
+            utest::TestBlobTransferUtils::getInMemoryMetadataStore(),
+            utest::TestBlobTransferUtils::CancelType::NoCancel
+            )
+        );
+}
+
 UTF_AUTO_TEST_CASE( BlobTransfer_FilesPackagerInMemoryCancelUploadTests )
 {
     test::MachineGlobalTestLock lockBlobServer;
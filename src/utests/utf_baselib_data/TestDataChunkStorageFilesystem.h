@@ -425,6 +425,109 @@ namespace utest
                 }
             }
         }
+
+        template
+        <
+            typename STORAGEIMPL
+        >
+        static void executeMappedReadsTests()
+        {
+            using namespace bl;
+            using namespace bl::data;
+
+            const auto sessionId = uuids::create();
+
+            const auto createBlock = []( SAA_in const std::size_t size ) -> om::ObjPtr< DataBlock >
+            {
+                auto block = DataBlock::createInstance();
+
+                for( std::size_t i = 0U; i < size; ++i )
+                {
+                    block -> begin()[ i ] = static_cast< char >( i % 251U );
+                }
+
+                block -> setSize( size );
+                block -> setOffset1( 0U );
+
+                return block;
+            };
+
+            const auto storage = om::lockDisposable( STORAGEIMPL::createInstance() );
+
+            if( ! storage -> mappedReadsEnabled() )
+            {
+                return;
+            }
+
+            const auto smallChunkId = uuids::create();
+            const auto largeChunkId = uuids::create();
+
+            const auto smallBlock = createBlock( STORAGEIMPL::MAPPED_READ_SIZE_MIN - 1U );
+            const auto largeBlock = createBlock( DataBlock::defaultCapacity() / 2U );
+
+            storage -> save( sessionId, smallChunkId, smallBlock );
+            storage -> save( sessionId, uuids::create(), smallBlock );
+            storage -> save( sessionId, largeChunkId, largeBlock );
+
+            /*
+             * Small chunks are not mapped and non-existing chunks throw the same
+             * exception as load()
+             */
+
+            UTF_REQUIRE( ! storage -> tryLoadMapped( sessionId, smallChunkId ) );
+
+            UTF_REQUIRE_THROW( storage -> tryLoadMapped( sessionId, uuids::create() ), ServerErrorException );
+
+            const auto mappedBlock = storage -> tryLoadMapped( sessionId, largeChunkId );
+
+            UTF_REQUIRE( mappedBlock );
+            UTF_REQUIRE( mappedBlock -> isExternal() );
+            UTF_REQUIRE_EQUAL( mappedBlock -> size(), largeBlock -> size() );
+            UTF_REQUIRE_EQUAL( mappedBlock -> offset1(), 0U );
+            UTF_REQUIRE( BackendImplTestImpl::areBlocksEqual( largeBlock, mappedBlock ) );
+
+            /*
+             * The mapped block must remain valid after the chunk was removed and the
+             * writes to it must not be visible to the storage
+             */
+
+            storage -> remove( sessionId, largeChunkId );
+
+            UTF_REQUIRE( BackendImplTestImpl::areBlocksEqual( largeBlock, mappedBlock ) );
+
+            storage -> save( sessionId, largeChunkId, largeBlock );
+
+            std::memset( mappedBlock -> begin(), 'x', mappedBlock -> size() );
+
+            const auto newBlock = DataBlock::createInstance();
+
+            storage -> load( sessionId, largeChunkId, newBlock );
+
+            UTF_REQUIRE( BackendImplTestImpl::areBlocksEqual( largeBlock, newBlock ) );
+
+            const auto mappedBlock2 = storage -> tryLoadMapped( sessionId, largeChunkId );
+
+            UTF_REQUIRE( mappedBlock2 );
+            UTF_REQUIRE( BackendImplTestImpl::areBlocksEqual( largeBlock, mappedBlock2 ) );
+
+            /*
+             * Saving over a chunk while a mapped block of it is still alive must not change
+             * the mapped data (or truncate the file under the mapping which would fault on
+             * access to the pages past the new end of the file)
+             */
+
+            const auto otherBlock = createBlock( STORAGEIMPL::MAPPED_READ_SIZE_MIN );
+
+            std::memset( otherBlock -> begin(), 'y', otherBlock -> size() );
+
+            storage -> save( sessionId, largeChunkId, otherBlock );
+
+            UTF_REQUIRE( BackendImplTestImpl::areBlocksEqual( largeBlock, mappedBlock2 ) );
+
+            storage -> load( sessionId, largeChunkId, newBlock );
+
+            UTF_REQUIRE( BackendImplTestImpl::areBlocksEqual( otherBlock, newBlock ) );
+        }
     };
 
     typedef TestDataChunkStorageFilesystemLocalHelperT<> TestDataChunkStorageFilesystemLocalHelper;
@@ -450,3 +553,198 @@ UTF_AUTO_TEST_CASE( TestDataChunkStorageFilesystemSingleFile )
         "DataChunkStorageFilesystemSingleFile tests"
         );
 }
+
+UTF_AUTO_TEST_CASE( TestDataChunkStorageFilesystemSingleFileCompaction )
+{
+    using namespace bl;
+    using namespace bl::data;
+    using namespace utest;
+
+    const auto sessionId = uuids::create();
+
+    const auto createBlock = []( SAA_in const std::size_t index ) -> om::ObjPtr< DataBlock >
+    {
+        const auto data = resolveMessage( BL_MSG() << "This is test data for chunk #" << index );
+
+        auto block = DataBlock::createInstance( 128 );
+
+        std::memcpy( block -> begin(), data.c_str(), data.size() );
+
+        block -> setSize( data.size() );
+        block -> setOffset1( 0U );
+
+        return block;
+    };
+
+    const std::size_t noOfChunks = 200U;
+
+    fs::TmpDir tempDir;
+    fs::TmpDir crashDir;
+
+    std::vector< bl::uuid_t > chunks;
+
+    const auto createStorageAt = [ & ]( SAA_in const fs::path& rootPath ) -> om::ObjPtr< DataChunkStorageFilesystemSingleFile >
+    {
+        return DataChunkStorageFilesystemSingleFile::createInstance(
+            cpp::copy( rootPath )                       /* rootPath */,
+            false                                       /* isRootTemp */,
+            1024U                                       /* maxSegmentSize */
+            );
+    };
+
+    const auto createStorage = [ & ]() -> om::ObjPtr< DataChunkStorageFilesystemSingleFile >
+    {
+        return createStorageAt( tempDir.path() );
+    };
+
+    const auto verifyChunks = [ & ]( SAA_in const om::ObjPtr< DataChunkStorageFilesystemSingleFile >& storage ) -> void
+    {
+        for( std::size_t i = 0U; i < chunks.size(); ++i )
+        {
+            const auto newBlock = DataBlock::createInstance( 128 );
+
+            if( i % 4U )
+            {
+                UTF_REQUIRE_THROW( storage -> load( sessionId, chunks[ i ], newBlock ), ServerErrorException );
+            }
+            else
+            {
+                storage -> load( sessionId, chunks[ i ], newBlock );
+
+                UTF_REQUIRE( BackendImplTestImpl::areBlocksEqual( createBlock( i ), newBlock ) );
+            }
+        }
+    };
+
+    {
+        const auto storage = om::lockDisposable( createStorage() );
+
+        for( std::size_t i = 0U; i < noOfChunks; ++i )
+        {
+            const auto chunkId = uuids::create();
+
+            storage -> save( sessionId, chunkId, createBlock( i ) );
+
+            chunks.push_back( chunkId );
+        }
+
+        const auto segmentsCount = storage -> getSegmentsCount();
+
+        UTF_REQUIRE( segmentsCount > 2U );
+
+        /*
+         * Delete 3 out of every 4 chunks and compact; all sealed segments
+         * should be compacted and the deleted space should be reclaimed
+         */
+
+        for( std::size_t i = 0U; i < chunks.size(); ++i )
+        {
+            if( i % 4U )
+            {
+                storage -> remove( sessionId, chunks[ i ] );
+            }
+        }
+
+        std::uint64_t deletedSize = 0U;
+
+        const auto sizeBefore = storage -> getSegmentsSize( &deletedSize );
+
+        UTF_REQUIRE( deletedSize > sizeBefore / 2U );
+
+        UTF_REQUIRE( storage -> compact() > 0U );
+
+        const auto sizeAfter = storage -> getSegmentsSize( &deletedSize );
+
+        UTF_REQUIRE( sizeAfter < sizeBefore / 2U );
+        UTF_REQUIRE( storage -> getSegmentsCount() < segmentsCount );
+
+        verifyChunks( storage );
+
+        /*
+         * data.bin (segment 0) was compacted away and the index checkpoint was written
+         * before the compacted segments were deleted, so a copy of the storage files
+         * taken now (i.e. as if the process crashed) is loaded from the checkpoint
+         */
+
+        UTF_REQUIRE( ! fs::path_exists( tempDir.path() / "chunks" / "data.bin" ) );
+        UTF_REQUIRE( fs::path_exists( tempDir.path() / "chunks" / "index.bin" ) );
+
+        const auto crashPath = crashDir.path() / "storage";
+
+        fs::safeMkdirs( crashPath / "chunks" );
+
+        for( fs::directory_iterator i( tempDir.path() / "chunks" ), end; i != end; ++i )
+        {
+            fs::copy_file( i -> path(), crashPath / "chunks" / i -> path().filename() );
+        }
+
+        {
+            const auto crashStorage = om::lockDisposable( createStorageAt( crashPath ) );
+
+            UTF_REQUIRE( crashStorage -> isIndexCheckpointLoaded() );
+            UTF_REQUIRE_EQUAL( crashStorage -> getSegmentsCount(), storage -> getSegmentsCount() );
+
+            verifyChunks( crashStorage );
+        }
+
+        /*
+         * Any modification removes the checkpoint as it is no longer valid
+         */
+
+        storage -> remove( sessionId, chunks[ 0 ] );
+        storage -> save( sessionId, chunks[ 0 ], createBlock( 0 ) );
+
+        UTF_REQUIRE( ! fs::path_exists( tempDir.path() / "chunks" / "index.bin" ) );
+    }
+
+    /*
+     * Re-open the storage (from the index checkpoint) and then re-open it
+     * again after the checkpoint has been removed (by scanning the segments)
+     */
+
+    {
+        UTF_REQUIRE( fs::path_exists( tempDir.path() / "chunks" / "index.bin" ) );
+
+        const auto storage = om::lockDisposable( createStorage() );
+
+        UTF_REQUIRE( storage -> isIndexCheckpointLoaded() );
+        UTF_REQUIRE( ! fs::path_exists( tempDir.path() / "chunks" / "index.bin" ) );
+        UTF_REQUIRE( ! fs::path_exists( tempDir.path() / "chunks" / "data.bin" ) );
+
+        verifyChunks( storage );
+
+        /*
+         * Force compaction of everything with deleted space (including the
+         * active segment) and verify that no deleted space is left
+         */
+
+        storage -> compact( true /* force */ );
+
+        std::uint64_t deletedSize = 0U;
+
+        storage -> getSegmentsSize( &deletedSize );
+
+        UTF_REQUIRE_EQUAL( deletedSize, 0U );
+
+        verifyChunks( storage );
+    }
+
+    fs::safeRemove( tempDir.path() / "chunks" / "index.bin" );
+
+    {
+        const auto storage = om::lockDisposable( createStorage() );
+
+        UTF_REQUIRE( ! storage -> isIndexCheckpointLoaded() );
+
+        verifyChunks( storage );
+    }
+}
+
+UTF_AUTO_TEST_CASE( TestDataChunkStorageFilesystemMappedReads )
+{
+    using namespace bl::data;
+    using namespace utest;
+
+    TestDataChunkStorageFilesystemLocalHelper::executeMappedReadsTests< DataChunkStorageFilesystemMultiFiles >();
+    TestDataChunkStorageFilesystemLocalHelper::executeMappedReadsTests< DataChunkStorageFilesystemSingleFile >();
+}
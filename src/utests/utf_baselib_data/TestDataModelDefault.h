@@ -62,6 +62,31 @@ namespace utest
         BL_DM_DEFINE_PROPERTY( ContainedTestObject, intValue )
         BL_DM_DEFINE_PROPERTY( ContainedTestObject, uint64Value )
 
+        /*
+         * NumericTestObject
+         */
+
+        BL_DM_DEFINE_CLASS_BEGIN( NumericTestObject )
+
+            BL_DM_DECLARE_STRING_PROPERTY               ( strValue )
+            BL_DM_DECLARE_INT_PROPERTY                  ( intValue )
+            BL_DM_DECLARE_UINT64_PROPERTY               ( uint64Value )
+            BL_DM_DECLARE_DOUBLE_PROPERTY               ( doubleValue )
+
+            BL_DM_PROPERTIES_IMPL_BEGIN()
+                BL_DM_IMPL_PROPERTY( strValue )
+                BL_DM_IMPL_PROPERTY( intValue )
+                BL_DM_IMPL_PROPERTY( uint64Value )
+                BL_DM_IMPL_PROPERTY( doubleValue )
+            BL_DM_PROPERTIES_IMPL_END()
+
+        BL_DM_DEFINE_CLASS_END( NumericTestObject )
+
+        BL_DM_DEFINE_PROPERTY( NumericTestObject, strValue )
+        BL_DM_DEFINE_PROPERTY( NumericTestObject, intValue )
+        BL_DM_DEFINE_PROPERTY( NumericTestObject, uint64Value )
+        BL_DM_DEFINE_PROPERTY( NumericTestObject, doubleValue )
+
         /*
          * TestObjectBase
          */
@@ -539,3 +564,309 @@ UTF_AUTO_TEST_CASE( CoreDataModelTests )
     }
 }
 
+
+UTF_AUTO_TEST_CASE( CoreDataModelBinaryTests )
+{
+    using namespace bl;
+    using namespace bl::dm;
+    using namespace utest::dm;
+
+    typedef DataModelUtils dmu;
+
+    const auto requireSameCanonicalJson = [](
+        SAA_in          const om::ObjPtr< TestObject >&                             expected,
+        SAA_in          const om::ObjPtr< TestObject >&                             actual
+        ) -> void
+    {
+        UTF_REQUIRE_EQUAL(
+            dmu::getJsonString( expected, false /* prettyPrint */, true /* canonicalize */ ),
+            dmu::getJsonString( actual, false /* prettyPrint */, true /* canonicalize */ )
+            );
+    };
+
+    const auto testObj = DataModelUtils::loadFromFile< TestObject >(
+        utest::TestUtils::resolveDataFilePath( "serialized_object.json" )
+        );
+
+    testObj -> numbersLvalue().push_back( -1 );
+    testObj -> numbersLvalue().push_back( std::numeric_limits< int >::min() );
+    testObj -> numbersLvalue().push_back( std::numeric_limits< int >::max() );
+
+    {
+        const auto binary = dmu::getBinaryString( testObj );
+
+        UTF_REQUIRE( dmu::isBinaryDoc( binary.data(), binary.size() ) );
+        UTF_REQUIRE( binary.size() < dmu::getDocAsPackedJsonString( testObj ).size() );
+
+        const auto loaded = dmu::loadFromBinary< TestObject >( binary );
+
+        requireSameCanonicalJson( testObj, loaded );
+
+        UTF_REQUIRE_EQUAL( dmu::getBinaryString( loaded ), binary );
+
+        /*
+         * Unset properties must stay unset and the canonicalized form must round trip too
+         */
+
+        const auto empty = dmu::loadFromBinary< TestObject >( dmu::getBinaryString( TestObject::createInstance() ) );
+
+        UTF_REQUIRE( ! empty -> idIsSet() );
+        UTF_REQUIRE( ! empty -> complex() );
+        UTF_REQUIRE( empty -> custom().is_null() );
+
+        const auto canonical = dmu::loadFromBinary< TestObject >(
+            dmu::getBinaryString( testObj, true /* canonicalize */ )
+            );
+
+        requireSameCanonicalJson( testObj, canonical );
+    }
+
+    {
+        /*
+         * Unmapped properties are carried over as JSON text
+         */
+
+        auto jsonObj = dmu::getJsonObject( testObj );
+
+        jsonObj[ "unmappedName" ] = "unmappedValue";
+
+        const auto withUnmapped = dmu::loadFromJsonObject< TestObject >( std::move( jsonObj ) );
+
+        UTF_REQUIRE_EQUAL( 1U, withUnmapped -> unmapped().size() );
+
+        const auto loaded = dmu::loadFromBinary< TestObject >( dmu::getBinaryString( withUnmapped ) );
+
+        UTF_REQUIRE_EQUAL( 1U, loaded -> unmapped().size() );
+        UTF_REQUIRE_EQUAL( loaded -> unmapped().at( "unmappedName" ).get_str(), "unmappedValue" );
+
+        requireSameCanonicalJson( withUnmapped, loaded );
+
+        /*
+         * The placeholder object keeps everything as unmapped properties
+         */
+
+        const auto payloadObj = dmu::loadFromBinary< Payload >(
+            dmu::getBinaryString( dmu::loadFromJsonText< Payload >( dmu::getDocAsPackedJsonString( testObj ) ) )
+            );
+
+        requireSameCanonicalJson( testObj, dmu::castTo< TestObject >( payloadObj ) );
+    }
+
+    {
+        /*
+         * Properties can be appended: trailing unknown properties are skipped and missing
+         * trailing properties are left unset
+         */
+
+        const auto& containedObj = testObj -> complex();
+
+        const auto baseObj = dmu::loadFromBinary< ContainedTestObjectBase >( dmu::getBinaryString( containedObj ) );
+
+        UTF_REQUIRE_EQUAL( baseObj -> strValue(), containedObj -> strValue() );
+
+        const auto derivedObj = dmu::loadFromBinary< ContainedTestObject >( dmu::getBinaryString( baseObj ) );
+
+        UTF_REQUIRE_EQUAL( derivedObj -> strValue(), containedObj -> strValue() );
+        UTF_REQUIRE( ! derivedObj -> boolValueIsSet() );
+        UTF_REQUIRE( ! derivedObj -> intValueIsSet() );
+        UTF_REQUIRE( ! derivedObj -> uint64ValueIsSet() );
+    }
+
+    {
+        /*
+         * Malformed input must be rejected
+         */
+
+        const auto binary = dmu::getBinaryString( testObj );
+
+        UTF_REQUIRE_THROW( dmu::loadFromBinary< TestObject >( dmu::getDocAsPackedJsonString( testObj ) ), JsonException );
+
+        for( std::size_t size = 0U; size < binary.size(); size += 7U )
+        {
+            UTF_REQUIRE_THROW( dmu::loadFromBinary< TestObject >( binary.data(), size ), JsonException );
+        }
+
+        UTF_REQUIRE_THROW( dmu::loadFromBinary< TestObject >( binary + "x" ), JsonException );
+    }
+}
+
+UTF_AUTO_TEST_CASE( CoreDataModelStreamingTests )
+{
+    using namespace bl;
+    using namespace bl::dm;
+    using namespace utest::dm;
+
+    typedef DataModelUtils dmu;
+
+    const auto getCanonicalJson = []( SAA_in const om::ObjPtr< TestObject >& testObj ) -> std::string
+    {
+        return dmu::getJsonString( testObj, false /* prettyPrint */, true /* canonicalize */ );
+    };
+
+    const auto jsonText = encoding::readTextFile(
+        utest::TestUtils::resolveDataFilePath( "serialized_object.json" )
+        );
+
+    {
+        /*
+         * The streaming reader must produce the same object as the json::Value based path
+         */
+
+        auto jsonObj = json::readFromString( jsonText ).get_obj();
+
+        jsonObj[ "unmappedName" ] = "unmappedValue";
+        jsonObj[ "unmappedTree" ] = json::readFromString( "{ \"a\" : [ 1, -2, 3.5, true, null, { \"b\" : \"c\" } ] }" );
+
+        const auto text = json::saveToString( jsonObj );
+
+        const auto domObj = dmu::loadFromJsonObject< TestObject >( jsonObj );
+        const auto streamObj = dmu::loadFromJsonText< TestObject >( text );
+
+        UTF_REQUIRE_EQUAL( 2U, streamObj -> unmapped().size() );
+        UTF_REQUIRE_EQUAL( getCanonicalJson( domObj ), getCanonicalJson( streamObj ) );
+
+        const auto skippedObj = dmu::loadFromJsonText< TestObject >(
+            text.data(),
+            text.size(),
+            true /* ignoreUnmapped */
+            );
+
+        UTF_REQUIRE_EQUAL( 0U, skippedObj -> unmapped().size() );
+        UTF_REQUIRE_EQUAL( skippedObj -> id(), domObj -> id() );
+        UTF_REQUIRE_EQUAL( skippedObj -> complexMap().size(), domObj -> complexMap().size() );
+    }
+
+    {
+        /*
+         * Escape sequences, numeric limits and null values
+         */
+
+        const auto text = std::string(
+            "{ \"json_str\" : \"line1\\nline2 \\\"\\u00e9\\ud83d\\ude00\\\" \\/\", "
+            "\"id\" : 18446744073709551615, "
+            "\"numbers\" : [ -2147483648, 2147483647, \"42\" ], "
+            "\"strings\" : null, "
+            "\"custom\" : { \"real\" : 1.5e3, \"big\" : -9223372036854775808 }, "
+            "\"unm\\u0061pped\" : 1 }"
+            );
+
+        UTF_REQUIRE_THROW( dmu::loadFromJsonText< TestObject >( text ), JsonException );
+
+        const auto fixedText = str::replace_all_copy( text, "\"strings\" : null, ", "" );
+
+        const auto testObj = dmu::loadFromJsonText< TestObject >( fixedText );
+
+        UTF_REQUIRE_EQUAL( testObj -> str(), "line1\nline2 \"\xc3\xa9\xf0\x9f\x98\x80\" /" );
+        UTF_REQUIRE_EQUAL( testObj -> id(), std::numeric_limits< std::uint64_t >::max() );
+        UTF_REQUIRE_EQUAL( testObj -> numbers().size(), 3U );
+        UTF_REQUIRE_EQUAL( testObj -> numbers()[ 0 ], std::numeric_limits< int >::min() );
+        UTF_REQUIRE_EQUAL( testObj -> numbers()[ 1 ], std::numeric_limits< int >::max() );
+        UTF_REQUIRE_EQUAL( testObj -> numbers()[ 2 ], 42 );
+        UTF_REQUIRE_EQUAL( testObj -> custom().get_obj().at( "real" ).get_real(), 1500.0 );
+        UTF_REQUIRE_EQUAL( testObj -> custom().get_obj().at( "big" ).get_int64(), std::numeric_limits< std::int64_t >::min() );
+        UTF_REQUIRE_EQUAL( testObj -> unmapped().at( "unmapped" ).get_int(), 1 );
+
+        UTF_REQUIRE_EQUAL(
+            getCanonicalJson( testObj ),
+            getCanonicalJson( dmu::loadFromJsonObject< TestObject >( json::readFromString( fixedText ).get_obj() ) )
+            );
+    }
+
+    {
+        /*
+         * Narrowing of the integer values is range checked (out of range values throw
+         * rather than wrap) and the integer values are read into double properties in
+         * the same way as json_spirit reads them (i.e. values above the int64 maximum
+         * are unsigned)
+         */
+
+        UTF_REQUIRE_THROW( dmu::loadFromJsonText< NumericTestObject >( "{ \"intValue\" : 3000000000 }" ), JsonException );
+        UTF_REQUIRE_THROW( dmu::loadFromJsonText< NumericTestObject >( "{ \"intValue\" : -2147483649 }" ), JsonException );
+        UTF_REQUIRE_THROW( dmu::loadFromJsonText< NumericTestObject >( "{ \"uint64Value\" : -1 }" ), JsonException );
+
+        const auto text = std::string(
+            "{ \"intValue\" : -2147483648, "
+            "\"uint64Value\" : 18446744073709551615, "
+            "\"doubleValue\" : 18446744073709551615 }"
+            );
+
+        const auto numericObj = dmu::loadFromJsonText< NumericTestObject >( text );
+
+        UTF_REQUIRE_EQUAL( numericObj -> intValue(), std::numeric_limits< int >::min() );
+        UTF_REQUIRE_EQUAL( numericObj -> uint64Value(), std::numeric_limits< std::uint64_t >::max() );
+        UTF_REQUIRE_EQUAL( numericObj -> doubleValue(), 18446744073709551615.0 );
+
+        const auto domObj = dmu::loadFromJsonObject< NumericTestObject >( json::readFromString( text ).get_obj() );
+
+        UTF_REQUIRE_EQUAL( numericObj -> doubleValue(), domObj -> doubleValue() );
+
+        UTF_REQUIRE_EQUAL(
+            dmu::loadFromJsonText< NumericTestObject >( "{ \"doubleValue\" : -9223372036854775808 }" ) -> doubleValue(),
+            -9223372036854775808.0
+            );
+    }
+
+    {
+        /*
+         * A string property with null value is treated as not present and it is loaded as
+         * an unmapped property (in the same way as in the json::Value based path)
+         */
+
+        const auto text = std::string( "{ \"strValue\" : null, \"intValue\" : 1 }" );
+
+        const auto streamObj = dmu::loadFromJsonText< NumericTestObject >( text );
+        const auto domObj = dmu::loadFromJsonObject< NumericTestObject >( json::readFromString( text ).get_obj() );
+
+        UTF_REQUIRE( streamObj -> strValue().empty() );
+        UTF_REQUIRE_EQUAL( streamObj -> intValue(), 1 );
+        UTF_REQUIRE_EQUAL( 1U, streamObj -> unmapped().size() );
+        UTF_REQUIRE( streamObj -> unmapped().at( "strValue" ).is_null() );
+
+        UTF_REQUIRE_EQUAL( 1U, domObj -> unmapped().size() );
+        UTF_REQUIRE_EQUAL(
+            dmu::getJsonString( streamObj, false /* prettyPrint */, true /* canonicalize */ ),
+            dmu::getJsonString( domObj, false /* prettyPrint */, true /* canonicalize */ )
+            );
+
+        const auto skippedObj = dmu::loadFromJsonText< NumericTestObject >(
+            text.data(),
+            text.size(),
+            true /* ignoreUnmapped */
+            );
+
+        UTF_REQUIRE( skippedObj -> strValue().empty() );
+        UTF_REQUIRE_EQUAL( 0U, skippedObj -> unmapped().size() );
+    }
+
+    {
+        /*
+         * Malformed input and type mismatches
+         */
+
+        UTF_REQUIRE_THROW_MESSAGE(
+            dmu::loadFromJsonText< TestObject >( "{ \"id\" : \"1234\" }" ),
+            JsonException,
+            "expected value type is 'integer' while actual type is 'string' for property 'id'"
+            );
+
+        UTF_REQUIRE_THROW_MESSAGE(
+            dmu::loadFromJsonText< TestObject >( "{ \"id\" : 1, \"id\" : 2 }" ),
+            UserMessageException,
+            "Duplicate entry encountered for property with name 'id'"
+            );
+
+        UTF_REQUIRE_THROW( dmu::loadFromJsonText< TestObject >( "{ \"id\" : 1 } x" ), JsonException );
+        UTF_REQUIRE_THROW( dmu::loadFromJsonText< TestObject >( "{ \"id\" : 1, }" ), JsonException );
+        UTF_REQUIRE_THROW( dmu::loadFromJsonText< TestObject >( "{ \"id\" : tru }" ), JsonException );
+        UTF_REQUIRE_THROW( dmu::loadFromJsonText< TestObject >( "{ \"json_str\" : \"\\q\" }" ), JsonException );
+        UTF_REQUIRE_THROW(
+            dmu::loadFromJsonText< TestObject >( "{ \"custom\" : " + std::string( 1024U, '[' ) ),
+            JsonException
+            );
+
+        for( std::size_t size = 0U; size < jsonText.size(); size += 13U )
+        {
+            UTF_REQUIRE_THROW( dmu::loadFromJsonText< TestObject >( jsonText.data(), size ), JsonException );
+        }
+    }
+}
@@ -0,0 +1,345 @@
+/*
+ * This file is part of the swblocks-baselib library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <baselib/core/PreCompiled.h>
+#include <baselib/data/PreCompiled.h>
+
+#include <utests/baselib/PreCompiled.h>
+
+/************************************************************************
+ * FilesystemMetadataMappedImpl tests
+ */
+
+UTF_AUTO_TEST_CASE( TestFilesystemMetadataMappedImpl )
+{
+    using namespace bl;
+    using namespace bl::data;
+
+    typedef FilesystemMetadataMappedImpl fsmd_t;
+
+    const auto randomId = uuids::create();
+
+    fs::TmpDir tmpDir;
+
+    {
+        const auto fsmd = fsmd_t::createInstance< FilesystemMetadataRO >( tmpDir.path() / "empty" );
+
+        /*
+         * The object is not finalized, so any method calls should throw
+         */
+
+        UTF_REQUIRE_THROW( fsmd -> queryAllEntries(), UnexpectedException );
+        UTF_REQUIRE_THROW( fsmd -> queryAllChunks(), UnexpectedException );
+        UTF_REQUIRE_THROW( fsmd -> queryChunks( randomId ), UnexpectedException );
+        UTF_REQUIRE_THROW( fsmd -> loadEntryInfo( randomId ), UnexpectedException );
+        UTF_REQUIRE_THROW( fsmd -> loadChunkInfo( randomId ), UnexpectedException );
+
+        /*
+         * A store which wasn't finalized can't be opened
+         */
+
+        UTF_REQUIRE_THROW(
+            fsmd_t::createInstance( tmpDir.path() / "empty", FilesystemMetadataMapped::OpenExisting ),
+            std::exception
+            );
+
+        const auto wo = om::qi< FilesystemMetadataWO >( fsmd );
+
+        wo -> finalize();
+
+        UTF_REQUIRE( ! fsmd -> queryAllEntries() -> hasCurrent() );
+        UTF_REQUIRE( ! fsmd -> queryAllChunks() -> hasCurrent() );
+        UTF_REQUIRE_EQUAL( fsmd -> queryEntriesCount(), 0U );
+
+        UTF_REQUIRE_THROW( fsmd -> queryChunks( randomId ), UnexpectedException );
+        UTF_REQUIRE_THROW( fsmd -> loadEntryInfo( randomId ), UnexpectedException );
+        UTF_REQUIRE_THROW( fsmd -> loadChunkInfo( randomId ), UnexpectedException );
+
+        UTF_REQUIRE_THROW( wo -> createEntry( fsmd_t::EntryInfo() ), UnexpectedException );
+        UTF_REQUIRE_THROW( wo -> createChunk( randomId, fsmd_t::ChunkInfo() ), UnexpectedException );
+        UTF_REQUIRE_THROW( wo -> finalize(), UnexpectedException );
+    }
+
+    /*
+     * Create enough entries and chunks so the records are flushed from the write
+     * buffers and some of them are updated after they were flushed
+     */
+
+    const std::size_t entriesCount = 5000U;
+    const std::size_t chunksPerFile = 3U;
+
+    const auto storePath = tmpDir.path() / "store";
+
+    std::vector< uuid_t > entryIds;
+    std::map< uuid_t, std::vector< uuid_t > > expectedChunks;
+    std::map< uuid_t, fs::path > expectedPaths;
+
+    const auto fsmd = fsmd_t::createInstance< FilesystemMetadataWO >( storePath );
+
+    const auto now = std::time( nullptr );
+
+    for( std::size_t i = 0U; i < entriesCount; ++i )
+    {
+        fsmd_t::EntryInfo entry;
+
+        entry.type =
+            0U == i % 10U ? fsmd_t::Directory :
+            5U == i % 10U ? fsmd_t::Symlink :
+            fsmd_t::File;
+
+        entry.size = fsmd_t::File == entry.type ? i * 100U : 0U;
+        entry.lastModified = now + i;
+        entry.timeCreated = now;
+        entry.flags = 0U == i % 3U ? fsmd_t::Executable : fsmd_t::EntryFlagsNone;
+
+        entry.relPath = bo::path::createInstance();
+
+        entry.relPath -> lvalue() =
+            0U == i % 100U ?
+                fs::path( "top" + std::to_string( i ) ) :
+                fs::path( "dir" + std::to_string( i % 10U ) ) / ( "sub" + std::to_string( i % 7U ) ) / ( "file" + std::to_string( i ) );
+
+        if( fsmd_t::Symlink == entry.type )
+        {
+            entry.targetPath = bo::path::createInstance();
+            entry.targetPath -> lvalue() = "../target" + std::to_string( i );
+        }
+
+        const auto relPath = entry.relPath -> value();
+        const auto entryId = fsmd -> createEntry( std::move( entry ) );
+
+        entryIds.push_back( entryId );
+        expectedPaths[ entryId ] = relPath;
+        expectedChunks[ entryId ];
+    }
+
+    /*
+     * The relative paths must be unique
+     */
+
+    {
+        fsmd_t::EntryInfo entry;
+
+        entry.relPath = bo::path::createInstance();
+        entry.relPath -> lvalue() = fs::path( "dir1" ) / "sub1" / "file1";
+
+        UTF_REQUIRE_THROW( fsmd -> createEntry( std::move( entry ) ), UnexpectedException );
+    }
+
+    /*
+     * Create the chunks interleaved between the entries and associate the checksums
+     * and the hashes (most of these entries are already flushed to the file)
+     */
+
+    for( std::size_t chunkNo = 0U; chunkNo < chunksPerFile; ++chunkNo )
+    {
+        for( std::size_t i = 1U; i < entriesCount; i += 2U )
+        {
+            fsmd_t::ChunkInfo chunk;
+
+            chunk.pos = chunkNo * 1024U;
+            chunk.size = static_cast< std::uint32_t >( i );
+            chunk.checksum = static_cast< std::uint32_t >( i + chunkNo );
+
+            if( chunkNo )
+            {
+                chunk.hash = bo::string::createInstance( "hash" + std::to_string( i ) );
+                chunk.isChunkDuplicate = true;
+            }
+
+            const auto entryId = entryIds[ i ];
+
+            expectedChunks[ entryId ].push_back( fsmd -> createChunk( entryId, std::move( chunk ) ) );
+        }
+    }
+
+    for( std::size_t i = 0U; i < entriesCount; i += 4U )
+    {
+        fsmd -> associateChecksum( entryIds[ i ], static_cast< std::uint32_t >( i ) );
+        fsmd -> associateHash( entryIds[ i ], "entryHash" + std::to_string( i ) );
+    }
+
+    UTF_REQUIRE_THROW( fsmd -> createChunk( randomId, fsmd_t::ChunkInfo() ), UnexpectedException );
+
+    fsmd -> finalize();
+
+    const auto verify = [ & ]( SAA_in const om::ObjPtr< FilesystemMetadataRO >& ro ) -> void
+    {
+        UTF_REQUIRE_EQUAL( ro -> queryEntriesCount(), entriesCount );
+
+        std::size_t index = 0U;
+
+        for( auto iter = ro -> queryAllEntries(); iter -> hasCurrent(); iter -> loadNext() )
+        {
+            const auto entryId = iter -> current();
+
+            UTF_REQUIRE( entryId == entryIds[ index ] );
+
+            const auto info = ro -> loadEntryInfo( entryId );
+
+            UTF_REQUIRE( info.relPath -> value() == expectedPaths[ entryId ] );
+            UTF_REQUIRE( info.lastModified == now + static_cast< std::time_t >( index ) );
+            UTF_REQUIRE( info.timeCreated == now );
+            UTF_REQUIRE( info.isChecksumSet == ( 0U == index % 4U ) );
+            UTF_REQUIRE( ( 0U != ( info.flags & fsmd_t::Executable ) ) == ( 0U == index % 3U ) );
+
+            if( 0U == index % 4U )
+            {
+                UTF_REQUIRE( info.checksum == index );
+                UTF_REQUIRE_EQUAL( info.hash -> value(), "entryHash" + std::to_string( index ) );
+            }
+            else
+            {
+                UTF_REQUIRE( ! info.hash );
+            }
+
+            if( fsmd_t::Symlink == info.type )
+            {
+                UTF_REQUIRE( info.targetPath -> value() == "../target" + std::to_string( index ) );
+            }
+            else
+            {
+                UTF_REQUIRE( ! info.targetPath );
+            }
+
+            const auto& chunkIds = expectedChunks[ entryId ];
+
+            UTF_REQUIRE_EQUAL( ro -> queryChunksCount( entryId ), chunkIds.size() );
+
+            std::size_t chunkNo = 0U;
+
+            for( auto chunks = ro -> queryChunks( entryId ); chunks -> hasCurrent(); chunks -> loadNext() )
+            {
+                const auto chunkId = chunks -> current();
+
+                UTF_REQUIRE( chunkId == chunkIds[ chunkNo ] );
+                UTF_REQUIRE( ro -> queryEntryId( chunkId ) == entryId );
+
+                const auto chunk = ro -> loadChunkInfo( chunkId );
+
+                UTF_REQUIRE( chunk.pos == chunkNo * 1024U );
+                UTF_REQUIRE( chunk.size == index );
+                UTF_REQUIRE( chunk.checksum == index + chunkNo );
+                UTF_REQUIRE( chunk.isChunkDuplicate == ( 0U != chunkNo ) );
+
+                if( chunkNo )
+                {
+                    UTF_REQUIRE_EQUAL( chunk.hash -> value(), "hash" + std::to_string( index ) );
+                }
+
+                ++chunkNo;
+            }
+
+            UTF_REQUIRE_EQUAL( chunkNo, chunkIds.size() );
+
+            ++index;
+        }
+
+        UTF_REQUIRE_EQUAL( index, entriesCount );
+
+        std::size_t allChunksCount = 0U;
+
+        for( auto iter = ro -> queryAllChunks(); iter -> hasCurrent(); iter -> loadNext() )
+        {
+            ++allChunksCount;
+        }
+
+        UTF_REQUIRE_EQUAL( allChunksCount, chunksPerFile * entriesCount / 2U );
+
+        UTF_REQUIRE_THROW( ro -> loadEntryInfo( randomId ), UnexpectedException );
+        UTF_REQUIRE_THROW( ro -> loadChunkInfo( randomId ), UnexpectedException );
+        UTF_REQUIRE_THROW( ro -> queryEntryId( randomId ), UnexpectedException );
+
+        const auto stats = om::qi< fsmd_t >( ro ) -> computeStatistics();
+
+        UTF_REQUIRE( stats.entriesCount == entriesCount );
+        UTF_REQUIRE( stats.directoriesCount == entriesCount / 10U );
+        UTF_REQUIRE( stats.symlinksCount == entriesCount / 10U );
+        UTF_REQUIRE( stats.filesCount == entriesCount - 2U * entriesCount / 10U );
+    };
+
+    const auto ro = om::qi< FilesystemMetadataRO >( fsmd );
+
+    verify( ro );
+
+    /*
+     * Now reopen the store from the disk and verify it again
+     */
+
+    const auto reopened = fsmd_t::createInstance< FilesystemMetadataRO >( storePath, FilesystemMetadataMapped::OpenExisting );
+
+    UTF_REQUIRE( om::qi< FilesystemMetadataWO >( reopened ) -> isFinalized() );
+    UTF_REQUIRE( FilesystemMetadataUtils::areEqual( ro, reopened ) );
+
+    verify( reopened );
+
+    /*
+     * The iterators keep the mapped store alive
+     */
+
+    om::ObjPtr< UuidIterator > iter;
+
+    {
+        const auto store = fsmd_t::createInstance< FilesystemMetadataRO >( storePath, FilesystemMetadataMapped::OpenExisting );
+
+        iter = store -> queryChunks( entryIds[ 1 ] );
+    }
+
+    UTF_REQUIRE( iter -> hasCurrent() );
+    UTF_REQUIRE( iter -> current() == expectedChunks[ entryIds[ 1 ] ].front() );
+
+    /*
+     * The indexes and the counts stored in the records of a corrupted store must be
+     * validated and must throw instead of reading out of bounds
+     *
+     * The first entry record has no chunks and the first chunk record belongs to the
+     * second entry (see how the chunks were created above)
+     */
+
+    const auto corruptedPath = tmpDir.path() / "corrupted";
+
+    fs::safeMkdirs( corruptedPath );
+
+    for( const auto* fileName : { "entries.dat", "chunks.dat", "entry-ids.dat", "chunk-ids.dat", "strings.dat", "index.dat" } )
+    {
+        fs::copy_file( storePath / fileName, corruptedPath / fileName );
+    }
+
+    {
+        const std::uint64_t invalid = std::numeric_limits< std::uint64_t >::max() - 1U;
+
+        const auto entries = os::fopen( corruptedPath / "entries.dat", "r+b" );
+        const auto chunks = os::fopen( corruptedPath / "chunks.dat", "r+b" );
+
+        os::fpwrite( entries, 3U * sizeof( std::uint64_t ) /* EntryRecord::firstChunk */, &invalid, sizeof( invalid ) );
+        os::fpwrite( chunks, 1U * sizeof( std::uint64_t ) /* ChunkRecord::entryIndex */, &invalid, sizeof( invalid ) );
+    }
+
+    {
+        const auto corrupted = fsmd_t::createInstance< FilesystemMetadataRO >( corruptedPath, FilesystemMetadataMapped::OpenExisting );
+
+        UTF_REQUIRE_THROW( corrupted -> queryChunks( entryIds[ 0 ] ), UnexpectedException );
+        UTF_REQUIRE_THROW( corrupted -> queryChunksCount( entryIds[ 0 ] ), UnexpectedException );
+        UTF_REQUIRE_THROW( corrupted -> queryEntryId( expectedChunks[ entryIds[ 1 ] ].front() ), UnexpectedException );
+
+        /*
+         * The records which were not corrupted are still accessible
+         */
+
+        UTF_REQUIRE_EQUAL( corrupted -> queryChunksCount( entryIds[ 1 ] ), chunksPerFile );
+        UTF_REQUIRE( corrupted -> queryEntryId( expectedChunks[ entryIds[ 1 ] ][ 1 ] ) == entryIds[ 1 ] );
+    }
+}
@@ -20,4 +20,5 @@
 #include "TestDataModelDefault.h"
 #include "TestServerErrorHelpers.h"
 #include "TestFilesystemMetadataInMemory.h"
+#include "TestFilesystemMetadataMapped.h"
 #include "TestDataChunkStorageFilesystem.h"
@@ -399,3 +399,161 @@ UTF_AUTO_TEST_CASE( Client_SimpleSecureHttpSslGetTests )
         );
 }
 
+
+namespace
+{
+    template
+    <
+        typename TASKIMPL
+    >
+    void executeHttpRequestsWithConnectionsPool(
+        SAA_in          const bl::om::ObjPtr< typename TASKIMPL::connections_pool_t >&  connectionsPool,
+        SAA_in          const std::size_t                                               count
+        )
+    {
+        using namespace bl;
+        using namespace bl::tasks;
+
+        scheduleAndExecuteInParallel(
+            [ & ]( SAA_in const om::ObjPtr< ExecutionQueue >& eq ) -> void
+            {
+                eq -> setOptions( ExecutionQueue::OptionKeepAll );
+
+                for( std::size_t i = 0U; i < count; ++i )
+                {
+                    const auto stask = TASKIMPL::createInstance(
+                        cpp::copy( test::UtfArgsParser::host() ),
+                        cpp::copy( test::UtfArgsParser::port() ),
+                        utest::http::g_requestUri,
+                        "GET"                           /* action */,
+                        std::string()                   /* content */,
+                        http::HeadersMap()
+                        );
+
+                    stask -> setConnectionsPool( connectionsPool );
+
+                    const auto task = om::qi< Task >( stask );
+
+                    eq -> push_back( task );
+                    const auto executedTask = eq -> pop( true );
+
+                    UTF_REQUIRE( om::areEqual( task, executedTask ) );
+                    UTF_REQUIRE_EQUAL( Task::Completed, task -> getState() );
+
+                    if( stask -> isFailed() )
+                    {
+                        cpp::safeRethrowException( stask -> exception() );
+                    }
+
+                    UTF_REQUIRE_EQUAL( 200U, stask -> getHttpStatus() );
+                    UTF_REQUIRE( stask -> getResponse().size() );
+
+                    /*
+                     * The server keeps the connections alive, so only the first request should
+                     * open a new connection if the pool keeps the idle connections
+                     */
+
+                    UTF_REQUIRE_EQUAL(
+                        0U != i && 0U != connectionsPool -> maxIdleConnectionsPerEndpoint(),
+                        stask -> isReusedConnection()
+                        );
+                }
+            });
+    }
+
+} // __unnamed
+
+UTF_AUTO_TEST_CASE( Client_SimpleHttpConnectionsPoolTests )
+{
+    using namespace bl;
+    using namespace bl::tasks;
+
+    const std::size_t count = 5U;
+
+    const auto endpointId = resolveMessage(
+        BL_MSG()
+            << test::UtfArgsParser::host()
+            << ":"
+            << test::UtfArgsParser::port()
+        );
+
+    utest::http::HttpServerHelpers::startHttpServerAndExecuteCallback(
+        [ & ]() -> void
+        {
+            const auto connectionsPool = HttpConnectionsPool::createInstance();
+
+            executeHttpRequestsWithConnectionsPool< SimpleHttpTaskImpl >( connectionsPool, count );
+
+            UTF_REQUIRE_EQUAL( count - 1U, connectionsPool -> reusedConnectionsCount() );
+            UTF_REQUIRE_EQUAL( 1U, connectionsPool -> idleConnectionsCount( endpointId ) );
+            UTF_REQUIRE_EQUAL( 0U, connectionsPool -> resumedSessionsCount() );
+
+            /*
+             * After the pool is disposed the idle connections are closed and the connections
+             * which are returned to it are not kept
+             */
+
+            connectionsPool -> dispose();
+
+            UTF_REQUIRE_EQUAL( 0U, connectionsPool -> idleConnectionsCount( endpointId ) );
+
+            executeHttpRequestsWithConnectionsPool< SimpleHttpTaskImpl >( connectionsPool, 1U /* count */ );
+
+            UTF_REQUIRE_EQUAL( 0U, connectionsPool -> idleConnectionsCount( endpointId ) );
+        }
+        );
+
+    utest::http::HttpServerHelpers::startHttpServerAndExecuteCallback(
+        [ & ]() -> void
+        {
+            /*
+             * The idle connections which have expired are not reused
+             */
+
+            const auto connectionsPool = HttpConnectionsPool::createInstance(
+                HttpConnectionsPool::MAX_IDLE_CONNECTIONS_PER_ENDPOINT_DEFAULT,
+                time::milliseconds( 100 )                                       /* idleTimeout */
+                );
+
+            executeHttpRequestsWithConnectionsPool< SimpleHttpTaskImpl >( connectionsPool, 1U /* count */ );
+
+            UTF_REQUIRE_EQUAL( 1U, connectionsPool -> idleConnectionsCount( endpointId ) );
+
+            os::sleep( time::milliseconds( 200 ) );
+
+            executeHttpRequestsWithConnectionsPool< SimpleHttpTaskImpl >( connectionsPool, 1U /* count */ );
+
+            UTF_REQUIRE_EQUAL( 0U, connectionsPool -> reusedConnectionsCount() );
+            UTF_REQUIRE_EQUAL( 1U, connectionsPool -> idleConnectionsCount( endpointId ) );
+        }
+        );
+
+    utest::http::HttpServerHelpers::startHttpServerAndExecuteCallback< bl::httpserver::HttpSslServer >(
+        [ & ]() -> void
+        {
+            {
+                const auto connectionsPool = HttpSslConnectionsPool::createInstance();
+
+                executeHttpRequestsWithConnectionsPool< SimpleHttpSslTaskImpl >( connectionsPool, count );
+
+                UTF_REQUIRE_EQUAL( count - 1U, connectionsPool -> reusedConnectionsCount() );
+                UTF_REQUIRE_EQUAL( 1U, connectionsPool -> idleConnectionsCount( endpointId ) );
+            }
+
+            {
+                /*
+                 * If the idle connections are not kept then each request makes a new connection,
+                 * but the TLS session from the previous connection should be resumed
+                 */
+
+                const auto connectionsPool = HttpSslConnectionsPool::createInstance( 0U /* maxIdleConnectionsPerEndpoint */ );
+
+                executeHttpRequestsWithConnectionsPool< SimpleHttpSslTaskImpl >( connectionsPool, count );
+
+                UTF_REQUIRE_EQUAL( 0U, connectionsPool -> reusedConnectionsCount() );
+                UTF_REQUIRE_EQUAL( 0U, connectionsPool -> idleConnectionsCount( endpointId ) );
+                UTF_REQUIRE( connectionsPool -> resumedSessionsCount() > 0U );
+            }
+        }
+        );
+}
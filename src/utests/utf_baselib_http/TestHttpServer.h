@@ -159,6 +159,90 @@ UTF_AUTO_TEST_CASE( BaseLib_ResponseTest )
     }
 }
 
+UTF_AUTO_TEST_CASE( BaseLib_ResponseContentBlocksTest )
+{
+    using namespace bl;
+
+    typedef http::Parameters::HttpStatusCode        StatusCode;
+    typedef httpserver::Response                    Response;
+    typedef http::Parameters::HttpHeader            HttpHeader;
+
+    const std::string content = "abcdefgh";
+
+    {
+        /*
+         * The serialized response must be the concatenation of the parts which are sent
+         */
+
+        const auto response = Response::createInstance(
+            StatusCode::HTTP_SUCCESS_OK,
+            bl::cpp::copy( content )
+            );
+
+        UTF_REQUIRE( ! response -> hasContentBlocks() );
+        UTF_REQUIRE_EQUAL( response -> contentSize(), content.size() );
+
+        UTF_REQUIRE_EQUAL(
+            response -> getSerialized(),
+            response -> getStatusLine() + response -> getSerializedHeaders() + content
+            );
+
+        const auto& headers = response -> getSerializedHeaders();
+
+        UTF_REQUIRE_EQUAL( headers.substr( headers.size() - 4U ), HttpHeader::g_sentinel );
+    }
+
+    {
+        Response::content_blocks_t blocks;
+
+        std::string expectedContent;
+
+        for( std::size_t i = 0U; i < 3U; ++i )
+        {
+            const auto blockContent = content + bl::utils::lexical_cast< std::string >( i );
+
+            auto block = data::DataBlock::createInstance( blockContent.size() );
+
+            std::memcpy( block -> begin(), blockContent.c_str(), blockContent.size() );
+
+            blocks.push_back( std::move( block ) );
+
+            expectedContent += blockContent;
+        }
+
+        const auto response = Response::createInstance(
+            StatusCode::HTTP_SUCCESS_OK,
+            std::move( blocks )
+            );
+
+        UTF_REQUIRE( response -> hasContentBlocks() );
+        UTF_REQUIRE( response -> content().empty() );
+        UTF_REQUIRE_EQUAL( response -> contentBlocks().size(), 3U );
+        UTF_REQUIRE_EQUAL( response -> contentSize(), expectedContent.size() );
+
+        const auto pos = response -> headers().find( HttpHeader::g_contentLength );
+
+        UTF_REQUIRE( pos != response -> headers().end() );
+        UTF_REQUIRE_EQUAL( pos -> second, bl::utils::lexical_cast< std::string >( expectedContent.size() ) );
+
+        UTF_REQUIRE_EQUAL(
+            response -> getSerialized(),
+            response -> getStatusLine() + response -> getSerializedHeaders() + expectedContent
+            );
+    }
+
+    {
+        Response::content_blocks_t blocks;
+
+        blocks.push_back( nullptr );
+
+        UTF_REQUIRE_THROW(
+            Response::createInstance( StatusCode::HTTP_SUCCESS_OK, std::move( blocks ) ),
+            bl::UnexpectedException
+            );
+    }
+}
+
 UTF_AUTO_TEST_CASE( BaseLib_RequestTest )
 {
     using namespace bl;
@@ -251,11 +335,11 @@ UTF_AUTO_TEST_CASE( BaseLib_ParserHelpersTestMethodURIProtocol )
 
         httpserver::detail::Context context;
 
-        context.m_buffer.append( begin, end );
+        const std::string text( begin, end );
 
-        UTF_REQUIRE_EQUAL( request, context.m_buffer );
+        UTF_REQUIRE_EQUAL( request, text );
 
-        const auto result = ParserHelpers::parseMethodURIVersion( context.m_buffer, context );
+        const auto result = ParserHelpers::parseMethodURIVersion( text, context );
 
         UTF_REQUIRE_EQUAL( result.first, HttpParserResult::PARSED );
         UTF_REQUIRE( result.second == nullptr );
@@ -286,9 +370,9 @@ UTF_AUTO_TEST_CASE( BaseLib_ParserHelpersTestMethodURIProtocol )
 
         httpserver::detail::Context context;
 
-        context.m_buffer.append( begin, end );
+        const std::string text( begin, end );
 
-        const auto result = ParserHelpers::parseMethodURIVersion( context.m_buffer, context );
+        const auto result = ParserHelpers::parseMethodURIVersion( text, context );
 
         UTF_REQUIRE_EQUAL( result.first, HttpParserResult::PARSING_ERROR );
         UTF_REQUIRE( result.second != nullptr );
@@ -329,9 +413,9 @@ UTF_AUTO_TEST_CASE( BaseLib_ParserHelpersParseHeader )
 
         httpserver::detail::Context context;
 
-        context.m_buffer.append( begin, end );
+        const std::string text( begin, end );
 
-        const auto result = ParserHelpers::parseHeader( context.m_buffer, context );
+        const auto result = ParserHelpers::parseHeader( text, context );
 
         UTF_REQUIRE_EQUAL( result.first, HttpParserResult::PARSED );
         UTF_REQUIRE( result.second == nullptr );
@@ -360,9 +444,9 @@ UTF_AUTO_TEST_CASE( BaseLib_ParserHelpersParseHeader )
 
         httpserver::detail::Context context;
 
-        context.m_buffer.append( begin, end );
+        const std::string text( begin, end );
 
-        const auto result = ParserHelpers::parseHeader( context.m_buffer, context );
+        const auto result = ParserHelpers::parseHeader( text, context );
 
         UTF_REQUIRE_EQUAL( result.first, HttpParserResult::PARSED );
         UTF_REQUIRE( result.second == nullptr );
@@ -397,9 +481,9 @@ UTF_AUTO_TEST_CASE( BaseLib_ParserHelpersParseHeader )
         UTF_REQUIRE_EQUAL( context.m_headers.size(), 1U );
         UTF_REQUIRE_EQUAL( context.m_headers.find( headerName ) -> second, value );
 
-        context.m_buffer.append( begin, end );
+        const std::string text( begin, end );
 
-        const auto result = ParserHelpers::parseHeader( context.m_buffer, context );
+        const auto result = ParserHelpers::parseHeader( text, context );
 
         UTF_REQUIRE_EQUAL( result.first, HttpParserResult::PARSING_ERROR );
         UTF_REQUIRE( result.second != nullptr );
@@ -426,9 +510,9 @@ UTF_AUTO_TEST_CASE( BaseLib_ParserHelpersParseHeader )
 
         httpserver::detail::Context context;
 
-        context.m_buffer.append( begin, end );
+        const std::string text( begin, end );
 
-        const auto result = ParserHelpers::parseHeader( context.m_buffer, context );
+        const auto result = ParserHelpers::parseHeader( text, context );
 
         UTF_REQUIRE_EQUAL( result.first, HttpParserResult::PARSING_ERROR );
         UTF_REQUIRE( result.second != nullptr );
@@ -460,9 +544,9 @@ UTF_AUTO_TEST_CASE( BaseLib_ParserHelpersParseHeader )
 
         httpserver::detail::Context context;
 
-        context.m_buffer.append( begin, end );
+        const std::string text( begin, end );
 
-        const auto result = ParserHelpers::parseHeader( context.m_buffer, context );
+        const auto result = ParserHelpers::parseHeader( text, context );
 
         UTF_REQUIRE_EQUAL( result.first, HttpParserResult::PARSING_ERROR );
         UTF_REQUIRE( result.second != nullptr );
@@ -488,9 +572,9 @@ UTF_AUTO_TEST_CASE( BaseLib_ParserHelpersParseHeader )
 
         httpserver::detail::Context context;
 
-        context.m_buffer.append( begin, end );
+        const std::string text( begin, end );
 
-        const auto result = ParserHelpers::parseHeader( context.m_buffer, context );
+        const auto result = ParserHelpers::parseHeader( text, context );
 
         UTF_REQUIRE_EQUAL( result.first, HttpParserResult::PARSING_ERROR );
         UTF_REQUIRE( result.second != nullptr );
@@ -519,9 +603,9 @@ UTF_AUTO_TEST_CASE( BaseLib_ParserHelpersParseHeader )
 
         httpserver::detail::Context context;
 
-        context.m_buffer.append( begin, end );
+        const std::string text( begin, end );
 
-        const auto result = ParserHelpers::parseHeader( context.m_buffer, context );
+        const auto result = ParserHelpers::parseHeader( text, context );
 
         UTF_REQUIRE_EQUAL( result.first, HttpParserResult::PARSING_ERROR );
         UTF_REQUIRE( result.second != nullptr );
@@ -859,6 +943,177 @@ UTF_AUTO_TEST_CASE( BaseLib_ParserTest )
     }
 }
 
+UTF_AUTO_TEST_CASE( BaseLib_ParserPipeliningTest )
+{
+    using namespace bl;
+
+    typedef httpserver::Parser                          Parser;
+
+    typedef httpserver::detail::HttpParserResult        HttpParserResult;
+
+    const std::string requests =
+        "PUT /first HTTP/1.0\r\n"
+        "Content-Length: 5\r\n\r\n"
+        "01234"
+        "GET /second HTTP/1.0\r\n\r\n"
+        "GET /thi";
+
+    const char* begin = requests.c_str();
+    const char* end = begin + requests.length();
+
+    {
+        /*
+         * Test that the data after the request is an error if pipelining is not enabled
+         */
+
+        const auto parser = Parser::createInstance();
+
+        UTF_REQUIRE( ! parser -> isPipeliningEnabled() );
+
+        const auto result = parser -> parse( begin, end );
+
+        UTF_REQUIRE_EQUAL( result.first, HttpParserResult::PARSING_ERROR );
+        UTF_REQUIRE( result.second != nullptr );
+        UTF_REQUIRE( ! parser -> hasPendingData() );
+    }
+
+    {
+        /*
+         * Test that the pipelined requests are parsed one by one from the same buffer
+         */
+
+        const auto parser = Parser::createInstance();
+
+        parser -> isPipeliningEnabled( true );
+
+        auto result = parser -> parse( begin, end );
+
+        UTF_REQUIRE_EQUAL( result.first, HttpParserResult::PARSED );
+        UTF_REQUIRE( result.second == nullptr );
+        UTF_REQUIRE( parser -> hasPendingData() );
+
+        auto request = parser -> buildRequest();
+
+        UTF_REQUIRE_EQUAL( request -> method(), "PUT" );
+        UTF_REQUIRE_EQUAL( request -> uri(), "/first" );
+        UTF_REQUIRE_EQUAL( request -> body(), "01234" );
+
+        result = parser -> parseNext();
+
+        UTF_REQUIRE_EQUAL( result.first, HttpParserResult::PARSED );
+        UTF_REQUIRE( parser -> hasPendingData() );
+
+        request = parser -> buildRequest();
+
+        UTF_REQUIRE_EQUAL( request -> method(), "GET" );
+        UTF_REQUIRE_EQUAL( request -> uri(), "/second" );
+        UTF_REQUIRE( request -> body().empty() );
+
+        /*
+         * The third request is incomplete, so more data is required
+         */
+
+        result = parser -> parseNext();
+
+        UTF_REQUIRE_EQUAL( result.first, HttpParserResult::MORE_DATA_REQUIRED );
+        UTF_REQUIRE( ! parser -> hasPendingData() );
+        UTF_REQUIRE_THROW( parser -> buildRequest(), bl::UnexpectedException );
+
+        const std::string remainder = "rd HTTP/1.0\r\nConnection: keep-alive\r\n\r\n";
+
+        result = parser -> parse( remainder.c_str(), remainder.c_str() + remainder.length() );
+
+        UTF_REQUIRE_EQUAL( result.first, HttpParserResult::PARSED );
+        UTF_REQUIRE( ! parser -> hasPendingData() );
+
+        request = parser -> buildRequest();
+
+        UTF_REQUIRE_EQUAL( request -> uri(), "/third" );
+        UTF_REQUIRE( request -> isKeepAliveRequested() );
+
+        result = parser -> parseNext();
+
+        UTF_REQUIRE_EQUAL( result.first, HttpParserResult::MORE_DATA_REQUIRED );
+        UTF_REQUIRE( result.second == nullptr );
+    }
+}
+
+UTF_AUTO_TEST_CASE( BaseLib_ParserBodySliceTest )
+{
+    using namespace bl;
+
+    typedef httpserver::Parser                          Parser;
+
+    typedef httpserver::detail::HttpParserResult        HttpParserResult;
+
+    const std::string body( 16U * 1024U, 'x' );
+
+    const std::string headers =
+        "PUT /first HTTP/1.0\r\n"
+        "Content-Length: " + bl::utils::lexical_cast< std::string >( body.size() ) + "\r\n\r\n";
+
+    const std::string requests = headers + body + "GET /second HTTP/1.0\r\n\r\n";
+
+    const auto parser = Parser::createInstance();
+
+    parser -> isPipeliningEnabled( true );
+
+    /*
+     * Feed the data in small pieces, so the input buffer has to grow
+     */
+
+    const std::size_t pieceSize = 1000U;
+
+    auto result = parser -> parse( requests.c_str(), requests.c_str() + pieceSize );
+
+    for( std::size_t pos = pieceSize; result.first == HttpParserResult::MORE_DATA_REQUIRED; pos += pieceSize )
+    {
+        UTF_REQUIRE( pos < requests.size() );
+
+        result = parser -> parse(
+            requests.c_str() + pos,
+            requests.c_str() + std::min( pos + pieceSize, requests.size() )
+            );
+    }
+
+    UTF_REQUIRE_EQUAL( result.first, HttpParserResult::PARSED );
+
+    const auto request = parser -> buildRequest();
+
+    /*
+     * The body is a slice of the block holding the whole request
+     */
+
+    const auto& block = request -> bodyBlock();
+
+    UTF_REQUIRE( nullptr != block );
+    UTF_REQUIRE_EQUAL( request -> bodyOffset(), headers.size() );
+    UTF_REQUIRE_EQUAL( request -> bodySize(), body.size() );
+    UTF_REQUIRE( request -> bodyData() == block -> begin() + headers.size() );
+    UTF_REQUIRE_EQUAL( request -> body(), body );
+
+    /*
+     * The pipelined request must not overwrite the body of the previous request
+     */
+
+    result = parser -> parseNext();
+
+    UTF_REQUIRE_EQUAL( result.first, HttpParserResult::PARSED );
+
+    const auto nextRequest = parser -> buildRequest();
+
+    UTF_REQUIRE_EQUAL( nextRequest -> uri(), "/second" );
+    UTF_REQUIRE_EQUAL( nextRequest -> bodySize(), 0U );
+    UTF_REQUIRE( nextRequest -> bodyData() == nullptr );
+    UTF_REQUIRE( ! nextRequest -> bodyBlock() );
+
+    UTF_REQUIRE_EQUAL( request -> body(), body );
+
+    result = parser -> parseNext();
+
+    UTF_REQUIRE_EQUAL( result.first, HttpParserResult::MORE_DATA_REQUIRED );
+}
+
 UTF_AUTO_TEST_CASE( BaseLib_HttpServerImplTest )
 {
     using namespace bl;
@@ -881,6 +1136,451 @@ UTF_AUTO_TEST_CASE( BaseLib_HttpServerImplTest )
         );
 }
 
+UTF_AUTO_TEST_CASE( BaseLib_HttpServerRequestKeepAliveTest )
+{
+    using namespace bl;
+
+    const auto isKeepAliveRequested = []( SAA_in const std::string& name, SAA_in const std::string& value ) -> bool
+    {
+        http::HeadersMap headers;
+
+        headers[ name ] = value;
+
+        return httpserver::Request::createInstance(
+            std::string( "GET" ),
+            std::string( "/" ),
+            std::move( headers )
+            )
+            -> isKeepAliveRequested();
+    };
+
+    UTF_REQUIRE( isKeepAliveRequested( "Connection", "keep-alive" ) );
+    UTF_REQUIRE( isKeepAliveRequested( "connection", "Keep-Alive" ) );
+    UTF_REQUIRE( isKeepAliveRequested( "CONNECTION", "Upgrade, Keep-Alive" ) );
+    UTF_REQUIRE( isKeepAliveRequested( "Connection", "Keep-Alive, Upgrade" ) );
+
+    UTF_REQUIRE( ! isKeepAliveRequested( "Connection", "close" ) );
+    UTF_REQUIRE( ! isKeepAliveRequested( "Connection", "keep-alive, close" ) );
+    UTF_REQUIRE( ! isKeepAliveRequested( "Connection", "Upgrade" ) );
+    UTF_REQUIRE( ! isKeepAliveRequested( "Connection", "keep-alive-not" ) );
+    UTF_REQUIRE( ! isKeepAliveRequested( "Keep-Alive", "keep-alive" ) );
+
+    UTF_REQUIRE( ! httpserver::Request::createInstance( std::string( "GET" ), std::string( "/" ) ) -> isKeepAliveRequested() );
+}
+
+UTF_AUTO_TEST_CASE( BaseLib_HttpServerKeepAliveTest )
+{
+    using namespace bl;
+    using namespace bl::tasks;
+    using namespace utest::http;
+
+    typedef bl::asio::ip::tcp                           tcp;
+
+    const auto createRequest = []( SAA_in const bool keepAlive ) -> std::string
+    {
+        return
+            "GET " + g_requestPerfUri + " HTTP/1.0\r\n" +
+            ( keepAlive ? "Connection: keep-alive\r\n" : "" ) +
+            "\r\n";
+    };
+
+    const auto countOf = []( SAA_in const std::string& text, SAA_in const std::string& pattern ) -> std::size_t
+    {
+        std::size_t count = 0U;
+
+        for( auto pos = text.find( pattern ); pos != std::string::npos; pos = text.find( pattern, pos + 1U ) )
+        {
+            ++count;
+        }
+
+        return count;
+    };
+
+    /*
+     * Sends the requests on a single connection, one batch at a time (each batch is written
+     * with a single write, so the requests in it are pipelined) and it waits for the
+     * responses of each batch before sending the next one
+     *
+     * After the last batch it reads until the server closes the connection
+     */
+
+    const auto sendRequests = [ & ]( SAA_in const std::vector< std::string >& batches ) -> std::string
+    {
+        asio::io_service aioService;
+        tcp::socket socket( aioService );
+
+        socket.connect(
+            tcp::endpoint( asio::ip::address::from_string( "127.0.0.1" ), test::UtfArgsParser::port() )
+            );
+
+        std::string responses;
+        std::size_t requestsCount = 0U;
+        char buffer[ 1024 ];
+
+        for( std::size_t i = 0U; i < batches.size(); ++i )
+        {
+            asio::write( socket, asio::buffer( batches[ i ] ) );
+
+            requestsCount += countOf( batches[ i ], " HTTP/1.0\r\n" );
+
+            const bool isLastBatch = ( i + 1U ) == batches.size();
+
+            while( isLastBatch || countOf( responses, g_desiredPerfResult ) < requestsCount )
+            {
+                eh::error_code ec;
+
+                const auto bytesRead = socket.read_some( asio::buffer( buffer ), ec );
+
+                if( ec )
+                {
+                    UTF_REQUIRE( asio::error::eof == ec );
+                    UTF_REQUIRE( isLastBatch );
+
+                    break;
+                }
+
+                responses.append( buffer, bytesRead );
+            }
+        }
+
+        return responses;
+    };
+
+    const auto idleTimeout = time::seconds( 1L );
+    const std::size_t maxRequests = 3U;
+
+    const auto callback = [ & ]() -> void
+    {
+        {
+            /*
+             * Pipelined persistent requests - the last one does not ask for keep-alive
+             */
+
+            const auto responses = sendRequests(
+                {
+                    createRequest( true ) + createRequest( true ) + createRequest( false )
+                }
+                );
+
+            UTF_REQUIRE_EQUAL( countOf( responses, "HTTP/1.0 200 OK\r\n" ), 3U );
+            UTF_REQUIRE_EQUAL( countOf( responses, g_desiredPerfResult ), 3U );
+            UTF_REQUIRE_EQUAL( countOf( responses, "Connection: keep-alive\r\n" ), 2U );
+            UTF_REQUIRE_EQUAL( countOf( responses, "Connection: close\r\n" ), 0U );
+        }
+
+        {
+            /*
+             * The 'Connection' header name and value are case-insensitive and the value is
+             * a list of tokens; a request pipelined after a request which does not ask for
+             * keep-alive is not processed and the client is told the connection is closed
+             */
+
+            const auto responses = sendRequests(
+                {
+                    "GET " + g_requestPerfUri + " HTTP/1.0\r\nconnection: Keep-Alive, Upgrade\r\n\r\n" +
+                    createRequest( false ) +
+                    createRequest( true )
+                }
+                );
+
+            UTF_REQUIRE_EQUAL( countOf( responses, "HTTP/1.0 200 OK\r\n" ), 2U );
+            UTF_REQUIRE_EQUAL( countOf( responses, g_desiredPerfResult ), 2U );
+            UTF_REQUIRE_EQUAL( countOf( responses, "Connection: keep-alive\r\n" ), 1U );
+            UTF_REQUIRE_EQUAL( countOf( responses, "Connection: close\r\n" ), 1U );
+        }
+
+        {
+            /*
+             * Sequential persistent requests - the connection is closed after the max
+             * requests limit is reached and the last response says so
+             */
+
+            const auto responses = sendRequests(
+                {
+                    createRequest( true ),
+                    createRequest( true ),
+                    createRequest( true ) + createRequest( true )
+                }
+                );
+
+            UTF_REQUIRE_EQUAL( countOf( responses, g_desiredPerfResult ), maxRequests );
+            UTF_REQUIRE_EQUAL( countOf( responses, "Connection: keep-alive\r\n" ), maxRequests - 1U );
+            UTF_REQUIRE_EQUAL( countOf( responses, "Connection: close\r\n" ), 1U );
+        }
+
+        {
+            /*
+             * The idle connection is closed by the server after the idle timeout
+             */
+
+            const auto startTime = time::microsec_clock::universal_time();
+
+            const auto responses = sendRequests( { createRequest( true ) } );
+
+            const auto elapsed = time::microsec_clock::universal_time() - startTime;
+
+            UTF_REQUIRE_EQUAL( countOf( responses, g_desiredPerfResult ), 1U );
+            UTF_REQUIRE_EQUAL( countOf( responses, "Connection: keep-alive\r\n" ), 1U );
+            UTF_REQUIRE( elapsed >= idleTimeout - time::milliseconds( 100L ) );
+        }
+    };
+
+    test::MachineGlobalTestLock lock;
+
+    const auto acceptor = httpserver::HttpServer::createInstance(
+        ServerBackendProcessingImplTest::createInstance< ServerBackendProcessing >(),
+        nullptr                                             /* controlToken */,
+        "0.0.0.0"                                           /* host */,
+        test::UtfArgsParser::port(),
+        test::UtfCrypto::getDefaultServerKey()              /* privateKeyPem */,
+        test::UtfCrypto::getDefaultServerCertificate()      /* certificatePem */,
+        idleTimeout                                         /* keepAliveIdleTimeout */,
+        maxRequests                                         /* keepAliveMaxRequests */
+        );
+
+    utest::TestTaskUtils::startAcceptorAndExecuteCallback( callback, acceptor );
+}
+
+UTF_AUTO_TEST_CASE( BaseLib_HttpServerStreamedResponseTest )
+{
+    using namespace bl;
+    using namespace bl::tasks;
+    using namespace utest::http;
+
+    typedef bl::asio::ip::tcp                           tcp;
+
+    /*
+     * The content is much larger than the block it is produced into and it is sent with
+     * multiple writes, so it is never allocated or held in memory as a whole
+     */
+
+    const std::uint64_t contentSize = 64U * 1024U * 1024U + 17U;
+    const std::size_t blockSize = 64U * 1024U;
+
+    {
+        const auto content = TestStreamedContent::createInstance( 3U * blockSize + 1U, blockSize );
+
+        const auto response = Response::createInstance(
+            http::Parameters::HTTP_SUCCESS_OK,
+            content -> getProducer()
+            );
+
+        UTF_REQUIRE( response -> isStreamed() );
+        UTF_REQUIRE( ! response -> hasContentBlocks() );
+        UTF_REQUIRE( response -> content().empty() );
+        UTF_REQUIRE_EQUAL( response -> contentSize(), 0U );
+
+        UTF_REQUIRE( response -> headers().find( HttpHeader::g_contentLength ) == response -> headers().end() );
+        UTF_REQUIRE( response -> headers().find( HttpHeader::g_contentType ) != response -> headers().end() );
+
+        UTF_REQUIRE_EQUAL(
+            response -> getSerialized(),
+            response -> getStatusLine() + response -> getSerializedHeaders()
+            );
+
+        UTF_REQUIRE_EQUAL( content -> blocksProduced(), 0U );
+
+        std::size_t size = 0U;
+
+        while( const auto block = response -> contentProducer()() )
+        {
+            UTF_REQUIRE( block -> size() <= blockSize );
+
+            size += block -> size();
+        }
+
+        UTF_REQUIRE_EQUAL( size, 3U * blockSize + 1U );
+        UTF_REQUIRE_EQUAL( content -> blocksProduced(), 4U );
+
+        UTF_REQUIRE_THROW(
+            Response::createInstance( http::Parameters::HTTP_SUCCESS_OK, Response::content_producer_t() ),
+            bl::UnexpectedException
+            );
+    }
+
+    /*
+     * Reads the response until the server closes the connection and verifies the content
+     * as it arrives
+     *
+     * Since the content is delimited by closing the connection the response must not have
+     * Content-Length and a client which asked for keep-alive must be told the connection is
+     * going to be closed
+     */
+
+    const auto sendRequest = [ & ]( SAA_in const bool keepAlive ) -> void
+    {
+        asio::io_service aioService;
+        tcp::socket socket( aioService );
+
+        socket.connect(
+            tcp::endpoint( asio::ip::address::from_string( "127.0.0.1" ), test::UtfArgsParser::port() )
+            );
+
+        asio::write(
+            socket,
+            asio::buffer(
+                "GET " + g_requestPerfUri + " HTTP/1.0\r\n" +
+                ( keepAlive ? "Connection: keep-alive\r\n" : "" ) +
+                "\r\n"
+                )
+            );
+
+        std::string headers;
+        std::uint64_t contentReceived = 0U;
+        bool headersReceived = false;
+
+        std::vector< char > buffer( blockSize );
+
+        for( ;; )
+        {
+            eh::error_code ec;
+
+            const auto bytesRead = socket.read_some( asio::buffer( buffer ), ec );
+
+            if( ec )
+            {
+                UTF_REQUIRE( asio::error::eof == ec );
+
+                break;
+            }
+
+            std::size_t pos = 0U;
+
+            if( ! headersReceived )
+            {
+                const auto oldSize = headers.size();
+
+                headers.append( buffer.data(), bytesRead );
+
+                const auto sentinelPos = headers.find( HttpHeader::g_sentinel );
+
+                if( sentinelPos == std::string::npos )
+                {
+                    continue;
+                }
+
+                headersReceived = true;
+                pos = sentinelPos + HttpHeader::g_sentinel.size() - oldSize;
+                headers.resize( sentinelPos + HttpHeader::g_sentinel.size() );
+            }
+
+            for( ; pos < bytesRead; ++pos )
+            {
+                if( ! TestStreamedContent::isExpectedByte( contentReceived, buffer[ pos ] ) )
+                {
+                    UTF_FAIL( BL_MSG() << "Unexpected content byte at offset " << contentReceived );
+                }
+
+                ++contentReceived;
+            }
+        }
+
+        UTF_REQUIRE( headersReceived );
+        UTF_REQUIRE_EQUAL( headers.find( "HTTP/1.0 200 OK\r\n" ), 0U );
+        UTF_REQUIRE( headers.find( HttpHeader::g_contentLength ) == std::string::npos );
+        UTF_REQUIRE( headers.find( "Connection: keep-alive\r\n" ) == std::string::npos );
+        UTF_REQUIRE_EQUAL( headers.find( "Connection: close\r\n" ) != std::string::npos, keepAlive );
+        UTF_REQUIRE_EQUAL( contentReceived, contentSize );
+    };
+
+    const auto callback = [ & ]() -> void
+    {
+        sendRequest( false /* keepAlive */ );
+        sendRequest( true /* keepAlive */ );
+    };
+
+    test::MachineGlobalTestLock lock;
+
+    const auto acceptor = httpserver::HttpServer::createInstance(
+        TestStreamedBackend::createInstance< ServerBackendProcessing >( contentSize, blockSize ),
+        nullptr                                             /* controlToken */,
+        "0.0.0.0"                                           /* host */,
+        test::UtfArgsParser::port(),
+        test::UtfCrypto::getDefaultServerKey()              /* privateKeyPem */,
+        test::UtfCrypto::getDefaultServerCertificate()      /* certificatePem */
+        );
+
+    utest::TestTaskUtils::startAcceptorAndExecuteCallback( callback, acceptor );
+}
+
+UTF_AUTO_TEST_CASE( BaseLib_HttpServerShardedTest )
+{
+    using namespace bl;
+    using namespace bl::tasks;
+    using namespace utest::http;
+
+    test::MachineGlobalTestLock lock;
+
+    const std::size_t shardsCount = 4U;
+
+    const auto shards = om::lockDisposable( ThreadPoolShards::createInstance( shardsCount ) );
+
+    UTF_REQUIRE_EQUAL( shards -> size(), shardsCount );
+
+    /*
+     * Each request is sent on a new connection and the kernel distributes the connections
+     * across the shard acceptors (based on the hash of the connection's endpoints)
+     */
+
+    const std::size_t count = 20U;
+
+    {
+        const auto acceptor = httpserver::HttpServer::createInstance(
+            ServerBackendProcessingImplTest::createInstance< ServerBackendProcessing >(),
+            nullptr                                             /* controlToken */,
+            "0.0.0.0"                                           /* host */,
+            test::UtfArgsParser::port(),
+            test::UtfCrypto::getDefaultServerKey()              /* privateKeyPem */,
+            test::UtfCrypto::getDefaultServerCertificate()      /* certificatePem */
+            );
+
+        acceptor -> enableSharding( om::copy( shards ) );
+
+        utest::TestTaskUtils::startAcceptorAndExecuteCallback(
+            [ & ]() -> void
+            {
+                scheduleAndExecuteInParallel(
+                    [ & ]( SAA_in const om::ObjPtr< ExecutionQueue >& eq ) -> void
+                    {
+                        for( std::size_t i = 0U; i < count; ++i )
+                        {
+                            HttpServerHelpers::sendAndVerifyAssortedHttpRequests< SimpleHttpPutTaskImpl >( eq );
+                        }
+                    });
+            },
+            acceptor
+            );
+    }
+
+    {
+        const auto acceptor = httpserver::HttpSslServer::createInstance(
+            ServerBackendProcessingImplTest::createInstance< ServerBackendProcessing >(),
+            nullptr                                             /* controlToken */,
+            "0.0.0.0"                                           /* host */,
+            test::UtfArgsParser::port(),
+            test::UtfCrypto::getDefaultServerKey()              /* privateKeyPem */,
+            test::UtfCrypto::getDefaultServerCertificate()      /* certificatePem */
+            );
+
+        acceptor -> enableSharding( om::copy( shards ) );
+
+        utest::TestTaskUtils::startAcceptorAndExecuteCallback(
+            [ & ]() -> void
+            {
+                scheduleAndExecuteInParallel(
+                    [ & ]( SAA_in const om::ObjPtr< ExecutionQueue >& eq ) -> void
+                    {
+                        for( std::size_t i = 0U; i < count; ++i )
+                        {
+                            HttpServerHelpers::sendAndVerifyAssortedHttpRequests< SimpleHttpSslPutTaskImpl >( eq );
+                        }
+                    });
+            },
+            acceptor
+            );
+    }
+}
+
 UTF_AUTO_TEST_CASE( BaseLib_HttpServerPerfTest )
 {
     using namespace bl;
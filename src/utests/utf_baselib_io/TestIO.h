@@ -28,6 +28,7 @@
 #include <baselib/messaging/MessagingClientBlockDispatch.h>
 #include <baselib/messaging/MessagingClientBlock.h>
 #include <baselib/messaging/MessagingClientFactory.h>
+#include <baselib/messaging/MessagingUtils.h>
 #include <baselib/messaging/BrokerErrorCodes.h>
 
 #include <baselib/tasks/TasksUtils.h>
@@ -469,6 +470,11 @@ namespace
                             UTF_REQUIRE_EQUAL( serverConnection -> peerId(), remotePeerId );
                             UTF_REQUIRE_EQUAL( serverConnection -> remotePeerId(), peerId );
 
+                            UTF_REQUIRE_EQUAL(
+                                transfer -> peerCapabilities(),
+                                std::uint16_t( CommandBlock::CapabilitiesSupported )
+                                );
+
                             /*
                              * Verify that resetting the version also resets the remotePeerId() and
                              * then after re-negotiating the version again the remotePeerId() is
@@ -2595,6 +2601,26 @@ UTF_AUTO_TEST_CASE( IO_BinaryProtocolInvariants )
         offsetof( CommandBlock::DataHeader::tagReserved, reserved1 )
         );
 
+    UTF_REQUIRE_EQUAL(
+        offsetof( CommandBlock::DataHeader::tagVersion, capabilitiesRequested ),
+        offsetof( CommandBlock::DataHeader::tagReserved, reserved2 )
+        );
+
+    UTF_REQUIRE_EQUAL(
+        offsetof( CommandBlock::DataHeader::tagVersion, capabilitiesAccepted ),
+        offsetof( CommandBlock::DataHeader::tagReserved, reserved4 )
+        );
+
+    UTF_REQUIRE_EQUAL(
+        sizeof( command.data.version.capabilitiesRequested ),
+        sizeof( command.data.reserved.reserved2 )
+        );
+
+    UTF_REQUIRE_EQUAL(
+        sizeof( command.data.version.capabilitiesAccepted ),
+        sizeof( command.data.reserved.reserved4 )
+        );
+
     UTF_REQUIRE_EQUAL(
         offsetof( CommandBlock::DataHeader::tagBlockInfo, flags ),
         offsetof( CommandBlock::DataHeader::tagReserved, reserved1 )
@@ -2720,6 +2746,358 @@ UTF_AUTO_TEST_CASE( IO_BinaryProtocolInvariants )
     }
 }
 
+UTF_AUTO_TEST_CASE( IO_BinaryProtocolDataFallbackTests )
+{
+    using namespace bl;
+    using namespace bl::tasks;
+    using namespace bl::messaging;
+
+    typedef tasks::detail::CommandBlock CommandBlock;
+
+    test::MachineGlobalTestLock lock;
+
+    /*
+     * Emulate an older server which doesn't know about the optional capabilities: it acknowledges
+     * each command by echoing back the command block and it records the protocol data of the data
+     * blocks which were sent to it
+     */
+
+    tcp::acceptor acceptor(
+        ThreadPoolDefault::getDefault() -> aioService(),
+        tcp::endpoint( asio::ip::address_v4::loopback(), 28100 )
+        );
+
+    tcp::socket serverSocket( ThreadPoolDefault::getDefault() -> aioService() );
+
+    os::mutex lockReceived;
+    std::vector< std::string > protocolDataReceived;
+
+    const auto runOldServer = [ & ]() -> void
+    {
+        for( ;; )
+        {
+            CommandBlock command;
+            eh::error_code ec;
+
+            asio::read( serverSocket, asio::buffer( &command, sizeof( command ) ), ec );
+
+            if( ec )
+            {
+                break;
+            }
+
+            CommandBlock ack( command );
+
+            ack.flags |= os::host2NetworkShort( CommandBlock::AckBit );
+
+            asio::write( serverSocket, asio::buffer( &ack, sizeof( ack ) ) );
+
+            command.network2Host();
+
+            if( CommandBlock::CntrlCodePutDataBlock == command.cntrlCode )
+            {
+                std::string data( command.chunkSize, '\0' );
+
+                asio::read( serverSocket, asio::buffer( &data[ 0 ], data.size() ) );
+
+                {
+                    BL_MUTEX_GUARD( lockReceived );
+
+                    protocolDataReceived.push_back( data.substr( command.data.blockInfo.protocolDataOffset ) );
+                }
+
+                asio::write( serverSocket, asio::buffer( &ack, sizeof( ack ) ) );
+            }
+        }
+    };
+
+    const auto brokerProtocol = MessagingUtils::createBrokerProtocolMessage(
+        MessageType::AsyncRpcDispatch,
+        uuids::create()                     /* conversationId */,
+        "tokenType"                         /* tokenType */,
+        "tokenData"                         /* tokenData */
+        );
+
+    const auto expectedJson = MessagingUtils::serializeBrokerProtocol( brokerProtocol );
+
+    const auto payload = dm::DataModelUtils::loadFromJsonText< Payload >( std::string( "{}" ) );
+
+    const auto dataBlocksPool = data::datablocks_pool_type::createInstance();
+
+    tasks::scheduleAndExecuteInParallel(
+        [ & ]( SAA_in const om::ObjPtr< tasks::ExecutionQueue >& eq ) -> void
+        {
+            const auto connector = connector_t::createInstance( "127.0.0.1", 28100 );
+            const auto taskConnector = om::qi< tasks::Task >( connector.get() );
+            eq -> push_back( taskConnector );
+
+            acceptor.accept( serverSocket );
+
+            eq -> waitForSuccess( taskConnector );
+
+            os::thread serverThread( runOldServer );
+
+            const auto guard = BL_SCOPE_GUARD(
+                {
+                    eh::error_code ec;
+
+                    serverSocket.shutdown( tcp::socket::shutdown_both, ec );
+                    serverThread.join();
+                }
+                );
+
+            const auto transfer = connection_t::createInstance(
+                connection_t::CommandId::NoCommand,
+                uuids::create() /* peerId */,
+                dataBlocksPool
+                );
+
+            transfer -> attachStream( connector -> detachStream() );
+            transfer -> hasBrokerProtocolData( true );
+
+            const auto taskTransfer = om::qi< tasks::Task >( transfer.get() );
+            eq -> push_back( taskTransfer );
+            eq -> waitForSuccess( taskTransfer );
+
+            UTF_REQUIRE( transfer -> isClientVersionNegotiated() );
+            UTF_REQUIRE_EQUAL( transfer -> peerCapabilities(), 0U );
+
+            const auto sendBlock = [ & ]( SAA_in const om::ObjPtr< data::DataBlock >& dataBlock ) -> std::string
+            {
+                transfer -> setCommandInfoRawPtr( connection_t::CommandId::SendChunk, uuids::create(), dataBlock.get() );
+
+                eq -> push_back( taskTransfer );
+                eq -> waitForSuccess( taskTransfer );
+
+                BL_MUTEX_GUARD( lockReceived );
+
+                UTF_REQUIRE( ! protocolDataReceived.empty() );
+
+                return protocolDataReceived.back();
+            };
+
+            /*
+             * The binary protocol data (with and without a payload) is re-encoded as JSON for a peer
+             * which has not acknowledged the binary format and the original block is left unchanged
+             */
+
+            for( const auto withPayload : { true, false } )
+            {
+                const auto binaryBlock = MessagingUtils::serializeObjectsToBlock(
+                    brokerProtocol,
+                    withPayload ? om::copy( payload ) : nullptr,
+                    dataBlocksPool,
+                    0U /* capacity */,
+                    true /* useBinaryProtocol */
+                    );
+
+                const auto binaryCopy = data::DataBlock::copy( binaryBlock );
+
+                UTF_REQUIRE_EQUAL( sendBlock( binaryBlock ), expectedJson );
+
+                UTF_REQUIRE( MessagingUtils::isBinaryProtocolData( binaryBlock ) );
+                UTF_REQUIRE_EQUAL( binaryBlock -> size(), binaryCopy -> size() );
+                UTF_REQUIRE_EQUAL( 0, std::memcmp( binaryBlock -> begin(), binaryCopy -> begin(), binaryBlock -> size() ) );
+            }
+
+            /*
+             * JSON protocol data is sent as is and blocks on connections which don't carry messaging
+             * blocks are never touched
+             */
+
+            UTF_REQUIRE_EQUAL(
+                sendBlock( MessagingUtils::serializeObjectsToBlock( brokerProtocol, payload, dataBlocksPool ) ),
+                expectedJson
+                );
+
+            transfer -> hasBrokerProtocolData( false );
+
+            const auto binaryBlock = MessagingUtils::serializeObjectsToBlock(
+                brokerProtocol,
+                payload,
+                dataBlocksPool,
+                0U /* capacity */,
+                true /* useBinaryProtocol */
+                );
+
+            UTF_REQUIRE_EQUAL(
+                sendBlock( binaryBlock ),
+                std::string( binaryBlock -> begin() + binaryBlock -> offset1(), binaryBlock -> end() )
+                );
+        }
+        );
+}
+
+UTF_AUTO_TEST_CASE( IO_PutDataWithCommandTests )
+{
+    using namespace bl;
+    using namespace bl::tasks;
+    using namespace bl::messaging;
+
+    typedef tasks::detail::CommandBlock CommandBlock;
+
+    test::MachineGlobalTestLock lock;
+
+    /*
+     * Emulate a server which accepts only the put data with command capability: it reads the
+     * data of a put data command right after the command block and it sends back a single
+     * acknowledgment after that (so a client which waits for the command to be acknowledged
+     * before it sends the data would hang here)
+     *
+     * The data blocks which start with "fail" are rejected with an error
+     */
+
+    tcp::acceptor acceptor(
+        ThreadPoolDefault::getDefault() -> aioService(),
+        tcp::endpoint( asio::ip::address_v4::loopback(), 28100 )
+        );
+
+    tcp::socket serverSocket( ThreadPoolDefault::getDefault() -> aioService() );
+
+    os::mutex lockReceived;
+    std::vector< std::string > dataReceived;
+    std::size_t acksSent = 0U;
+
+    const auto runServer = [ & ]() -> void
+    {
+        for( ;; )
+        {
+            CommandBlock command;
+            eh::error_code ec;
+
+            asio::read( serverSocket, asio::buffer( &command, sizeof( command ) ), ec );
+
+            if( ec )
+            {
+                break;
+            }
+
+            command.network2Host();
+
+            CommandBlock ack( command );
+
+            ack.flags |= CommandBlock::AckBit;
+
+            if( CommandBlock::CntrlCodeSetProtocolVersion == command.cntrlCode )
+            {
+                ack.data.version.capabilitiesAccepted = CommandBlock::CapabilityPutDataWithCommand;
+            }
+            else if( CommandBlock::CntrlCodePutDataBlock == command.cntrlCode )
+            {
+                std::string data( command.chunkSize, '\0' );
+
+                asio::read( serverSocket, asio::buffer( &data[ 0 ], data.size() ) );
+
+                if( 0U == data.find( "fail" ) )
+                {
+                    ack.flags |= CommandBlock::ErrBit;
+                    ack.errorCode = eh::errc::make_error_code( eh::errc::invalid_argument ).value();
+                }
+
+                BL_MUTEX_GUARD( lockReceived );
+
+                dataReceived.push_back( std::move( data ) );
+                ++acksSent;
+            }
+
+            ack.host2Network();
+
+            asio::write( serverSocket, asio::buffer( &ack, sizeof( ack ) ) );
+        }
+    };
+
+    const auto dataBlocksPool = data::datablocks_pool_type::createInstance();
+
+    tasks::scheduleAndExecuteInParallel(
+        [ & ]( SAA_in const om::ObjPtr< tasks::ExecutionQueue >& eq ) -> void
+        {
+            const auto connector = connector_t::createInstance( "127.0.0.1", 28100 );
+            const auto taskConnector = om::qi< tasks::Task >( connector.get() );
+            eq -> push_back( taskConnector );
+
+            acceptor.accept( serverSocket );
+
+            eq -> waitForSuccess( taskConnector );
+
+            os::thread serverThread( runServer );
+
+            const auto guard = BL_SCOPE_GUARD(
+                {
+                    eh::error_code ec;
+
+                    serverSocket.shutdown( tcp::socket::shutdown_both, ec );
+                    serverThread.join();
+                }
+                );
+
+            const auto transfer = connection_t::createInstance(
+                connection_t::CommandId::NoCommand,
+                uuids::create() /* peerId */,
+                dataBlocksPool
+                );
+
+            transfer -> attachStream( connector -> detachStream() );
+
+            const auto taskTransfer = om::qi< tasks::Task >( transfer.get() );
+            eq -> push_back( taskTransfer );
+            eq -> waitForSuccess( taskTransfer );
+
+            UTF_REQUIRE( transfer -> isClientVersionNegotiated() );
+
+            UTF_REQUIRE_EQUAL(
+                transfer -> peerCapabilities(),
+                std::uint16_t( CommandBlock::CapabilityPutDataWithCommand )
+                );
+
+            const auto sendBlock = [ & ]( SAA_in const std::string& text ) -> void
+            {
+                const auto dataBlock = data::DataBlock::createInstance( text.size() );
+
+                std::memcpy( dataBlock -> begin(), text.c_str(), text.size() );
+                dataBlock -> setSize( text.size() );
+
+                transfer -> setCommandInfoRawPtr( connection_t::CommandId::SendChunk, uuids::create(), dataBlock.get() );
+
+                eq -> push_back( taskTransfer );
+                eq -> waitForSuccess( taskTransfer );
+            };
+
+            sendBlock( "small block" );
+            sendBlock( std::string( 256U * 1024U, 'x' ) );
+
+            /*
+             * A failed command must not break the connection: the next command is sent on it
+             */
+
+            try
+            {
+                sendBlock( "fail block" );
+
+                UTF_FAIL( "This is expected to throw" );
+            }
+            catch( ServerErrorException& e )
+            {
+                const auto* ec = eh::get_error_info< eh::errinfo_error_code >( e );
+
+                UTF_REQUIRE( ec );
+                UTF_REQUIRE_EQUAL( *ec, eh::errc::make_error_code( eh::errc::invalid_argument ) );
+            }
+
+            sendBlock( "last block" );
+
+            BL_MUTEX_GUARD( lockReceived );
+
+            UTF_REQUIRE_EQUAL( dataReceived.size(), 4U );
+            UTF_REQUIRE_EQUAL( acksSent, 4U );
+
+            UTF_REQUIRE_EQUAL( dataReceived[ 0 ], "small block" );
+            UTF_REQUIRE_EQUAL( dataReceived[ 1 ], std::string( 256U * 1024U, 'x' ) );
+            UTF_REQUIRE_EQUAL( dataReceived[ 2 ], "fail block" );
+            UTF_REQUIRE_EQUAL( dataReceived[ 3 ], "last block" );
+        }
+        );
+}
+
 UTF_AUTO_TEST_CASE( IO_MessagingClientBlockDispatchLocalTests )
 {
     using namespace bl;
@@ -105,6 +105,117 @@ namespace
     typedef bl::om::ObjectImpl< TestHostServicesContextT<> > TestHostServicesContext;
     typedef TestHostServicesContext context_t;
 
+    /**
+     * @brief An in-process authorization service which fails all authorization requests
+     * (after a small delay, so the concurrent requests for the same token get coalesced)
+     */
+
+    template
+    <
+        typename E = void
+    >
+    class TestFailingAuthorizationServiceImplT : public bl::om::ObjectDefaultBase
+    {
+    protected:
+
+        std::atomic< std::size_t >                                              m_tasksCreated;
+
+        TestFailingAuthorizationServiceImplT() NOEXCEPT
+            :
+            m_tasksCreated( 0U )
+        {
+        }
+
+    public:
+
+        typedef bl::tasks::SimpleTaskImpl                                       task_impl_t;
+
+        auto getTokenType() NOEXCEPT -> const std::string&
+        {
+            return utest::DummyAuthorizationCache::dummyTokenType();
+        }
+
+        auto tasksCreated() const NOEXCEPT -> std::size_t
+        {
+            return m_tasksCreated;
+        }
+
+        auto createAuthorizationTask( SAA_in const bl::om::ObjPtr< bl::data::DataBlock >& authenticationToken )
+            -> bl::om::ObjPtr< bl::tasks::Task >
+        {
+            BL_UNUSED( authenticationToken );
+
+            ++m_tasksCreated;
+
+            return task_impl_t::createInstance< bl::tasks::Task >(
+                []() -> void
+                {
+                    bl::os::sleep( bl::time::milliseconds( 200 ) );
+
+                    BL_THROW_USER_FRIENDLY(
+                        bl::UnexpectedException(),
+                        BL_MSG()
+                            << "Authorization has failed"
+                        );
+                }
+                );
+        }
+
+        auto extractSecurityPrincipal( SAA_in const bl::om::ObjPtr< bl::tasks::Task >& executedAuthorizationTask )
+            -> bl::om::ObjPtr< bl::security::SecurityPrincipal >
+        {
+            BL_UNUSED( executedAuthorizationTask );
+
+            BL_THROW(
+                bl::UnexpectedException(),
+                BL_MSG()
+                    << "The authorization requests are never expected to succeed"
+                );
+        }
+    };
+
+    typedef bl::om::ObjectImpl< TestFailingAuthorizationServiceImplT<> > TestFailingAuthorizationServiceImpl;
+
+    /**
+     * @brief A proxy which counts its live instances (e.g. to verify when a backend releases
+     * the host services proxies it was given)
+     */
+
+    template
+    <
+        typename E = void
+    >
+    class TestLiveProxyT : public bl::om::ProxyImplT<>
+    {
+        BL_DECLARE_OBJECT_IMPL_NO_DESTRUCTOR( TestLiveProxyT )
+
+    protected:
+
+        std::atomic< std::size_t >&                                             m_liveCount;
+
+        TestLiveProxyT( SAA_inout std::atomic< std::size_t >& liveCount ) NOEXCEPT
+            :
+            bl::om::ProxyImplT<>( true /* strongRef */ ),
+            m_liveCount( liveCount )
+        {
+            ++m_liveCount;
+        }
+
+        ~TestLiveProxyT() NOEXCEPT
+        {
+            /*
+             * The test proxies are owned by the backend only, so they are disconnected here
+             * when the backend releases its last reference
+             */
+
+            disconnect();
+
+            --m_liveCount;
+        }
+    };
+
+    typedef bl::om::ObjectImpl< TestLiveProxyT<> > TestLiveProxy;
+
     auto createTestSecurityPrincipal() -> bl::om::ObjPtr< bl::messaging::SecurityPrincipal >
     {
         auto principal = bl::messaging::SecurityPrincipal::createInstance();
@@ -842,6 +953,310 @@ UTF_AUTO_TEST_CASE( BackendTests )
     }
 }
 
+UTF_AUTO_TEST_CASE( BackendAuthorizationFailureTests )
+{
+    using namespace bl;
+    using namespace bl::tasks;
+    using namespace bl::messaging;
+    using namespace bl::security;
+
+    typedef om::ObjectImpl< AuthorizationCacheImpl< TestFailingAuthorizationServiceImpl > > cache_t;
+
+    /*
+     * When the authorization fails the requests which are waiting for the authorization request
+     * issued by another request for the same token must fail too (and not hang) and the next
+     * requests must issue a new authorization request
+     */
+
+    const auto service = TestFailingAuthorizationServiceImpl::createInstance();
+
+    const auto backendProcessing = BrokerBackendProcessing::createInstance< BackendProcessing >(
+        cache_t::createInstance< AuthorizationCache >( om::copy( service ) )
+        );
+
+    const auto context = context_t::createInstance();
+
+    const auto hostServices = om::ProxyImpl::createInstance< om::Proxy >( true /* strongRef */ );
+
+    hostServices -> connect( context.get() );
+
+    BL_SCOPE_EXIT(
+        {
+            backendProcessing -> setHostServices( nullptr );
+            hostServices -> disconnect();
+        }
+        );
+
+    backendProcessing -> setHostServices( om::copy( hostServices ) );
+
+    const auto protocolDataString =
+        dm::DataModelUtils::getDocAsPackedJsonString( createProtocolMessage( "invalidToken" /* cookiesText */ ) );
+
+    const auto createBackendProcessingTask = [ & ]() -> om::ObjPtr< Task >
+    {
+        const auto data = data::DataBlock::createInstance( protocolDataString.size() );
+
+        std::copy_n( protocolDataString.data(), protocolDataString.size(), data -> begin() );
+
+        data -> setSize( protocolDataString.size() );
+
+        return backendProcessing -> createBackendProcessingTask(
+            BackendProcessing::OperationId::Put,
+            BackendProcessing::CommandId::None,
+            uuids::create()                             /* sessionId */,
+            uuids::create()                             /* chunkId */,
+            uuids::create()                             /* sourcePeerId */,
+            uuids::create()                             /* targetPeerId */,
+            data
+            );
+    };
+
+    const std::size_t requestsCount = 8U;
+
+    const auto executeRequests = [ & ]() -> void
+    {
+        std::vector< om::ObjPtr< Task > > tasks;
+
+        for( std::size_t i = 0U; i < requestsCount; ++i )
+        {
+            tasks.push_back( createBackendProcessingTask() );
+        }
+
+        scheduleAndExecuteInParallel(
+            [ & ]( SAA_in const om::ObjPtr< ExecutionQueue >& eq ) -> void
+            {
+                eq -> setOptions( ExecutionQueue::OptionKeepNone );
+
+                for( const auto& task : tasks )
+                {
+                    eq -> push_back( task );
+                }
+
+                for( const auto& task : tasks )
+                {
+                    eq -> wait( task );
+                }
+            }
+            );
+
+        for( const auto& task : tasks )
+        {
+            UTF_REQUIRE( task -> isFailed() );
+
+            try
+            {
+                cpp::safeRethrowException( task -> exception() );
+            }
+            catch( ServerErrorException& e )
+            {
+                const auto* ec = eh::get_error_info< eh::errinfo_error_code >( e );
+
+                UTF_REQUIRE( ec );
+                UTF_REQUIRE_EQUAL( *ec, eh::errc::make_error_code( BrokerErrorCodes::AuthorizationFailed ) );
+            }
+        }
+    };
+
+    executeRequests();
+
+    const auto tasksCreated = service -> tasksCreated();
+
+    UTF_REQUIRE( tasksCreated >= 1U && tasksCreated < requestsCount );
+
+    executeRequests();
+
+    UTF_REQUIRE( service -> tasksCreated() > tasksCreated );
+}
+
+UTF_AUTO_TEST_CASE( BackendHostServicesSnapshotTests )
+{
+    using namespace bl;
+    using namespace bl::tasks;
+    using namespace bl::messaging;
+
+    /*
+     * The host services are replaced many times while other threads keep creating backend
+     * tasks from the lock free snapshot; the replaced proxies must be released as soon as no
+     * task can reference them any more (i.e. they must not accumulate in the backend)
+     */
+
+    const auto backendProcessing = utest::TestMessagingUtils::createTestMessagingBackend();
+
+    const auto data = data::DataBlock::createInstance( 1024U );
+
+    std::atomic< std::size_t > liveCount( 0U );
+    std::atomic< std::size_t > tasksCreated( 0U );
+    std::atomic< bool > done( false );
+
+    const auto publishHostServices = [ & ]() -> void
+    {
+        backendProcessing -> setHostServices( TestLiveProxy::createInstance< om::Proxy >( liveCount ) );
+    };
+
+    publishHostServices();
+
+    std::vector< std::thread > readers;
+
+    for( std::size_t i = 0U; i < 4U; ++i )
+    {
+        readers.emplace_back(
+            [ & ]() -> void
+            {
+                while( ! done.load() )
+                {
+                    const auto task = backendProcessing -> createBackendProcessingTask(
+                        BackendProcessing::OperationId::Put,
+                        BackendProcessing::CommandId::None,
+                        uuids::create()                             /* sessionId */,
+                        uuids::create()                             /* chunkId */,
+                        uuids::create()                             /* sourcePeerId */,
+                        uuids::create()                             /* targetPeerId */,
+                        data
+                        );
+
+                    if( task )
+                    {
+                        ++tasksCreated;
+                    }
+                }
+            }
+            );
+    }
+
+    const std::size_t publishCount = 2000U;
+
+    for( std::size_t i = 0U; i < publishCount; ++i )
+    {
+        publishHostServices();
+
+        /*
+         * Only the current proxy and the ones referenced by the tasks which are being created
+         * right now can be alive
+         */
+
+        UTF_REQUIRE( liveCount.load() <= 1U + readers.size() );
+    }
+
+    done = true;
+
+    for( auto& reader : readers )
+    {
+        reader.join();
+    }
+
+    UTF_REQUIRE( tasksCreated.load() );
+    UTF_REQUIRE_EQUAL( liveCount.load(), 1U );
+
+    backendProcessing -> dispose();
+
+    UTF_REQUIRE_EQUAL( liveCount.load(), 0U );
+}
+
+UTF_AUTO_TEST_CASE( PeerIdRoutingCacheTests )
+{
+    using namespace bl;
+    using namespace bl::messaging;
+
+    const auto cache = PeerIdRoutingCache::createInstance();
+
+    const auto proxyPeerId1 = uuids::create();
+    const auto proxyPeerId2 = uuids::create();
+
+    UTF_REQUIRE( uuids::nil() == cache -> tryResolveTargetPeerId( uuids::create() ) );
+    UTF_REQUIRE( ! cache -> dissociateTargetPeerId( uuids::create() ) );
+
+    /*
+     * Insert enough peers to grow all shard tables a few times and then remove
+     * and re-add them to exercise the purging of the deleted slots
+     */
+
+    const std::size_t peersCount = 8U * PeerIdRoutingCache::SHARDS_COUNT * PeerIdRoutingCache::SHARD_CAPACITY_INITIAL;
+
+    std::vector< uuid_t > peers;
+
+    for( std::size_t i = 0U; i < peersCount; ++i )
+    {
+        peers.push_back( uuids::create() );
+        cache -> associateTargetPeerId( i % 2U ? proxyPeerId1 : proxyPeerId2, peers.back() );
+    }
+
+    for( std::size_t round = 0U; round < 4U; ++round )
+    {
+        for( std::size_t i = 0U; i < peersCount; ++i )
+        {
+            UTF_REQUIRE( ( i % 2U ? proxyPeerId1 : proxyPeerId2 ) == cache -> tryResolveTargetPeerId( peers[ i ] ) );
+        }
+
+        for( std::size_t i = 0U; i < peersCount; i += 3U )
+        {
+            UTF_REQUIRE( cache -> dissociateTargetPeerId( peers[ i ] ) );
+            UTF_REQUIRE( ! cache -> dissociateTargetPeerId( peers[ i ] ) );
+            UTF_REQUIRE( uuids::nil() == cache -> tryResolveTargetPeerId( peers[ i ] ) );
+        }
+
+        for( std::size_t i = 0U; i < peersCount; i += 3U )
+        {
+            peers[ i ] = uuids::create();
+            cache -> associateTargetPeerId( i % 2U ? proxyPeerId1 : proxyPeerId2, peers[ i ] );
+        }
+    }
+
+    /*
+     * Re-association updates the existing entry
+     */
+
+    cache -> associateTargetPeerId( proxyPeerId1, peers[ 0U ] );
+    UTF_REQUIRE( proxyPeerId1 == cache -> tryResolveTargetPeerId( peers[ 0U ] ) );
+    cache -> associateTargetPeerId( proxyPeerId2, peers[ 0U ] );
+    UTF_REQUIRE( proxyPeerId2 == cache -> tryResolveTargetPeerId( peers[ 0U ] ) );
+
+    /*
+     * Concurrent readers must always see either the old or the new value while
+     * a writer keeps changing the routing of a set of peers and adding new ones
+     */
+
+    std::atomic< bool > done( false );
+    std::atomic< std::size_t > failures( 0U );
+
+    std::vector< std::thread > readers;
+
+    for( std::size_t i = 0U; i < 4U; ++i )
+    {
+        readers.emplace_back(
+            [ & ]() -> void
+            {
+                while( ! done.load() )
+                {
+                    for( std::size_t j = 0U; j < 64U; ++j )
+                    {
+                        const auto resolved = cache -> tryResolveTargetPeerId( peers[ j ] );
+
+                        if( resolved != proxyPeerId1 && resolved != proxyPeerId2 )
+                        {
+                            ++failures;
+                        }
+                    }
+                }
+            }
+            );
+    }
+
+    for( std::size_t i = 0U; i < 20000U; ++i )
+    {
+        cache -> associateTargetPeerId( i % 2U ? proxyPeerId1 : proxyPeerId2, peers[ i % 64U ] );
+        cache -> associateTargetPeerId( proxyPeerId1, uuids::create() );
+    }
+
+    done = true;
+
+    for( auto& reader : readers )
+    {
+        reader.join();
+    }
+
+    UTF_REQUIRE_EQUAL( failures.load(), 0U );
+}
+
 UTF_AUTO_TEST_CASE( BrokerFacadeTests )
 {
     if( ! test::UtfArgsParser::isServer() )
@@ -1430,35 +1845,119 @@ UTF_AUTO_TEST_CASE( IO_MessagingUtilsTests )
 
         utest::DataModelTestUtils::requireObjectsEqual( brokerProtocol, pair.first /* brokerProtocol */ );
         utest::DataModelTestUtils::requireObjectsEqual( payload, pair.second /* payload */ );
-    }
-
-    /*
-     * Test the endpoints expansion helper
-     */
-
-    {
-        std::vector< std::string > endpoints;
 
         /*
-         * Test various scenarios when the input is even number (2)
+         * The binary protocol data must be smaller, detected on read and preserved when
+         * the broker updates the protocol message in place
          */
 
-        endpoints.push_back( "ep1:1234" );
-        endpoints.push_back( "ep2:5678" );
+        const auto binaryBlock = MessagingUtils::serializeObjectsToBlock(
+            brokerProtocol,
+            payload,
+            dataBlocksPool,
+            data::DataBlock::defaultCapacity(),
+            true /* useBinaryProtocol */
+            );
 
-        const auto testExpandEndpoints = [ & ](
-            SAA_in          const std::size_t                                       noOfRequestedEndpoints,
-            SAA_in          const std::size_t                                       expectedMultiplier
-            )
-            -> void
-        {
-            const auto expandedEndpoints =
-                MessagingUtils::expandEndpoints( noOfRequestedEndpoints, cpp::copy( endpoints ) );
+        UTF_REQUIRE( MessagingUtils::isBinaryProtocolData( binaryBlock ) );
+        UTF_REQUIRE( ! MessagingUtils::isBinaryProtocolData( dataBlock ) );
+        UTF_REQUIRE_EQUAL( binaryBlock -> offset1(), dataBlock -> offset1() );
+        UTF_REQUIRE( binaryBlock -> size() < dataBlock -> size() );
 
-            UTF_REQUIRE( expandedEndpoints.size() >= endpoints.size() );
-            UTF_REQUIRE_EQUAL( expandedEndpoints.size(), expectedMultiplier * endpoints.size() );
+        const auto binaryPair = MessagingUtils::deserializeBlockToObjects( binaryBlock );
 
-            for( std::size_t i = 0U, count = expandedEndpoints.size(); i < count; ++i )
+        UTF_REQUIRE( binaryPair.second );
+
+        utest::DataModelTestUtils::requireObjectsEqual( brokerProtocol, binaryPair.first /* brokerProtocol */ );
+        utest::DataModelTestUtils::requireObjectsEqual( payload, binaryPair.second /* payload */ );
+
+        const auto sourcePeerId = uuids::create();
+        const auto targetPeerId = uuids::create();
+
+        binaryPair.first -> sourcePeerId( str::empty() );
+        binaryPair.first -> targetPeerId( str::empty() );
+
+        MessagingUtils::updateBrokerProtocolMessageInBlock(
+            binaryPair.first,
+            binaryBlock,
+            sourcePeerId,
+            targetPeerId
+            );
+
+        UTF_REQUIRE( MessagingUtils::isBinaryProtocolData( binaryBlock ) );
+
+        const auto updatedPair = MessagingUtils::deserializeBlockToObjects( binaryBlock, true /* brokerProtocolOnly */ );
+
+        UTF_REQUIRE_EQUAL( updatedPair.first -> sourcePeerId(), uuids::uuid2string( sourcePeerId ) );
+        UTF_REQUIRE_EQUAL( updatedPair.first -> targetPeerId(), uuids::uuid2string( targetPeerId ) );
+
+        /*
+         * By default the blocks are allocated from the smallest size class which can fit the
+         * message and when the protocol message is updated in place the block is grown as needed
+         */
+
+        UTF_REQUIRE_EQUAL( dataBlock -> capacity(), data::DataBlock::capacityForSize( dataBlock -> size() ) );
+        UTF_REQUIRE( dataBlock -> capacity() < data::DataBlock::defaultCapacity() );
+
+        const auto tightBlock = MessagingUtils::serializeObjectsToBlock(
+            brokerProtocol,
+            payload,
+            dataBlocksPool,
+            dataBlock -> size()                                 /* capacity */
+            );
+
+        UTF_REQUIRE_EQUAL( tightBlock -> capacity(), tightBlock -> size() );
+
+        const auto tightPair = MessagingUtils::deserializeBlockToObjects( tightBlock, true /* brokerProtocolOnly */ );
+
+        tightPair.first -> sourcePeerId( str::empty() );
+        tightPair.first -> targetPeerId( str::empty() );
+
+        MessagingUtils::updateBrokerProtocolMessageInBlock(
+            tightPair.first,
+            tightBlock,
+            sourcePeerId,
+            targetPeerId
+            );
+
+        UTF_REQUIRE( tightBlock -> size() > dataBlock -> size() );
+        UTF_REQUIRE( data::DataBlock::capacityForSize( tightBlock -> size() ) == tightBlock -> capacity() );
+
+        const auto tightUpdatedPair = MessagingUtils::deserializeBlockToObjects( tightBlock );
+
+        UTF_REQUIRE_EQUAL( tightUpdatedPair.first -> sourcePeerId(), uuids::uuid2string( sourcePeerId ) );
+        UTF_REQUIRE_EQUAL( tightUpdatedPair.first -> targetPeerId(), uuids::uuid2string( targetPeerId ) );
+
+        utest::DataModelTestUtils::requireObjectsEqual( payload, tightUpdatedPair.second /* payload */ );
+    }
+
+    /*
+     * Test the endpoints expansion helper
+     */
+
+    {
+        std::vector< std::string > endpoints;
+
+        /*
+         * Test various scenarios when the input is even number (2)
+         */
+
+        endpoints.push_back( "ep1:1234" );
+        endpoints.push_back( "ep2:5678" );
+
+        const auto testExpandEndpoints = [ & ](
+            SAA_in          const std::size_t                                       noOfRequestedEndpoints,
+            SAA_in          const std::size_t                                       expectedMultiplier
+            )
+            -> void
+        {
+            const auto expandedEndpoints =
+                MessagingUtils::expandEndpoints( noOfRequestedEndpoints, cpp::copy( endpoints ) );
+
+            UTF_REQUIRE( expandedEndpoints.size() >= endpoints.size() );
+            UTF_REQUIRE_EQUAL( expandedEndpoints.size(), expectedMultiplier * endpoints.size() );
+
+            for( std::size_t i = 0U, count = expandedEndpoints.size(); i < count; ++i )
             {
                 UTF_REQUIRE_EQUAL( expandedEndpoints[ i ], endpoints[ i % endpoints.size() ] );
             }
@@ -1494,6 +1993,195 @@ UTF_AUTO_TEST_CASE( IO_MessagingUtilsTests )
     }
 }
 
+UTF_AUTO_TEST_CASE( IO_MessagingRoutingFastPathTests )
+{
+    using namespace bl;
+    using namespace bl::messaging;
+
+    const auto conversationId = uuids::create();
+    const auto messageId = uuids::create();
+    const auto sourcePeerId = uuids::create();
+    const auto targetPeerId = uuids::create();
+
+    const std::string cookiesText( "<test \"cookies\">" );
+
+    const auto brokerProtocol = utest::TestMessagingUtils::createBrokerProtocolMessage(
+        MessageType::AsyncRpcDispatch,
+        conversationId,
+        cookiesText,
+        messageId
+        );
+
+    const auto payload = bl::dm::DataModelUtils::loadFromFile< Payload >(
+        utest::TestUtils::resolveDataFilePath( "async_rpc_request.json" )
+        );
+
+    /*
+     * The routing properties are extracted without deserializing the message
+     */
+
+    const auto dataBlock = MessagingUtils::serializeObjectsToBlock( brokerProtocol, payload );
+
+    BrokerProtocolRoutingInfo routingInfo;
+
+    UTF_REQUIRE( routingInfo.tryParse( dataBlock ) );
+
+    UTF_REQUIRE_EQUAL( routingInfo.messageType(), MessageType::AsyncRpcDispatch );
+    UTF_REQUIRE_EQUAL( routingInfo.messageId(), messageId );
+    UTF_REQUIRE_EQUAL( routingInfo.conversationId(), conversationId );
+    UTF_REQUIRE( ! routingInfo.hasSourcePeerId() );
+    UTF_REQUIRE( ! routingInfo.hasTargetPeerId() );
+    UTF_REQUIRE( routingInfo.hasPrincipalIdentityInfo() );
+    UTF_REQUIRE_EQUAL( routingInfo.tokenType(), utest::DummyAuthorizationCache::dummyTokenType() );
+    UTF_REQUIRE_EQUAL( routingInfo.tokenData(), cookiesText );
+
+    /*
+     * The peer ids are patched in place and the result must be the same as if the
+     * message was re-encoded
+     */
+
+    const auto offset1 = dataBlock -> offset1();
+
+    UTF_REQUIRE( routingInfo.updateInBlock( dataBlock, sourcePeerId, targetPeerId ) );
+    UTF_REQUIRE( ! routingInfo.isParsed() );
+    UTF_REQUIRE_EQUAL( dataBlock -> offset1(), offset1 );
+
+    const auto expectedProtocol = dm::DataModelUtils::loadFromJsonText< BrokerProtocol >(
+        dm::DataModelUtils::getDocAsPackedJsonString( brokerProtocol )
+        );
+
+    expectedProtocol -> sourcePeerId( uuids::uuid2string( sourcePeerId ) );
+    expectedProtocol -> targetPeerId( uuids::uuid2string( targetPeerId ) );
+
+    auto pair = MessagingUtils::deserializeBlockToObjects( dataBlock );
+
+    utest::DataModelTestUtils::requireObjectsEqual( expectedProtocol, pair.first /* brokerProtocol */ );
+    utest::DataModelTestUtils::requireObjectsEqual( payload, pair.second /* payload */ );
+
+    /*
+     * Once the peer ids are set they are not changed, but the principal identity info
+     * can still be replaced
+     */
+
+    UTF_REQUIRE( routingInfo.tryParse( dataBlock ) );
+    UTF_REQUIRE( routingInfo.hasSourcePeerId() );
+    UTF_REQUIRE( routingInfo.hasTargetPeerId() );
+    UTF_REQUIRE_EQUAL( routingInfo.sourcePeerId(), sourcePeerId );
+    UTF_REQUIRE_EQUAL( routingInfo.targetPeerId(), targetPeerId );
+
+    UTF_REQUIRE( ! routingInfo.updateInBlock( dataBlock, uuids::create(), uuids::create() ) );
+
+    const auto principalIdentityInfo = PrincipalIdentityInfo::createInstance();
+    const auto securityPrincipal = SecurityPrincipal::createInstance();
+
+    securityPrincipal -> sid( "<test sid>" );
+    securityPrincipal -> email( "test@test.com" );
+    principalIdentityInfo -> securityPrincipal( om::copy( securityPrincipal ) );
+
+    const auto principalIdentityInfoJson = dm::DataModelUtils::getDocAsPackedJsonString( principalIdentityInfo );
+
+    UTF_REQUIRE( routingInfo.tryParse( dataBlock ) );
+    UTF_REQUIRE( routingInfo.updateInBlock( dataBlock, uuids::create(), uuids::create(), &principalIdentityInfoJson ) );
+
+    expectedProtocol -> principalIdentityInfo( om::copy( principalIdentityInfo ) );
+
+    pair = MessagingUtils::deserializeBlockToObjects( dataBlock );
+
+    utest::DataModelTestUtils::requireObjectsEqual( expectedProtocol, pair.first /* brokerProtocol */ );
+    utest::DataModelTestUtils::requireObjectsEqual( payload, pair.second /* payload */ );
+
+    /*
+     * The security principal is only produced by the broker, so such messages are left
+     * to the full deserialization (which also does not change the peer ids)
+     */
+
+    UTF_REQUIRE( ! routingInfo.tryParse( dataBlock ) );
+
+    MessagingUtils::updateBrokerProtocolPeerIdsInBlock( dataBlock, uuids::create(), uuids::create() );
+
+    pair = MessagingUtils::deserializeBlockToObjects( dataBlock );
+
+    utest::DataModelTestUtils::requireObjectsEqual( expectedProtocol, pair.first /* brokerProtocol */ );
+
+    /*
+     * Empty and null peer ids are replaced in place (in the middle of the text)
+     */
+
+    const auto setProtocolText = [ & ]( SAA_in const std::string& protocolText ) -> om::ObjPtr< data::DataBlock >
+    {
+        auto block = data::DataBlock::createInstance( protocolText.size() );
+
+        std::memcpy( block -> begin(), protocolText.data(), protocolText.size() );
+        block -> setSize( protocolText.size() );
+
+        return block;
+    };
+
+    const auto ids =
+        std::string( "\"conversationId\":\"" ) + uuids::uuid2string( conversationId ) + "\"," +
+        "\"messageId\":\"" + uuids::uuid2string( messageId ) + "\"";
+
+    {
+        const auto block = setProtocolText(
+            "{ \"sourcePeerId\" : \"\", \"messageType\":\"AsyncNotification\", \"targetPeerId\":null, " + ids + " }"
+            );
+
+        MessagingUtils::updateBrokerProtocolPeerIdsInBlock( block, sourcePeerId, targetPeerId );
+
+        const auto updated = MessagingUtils::deserializeBlockToObjects( block ).first;
+
+        UTF_REQUIRE_EQUAL( updated -> messageType(), MessageType::toString( MessageType::AsyncNotification ) );
+        UTF_REQUIRE_EQUAL( updated -> sourcePeerId(), uuids::uuid2string( sourcePeerId ) );
+        UTF_REQUIRE_EQUAL( updated -> targetPeerId(), uuids::uuid2string( targetPeerId ) );
+        UTF_REQUIRE_EQUAL( updated -> conversationId(), uuids::uuid2string( conversationId ) );
+        UTF_REQUIRE( ! updated -> principalIdentityInfo() );
+    }
+
+    /*
+     * Messages which the fast path does not handle are rejected (and are handled
+     * by the full deserialization)
+     */
+
+    const auto requireSlowPath = [ & ]( SAA_in const std::string& protocolText ) -> void
+    {
+        const auto block = setProtocolText( protocolText );
+
+        UTF_REQUIRE( ! routingInfo.tryParse( block ) );
+        UTF_REQUIRE( ! routingInfo.isParsed() );
+    };
+
+    requireSlowPath( "{\"messageType\":\"AsyncRpcDispatch\"," + ids );
+    requireSlowPath( "{\"messageType\":\"AsyncRpcDispatch\"," + ids + "} {}" );
+    requireSlowPath( "{\"messageType\":\"InvalidType\"," + ids + "}" );
+    requireSlowPath( "{\"messageType\":\"AsyncRpcDispatch\",\"messageId\":\"" + uuids::uuid2string( messageId ) + "\"}" );
+    requireSlowPath( "{\"messageType\":\"AsyncRpcDispatch\",\"sourcePeerId\":\"not a uuid\"," + ids + "}" );
+    requireSlowPath( "{\"messageType\":\"AsyncRpcDispatch\",\"sourcePeerId\":1," + ids + "}" );
+    requireSlowPath( "{\"messageType\":\"Async\\u0052pcDispatch\"," + ids + "}" );
+    requireSlowPath( "{\"messageType\":\"AsyncRpcDispatch\",\"messageType\":\"AsyncRpcDispatch\"," + ids + "}" );
+    requireSlowPath( "{\"messageType\":\"AsyncRpcDispatch\",\"unknown\":1," + ids + "}" );
+    requireSlowPath( "{\"messageType\":\"AsyncRpcDispatch\",\"principalIdentityInfo\":{}," + ids + "}" );
+
+    const auto binaryBlock = MessagingUtils::serializeObjectsToBlock(
+        brokerProtocol,
+        payload,
+        nullptr /* dataBlocksPool */,
+        0U /* capacity */,
+        true /* useBinaryProtocol */
+        );
+
+    UTF_REQUIRE( ! routingInfo.tryParse( binaryBlock ) );
+
+    MessagingUtils::updateBrokerProtocolPeerIdsInBlock( binaryBlock, sourcePeerId, targetPeerId );
+
+    UTF_REQUIRE( MessagingUtils::isBinaryProtocolData( binaryBlock ) );
+
+    const auto binaryPair = MessagingUtils::deserializeBlockToObjects( binaryBlock );
+
+    UTF_REQUIRE_EQUAL( binaryPair.first -> sourcePeerId(), uuids::uuid2string( sourcePeerId ) );
+    UTF_REQUIRE_EQUAL( binaryPair.first -> targetPeerId(), uuids::uuid2string( targetPeerId ) );
+    utest::DataModelTestUtils::requireObjectsEqual( payload, binaryPair.second /* payload */ );
+}
+
 UTF_AUTO_TEST_CASE( IO_MessagingClientObjectDispatchLocalTests )
 {
     using namespace bl;
@@ -2102,6 +2790,185 @@ UTF_AUTO_TEST_CASE( IO_MessagingClientObjectDispatchTcpDispatcherTests )
         );
 }
 
+UTF_AUTO_TEST_CASE( IO_MessagingAutoPushConnectionLatencyTests )
+{
+    using namespace bl;
+    using namespace bl::tasks;
+    using namespace bl::messaging;
+
+    /*
+     * Sends messages one at a time (i.e. the next message is sent only after the previous one
+     * has been delivered) which is the worst case for the auto push connection as every block
+     * is pushed right about when the connection task switches to the heartbeat timer task
+     *
+     * If the wakeup is lost the block sits in the queue for the entire heartbeat interval
+     * (30 seconds by default), so no message should ever take anywhere near that long
+     */
+
+    const auto callbackTests = []() -> void
+    {
+        const std::size_t noOfMessages = 2000U;
+        const auto maxDeliveryTime = time::seconds( 10L );
+
+        std::atomic< std::size_t > callsCount( 0U );
+
+        const auto dataBlocksPool = data::datablocks_pool_type::createInstance();
+
+        const auto sourcePeerId = uuids::create();
+        const auto targetPeerId = uuids::create();
+
+        const auto brokerProtocol = utest::TestMessagingUtils::createBrokerProtocolMessage(
+            MessageType::AsyncRpcDispatch,
+            uuids::create()                                             /* conversationId */,
+            utest::TestMessagingUtils::getTokenData()
+            );
+
+        const auto incomingObjectChannel1 = bl::om::lockDisposable(
+            MessagingClientObjectDispatchFromCallback::createInstance(
+                [ & ](
+                    SAA_in              const bl::uuid_t&                               targetPeerId,
+                    SAA_in              const bl::om::ObjPtr< BrokerProtocol >&         brokerProtocol,
+                    SAA_in_opt          const bl::om::ObjPtr< Payload >&                payload
+                    ) -> void
+                {
+                    BL_UNUSED( targetPeerId );
+                    BL_UNUSED( brokerProtocol );
+                    BL_UNUSED( payload );
+
+                    UTF_FAIL( "This one should not be called" );
+                }
+                )
+            );
+
+        const auto incomingObjectChannel2 = bl::om::lockDisposable(
+            MessagingClientObjectDispatchFromCallback::createInstance(
+                [ & ](
+                    SAA_in              const bl::uuid_t&                               targetPeerId,
+                    SAA_in              const bl::om::ObjPtr< BrokerProtocol >&         brokerProtocol,
+                    SAA_in_opt          const bl::om::ObjPtr< Payload >&                payload
+                    ) -> void
+                {
+                    BL_UNUSED( targetPeerId );
+                    BL_UNUSED( brokerProtocol );
+                    BL_UNUSED( payload );
+
+                    ++callsCount;
+                }
+                )
+            );
+
+        auto connections1 = MessagingClientFactorySsl::createEstablishedConnections(
+            "localhost"                                                 /* host */,
+            test::UtfArgsParser::port()                                 /* inboundPort */,
+            test::UtfArgsParser::port() + 1                             /* outboundPort */
+            );
+
+        auto connections2 = MessagingClientFactorySsl::createEstablishedConnections(
+            "localhost"                                                 /* host */,
+            test::UtfArgsParser::port()                                 /* inboundPort */,
+            test::UtfArgsParser::port() + 1                             /* outboundPort */
+            );
+
+        const auto client1 = bl::om::lockDisposable(
+            MessagingClientObjectFactory::createFromObjectDispatchTcp(
+                om::qi< MessagingClientObjectDispatch >( incomingObjectChannel1 ),
+                dataBlocksPool,
+                sourcePeerId,
+                "localhost"                                             /* host */,
+                test::UtfArgsParser::port()                             /* inboundPort */,
+                test::UtfArgsParser::port() + 1                         /* outboundPort */,
+                std::move( connections1.first )                         /* inboundConnection */,
+                std::move( connections1.second )                        /* outboundConnection */
+                )
+            );
+
+        const auto client2 = bl::om::lockDisposable(
+            MessagingClientObjectFactory::createFromObjectDispatchTcp(
+                om::qi< MessagingClientObjectDispatch >( incomingObjectChannel2 ),
+                dataBlocksPool,
+                targetPeerId,
+                "localhost"                                             /* host */,
+                test::UtfArgsParser::port()                             /* inboundPort */,
+                test::UtfArgsParser::port() + 1                         /* outboundPort */,
+                std::move( connections2.first )                         /* inboundConnection */,
+                std::move( connections2.second )                        /* outboundConnection */
+                )
+            );
+
+        const auto& objectDispatcher = client1 -> outgoingObjectChannel();
+
+        scheduleAndExecuteInParallel(
+            [ & ]( SAA_in const om::ObjPtr< ExecutionQueue >& eq ) -> void
+            {
+                eq -> setOptions( ExecutionQueue::OptionKeepFailed );
+
+                for( std::size_t i = 0U; i < noOfMessages; ++i )
+                {
+                    const auto startTime = time::microsec_clock::universal_time();
+
+                    eq -> push_back(
+                        ExternalCompletionTaskImpl::createInstance< Task >(
+                            cpp::bind(
+                                &MessagingClientObjectDispatch::pushMessageCopyCallback,
+                                om::ObjPtrCopyable< MessagingClientObjectDispatch >::acquireRef(
+                                    objectDispatcher.get()
+                                    ),
+                                targetPeerId,
+                                om::ObjPtrCopyable< BrokerProtocol >( brokerProtocol ),
+                                om::ObjPtrCopyable< Payload >(),
+                                _1 /* onReady - the completion callback */
+                                )
+                            )
+                        );
+
+                    utest::TestMessagingUtils::flushQueueWithRetriesOnTargetPeerNotFound( eq );
+
+                    const auto elapsed = time::microsec_clock::universal_time() - startTime;
+
+                    /*
+                     * The first message is excluded as it can wait for the target peer
+                     * to become available
+                     */
+
+                    if( i )
+                    {
+                        UTF_REQUIRE( elapsed < maxDeliveryTime );
+                    }
+                }
+            }
+            );
+
+        /*
+         * The messages are delivered asynchronously to the target, so wait for all of
+         * them to arrive
+         */
+
+        for( std::size_t i = 0U; i < 100U && callsCount.load() < noOfMessages; ++i )
+        {
+            os::sleep( time::milliseconds( 100L ) );
+        }
+
+        UTF_REQUIRE_EQUAL( callsCount.load(), noOfMessages );
+    };
+
+    test::MachineGlobalTestLock lock;
+
+    const auto processingBackend = bl::om::lockDisposable(
+        utest::TestMessagingUtils::createTestMessagingBackend()
+        );
+
+    bl::messaging::BrokerFacade::execute(
+        processingBackend,
+        test::UtfCrypto::getDefaultServerKey()              /* privateKeyPem */,
+        test::UtfCrypto::getDefaultServerCertificate()      /* certificatePem */,
+        test::UtfArgsParser::port()                         /* inboundPort */,
+        test::UtfArgsParser::port() + 1                     /* outboundPort */,
+        test::UtfArgsParser::threadsCount(),
+        0U                                                  /* maxConcurrentTasks */,
+        callbackTests
+        );
+}
+
 namespace utest
 {
     namespace dm
@@ -3263,6 +4130,283 @@ UTF_AUTO_TEST_CASE( IO_MessagingMessageProcessingTestMsgTimeout )
         );
 }
 
+namespace
+{
+    /*
+     * Object dispatch which emulates the broker by delivering the messages directly to
+     * the target conversation task and completing the send asynchronously
+     */
+
+    class LoopbackObjectDispatch : public bl::messaging::MessagingClientObjectDispatch
+    {
+        BL_DECLARE_OBJECT_IMPL_ONEIFACE_DISPOSABLE(
+            LoopbackObjectDispatch,
+            bl::messaging::MessagingClientObjectDispatch
+            )
+
+    protected:
+
+        typedef bl::messaging::BrokerProtocol                                   BrokerProtocol;
+        typedef bl::messaging::Payload                                          Payload;
+        typedef bl::messaging::CompletionCallback                               CompletionCallback;
+
+        const bl::uuid_t                                                        m_sourcePeerId;
+        const bl::om::ObjPtrCopyable< bl::om::Proxy >                           m_targetSink;
+
+        LoopbackObjectDispatch(
+            SAA_in          const bl::uuid_t&                                   sourcePeerId,
+            SAA_in          const bl::om::ObjPtrCopyable< bl::om::Proxy >&      targetSink
+            )
+            :
+            m_sourcePeerId( sourcePeerId ),
+            m_targetSink( targetSink )
+        {
+        }
+
+    public:
+
+        virtual void dispose() NOEXCEPT OVERRIDE
+        {
+        }
+
+        virtual void pushMessage(
+            SAA_in                  const bl::uuid_t&                               targetPeerId,
+            SAA_in                  const bl::om::ObjPtr< BrokerProtocol >&         brokerProtocol,
+            SAA_in_opt              const bl::om::ObjPtr< Payload >&                payload,
+            SAA_in_opt              CompletionCallback&&                            completionCallback = CompletionCallback()
+            ) OVERRIDE
+        {
+            brokerProtocol -> sourcePeerId( bl::uuids::uuid2string( m_sourcePeerId ) );
+
+            utest::TestMessagingUtils::dispatchCallback(
+                m_targetSink,
+                bl::uuids::nil()                                /* targetPeerIdExpected */,
+                targetPeerId,
+                brokerProtocol,
+                payload
+                );
+
+            const auto callback = BL_PARAM_FWD( completionCallback );
+
+            bl::ThreadPoolDefault::getDefault( bl::ThreadPoolId::GeneralPurpose ) -> post(
+                [ callback ]() -> void
+                {
+                    callback( nullptr /* eptr */ );
+                }
+                );
+        }
+
+        virtual bool isConnected() const NOEXCEPT OVERRIDE
+        {
+            return true;
+        }
+    };
+
+    typedef bl::om::ObjectImpl< LoopbackObjectDispatch > LoopbackObjectDispatchImpl;
+
+    /*
+     * Tester class for the send window - the sender streams a number of messages without
+     * payload and the receiver records the ids of the messages in the order it processes
+     * them and finishes when it has received all of them
+     */
+
+    class TestConversationStreaming : public bl::messaging::ConversationProcessingBaseImpl<>
+    {
+        BL_DECLARE_OBJECT_IMPL( TestConversationStreaming )
+
+    protected:
+
+        typedef bl::messaging::ConversationProcessingBaseImpl<>                 base_type;
+        typedef base_type::object_dispatch_t                                    object_dispatch_t;
+
+        const bool                                                              m_isSender;
+        const std::size_t                                                       m_messagesCount;
+        std::vector< bl::uuid_t >                                               m_messageIds;
+
+        TestConversationStreaming(
+            SAA_in          const bool                                          isSender,
+            SAA_in          const std::size_t                                   messagesCount,
+            SAA_in          const bl::uuid_t&                                   peerId,
+            SAA_in          const bl::uuid_t&                                   targetPeerId,
+            SAA_in          const bl::uuid_t&                                   conversationId,
+            SAA_in          bl::om::ObjPtr< object_dispatch_t >&&               objectDispatcher
+            )
+            :
+            base_type(
+                peerId,
+                targetPeerId,
+                conversationId,
+                BL_PARAM_FWD( objectDispatcher )
+                ),
+            m_isSender( isSender ),
+            m_messagesCount( messagesCount )
+        {
+        }
+
+        virtual void processCurrentMessage() OVERRIDE
+        {
+            UTF_REQUIRE( ! m_isSender );
+
+            m_messageIds.push_back( bl::uuids::string2uuid( m_currentMessage.brokerProtocol -> messageId() ) );
+
+            m_currentMessage = MessageInfo();
+
+            if( m_messageIds.size() == m_messagesCount )
+            {
+                m_isFinished = true;
+            }
+        }
+
+    public:
+
+        auto messageIds() const NOEXCEPT -> const std::vector< bl::uuid_t >&
+        {
+            return m_messageIds;
+        }
+
+        void onProcessing()
+        {
+            base_type::onProcessing();
+
+            if( ! m_isSender )
+            {
+                return;
+            }
+
+            BL_MUTEX_GUARD( m_lock );
+
+            if(
+                m_isFinished ||
+                m_wasLastMessageSent ||
+                ! m_outgoingQueue.empty() ||
+                m_unacknowledgedMessages.size() >= m_sendWindowSize
+                )
+            {
+                return;
+            }
+
+            const auto brokerProtocol =
+                bl::messaging::MessagingUtils::createResponseProtocolMessage( m_conversationId );
+
+            m_messageIds.push_back( bl::uuids::string2uuid( brokerProtocol -> messageId() ) );
+
+            base_type::sendMessage(
+                m_messageIds.size() == m_messagesCount      /* isLastMessage */,
+                brokerProtocol,
+                nullptr                                     /* payload */
+                );
+        }
+    };
+
+    typedef bl::om::ObjectImpl< TestConversationStreaming > TestConversationStreamingImpl;
+
+} // __unnamed
+
+UTF_AUTO_TEST_CASE( MessagingConversationProcessingSendWindowTests )
+{
+    using namespace bl;
+    using namespace bl::tasks;
+    using namespace bl::messaging;
+
+    const std::size_t messagesCount = 64U;
+    const std::size_t sendWindowSize = 8U;
+
+    scheduleAndExecuteInParallel(
+        [ & ]( SAA_in const om::ObjPtr< ExecutionQueue >& eq ) -> void
+        {
+            const auto peerId1 = uuids::create();
+            const auto peerId2 = uuids::create();
+            const auto conversationId = uuids::create();
+
+            const om::ObjPtrCopyable< om::Proxy > sink1 =
+                om::ProxyImpl::createInstance< om::Proxy >( true /* strongRef */ );
+
+            const om::ObjPtrCopyable< om::Proxy > sink2 =
+                om::ProxyImpl::createInstance< om::Proxy >( true /* strongRef */ );
+
+            typedef om::ObjectImpl
+            <
+                ConversationProcessingTaskT< TestConversationStreamingImpl >
+            >
+            processing_task_t;
+
+            const auto sender = TestConversationStreamingImpl::createInstance(
+                true                                                    /* isSender */,
+                messagesCount,
+                peerId1                                                 /* peerId (self) */,
+                peerId2                                                 /* targetPeerId (the target) */,
+                conversationId,
+                LoopbackObjectDispatchImpl::createInstance< MessagingClientObjectDispatch >( peerId1, sink2 )
+                );
+
+            const auto receiver = TestConversationStreamingImpl::createInstance(
+                false                                                   /* isSender */,
+                messagesCount,
+                peerId2                                                 /* peerId (self) */,
+                peerId1                                                 /* targetPeerId (the target) */,
+                conversationId,
+                LoopbackObjectDispatchImpl::createInstance< MessagingClientObjectDispatch >( peerId2, sink1 )
+                );
+
+            UTF_REQUIRE_EQUAL( sender -> sendWindowSize(), 1U );
+
+            UTF_REQUIRE_THROW( sender -> sendWindowSize( 0U ), UnexpectedException );
+
+            sender -> sendWindowSize( sendWindowSize );
+
+            UTF_REQUIRE_EQUAL( sender -> sendWindowSize(), sendWindowSize );
+
+            const auto task1 = processing_task_t::createInstance< Task >( om::copy( sender ) );
+            const auto task2 = processing_task_t::createInstance< Task >( om::copy( receiver ) );
+
+            BL_SCOPE_EXIT(
+                {
+                    sink1 -> disconnect();
+                    sink2 -> disconnect();
+                }
+                );
+
+            sink1 -> connect( task1.get() );
+            sink2 -> connect( task2.get() );
+
+            /*
+             * Start the sender first - the receiver queues the messages, but it won't send
+             * back any acknowledgments until it is started, so the sender should fill its
+             * send window and then stop
+             */
+
+            eq -> push_back( task1 );
+
+            for( std::size_t i = 0U; i < 1000U; ++i )
+            {
+                if( sender -> unacknowledgedMessagesCount() == sendWindowSize )
+                {
+                    break;
+                }
+
+                os::sleep( time::milliseconds( 10 ) );
+            }
+
+            UTF_REQUIRE_EQUAL( sender -> unacknowledgedMessagesCount(), sendWindowSize );
+
+            os::sleep( time::milliseconds( 100 ) );
+
+            UTF_REQUIRE_EQUAL( sender -> unacknowledgedMessagesCount(), sendWindowSize );
+            UTF_REQUIRE_EQUAL( sender -> messageIds().size(), sendWindowSize );
+
+            eq -> push_back( task2 );
+
+            eq -> waitForSuccess( task2 );
+            eq -> waitForSuccess( task1 );
+
+            UTF_REQUIRE_EQUAL( sender -> unacknowledgedMessagesCount(), 0U );
+            UTF_REQUIRE_EQUAL( receiver -> messageIds().size(), messagesCount );
+
+            UTF_REQUIRE( sender -> messageIds() == receiver -> messageIds() );
+        }
+        );
+}
+
 UTF_AUTO_TEST_CASE( IO_MessagingPerfTests )
 {
     using namespace bl;
@@ -121,6 +121,96 @@ namespace utest
 
         typedef bl::om::ObjectImpl< TestAuthorizationServiceImplT<> > TestAuthorizationServiceImpl;
 
+        /**
+         * @brief An in-process authorization service which counts the authorization tasks
+         * created and can be configured to fail them
+         */
+
+        template
+        <
+            typename E = void
+        >
+        class TestCountingAuthorizationServiceImplT : public bl::om::ObjectDefaultBase
+        {
+            BL_CTR_DEFAULT( TestCountingAuthorizationServiceImplT, protected )
+
+        private:
+
+            static const std::string                            g_tokenType;
+
+            std::atomic< std::size_t >                          m_tasksCreated;
+            std::atomic< bool >                                 m_isFailing;
+
+        public:
+
+            typedef bl::tasks::SimpleTaskImpl                   task_impl_t;
+
+            auto getTokenType() NOEXCEPT -> const std::string&
+            {
+                return g_tokenType;
+            }
+
+            auto tasksCreated() const NOEXCEPT -> std::size_t
+            {
+                return m_tasksCreated;
+            }
+
+            void isFailing( SAA_in const bool isFailing ) NOEXCEPT
+            {
+                m_isFailing = isFailing;
+            }
+
+            auto createAuthorizationTask( SAA_in const bl::om::ObjPtr< bl::data::DataBlock >& authenticationToken )
+                -> bl::om::ObjPtr< bl::tasks::Task >
+            {
+                using namespace bl;
+
+                BL_UNUSED( authenticationToken );
+
+                ++m_tasksCreated;
+
+                const bool isFailing = m_isFailing;
+
+                return task_impl_t::createInstance< tasks::Task >(
+                    [ isFailing ]() -> void
+                    {
+                        os::sleep( time::milliseconds( 100 ) );
+
+                        BL_CHK_USER_FRIENDLY(
+                            false,
+                            ! isFailing,
+                            BL_MSG()
+                                << "Authorization has failed"
+                            );
+                    }
+                    );
+            }
+
+            auto extractSecurityPrincipal( SAA_in const bl::om::ObjPtr< bl::tasks::Task >& executedAuthorizationTask )
+                -> bl::om::ObjPtr< bl::security::SecurityPrincipal >
+            {
+                using namespace bl;
+                using namespace bl::security;
+
+                BL_ASSERT( ! executedAuthorizationTask -> isFailed() );
+
+                BL_UNUSED( executedAuthorizationTask );
+
+                return SecurityPrincipal::createInstance(
+                    uuids::uuid2string( uuids::create() )           /* secureIdentity */,
+                    "givenName"                                     /* givenName */,
+                    "familyName"                                    /* familyName */,
+                    "user@host.com"                                 /* email */,
+                    "type_0"                                        /* typeId */,
+                    AuthorizationCache::createAuthenticationToken( "latestToken" )
+                    );
+            }
+        };
+
+        BL_DEFINE_STATIC_CONST_STRING( TestCountingAuthorizationServiceImplT, g_tokenType ) = "countingTokenType";
+
+        typedef bl::om::ObjectImpl< TestCountingAuthorizationServiceImplT<> > TestCountingAuthorizationServiceImpl;
+
     } // security
 
 } // utest
@@ -152,3 +242,239 @@ UTF_AUTO_TEST_CASE( AuthorizationCacheImplFullTests )
         );
 }
 
+
+UTF_AUTO_TEST_CASE( AuthorizationCacheImplSingleFlightTests )
+{
+    using namespace bl;
+    using namespace bl::tasks;
+    using namespace bl::security;
+    using namespace utest::security;
+
+    typedef om::ObjectImpl< AuthorizationCacheImpl< TestCountingAuthorizationServiceImpl > > cache_t;
+
+    const auto executeTasks = []( SAA_in const std::vector< om::ObjPtr< Task > >& tasks ) -> void
+    {
+        scheduleAndExecuteInParallel(
+            [ & ]( SAA_in const om::ObjPtr< ExecutionQueue >& eq ) -> void
+            {
+                eq -> setOptions( ExecutionQueue::OptionKeepNone );
+
+                for( const auto& task : tasks )
+                {
+                    eq -> push_back( task );
+                }
+
+                for( const auto& task : tasks )
+                {
+                    eq -> wait( task );
+                }
+            }
+            );
+    };
+
+    const auto executeTask = [ & ]( SAA_in const om::ObjPtr< Task >& task ) -> void
+    {
+        std::vector< om::ObjPtr< Task > > tasks;
+
+        tasks.push_back( om::copy( task ) );
+
+        executeTasks( tasks );
+    };
+
+    const auto test = [ & ]( SAA_in const cache_t::KeyHashing keyHashing ) -> void
+    {
+        const auto service = TestCountingAuthorizationServiceImpl::createInstance();
+
+        const auto cache = cache_t::createInstance< AuthorizationCache >(
+            om::copy( service ),
+            time::neg_infin                     /* freshnessInterval */,
+            cache_t::STRIPES_COUNT              /* maxEntries */,
+            time::neg_infin                     /* staleInterval */,
+            keyHashing
+            );
+
+        const auto token = AuthorizationCache::createAuthenticationToken( "token" );
+
+        /*
+         * Only the first task issues an authorization request and the rest wait for it and
+         * then obtain the same principal
+         */
+
+        {
+            const auto leaderTask = cache -> createAuthorizationTask( token );
+
+            std::vector< om::ObjPtr< Task > > waitingTasks;
+
+            for( std::size_t i = 0U; i < 8U; ++i )
+            {
+                waitingTasks.push_back( cache -> createAuthorizationTask( token ) );
+            }
+
+            UTF_REQUIRE_EQUAL( service -> tasksCreated(), 1U );
+
+            executeTask( leaderTask );
+
+            const auto principal = cache -> update( token, leaderTask );
+            UTF_REQUIRE( principal );
+
+            executeTasks( waitingTasks );
+
+            for( const auto& task : waitingTasks )
+            {
+                UTF_REQUIRE( om::areEqual( cache -> update( token, task ), principal ) );
+            }
+
+            UTF_REQUIRE( om::areEqual( cache -> tryGetAuthorizedPrinciplal( token ), principal ) );
+
+            const auto newTask = cache -> createAuthorizationTask( token );
+            UTF_REQUIRE_EQUAL( service -> tasksCreated(), 2U );
+
+            executeTask( newTask );
+            UTF_REQUIRE( ! om::areEqual( cache -> update( token, newTask ), principal ) );
+        }
+
+        /*
+         * If the authorization fails then the tasks waiting for it fail too
+         */
+
+        {
+            service -> isFailing( true );
+
+            const auto leaderTask = cache -> createAuthorizationTask( token );
+            const auto waitingTask = cache -> createAuthorizationTask( token );
+
+            UTF_REQUIRE_EQUAL( service -> tasksCreated(), 3U );
+
+            executeTask( leaderTask );
+
+            UTF_REQUIRE_THROW_MESSAGE(
+                cache -> update( token, leaderTask ),
+                SecurityException,
+                "Authorization request to the authorization service has failed"
+                );
+
+            executeTask( waitingTask );
+
+            UTF_REQUIRE( waitingTask -> isFailed() );
+            UTF_REQUIRE( nullptr == cache -> tryUpdate( token, waitingTask ) );
+
+            UTF_REQUIRE_THROW_MESSAGE(
+                cache -> update( token, waitingTask ),
+                SecurityException,
+                "Authorization request to the authorization service has failed"
+                );
+
+            /*
+             * The failed attempts do not modify the cache and the next request is issued
+             */
+
+            UTF_REQUIRE( cache -> tryGetAuthorizedPrinciplal( token ) );
+
+            service -> isFailing( false );
+
+            UTF_REQUIRE( cache -> update( token ) );
+            UTF_REQUIRE_EQUAL( service -> tasksCreated(), 4U );
+        }
+
+        /*
+         * If the task issued is released without being executed then the tasks waiting for it
+         * fail (instead of hanging) and the next request issues a new authorization task
+         */
+
+        {
+            auto leaderTask = cache -> createAuthorizationTask( token );
+            const auto waitingTask = cache -> createAuthorizationTask( token );
+
+            UTF_REQUIRE_EQUAL( service -> tasksCreated(), 5U );
+
+            leaderTask.reset();
+
+            executeTask( waitingTask );
+
+            UTF_REQUIRE( waitingTask -> isFailed() );
+
+            UTF_REQUIRE_THROW_MESSAGE(
+                cache -> update( token, waitingTask ),
+                SecurityException,
+                "Authorization request to the authorization service has failed"
+                );
+
+            UTF_REQUIRE( cache -> update( token ) );
+            UTF_REQUIRE_EQUAL( service -> tasksCreated(), 6U );
+        }
+
+        /*
+         * The cache is bounded - each stripe can hold a single entry here and the least
+         * recently used one is evicted
+         */
+
+        {
+            const std::size_t tokensCount = 4U * cache_t::STRIPES_COUNT;
+
+            std::vector< om::ObjPtr< data::DataBlock > > tokens;
+
+            for( std::size_t i = 0U; i < tokensCount; ++i )
+            {
+                tokens.push_back( AuthorizationCache::createAuthenticationToken( "token_" + std::to_string( i ) ) );
+
+                UTF_REQUIRE( cache -> update( tokens.back() ) );
+                UTF_REQUIRE( cache -> tryGetAuthorizedPrinciplal( tokens.back() ) );
+            }
+
+            std::size_t cachedCount = 0U;
+
+            for( const auto& cachedToken : tokens )
+            {
+                if( cache -> tryGetAuthorizedPrinciplal( cachedToken ) )
+                {
+                    ++cachedCount;
+                }
+            }
+
+            UTF_REQUIRE( cachedCount <= cache_t::STRIPES_COUNT );
+            UTF_REQUIRE( cache -> tryGetAuthorizedPrinciplal( tokens.back() ) );
+
+            cache -> evict( tokens.back() );
+            UTF_REQUIRE( ! cache -> tryGetAuthorizedPrinciplal( tokens.back() ) );
+        }
+    };
+
+    test( cache_t::CryptographicKeyHashing );
+    test( cache_t::KeyedFastHashing );
+
+    /*
+     * Test the stale-while-revalidate logic - when the entry is stale only one caller
+     * gets nullptr and is expected to refresh it while the rest get the stale principal
+     */
+
+    {
+        const auto service = TestCountingAuthorizationServiceImpl::createInstance();
+
+        const auto cache = cache_t::createInstance< AuthorizationCache >(
+            om::copy( service ),
+            time::milliseconds( 200 )           /* freshnessInterval */,
+            std::size_t( cache_t::MAX_ENTRIES_DEFAULT ),
+            time::hours( 1 )                    /* staleInterval */
+            );
+
+        const auto token = AuthorizationCache::createAuthenticationToken( "token" );
+
+        const auto principal = cache -> update( token );
+        UTF_REQUIRE( om::areEqual( cache -> tryGetAuthorizedPrinciplal( token ), principal ) );
+
+        os::sleep( time::milliseconds( 400 ) );
+
+        UTF_REQUIRE( ! cache -> tryGetAuthorizedPrinciplal( token ) );
+        UTF_REQUIRE( om::areEqual( cache -> tryGetAuthorizedPrinciplal( token ), principal ) );
+        UTF_REQUIRE( om::areEqual( cache -> tryGetAuthorizedPrinciplal( token ), principal ) );
+
+        const auto refreshTask = cache -> createAuthorizationTask( token );
+        UTF_REQUIRE_EQUAL( service -> tasksCreated(), 2U );
+
+        executeTask( refreshTask );
+
+        const auto refreshedPrincipal = cache -> update( token, refreshTask );
+        UTF_REQUIRE( ! om::areEqual( refreshedPrincipal, principal ) );
+        UTF_REQUIRE( om::areEqual( cache -> tryGetAuthorizedPrinciplal( token ), refreshedPrincipal ) );
+    }
+}
@@ -125,6 +125,42 @@ UTF_AUTO_TEST_CASE( HashUtils_Test384 )
     UTF_REQUIRE_EQUAL( digestStr, known384Digest );
 }
 
+UTF_AUTO_TEST_CASE( HashUtils_TestSipHash24 )
+{
+    using namespace bl;
+    using namespace bl::hash;
+
+    BL_LOG_MULTILINE(
+        Logging::debug(),
+        BL_MSG()
+            << "\n******************************** Starting test: HashUtils_TestSipHash24 ********************************\n"
+        );
+
+    /*
+     * The test vectors from the SipHash reference implementation - the key is the bytes
+     * 00 .. 0f and the message of size N is the bytes 00 .. N-1
+     */
+
+    std::uint8_t key[ SipHash24::KEY_SIZE ];
+    std::uint8_t message[ 64 ];
+
+    for( std::size_t i = 0U; i < sizeof( message ); ++i )
+    {
+        if( i < sizeof( key ) )
+        {
+            key[ i ] = static_cast< std::uint8_t >( i );
+        }
+
+        message[ i ] = static_cast< std::uint8_t >( i );
+    }
+
+    UTF_REQUIRE_EQUAL( SipHash24::hash( key, message, 0U ), 0x726fdb47dd0e0e31ULL );
+    UTF_REQUIRE_EQUAL( SipHash24::hash( key, message, 7U ), 0xab0200f58b01d137ULL );
+    UTF_REQUIRE_EQUAL( SipHash24::hash( key, message, 8U ), 0x93f5f5799a932462ULL );
+    UTF_REQUIRE_EQUAL( SipHash24::hash( key, message, 15U ), 0xa129ca6149be45e5ULL );
+    UTF_REQUIRE_EQUAL( SipHash24::hash( key, message, 63U ), 0x958a324ceb064572ULL );
+}
+
 UTF_AUTO_TEST_CASE( HashUtils_TestPerformance )
 {
     using namespace bl;
@@ -21,6 +21,7 @@
 #include <baselib/http/SimpleHttpTask.h>
 
 #include <baselib/tasks/utils/Pinger.h>
+#include <baselib/tasks/utils/AsyncFileIoService.h>
 
 #include <baselib/tasks/TasksUtils.h>
 #include <baselib/tasks/Algorithms.h>
@@ -36,6 +37,7 @@
 #include <baselib/reactive/Observer.h>
 
 #include <baselib/transfer/ChunksTransmitter.h>
+#include <baselib/transfer/ContentDefinedChunker.h>
 #include <baselib/transfer/FilesPackagerUnit.h>
 #include <baselib/transfer/RecursiveDirectoryScanner.h>
 #include <baselib/transfer/SendRecvContext.h>
@@ -60,6 +62,7 @@
 #include <cstdint>
 #include <unordered_map>
 
+#include <utests/baselib/LoggerUtils.h>
 #include <utests/baselib/MachineGlobalTestLock.h>
 #include <utests/baselib/TestTaskUtils.h>
 #include <utests/baselib/UtfArgsParser.h>
@@ -1404,6 +1407,160 @@ UTF_AUTO_TEST_CASE( Tasks_ScanDirectoryTaskTests )
         );
 }
 
+UTF_AUTO_TEST_CASE( Tasks_ScanDirectoryTaskStatModeTests )
+{
+    using namespace bl;
+    using namespace bl::tasks;
+    using namespace utest;
+
+    fs::TmpDir tmpDir;
+
+    TestFsUtils dummyCreator;
+    dummyCreator.createDummyTestDir( tmpDir.path() );
+
+    /*
+     * The results of ScanDirectoryTask are verified against the boost directory
+     * iterator for all stat modes; the entries are keyed by the full path
+     */
+
+    struct ExpectedEntry
+    {
+        fs::file_status             symlinkStatus;
+        std::uint64_t               size;
+        std::time_t                 lastWriteTime;
+    };
+
+    std::map< fs::path, ExpectedEntry > expected;
+
+    fs::recursive_directory_iterator end, it( tmpDir.path() );
+
+    for( ; it != end; ++it )
+    {
+        const auto& path = it -> path();
+        const auto status = fs::symlink_status( path );
+
+        ExpectedEntry entry;
+
+        entry.symlinkStatus = status;
+        entry.size = fs::is_regular_file( status ) ? fs::file_size( path ) : 0U;
+        entry.lastWriteTime = fs::is_symlink( status ) ? 0 : fs::last_write_time( path );
+
+        expected[ path ] = entry;
+    }
+
+    UTF_REQUIRE( expected.size() > 10U );
+
+    const auto scan = [ & ]( SAA_in const os::DirectoryStatMode statMode ) -> void
+    {
+        std::size_t entriesCount = 0U;
+
+        scheduleAndExecuteInParallel(
+            [ & ]( SAA_in const om::ObjPtr< ExecutionQueue >& eq ) -> void
+            {
+                eq -> setOptions( ExecutionQueue::OptionKeepAll );
+
+                const auto boxedRootPath = bo::path::createInstance();
+                boxedRootPath -> swapValue( cpp::copy( tmpDir.path() ) );
+
+                eq -> push_back(
+                    ScanDirectoryTaskImpl::createInstance< Task >(
+                        tmpDir.path(),
+                        boxedRootPath,
+                        nullptr /* cbControl */,
+                        statMode
+                        )
+                    );
+
+                for( ;; )
+                {
+                    const auto scannerTask = eq -> pop( true /* wait */ );
+
+                    if( ! scannerTask )
+                    {
+                        break;
+                    }
+
+                    if( scannerTask -> isFailed() )
+                    {
+                        cpp::safeRethrowException( scannerTask -> exception() );
+                    }
+
+                    const auto scanner = om::qi< ScanDirectoryTaskImpl >( scannerTask );
+
+                    const auto& entries = scanner -> entries();
+                    const auto& entriesStats = scanner -> entriesStats();
+
+                    UTF_REQUIRE_EQUAL( entries.size(), entriesStats.size() );
+
+                    for( std::size_t i = 0U; i < entries.size(); ++i )
+                    {
+                        ++entriesCount;
+
+                        const auto pos = expected.find( entries[ i ].path() );
+                        UTF_REQUIRE( pos != expected.end() );
+
+                        const auto& expectedEntry = pos -> second;
+                        const auto& stat = entriesStats[ i ];
+                        const auto status = entries[ i ].symlink_status();
+
+                        UTF_REQUIRE_EQUAL( status.type(), expectedEntry.symlinkStatus.type() );
+
+                        const bool statExpected =
+                            os::DirectoryStatAll == statMode ||
+                            (
+                                os::DirectoryStatRegularFiles == statMode &&
+                                fs::is_regular_file( expectedEntry.symlinkStatus )
+                            );
+
+                        if( os::onUNIX() && ! statExpected )
+                        {
+                            /*
+                             * The types come from the directory enumeration on UNIX and the stat
+                             * is only called if the type is not known (which is file system dependent)
+                             */
+
+                            continue;
+                        }
+
+                        UTF_REQUIRE( stat.isKnown );
+                        UTF_REQUIRE_EQUAL( stat.size, expectedEntry.size );
+
+                        if( ! fs::is_symlink( status ) )
+                        {
+                            UTF_REQUIRE_EQUAL( stat.lastWriteTime, expectedEntry.lastWriteTime );
+                        }
+
+                        if( os::onUNIX() )
+                        {
+                            UTF_REQUIRE_EQUAL(
+                                static_cast< int >( status.permissions() ),
+                                static_cast< int >( expectedEntry.symlinkStatus.permissions() )
+                                );
+                        }
+                    }
+                }
+            });
+
+        UTF_REQUIRE_EQUAL( entriesCount, expected.size() );
+    };
+
+    scan( os::DirectoryStatNone );
+    scan( os::DirectoryStatRegularFiles );
+    scan( os::DirectoryStatAll );
+
+    /*
+     * Opening a directory which does not exist must fail with an error code
+     */
+
+    eh::error_code ec;
+    std::vector< os::DirectoryEntryInfo > infos;
+
+    os::readDirectory( tmpDir.path() / "doesNotExist", os::DirectoryStatAll, infos, ec );
+
+    UTF_REQUIRE( ec );
+    UTF_REQUIRE( infos.empty() );
+}
+
 /************************************************************************
  * Test to demo how to create a simple timer task
  */
@@ -1902,6 +2059,135 @@ UTF_AUTO_TEST_CASE( Tasks_ProcessingUnitWithObserverTests )
     localProcessingUnitTester< RecursiveDirectoryScannerObserver, bl::reactive::Observer >();
 }
 
+/************************************************************************
+ * Tests for the ContentDefinedChunker
+ */
+
+namespace
+{
+    std::vector< std::size_t > splitContentDefined(
+        SAA_in              const std::vector< unsigned char >&                             data,
+        SAA_in              const std::size_t                                               sliceSize
+        )
+    {
+        bl::transfer::ContentDefinedChunker chunker( 2U * 1024U, 8U * 1024U, 32U * 1024U );
+
+        std::vector< std::size_t > boundaries;
+
+        std::size_t pos = 0U;
+
+        while( pos < data.size() )
+        {
+            const std::size_t bytesLeft = data.size() - pos;
+
+            std::size_t available = 0U;
+            std::size_t chunkSize = 0U;
+
+            chunker.reset();
+
+            while( 0U == chunkSize && available < bytesLeft )
+            {
+                available = std::min( bytesLeft, available + sliceSize );
+
+                chunkSize = chunker.scan( data.data() + pos, available );
+            }
+
+            if( 0U == chunkSize )
+            {
+                chunkSize = available;
+            }
+
+            pos += chunkSize;
+
+            boundaries.push_back( pos );
+        }
+
+        return boundaries;
+    }
+
+} // __unnamed
+
+UTF_AUTO_TEST_CASE( Tasks_ContentDefinedChunkerTests )
+{
+    using namespace bl;
+    using namespace bl::transfer;
+
+    std::vector< unsigned char > data( 1024U * 1024U );
+
+    std::uint32_t state = 12345U;
+
+    for( auto& value : data )
+    {
+        state = state * 1103515245U + 12345U;
+        value = ( unsigned char )( state >> 24 );
+    }
+
+    const auto boundaries = splitContentDefined( data, data.size() );
+
+    UTF_REQUIRE_EQUAL( boundaries.back(), data.size() );
+    UTF_REQUIRE( boundaries.size() > data.size() / ( 32U * 1024U ) );
+    UTF_REQUIRE( boundaries.size() < data.size() / ( 2U * 1024U ) );
+
+    for( std::size_t i = 0U, prev = 0U; i + 1U < boundaries.size(); prev = boundaries[ i ], ++i )
+    {
+        const auto chunkSize = boundaries[ i ] - prev;
+
+        UTF_REQUIRE( chunkSize > 2U * 1024U );
+        UTF_REQUIRE( chunkSize <= 32U * 1024U );
+    }
+
+    /*
+     * The chunks must not depend on how the data is fed into the chunker
+     */
+
+    UTF_REQUIRE( boundaries == splitContentDefined( data, 1000U ) );
+    UTF_REQUIRE( boundaries == splitContentDefined( data, 4096U ) );
+
+    /*
+     * Insert some bytes near the beginning and verify that almost all boundaries
+     * after the insert position are preserved (shifted by the number of bytes)
+     */
+
+    const std::size_t insertPos = 5000U;
+    const std::size_t insertSize = 100U;
+
+    auto dataChanged = data;
+    dataChanged.insert( dataChanged.begin() + insertPos, insertSize, ( unsigned char ) 0xAB );
+
+    const auto boundariesChanged = splitContentDefined( dataChanged, dataChanged.size() );
+
+    std::size_t preserved = 0U;
+    std::size_t total = 0U;
+
+    for( const auto boundary : boundaries )
+    {
+        if( boundary <= insertPos + 32U * 1024U )
+        {
+            continue;
+        }
+
+        ++total;
+
+        if( std::binary_search( boundariesChanged.begin(), boundariesChanged.end(), boundary + insertSize ) )
+        {
+            ++preserved;
+        }
+    }
+
+    UTF_REQUIRE( total > 0U );
+    UTF_REQUIRE( preserved * 10U >= total * 9U );
+
+    /*
+     * Invalid chunk sizes must be rejected
+     */
+
+    UTF_REQUIRE_THROW_MESSAGE(
+        ContentDefinedChunker( 8U * 1024U, 8U * 1024U, 32U * 1024U ),
+        UnexpectedException,
+        "Invalid content-defined chunk sizes; min: 8192, avg: 8192, max: 32768"
+        );
+}
+
 /************************************************************************
  * Tests for the FilesPackagerUnit
  */
@@ -3623,3 +3909,255 @@ UTF_AUTO_TEST_CASE( Tasks_EarlyCancelTests )
         }
         );
 }
+
+UTF_AUTO_TEST_CASE( Tasks_AsyncFileIoServiceFailureTests )
+{
+#ifdef BL_TASKS_HAS_IO_URING
+    using namespace bl;
+    using namespace bl::tasks;
+
+    const std::size_t blocksCount = 32U;
+    const std::size_t blockSize = 4U * 1024U;
+
+    const auto service = om::lockDisposable(
+        AsyncFileIoService::createInstance( 16U /* queueDepth */ )
+        );
+
+    if( ! service -> isAsync() )
+    {
+        UTF_MESSAGE( "io_uring is not available; the test is skipped" );
+
+        return;
+    }
+
+    /*
+     * Replace the ring file descriptor with /dev/null, so io_uring_enter starts failing
+     * with an error which is not expected (EOPNOTSUPP) - the service must switch to the
+     * synchronous mode rather than abort the process
+     */
+
+    int ringFd = -1;
+
+    for( fs::directory_iterator it( "/proc/self/fd" ), end; it != end; ++it )
+    {
+        eh::error_code ec;
+
+        const auto target = fs::read_symlink( it -> path(), ec );
+
+        if( ! ec && target.string() == "anon_inode:[io_uring]" )
+        {
+            ringFd = std::stoi( it -> path().filename().string() );
+        }
+    }
+
+    UTF_REQUIRE( ringFd >= 0 );
+
+    /*
+     * The switch to the synchronous mode is reported as a warning
+     */
+
+    Logging::LineLoggerPusher pushLineLogger( &utest::warningToDebugLineLogger );
+
+    {
+        const int nullFd = ::open( "/dev/null", O_RDWR | O_CLOEXEC );
+
+        UTF_REQUIRE( nullFd >= 0 );
+
+        BL_SCOPE_EXIT( ::close( nullFd ); );
+
+        UTF_REQUIRE_EQUAL( ::dup2( nullFd, ringFd ), ringFd );
+    }
+
+    fs::TmpDir tmpDir;
+
+    const auto path = tmpDir.path() / "data.bin";
+
+    const auto file = bo::stdio_file::createInstance( os::fopen( path, "w+b" ) );
+
+    std::vector< om::ObjPtrCopyable< data::DataBlock > > blocks;
+    std::vector< om::ObjPtrCopyable< data::DataBlock > > readBlocks;
+
+    for( std::size_t i = 0U; i < blocksCount; ++i )
+    {
+        blocks.push_back( data::DataBlock::createInstance( blockSize ) );
+
+        for( std::size_t j = 0U; j < blockSize; ++j )
+        {
+            blocks.back() -> begin()[ j ] = static_cast< char >( ( i + j ) % 251U );
+        }
+
+        blocks.back() -> setSize( blockSize );
+
+        readBlocks.push_back( data::DataBlock::createInstance( blockSize ) );
+    }
+
+    scheduleAndExecuteInParallel(
+        [ & ]( SAA_in const om::ObjPtr< ExecutionQueue >& eq ) -> void
+        {
+            for( std::size_t i = 0U; i < blocksCount; ++i )
+            {
+                eq -> push_back(
+                    AsyncFileIoTaskImpl::createWriteTask( service, file, i * blockSize, blocks[ i ] )
+                    );
+            }
+        }
+        );
+
+    UTF_REQUIRE( ! service -> isAsync() );
+
+    UTF_REQUIRE_EQUAL( fs::file_size( path ), blocksCount * blockSize );
+
+    scheduleAndExecuteInParallel(
+        [ & ]( SAA_in const om::ObjPtr< ExecutionQueue >& eq ) -> void
+        {
+            for( std::size_t i = 0U; i < blocksCount; ++i )
+            {
+                eq -> push_back(
+                    AsyncFileIoTaskImpl::createReadTask( service, file, i * blockSize, readBlocks[ i ], blockSize )
+                    );
+            }
+        }
+        );
+
+    for( std::size_t i = 0U; i < blocksCount; ++i )
+    {
+        UTF_REQUIRE_EQUAL( readBlocks[ i ] -> size(), blockSize );
+        UTF_REQUIRE( 0 == std::memcmp( readBlocks[ i ] -> pv(), blocks[ i ] -> pv(), blockSize ) );
+    }
+#endif // BL_TASKS_HAS_IO_URING
+}
+
+UTF_AUTO_TEST_CASE( Tasks_AsyncFileIoServiceTests )
+{
+    using namespace bl;
+    using namespace bl::tasks;
+
+    const std::size_t blocksCount = 64U;
+    const std::size_t blockSize = 64U * 1024U;
+
+    const auto fillBlock = []( SAA_inout data::DataBlock& block, SAA_in const std::size_t seed ) -> void
+    {
+        for( std::size_t i = 0U; i < block.capacity(); ++i )
+        {
+            block.begin()[ i ] = static_cast< char >( ( seed + i ) % 251U );
+        }
+
+        block.setSize( block.capacity() );
+    };
+
+    const auto test = [ & ]( SAA_in const bool forceFallback, SAA_in const bool registerBuffers ) -> void
+    {
+        /*
+         * A small queue depth ensures some operations are queued while the rings are full
+         */
+
+        const auto service = om::lockDisposable(
+            AsyncFileIoService::createInstance( 16U /* queueDepth */, forceFallback )
+            );
+
+        BL_LOG(
+            Logging::debug(),
+            BL_MSG()
+                << "Async file I/O service test; forceFallback: "
+                << forceFallback
+                << "; isAsync: "
+                << service -> isAsync()
+            );
+
+        if( forceFallback )
+        {
+            UTF_REQUIRE( ! service -> isAsync() );
+        }
+
+        fs::TmpDir tmpDir;
+
+        const auto path = tmpDir.path() / "data.bin";
+
+        const auto file = bo::stdio_file::createInstance( os::fopen( path, "w+b" ) );
+
+        std::vector< om::ObjPtrCopyable< data::DataBlock > > blocks;
+        std::vector< om::ObjPtrCopyable< data::DataBlock > > readBlocks;
+
+        for( std::size_t i = 0U; i < blocksCount; ++i )
+        {
+            blocks.push_back( data::DataBlock::createInstance( blockSize ) );
+            fillBlock( *blocks.back(), i );
+
+            readBlocks.push_back( data::DataBlock::createInstance( blockSize ) );
+        }
+
+        if( registerBuffers )
+        {
+            /*
+             * The registration can fail if the locked memory limit is too low
+             */
+
+            const auto registered = service -> tryRegisterBuffers( blocks );
+
+            UTF_REQUIRE( service -> isAsync() || ! registered );
+
+            UTF_REQUIRE( ! service -> tryRegisterBuffers( blocks ) );
+        }
+
+        /*
+         * Write all blocks concurrently (in reverse order) and then read them back
+         */
+
+        scheduleAndExecuteInParallel(
+            [ & ]( SAA_in const om::ObjPtr< ExecutionQueue >& eq ) -> void
+            {
+                for( std::size_t i = blocksCount; i > 0U; --i )
+                {
+                    eq -> push_back(
+                        AsyncFileIoTaskImpl::createWriteTask( service, file, ( i - 1U ) * blockSize, blocks[ i - 1U ] )
+                        );
+                }
+            }
+            );
+
+        UTF_REQUIRE_EQUAL( fs::file_size( path ), blocksCount * blockSize );
+
+        scheduleAndExecuteInParallel(
+            [ & ]( SAA_in const om::ObjPtr< ExecutionQueue >& eq ) -> void
+            {
+                for( std::size_t i = 0U; i < blocksCount; ++i )
+                {
+                    eq -> push_back(
+                        AsyncFileIoTaskImpl::createReadTask( service, file, i * blockSize, readBlocks[ i ], blockSize )
+                        );
+                }
+            }
+            );
+
+        for( std::size_t i = 0U; i < blocksCount; ++i )
+        {
+            UTF_REQUIRE_EQUAL( readBlocks[ i ] -> size(), blockSize );
+            UTF_REQUIRE( 0 == std::memcmp( readBlocks[ i ] -> pv(), blocks[ i ] -> pv(), blockSize ) );
+        }
+
+        /*
+         * Reading past the end of file must fail
+         */
+
+        scheduleAndExecuteInParallel(
+            [ & ]( SAA_in const om::ObjPtr< ExecutionQueue >& eq ) -> void
+            {
+                eq -> push_back(
+                    AsyncFileIoTaskImpl::createReadTask(
+                        service,
+                        file,
+                        blocksCount * blockSize - 10U,
+                        readBlocks[ 0 ],
+                        100U
+                        )
+                    );
+
+                UTF_CHECK_THROW( eq -> flush(), SystemException );
+            }
+            );
+    };
+
+    test( false /* forceFallback */, false /* registerBuffers */ );
+    test( false /* forceFallback */, true /* registerBuffers */ );
+    test( true /* forceFallback */, false /* registerBuffers */ );
+}